@@ -66,8 +66,13 @@
 
 #include <tss2/Unmarshal_fp.h>
 
+/* The TPM implements in and out as globals.  The TSS unmarshals into per command structures and
+   has no global parameter state. */
+
+#ifndef TPM_TSS
 COMMAND_PARAMETERS in;
 RESPONSE_PARAMETERS out;
+#endif
 
 /*
   In_Unmarshal - shared by TPM and TSS
@@ -0,0 +1,385 @@
+/********************************************************************************/
+/*										*/
+/*				 Check Quote					*/
+/*		       IBM Thomas J. Watson Research Center			*/
+/*			     $Id: checkquote.c $				*/
+/*										*/
+/* (c) Copyright IBM Corporation 2017.						*/
+/*										*/
+/* All rights reserved.								*/
+/* 										*/
+/* Redistribution and use in source and binary forms, with or without		*/
+/* modification, are permitted provided that the following conditions are	*/
+/* met:										*/
+/* 										*/
+/* Redistributions of source code must retain the above copyright notice,	*/
+/* this list of conditions and the following disclaimer.			*/
+/* 										*/
+/* Redistributions in binary form must reproduce the above copyright		*/
+/* notice, this list of conditions and the following disclaimer in the		*/
+/* documentation and/or other materials provided with the distribution.		*/
+/* 										*/
+/* Neither the names of the IBM Corporation nor the names of its		*/
+/* contributors may be used to endorse or promote products derived from		*/
+/* this software without specific prior written permission.			*/
+/* 										*/
+/* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS		*/
+/* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT		*/
+/* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR	*/
+/* A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT		*/
+/* HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,	*/
+/* SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT		*/
+/* LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,	*/
+/* DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY	*/
+/* THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT		*/
+/* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE	*/
+/* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.		*/
+/********************************************************************************/
+
+/* checkquote is test/demo code.  It verifies a quote offline, without a TPM, using the outputs of
+   quote -os and -oa.  It optionally checks the nonce and replays a TCG 2 (crypto agile) event log
+   to check the quoted PCR digest.  With -it, it verifies the quote repeatedly as a batch across
+   the worker pool, as a benchmark.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include <tss2/tss.h>
+#include <tss2/tssutils.h>
+#include <tss2/tssfile.h>
+#include <tss2/tssresponsecode.h>
+#include <tss2/tssprint.h>
+#include <tss2/Unmarshal_fp.h>
+
+#include "eventlib.h"
+#include "quoteverify.h"
+#include "cryptoutils.h"
+
+/* local prototypes */
+
+static void printUsage(void);
+static TPM_RC readLog(unsigned char **log,
+		      size_t *logLength,
+		      const char *filename);
+
+int verbose = FALSE;
+
+int main(int argc, char * argv[])
+{
+    TPM_RC 			rc = 0;
+    int 			i = 0;
+    const char 			*publicKeyFilename = NULL;
+    const char 			*signatureFilename = NULL;
+    const char 			*attestFilename = NULL;
+    const char 			*qualifyingDataFilename = NULL;
+    const char 			*logFilename = NULL;
+    unsigned int		iterations = 1;
+    unsigned int		workers = 0;
+    TPM2B_PUBLIC		publicKey;
+    TPMT_SIGNATURE		signature;
+    TPM2B_ATTEST		quoted;
+    TPM2B_DATA			qualifyingData;
+    TPM2B_NAME			akName;
+    unsigned char 		*buffer = NULL;		/* freed @1 */
+    size_t			length;
+    unsigned char 		*log = NULL;		/* freed @2 */
+    size_t			logLength;
+    TSS_EVENT2_PCR_BANKS	*banks = NULL;		/* freed @3 */
+    TCG_EfiSpecIDEvent 		specIdEvent;
+    uint32_t			eventCount = 0;
+    QUOTE_VERIFIER		verifier;
+    int				verifierInit = FALSE;
+    QUOTE_JOB			*jobs = NULL;		/* freed @4 */
+    unsigned int		failed = 0;
+    double			startTime = 0;
+    double			endTime = 0;
+
+    setvbuf(stdout, 0, _IONBF, 0);      /* output may be going through pipe to log file */
+    TSS_SetProperty(NULL, TPM_TRACE_LEVEL, "1");
+
+    for (i=1 ; i<argc ; i++) {
+	if (strcmp(argv[i],"-ipu") == 0) {
+	    i++;
+	    if (i < argc) {
+		publicKeyFilename = argv[i];
+	    }
+	    else {
+		printf("-ipu option needs a value\n");
+		printUsage();
+	    }
+	}
+	else if (strcmp(argv[i],"-is") == 0) {
+	    i++;
+	    if (i < argc) {
+		signatureFilename = argv[i];
+	    }
+	    else {
+		printf("-is option needs a value\n");
+		printUsage();
+	    }
+	}
+	else if (strcmp(argv[i],"-ia") == 0) {
+	    i++;
+	    if (i < argc) {
+		attestFilename = argv[i];
+	    }
+	    else {
+		printf("-ia option needs a value\n");
+		printUsage();
+	    }
+	}
+	else if (strcmp(argv[i],"-qd") == 0) {
+	    i++;
+	    if (i < argc) {
+		qualifyingDataFilename = argv[i];
+	    }
+	    else {
+		printf("-qd option needs a value\n");
+		printUsage();
+	    }
+	}
+	else if (strcmp(argv[i],"-il") == 0) {
+	    i++;
+	    if (i < argc) {
+		logFilename = argv[i];
+	    }
+	    else {
+		printf("-il option needs a value\n");
+		printUsage();
+	    }
+	}
+	else if (strcmp(argv[i],"-it") == 0) {
+	    i++;
+	    if (i < argc) {
+		sscanf(argv[i],"%u", &iterations);
+	    }
+	    else {
+		printf("Missing parameter for -it\n");
+		printUsage();
+	    }
+	}
+	else if (strcmp(argv[i],"-th") == 0) {
+	    i++;
+	    if (i < argc) {
+		sscanf(argv[i],"%u", &workers);
+	    }
+	    else {
+		printf("Missing parameter for -th\n");
+		printUsage();
+	    }
+	}
+	else if (strcmp(argv[i],"-h") == 0) {
+	    printUsage();
+	}
+	else if (strcmp(argv[i],"-v") == 0) {
+	    verbose = TRUE;
+	    TSS_SetProperty(NULL, TPM_TRACE_LEVEL, "2");
+	}
+	else {
+	    printf("\n%s is not a valid option\n", argv[i]);
+	    printUsage();
+	}
+    }
+    if ((publicKeyFilename == NULL) ||
+	(signatureFilename == NULL) ||
+	(attestFilename == NULL)) {
+	printf("Missing parameter -ipu, -is, or -ia\n");
+	printUsage();
+    }
+    if (iterations == 0) {
+	printf("-it must be greater than 0\n");
+	printUsage();
+    }
+    /* AK public area, output from create */
+    if (rc == 0) {
+	rc = TSS_File_ReadBinaryFile(&buffer,     /* freed @1 */
+				     &length,
+				     publicKeyFilename);
+    }
+    if (rc == 0) {
+	uint8_t *tmpBuffer = buffer;
+	INT32 size = length;
+	rc = TPM2B_PUBLIC_Unmarshal(&publicKey, &tmpBuffer, &size, NO);
+    }
+    free(buffer);	/* @1 */
+    buffer = NULL;
+    /* signature, output from quote -os */
+    if (rc == 0) {
+	rc = TSS_File_ReadBinaryFile(&buffer,     /* freed @1 */
+				     &length,
+				     signatureFilename);
+    }
+    if (rc == 0) {
+	uint8_t *tmpBuffer = buffer;
+	INT32 size = length;
+	rc = TPMT_SIGNATURE_Unmarshal(&signature, &tmpBuffer, &size, NO);
+    }
+    free(buffer);	/* @1 */
+    buffer = NULL;
+    /* attestation structure, output from quote -oa */
+    if (rc == 0) {
+	rc = TSS_File_Read2B(&quoted.b,
+			     sizeof(quoted.t.attestationData),
+			     attestFilename);
+    }
+    if ((rc == 0) && (qualifyingDataFilename != NULL)) {
+	rc = TSS_File_Read2B(&qualifyingData.b,
+			     sizeof(qualifyingData.t.buffer),
+			     qualifyingDataFilename);
+    }
+    /* expected PCR values */
+    if ((rc == 0) && (logFilename != NULL)) {
+	rc = readLog(&log, &logLength, logFilename);		/* freed @2 */
+    }
+    if ((rc == 0) && (logFilename != NULL)) {
+	banks = malloc(sizeof(TSS_EVENT2_PCR_BANKS));		/* freed @3 */
+	if (banks == NULL) {
+	    printf("checkquote: Cannot allocate PCR banks\n");
+	    rc = TSS_RC_OUT_OF_MEMORY;
+	}
+    }
+    if ((rc == 0) && (logFilename != NULL)) {
+	rc = TSS_EVENT2_Log_Replay(banks, &specIdEvent, &eventCount,
+				   log, (uint32_t)logLength);
+    }
+    if (rc == 0) {
+	rc = QUOTE_Verifier_Init(&verifier, workers);
+    }
+    if (rc == 0) {
+	verifierInit = TRUE;
+	rc = QUOTE_Verifier_AddKey(&verifier, &akName, &publicKey.publicArea);
+    }
+    if (rc == 0) {
+	jobs = malloc(iterations * sizeof(QUOTE_JOB));		/* freed @4 */
+	if (jobs == NULL) {
+	    printf("checkquote: Cannot allocate %u jobs\n", iterations);
+	    rc = TSS_RC_OUT_OF_MEMORY;
+	}
+    }
+    if (rc == 0) {
+	unsigned int j;
+	for (j = 0 ; j < iterations ; j++) {
+	    jobs[j].akName = &akName;
+	    jobs[j].quoted = &quoted;
+	    jobs[j].signature = &signature;
+	    jobs[j].qualifyingData = (qualifyingDataFilename != NULL) ? &qualifyingData : NULL;
+	    jobs[j].banks = banks;
+	}
+	startTime = getSeconds();
+	rc = QUOTE_Verify_Batch(&verifier, jobs, iterations);
+	endTime = getSeconds();
+    }
+    if (rc == 0) {
+	unsigned int j;
+	/* report the first failure */
+	for (j = 0 ; j < iterations ; j++) {
+	    if (jobs[j].rc != 0) {
+		if (failed == 0) {
+		    rc = jobs[j].rc;
+		}
+		failed++;
+	    }
+	}
+    }
+    if (rc == 0) {
+	if (verbose) TSS_TPMS_ATTEST_Print(&jobs[0].attest, 0);
+	if (logFilename != NULL) {
+	    printf("checkquote: PCR digest matches %u events\n", eventCount);
+	}
+	if (iterations > 1) {
+	    double seconds = endTime - startTime;
+	    printf("checkquote: %u quotes, %u workers, %.3f sec, %.0f quotes/sec\n",
+		   iterations, workers, seconds,
+		   (seconds > 0) ? (iterations / seconds) : 0);
+	}
+	printf("checkquote: success\n");
+    }
+    else {
+	const char *msg;
+	const char *submsg;
+	const char *num;
+	if (failed != 0) {
+	    printf("checkquote: %u of %u quotes failed\n", failed, iterations);
+	}
+	printf("checkquote: failed, rc %08x\n", rc);
+	TSS_ResponseCode_toString(&msg, &submsg, &num, rc);
+	printf("%s%s%s\n", msg, submsg, num);
+	rc = EXIT_FAILURE;
+    }
+    if (verifierInit) {
+	QUOTE_Verifier_Delete(&verifier);
+    }
+    free(jobs);		/* @4 */
+    free(banks);	/* @3 */
+    free(log);		/* @2 */
+    return rc;
+}
+
+/* readLog() reads the event log into a malloced buffer.  Boot logs may exceed the TSS file
+   utility allocation limit. */
+
+static TPM_RC readLog(unsigned char **log,
+		      size_t *logLength,
+		      const char *filename)
+{
+    TPM_RC 		rc = 0;
+    FILE		*file = NULL;		/* closed @1 */
+    size_t		allocated = 0;
+    size_t		readSize;
+    unsigned char	*tmp;
+
+    *logLength = 0;
+    if (rc == 0) {
+	rc = TSS_File_Open(&file, filename, "rb");	/* closed @1 */
+    }
+    while (rc == 0) {
+	if (*logLength == allocated) {
+	    allocated = (allocated == 0) ? 0x10000 : (allocated * 2);
+	    tmp = realloc(*log, allocated);
+	    if (tmp == NULL) {
+		printf("readLog: Cannot allocate %lu bytes\n", (unsigned long)allocated);
+		rc = TSS_RC_OUT_OF_MEMORY;
+		break;
+	    }
+	    *log = tmp;
+	}
+	readSize = fread(*log + *logLength, 1, allocated - *logLength, file);
+	*logLength += readSize;
+	if (readSize == 0) {
+	    if (ferror(file)) {
+		printf("readLog: Error reading %s\n", filename);
+		rc = TSS_RC_FILE_READ;
+	    }
+	    break;
+	}
+    }
+    if ((rc == 0) && (*logLength > 0x7fffffff)) {
+	printf("readLog: %s is too large\n", filename);
+	rc = TSS_RC_FILE_READ;
+    }
+    if (file != NULL) {
+	fclose(file);	/* @1 */
+    }
+    return rc;
+}
+
+static void printUsage(void)
+{
+    printf("\n");
+    printf("checkquote\n");
+    printf("\n");
+    printf("Verifies a quote offline\n");
+    printf("\n");
+    printf("\t-ipu AK public key file name in TPM format\n");
+    printf("\t-is quote signature file name, from quote -os\n");
+    printf("\t-ia attestation file name, from quote -oa\n");
+    printf("\t[-qd qualifying data file name, the quote nonce]\n");
+    printf("\t[-il TCG 2 event log file name, replayed to check the PCR digest]\n");
+    printf("\t[-it verify the quote n times as a batch, benchmark (default 1)]\n");
+    printf("\t[-th number of worker threads (default 0, verify inline)]\n");
+    printf("\t[-v verbose trace]\n");
+    exit(1);	
+}
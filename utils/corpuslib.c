@@ -0,0 +1,167 @@
+/********************************************************************************/
+/*										*/
+/*		       TSS Command and Response Corpus				*/
+/*		       IBM Thomas J. Watson Research Center			*/
+/*			      $Id: corpuslib.c $				*/
+/*										*/
+/* (c) Copyright IBM Corporation 2017.						*/
+/*										*/
+/* All rights reserved.								*/
+/* 										*/
+/* Redistribution and use in source and binary forms, with or without		*/
+/* modification, are permitted provided that the following conditions are	*/
+/* met:										*/
+/* 										*/
+/* Redistributions of source code must retain the above copyright notice,	*/
+/* this list of conditions and the following disclaimer.			*/
+/* 										*/
+/* Redistributions in binary form must reproduce the above copyright		*/
+/* notice, this list of conditions and the following disclaimer in the		*/
+/* documentation and/or other materials provided with the distribution.		*/
+/* 										*/
+/* Neither the names of the IBM Corporation nor the names of its		*/
+/* contributors may be used to endorse or promote products derived from		*/
+/* this software without specific prior written permission.			*/
+/* 										*/
+/* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS		*/
+/* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT		*/
+/* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR	*/
+/* A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT		*/
+/* HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,	*/
+/* SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT		*/
+/* LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,	*/
+/* DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY	*/
+/* THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT		*/
+/* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE	*/
+/* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.		*/
+/********************************************************************************/
+
+
+
+#include <stdio.h>
+#include <string.h>
+
+#include <tss2/tss.h>
+#include <tss2/tsserror.h>
+#include <tss2/tssmarshal.h>
+#include <tss2/Unmarshal_fp.h>
+
+#include "corpuslib.h"
+
+extern int verbose;
+
+/* Corpus_Pair_Parse() parses a command and response pair, 'data' of 'length' bytes.
+
+   The pointers in corpusPair point into 'data'.  The command parameters start after the handles
+   and any authorization area, where the TSS command unmarshal functions begin.  The response
+   starts after the 10 byte header, where the TSS response unmarshal functions begin.
+
+   Returns TSS_RC_MALFORMED_RESPONSE if the pair does not parse.
+*/
+
+TPM_RC Corpus_Pair_Parse(CORPUS_PAIR *corpusPair,
+			 uint8_t *data,
+			 size_t length)
+{
+    TPM_RC	rc = 0;
+    uint8_t	*buffer = data;
+    INT32	size;
+    uint32_t	commandSize;
+    uint32_t	responseSize;
+    uint32_t	authorizationSize;
+    size_t	index;
+    TPM_CC	commandCode;
+    const char 	*commandText;
+    uint32_t	h;
+
+    /* the command header */
+    if (rc == 0) {
+	if (length > 0x7fffffff) {
+	    rc = TSS_RC_MALFORMED_RESPONSE;
+	}
+	size = (INT32)length;
+    }
+    if (rc == 0) {
+	rc = TPM_ST_Unmarshal(&corpusPair->commandTag, &buffer, &size);
+    }
+    if (rc == 0) {
+	rc = UINT32_Unmarshal(&commandSize, &buffer, &size);
+    }
+    if (rc == 0) {
+	rc = TPM_CC_Unmarshal(&corpusPair->commandCode, &buffer, &size);
+    }
+    if (rc == 0) {
+	if ((commandSize < (sizeof(TPM_ST) + sizeof(uint32_t) + sizeof(TPM_CC))) ||
+	    (commandSize > length)) {
+	    if (verbose) printf("Corpus_Pair_Parse: command size %u, file %lu\n",
+				commandSize, (unsigned long)length);
+	    rc = TSS_RC_MALFORMED_RESPONSE;
+	}
+    }
+    /* the command handle count from the marshal table */
+    if (rc == 0) {
+	for (index = 0 ; ; index++) {
+	    rc = TSS_MarshalTable_Entry(index, &commandCode, &commandText,
+					&corpusPair->commandHandleCount);
+	    if ((rc != 0) || (commandCode == corpusPair->commandCode)) {
+		break;
+	    }
+	}
+	if (rc != 0) {
+	    if (verbose) printf("Corpus_Pair_Parse: command code %08x not in table\n",
+				corpusPair->commandCode);
+	}
+    }
+    /* the remainder of the command, bounded by its size */
+    if (rc == 0) {
+	size = commandSize - (sizeof(TPM_ST) + sizeof(uint32_t) + sizeof(TPM_CC));
+    }
+    for (h = 0 ; (rc == 0) && (h < corpusPair->commandHandleCount) ; h++) {
+	rc = TPM_HANDLE_Unmarshal(&corpusPair->handles[h], &buffer, &size);
+    }
+    /* skip the authorization area */
+    if ((rc == 0) && (corpusPair->commandTag == TPM_ST_SESSIONS)) {
+	rc = UINT32_Unmarshal(&authorizationSize, &buffer, &size);
+	if (rc == 0) {
+	    if (authorizationSize > (uint32_t)size) {
+		rc = TSS_RC_MALFORMED_RESPONSE;
+	    }
+	    else {
+		buffer += authorizationSize;
+		size -= authorizationSize;
+	    }
+	}
+    }
+    if (rc == 0) {
+	corpusPair->commandParameters = buffer;
+	corpusPair->commandParameterSize = size;
+	buffer += size;
+    }
+    /* the response header */
+    if (rc == 0) {
+	size = (INT32)(length - commandSize);
+	rc = TPM_ST_Unmarshal(&corpusPair->responseTag, &buffer, &size);
+    }
+    if (rc == 0) {
+	rc = UINT32_Unmarshal(&responseSize, &buffer, &size);
+    }
+    if (rc == 0) {
+	rc = TPM_RC_Unmarshal(&corpusPair->responseCode, &buffer, &size);
+    }
+    if (rc == 0) {
+	if ((responseSize != (length - commandSize)) ||
+	    (responseSize < (sizeof(TPM_ST) + sizeof(uint32_t) + sizeof(TPM_RC)))) {
+	    if (verbose) printf("Corpus_Pair_Parse: response size %u, expected %lu\n",
+				responseSize, (unsigned long)(length - commandSize));
+	    rc = TSS_RC_MALFORMED_RESPONSE;
+	}
+    }
+    if (rc == 0) {
+	corpusPair->response = buffer;
+	corpusPair->responseSize = size;
+    }
+    if (rc != 0) {
+	rc = TSS_RC_MALFORMED_RESPONSE;
+    }
+    return rc;
+}
@@ -0,0 +1,82 @@
+/********************************************************************************/
+/*										*/
+/*		       TSS Command and Response Corpus				*/
+/*		       IBM Thomas J. Watson Research Center			*/
+/*			      $Id: corpuslib.h $				*/
+/*										*/
+/* (c) Copyright IBM Corporation 2017.						*/
+/*										*/
+/* All rights reserved.								*/
+/* 										*/
+/* Redistribution and use in source and binary forms, with or without		*/
+/* modification, are permitted provided that the following conditions are	*/
+/* met:										*/
+/* 										*/
+/* Redistributions of source code must retain the above copyright notice,	*/
+/* this list of conditions and the following disclaimer.			*/
+/* 										*/
+/* Redistributions in binary form must reproduce the above copyright		*/
+/* notice, this list of conditions and the following disclaimer in the		*/
+/* documentation and/or other materials provided with the distribution.		*/
+/* 										*/
+/* Neither the names of the IBM Corporation nor the names of its		*/
+/* contributors may be used to endorse or promote products derived from		*/
+/* this software without specific prior written permission.			*/
+/* 										*/
+/* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS		*/
+/* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT		*/
+/* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR	*/
+/* A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT		*/
+/* HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,	*/
+/* SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT		*/
+/* LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,	*/
+/* DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY	*/
+/* THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT		*/
+/* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE	*/
+/* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.		*/
+/********************************************************************************/
+
+
+
+/* A corpus pair is one TPM command packet immediately followed by its response packet, as written
+   by the TSS when the TPM_CORPUS_DIR property is set.  Both packets carry their own header size, so
+   no framing is needed.
+
+   Corpus pairs feed parsebench, which times the marshal table functions, and fuzzparse, which
+   seeds the response parser fuzzers.
+*/
+
+#ifndef CORPUSLIB_H
+#define CORPUSLIB_H
+
+#include <stdint.h>
+
+#include <tss2/TPM_Types.h>
+#include <tss2/Implementation.h>
+
+typedef struct CORPUS_PAIR {
+    TPM_ST		commandTag;
+    TPM_CC		commandCode;
+    uint32_t		commandHandleCount;
+    TPM_HANDLE		handles[MAX_HANDLE_NUM];
+    uint8_t		*commandParameters;	/* after the handles and authorization area */
+    uint32_t		commandParameterSize;
+    TPM_ST		responseTag;
+    TPM_RC		responseCode;
+    uint8_t		*response;		/* after the response header */
+    uint32_t		responseSize;
+} CORPUS_PAIR;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+    TPM_RC Corpus_Pair_Parse(CORPUS_PAIR *corpusPair,
+			     uint8_t *data,
+			     size_t length);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
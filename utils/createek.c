@@ -112,6 +112,7 @@ int main(int argc, char *argv[])
     uint8_t 			*modulusBin = NULL;
     int				modulusBytes;
     unsigned int 		noFlush = 0;		/* default flush after validation */
+    int				useCache = FALSE;	/* default create the primary key */
     
     setvbuf(stdout, 0, _IONBF, 0);      /* output may be going through pipe to log file */
     TSS_SetProperty(NULL, TPM_TRACE_LEVEL, "1");
@@ -176,6 +177,9 @@ int main(int argc, char *argv[])
 	else if (strcmp(argv[i],"-noflush") == 0) {
 	    noFlush = 1;
 	}
+	else if (strcmp(argv[i],"-cache") == 0) {
+	    useCache = TRUE;
+	}
 	else if (strcmp(argv[i],"-h") == 0) {
 	    printUsage();
 	}
@@ -223,7 +227,7 @@ int main(int argc, char *argv[])
 	  case CreateprimaryType:
 	    rc = processPrimary(tssContext, &keyHandle,
 				ekCertIndex, ekNonceIndex, ekTemplateIndex,
-				noFlush, TRUE);
+				noFlush, useCache, TRUE);
 	    break;
 	}
     }
@@ -272,6 +276,7 @@ static void printUsage(void)
     printf("-ce print EK certificate \n");
     printf("-cp CreatePrimary using the EK template and EK nonce\n");
     printf("\t[-noflush Do not flush the primary key after validation\n");
+    printf("\t[-cache load the primary key from the TSS cache if present (default create)]\n");
     printf("[-root filename validate EK certificates against the root)]\n");
     printf("\tfilename contains a list of PEM certificate filenames, one per line\n");
     printf("\tthe list may contain up to %u certificates\n", MAX_ROOTS);
@@ -51,6 +51,7 @@
 #include <tss2/tssresponsecode.h>
 #include <tss2/tssmarshal.h>
 #include <tss2/tsscryptoh.h>
+#include <tss2/tssprimary.h>
 
 #include "objecttemplates.h"
 #include "cryptoutils.h"
@@ -96,6 +97,8 @@ int main(int argc, char *argv[])
     unsigned int		sessionAttributes1 = 0;
     TPMI_SH_AUTH_SESSION    	sessionHandle2 = TPM_RH_NULL;
     unsigned int		sessionAttributes2 = 0;
+    int				useCache = FALSE;
+    int				cached = FALSE;
     
     setvbuf(stdout, 0, _IONBF, 0);      /* output may be going through pipe to log file */
     TSS_SetProperty(NULL, TPM_TRACE_LEVEL, "1");
@@ -436,6 +439,9 @@ int main(int argc, char *argv[])
 		printUsage();
 	    }
 	}
+	else if (strcmp(argv[i],"-cache") == 0) {
+	    useCache = TRUE;
+	}
 	else if (strcmp(argv[i],"-h") == 0) {
 	    printUsage();
 	}
@@ -452,6 +458,10 @@ int main(int argc, char *argv[])
 	printf("Too many key attributes\n");
 	printUsage();
     }
+    if (useCache && ((ticketFilename != NULL) || (creationHashFilename != NULL))) {
+	printf("-cache cannot be used with -tk or -ch, a cached key has no creation data\n");
+	printUsage();
+    }
     switch (keyType) {
       case TYPE_BL:
 	if (dataFilename == NULL) {
@@ -628,7 +638,7 @@ int main(int argc, char *argv[])
 	rc = TSS_Create(&tssContext);
     }
     /* call TSS to execute the command */
-    if (rc == 0) {
+    if ((rc == 0) && !useCache) {
 	rc = TSS_Execute(tssContext,
 			 (RESPONSE_PARAMETERS *)&out,
 			 (COMMAND_PARAMETERS *)&in,
@@ -639,6 +649,18 @@ int main(int argc, char *argv[])
 			 sessionHandle2, NULL, sessionAttributes2,
 			 TPM_RH_NULL, NULL, 0);
     }
+    /* load the primary key from the cache, or create and cache it */
+    if ((rc == 0) && useCache) {
+	rc = TSS_PrimaryCache_CreatePrimary(tssContext,
+					    &out,
+					    &cached,
+					    &in,
+					    sessionHandle0, parentPasswordPtr, sessionAttributes0,
+					    sessionHandle1, sessionAttributes1,
+					    sessionHandle2, sessionAttributes2);
+	if ((rc == 0) && verbose) printf("createprimary: %s\n",
+					 cached ? "loaded from cache" : "created");
+    }
     {
 	TPM_RC rc1 = TSS_Delete(tssContext);
 	if (rc == 0) {
@@ -646,9 +668,9 @@ int main(int argc, char *argv[])
 	}
     }
     /*
-      validate the creation data
+      validate the creation data, not returned for a cached primary key
     */
-    {
+    if (!cached) {
 	uint16_t	written = 0;;
 	uint8_t		*buffer = NULL;		/* for the free */
 	uint32_t 	sizeInBytes;
@@ -749,6 +771,8 @@ static void printUsage(void)
     printf("\t[oipem public key PEM format file name (default do not save)]\n");
     printf("\t[-tk output ticket file name]\n");
     printf("\t[-ch output creation hash file name]\n");
+    printf("\t[-cache load the primary key from the TSS cache if present (default create)\n");
+    printf("\t\tnot used with -pwdk, a key with a password is not cached]\n");
     printf("\n");
     printUsageTemplate();
     printf("\n");
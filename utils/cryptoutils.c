@@ -54,6 +54,13 @@
 #include <stdint.h>
 #include <limits.h>
 
+#ifdef TPM_POSIX
+#include <time.h>
+#endif
+#ifdef TPM_WINDOWS
+#include <windows.h>
+#endif
+
 #include <openssl/rsa.h>
 #include <openssl/objects.h>
 #include <openssl/evp.h>
@@ -1407,3 +1414,23 @@ TPM_RC convertBin2Bn(BIGNUM **bn,			/* freed by caller */
     return rc;
 }
 
+/* getSeconds() returns a monotonic time in seconds, used by the utilities to calculate elapsed time
+   and rates.  Only differences between two calls are meaningful. */
+
+double getSeconds(void)
+{
+    double seconds;
+#ifdef TPM_POSIX
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    seconds = (double)now.tv_sec + ((double)now.tv_nsec / 1e9);
+#endif
+#ifdef TPM_WINDOWS
+    LARGE_INTEGER count;
+    LARGE_INTEGER frequency;
+    QueryPerformanceCounter(&count);
+    QueryPerformanceFrequency(&frequency);
+    seconds = (double)count.QuadPart / (double)frequency.QuadPart;
+#endif
+    return seconds;
+}
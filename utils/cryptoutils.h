@@ -177,6 +177,7 @@ extern "C" {
     TPM_RC convertBin2Bn(BIGNUM **bn,
 			 const unsigned char *bin,
 			 unsigned int bytes);
+    double getSeconds(void);
 
 #ifdef __cplusplus
 }
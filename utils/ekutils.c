@@ -61,6 +61,8 @@
 #include <tss2/tsscrypto.h>
 #include <tss2/tssprint.h>
 #include <tss2/Unmarshal_fp.h>
+#include <tss2/tssstream.h>
+#include <tss2/tssprimary.h>
 
 #include "cryptoutils.h"
 #include "ekutils.h"
@@ -88,40 +90,12 @@ TPM_RC readNvBufferMax(TSS_CONTEXT *tssContext,
 		       uint32_t *nvBufferMax)
 {
     TPM_RC			rc = 0;
-    GetCapability_In 		in;
-    GetCapability_Out		out;
 
-    in.capability = TPM_CAP_TPM_PROPERTIES;
-    in.property = TPM_PT_NV_BUFFER_MAX;
-    in.propertyCount = 1;	/* ask for one property */
+    /* the TSS caches the value per context, so repeated calls do not go to the TPM */
     if (rc == 0) {
-	rc = TSS_Execute(tssContext,
-			 (RESPONSE_PARAMETERS *)&out, 
-			 (COMMAND_PARAMETERS *)&in,
-			 NULL,
-			 TPM_CC_GetCapability,
-			 TPM_RH_NULL, NULL, 0);
+	rc = TSS_NV_GetBufferMax(tssContext, nvBufferMax);
     }
-    /* sanity check that the property name is correct (demo of how to parse the structure) */
     if (rc == 0) {
-	if ((out.capabilityData.data.tpmProperties.count > 0) &&
-	    (out.capabilityData.data.tpmProperties.tpmProperty[0].property ==
-	     TPM_PT_NV_BUFFER_MAX)) {
-	    *nvBufferMax = out.capabilityData.data.tpmProperties.tpmProperty[0].value;
-	}
-	else {
-	    if (verbose) printf("readNvBufferMax: wrong property returned: %08x\n",
-		   out.capabilityData.data.tpmProperties.tpmProperty[0].property);
-	    /* hard code a value for a back level HW TPM that does not implement
-	       TPM_PT_NV_BUFFER_MAX yet */
-	    *nvBufferMax = 512;
-	}
-	if (verbose) printf("readNvBufferMax: TPM max read/write: %u\n", *nvBufferMax);
-	/* in addition, the maximum TSS side structure MAX_NV_BUFFER_SIZE is accounted for.  The TSS
-	   value is typically larger than the TPM value. */
-	if (*nvBufferMax > MAX_NV_BUFFER_SIZE) {
-	    *nvBufferMax = MAX_NV_BUFFER_SIZE;
-	}
 	if (verbose) printf("readNvBufferMax: combined max read/write: %u\n", *nvBufferMax);
     }
     else {
@@ -186,63 +160,33 @@ TPM_RC getIndexData(TSS_CONTEXT *tssContext,
 		    uint16_t readDataSize)		/* total size to read */
 {
     TPM_RC			rc = 0;
-    int				done = FALSE;
-    uint32_t 			nvBufferMax;
-    uint16_t 			bytesRead;			/* bytes read so far */
-    NV_Read_In 			in;
-    NV_Read_Out			out;
+    TSS_STREAM_BUFFER		streamBuffer;
     
-    /* data may have to be read in chunks.  Read the TPM_PT_NV_BUFFER_MAX, the chunk size */
-    if (rc == 0) {
-	rc = readNvBufferMax(tssContext,
-			     &nvBufferMax);
-    }    
     if (rc == 0) {
 	if (verbose) printf("getIndexData: index %08x\n", nvIndex);
-	in.authHandle = nvIndex;	/* index authorization */
-	in.nvIndex = nvIndex;
-	in.offset = 0;			/* start at beginning */
-	bytesRead = 0;			/* bytes read so far */
-    }
-    if (rc == 0) {
 	rc = TSS_Malloc(readBuffer, readDataSize);
     }
-    /* call TSS to execute the command */
-    while ((rc == 0) && !done) {
-	if (rc == 0) {
-	    /* read a chunk */
-	    in.offset = bytesRead;
-	    if ((uint32_t)(readDataSize - bytesRead) < nvBufferMax) {
-		in.size = readDataSize - bytesRead;	/* last chunk */
-	    }
-	    else {
-		in.size = nvBufferMax;		/* next chunk */
-	    }
-	}
-	if (rc == 0) {
-	    rc = TSS_Execute(tssContext,
-			     (RESPONSE_PARAMETERS *)&out,
-			     (COMMAND_PARAMETERS *)&in,
-			     NULL,
-			     TPM_CC_NV_Read,
-			     TPM_RS_PW, NULL, 0,
-			     TPM_RH_NULL, NULL, 0);
-	    if (rc != 0) {
-		const char *msg;
-		const char *submsg;
-		const char *num;
-		printf("nvread: failed, rc %08x\n", rc);
-		TSS_ResponseCode_toString(&msg, &submsg, &num, rc);
-		printf("%s%s%s\n", msg, submsg, num);
-	    }
-	}
- 	/* copy the results to the read buffer */
-	if (rc == 0) {
-	    memcpy(*readBuffer + bytesRead, out.data.b.buffer, out.data.b.size);
-	    bytesRead += out.data.b.size;
-	    if (bytesRead == readDataSize) {
-		done = TRUE;
-	    }
+    /* the data may be read in chunks of TPM_PT_NV_BUFFER_MAX */
+    if (rc == 0) {
+	streamBuffer.buffer = *readBuffer;
+	streamBuffer.size = readDataSize;
+	streamBuffer.length = 0;
+	rc = TSS_NV_ReadStream(tssContext,
+			       nvIndex,		/* index authorization */
+			       nvIndex,
+			       0,		/* start at beginning */
+			       readDataSize,
+			       TSS_Stream_WriteBuffer, &streamBuffer,
+			       TPM_RS_PW, NULL, 0,
+			       TPM_RH_NULL, 0,
+			       TPM_RH_NULL, 0);
+	if (rc != 0) {
+	    const char *msg;
+	    const char *submsg;
+	    const char *num;
+	    printf("nvread: failed, rc %08x\n", rc);
+	    TSS_ResponseCode_toString(&msg, &submsg, &num, rc);
+	    printf("%s%s%s\n", msg, submsg, num);
 	}
     }
     return rc;
@@ -1030,6 +974,9 @@ TPM_RC processRoot(TSS_CONTEXT *tssContext,
 
    After returning the TPMT_PUBLIC, flushes the primary key unless noFlush is TRUE.  If noFlush is
    FALSE, returns the loaded handle, else returns TPM_RH_NULL.
+
+   If useCache is TRUE, the EK is loaded from the TSS primary key cache if present, and otherwise
+   created and added to the cache.  The cache writes a file to the TSS data directory.
 */
 
 TPM_RC processCreatePrimary(TSS_CONTEXT *tssContext,
@@ -1040,6 +987,7 @@ TPM_RC processCreatePrimary(TSS_CONTEXT *tssContext,
 			    TPMT_PUBLIC *tpmtPublicIn,		/* template */
 			    TPMT_PUBLIC *tpmtPublicOut,		/* primary key */
 			    unsigned int noFlush,	/* TRUE - don't flush the primary key */
+			    int useCache,		/* TRUE - use the TSS primary key cache */
 			    int print)
 {
     TPM_RC			rc = 0;
@@ -1088,15 +1036,31 @@ TPM_RC processCreatePrimary(TSS_CONTEXT *tssContext,
 	    getEccTemplate(&inCreatePrimary.inPublic.publicArea);
 	}
     }
-    /* call TSS to execute the command */
+    /* call TSS to execute the command.  The EK is the same each time, so the caller can ask for
+       the TSS primary key cache */
     if (rc == 0) {
-	rc = TSS_Execute(tssContext,
-			 (RESPONSE_PARAMETERS *)&outCreatePrimary,
-			 (COMMAND_PARAMETERS *)&inCreatePrimary,
-			 NULL,
-			 TPM_CC_CreatePrimary,
-			 TPM_RS_PW, NULL, 0,
-			 TPM_RH_NULL, NULL, 0);
+	int cached = FALSE;
+	if (useCache) {
+	    rc = TSS_PrimaryCache_CreatePrimary(tssContext,
+						&outCreatePrimary,
+						&cached,
+						&inCreatePrimary,
+						TPM_RS_PW, NULL, 0,
+						TPM_RH_NULL, 0,
+						TPM_RH_NULL, 0);
+	}
+	else {
+	    rc = TSS_Execute(tssContext,
+			     (RESPONSE_PARAMETERS *)&outCreatePrimary,
+			     (COMMAND_PARAMETERS *)&inCreatePrimary,
+			     NULL,
+			     TPM_CC_CreatePrimary,
+			     TPM_RS_PW, NULL, 0,
+			     TPM_RH_NULL, NULL, 0);
+	}
+	if ((rc == 0) && cached) {
+	    if (verbose) printf("processCreatePrimary: EK loaded from cache\n");
+	}
 	if (rc != 0) {
 	    const char *msg;
 	    const char *submsg;
@@ -1250,6 +1214,7 @@ TPM_RC processPrimary(TSS_CONTEXT *tssContext,
 		      TPMI_RH_NV_INDEX ekNonceIndex, 
 		      TPMI_RH_NV_INDEX ekTemplateIndex,
 		      unsigned int noFlush,		/* TRUE - don't flush the primary key */
+		      int useCache,			/* TRUE - use the TSS primary key cache */
 		      int print)
 {
     TPM_RC			rc = 0;
@@ -1284,6 +1249,7 @@ TPM_RC processPrimary(TSS_CONTEXT *tssContext,
 				  &tpmtPublicIn,		/* template */
 				  &tpmtPublicOut,		/* primary key */
 				  noFlush,
+				  useCache,
 				  print);
     }
     /* get the EK certificate */
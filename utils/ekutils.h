@@ -139,6 +139,7 @@ extern "C" {
 				TPMT_PUBLIC *tpmtPublicIn,
 				TPMT_PUBLIC *tpmtPublicOut,
 				unsigned int noFlush,
+				int useCache,
 				int print);
     TPM_RC processValidatePrimary(uint8_t *publicKeyBin,
 				  int publicKeyBytes,
@@ -151,6 +152,7 @@ extern "C" {
 			  TPMI_RH_NV_INDEX ekNonceIndex, 
 			  TPMI_RH_NV_INDEX ekTemplateIndex,
 			  unsigned int noFlush,
+			  int useCache,
 			  int print);
 
     TPM_RC TSS_RSAGetKey(const BIGNUM **n,
@@ -59,6 +59,10 @@ static TPM_RC TSS_SpecIdEventAlgorithmSize_Unmarshal(TCG_EfiSpecIdEventAlgorithm
 						     uint8_t **buffer,
 						     int32_t *size);
 static void TSS_SpecIdEventAlgorithmSize_Trace(TCG_EfiSpecIdEventAlgorithmSize *algSize);
+static TPM_RC TSS_EVENT2_Header_LE_Unmarshal(TCG_PCR_EVENT2 *target,
+					     uint8_t **eventData,
+					     BYTE **buffer, int32_t *size,
+					     const TCG_EfiSpecIDEvent *specIdEvent);
 
 /* TSS_EVENT_Line_Read() reads a TPM 1.2 SHA-1 event line from a binary file inFile.
 
@@ -198,6 +202,13 @@ TPM_RC TSS_SpecIdEvent_Unmarshal(TCG_EfiSpecIDEvent *specIdEvent,
     if (rc == 0) {
 	rc = UINT32LE_Unmarshal(&(specIdEvent->numberOfAlgorithms), &buffer, &size);
     }
+    if (rc == 0) {
+	if (specIdEvent->numberOfAlgorithms > HASH_COUNT) {
+	    printf("TSS_SpecIdEvent_Unmarshal: Error, numberOfAlgorithms %u greater than %u\n",
+		   specIdEvent->numberOfAlgorithms, HASH_COUNT);
+	    rc = ERR_STRUCTURE;
+	}
+    }
     for (i = 0 ; (rc == 0) && (i < specIdEvent->numberOfAlgorithms) ; i++) {
 	rc = TSS_SpecIdEventAlgorithmSize_Unmarshal(&(specIdEvent->digestSizes[i]),
 						    &buffer, &size);
@@ -484,7 +495,8 @@ TPM_RC TSS_EVENT2_Line_Unmarshal(TCG_PCR_EVENT2 *target, BYTE **buffer, INT32 *s
 /* TSS_EVENT2_PCR_Extend() extends a PCR digest with the digest from the TCG_PCR_EVENT2 event log
    entry.
 
-   FIXME - currently handles only PCR 0-7 and SHA-256.
+   Handles only PCR 0-7 and SHA-256.  See TSS_EVENT2_PCR_Banks_Extend() to replay all PCRs and
+   banks.
 */
 
 TPM_RC TSS_EVENT2_PCR_Extend(TPMT_HA pcrs[8],
@@ -530,6 +542,341 @@ TPM_RC TSS_EVENT2_PCR_Extend(TPMT_HA pcrs[8],
     return rc;
 }
 
+/* TSS_EVENT_Line_LE_Unmarshal() unmarshals a TPM 1.2 SHA-1 event line from a little endian event
+   log buffer.  It is typically used for the first event of a TPM 2.0 log, which holds the
+   TCG_EfiSpecIDEvent.
+*/
+
+TPM_RC TSS_EVENT_Line_LE_Unmarshal(TCG_PCR_EVENT *target, BYTE **buffer, int32_t *size)
+{
+    TPM_RC rc = 0;
+
+    if (rc == 0) {
+	rc = UINT32LE_Unmarshal(&target->pcrIndex, buffer, size);
+    }
+    if (rc == 0) {
+	rc = UINT32LE_Unmarshal(&target->eventType, buffer, size);
+    }
+    if (rc == 0) {
+	rc = Array_Unmarshal(target->digest, sizeof(target->digest), buffer, size);
+    }
+    if (rc == 0) {
+	rc = UINT32LE_Unmarshal(&target->eventDataSize, buffer, size);
+    }
+    if (rc == 0) {
+	if (target->eventDataSize > sizeof(target->event)) {
+	    printf("TSS_EVENT_Line_LE_Unmarshal: Error, event size too big: %u\n",
+		   target->eventDataSize);
+	    rc = ERR_STRUCTURE;
+	}
+    }
+    if (rc == 0) {
+	rc = Array_Unmarshal(target->event, target->eventDataSize, buffer, size);
+    }
+    return rc;
+}
+
+/* TSS_EVENT2_Line_LE_Unmarshal() unmarshals a TPM 2.0 hash agile event line from a little endian
+   event log buffer.
+
+   If specIdEvent is not NULL, its digest sizes are used to skip digests for algorithms unknown to
+   the TSS.  Those digests are not returned in target.  If specIdEvent is NULL, an unknown
+   algorithm is an error.
+*/
+
+TPM_RC TSS_EVENT2_Line_LE_Unmarshal(TCG_PCR_EVENT2 *target, BYTE **buffer, int32_t *size,
+				    const TCG_EfiSpecIDEvent *specIdEvent)
+{
+    TPM_RC 	rc = 0;
+    uint8_t	*eventData;
+
+    if (rc == 0) {
+	rc = TSS_EVENT2_Header_LE_Unmarshal(target, &eventData, buffer, size, specIdEvent);
+    }
+    if (rc == 0) {
+	if (target->eventSize > sizeof(target->event)) {
+	    printf("TSS_EVENT2_Line_LE_Unmarshal: Error, event size too big: %u\n",
+		   target->eventSize);
+	    rc = ERR_STRUCTURE;
+	}
+    }
+    if (rc == 0) {
+	memcpy(target->event, eventData, target->eventSize);
+    }
+    return rc;
+}
+
+/* TSS_EVENT2_Header_LE_Unmarshal() unmarshals all but the event data of a TPM 2.0 event line.  The
+   event data is not copied.  eventData points to it in the buffer, and the buffer is moved past
+   it.  Since the event is not copied, it is not limited to TCG_EVENT_LEN_MAX.
+*/
+
+static TPM_RC TSS_EVENT2_Header_LE_Unmarshal(TCG_PCR_EVENT2 *target,
+					     uint8_t **eventData,
+					     BYTE **buffer, int32_t *size,
+					     const TCG_EfiSpecIDEvent *specIdEvent)
+{
+    TPM_RC 	rc = 0;
+    uint32_t 	count;		/* digests in the log */
+    uint32_t 	i;
+    uint32_t 	a;
+    uint16_t	hashAlg;
+    uint16_t	digestSize;
+
+    if (rc == 0) {
+	rc = UINT32LE_Unmarshal(&target->pcrIndex, buffer, size);
+    }
+    if (rc == 0) {
+	rc = UINT32LE_Unmarshal(&target->eventType, buffer, size);
+    }
+    if (rc == 0) {
+	rc = UINT32LE_Unmarshal(&count, buffer, size);
+    }
+    if (rc == 0) {
+	if (count == 0) {
+	    printf("TSS_EVENT2_Header_LE_Unmarshal: Error, digest count is zero\n");
+	    rc = ERR_STRUCTURE;
+	}
+    }
+    target->digests.count = 0;
+    for (i = 0 ; (rc == 0) && (i < count) ; i++) {
+	if (rc == 0) {
+	    rc = UINT16LE_Unmarshal(&hashAlg, buffer, size);
+	}
+	if (rc == 0) {
+	    digestSize = TSS_GetDigestSize(hashAlg);
+	    /* an algorithm known to the TSS */
+	    if (digestSize != 0) {
+		if (target->digests.count >= HASH_COUNT) {
+		    printf("TSS_EVENT2_Header_LE_Unmarshal: Error, digest count %u "
+			   "is greater than structure %u\n", count, HASH_COUNT);
+		    rc = ERR_STRUCTURE;
+		}
+		if (rc == 0) {
+		    target->digests.digests[target->digests.count].hashAlg = hashAlg;
+		    rc = Array_Unmarshal((uint8_t *)
+					 &target->digests.digests[target->digests.count].digest,
+					 digestSize, buffer, size);
+		}
+		if (rc == 0) {
+		    target->digests.count++;
+		}
+	    }
+	    /* an unknown algorithm, get the size from the TCG_EfiSpecIDEvent and skip it */
+	    else {
+		for (a = 0 ; (specIdEvent != NULL) && (a < specIdEvent->numberOfAlgorithms) ; a++) {
+		    if (specIdEvent->digestSizes[a].algorithmId == hashAlg) {
+			digestSize = specIdEvent->digestSizes[a].digestSize;
+			break;
+		    }
+		}
+		if ((digestSize == 0) || (*size < (int32_t)digestSize)) {
+		    printf("TSS_EVENT2_Header_LE_Unmarshal: Error, "
+			   "unknown digest algorithm %04x\n", hashAlg);
+		    rc = ERR_STRUCTURE;
+		}
+		else {
+		    *buffer += digestSize;
+		    *size -= digestSize;
+		}
+	    }
+	}
+    }
+    if (rc == 0) {
+	rc = UINT32LE_Unmarshal(&target->eventSize, buffer, size);
+    }
+    if (rc == 0) {
+	if ((*size < 0) || (target->eventSize > (uint32_t)*size)) {
+	    printf("TSS_EVENT2_Header_LE_Unmarshal: Error, event size %u past end of log\n",
+		   target->eventSize);
+	    rc = TPM_RC_INSUFFICIENT;
+	}
+    }
+    if (rc == 0) {
+	*eventData = *buffer;
+	*buffer += target->eventSize;
+	*size -= target->eventSize;
+    }
+    return rc;
+}
+
+/* TSS_EVENT2_PCR_Banks_Init() selects the PCR banks from the algorithms in the TCG_EfiSpecIDEvent
+   and sets the PCRs to their reset values.  Algorithms unknown to the TSS are skipped.
+
+   Per the PC Client PTP, PCR 17-22 reset to all ones.  They are only reset to zero by a dynamic
+   launch, which is not in the SRTM log.
+*/
+
+TPM_RC TSS_EVENT2_PCR_Banks_Init(TSS_EVENT2_PCR_BANKS *banks,
+				 const TCG_EfiSpecIDEvent *specIdEvent)
+{
+    TPM_RC 	rc = 0;
+    uint32_t 	a;
+    uint32_t 	pcr;
+    uint16_t	digestSize;
+    
+    banks->bankCount = 0;
+    for (a = 0 ; (rc == 0) && (a < specIdEvent->numberOfAlgorithms) ; a++) {
+	digestSize = TSS_GetDigestSize(specIdEvent->digestSizes[a].algorithmId);
+	if (digestSize == 0) {
+	    continue;
+	}
+	for (pcr = 0 ; pcr < IMPLEMENTATION_PCR ; pcr++) {
+	    banks->pcrs[banks->bankCount][pcr].hashAlg = specIdEvent->digestSizes[a].algorithmId;
+	    if ((pcr >= 17) && (pcr <= 22)) {
+		memset((uint8_t *)&banks->pcrs[banks->bankCount][pcr].digest, 0xff, digestSize);
+	    }
+	    else {
+		memset((uint8_t *)&banks->pcrs[banks->bankCount][pcr].digest, 0, digestSize);
+	    }
+	}
+	banks->digestSize[banks->bankCount] = digestSize;
+	banks->bankCount++;
+    }
+    if (rc == 0) {
+	if (banks->bankCount == 0) {
+	    printf("ERROR: TSS_EVENT2_PCR_Banks_Init: no supported algorithm in the log\n");
+	    rc = 1;
+	}
+    }
+    return rc;
+}
+
+/* TSS_EVENT2_PCR_Banks_Extend() extends the event digests into all PCR banks.
+
+   EV_NO_ACTION events are not extended.  The StartupLocality EV_NO_ACTION event sets the PCR 0
+   initial value to the locality.  It is valid only before the first PCR 0 extend.
+*/
+
+TPM_RC TSS_EVENT2_PCR_Banks_Extend(TSS_EVENT2_PCR_BANKS *banks,
+				   const TCG_PCR_EVENT2 *event2)
+{
+    TPM_RC rc = 0;
+    uint32_t b;				/* iterator through PCR banks */
+
+    if (event2->eventType == EV_NO_ACTION) {
+	if ((event2->eventSize >= sizeof(TCG_STARTUP_LOCALITY_SIGNATURE) + 1) &&
+	    (memcmp(event2->event, TCG_STARTUP_LOCALITY_SIGNATURE,
+		    sizeof(TCG_STARTUP_LOCALITY_SIGNATURE)) == 0)) {
+	    for (b = 0 ; b < banks->bankCount ; b++) {
+		banks->pcrs[b][0].digest.tssmax[banks->digestSize[b] - 1] =
+		    event2->event[sizeof(TCG_STARTUP_LOCALITY_SIGNATURE)];
+	    }
+	}
+	return rc;
+    }
+    if (rc == 0) {
+	if (event2->pcrIndex >= IMPLEMENTATION_PCR) {
+	    printf("ERROR: TSS_EVENT2_PCR_Banks_Extend: PCR number %u out of range\n",
+		   event2->pcrIndex);
+	    rc = 1;
+	}
+    }
+    for (b = 0 ; (rc == 0) && (b < banks->bankCount) ; b++) {
+	TPMT_HA *pcr = &banks->pcrs[b][event2->pcrIndex];
+	uint32_t i;
+	/* the digest for this bank is usually at the same index */
+	if ((b < event2->digests.count) && (event2->digests.digests[b].hashAlg == pcr->hashAlg)) {
+	    i = b;
+	}
+	else {
+	    for (i = 0 ; i < event2->digests.count ; i++) {
+		if (event2->digests.digests[i].hashAlg == pcr->hashAlg) {
+		    break;
+		}
+	    }
+	}
+	if (i == event2->digests.count) {
+	    printf("ERROR: TSS_EVENT2_PCR_Banks_Extend: no %04x entry in event record, PCR %u\n",
+		   pcr->hashAlg, event2->pcrIndex);
+	    rc = 1;
+	}
+	if (rc == 0) {
+	    rc = TSS_Hash_Generate(pcr,
+				   banks->digestSize[b], (uint8_t *)&pcr->digest,
+				   banks->digestSize[b], &event2->digests.digests[i].digest,
+				   0, NULL);
+	}
+    }
+    return rc;
+}
+
+/* TSS_EVENT2_Log_Replay() replays a complete TPM 2.0 hash agile event log in one pass.
+
+   The log is a little endian buffer, typically read from
+   /sys/kernel/security/tpm0/binary_bios_measurements.  The first event must hold the
+   TCG_EfiSpecIDEvent, whose algorithm list selects the PCR banks.  All PCRs in all banks are
+   replayed.  Event data is not copied, so events larger than TCG_EVENT_LEN_MAX are accepted.
+
+   specIdEvent is returned for the caller's trace and may be NULL.
+*/
+
+TPM_RC TSS_EVENT2_Log_Replay(TSS_EVENT2_PCR_BANKS *banks,
+			     TCG_EfiSpecIDEvent *specIdEvent,
+			     uint32_t *eventCount,
+			     const uint8_t *log,
+			     uint32_t logLength)
+{
+    TPM_RC		rc = 0;
+    uint8_t		*buffer = (uint8_t *)log;
+    int32_t		size = logLength;
+    TCG_PCR_EVENT	*event = NULL;		/* freed @1 */
+    TCG_PCR_EVENT2	*event2 = NULL;		/* freed @2 */
+    TCG_EfiSpecIDEvent	localSpecIdEvent;
+    uint8_t		*eventData;
+
+    if (specIdEvent == NULL) {
+	specIdEvent = &localSpecIdEvent;
+    }
+    *eventCount = 0;
+    if (rc == 0) {
+	if (logLength > 0x7fffffff) {
+	    printf("ERROR: TSS_EVENT2_Log_Replay: log length %u too large\n", logLength);
+	    rc = ERR_STRUCTURE;
+	}
+    }
+    /* the structures are too large for the stack on some platforms */
+    if (rc == 0) {
+	event = malloc(sizeof(TCG_PCR_EVENT));
+	event2 = malloc(sizeof(TCG_PCR_EVENT2));
+	if ((event == NULL) || (event2 == NULL)) {
+	    printf("ERROR: TSS_EVENT2_Log_Replay: could not allocate event\n");
+	    rc = TSS_RC_OUT_OF_MEMORY;
+	}
+    }
+    /* the first event is a TPM 1.2 format event holding the TCG_EfiSpecIDEvent */
+    if (rc == 0) {
+	rc = TSS_EVENT_Line_LE_Unmarshal(event, &buffer, &size);
+    }
+    if (rc == 0) {
+	rc = TSS_SpecIdEvent_Unmarshal(specIdEvent, event->eventDataSize, event->event);
+    }
+    if (rc == 0) {
+	rc = TSS_EVENT2_PCR_Banks_Init(banks, specIdEvent);
+    }
+    while ((rc == 0) && (size > 0)) {
+	rc = TSS_EVENT2_Header_LE_Unmarshal(event2, &eventData, &buffer, &size, specIdEvent);
+	/* only a StartupLocality EV_NO_ACTION event uses the event data */
+	if ((rc == 0) && (event2->eventType == EV_NO_ACTION)) {
+	    event2->eventSize = (event2->eventSize < sizeof(event2->event)) ?
+				event2->eventSize : sizeof(event2->event);
+	    memcpy(event2->event, eventData, event2->eventSize);
+	}
+	if (rc == 0) {
+	    rc = TSS_EVENT2_PCR_Banks_Extend(banks, event2);
+	}
+	if (rc == 0) {
+	    (*eventCount)++;
+	}
+	else {
+	    printf("ERROR: TSS_EVENT2_Log_Replay: failed at event %u\n", *eventCount + 1);
+	}
+    }
+    free(event);	/* @1 */
+    free(event2);	/* @2 */
+    return rc;
+}
+
 /* Uint16_Convert() converts a little endian uint16_t (from an input stream) to host byte order
  */
 
@@ -565,7 +912,7 @@ static uint32_t Uint32_Convert(uint32_t in)
 static TPM_RC
 UINT16LE_Unmarshal(uint16_t *target, BYTE **buffer, int32_t *size)
 {
-    if ((uint16_t)*size < sizeof(uint16_t)) {
+    if (*size < (int32_t)sizeof(uint16_t)) {
 	return TPM_RC_INSUFFICIENT;
     }
     *target = ((uint16_t)((*buffer)[0]) <<  0) |
@@ -580,7 +927,7 @@ UINT16LE_Unmarshal(uint16_t *target, BYTE **buffer, int32_t *size)
 static TPM_RC
 UINT32LE_Unmarshal(uint32_t *target, BYTE **buffer, int32_t *size)
 {
-    if ((uint32_t)*size < sizeof(uint32_t)) {
+    if (*size < (int32_t)sizeof(uint32_t)) {
 	return TPM_RC_INSUFFICIENT;
     }
     *target = ((uint32_t)((*buffer)[0]) <<  0) |
@@ -137,6 +137,20 @@ typedef struct tdTCG_EfiSpecIdEvent {
     uint8_t 					vendorInfo[0xff]; 
 } TCG_EfiSpecIDEvent;
 
+/* StartupLocality EV_NO_ACTION event signature, including the nul terminator.  The signature is
+   followed by the one byte locality. */
+
+#define TCG_STARTUP_LOCALITY_SIGNATURE "StartupLocality"
+
+/* TSS_EVENT2_PCR_BANKS holds the software PCRs for an event log replay, one bank for each
+   algorithm in the TCG_EfiSpecIDEvent that is known to the TSS. */
+
+typedef struct {
+    uint32_t 		bankCount;
+    uint16_t		digestSize[HASH_COUNT];
+    TPMT_HA		pcrs[HASH_COUNT][IMPLEMENTATION_PCR];
+} TSS_EVENT2_PCR_BANKS;
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -155,9 +169,26 @@ extern "C" {
 
     TPM_RC TSS_EVENT2_Line_Unmarshal(TCG_PCR_EVENT2 *target, BYTE **buffer, INT32 *size);
 
+    TPM_RC TSS_EVENT_Line_LE_Unmarshal(TCG_PCR_EVENT *target, BYTE **buffer, int32_t *size);
+
+    TPM_RC TSS_EVENT2_Line_LE_Unmarshal(TCG_PCR_EVENT2 *target, BYTE **buffer, int32_t *size,
+					const TCG_EfiSpecIDEvent *specIdEvent);
+
     TPM_RC TSS_EVENT2_PCR_Extend(TPMT_HA pcrs[8],
 				 TCG_PCR_EVENT2 *event2);
 
+    TPM_RC TSS_EVENT2_PCR_Banks_Init(TSS_EVENT2_PCR_BANKS *banks,
+				     const TCG_EfiSpecIDEvent *specIdEvent);
+
+    TPM_RC TSS_EVENT2_PCR_Banks_Extend(TSS_EVENT2_PCR_BANKS *banks,
+				       const TCG_PCR_EVENT2 *event2);
+
+    TPM_RC TSS_EVENT2_Log_Replay(TSS_EVENT2_PCR_BANKS *banks,
+				 TCG_EfiSpecIDEvent *specIdEvent,
+				 uint32_t *eventCount,
+				 const uint8_t *log,
+				 uint32_t logLength);
+
     void TSS_EVENT_Line_Trace(TCG_PCR_EVENT *event);
 
     void TSS_EVENT2_Line_Trace(TCG_PCR_EVENT2 *event);
@@ -0,0 +1,440 @@
+/********************************************************************************/
+/*										*/
+/*			Event Log Replay and Benchmark				*/
+/*		       IBM Thomas J. Watson Research Center			*/
+/*			     $Id: eventreplay.c $				*/
+/*										*/
+/* (c) Copyright IBM Corporation 2017.						*/
+/*										*/
+/* All rights reserved.								*/
+/* 										*/
+/* Redistribution and use in source and binary forms, with or without		*/
+/* modification, are permitted provided that the following conditions are	*/
+/* met:										*/
+/* 										*/
+/* Redistributions of source code must retain the above copyright notice,	*/
+/* this list of conditions and the following disclaimer.			*/
+/* 										*/
+/* Redistributions in binary form must reproduce the above copyright		*/
+/* notice, this list of conditions and the following disclaimer in the		*/
+/* documentation and/or other materials provided with the distribution.		*/
+/* 										*/
+/* Neither the names of the IBM Corporation nor the names of its		*/
+/* contributors may be used to endorse or promote products derived from		*/
+/* this software without specific prior written permission.			*/
+/* 										*/
+/* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS		*/
+/* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT		*/
+/* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR	*/
+/* A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT		*/
+/* HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,	*/
+/* SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT		*/
+/* LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,	*/
+/* DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY	*/
+/* THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT		*/
+/* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE	*/
+/* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.		*/
+/********************************************************************************/
+
+
+/* eventreplay is test/demo code.  It replays a TPM 2.0 hash agile event log in software, with no
+   TPM, and prints the resulting PCRs for every bank in the log.
+
+   It can also write a synthetic UEFI event log and time the replay, as a benchmark of the event
+   log parser and PCR extend.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <tss2/tss.h>
+#include <tss2/tssutils.h>
+#include <tss2/tssfile.h>
+#include <tss2/tsscryptoh.h>
+#include <tss2/tssresponsecode.h>
+
+#include "eventlib.h"
+
+/* local prototypes */
+
+static void printUsage(void);
+static TPM_RC readLog(unsigned char **log,
+		      size_t *logLength,
+		      const char *filename);
+static TPM_RC generateLog(const char *filename,
+			  unsigned int events);
+static void putUint16LE(uint8_t **buffer, uint16_t value);
+static void putUint32LE(uint8_t **buffer, uint32_t value);
+
+int verbose = FALSE;
+
+int main(int argc, char * argv[])
+{
+    TPM_RC 			rc = 0;
+    int 			i = 0;
+    const char 			*infilename = NULL;
+    const char 			*outfilename = NULL;
+    unsigned int		generate = 0;
+    unsigned int		iterations = 1;
+    unsigned int		iter;
+    unsigned char 		*log = NULL;		/* freed @1 */
+    size_t			logLength;
+    TSS_EVENT2_PCR_BANKS	*banks = NULL;		/* freed @2 */
+    TCG_EfiSpecIDEvent 		specIdEvent;
+    uint32_t			eventCount = 0;
+    clock_t			startTime;
+    clock_t			endTime;
+	
+    setvbuf(stdout, 0, _IONBF, 0);      /* output may be going through pipe to log file */
+    TSS_SetProperty(NULL, TPM_TRACE_LEVEL, "1");
+
+    for (i=1 ; i<argc ; i++) {
+	if (strcmp(argv[i],"-if") == 0) {
+	    i++;
+	    if (i < argc) {
+		infilename = argv[i];
+	    }
+	    else {
+		printf("-if option needs a value\n");
+		printUsage();
+	    }
+	}
+	else if (strcmp(argv[i],"-of") == 0) {
+	    i++;
+	    if (i < argc) {
+		outfilename = argv[i];
+	    }
+	    else {
+		printf("-of option needs a value\n");
+		printUsage();
+	    }
+	}
+	else if (strcmp(argv[i],"-gen") == 0) {
+	    i++;
+	    if (i < argc) {
+		sscanf(argv[i],"%u", &generate);
+	    }
+	    else {
+		printf("Missing parameter for -gen\n");
+		printUsage();
+	    }
+	}
+	else if (strcmp(argv[i],"-it") == 0) {
+	    i++;
+	    if (i < argc) {
+		sscanf(argv[i],"%u", &iterations);
+	    }
+	    else {
+		printf("Missing parameter for -it\n");
+		printUsage();
+	    }
+	}
+	else if (!strcmp(argv[i], "-h")) {
+	    printUsage();
+	}
+	else if (!strcmp(argv[i], "-v")) {
+	    verbose = TRUE;
+	    TSS_SetProperty(NULL, TPM_TRACE_LEVEL, "2");
+	}
+	else {
+	    printf("\n%s is not a valid option\n", argv[i]);
+	    printUsage();
+	}
+    }
+    if (generate != 0) {
+	if (outfilename == NULL) {
+	    printf("-gen requires -of\n");
+	    printUsage();
+	}
+	rc = generateLog(outfilename, generate);
+	if (infilename == NULL) {
+	    infilename = outfilename;
+	}
+    }
+    if (infilename == NULL) {
+	printf("Missing -if argument\n");
+	printUsage();
+    }
+    if (iterations == 0) {
+	printf("-it must be at least 1\n");
+	printUsage();
+    }
+    /* read the complete event log, parsing is from the buffer */
+    if (rc == 0) {
+	rc = readLog(&log,     			/* freed @1 */
+		     &logLength,
+		     infilename);
+    }
+    if (rc == 0) {
+	banks = malloc(sizeof(TSS_EVENT2_PCR_BANKS));		/* freed @2 */
+	if (banks == NULL) {
+	    printf("Cannot allocate PCR banks\n");
+	    rc = TSS_RC_OUT_OF_MEMORY;
+	}
+    }
+    startTime = clock();
+    for (iter = 0 ; (rc == 0) && (iter < iterations) ; iter++) {
+	rc = TSS_EVENT2_Log_Replay(banks, &specIdEvent, &eventCount,
+				   log, (uint32_t)logLength);
+    }
+    endTime = clock();
+    if ((rc == 0) && verbose) {
+	TSS_SpecIdEvent_Trace(&specIdEvent);
+    }
+    if (rc == 0) {
+	uint32_t b;
+	uint32_t pcr;
+	for (b = 0 ; b < banks->bankCount ; b++) {
+	    for (pcr = 0 ; pcr < IMPLEMENTATION_PCR ; pcr++) {
+		uint16_t d;
+		printf("PCR %02u %04x ", pcr, banks->pcrs[b][pcr].hashAlg);
+		for (d = 0 ; d < banks->digestSize[b] ; d++) {
+		    printf("%02x", banks->pcrs[b][pcr].digest.tssmax[d]);
+		}
+		printf("\n");
+	    }
+	}
+    }
+    if ((rc == 0) && (iterations > 1)) {
+	double seconds = (double)(endTime - startTime) / CLOCKS_PER_SEC;
+	printf("Events %u banks %u iterations %u time %f time per replay %f events per second %.0f\n",
+	       eventCount, banks->bankCount, iterations, seconds, seconds / iterations,
+	       (seconds > 0) ? ((double)eventCount * iterations) / seconds : 0);
+    }
+    if (rc == 0) {
+	if (verbose) printf("eventreplay: success\n");
+    }
+    else {
+	const char *msg;
+	const char *submsg;
+	const char *num;
+	printf("eventreplay: failed, rc %08x\n", rc);
+	TSS_ResponseCode_toString(&msg, &submsg, &num, rc);
+	printf("%s%s%s\n", msg, submsg, num);
+	rc = EXIT_FAILURE;
+    }
+    free(log);		/* @1 */
+    free(banks);	/* @2 */
+    return rc;
+}
+
+/* readLog() reads the complete event log into a buffer.
+
+   TSS_File_ReadBinaryFile() is not used because a firmware log is often larger than the TSS
+   allocation limit, and because the securityfs file does not report its size.
+*/
+
+static TPM_RC readLog(unsigned char **log,
+		      size_t *logLength,
+		      const char *filename)
+{
+    TPM_RC 		rc = 0;
+    FILE		*file = NULL;		/* closed @1 */
+    size_t		allocated = 0;
+    size_t		readSize;
+    unsigned char	*tmp;
+
+    *logLength = 0;
+    if (rc == 0) {
+	rc = TSS_File_Open(&file, filename, "rb");	/* closed @1 */
+    }
+    while (rc == 0) {
+	if (*logLength == allocated) {
+	    allocated = (allocated == 0) ? 0x10000 : (allocated * 2);
+	    tmp = realloc(*log, allocated);
+	    if (tmp == NULL) {
+		printf("readLog: Cannot allocate %lu bytes\n", (unsigned long)allocated);
+		rc = TSS_RC_OUT_OF_MEMORY;
+		break;
+	    }
+	    *log = tmp;
+	}
+	readSize = fread(*log + *logLength, 1, allocated - *logLength, file);
+	*logLength += readSize;
+	if (readSize == 0) {
+	    if (ferror(file)) {
+		printf("readLog: Error reading %s\n", filename);
+		rc = TSS_RC_FILE_READ;
+	    }
+	    break;
+	}
+    }
+    if ((rc == 0) && (*logLength > 0x7fffffff)) {
+	printf("readLog: %s is too large\n", filename);
+	rc = TSS_RC_FILE_READ;
+    }
+    if (file != NULL) {
+	fclose(file);	/* @1 */
+    }
+    return rc;
+}
+
+/* generateLog() writes a synthetic UEFI event log with SHA-1, SHA-256, and SHA-384 banks.
+
+   The first event is the TCG_EfiSpecIDEvent.  It is followed by a StartupLocality event and then
+   'events' measurements spread over PCR 0-9 and 14, with event sizes from 32 to 4095 bytes.
+*/
+
+static TPM_RC generateLog(const char *filename,
+			  unsigned int events)
+{
+    TPM_RC 		rc = 0;
+    static const TPMI_ALG_HASH algs[] = {TPM_ALG_SHA1, TPM_ALG_SHA256, TPM_ALG_SHA384};
+    static const uint32_t pcrs[] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 14};
+    static const uint32_t eventTypes[] = {EV_POST_CODE,
+					  EV_EFI_VARIABLE_DRIVER_CONFIG,
+					  EV_EFI_VARIABLE_BOOT,
+					  EV_EFI_BOOT_SERVICES_APPLICATION,
+					  EV_EFI_BOOT_SERVICES_DRIVER,
+					  EV_EFI_PLATFORM_FIRMWARE_BLOB,
+					  EV_IPL};
+    size_t		algCount = sizeof(algs) / sizeof(algs[0]);
+    size_t		lineMax;
+    uint8_t		*line = NULL;		/* freed @1 */
+    uint8_t		*buffer;
+    FILE		*file = NULL;		/* closed @2 */
+    unsigned int 	e;
+    uint32_t		eventSize;
+    size_t		a;
+    TPMT_HA		digest;
+
+    /* PCR index, event type, count, digests, event size, event */
+    lineMax = 4 + 4 + 4 + (algCount * (2 + SHA384_DIGEST_SIZE)) + 4 + TCG_EVENT_LEN_MAX;
+    if (rc == 0) {
+	line = malloc(lineMax);
+	if (line == NULL) {
+	    printf("generateLog: Cannot allocate %lu bytes\n", (unsigned long)lineMax);
+	    rc = TSS_RC_OUT_OF_MEMORY;
+	}
+    }
+    if (rc == 0) {
+	rc = TSS_File_Open(&file, filename, "wb");	/* closed @2 */
+    }
+    /* TPM 1.2 format first event holding the TCG_EfiSpecIDEvent */
+    if (rc == 0) {
+	static const uint8_t signature[16] = "Spec ID Event03";
+	uint8_t *eventStart;
+	buffer = line;
+	putUint32LE(&buffer, 0);
+	putUint32LE(&buffer, EV_NO_ACTION);
+	memset(buffer, 0, SHA1_DIGEST_SIZE);
+	buffer += SHA1_DIGEST_SIZE;
+	eventStart = buffer + 4;
+	buffer = eventStart;
+	memcpy(buffer, signature, sizeof(signature));
+	buffer += sizeof(signature);
+	putUint32LE(&buffer, 0);		/* platformClass */
+	*buffer++ = 0;				/* specVersionMinor */
+	*buffer++ = 2;				/* specVersionMajor */
+	*buffer++ = 0;				/* specErrata */
+	*buffer++ = 2;				/* uintnSize */
+	putUint32LE(&buffer, (uint32_t)algCount);
+	for (a = 0 ; a < algCount ; a++) {
+	    putUint16LE(&buffer, algs[a]);
+	    putUint16LE(&buffer, TSS_GetDigestSize(algs[a]));
+	}
+	*buffer++ = 0;				/* vendorInfoSize */
+	eventSize = (uint32_t)(buffer - eventStart);
+	buffer = eventStart - 4;
+	putUint32LE(&buffer, eventSize);
+	if (fwrite(line, (size_t)(eventStart - line) + eventSize, 1, file) != 1) {
+	    printf("generateLog: Error writing %s\n", filename);
+	    rc = TSS_RC_FILE_WRITE;
+	}
+    }
+    /* StartupLocality event */
+    if (rc == 0) {
+	buffer = line;
+	putUint32LE(&buffer, 0);
+	putUint32LE(&buffer, EV_NO_ACTION);
+	putUint32LE(&buffer, (uint32_t)algCount);
+	for (a = 0 ; a < algCount ; a++) {
+	    putUint16LE(&buffer, algs[a]);
+	    memset(buffer, 0, TSS_GetDigestSize(algs[a]));
+	    buffer += TSS_GetDigestSize(algs[a]);
+	}
+	putUint32LE(&buffer, sizeof(TCG_STARTUP_LOCALITY_SIGNATURE) + 1);
+	memcpy(buffer, TCG_STARTUP_LOCALITY_SIGNATURE, sizeof(TCG_STARTUP_LOCALITY_SIGNATURE));
+	buffer += sizeof(TCG_STARTUP_LOCALITY_SIGNATURE);
+	*buffer++ = 3;				/* H-CRTM locality */
+	if (fwrite(line, buffer - line, 1, file) != 1) {
+	    printf("generateLog: Error writing %s\n", filename);
+	    rc = TSS_RC_FILE_WRITE;
+	}
+    }
+    for (e = 0 ; (rc == 0) && (e < events) ; e++) {
+	uint8_t *eventData;
+	/* deterministic sizes, mostly small with an occasional large variable or blob */
+	eventSize = ((e % 16) == 15) ? (TCG_EVENT_LEN_MAX - 1) : (32 + ((e * 97) % 480));
+	buffer = line;
+	putUint32LE(&buffer, pcrs[e % (sizeof(pcrs) / sizeof(pcrs[0]))]);
+	putUint32LE(&buffer, eventTypes[e % (sizeof(eventTypes) / sizeof(eventTypes[0]))]);
+	putUint32LE(&buffer, (uint32_t)algCount);
+	/* the event data follows the digests */
+	eventData = buffer + (algCount * 2) + 4;
+	for (a = 0 ; a < algCount ; a++) {
+	    eventData += TSS_GetDigestSize(algs[a]);
+	}
+	memset(eventData, (int)(e & 0xff), eventSize);
+	memcpy(eventData, &e, sizeof(e));
+	/* digests of the event data */
+	for (a = 0 ; (rc == 0) && (a < algCount) ; a++) {
+	    digest.hashAlg = algs[a];
+	    rc = TSS_Hash_Generate(&digest,
+				   eventSize, eventData,
+				   0, NULL);
+	    if (rc == 0) {
+		putUint16LE(&buffer, algs[a]);
+		memcpy(buffer, (uint8_t *)&digest.digest, TSS_GetDigestSize(algs[a]));
+		buffer += TSS_GetDigestSize(algs[a]);
+	    }
+	}
+	if (rc == 0) {
+	    putUint32LE(&buffer, eventSize);
+	    if (fwrite(line, (buffer - line) + eventSize, 1, file) != 1) {
+		printf("generateLog: Error writing %s\n", filename);
+		rc = TSS_RC_FILE_WRITE;
+	    }
+	}
+    }
+    if (file != NULL) {
+	fclose(file);	/* @2 */
+    }
+    free(line);		/* @1 */
+    return rc;
+}
+
+static void putUint16LE(uint8_t **buffer, uint16_t value)
+{
+    (*buffer)[0] = (uint8_t)(value >> 0);
+    (*buffer)[1] = (uint8_t)(value >> 8);
+    *buffer += 2;
+    return;
+}
+
+static void putUint32LE(uint8_t **buffer, uint32_t value)
+{
+    (*buffer)[0] = (uint8_t)(value >>  0);
+    (*buffer)[1] = (uint8_t)(value >>  8);
+    (*buffer)[2] = (uint8_t)(value >> 16);
+    (*buffer)[3] = (uint8_t)(value >> 24);
+    *buffer += 4;
+    return;
+}
+
+static void printUsage(void)
+{
+    printf("\n");
+    printf("eventreplay\n");
+    printf("\n");
+    printf("Replays a TPM 2.0 event log (binary) in software and prints all PCR banks\n");
+    printf("\n");
+    printf("\t-if\tevent log file\n");
+    printf("\t[-gen\tnumber of events in a synthetic log to write to -of]\n");
+    printf("\t[-of\tsynthetic log file]\n");
+    printf("\t[-it\tnumber of replays to time (default 1)]\n");
+    printf("\n");
+    exit(1);
+}
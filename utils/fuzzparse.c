@@ -0,0 +1,307 @@
+/********************************************************************************/
+/*										*/
+/*			     Parser Fuzz Targets				*/
+/*		       IBM Thomas J. Watson Research Center			*/
+/*			      $Id: fuzzparse.c $				*/
+/*										*/
+/* (c) Copyright IBM Corporation 2017.						*/
+/*										*/
+/* All rights reserved.								*/
+/* 										*/
+/* Redistribution and use in source and binary forms, with or without		*/
+/* modification, are permitted provided that the following conditions are	*/
+/* met:										*/
+/* 										*/
+/* Redistributions of source code must retain the above copyright notice,	*/
+/* this list of conditions and the following disclaimer.			*/
+/* 										*/
+/* Redistributions in binary form must reproduce the above copyright		*/
+/* notice, this list of conditions and the following disclaimer in the		*/
+/* documentation and/or other materials provided with the distribution.		*/
+/* 										*/
+/* Neither the names of the IBM Corporation nor the names of its		*/
+/* contributors may be used to endorse or promote products derived from		*/
+/* this software without specific prior written permission.			*/
+/* 										*/
+/* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS		*/
+/* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT		*/
+/* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR	*/
+/* A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT		*/
+/* HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,	*/
+/* SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT		*/
+/* LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,	*/
+/* DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY	*/
+/* THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT		*/
+/* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE	*/
+/* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.		*/
+/********************************************************************************/
+
+
+
+/* fuzzparse holds fuzz targets for the parsers that handle untrusted input:
+
+   response	a command and response pair (see corpuslib.h), through the command parameter
+		unmarshal and the response unmarshal
+   ima		an IMA event log, through IMA_Event_ReadBuffer() and
+		IMA_TemplateData_ReadBuffer()
+   event2	a TPM 2.0 event log body, through TSS_EVENT2_Line_Unmarshal()
+
+   Each target copies the input to an exactly sized allocation, so that an address sanitizer
+   catches any read past the end.
+
+   Built normally, fuzzparse runs one target over input files, which suits AFL (-if @@) and
+   reproducing a crash.  Built with -DTSS_FUZZ_LIBFUZZER, it instead supplies the libFuzzer entry
+   point for the target selected by TSS_FUZZ_TARGET.  'make fuzz' builds the libFuzzer binaries.
+   Seed the response fuzzer with a corpus captured through TPM_CORPUS_DIR.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include <tss2/tss.h>
+#include <tss2/tssutils.h>
+#include <tss2/tssfile.h>
+#include <tss2/tssmarshal.h>
+#include <tss2/tssresponsecode.h>
+
+#include "corpuslib.h"
+#include "imalib.h"
+#include "eventlib.h"
+
+int TSS_Fuzz_Response(const uint8_t *data, size_t length);
+int TSS_Fuzz_ImaEvent(const uint8_t *data, size_t length);
+int TSS_Fuzz_Event2(const uint8_t *data, size_t length);
+
+int verbose = FALSE;
+int vverbose = FALSE;
+
+#ifdef TSS_FUZZ_LIBFUZZER
+
+#ifndef TSS_FUZZ_TARGET
+#define TSS_FUZZ_TARGET TSS_Fuzz_Response
+#endif
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t length);
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t length)
+{
+    return TSS_FUZZ_TARGET(data, length);
+}
+
+#else
+
+static void printUsage(void);
+
+int main(int argc, char *argv[])
+{
+    TPM_RC			rc = 0;
+    int				i;    /* argc iterator */
+    int				(*fuzzTarget)(const uint8_t *, size_t) = TSS_Fuzz_Response;
+    unsigned char 		*data = NULL;
+    size_t 			length;
+    int				files = 0;
+
+    setvbuf(stdout, 0, _IONBF, 0);      /* output may be going through pipe to log file */
+    TSS_SetProperty(NULL, TPM_TRACE_LEVEL, "1");
+
+    /* command line argument defaults */
+    for (i=1 ; (i<argc) && (rc == 0) ; i++) {
+	if (strcmp(argv[i],"-t") == 0) {
+	    i++;
+	    if (i < argc) {
+		if (strcmp(argv[i],"response") == 0) {
+		    fuzzTarget = TSS_Fuzz_Response;
+		}
+		else if (strcmp(argv[i],"ima") == 0) {
+		    fuzzTarget = TSS_Fuzz_ImaEvent;
+		}
+		else if (strcmp(argv[i],"event2") == 0) {
+		    fuzzTarget = TSS_Fuzz_Event2;
+		}
+		else {
+		    printf("Bad parameter %s for -t\n", argv[i]);
+		    printUsage();
+		}
+	    }
+	    else {
+		printf("-t option needs a value\n");
+		printUsage();
+	    }
+	}
+	else if (strcmp(argv[i],"-if") == 0) {
+	    i++;
+	    if (i < argc) {
+		/* run the target on each file as it is found, after the preceding -t */
+		rc = TSS_File_ReadBinaryFile(&data, &length, argv[i]);	/* freed @1 */
+		if (rc == 0) {
+		    if (verbose) printf("fuzzparse: %s\n", argv[i]);
+		    fuzzTarget(data, length);
+		    files++;
+		}
+		free(data);		/* @1 */
+		data = NULL;
+	    }
+	    else {
+		printf("-if option needs a value\n");
+		printUsage();
+	    }
+	}
+	else if (strcmp(argv[i],"-h") == 0) {
+	    printUsage();
+	}
+	else if (strcmp(argv[i],"-v") == 0) {
+	    verbose = TRUE;
+	    TSS_SetProperty(NULL, TPM_TRACE_LEVEL, "2");
+	}
+	else {
+	    printf("\n%s is not a valid option\n", argv[i]);
+	    printUsage();
+	}
+    }
+    if ((rc == 0) && (files == 0)) {
+	printf("Missing parameter -if\n");
+	printUsage();
+    }
+    if (rc == 0) {
+	if (verbose) printf("fuzzparse: success\n");
+    }
+    else {
+	const char *msg;
+	const char *submsg;
+	const char *num;
+	printf("fuzzparse: failed, rc %08x\n", rc);
+	TSS_ResponseCode_toString(&msg, &submsg, &num, rc);
+	printf("%s%s%s\n", msg, submsg, num);
+	rc = EXIT_FAILURE;
+    }
+    return rc;
+}
+
+static void printUsage(void)
+{
+    printf("\n");
+    printf("fuzzparse\n");
+    printf("\n");
+    printf("Runs a parser fuzz target over input files, no TPM is required\n");
+    printf("\n");
+    printf("\t[-t target response, ima, event2 (default response)]\n");
+    printf("\t-if input file, may be repeated\n");
+    printf("\n");
+    printf("\te.g. afl-fuzz -i corpus -o findings ./fuzzparse -t response -if @@\n");
+    exit(1);	
+}
+
+#endif	/* TSS_FUZZ_LIBFUZZER */
+
+/* TSS_Fuzz_Copy() copies the input to an exactly sized allocation */
+
+static uint8_t *TSS_Fuzz_Copy(const uint8_t *data, size_t length)
+{
+    uint8_t *copy = malloc(length > 0 ? length : 1);
+    if ((copy != NULL) && (length > 0)) {
+	memcpy(copy, data, length);
+    }
+    return copy;
+}
+
+/* TSS_Fuzz_Response() parses a command and response pair, then unmarshals the command parameters
+   and the response */
+
+int TSS_Fuzz_Response(const uint8_t *data, size_t length)
+{
+    TPM_RC		rc = 0;
+    uint8_t		*copy = NULL;
+    CORPUS_PAIR		corpusPair;
+    COMMAND_PARAMETERS	*commandParameters = NULL;
+    RESPONSE_PARAMETERS	*responseParameters = NULL;
+    BYTE		*buffer;
+    INT32		size;
+
+    copy = TSS_Fuzz_Copy(data, length);		/* freed @1 */
+    if (copy == NULL) {
+	rc = TSS_RC_OUT_OF_MEMORY;
+    }
+    if (rc == 0) {
+	rc = Corpus_Pair_Parse(&corpusPair, copy, length);
+    }
+    if (rc == 0) {
+	rc = TSS_Malloc((uint8_t **)&commandParameters, sizeof(COMMAND_PARAMETERS));	/* freed @2 */
+    }
+    if (rc == 0) {
+	rc = TSS_Malloc((uint8_t **)&responseParameters, sizeof(RESPONSE_PARAMETERS)); /* freed @3 */
+    }
+    if (rc == 0) {
+	buffer = corpusPair.commandParameters;
+	size = corpusPair.commandParameterSize;
+	TSS_MarshalTable_InUnmarshal(corpusPair.commandCode, commandParameters,
+				     &buffer, &size, corpusPair.handles);
+	/* the TSS only unmarshals successful responses, but the parser must survive any input */
+	buffer = corpusPair.response;
+	size = corpusPair.responseSize;
+	TSS_MarshalTable_OutUnmarshal(corpusPair.commandCode, responseParameters,
+				      corpusPair.responseTag, &buffer, &size);
+    }
+    free(copy);			/* @1 */
+    free(commandParameters);	/* @2 */
+    free(responseParameters);	/* @3 */
+    return 0;
+}
+
+/* TSS_Fuzz_ImaEvent() parses an IMA event log, both byte orders, including the template data */
+
+int TSS_Fuzz_ImaEvent(const uint8_t *data, size_t length)
+{
+    uint32_t		rc = 0;
+    uint8_t		*copy = NULL;
+    uint8_t		*buffer;
+    size_t		remaining;
+    int			endOfBuffer;
+    int			littleEndian;
+    ImaEvent		imaEvent;
+    ImaTemplateData	imaTemplateData;
+
+    copy = TSS_Fuzz_Copy(data, length);		/* freed @1 */
+    for (littleEndian = 0 ; (copy != NULL) && (littleEndian < 2) ; littleEndian++) {
+	buffer = copy;
+	remaining = length;
+	endOfBuffer = FALSE;
+	for (rc = 0 ; (rc == 0) && !endOfBuffer ; ) {
+	    IMA_Event_Init(&imaEvent);
+	    rc = IMA_Event_ReadBuffer(&imaEvent, &remaining, &buffer,
+				      &endOfBuffer, littleEndian, TRUE);
+	    if ((rc == 0) && !endOfBuffer) {
+		rc = IMA_TemplateData_ReadBuffer(&imaTemplateData, &imaEvent, littleEndian);
+	    }
+	    IMA_Event_Free(&imaEvent);
+	}
+    }
+    free(copy);			/* @1 */
+    return 0;
+}
+
+/* TSS_Fuzz_Event2() parses a TPM 2.0 event log body, the events after the first TCG_PCR_EVENT */
+
+int TSS_Fuzz_Event2(const uint8_t *data, size_t length)
+{
+    TPM_RC		rc = 0;
+    uint8_t		*copy = NULL;
+    BYTE		*buffer;
+    INT32		size;
+    TCG_PCR_EVENT2	event2;
+
+    copy = TSS_Fuzz_Copy(data, length);		/* freed @1 */
+    if ((copy == NULL) || (length > 0x7fffffff)) {
+	rc = TSS_RC_OUT_OF_MEMORY;
+    }
+    if (rc == 0) {
+	buffer = copy;
+	size = (INT32)length;
+	while ((rc == 0) && (size > 0)) {
+	    rc = TSS_EVENT2_Line_Unmarshal(&event2, &buffer, &size);
+	}
+    }
+    free(copy);			/* @1 */
+    return 0;
+}
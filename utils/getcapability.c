@@ -49,6 +49,7 @@
 #include <tss2/tss.h>
 #include <tss2/tssutils.h>
 #include <tss2/tssresponsecode.h>
+#include <tss2/tsscapability.h>
 
 static void printUsage(TPM_CAP capability);
 static TPM_RC printResponse(TPMS_CAPABILITY_DATA *capabilityData, uint32_t property);
@@ -71,6 +72,7 @@ int main(int argc, char *argv[])
     unsigned int		sessionAttributes1 = 0;
     TPMI_SH_AUTH_SESSION    	sessionHandle2 = TPM_RH_NULL;
     unsigned int		sessionAttributes2 = 0;
+    int				done = FALSE;
 
     setvbuf(stdout, 0, _IONBF, 0);      /* output may be going through pipe to log file */
     TSS_SetProperty(NULL, TPM_TRACE_LEVEL, "1");
@@ -201,17 +203,35 @@ int main(int argc, char *argv[])
     if (rc == 0) {
 	rc = TSS_Create(&tssContext);
     }
-    /* call TSS to execute the command */
-    if (rc == 0) {
-	rc = TSS_Execute(tssContext,
-			 (RESPONSE_PARAMETERS *)&out, 
-			 (COMMAND_PARAMETERS *)&in,
-			 NULL,
-			 TPM_CC_GetCapability,
-			 sessionHandle0, NULL, sessionAttributes0,
-			 sessionHandle1, NULL, sessionAttributes1,
-			 sessionHandle2, NULL, sessionAttributes2,
-			 TPM_RH_NULL, NULL, 0);
+    /* call TSS to execute the command, paging while the TPM reports moreData */
+    while ((rc == 0) && !done) {
+	if (rc == 0) {
+	    rc = TSS_Execute(tssContext,
+			     (RESPONSE_PARAMETERS *)&out, 
+			     (COMMAND_PARAMETERS *)&in,
+			     NULL,
+			     TPM_CC_GetCapability,
+			     sessionHandle0, NULL, sessionAttributes0,
+			     sessionHandle1, NULL, sessionAttributes1,
+			     sessionHandle2, NULL, sessionAttributes2,
+			     TPM_RH_NULL, NULL, 0);
+	}
+	if (rc == 0) {
+	    rc = printResponse(&out.capabilityData, property);
+	}
+	/* continue after the last returned property */
+	if (rc == 0) {
+	    if (out.moreData == NO) {
+		done = TRUE;
+	    }
+	    else if (TSS_Capability_NextProperty(&in.property, &out.capabilityData) != 0) {
+		printf("moreData: %u\n", out.moreData);
+		done = TRUE;
+	    }
+	    else {
+		if (verbose) printf("getcapability: next property %08x\n", in.property);
+	    }
+	}
     }
     {
 	TPM_RC rc1 = TSS_Delete(tssContext);
@@ -219,12 +239,6 @@ int main(int argc, char *argv[])
 	    rc = rc1;
 	}
     }
-    if (rc == 0) {
-	if (out.moreData > 0) {
-	    printf("moreData: %u\n", out.moreData);
-	}
-	rc = printResponse(&out.capabilityData, property);
-    }
     if (rc == 0) {
 	if (verbose) printf("getcapability: success\n");
     }
@@ -569,9 +583,11 @@ static void printUsage(TPM_CAP capability)
     printf("\n");
     printf("Runs TPM2_GetCapability\n");
     printf("\n");
+    printf("Repeats the command while the TPM returns moreData\n");
+    printf("\n");
     printf("\t-cap capability\n");
     printf("\t-pr property (defaults to 0)\n");
-    printf("\t-pc propertyCount (defaults to 64)\n");
+    printf("\t-pc propertyCount per command (defaults to 64)\n");
     printf("\n");
     printf("\t-se[0-2] session handle / attributes (default PWAP)\n");
     printf("\t\t01 continue\n");
@@ -74,6 +74,8 @@ int main(int argc, char *argv[])
     const char			*qualifyingDataFilename = NULL;
     TPMS_ATTEST 		tpmsAttest;
     const char			*sessionDigestFilename = NULL;
+    int				compareDigest = FALSE;
+    TPM2B_DIGEST		expectedDigest;
     TPMI_SH_AUTH_SESSION    	sessionHandle0 = TPM_RS_PW;
     unsigned int		sessionAttributes0 = 0;
     TPMI_SH_AUTH_SESSION    	sessionHandle1 = TPM_RS_PW;
@@ -178,6 +180,9 @@ int main(int argc, char *argv[])
 		printUsage();
 	    }
 	}
+	else if (strcmp(argv[i],"-cd") == 0) {
+	    compareDigest = TRUE;
+	}
 	else if (strcmp(argv[i],"-qd") == 0) {
 	    i++;
 	    if (i < argc) {
@@ -301,6 +306,10 @@ int main(int argc, char *argv[])
     if (rc == 0) {
 	rc = TSS_Create(&tssContext);
     }
+    /* the session digest that the TSS tracked, before this command */
+    if ((rc == 0) && compareDigest) {
+	rc = TSS_GetSessionAuditDigest(tssContext, &expectedDigest, sessionHandle);
+    }
     /* call TSS to execute the command */
     if (rc == 0) {
 	rc = TSS_Execute(tssContext,
@@ -333,6 +342,18 @@ int main(int argc, char *argv[])
 	    rc = EXIT_FAILURE;
 	}
     }
+    if ((rc == 0) && compareDigest) {
+	int match;
+	match = TSS_TPM2B_Compare(&expectedDigest.b,
+				  &tpmsAttest.attested.sessionAudit.sessionDigest.b);
+	if (!match) {
+	    printf("getsessionauditdigest: failed, sessionDigest != TSS audit digest\n");
+	    rc = TSS_RC_AUDIT_DIGEST;
+	}
+	else {
+	    if (verbose) printf("getsessionauditdigest: sessionDigest matches the TSS\n");
+	}
+    }
     if ((rc == 0) && (signatureFilename != NULL)) {
 	rc = TSS_File_WriteStructure(&out.signature,
 				     (MarshalFunction_t)TSS_TPMT_SIGNATURE_Marshal,
@@ -389,6 +410,7 @@ static void printUsage(void)
     printf("\t[-os signature file name (default do not save)]\n");
     printf("\t[-oa attestation output file name (default do not save)]\n");
     printf("\t[-od session digest file name (default do not save)]\n");
+    printf("\t[-cd compare the session digest to the digest tracked by the TSS]\n");
     printf("\n");
     printf("\t-se[0-2] session handle / attributes (default PWAP)\n");
     printf("\t\t01 continue\n");
@@ -50,6 +50,10 @@
 #include <tss2/tssutils.h>
 #include <tss2/tssresponsecode.h>
 #include <tss2/tssmarshal.h>
+#include <tss2/tsscryptoh.h>
+#include <tss2/tssstream.h>
+
+#include "cryptoutils.h"
 
 static void printUsage(void);
 static void printHash(Hash_Out *out);
@@ -70,6 +74,13 @@ int main(int argc, char *argv[])
     const char 			*inString = NULL;
     const char			*hashFilename = NULL;
     const char			*ticketFilename = NULL;
+    int				stream = FALSE;
+    int				useTpm = FALSE;
+    FILE			*inFile = NULL;
+    TPMT_HA			digest;
+    uint64_t			streamed = 0;
+    double			startTime = 0;
+    double			elapsed = 0;
  
     size_t 			length = 0;
     uint8_t			*buffer = NULL;	/* for the free */
@@ -111,6 +122,12 @@ int main(int argc, char *argv[])
 		printUsage();
 	    }
 	}
+	else if (strcmp(argv[i],"-stream") == 0) {
+	    stream = TRUE;
+	}
+	else if (strcmp(argv[i],"-tpm") == 0) {
+	    useTpm = TRUE;
+	}
 	else if (strcmp(argv[i],"-ic") == 0) {
 	    i++;
 	    if (i < argc) {
@@ -171,6 +188,10 @@ int main(int argc, char *argv[])
 	printf("Input file -if and input string -ic cannot both be specified\n");
 	printUsage();
     }
+    if (stream && (inFilename == NULL)) {
+	printf("-stream requires input file -if\n");
+	printUsage();
+    }
     /* Table 50 - TPMI_RH_HIERARCHY primaryHandle */
     if (rc == 0) {
 	if (hierarchyChar == 'e') {
@@ -191,7 +212,12 @@ int main(int argc, char *argv[])
 	}
  	in.hierarchy = hierarchy;
     }
-    if (inFilename != NULL) {
+    if ((inFilename != NULL) && stream) {
+	if (rc == 0) {
+	    rc = TSS_File_Open(&inFile, inFilename, "rb");	/* closed @1 */
+	}
+    }
+    if ((inFilename != NULL) && !stream) {
 	if (rc == 0) {
 	    rc = TSS_File_ReadBinaryFile(&buffer,     /* must be freed by caller */
 					 &length,
@@ -231,7 +257,7 @@ int main(int argc, char *argv[])
 	rc = TSS_Create(&tssContext);
     }
     /* call TSS to execute the command */
-    if (rc == 0) {
+    if ((rc == 0) && !stream) {
 	rc = TSS_Execute(tssContext,
 			 (RESPONSE_PARAMETERS *)&out, 
 			 (COMMAND_PARAMETERS *)&in,
@@ -239,6 +265,31 @@ int main(int argc, char *argv[])
 			 TPM_CC_Hash,
 			 TPM_RH_NULL, NULL, 0);
     }
+    /* stream the file through a hash sequence.  If a ticket is not needed, the library hashes in
+       software unless -tpm was specified */
+    if ((rc == 0) && stream) {
+	digest.hashAlg = halg;
+	out.validation.tag = TPM_ST_HASHCHECK;
+	out.validation.hierarchy = TPM_RH_NULL;
+	out.validation.digest.t.size = 0;
+	startTime = getSeconds();
+	rc = TSS_Hash_Stream(tssContext,
+			     &digest,
+			     ((ticketFilename != NULL) || useTpm) ? &out.validation : NULL,
+			     hierarchy,
+			     TSS_Stream_ReadFile, inFile,
+			     &streamed);
+	elapsed = getSeconds() - startTime;
+    }
+    if ((rc == 0) && stream) {
+	out.outHash.t.size = TSS_GetDigestSize(halg);
+	memcpy(out.outHash.t.buffer, (uint8_t *)&digest.digest, out.outHash.t.size);
+	printf("hash: %llu bytes in %.3f sec", (unsigned long long)streamed, elapsed);
+	if (elapsed > 0) {
+	    printf(", %.3f MB/s", (streamed / (1024.0 * 1024.0)) / elapsed);
+	}
+	printf("\n");
+    }
     {
 	TPM_RC rc1 = TSS_Delete(tssContext);
 	if (rc == 0) {
@@ -256,6 +307,9 @@ int main(int argc, char *argv[])
 				     ticketFilename);
     }
     free(buffer);
+    if (inFile != NULL) {
+	fclose(inFile);		/* @1 */
+    }
     if (rc == 0) {
 	if (verbose) printHash(&out);
 	if (verbose) printf("hash: success\n");
@@ -289,6 +343,9 @@ static void printUsage(void)
     printf("\t[-halg (sha1, sha256, sha384) (default sha256)]\n");
     printf("\t-if input file to be hashed\n");
     printf("\t-ic data string to be hashed\n");
+    printf("\t[-stream stream the -if file through a hash sequence, no size limit]\n");
+    printf("\t\tReports the hash rate.  Hashes in software unless a ticket is requested\n");
+    printf("\t[-tpm with -stream, use the TPM even if no ticket is requested]\n");
     printf("\t[-oh hash file name (default do not save)]\n");
     printf("\t[-tk ticket file name (default do not save)]\n");
     exit(1);	
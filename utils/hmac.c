@@ -49,6 +49,10 @@
 #include <tss2/tss.h>
 #include <tss2/tssutils.h>
 #include <tss2/tssresponsecode.h>
+#include <tss2/tsscryptoh.h>
+#include <tss2/tssstream.h>
+
+#include "cryptoutils.h"
 
 static void printUsage(void);
 static void printHmac(HMAC_Out *out);
@@ -74,6 +78,12 @@ int main(int argc, char *argv[])
     unsigned int		sessionAttributes1 = 0;
     TPMI_SH_AUTH_SESSION    	sessionHandle2 = TPM_RH_NULL;
     unsigned int		sessionAttributes2 = 0;
+    int				stream = FALSE;
+    FILE			*inFile = NULL;
+    TPMT_HA			digest;
+    uint64_t			streamed = 0;
+    double			startTime = 0;
+    double			elapsed = 0;
 
     size_t 			length = 0;
     uint8_t			*buffer = NULL;	/* for the free */
@@ -124,6 +134,9 @@ int main(int argc, char *argv[])
 		printUsage();
 	    }
 	}
+	else if (strcmp(argv[i],"-stream") == 0) {
+	    stream = TRUE;
+	}
 	else if (strcmp(argv[i],"-ic") == 0) {
 	    i++;
 	    if (i < argc) {
@@ -244,7 +257,16 @@ int main(int argc, char *argv[])
 	printf("Input file -if and input string -ic cannot both be specified\n");
 	printUsage();
     }
-    if (inFilename != NULL) {
+    if (stream && (inFilename == NULL)) {
+	printf("-stream requires input file -if\n");
+	printUsage();
+    }
+    if ((inFilename != NULL) && stream) {
+	if (rc == 0) {
+	    rc = TSS_File_Open(&inFile, inFilename, "rb");	/* closed @1 */
+	}
+    }
+    if ((inFilename != NULL) && !stream) {
 	if (rc == 0) {
 	    rc = TSS_File_ReadBinaryFile(&buffer,     /* must be freed by caller */
 					 &length,
@@ -287,7 +309,7 @@ int main(int argc, char *argv[])
 	rc = TSS_Create(&tssContext);
     }
     /* call TSS to execute the command */
-    if (rc == 0) {
+    if ((rc == 0) && !stream) {
 	rc = TSS_Execute(tssContext,
 			 (RESPONSE_PARAMETERS *)&out,
 			 (COMMAND_PARAMETERS *)&in,
@@ -298,6 +320,29 @@ int main(int argc, char *argv[])
 			 sessionHandle2, NULL, sessionAttributes2,
 			 TPM_RH_NULL, NULL, 0);
     }
+    /* stream the file through an HMAC sequence.  The key authorization is only used to start the
+       sequence. */
+    if ((rc == 0) && stream) {
+	digest.hashAlg = halg;
+	startTime = getSeconds();
+	rc = TSS_HMAC_Stream(tssContext,
+			     &digest,
+			     keyHandle,
+			     keyPassword,
+			     sessionHandle0, sessionAttributes0,
+			     TSS_Stream_ReadFile, inFile,
+			     &streamed);
+	elapsed = getSeconds() - startTime;
+    }
+    if ((rc == 0) && stream) {
+	out.outHMAC.t.size = TSS_GetDigestSize(halg);
+	memcpy(out.outHMAC.t.buffer, (uint8_t *)&digest.digest, out.outHMAC.t.size);
+	printf("hmac: %llu bytes in %.3f sec", (unsigned long long)streamed, elapsed);
+	if (elapsed > 0) {
+	    printf(", %.3f MB/s", (streamed / (1024.0 * 1024.0)) / elapsed);
+	}
+	printf("\n");
+    }
     {
 	TPM_RC rc1 = TSS_Delete(tssContext);
 	if (rc == 0) {
@@ -310,6 +355,9 @@ int main(int argc, char *argv[])
 				      hmacFilename); 
     }    
     free(buffer);
+    if (inFile != NULL) {
+	fclose(inFile);		/* @1 */
+    }
     if (rc == 0) {
 	if (verbose) printHmac(&out);
 	if (verbose) printf("hmac: success\n");
@@ -343,6 +391,8 @@ static void printUsage(void)
     printf("\t[-halg (sha1, sha256, sha384) (default sha256)]\n");
     printf("\t-if input file to be HMACed\n");
     printf("\t-ic data string to be HMACed\n");
+    printf("\t[-stream stream the -if file through an HMAC sequence, no size limit]\n");
+    printf("\t\tReports the HMAC rate.  Only session 0 is used\n");
     printf("\t[-os hmac file name (default do not save)]\n");
     printf("\n");
     printf("\t-se[0-2] session handle / attributes (default PWAP)\n");
@@ -185,11 +185,11 @@ uint32_t IMA_Event_ReadFile(ImaEvent *imaEvent,	/* freed by caller */
 	    }
 	}
     }
-    if (rc == 0) {
+    if ((rc == 0) && !*endOfFile) {
 	imaEvent->pcrIndex = IMA_Uint32_Convert((uint8_t *)&imaEvent->pcrIndex, littleEndian);
     }
     /* sanity check the PCR index */
-    if (rc == 0) {
+    if ((rc == 0) && !*endOfFile) {
 	if (imaEvent->pcrIndex != IMA_PCR) {
 	    printf("ERROR: IMA_Event_ReadFile: PCR index %u not PCR %u\n",
 		   imaEvent->pcrIndex, IMA_PCR);
@@ -197,7 +197,7 @@ uint32_t IMA_Event_ReadFile(ImaEvent *imaEvent,	/* freed by caller */
 	}
     }	
     /* read the IMA digest, this is hard coded to SHA-1 */
-    if (rc == 0) {
+    if ((rc == 0) && !*endOfFile) {
 	readSize = fread(&(imaEvent->digest),
 			 sizeof(((ImaEvent *)NULL)->digest), 1, inFile);
 	if (readSize != 1) {
@@ -212,7 +212,7 @@ uint32_t IMA_Event_ReadFile(ImaEvent *imaEvent,	/* freed by caller */
 	}
     }
     /* read the IMA name length */
-    if (rc == 0) {
+    if ((rc == 0) && !*endOfFile) {
 	readSize = fread(&(imaEvent->name_len),
 			 sizeof(((ImaEvent *)NULL)->name_len), 1, inFile);
 	if (readSize != 1) {
@@ -226,11 +226,11 @@ uint32_t IMA_Event_ReadFile(ImaEvent *imaEvent,	/* freed by caller */
 	    }
 	}
     }
-    if (rc == 0) {
+    if ((rc == 0) && !*endOfFile) {
 	imaEvent->name_len = IMA_Uint32_Convert((uint8_t *)&imaEvent->name_len, littleEndian);
     }
     /* bounds check the name length, leave a byte for the nul terminator */
-    if (rc == 0) {
+    if ((rc == 0) && !*endOfFile) {
 	if (imaEvent->name_len > (sizeof(((ImaEvent *)NULL)->name)) -1) {
 	    printf("ERROR: IMA_Event_ReadFile: template name length too big: %u\n",
 		   imaEvent->name_len);
@@ -238,7 +238,7 @@ uint32_t IMA_Event_ReadFile(ImaEvent *imaEvent,	/* freed by caller */
 	}
     }
     /* read the template name */
-    if (rc == 0) {
+    if ((rc == 0) && !*endOfFile) {
 	/* nul terminate first */
 	memset(imaEvent->name, 0, sizeof(((ImaEvent *)NULL)->name));
 	readSize = fread(&(imaEvent->name),
@@ -255,7 +255,7 @@ uint32_t IMA_Event_ReadFile(ImaEvent *imaEvent,	/* freed by caller */
 	}
     }
     /* record the template name as an int */
-    if (rc == 0) {
+    if ((rc == 0) && !*endOfFile) {
 	if (strcmp(imaEvent->name, "ima-ng") == 0) {
 		imaEvent->nameInt = IMA_NG;
 	}
@@ -268,7 +268,7 @@ uint32_t IMA_Event_ReadFile(ImaEvent *imaEvent,	/* freed by caller */
 	}
     }
     /* read the template data length */
-    if (rc == 0) {
+    if ((rc == 0) && !*endOfFile) {
 	readSize = fread(&(imaEvent->template_data_len),
 			 sizeof(((ImaEvent *)NULL)->template_data_len ), 1, inFile);
 	if (readSize != 1) {
@@ -282,19 +282,19 @@ uint32_t IMA_Event_ReadFile(ImaEvent *imaEvent,	/* freed by caller */
 	    }
 	}
     }
-    if (rc == 0) {
+    if ((rc == 0) && !*endOfFile) {
 	imaEvent->template_data_len = IMA_Uint32_Convert((uint8_t *)&imaEvent->template_data_len,
 							 littleEndian);
     }
     /* bounds check the template data length */
-    if (rc == 0) {
+    if ((rc == 0) && !*endOfFile) {
 	if (imaEvent->template_data_len > TCG_TEMPLATE_DATA_LEN_MAX) {
 	    printf("ERROR: IMA_Event_ReadFile: template data length too big: %u\n",
 		   imaEvent->template_data_len);
 	    rc = ERR_STRUCTURE;
 	}
     }
-    if (rc == 0) {
+    if ((rc == 0) && !*endOfFile) {
 	imaEvent->template_data = malloc(imaEvent->template_data_len);
 	if (imaEvent->template_data == NULL) {
 	    printf("ERROR: IMA_Event_ReadFile: "
@@ -303,7 +303,7 @@ uint32_t IMA_Event_ReadFile(ImaEvent *imaEvent,	/* freed by caller */
 	    rc = ERR_STRUCTURE;
 	}
     }
-    if (rc == 0) {
+    if ((rc == 0) && !*endOfFile) {
 	readSize = fread(imaEvent->template_data,
 			 imaEvent->template_data_len, 1, inFile);
 	if (readSize != 1) {
@@ -910,17 +910,17 @@ static uint32_t IMA_Uint32_Convert(const uint8_t *stream,
 
     /* little endian input */
     if (littleEndian) {
-	out = (stream[0] <<  0) |
-	      (stream[1] <<  8) |
-	      (stream[2] << 16) |
-	      (stream[3] << 24);
+	out = ((uint32_t)stream[0] <<  0) |
+	      ((uint32_t)stream[1] <<  8) |
+	      ((uint32_t)stream[2] << 16) |
+	      ((uint32_t)stream[3] << 24);
     }
     /* big endian input */
     else {
-	out = (stream[0] << 24) |
-	      (stream[1] << 16) |
-	      (stream[2] <<  8) |
-	      (stream[3] <<  0);
+	out = ((uint32_t)stream[0] << 24) |
+	      ((uint32_t)stream[1] << 16) |
+	      ((uint32_t)stream[2] <<  8) |
+	      ((uint32_t)stream[3] <<  0);
     }
     return out;
 }
@@ -129,6 +129,18 @@ tsscrypto.o: 	$(TSS_HEADERS) tsscrypto.c
 		$(CC) $(CCFLAGS) $(CCLFLAGS) tsscrypto.c
 tssutils.o: 	$(TSS_HEADERS) tssutils.c
 		$(CC) $(CCFLAGS) $(CCLFLAGS) tssutils.c
+tssreplay.o: 	$(TSS_HEADERS) tssreplay.c
+		$(CC) $(CCFLAGS) $(CCLFLAGS) tssreplay.c
+tssscheduler.o: 	$(TSS_HEADERS) tssscheduler.c
+		$(CC) $(CCFLAGS) $(CCLFLAGS) tssscheduler.c
+tsspolicy.o: 	$(TSS_HEADERS) tsspolicy.c
+		$(CC) $(CCFLAGS) $(CCLFLAGS) tsspolicy.c
+tssprimary.o: 	$(TSS_HEADERS) tssprimary.c
+		$(CC) $(CCFLAGS) $(CCLFLAGS) tssprimary.c
+tsscapability.o: 	$(TSS_HEADERS) tsscapability.c
+		$(CC) $(CCFLAGS) $(CCLFLAGS) tsscapability.c
+tssstream.o: 	$(TSS_HEADERS) tssstream.c
+		$(CC) $(CCFLAGS) $(CCLFLAGS) tssstream.c
 tssfile.o: 	$(TSS_HEADERS) tssfile.c
 		$(CC) $(CCFLAGS) $(CCLFLAGS) tssfile.c
 tsssocket.o: 	$(TSS_HEADERS) tsssocket.c
@@ -182,9 +194,18 @@ createprimary.exe:	createprimary.o objecttemplates.o cryptoutils.o $(LIBTSS)
 eventextend.exe:	eventextend.o eventlib.o $(LIBTSS) 
 		$(CC) $(LNFLAGS) -L. -ltss $< -o $@ applink.o eventlib.o $(LNLIBS) $(LIBTSS) 
 
+eventreplay.exe:	eventreplay.o eventlib.o $(LIBTSS) 
+		$(CC) $(LNFLAGS) -L. -ltss $< -o $@ applink.o eventlib.o $(LNLIBS) $(LIBTSS) 
+
 imaextend.exe:	imaextend.o imalib.o $(LIBTSS) 
 		$(CC) $(LNFLAGS) -L. -ltss $< -o $@ applink.o imalib.o $(LNLIBS) $(LIBTSS) 
 
+refdb.exe:	refdb.o refdblib.o imalib.o $(LIBTSS) 
+		$(CC) $(LNFLAGS) -L. -ltss $< -o $@ applink.o refdblib.o imalib.o $(LNLIBS) $(LIBTSS) 
+
+checkquote.exe:	checkquote.o quoteverify.o cryptoutils.o eventlib.o $(LIBTSS) 
+		$(CC) $(LNFLAGS) -L. -ltss $< -o $@ applink.o quoteverify.o cryptoutils.o eventlib.o $(LNLIBS) $(LIBTSS) 
+
 createek.exe:	createek.o ekutils.o cryptoutils.o $(LIBTSS) 
 		$(CC) $(LNFLAGS) -L. -ltss $< -o $@ applink.o ekutils.o cryptoutils.o $(LNLIBS) $(LIBTSS)
 
@@ -194,6 +215,12 @@ importpem.exe:	importpem.o objecttemplates.o ekutils.o cryptoutils.o $(LIBTSS)
 loadexternal.exe:	loadexternal.o cryptoutils.o ekutils.o $(LIBTSS)
 		$(CC) $(LNFLAGS) -L. -ltss $< -o $@ applink.o cryptoutils.o ekutils.o $(LNLIBS) $(LIBTSS)
 
+hash.exe:	hash.o cryptoutils.o $(LIBTSS)
+		$(CC) $(LNFLAGS) -L. -ltss $< -o $@ applink.o cryptoutils.o $(LNLIBS) $(LIBTSS)
+
+hmac.exe:	hmac.o cryptoutils.o $(LIBTSS)
+		$(CC) $(LNFLAGS) -L. -ltss $< -o $@ applink.o cryptoutils.o $(LNLIBS) $(LIBTSS)
+
 nvread.exe:	nvread.o ekutils.o cryptoutils.o $(LIBTSS) 
 		$(CC) $(LNFLAGS) -L. -ltss $< -o $@ applink.o ekutils.o cryptoutils.o $(LNLIBS) $(LIBTSS)
 
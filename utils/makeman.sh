@@ -48,6 +48,9 @@ help2man -h-h  --version-string="v1045" -n "Runs TPM2_Import with PEM input" /us
 help2man -h-h  --version-string="v1045" -n "Runs TPM2_Load" /usr/bin/tssload > man/man1/tssload.1
 help2man -h-h  --version-string="v1045" -n "Runs TPM2_LoadExternal" /usr/bin/tssloadexternal > man/man1/tssloadexternal.1
 help2man -h-h  --version-string="v1045" -n "Runs TPM2_MakeCredential" /usr/bin/tssmakecredential > man/man1/tssmakecredential.1
+help2man -h-h  --version-string="v1045" -n "Times TSS structure marshaling" /usr/bin/tssmarshalbench > man/man1/tssmarshalbench.1
+help2man -h-h  --version-string="v1045" -n "Times TSS command and response parsing" /usr/bin/tssparsebench > man/man1/tssparsebench.1
+help2man -h-h  --version-string="v1045" -n "Runs TSS parser fuzz targets" /usr/bin/tssfuzzparse > man/man1/tssfuzzparse.1
 help2man -h-h  --version-string="v1045" -n "Runs TPM2_Ntc2GetConfig" /usr/bin/tssntc2getconfig > man/man1/tssntc2getconfig.1
 help2man -h-h  --version-string="v1045" -n "Runs TPM2_Ntc2LockConfig" /usr/bin/tssntc2lockconfig > man/man1/tssntc2lockconfig.1
 help2man -h-h  --version-string="v1045" -n "Runs TPM2_Ntc2Preconfig" /usr/bin/tssntc2preconfig > man/man1/tssntc2preconfig.1
@@ -78,6 +81,7 @@ help2man -h-h  --version-string="v1045" -n "Runs TPM2_PolicyCommandCode" /usr/bi
 help2man -h-h  --version-string="v1045" -n "Runs TPM2_PolicyCounterTimer" /usr/bin/tsspolicycountertimer > man/man1/tsspolicycountertimer.1
 help2man -h-h  --version-string="v1045" -n "Runs TPM2_PolicyCpHash" /usr/bin/tsspolicycphash > man/man1/tsspolicycphash.1
 help2man -h-h  --version-string="v1045" -n "Runs TPM2_PolicyGetDigest" /usr/bin/tsspolicygetdigest > man/man1/tsspolicygetdigest.1
+help2man -h-h  --version-string="v1045" -n "Runs TPM2_PolicyLocality" /usr/bin/tsspolicylocality > man/man1/tsspolicylocality.1
 help2man -h-h  --version-string="v1045" -n "Runs policymaker utility" /usr/bin/tsspolicymaker > man/man1/tsspolicymaker.1
 help2man -h-h  --version-string="v1045" -n "Runs policymakerpcr utility" /usr/bin/tsspolicymakerpcr > man/man1/tsspolicymakerpcr.1
 help2man -h-h  --version-string="v1045" -n "Runs TPM2_PolicyNv" /usr/bin/tsspolicynv > man/man1/tsspolicynv.1
@@ -108,6 +112,7 @@ help2man -h-h  --version-string="v1045" -n "Runs TPM2_StartAuthSession" /usr/bin
 help2man -h-h  --version-string="v1045" -n "Runs TPM2_Startup" /usr/bin/tssstartup > man/man1/tssstartup.1
 help2man -h-h  --version-string="v1045" -n "Runs TPM2_StirRandom" /usr/bin/tssstirrandom > man/man1/tssstirrandom.1
 help2man -h-h  --version-string="v1045" -n "Runs timepacket profiler" /usr/bin/tsstimepacket > man/man1/tsstimepacket.1
+help2man -h-h  --version-string="v1045" -n "Runs TSS context regression tests" /usr/bin/tssregcontext > man/man1/tssregcontext.1
 help2man -h-h  --version-string="v1045" -n "Runs TPM2_Unseal" /usr/bin/tssunseal > man/man1/tssunseal.1
 help2man -h-h  --version-string="v1045" -n "Runs TPM2_VerifySignature" /usr/bin/tssverifysignature > man/man1/tssverifysignature.1
 help2man -h-h  --version-string="v1045" -n "Runs writeapp demo" /usr/bin/tsswriteapp > man/man1/tsswriteapp.1
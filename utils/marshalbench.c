@@ -0,0 +1,643 @@
+/********************************************************************************/
+/*										*/
+/*			      Marshal Benchmark					*/
+/*		       IBM Thomas J. Watson Research Center			*/
+/*			    $Id: marshalbench.c $				*/
+/*										*/
+/* (c) Copyright IBM Corporation 2017.						*/
+/*										*/
+/* All rights reserved.								*/
+/* 										*/
+/* Redistribution and use in source and binary forms, with or without		*/
+/* modification, are permitted provided that the following conditions are	*/
+/* met:										*/
+/* 										*/
+/* Redistributions of source code must retain the above copyright notice,	*/
+/* this list of conditions and the following disclaimer.			*/
+/* 										*/
+/* Redistributions in binary form must reproduce the above copyright		*/
+/* notice, this list of conditions and the following disclaimer in the		*/
+/* documentation and/or other materials provided with the distribution.		*/
+/* 										*/
+/* Neither the names of the IBM Corporation nor the names of its		*/
+/* contributors may be used to endorse or promote products derived from		*/
+/* this software without specific prior written permission.			*/
+/* 										*/
+/* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS		*/
+/* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT		*/
+/* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR	*/
+/* A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT		*/
+/* HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,	*/
+/* SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT		*/
+/* LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,	*/
+/* DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY	*/
+/* THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT		*/
+/* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE	*/
+/* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.		*/
+/********************************************************************************/
+
+
+/* marshalbench measures the structures per second marshaled by the TSS structure marshal
+   functions.  It needs no TPM.
+
+   Each structure is marshaled three ways:
+
+   twopass	marshal to count the bytes, allocate, marshal again (the original
+		TSS_Structure_Marshal() algorithm)
+   alloc	TSS_Structure_Marshal(), one marshal pass and an exact allocation
+   reuse	TSS_Structure_MarshalBuffer(), one marshal pass into a reused buffer
+
+   The session context is the TPMS_CONTEXT from TPM2_ContextSave of a session.
+
+   The hot types are then marshaled and unmarshaled by the TSS functions and by the table driven
+   engine, TSS_Table_Marshal() and TSS_Table_Unmarshal().  Before timing, a differential check
+   verifies that both produce the same stream, and that both unmarshals return the same result for
+   every truncation and single byte corruption of the stream.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+
+#include <tss2/tss.h>
+#include <tss2/tssutils.h>
+#include <tss2/tssmarshal.h>
+#include "marshaltable.h"
+#include <tss2/Unmarshal_fp.h>
+#include <tss2/tssresponsecode.h>
+
+/* a hot type, marshaled and unmarshaled by the functions and by the table */
+
+typedef struct {
+    const char			*name;
+    const void			*structure;
+    size_t			structureSize;
+    MarshalFunction_t		marshalFunction;
+    UnmarshalFunction_t		unmarshalFunction;	/* NULL for command only types */
+    const TSS_MARSHAL_TYPE	*type;
+} TABLE_BENCH;
+
+static TPM_RC benchStructure(const char *structureName,
+			     void *structure,
+			     MarshalFunction_t marshalFunction,
+			     unsigned int loops);
+static TPM_RC marshalTwoPass(uint8_t **buffer,
+			     uint16_t *written,
+			     void *structure,
+			     MarshalFunction_t marshalFunction);
+static TPM_RC benchTable(const TABLE_BENCH *tableBench,
+			 unsigned int loops);
+static TPM_RC checkTable(const TABLE_BENCH *tableBench,
+			 uint8_t *stream,
+			 uint16_t streamSize);
+static TPM_RC unmarshalCompare(const TABLE_BENCH *tableBench,
+			       uint8_t *stream,
+			       uint16_t streamSize);
+static TPM_RC TPMT_HA_Unmarshal_NoNull(TPMT_HA *target, BYTE **buffer, INT32 *size);
+static TPM_RC TPML_DIGEST_Unmarshal_Any(TPML_DIGEST *target, BYTE **buffer, INT32 *size);
+static void printRate(const char *structureName,
+		      const char *method,
+		      unsigned int loops,
+		      clock_t start);
+static void printUsage(void);
+
+int verbose = FALSE;
+
+int main(int argc, char *argv[])
+{
+    TPM_RC			rc = 0;
+    int				i;    /* argc iterator */
+    unsigned int		loops = 1000000;
+    TPM2B_PUBLIC		publicArea;
+    TPM2B_PRIVATE		privateArea;
+    TPMS_CONTEXT		context;
+    TPMT_HA			digest;
+    TPML_PCR_SELECTION		pcrSelection;
+    TPML_DIGEST			digestList;
+    TPML_DIGEST_VALUES		digestValues;
+    TPMS_AUTH_COMMAND		authCommand;
+    TPMS_AUTH_RESPONSE		authResponse;
+    TPM2B_MAX_NV_BUFFER		nvBuffer;
+    size_t			t;
+
+    setvbuf(stdout, 0, _IONBF, 0);      /* output may be going through pipe to log file */
+    TSS_SetProperty(NULL, TPM_TRACE_LEVEL, "1");
+
+    /* command line argument defaults */
+    for (i=1 ; (i<argc) && (rc == 0) ; i++) {
+	if (strcmp(argv[i],"-l") == 0) {
+	    i++;
+	    if (i < argc) {
+		loops = atoi(argv[i]);
+	    }
+	    else {
+		printf("-l option needs a value\n");
+		printUsage();
+	    }
+	}
+	else if (strcmp(argv[i],"-h") == 0) {
+	    printUsage();
+	}
+	else if (strcmp(argv[i],"-v") == 0) {
+	    verbose = TRUE;
+	    TSS_SetProperty(NULL, TPM_TRACE_LEVEL, "2");
+	}
+	else {
+	    printf("\n%s is not a valid option\n", argv[i]);
+	    printUsage();
+	}
+    }
+    if (loops == 0) {
+	printf("Illegal parameter -l\n");
+	printUsage();
+    }
+    /* an RSA 2048 storage key public area */
+    if (rc == 0) {
+	memset(&publicArea, 0, sizeof(publicArea));
+	publicArea.publicArea.type = TPM_ALG_RSA;
+	publicArea.publicArea.nameAlg = TPM_ALG_SHA256;
+	publicArea.publicArea.objectAttributes.val = TPMA_OBJECT_FIXEDTPM | TPMA_OBJECT_FIXEDPARENT |
+						     TPMA_OBJECT_SENSITIVEDATAORIGIN |
+						     TPMA_OBJECT_USERWITHAUTH |
+						     TPMA_OBJECT_RESTRICTED | TPMA_OBJECT_DECRYPT;
+	publicArea.publicArea.authPolicy.t.size = 0;
+	publicArea.publicArea.parameters.rsaDetail.symmetric.algorithm = TPM_ALG_AES;
+	publicArea.publicArea.parameters.rsaDetail.symmetric.keyBits.aes = 128;
+	publicArea.publicArea.parameters.rsaDetail.symmetric.mode.aes = TPM_ALG_CFB;
+	publicArea.publicArea.parameters.rsaDetail.scheme.scheme = TPM_ALG_NULL;
+	publicArea.publicArea.parameters.rsaDetail.keyBits = 2048;
+	publicArea.publicArea.parameters.rsaDetail.exponent = 0;
+	publicArea.publicArea.unique.rsa.t.size = 256;
+	memset(publicArea.publicArea.unique.rsa.t.buffer, 0xa5, 256);
+    }
+    /* a typical private area, integrity, IV, and encrypted sensitive */
+    if (rc == 0) {
+	privateArea.t.size = 222;
+	memset(privateArea.t.buffer, 0x5a, privateArea.t.size);
+    }
+    /* a session context */
+    if (rc == 0) {
+	context.sequence = 0x123;
+	context.savedHandle = HMAC_SESSION_FIRST;
+	context.hierarchy = TPM_RH_NULL;
+	context.contextBlob.t.size = 316;
+	memset(context.contextBlob.t.buffer, 0x3c, context.contextBlob.t.size);
+    }
+    if (rc == 0) {
+	printf("Loops %u\n", loops);
+	rc = benchStructure("TPM2B_PUBLIC", &publicArea,
+			    (MarshalFunction_t)TSS_TPM2B_PUBLIC_Marshal, loops);
+    }
+    if (rc == 0) {
+	rc = benchStructure("TPM2B_PRIVATE", &privateArea,
+			    (MarshalFunction_t)TSS_TPM2B_PRIVATE_Marshal, loops);
+    }
+    if (rc == 0) {
+	rc = benchStructure("TPMS_CONTEXT", &context,
+			    (MarshalFunction_t)TSS_TPMS_CONTEXT_Marshal, loops);
+    }
+    /* the hot types for the table driven engine */
+    if (rc == 0) {
+	memset(&digest, 0, sizeof(digest));
+	digest.hashAlg = TPM_ALG_SHA256;
+	memset((uint8_t *)&digest.digest, 0x11, SHA256_DIGEST_SIZE);
+
+	memset(&pcrSelection, 0, sizeof(pcrSelection));
+	pcrSelection.count = 2;
+	pcrSelection.pcrSelections[0].hash = TPM_ALG_SHA1;
+	pcrSelection.pcrSelections[0].sizeofSelect = 3;
+	pcrSelection.pcrSelections[0].pcrSelect[0] = 0xff;
+	pcrSelection.pcrSelections[1].hash = TPM_ALG_SHA256;
+	pcrSelection.pcrSelections[1].sizeofSelect = 3;
+	pcrSelection.pcrSelections[1].pcrSelect[1] = 0x80;
+
+	memset(&digestList, 0, sizeof(digestList));
+	digestList.count = 3;
+	for (t = 0 ; t < digestList.count ; t++) {
+	    digestList.digests[t].t.size = SHA256_DIGEST_SIZE;
+	    memset(digestList.digests[t].t.buffer, 0x20 + (int)t, SHA256_DIGEST_SIZE);
+	}
+	memset(&digestValues, 0, sizeof(digestValues));
+	digestValues.count = 2;
+	digestValues.digests[0].hashAlg = TPM_ALG_SHA1;
+	memset((uint8_t *)&digestValues.digests[0].digest, 0x31, SHA1_DIGEST_SIZE);
+	digestValues.digests[1].hashAlg = TPM_ALG_SHA256;
+	memset((uint8_t *)&digestValues.digests[1].digest, 0x32, SHA256_DIGEST_SIZE);
+
+	memset(&authCommand, 0, sizeof(authCommand));
+	authCommand.sessionHandle = HMAC_SESSION_FIRST;
+	authCommand.nonce.t.size = SHA256_DIGEST_SIZE;
+	memset(authCommand.nonce.t.buffer, 0x41, SHA256_DIGEST_SIZE);
+	authCommand.sessionAttributes.val = TPMA_SESSION_CONTINUESESSION;
+	authCommand.hmac.t.size = SHA256_DIGEST_SIZE;
+	memset(authCommand.hmac.t.buffer, 0x42, SHA256_DIGEST_SIZE);
+
+	memset(&authResponse, 0, sizeof(authResponse));
+	authResponse.nonce = authCommand.nonce;
+	authResponse.sessionAttributes = authCommand.sessionAttributes;
+	authResponse.hmac = authCommand.hmac;
+
+	nvBuffer.t.size = 512;
+	memset(nvBuffer.t.buffer, 0x5a, nvBuffer.t.size);
+    }
+    if (rc == 0) {
+	const TABLE_BENCH tableBench[] = {
+	    {"TPMT_HA", &digest, sizeof(digest),
+	     (MarshalFunction_t)TSS_TPMT_HA_Marshal,
+	     (UnmarshalFunction_t)TPMT_HA_Unmarshal_NoNull,
+	     &TSS_TYPE_TPMT_HA},
+	    {"TPML_PCR_SEL", &pcrSelection, sizeof(pcrSelection),
+	     (MarshalFunction_t)TSS_TPML_PCR_SELECTION_Marshal,
+	     (UnmarshalFunction_t)TPML_PCR_SELECTION_Unmarshal,
+	     &TSS_TYPE_TPML_PCR_SELECTION},
+	    {"TPML_DIGEST", &digestList, sizeof(digestList),
+	     (MarshalFunction_t)TSS_TPML_DIGEST_Marshal,
+	     (UnmarshalFunction_t)TPML_DIGEST_Unmarshal_Any,
+	     &TSS_TYPE_TPML_DIGEST},
+	    {"TPML_DIG_VAL", &digestValues, sizeof(digestValues),
+	     (MarshalFunction_t)TSS_TPML_DIGEST_VALUES_Marshal,
+	     (UnmarshalFunction_t)TPML_DIGEST_VALUES_Unmarshal,
+	     &TSS_TYPE_TPML_DIGEST_VALUES},
+	    {"TPMS_AUTH_CMD", &authCommand, sizeof(authCommand),
+	     (MarshalFunction_t)TSS_TPMS_AUTH_COMMAND_Marshal,
+	     NULL,
+	     &TSS_TYPE_TPMS_AUTH_COMMAND},
+	    {"TPMS_AUTH_RSP", &authResponse, sizeof(authResponse),
+	     NULL,
+	     (UnmarshalFunction_t)TPMS_AUTH_RESPONSE_Unmarshal,
+	     &TSS_TYPE_TPMS_AUTH_RESPONSE},
+	    {"TPM2B_NV_BUF", &nvBuffer, sizeof(nvBuffer),
+	     (MarshalFunction_t)TSS_TPM2B_MAX_NV_BUFFER_Marshal,
+	     (UnmarshalFunction_t)TPM2B_MAX_NV_BUFFER_Unmarshal,
+	     &TSS_TYPE_TPM2B_MAX_NV_BUFFER},
+	};
+	for (t = 0 ; (rc == 0) && (t < sizeof(tableBench) / sizeof(TABLE_BENCH)) ; t++) {
+	    rc = benchTable(&tableBench[t], loops);
+	}
+    }
+    if (rc == 0) {
+	if (verbose) printf("marshalbench: success\n");
+    }
+    else {
+	const char *msg;
+	const char *submsg;
+	const char *num;
+	printf("marshalbench: failed, rc %08x\n", rc);
+	TSS_ResponseCode_toString(&msg, &submsg, &num, rc);
+	printf("%s%s%s\n", msg, submsg, num);
+	rc = EXIT_FAILURE;
+    }
+    return rc;
+}
+
+/* benchStructure() times 'loops' marshals of the structure by each method, and checks that the
+   methods produce the same stream */
+
+static TPM_RC benchStructure(const char *structureName,
+			     void *structure,
+			     MarshalFunction_t marshalFunction,
+			     unsigned int loops)
+{
+    TPM_RC		rc = 0;
+    unsigned int	count;
+    clock_t		start;
+    uint8_t		*buffer = NULL;
+    uint16_t		written = 0;
+    uint8_t		*expect = NULL;		/* freed @1 */
+    uint16_t		expectWritten = 0;
+    TSS_MARSHAL_BUFFER	marshalBuffer;
+
+    TSS_MarshalBuffer_Init(&marshalBuffer);
+    if (rc == 0) {
+	rc = marshalTwoPass(&expect, &expectWritten, structure, marshalFunction);
+    }
+    if (rc == 0) {
+	start = clock();
+	for (count = 0 ; (rc == 0) && (count < loops) ; count++) {
+	    rc = marshalTwoPass(&buffer, &written, structure, marshalFunction);
+	    free(buffer);
+	    buffer = NULL;
+	}
+	printRate(structureName, "twopass", loops, start);
+    }
+    if (rc == 0) {
+	start = clock();
+	for (count = 0 ; (rc == 0) && (count < loops) ; count++) {
+	    rc = TSS_Structure_Marshal(&buffer, &written, structure, marshalFunction);
+	    if ((rc == 0) && (count == 0)) {
+		if ((written != expectWritten) || (memcmp(buffer, expect, written) != 0)) {
+		    printf("benchStructure: %s alloc stream mismatch\n", structureName);
+		    rc = EXIT_FAILURE;
+		}
+	    }
+	    free(buffer);
+	    buffer = NULL;
+	}
+	printRate(structureName, "alloc", loops, start);
+    }
+    if (rc == 0) {
+	start = clock();
+	for (count = 0 ; (rc == 0) && (count < loops) ; count++) {
+	    rc = TSS_Structure_MarshalBuffer(&marshalBuffer, &written, structure, marshalFunction);
+	}
+	printRate(structureName, "reuse", loops, start);
+    }
+    if (rc == 0) {
+	if ((written != expectWritten) ||
+	    (memcmp(marshalBuffer.buffer, expect, written) != 0)) {
+	    printf("benchStructure: %s reuse stream mismatch\n", structureName);
+	    rc = EXIT_FAILURE;
+	}
+    }
+    TSS_MarshalBuffer_Free(&marshalBuffer);
+    free(expect);	/* @1 */
+    return rc;
+}
+
+/* benchTable() checks and then times the functions and the table for a hot type.
+
+   TPMS_AUTH_RESPONSE has no TSS marshal function, so the table stream is the reference.
+   TPMS_AUTH_COMMAND has no unmarshal function, so only the marshal is compared.
+*/
+
+static TPM_RC benchTable(const TABLE_BENCH *tableBench,
+			 unsigned int loops)
+{
+    TPM_RC		rc = 0;
+    unsigned int	count;
+    clock_t		start;
+    uint8_t		stream[MAX_RESPONSE_SIZE];
+    uint16_t		streamSize = 0;
+    uint8_t		*buffer;
+    INT32		size;
+    uint16_t		written;
+    uint8_t		*target = NULL;		/* freed @1 */
+
+    if (rc == 0) {
+	rc = TSS_Malloc(&target, (uint32_t)tableBench->structureSize);
+    }
+    /* reference stream */
+    if (rc == 0) {
+	buffer = stream;
+	size = sizeof(stream);
+	if (tableBench->marshalFunction != NULL) {
+	    rc = tableBench->marshalFunction((void *)tableBench->structure,
+					     &streamSize, &buffer, &size);
+	}
+	else {
+	    rc = TSS_Table_Marshal(tableBench->type, tableBench->structure,
+				   &streamSize, &buffer, &size);
+	}
+    }
+    if (rc == 0) {
+	rc = checkTable(tableBench, stream, streamSize);
+    }
+    if ((rc == 0) && (tableBench->marshalFunction != NULL)) {
+	uint8_t out[MAX_RESPONSE_SIZE];
+	start = clock();
+	for (count = 0 ; (rc == 0) && (count < loops) ; count++) {
+	    buffer = out;
+	    size = sizeof(out);
+	    written = 0;
+	    rc = tableBench->marshalFunction((void *)tableBench->structure,
+					     &written, &buffer, &size);
+	}
+	printRate(tableBench->name, "marshal", loops, start);
+    }
+    if (rc == 0) {
+	uint8_t out[MAX_RESPONSE_SIZE];
+	start = clock();
+	for (count = 0 ; (rc == 0) && (count < loops) ; count++) {
+	    buffer = out;
+	    size = sizeof(out);
+	    written = 0;
+	    rc = TSS_Table_Marshal(tableBench->type, tableBench->structure,
+				   &written, &buffer, &size);
+	}
+	printRate(tableBench->name, "tbl mar", loops, start);
+    }
+    if ((rc == 0) && (tableBench->unmarshalFunction != NULL)) {
+	start = clock();
+	for (count = 0 ; (rc == 0) && (count < loops) ; count++) {
+	    buffer = stream;
+	    size = streamSize;
+	    rc = tableBench->unmarshalFunction(target, &buffer, &size);
+	}
+	printRate(tableBench->name, "unmarsh", loops, start);
+	start = clock();
+	for (count = 0 ; (rc == 0) && (count < loops) ; count++) {
+	    buffer = stream;
+	    size = streamSize;
+	    rc = TSS_Table_Unmarshal(tableBench->type, target, &buffer, &size);
+	}
+	printRate(tableBench->name, "tbl unm", loops, start);
+    }
+    free(target);	/* @1 */
+    return rc;
+}
+
+/* checkTable() is the differential check of the table against the functions.
+
+   The table marshal must produce 'stream'.  Then the unmarshal results are compared for the
+   stream, every truncation of it, and every byte of it replaced by 0x00, 0xff, and its complement.
+*/
+
+static TPM_RC checkTable(const TABLE_BENCH *tableBench,
+			 uint8_t *stream,
+			 uint16_t streamSize)
+{
+    TPM_RC	rc = 0;
+    uint8_t	out[MAX_RESPONSE_SIZE];
+    uint8_t	mutated[MAX_RESPONSE_SIZE];
+    uint8_t	*buffer = out;
+    INT32	size = sizeof(out);
+    uint16_t	written = 0;
+    uint16_t	countWritten = 0;
+    uint16_t	i;
+    size_t	m;
+
+    /* table marshal, and the table count only pass */
+    if (rc == 0) {
+	rc = TSS_Table_Marshal(tableBench->type, tableBench->structure, &written, &buffer, &size);
+    }
+    if (rc == 0) {
+	rc = TSS_Table_Marshal(tableBench->type, tableBench->structure, &countWritten, NULL, NULL);
+    }
+    if (rc == 0) {
+	if ((written != streamSize) || (countWritten != streamSize) ||
+	    (memcmp(out, stream, streamSize) != 0)) {
+	    printf("checkTable: %s table marshal stream mismatch\n", tableBench->name);
+	    rc = EXIT_FAILURE;
+	}
+    }
+    /* a short buffer fails the same way */
+    if ((rc == 0) && (streamSize > 0)) {
+	TPM_RC rc1 = 0;
+	TPM_RC rc2;
+	if (tableBench->marshalFunction != NULL) {
+	    buffer = out;
+	    size = streamSize - 1;
+	    written = 0;
+	    rc1 = tableBench->marshalFunction((void *)tableBench->structure,
+					      &written, &buffer, &size);
+	}
+	buffer = out;
+	size = streamSize - 1;
+	written = 0;
+	rc2 = TSS_Table_Marshal(tableBench->type, tableBench->structure, &written, &buffer, &size);
+	if ((rc2 == 0) || ((tableBench->marshalFunction != NULL) && (rc1 != rc2))) {
+	    printf("checkTable: %s short buffer rc %08x table rc %08x\n",
+		   tableBench->name, rc1, rc2);
+	    rc = EXIT_FAILURE;
+	}
+    }
+    if ((rc == 0) && (tableBench->unmarshalFunction != NULL)) {
+	rc = unmarshalCompare(tableBench, stream, streamSize);
+	for (i = 0 ; (rc == 0) && (i < streamSize) ; i++) {
+	    rc = unmarshalCompare(tableBench, stream, i);
+	}
+	for (i = 0 ; (rc == 0) && (i < streamSize) ; i++) {
+	    const uint8_t values[] = {0x00, 0xff, (uint8_t)~stream[i]};
+	    for (m = 0 ; (rc == 0) && (m < sizeof(values)) ; m++) {
+		memcpy(mutated, stream, streamSize);
+		mutated[i] = values[m];
+		rc = unmarshalCompare(tableBench, mutated, streamSize);
+	    }
+	}
+    }
+    if (rc == 0) {
+	if (verbose) printf("checkTable: %s matches\n", tableBench->name);
+    }
+    return rc;
+}
+
+/* unmarshalCompare() unmarshals 'stream' with the function and the table.  The return codes and
+   the bytes consumed must match.  On success, the two structures must remarshal to the same
+   stream. */
+
+static TPM_RC unmarshalCompare(const TABLE_BENCH *tableBench,
+			       uint8_t *stream,
+			       uint16_t streamSize)
+{
+    TPM_RC	rc = 0;
+    TPM_RC	rc1;
+    TPM_RC	rc2;
+    uint8_t	*target1 = NULL;	/* freed @1 */
+    uint8_t	*target2 = NULL;	/* freed @2 */
+    uint8_t	*buffer1 = stream;
+    uint8_t	*buffer2 = stream;
+    INT32	size1 = streamSize;
+    INT32	size2 = streamSize;
+
+    if (rc == 0) {
+	rc = TSS_Malloc(&target1, (uint32_t)tableBench->structureSize);
+    }
+    if (rc == 0) {
+	rc = TSS_Malloc(&target2, (uint32_t)tableBench->structureSize);
+    }
+    if (rc == 0) {
+	memset(target1, 0, tableBench->structureSize);
+	memset(target2, 0, tableBench->structureSize);
+	rc1 = tableBench->unmarshalFunction(target1, &buffer1, &size1);
+	rc2 = TSS_Table_Unmarshal(tableBench->type, target2, &buffer2, &size2);
+	if ((rc1 != rc2) || ((rc1 == 0) && (size1 != size2))) {
+	    printf("unmarshalCompare: %s size %u rc %08x remaining %d table rc %08x remaining %d\n",
+		   tableBench->name, streamSize, rc1, size1, rc2, size2);
+	    rc = EXIT_FAILURE;
+	}
+    }
+    if ((rc == 0) && (rc1 == 0)) {
+	uint8_t		out1[MAX_RESPONSE_SIZE];
+	uint8_t		out2[MAX_RESPONSE_SIZE];
+	uint8_t		*buffer;
+	INT32		size;
+	uint16_t	written1 = 0;
+	uint16_t	written2 = 0;
+
+	buffer = out1;
+	size = sizeof(out1);
+	rc = TSS_Table_Marshal(tableBench->type, target1, &written1, &buffer, &size);
+	if (rc == 0) {
+	    buffer = out2;
+	    size = sizeof(out2);
+	    rc = TSS_Table_Marshal(tableBench->type, target2, &written2, &buffer, &size);
+	}
+	if (rc == 0) {
+	    if ((written1 != written2) || (memcmp(out1, out2, written1) != 0)) {
+		printf("unmarshalCompare: %s size %u structure mismatch\n",
+		       tableBench->name, streamSize);
+		rc = EXIT_FAILURE;
+	    }
+	}
+    }
+    free(target1);	/* @1 */
+    free(target2);	/* @2 */
+    return rc;
+}
+
+/* adapters to the UnmarshalFunction_t signature */
+
+static TPM_RC TPMT_HA_Unmarshal_NoNull(TPMT_HA *target, BYTE **buffer, INT32 *size)
+{
+    return TPMT_HA_Unmarshal(target, buffer, size, NO);
+}
+
+static TPM_RC TPML_DIGEST_Unmarshal_Any(TPML_DIGEST *target, BYTE **buffer, INT32 *size)
+{
+    return TPML_DIGEST_Unmarshal(target, buffer, size, 0);
+}
+
+/* marshalTwoPass() is the original TSS_Structure_Marshal() algorithm, for comparison */
+
+static TPM_RC marshalTwoPass(uint8_t **buffer,
+			     uint16_t *written,
+			     void *structure,
+			     MarshalFunction_t marshalFunction)
+{
+    TPM_RC 	rc = 0;
+    uint8_t	*buffer1 = NULL;	/* for marshaling, moves pointer */
+
+    if (rc == 0) {
+	*written = 0;
+	rc = marshalFunction(structure, written, NULL, NULL);
+    }
+    if (rc == 0) {
+	rc = TSS_Malloc(buffer, *written);
+    }
+    if (rc == 0) {
+	buffer1 = *buffer;
+	*written = 0;
+	rc = marshalFunction(structure, written, &buffer1, NULL);
+    }
+    return rc;
+}
+
+static void printRate(const char *structureName,
+		      const char *method,
+		      unsigned int loops,
+		      clock_t start)
+{
+    double seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+    if (seconds > 0) {
+	printf("%-14s %-8s %12.0f structures/sec %8.1f ns\n", structureName, method,
+	       loops / seconds, (seconds * 1e9) / loops);
+    }
+    else {
+	printf("%-14s %-8s too fast to time, increase -l\n", structureName, method);
+    }
+    return;
+}
+
+static void printUsage(void)
+{
+    printf("\n");
+    printf("marshalbench\n");
+    printf("\n");
+    printf("Times TSS structure marshaling, no TPM is required\n");
+    printf("Checks the table driven marshal engine against the TSS functions\n");
+    printf("\n");
+    printf("\t[-l number of loops to time (default 1000000)]\n");
+    exit(1);	
+}
@@ -0,0 +1,501 @@
+/********************************************************************************/
+/*										*/
+/*		 Table Driven Structure Marshal and Unmarshal			*/
+/*		       IBM Thomas J. Watson Research Center			*/
+/*			   $Id: marshaltable.c $				*/
+/*										*/
+/* (c) Copyright IBM Corporation 2017.						*/
+/*										*/
+/* All rights reserved.								*/
+/* 										*/
+/* Redistribution and use in source and binary forms, with or without		*/
+/* modification, are permitted provided that the following conditions are	*/
+/* met:										*/
+/* 										*/
+/* Redistributions of source code must retain the above copyright notice,	*/
+/* this list of conditions and the following disclaimer.			*/
+/* 										*/
+/* Redistributions in binary form must reproduce the above copyright		*/
+/* notice, this list of conditions and the following disclaimer in the		*/
+/* documentation and/or other materials provided with the distribution.		*/
+/* 										*/
+/* Neither the names of the IBM Corporation nor the names of its		*/
+/* contributors may be used to endorse or promote products derived from		*/
+/* this software without specific prior written permission.			*/
+/* 										*/
+/* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS		*/
+/* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT		*/
+/* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR	*/
+/* A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT		*/
+/* HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,	*/
+/* SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT		*/
+/* LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,	*/
+/* DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY	*/
+/* THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT		*/
+/* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE	*/
+/* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.		*/
+/********************************************************************************/
+
+
+#include <string.h>
+
+#include <tss2/tsserror.h>
+#include "marshaltable.h"
+
+static TPM_RC TSS_Table_PutUint(UINT32 value, UINT16 length,
+				UINT16 *written, BYTE **buffer, INT32 *size);
+static TPM_RC TSS_Table_PutArray(const BYTE *source, UINT16 length,
+				 UINT16 *written, BYTE **buffer, INT32 *size);
+static TPM_RC TSS_Table_GetUint(UINT32 *value, UINT16 length,
+				BYTE **buffer, INT32 *size);
+static TPM_RC TSS_Table_GetArray(BYTE *target, UINT16 length,
+				 BYTE **buffer, INT32 *size);
+static TPM_RC TSS_Table_DigestSize(UINT16 *digestSize,
+				   TPMI_ALG_HASH hashAlg);
+
+/*
+  Descriptors
+*/
+
+static const TSS_MARSHAL_FIELD tpm2bDigestFields[] = {
+    TSS_FIELD_2B(TPM2B_DIGEST, b, sizeof(TPMU_HA))
+};
+const TSS_MARSHAL_TYPE TSS_TYPE_TPM2B_DIGEST =
+    TSS_MARSHAL_TYPE_OF("TPM2B_DIGEST", tpm2bDigestFields);
+
+static const TSS_MARSHAL_FIELD tpm2bMaxBufferFields[] = {
+    TSS_FIELD_2B(TPM2B_MAX_BUFFER, b, MAX_DIGEST_BUFFER)
+};
+const TSS_MARSHAL_TYPE TSS_TYPE_TPM2B_MAX_BUFFER =
+    TSS_MARSHAL_TYPE_OF("TPM2B_MAX_BUFFER", tpm2bMaxBufferFields);
+
+static const TSS_MARSHAL_FIELD tpm2bMaxNvBufferFields[] = {
+    TSS_FIELD_2B(TPM2B_MAX_NV_BUFFER, b, MAX_NV_BUFFER_SIZE)
+};
+const TSS_MARSHAL_TYPE TSS_TYPE_TPM2B_MAX_NV_BUFFER =
+    TSS_MARSHAL_TYPE_OF("TPM2B_MAX_NV_BUFFER", tpm2bMaxNvBufferFields);
+
+static const TSS_MARSHAL_FIELD tpmtHaFields[] = {
+    TSS_FIELD_HASH(TPMT_HA, hashAlg, NO),
+    TSS_FIELD_HA(TPMT_HA, digest, hashAlg)
+};
+const TSS_MARSHAL_TYPE TSS_TYPE_TPMT_HA =
+    TSS_MARSHAL_TYPE_OF("TPMT_HA", tpmtHaFields);
+
+/* TSS_TPMS_PCR_SELECTION_Marshal() marshals the entire pcrSelect array, while the unmarshal
+   reads sizeofSelect bytes */
+
+static const TSS_MARSHAL_FIELD tpmsPcrSelectionFields[] = {
+    TSS_FIELD_HASH(TPMS_PCR_SELECTION, hash, NO),
+    TSS_FIELD_RANGE(TPMS_PCR_SELECTION, sizeofSelect, PCR_SELECT_MIN, PCR_SELECT_MAX),
+    TSS_FIELD_ARRAY(TPMS_PCR_SELECTION, pcrSelect, sizeofSelect)
+};
+const TSS_MARSHAL_TYPE TSS_TYPE_TPMS_PCR_SELECTION =
+    TSS_MARSHAL_TYPE_OF("TPMS_PCR_SELECTION", tpmsPcrSelectionFields);
+
+static const TSS_MARSHAL_FIELD tpmlPcrSelectionFields[] = {
+    TSS_FIELD_ARRAYOF(TPML_PCR_SELECTION, count, pcrSelections, 0, HASH_COUNT,
+		      &TSS_TYPE_TPMS_PCR_SELECTION)
+};
+const TSS_MARSHAL_TYPE TSS_TYPE_TPML_PCR_SELECTION =
+    TSS_MARSHAL_TYPE_OF("TPML_PCR_SELECTION", tpmlPcrSelectionFields);
+
+static const TSS_MARSHAL_FIELD tpmlDigestFields[] = {
+    TSS_FIELD_ARRAYOF(TPML_DIGEST, count, digests, 0, 8,
+		      &TSS_TYPE_TPM2B_DIGEST)
+};
+const TSS_MARSHAL_TYPE TSS_TYPE_TPML_DIGEST =
+    TSS_MARSHAL_TYPE_OF("TPML_DIGEST", tpmlDigestFields);
+
+static const TSS_MARSHAL_FIELD tpmlDigestValuesFields[] = {
+    TSS_FIELD_ARRAYOF(TPML_DIGEST_VALUES, count, digests, 0, HASH_COUNT,
+		      &TSS_TYPE_TPMT_HA)
+};
+const TSS_MARSHAL_TYPE TSS_TYPE_TPML_DIGEST_VALUES =
+    TSS_MARSHAL_TYPE_OF("TPML_DIGEST_VALUES", tpmlDigestValuesFields);
+
+static const TSS_MARSHAL_FIELD tpmsAuthCommandFields[] = {
+    TSS_FIELD_SESSION(TPMS_AUTH_COMMAND, sessionHandle, YES),
+    TSS_FIELD_2B(TPMS_AUTH_COMMAND, nonce, sizeof(TPMU_HA)),
+    TSS_FIELD_ATTRIB(TPMS_AUTH_COMMAND, sessionAttributes, TPMA_SESSION_RESERVED),
+    TSS_FIELD_2B(TPMS_AUTH_COMMAND, hmac, sizeof(TPMU_HA))
+};
+const TSS_MARSHAL_TYPE TSS_TYPE_TPMS_AUTH_COMMAND =
+    TSS_MARSHAL_TYPE_OF("TPMS_AUTH_COMMAND", tpmsAuthCommandFields);
+
+static const TSS_MARSHAL_FIELD tpmsAuthResponseFields[] = {
+    TSS_FIELD_2B(TPMS_AUTH_RESPONSE, nonce, sizeof(TPMU_HA)),
+    TSS_FIELD_ATTRIB(TPMS_AUTH_RESPONSE, sessionAttributes, TPMA_SESSION_RESERVED),
+    TSS_FIELD_2B(TPMS_AUTH_RESPONSE, hmac, sizeof(TPMU_HA))
+};
+const TSS_MARSHAL_TYPE TSS_TYPE_TPMS_AUTH_RESPONSE =
+    TSS_MARSHAL_TYPE_OF("TPMS_AUTH_RESPONSE", tpmsAuthResponseFields);
+
+/*
+  Interpreter
+*/
+
+/* TSS_Table_Marshal() marshals 'source', described by 'type'.  The 'written', 'buffer', and 'size'
+   arguments are the same as the TSS_*_Marshal() functions, including the NULL buffer count only
+   pass and the NULL size no check pass.
+
+   Unlike the functions, a list count greater than the array returns TPM_RC_SIZE rather than
+   reading past the array.
+*/
+
+TPM_RC TSS_Table_Marshal(const TSS_MARSHAL_TYPE *type,
+			 const void *source,
+			 UINT16 *written,
+			 BYTE **buffer,
+			 INT32 *size)
+{
+    TPM_RC 			rc = 0;
+    const BYTE			*structure = (const BYTE *)source;
+    const TSS_MARSHAL_FIELD	*field;
+    const BYTE			*member;
+    size_t			i;
+    UINT32			j;
+
+    for (i = 0 ; (rc == 0) && (i < type->fieldCount) ; i++) {
+	field = &type->fields[i];
+	member = structure + field->offset;
+	switch (field->kind) {
+	  case TSS_FIELD_UINT8:
+	  case TSS_FIELD_UINT8_RANGE:
+	  case TSS_FIELD_ATTRIB8:
+	    rc = TSS_Table_PutUint(*member, sizeof(UINT8), written, buffer, size);
+	    break;
+	  case TSS_FIELD_UINT16:
+	  case TSS_FIELD_ALG_HASH:
+	    rc = TSS_Table_PutUint(*(const UINT16 *)member, sizeof(UINT16), written, buffer, size);
+	    break;
+	  case TSS_FIELD_UINT32:
+	  case TSS_FIELD_AUTH_SESSION:
+	    rc = TSS_Table_PutUint(*(const UINT32 *)member, sizeof(UINT32), written, buffer, size);
+	    break;
+	  case TSS_FIELD_TPM2B:
+	    /* inline, one size check for the size and the buffer */
+	    {
+		const TPM2B *tpm2b = (const TPM2B *)member;
+		UINT32 length = sizeof(UINT16) + tpm2b->size;
+		if (buffer != NULL) {
+		    if ((size == NULL) || ((UINT32)*size >= length)) {
+			(*buffer)[0] = (BYTE)(tpm2b->size >> 8);
+			(*buffer)[1] = (BYTE)(tpm2b->size >> 0);
+			memcpy(*buffer + sizeof(UINT16), tpm2b->buffer, tpm2b->size);
+			*buffer += length;
+			if (size != NULL) {
+			    *size -= length;
+			}
+		    }
+		    else {
+			rc = TSS_RC_INSUFFICIENT_BUFFER;
+		    }
+		}
+		*written += length;
+	    }
+	    break;
+	  case TSS_FIELD_SELECT:
+	    rc = TSS_Table_PutArray(member, field->size, written, buffer, size);
+	    break;
+	  case TSS_FIELD_DIGEST:
+	    {
+		UINT16 digestSize;
+		rc = TSS_Table_DigestSize(&digestSize,
+					  *(const TPMI_ALG_HASH *)(structure + field->aux));
+		if (rc == 0) {
+		    rc = TSS_Table_PutArray(member, digestSize, written, buffer, size);
+		}
+	    }
+	    break;
+	  case TSS_FIELD_LIST:
+	    {
+		UINT32 count = *(const UINT32 *)member;
+		if (count > field->max) {
+		    rc = TPM_RC_SIZE;
+		}
+		if (rc == 0) {
+		    rc = TSS_Table_PutUint(count, sizeof(UINT32), written, buffer, size);
+		}
+		for (j = 0 ; (rc == 0) && (j < count) ; j++) {
+		    rc = TSS_Table_Marshal(field->type,
+					   structure + field->aux + (j * field->size),
+					   written, buffer, size);
+		}
+	    }
+	    break;
+	  default:
+	    rc = TSS_RC_NOT_IMPLEMENTED;	/* corrupt descriptor */
+	}
+    }
+    return rc;
+}
+
+/* TSS_Table_Unmarshal() unmarshals 'target', described by 'type'.  The checks and return codes are
+   the same as the *_Unmarshal() function for the type. */
+
+TPM_RC TSS_Table_Unmarshal(const TSS_MARSHAL_TYPE *type,
+			   void *target,
+			   BYTE **buffer,
+			   INT32 *size)
+{
+    TPM_RC 			rc = 0;
+    BYTE			*structure = (BYTE *)target;
+    const TSS_MARSHAL_FIELD	*field;
+    BYTE			*member;
+    UINT32			value;
+    size_t			i;
+    UINT32			j;
+
+    for (i = 0 ; (rc == 0) && (i < type->fieldCount) ; i++) {
+	field = &type->fields[i];
+	member = structure + field->offset;
+	switch (field->kind) {
+	  case TSS_FIELD_UINT8:
+	  case TSS_FIELD_UINT8_RANGE:
+	  case TSS_FIELD_ATTRIB8:
+	    rc = TSS_Table_GetUint(&value, sizeof(UINT8), buffer, size);
+	    if (rc == 0) {
+		*member = (UINT8)value;
+		if ((field->kind == TSS_FIELD_UINT8_RANGE) &&
+		    ((value < field->min) || (value > field->max))) {
+		    rc = TPM_RC_VALUE;
+		}
+		else if ((field->kind == TSS_FIELD_ATTRIB8) && (value & field->max)) {
+		    rc = TPM_RC_RESERVED_BITS;
+		}
+	    }
+	    break;
+	  case TSS_FIELD_UINT16:
+	    rc = TSS_Table_GetUint(&value, sizeof(UINT16), buffer, size);
+	    if (rc == 0) {
+		*(UINT16 *)member = (UINT16)value;
+	    }
+	    break;
+	  case TSS_FIELD_ALG_HASH:
+	    rc = TSS_Table_GetUint(&value, sizeof(UINT16), buffer, size);
+	    if (rc == 0) {
+		UINT16 digestSize;
+		*(UINT16 *)member = (UINT16)value;
+		if ((value == TPM_ALG_NULL) ? !field->min :
+		    (TSS_Table_DigestSize(&digestSize, (TPMI_ALG_HASH)value) != 0)) {
+		    rc = TPM_RC_HASH;
+		}
+	    }
+	    break;
+	  case TSS_FIELD_UINT32:
+	    rc = TSS_Table_GetUint(&value, sizeof(UINT32), buffer, size);
+	    if (rc == 0) {
+		*(UINT32 *)member = value;
+	    }
+	    break;
+	  case TSS_FIELD_AUTH_SESSION:
+	    rc = TSS_Table_GetUint(&value, sizeof(UINT32), buffer, size);
+	    if (rc == 0) {
+		*(UINT32 *)member = value;
+		if (((value < HMAC_SESSION_FIRST) || (value > HMAC_SESSION_LAST)) &&
+		    ((value < POLICY_SESSION_FIRST) || (value > POLICY_SESSION_LAST)) &&
+		    ((value != TPM_RS_PW) || !field->min)) {
+		    rc = TPM_RC_VALUE;
+		}
+	    }
+	    break;
+	  case TSS_FIELD_TPM2B:
+	    {
+		TPM2B *tpm2b = (TPM2B *)member;
+		rc = TSS_Table_GetUint(&value, sizeof(UINT16), buffer, size);
+		if (rc == 0) {
+		    tpm2b->size = (UINT16)value;
+		    if (value > field->max) {
+			rc = TPM_RC_SIZE;
+		    }
+		}
+		if (rc == 0) {
+		    rc = TSS_Table_GetArray(tpm2b->buffer, tpm2b->size, buffer, size);
+		}
+	    }
+	    break;
+	  case TSS_FIELD_SELECT:
+	    {
+		UINT8 count = *(structure + field->aux);	/* unmarshaled by a previous field */
+		if (count > field->size) {
+		    rc = TPM_RC_SIZE;
+		}
+		if (rc == 0) {
+		    rc = TSS_Table_GetArray(member, count, buffer, size);
+		}
+	    }
+	    break;
+	  case TSS_FIELD_DIGEST:
+	    {
+		UINT16 digestSize;
+		rc = TSS_Table_DigestSize(&digestSize,
+					  *(const TPMI_ALG_HASH *)(structure + field->aux));
+		if (rc == 0) {
+		    rc = TSS_Table_GetArray(member, digestSize, buffer, size);
+		}
+	    }
+	    break;
+	  case TSS_FIELD_LIST:
+	    rc = TSS_Table_GetUint(&value, sizeof(UINT32), buffer, size);
+	    if (rc == 0) {
+		*(UINT32 *)member = value;
+		if ((value < field->min) || (value > field->max)) {
+		    rc = TPM_RC_SIZE;
+		}
+	    }
+	    for (j = 0 ; (rc == 0) && (j < value) ; j++) {
+		rc = TSS_Table_Unmarshal(field->type,
+					 structure + field->aux + (j * field->size),
+					 buffer, size);
+	    }
+	    break;
+	  default:
+	    rc = TSS_RC_NOT_IMPLEMENTED;	/* corrupt descriptor */
+	}
+    }
+    return rc;
+}
+
+/* TSS_Table_PutUint() marshals the low 'length' bytes of 'value', big endian */
+
+static TPM_RC TSS_Table_PutUint(UINT32 value, UINT16 length,
+				UINT16 *written, BYTE **buffer, INT32 *size)
+{
+    TPM_RC rc = 0;
+    if (buffer != NULL) {	/* if buffer is NULL, don't marshal, just return written */
+	/* if size is NULL, ignore it, else check sufficient */
+	if ((size == NULL) || ((UINT32)*size >= length)) {
+	    switch (length) {
+	      case sizeof(UINT32):
+		(*buffer)[0] = (BYTE)(value >> 24);
+		(*buffer)[1] = (BYTE)(value >> 16);
+		(*buffer)[2] = (BYTE)(value >>  8);
+		(*buffer)[3] = (BYTE)(value >>  0);
+		break;
+	      case sizeof(UINT16):
+		(*buffer)[0] = (BYTE)(value >>  8);
+		(*buffer)[1] = (BYTE)(value >>  0);
+		break;
+	      default:
+		(*buffer)[0] = (BYTE)(value >>  0);
+	    }
+	    *buffer += length;
+	    if (size != NULL) {
+		*size -= length;
+	    }
+	}
+	else {
+	    rc = TSS_RC_INSUFFICIENT_BUFFER;
+	}
+    }
+    *written += length;
+    return rc;
+}
+
+static TPM_RC TSS_Table_PutArray(const BYTE *source, UINT16 length,
+				 UINT16 *written, BYTE **buffer, INT32 *size)
+{
+    TPM_RC rc = 0;
+    if (buffer != NULL) {
+	if ((size == NULL) || (*size >= length)) {
+	    memcpy(*buffer, source, length);
+	    *buffer += length;
+	    if (size != NULL) {
+		*size -= length;
+	    }
+	}
+	else {
+	    rc = TSS_RC_INSUFFICIENT_BUFFER;
+	}
+    }
+    *written += length;
+    return rc;
+}
+
+/* TSS_Table_GetUint() unmarshals a 'length' byte big endian value */
+
+static TPM_RC TSS_Table_GetUint(UINT32 *value, UINT16 length,
+				BYTE **buffer, INT32 *size)
+{
+    TPM_RC rc = 0;
+    if ((UINT32)*size < length) {
+	rc = TPM_RC_INSUFFICIENT;
+    }
+    else {
+	switch (length) {
+	  case sizeof(UINT32):
+	    *value = ((UINT32)((*buffer)[0]) << 24) |
+		     ((UINT32)((*buffer)[1]) << 16) |
+		     ((UINT32)((*buffer)[2]) <<  8) |
+		     ((UINT32)((*buffer)[3]) <<  0);
+	    break;
+	  case sizeof(UINT16):
+	    *value = ((UINT32)((*buffer)[0]) <<  8) |
+		     ((UINT32)((*buffer)[1]) <<  0);
+	    break;
+	  default:
+	    *value = (*buffer)[0];
+	}
+	*buffer += length;
+	*size -= length;
+    }
+    return rc;
+}
+
+static TPM_RC TSS_Table_GetArray(BYTE *target, UINT16 length,
+				 BYTE **buffer, INT32 *size)
+{
+    TPM_RC rc = 0;
+    if (length > *size) {
+	rc = TPM_RC_INSUFFICIENT;
+    }
+    else {
+	memcpy(target, *buffer, length);
+	*buffer += length;
+	*size -= length;
+    }
+    return rc;
+}
+
+/* TSS_Table_DigestSize() returns the TPMU_HA size for the hash algorithm.  TPM_ALG_NULL is size
+   0.  Other algorithms return TPM_RC_SELECTOR, the same as TPMU_HA_Unmarshal(). */
+
+static TPM_RC TSS_Table_DigestSize(UINT16 *digestSize,
+				   TPMI_ALG_HASH hashAlg)
+{
+    TPM_RC rc = 0;
+    switch (hashAlg) {
+#ifdef TPM_ALG_SHA1
+      case TPM_ALG_SHA1:
+	*digestSize = SHA1_DIGEST_SIZE;
+	break;
+#endif
+#ifdef TPM_ALG_SHA256
+      case TPM_ALG_SHA256:
+	*digestSize = SHA256_DIGEST_SIZE;
+	break;
+#endif
+#ifdef TPM_ALG_SHA384
+      case TPM_ALG_SHA384:
+	*digestSize = SHA384_DIGEST_SIZE;
+	break;
+#endif
+#ifdef TPM_ALG_SHA512
+      case TPM_ALG_SHA512:
+	*digestSize = SHA512_DIGEST_SIZE;
+	break;
+#endif
+#ifdef TPM_ALG_SM3_256
+      case TPM_ALG_SM3_256:
+	*digestSize = SM3_256_DIGEST_SIZE;
+	break;
+#endif
+      case TPM_ALG_NULL:
+	*digestSize = 0;
+	break;
+      default:
+	rc = TPM_RC_SELECTOR;
+    }
+    return rc;
+}
@@ -0,0 +1,153 @@
+/********************************************************************************/
+/*										*/
+/*		 Table Driven Structure Marshal and Unmarshal			*/
+/*		       IBM Thomas J. Watson Research Center			*/
+/*			   $Id: marshaltable.h $				*/
+/*										*/
+/* (c) Copyright IBM Corporation 2017.						*/
+/*										*/
+/* All rights reserved.								*/
+/* 										*/
+/* Redistribution and use in source and binary forms, with or without		*/
+/* modification, are permitted provided that the following conditions are	*/
+/* met:										*/
+/* 										*/
+/* Redistributions of source code must retain the above copyright notice,	*/
+/* this list of conditions and the following disclaimer.			*/
+/* 										*/
+/* Redistributions in binary form must reproduce the above copyright		*/
+/* notice, this list of conditions and the following disclaimer in the		*/
+/* documentation and/or other materials provided with the distribution.		*/
+/* 										*/
+/* Neither the names of the IBM Corporation nor the names of its		*/
+/* contributors may be used to endorse or promote products derived from		*/
+/* this software without specific prior written permission.			*/
+/* 										*/
+/* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS		*/
+/* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT		*/
+/* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR	*/
+/* A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT		*/
+/* HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,	*/
+/* SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT		*/
+/* LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,	*/
+/* DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY	*/
+/* THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT		*/
+/* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE	*/
+/* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.		*/
+/********************************************************************************/
+
+
+/* The table driven marshal engine describes a structure as a TSS_MARSHAL_TYPE, a list of
+   TSS_MARSHAL_FIELD member descriptors.  The descriptors are built from the structure definitions
+   in TPM_Types.h by the TSS_FIELD_* macros, so member offsets and sizes always track the headers.
+   One interpreter loop replaces the chain of per type functions.
+
+   The stream and the return codes are the same as the TSS_*_Marshal() and *_Unmarshal()
+   functions for the type.
+
+   The engine is not part of the TSS library.  It is a measurement tool for marshalbench, which
+   compares it to the library functions.
+*/
+
+#ifndef MARSHALTABLE_H
+#define MARSHALTABLE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef TPM_TSS
+#define TPM_TSS
+#endif
+
+#include <tss2/TPM_Types.h>
+
+/* field kinds */
+
+#define TSS_FIELD_UINT8		1	/* UINT8 */
+#define TSS_FIELD_UINT16	2	/* UINT16 */
+#define TSS_FIELD_UINT32	3	/* UINT32 */
+#define TSS_FIELD_UINT8_RANGE	4	/* UINT8, unmarshal checks min to max, TPM_RC_VALUE */
+#define TSS_FIELD_ATTRIB8	5	/* UINT8 attributes, unmarshal checks reserved bits in max */
+#define TSS_FIELD_ALG_HASH	6	/* TPMI_ALG_HASH, min is allowNull */
+#define TSS_FIELD_AUTH_SESSION	7	/* TPMI_SH_AUTH_SESSION, min is allowPwd */
+#define TSS_FIELD_TPM2B		8	/* TPM2B, max is the buffer size */
+#define TSS_FIELD_SELECT	9	/* byte array, size bytes marshaled, the UINT8 member at aux
+					   is the unmarshal count */
+#define TSS_FIELD_DIGEST	10	/* TPMU_HA, the TPMI_ALG_HASH member at aux is the selector */
+#define TSS_FIELD_LIST		11	/* UINT32 count min to max, then count elements of type,
+					   starting at aux, size bytes apart */
+
+typedef struct TSS_MARSHAL_TYPE TSS_MARSHAL_TYPE;
+
+typedef struct {
+    uint8_t			kind;
+    uint16_t			offset;		/* of the member in the structure */
+    uint16_t			size;
+    uint16_t			aux;
+    uint32_t			min;
+    uint32_t			max;
+    const TSS_MARSHAL_TYPE	*type;
+} TSS_MARSHAL_FIELD;
+
+struct TSS_MARSHAL_TYPE {
+    const char			*name;
+    size_t			fieldCount;
+    const TSS_MARSHAL_FIELD	*fields;
+};
+
+/* descriptor macros, s is the structure type and m the member */
+
+#define TSS_FIELD_OF(kind, s, m, size, aux, min, max, type) \
+    {kind, (uint16_t)offsetof(s, m), size, aux, min, max, type}
+#define TSS_FIELD_U8(s, m)		TSS_FIELD_OF(TSS_FIELD_UINT8, s, m, 0, 0, 0, 0, NULL)
+#define TSS_FIELD_U16(s, m)		TSS_FIELD_OF(TSS_FIELD_UINT16, s, m, 0, 0, 0, 0, NULL)
+#define TSS_FIELD_U32(s, m)		TSS_FIELD_OF(TSS_FIELD_UINT32, s, m, 0, 0, 0, 0, NULL)
+#define TSS_FIELD_RANGE(s, m, min, max) TSS_FIELD_OF(TSS_FIELD_UINT8_RANGE, s, m, 0, 0, min, max, NULL)
+#define TSS_FIELD_ATTRIB(s, m, reserved) TSS_FIELD_OF(TSS_FIELD_ATTRIB8, s, m, 0, 0, 0, reserved, NULL)
+#define TSS_FIELD_HASH(s, m, allowNull)	TSS_FIELD_OF(TSS_FIELD_ALG_HASH, s, m, 0, 0, allowNull, 0, NULL)
+#define TSS_FIELD_SESSION(s, m, allowPwd) TSS_FIELD_OF(TSS_FIELD_AUTH_SESSION, s, m, 0, 0, allowPwd, 0, NULL)
+#define TSS_FIELD_2B(s, m, max)		TSS_FIELD_OF(TSS_FIELD_TPM2B, s, m, 0, 0, 0, max, NULL)
+#define TSS_FIELD_ARRAY(s, m, count)	\
+    TSS_FIELD_OF(TSS_FIELD_SELECT, s, m, sizeof(((s *)0)->m), (uint16_t)offsetof(s, count), 0, 0, NULL)
+#define TSS_FIELD_HA(s, m, selector)	\
+    TSS_FIELD_OF(TSS_FIELD_DIGEST, s, m, 0, (uint16_t)offsetof(s, selector), 0, 0, NULL)
+#define TSS_FIELD_ARRAYOF(s, count, m, min, max, type)	\
+    TSS_FIELD_OF(TSS_FIELD_LIST, s, count, sizeof(((s *)0)->m[0]), (uint16_t)offsetof(s, m), \
+		 min, max, type)
+
+#define TSS_MARSHAL_TYPE_OF(name, fields) \
+    {name, sizeof(fields) / sizeof(TSS_MARSHAL_FIELD), fields}
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+    /* descriptors for the hot types.  TPMT_HA does not allow TPM_ALG_NULL, TPML_DIGEST allows a
+       count of 0, TPMS_AUTH_COMMAND allows TPM_RS_PW. */
+
+    extern const TSS_MARSHAL_TYPE TSS_TYPE_TPM2B_DIGEST;
+    extern const TSS_MARSHAL_TYPE TSS_TYPE_TPM2B_MAX_BUFFER;
+    extern const TSS_MARSHAL_TYPE TSS_TYPE_TPM2B_MAX_NV_BUFFER;
+    extern const TSS_MARSHAL_TYPE TSS_TYPE_TPMT_HA;
+    extern const TSS_MARSHAL_TYPE TSS_TYPE_TPMS_PCR_SELECTION;
+    extern const TSS_MARSHAL_TYPE TSS_TYPE_TPML_PCR_SELECTION;
+    extern const TSS_MARSHAL_TYPE TSS_TYPE_TPML_DIGEST;
+    extern const TSS_MARSHAL_TYPE TSS_TYPE_TPML_DIGEST_VALUES;
+    extern const TSS_MARSHAL_TYPE TSS_TYPE_TPMS_AUTH_COMMAND;
+    extern const TSS_MARSHAL_TYPE TSS_TYPE_TPMS_AUTH_RESPONSE;
+
+    TPM_RC TSS_Table_Marshal(const TSS_MARSHAL_TYPE *type,
+			     const void *source,
+			     UINT16 *written,
+			     BYTE **buffer,
+			     INT32 *size);
+    TPM_RC TSS_Table_Unmarshal(const TSS_MARSHAL_TYPE *type,
+			       void *target,
+			       BYTE **buffer,
+			       INT32 *size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
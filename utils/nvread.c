@@ -49,7 +49,7 @@
 #include <tss2/tss.h>
 #include <tss2/tssutils.h>
 #include <tss2/tssresponsecode.h>
-#include "ekutils.h"
+#include <tss2/tssstream.h>
 
 static void printUsage(void);
 
@@ -60,8 +60,7 @@ int main(int argc, char *argv[])
     TPM_RC			rc = 0;
     int				i;    /* argc iterator */
     TSS_CONTEXT			*tssContext = NULL;
-    NV_Read_In 			in;
-    NV_Read_Out			out;
+    TPMI_RH_NV_AUTH		authHandle = 0;
     uint16_t 			offset = 0;			/* default 0 */
     uint16_t 			readLength = 0;			/* bytes to read */
     char 			hierarchyAuthChar = 0;
@@ -75,9 +74,7 @@ int main(int argc, char *argv[])
     TPMI_SH_AUTH_SESSION    	sessionHandle2 = TPM_RH_NULL;
     unsigned int		sessionAttributes2 = 0;
     unsigned char 		*readBuffer = NULL; 
-    uint32_t 			nvBufferMax;
-    uint16_t 			bytesRead;			/* bytes read so far */
-    int				done = FALSE;
+    TSS_STREAM_BUFFER		streamBuffer;
    
     setvbuf(stdout, 0, _IONBF, 0);      /* output may be going through pipe to log file */
     TSS_SetProperty(NULL, TPM_TRACE_LEVEL, "1");
@@ -228,13 +225,13 @@ int main(int argc, char *argv[])
     /* Authorization handle */
     if (rc == 0) {
 	if (hierarchyAuthChar == 'o') {
-	    in.authHandle = TPM_RH_OWNER;  
+	    authHandle = TPM_RH_OWNER;  
 	}
 	else if (hierarchyAuthChar == 'p') {
-	    in.authHandle = TPM_RH_PLATFORM;  
+	    authHandle = TPM_RH_PLATFORM;  
 	}
 	else if (hierarchyAuthChar == 0) {
-	    in.authHandle = nvIndex;
+	    authHandle = nvIndex;
 	}
 	else {
 	    printf("\n");
@@ -257,48 +254,19 @@ int main(int argc, char *argv[])
     if (rc == 0) {
 	rc = TSS_Create(&tssContext);
     }
-    /* data may have to be read in chunks.  Read the TPM_PT_NV_BUFFER_MAX, the chunk size */
+    /* data may have to be read in chunks of TPM_PT_NV_BUFFER_MAX.  The library handles the chunking
+       and collects the chunks in readBuffer. */
     if (rc == 0) {
-	rc = readNvBufferMax(tssContext,
-			     &nvBufferMax);
-    }    
-    if (rc == 0) {
-	in.nvIndex = nvIndex;
-	in.offset = offset;	/* start at supplied offset */
-	bytesRead = 0;		/* bytes read so far */
-    }
-    /* call TSS to execute the command */
-    while ((rc == 0) && !done) {
-	if (rc == 0) {
-	    /* read a chunk */
-	    in.offset = offset + bytesRead;
-	    if ((uint32_t)(readLength - bytesRead) < nvBufferMax) {
-		in.size = readLength - bytesRead;	/* last chunk */
-	    }
-	    else {
-		in.size = nvBufferMax;		/* next chunk */
-	    }
-	}
-	if (rc == 0) {
-	    if (verbose) printf("nvread: reading %u bytes\n", in.size);
-	    rc = TSS_Execute(tssContext,
-			     (RESPONSE_PARAMETERS *)&out,
-			     (COMMAND_PARAMETERS *)&in,
-			     NULL,
-			     TPM_CC_NV_Read,
-			     sessionHandle0, nvPassword, sessionAttributes0,
-			     sessionHandle1, NULL, sessionAttributes1,
-			     sessionHandle2, NULL, sessionAttributes2,
-			     TPM_RH_NULL, NULL, 0);
-	}
-	/* copy the results to the read buffer */
-	if (rc == 0) {
-	    memcpy(readBuffer + bytesRead, out.data.b.buffer, out.data.b.size);
-	    bytesRead += out.data.b.size;
-	    if (bytesRead == readLength) {
-		done = TRUE;
-	    }
-	}
+	streamBuffer.buffer = readBuffer;
+	streamBuffer.size = readLength;
+	streamBuffer.length = 0;
+	rc = TSS_NV_ReadStream(tssContext,
+			       authHandle, nvIndex,
+			       offset, readLength,
+			       TSS_Stream_WriteBuffer, &streamBuffer,
+			       sessionHandle0, nvPassword, sessionAttributes0,
+			       sessionHandle1, sessionAttributes1,
+			       sessionHandle2, sessionAttributes2);
     }
     {
 	TPM_RC rc1 = TSS_Delete(tssContext);
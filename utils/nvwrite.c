@@ -56,7 +56,7 @@
 #include <tss2/tss.h>
 #include <tss2/tssutils.h>
 #include <tss2/tssresponsecode.h>
-#include "ekutils.h"
+#include <tss2/tssstream.h>
 
 static void printUsage(void);
 
@@ -85,10 +85,8 @@ int main(int argc, char *argv[])
     TPMI_SH_AUTH_SESSION    	sessionHandle2 = TPM_RH_NULL;
     unsigned int		sessionAttributes2 = 0;
     uint32_t 			nvBufferMax;
-    size_t 			writeLength;		/* file bytes to write */
-    unsigned char 		*writeBuffer = NULL; 	/* file buffer to write */
-    uint16_t 			bytesWritten;		/* bytes written so far */
-    int				done = FALSE;
+    FILE 			*inFile = NULL; 	/* data file to write */
+    uint32_t 			written = 0;		/* bytes written so far */
  
     setvbuf(stdout, 0, _IONBF, 0);      /* output may be going through pipe to log file */
     TSS_SetProperty(NULL, TPM_TRACE_LEVEL, "1");
@@ -283,21 +281,15 @@ int main(int argc, char *argv[])
     if (rc == 0) {
 	rc = TSS_Create(&tssContext);
     }
-    /* data may have to be written in chunks.  Read the chunk size */
-    if (rc == 0) {
-	rc = readNvBufferMax(tssContext,
-			     &nvBufferMax);
+    /* -ic, command line data must fit in one write.  Read the chunk size */
+    if ((rc == 0) && (commandData != NULL)) {
+	rc = TSS_NV_GetBufferMax(tssContext,
+				 &nvBufferMax);
     }    
     /* if there is no input data source, default to 0 byte write */
     if (dataSource == 0) {
 	in.data.b.size = 0;
     }
-    /* -if, file data can be written in chunks */
-    if (datafilename != NULL) {
-	rc = TSS_File_ReadBinaryFile(&writeBuffer,     /* freed @1 */
-				     &writeLength,
-				     datafilename);
-    }
     /* -id, for pin pass or pin fail */
     if (inData) {
 	uint32_t tmpData;
@@ -307,56 +299,39 @@ int main(int argc, char *argv[])
 	tmpData = htonl(pinLimit);
 	memcpy(in.data.b.buffer + sizeof(tmpData), &tmpData, sizeof(tmpData));
     }
-    /* -ic, command line data must fit in one write */
-    if (commandData != NULL) {
+    if ((rc == 0) && (commandData != NULL)) {
 	rc = TSS_TPM2B_StringCopy(&in.data.b, commandData, nvBufferMax);
     }
-    if (rc == 0) {
-	in.nvIndex = nvIndex;
-	in.offset = offset;		/* beginning offset */
-	bytesWritten = 0;
+    /* -if, file data is streamed to the TPM in chunks */
+    if ((rc == 0) && (datafilename != NULL)) {
+	rc = TSS_File_Open(&inFile, datafilename, "rb");	/* closed @1 */
     }
-    while ((rc == 0) && !done) {
-	uint16_t writeBytes;		/* bytes to write in this pass */
-	if (rc == 0) {
-	    /* for data from file, write a chunk */
-	    if (datafilename != NULL) {
-		in.offset = offset + bytesWritten;
-		if ((uint32_t)(writeLength - bytesWritten) < nvBufferMax) {
-		    writeBytes = writeLength - bytesWritten;	/* last chunk */
-		}
-		else {
-		    writeBytes = nvBufferMax;	/* next chunk */
-		}
-		rc = TSS_TPM2B_Create(&in.data.b, writeBuffer + bytesWritten, writeBytes,
-				      MAX_NV_BUFFER_SIZE);
-	    }
-	}
-	/* call TSS to execute the command */
-	if (rc == 0) {
-	    if (verbose) printf("nvwrite: writing %u bytes\n", in.data.b.size);
-	    rc = TSS_Execute(tssContext,
-			     NULL,
-			     (COMMAND_PARAMETERS *)&in,
-			     NULL,
-			     TPM_CC_NV_Write,
-			     sessionHandle0, nvPassword, sessionAttributes0,
-			     sessionHandle1, NULL, sessionAttributes1,
-			     sessionHandle2, NULL, sessionAttributes2,
-			     TPM_RH_NULL, NULL, 0);
-	}
-	/* data file can be written in chunks, other options are single write */
-	if (rc == 0) {
-	    if (datafilename == NULL) {
-		done = TRUE;
-	    }
-	    else {
-		bytesWritten += writeBytes;
-		if (bytesWritten == writeLength) {
-		    done = TRUE;
-		}
-	    }
-	}
+    if ((rc == 0) && (datafilename != NULL)) {
+	rc = TSS_NV_WriteStream(tssContext,
+				in.authHandle,
+				nvIndex,
+				offset,
+				TSS_Stream_ReadFile, inFile,
+				&written,
+				sessionHandle0, nvPassword, sessionAttributes0,
+				sessionHandle1, sessionAttributes1,
+				sessionHandle2, sessionAttributes2);
+	if (verbose) printf("nvwrite: wrote %u bytes\n", written);
+    }
+    /* other data sources are a single write */
+    if ((rc == 0) && (datafilename == NULL)) {
+	in.nvIndex = nvIndex;
+	in.offset = offset;
+	if (verbose) printf("nvwrite: writing %u bytes\n", in.data.b.size);
+	rc = TSS_Execute(tssContext,
+			 NULL,
+			 (COMMAND_PARAMETERS *)&in,
+			 NULL,
+			 TPM_CC_NV_Write,
+			 sessionHandle0, nvPassword, sessionAttributes0,
+			 sessionHandle1, NULL, sessionAttributes1,
+			 sessionHandle2, NULL, sessionAttributes2,
+			 TPM_RH_NULL, NULL, 0);
     }
     {
 	TPM_RC rc1 = TSS_Delete(tssContext);
@@ -379,7 +354,9 @@ int main(int argc, char *argv[])
 	}
 	rc = EXIT_FAILURE;
     }
-    free(writeBuffer);	/* @1 */
+    if (inFile != NULL) {
+	fclose(inFile);		/* @1 */
+    }
     return rc;
 }
 
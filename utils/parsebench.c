@@ -0,0 +1,367 @@
+/********************************************************************************/
+/*										*/
+/*			       Parse Benchmark					*/
+/*		       IBM Thomas J. Watson Research Center			*/
+/*			     $Id: parsebench.c $				*/
+/*										*/
+/* (c) Copyright IBM Corporation 2017.						*/
+/*										*/
+/* All rights reserved.								*/
+/* 										*/
+/* Redistribution and use in source and binary forms, with or without		*/
+/* modification, are permitted provided that the following conditions are	*/
+/* met:										*/
+/* 										*/
+/* Redistributions of source code must retain the above copyright notice,	*/
+/* this list of conditions and the following disclaimer.			*/
+/* 										*/
+/* Redistributions in binary form must reproduce the above copyright		*/
+/* notice, this list of conditions and the following disclaimer in the		*/
+/* documentation and/or other materials provided with the distribution.		*/
+/* 										*/
+/* Neither the names of the IBM Corporation nor the names of its		*/
+/* contributors may be used to endorse or promote products derived from		*/
+/* this software without specific prior written permission.			*/
+/* 										*/
+/* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS		*/
+/* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT		*/
+/* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR	*/
+/* A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT		*/
+/* HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,	*/
+/* SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT		*/
+/* LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,	*/
+/* DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY	*/
+/* THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT		*/
+/* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE	*/
+/* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.		*/
+/********************************************************************************/
+
+
+
+/* parsebench times the TSS command and response parsers over a corpus of captured command and
+   response pairs.  It needs no TPM.
+
+   The corpus is captured by setting the TPM_CORPUS_DIR property while running the regression
+   tests against a simulator, e.g.
+
+	mkdir corpus
+	TPM_CORPUS_DIR=corpus ./reg.sh -a
+
+   Each pair is timed three ways:
+
+   inunm	command parameter unmarshal, the TSS command parameter check
+   inmar	command parameter marshal of the unmarshaled parameters
+   outunm	response unmarshal, for successful responses
+
+   The results are averaged per command, in marshal table order.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+
+#include <tss2/tss.h>
+#include <tss2/tssutils.h>
+#include <tss2/tssfile.h>
+#include <tss2/tssmarshal.h>
+#include <tss2/tssresponsecode.h>
+
+#include "corpuslib.h"
+
+/* the timing totals for one command */
+
+typedef struct {
+    TPM_CC		commandCode;
+    const char		*commandText;
+    unsigned int	pairs;
+    unsigned int	inUnmarshalCount;
+    double		inUnmarshalSeconds;
+    unsigned int	inMarshalCount;
+    double		inMarshalSeconds;
+    unsigned int	outUnmarshalCount;
+    double		outUnmarshalSeconds;
+} PARSE_BENCH;
+
+static TPM_RC benchPair(PARSE_BENCH *parseBench,
+			size_t parseBenchCount,
+			const char *filename,
+			unsigned int loops);
+static void printResult(const PARSE_BENCH *parseBench);
+static void printUsage(void);
+
+int verbose = FALSE;
+
+int main(int argc, char *argv[])
+{
+    TPM_RC			rc = 0;
+    int				i;    /* argc iterator */
+    unsigned int		loops = 10000;
+    const char			**filenames = NULL;
+    size_t			filenameCount = 0;
+    PARSE_BENCH			*parseBench = NULL;
+    size_t			parseBenchCount = 0;
+    uint32_t			commandHandleCount;
+    size_t			t;
+
+    setvbuf(stdout, 0, _IONBF, 0);      /* output may be going through pipe to log file */
+    TSS_SetProperty(NULL, TPM_TRACE_LEVEL, "1");
+
+    filenames = malloc(argc * sizeof(const char *));	/* freed @1 */
+    if (filenames == NULL) {
+	printf("parsebench: Cannot allocate file name list\n");
+	exit(1);
+    }
+    /* command line argument defaults */
+    for (i=1 ; (i<argc) && (rc == 0) ; i++) {
+	if (strcmp(argv[i],"-if") == 0) {
+	    i++;
+	    if (i < argc) {
+		filenames[filenameCount] = argv[i];
+		filenameCount++;
+	    }
+	    else {
+		printf("-if option needs a value\n");
+		printUsage();
+	    }
+	}
+	else if (strcmp(argv[i],"-l") == 0) {
+	    i++;
+	    if (i < argc) {
+		loops = atoi(argv[i]);
+	    }
+	    else {
+		printf("-l option needs a value\n");
+		printUsage();
+	    }
+	}
+	else if (strcmp(argv[i],"-h") == 0) {
+	    printUsage();
+	}
+	else if (strcmp(argv[i],"-v") == 0) {
+	    verbose = TRUE;
+	    TSS_SetProperty(NULL, TPM_TRACE_LEVEL, "2");
+	}
+	else {
+	    printf("\n%s is not a valid option\n", argv[i]);
+	    printUsage();
+	}
+    }
+    if (filenameCount == 0) {
+	printf("Missing parameter -if\n");
+	printUsage();
+    }
+    if (loops == 0) {
+	printf("Illegal parameter -l\n");
+	printUsage();
+    }
+    /* one result per marshal table entry */
+    if (rc == 0) {
+	TPM_CC		commandCode;
+	const char	*commandText;
+	while (TSS_MarshalTable_Entry(parseBenchCount, &commandCode, &commandText,
+				      &commandHandleCount) == 0) {
+	    parseBenchCount++;
+	}
+	parseBench = calloc(parseBenchCount, sizeof(PARSE_BENCH));	/* freed @2 */
+	if (parseBench == NULL) {
+	    printf("parsebench: Cannot allocate %lu results\n", (unsigned long)parseBenchCount);
+	    rc = TSS_RC_OUT_OF_MEMORY;
+	}
+    }
+    for (t = 0 ; (rc == 0) && (t < parseBenchCount) ; t++) {
+	rc = TSS_MarshalTable_Entry(t,
+				    &parseBench[t].commandCode,
+				    &parseBench[t].commandText,
+				    &commandHandleCount);
+    }
+    for (t = 0 ; (rc == 0) && (t < filenameCount) ; t++) {
+	rc = benchPair(parseBench, parseBenchCount, filenames[t], loops);
+    }
+    if (rc == 0) {
+	printf("Loops %u, pairs %lu, ns per operation\n", loops, (unsigned long)filenameCount);
+	printf("%-28s %6s %10s %10s %10s\n", "command", "pairs", "inunm", "inmar", "outunm");
+	for (t = 0 ; t < parseBenchCount ; t++) {
+	    if (parseBench[t].pairs > 0) {
+		printResult(&parseBench[t]);
+	    }
+	}
+    }
+    if (rc == 0) {
+	if (verbose) printf("parsebench: success\n");
+    }
+    else {
+	const char *msg;
+	const char *submsg;
+	const char *num;
+	printf("parsebench: failed, rc %08x\n", rc);
+	TSS_ResponseCode_toString(&msg, &submsg, &num, rc);
+	printf("%s%s%s\n", msg, submsg, num);
+	rc = EXIT_FAILURE;
+    }
+    free(filenames);		/* @1 */
+    free(parseBench);		/* @2 */
+    return rc;
+}
+
+/* benchPair() times 'loops' parses of the command and response pair in 'filename', and adds the
+   times to the command's parseBench entry */
+
+static TPM_RC benchPair(PARSE_BENCH *parseBench,
+			size_t parseBenchCount,
+			const char *filename,
+			unsigned int loops)
+{
+    TPM_RC		rc = 0;
+    unsigned char 	*data = NULL;		/* freed @1 */
+    size_t 		length;
+    CORPUS_PAIR		corpusPair;
+    PARSE_BENCH		*entry = NULL;
+    COMMAND_PARAMETERS	*commandParameters = NULL;
+    RESPONSE_PARAMETERS	*responseParameters = NULL;
+    BYTE		*commandBuffer = NULL;
+    BYTE		*buffer;
+    INT32		size;
+    UINT16		written;
+    unsigned int	l;
+    clock_t		start;
+    TPM_RC		rc1;
+    size_t		t;
+
+    if (rc == 0) {
+	rc = TSS_File_ReadBinaryFile(&data, &length, filename);
+    }
+    if (rc == 0) {
+	rc = Corpus_Pair_Parse(&corpusPair, data, length);
+	if (rc != 0) {
+	    printf("parsebench: %s is not a command and response pair\n", filename);
+	}
+    }
+    if (rc == 0) {
+	for (t = 0 ; t < parseBenchCount ; t++) {
+	    if (parseBench[t].commandCode == corpusPair.commandCode) {
+		entry = &parseBench[t];
+		break;
+	    }
+	}
+	if (entry == NULL) {
+	    rc = TSS_RC_COMMAND_UNIMPLEMENTED;
+	}
+    }
+    /* the parameter unions are too large for the stack */
+    if (rc == 0) {
+	rc = TSS_Malloc((uint8_t **)&commandParameters, sizeof(COMMAND_PARAMETERS));	/* freed @2 */
+    }
+    if (rc == 0) {
+	rc = TSS_Malloc((uint8_t **)&responseParameters, sizeof(RESPONSE_PARAMETERS)); /* freed @3 */
+    }
+    if (rc == 0) {
+	rc = TSS_Malloc(&commandBuffer, MAX_COMMAND_SIZE);	/* freed @4 */
+    }
+    if (rc == 0) {
+	if (verbose) printf("parsebench: %s %s\n", filename, entry->commandText);
+	entry->pairs++;
+	/* command parameter unmarshal, skipped for commands with no parameters */
+	buffer = corpusPair.commandParameters;
+	size = corpusPair.commandParameterSize;
+	rc1 = TSS_MarshalTable_InUnmarshal(corpusPair.commandCode, commandParameters,
+					   &buffer, &size, corpusPair.handles);
+	if (rc1 == 0) {
+	    start = clock();
+	    for (l = 0 ; l < loops ; l++) {
+		buffer = corpusPair.commandParameters;
+		size = corpusPair.commandParameterSize;
+		TSS_MarshalTable_InUnmarshal(corpusPair.commandCode, commandParameters,
+					     &buffer, &size, corpusPair.handles);
+	    }
+	    entry->inUnmarshalSeconds += (double)(clock() - start) / CLOCKS_PER_SEC;
+	    entry->inUnmarshalCount += loops;
+	    /* command parameter marshal */
+	    start = clock();
+	    for (l = 0 ; l < loops ; l++) {
+		buffer = commandBuffer;
+		size = MAX_COMMAND_SIZE;
+		written = 0;
+		TSS_MarshalTable_InMarshal(corpusPair.commandCode, commandParameters,
+					   &written, &buffer, &size);
+	    }
+	    entry->inMarshalSeconds += (double)(clock() - start) / CLOCKS_PER_SEC;
+	    entry->inMarshalCount += loops;
+	}
+	else if (rc1 != TSS_RC_NOT_IMPLEMENTED) {
+	    printf("parsebench: %s command parameters do not unmarshal, rc %08x\n",
+		   filename, rc1);
+	}
+    }
+    /* response unmarshal */
+    if ((rc == 0) && (corpusPair.responseCode == TPM_RC_SUCCESS)) {
+	buffer = corpusPair.response;
+	size = corpusPair.responseSize;
+	rc1 = TSS_MarshalTable_OutUnmarshal(corpusPair.commandCode, responseParameters,
+					    corpusPair.responseTag, &buffer, &size);
+	if (rc1 == 0) {
+	    start = clock();
+	    for (l = 0 ; l < loops ; l++) {
+		buffer = corpusPair.response;
+		size = corpusPair.responseSize;
+		TSS_MarshalTable_OutUnmarshal(corpusPair.commandCode, responseParameters,
+					      corpusPair.responseTag, &buffer, &size);
+	    }
+	    entry->outUnmarshalSeconds += (double)(clock() - start) / CLOCKS_PER_SEC;
+	    entry->outUnmarshalCount += loops;
+	}
+	else if (rc1 != TSS_RC_NOT_IMPLEMENTED) {
+	    printf("parsebench: %s response does not unmarshal, rc %08x\n",
+		   filename, rc1);
+	}
+    }
+    free(data);			/* @1 */
+    free(commandParameters);	/* @2 */
+    free(responseParameters);	/* @3 */
+    free(commandBuffer);	/* @4 */
+    return rc;
+}
+
+/* printResult() prints the average ns per operation for one command, or - if the command had no
+   parameters to time */
+
+static void printResult(const PARSE_BENCH *parseBench)
+{
+    char	inUnmarshal[16];
+    char	inMarshal[16];
+    char	outUnmarshal[16];
+
+    strcpy(inUnmarshal, "-");
+    strcpy(inMarshal, "-");
+    strcpy(outUnmarshal, "-");
+    if (parseBench->inUnmarshalCount > 0) {
+	sprintf(inUnmarshal, "%.1f",
+		(parseBench->inUnmarshalSeconds * 1e9) / parseBench->inUnmarshalCount);
+    }
+    if (parseBench->inMarshalCount > 0) {
+	sprintf(inMarshal, "%.1f",
+		(parseBench->inMarshalSeconds * 1e9) / parseBench->inMarshalCount);
+    }
+    if (parseBench->outUnmarshalCount > 0) {
+	sprintf(outUnmarshal, "%.1f",
+		(parseBench->outUnmarshalSeconds * 1e9) / parseBench->outUnmarshalCount);
+    }
+    printf("%-28s %6u %10s %10s %10s\n", parseBench->commandText, parseBench->pairs,
+	   inUnmarshal, inMarshal, outUnmarshal);
+    return;
+}
+
+static void printUsage(void)
+{
+    printf("\n");
+    printf("parsebench\n");
+    printf("\n");
+    printf("Times TSS command and response parsing over a captured corpus, no TPM is required\n");
+    printf("\n");
+    printf("Capture a corpus by running the regression tests with TPM_CORPUS_DIR set\n");
+    printf("\n");
+    printf("\t-if command and response pair file, may be repeated\n");
+    printf("\t[-l number of loops to time each pair (default 10000)]\n");
+    exit(1);	
+}
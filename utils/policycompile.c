@@ -0,0 +1,833 @@
+/********************************************************************************/
+/*										*/
+/*			       Policy Compiler					*/
+/*		       IBM Thomas J. Watson Research Center			*/
+/*			    $Id: policycompile.c $				*/
+/*										*/
+/* (c) Copyright IBM Corporation 2017.						*/
+/*										*/
+/* All rights reserved.								*/
+/* 										*/
+/* Redistribution and use in source and binary forms, with or without		*/
+/* modification, are permitted provided that the following conditions are	*/
+/* met:										*/
+/* 										*/
+/* Redistributions of source code must retain the above copyright notice,	*/
+/* this list of conditions and the following disclaimer.			*/
+/* 										*/
+/* Redistributions in binary form must reproduce the above copyright		*/
+/* notice, this list of conditions and the following disclaimer in the		*/
+/* documentation and/or other materials provided with the distribution.		*/
+/* 										*/
+/* Neither the names of the IBM Corporation nor the names of its		*/
+/* contributors may be used to endorse or promote products derived from		*/
+/* this software without specific prior written permission.			*/
+/* 										*/
+/* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS		*/
+/* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT		*/
+/* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR	*/
+/* A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT		*/
+/* HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,	*/
+/* SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT		*/
+/* LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,	*/
+/* DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY	*/
+/* THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT		*/
+/* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE	*/
+/* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.		*/
+/********************************************************************************/
+
+/* policycompile calculates TPM2 policy digests from a policy description, without a TPM or a
+   trial session.  It replaces the policymaker hexascii command line files for new policies.
+
+   A description file holds any number of policies.  Each policy is a block of policy statements,
+   one per line, which are extended in order for every requested hash algorithm.  '#' begins a
+   comment.
+
+	policy name [from base]
+	    statement
+	    ...
+	end
+
+   'from base' starts from the digests of an earlier policy rather than zero, so a common prefix
+   is calculated once for many policies.
+
+   Statements (hex is big endian hexascii, or @filename for a binary file):
+
+	commandcode	cc
+	authvalue
+	password
+	physicalpresence
+	locality	locality
+	nvwritten	yes | no
+	pcr		halg pcr[,pcr...] value ...	the PCR values in ascending PCR order
+	or		policy policy ...		2 to 8 earlier policies
+	signed		name-hex [policyref-hex]
+	secret		name-hex [policyref-hex]
+	authorize	name-hex [policyref-hex]
+	authorizenv	name-hex
+	nv		name-hex operand-hex offset operation
+	countertimer	operand-hex offset operation
+	cphash		digest-hex
+	namehash	digest-hex
+	template	digest-hex
+
+   Numbers are decimal, or hex with a 0x prefix.
+
+   Example:
+
+	policy sign
+	    commandcode 0x15d
+	end
+	policy quote
+	    commandcode 0x158
+	end
+	policy signorquote
+	    or sign quote
+	end
+
+   With -od, each policy digest is written to dir/name.bin, or dir/name-halg.bin when more than one
+   hash algorithm is requested.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <ctype.h>
+
+#include <tss2/tss.h>
+#include <tss2/tssutils.h>
+#include <tss2/tssfile.h>
+#include <tss2/tsscryptoh.h>
+#include <tss2/tssresponsecode.h>
+#include <tss2/tsspolicy.h>
+
+#define POLICY_NAME_MAX		64	/* maximum policy name length, including nul terminator */
+#define POLICY_LINE_MAX		4096	/* maximum description line length */
+#define POLICY_TOKENS_MAX	32	/* maximum tokens on a description line */
+
+typedef struct POLICY_ENTRY {
+    char	name[POLICY_NAME_MAX];
+    TSS_POLICY	policy;
+} POLICY_ENTRY;
+
+typedef struct POLICY_TABLE {
+    POLICY_ENTRY	*entries;
+    size_t		count;
+    size_t		allocated;
+} POLICY_TABLE;
+
+/* local prototypes */
+
+static void printUsage(void);
+static TPM_RC compileFile(POLICY_TABLE *table,
+			  const TSS_POLICY *initial,
+			  const char *outDirectory,
+			  int pr,
+			  const char *filename);
+static TPM_RC compileStatement(TSS_POLICY *policy,
+			       const POLICY_TABLE *table,
+			       char **tokens,
+			       int tokenCount);
+static TPM_RC compilePCR(TSS_POLICY *policy,
+			 char **tokens,
+			 int tokenCount);
+static TPM_RC compileOR(TSS_POLICY *policy,
+			const POLICY_TABLE *table,
+			char **tokens,
+			int tokenCount);
+static TPM_RC emitPolicy(const POLICY_ENTRY *entry,
+			 const char *outDirectory,
+			 int pr);
+static const POLICY_ENTRY *findPolicy(const POLICY_TABLE *table,
+				      const char *name);
+static TPM_RC addPolicy(POLICY_TABLE *table,
+			const char *name,
+			const TSS_POLICY *policy);
+static TPM_RC parseBinary(uint8_t *binary,
+			  uint16_t *length,
+			  size_t maxLength,
+			  const char *token);
+static TPM_RC parseNumber(uint32_t *number,
+			  uint32_t maxNumber,
+			  const char *token);
+static TPM_RC parseHashAlg(TPMI_ALG_HASH *hashAlg,
+			   const char *token);
+static const char *hashAlgName(TPMI_ALG_HASH hashAlg);
+
+int verbose = FALSE;
+
+int main(int argc, char *argv[])
+{
+    TPM_RC		rc = 0;
+    int			i;    			/* argc iterator */
+    const char 		*inFilename = NULL;
+    const char 		*outDirectory = NULL;
+    int			pr = FALSE;
+    TPMI_ALG_HASH	hashAlg[HASH_COUNT];
+    uint32_t		hashAlgCount = 0;
+    TSS_POLICY		initial;
+    POLICY_TABLE	table;
+
+    setvbuf(stdout, 0, _IONBF, 0);      /* output may be going through pipe to log file */
+    TSS_SetProperty(NULL, TPM_TRACE_LEVEL, "1");
+    table.entries = NULL;
+    table.count = 0;
+    table.allocated = 0;
+
+    for (i=1 ; (i<argc) && (rc == 0) ; i++) {
+	if (strcmp(argv[i],"-halg") == 0) {
+	    i++;
+	    if (i < argc) {
+		if (hashAlgCount == HASH_COUNT) {
+		    printf("Too many -halg\n");
+		    printUsage();
+		}
+		if (parseHashAlg(&hashAlg[hashAlgCount], argv[i]) != 0) {
+		    printf("Bad parameter for -halg\n");
+		    printUsage();
+		}
+		hashAlgCount++;
+	    }
+	    else {
+		printf("Missing parameter for -halg\n");
+		printUsage();
+	    }
+	}
+	else if (strcmp(argv[i],"-if") == 0) {
+	    i++;
+	    if (i < argc) {
+		inFilename = argv[i];
+	    }
+	    else {
+		printf("-if option needs a value\n");
+		printUsage();
+	    }
+	}
+	else if (strcmp(argv[i],"-od") == 0) {
+	    i++;
+	    if (i < argc) {
+		outDirectory = argv[i];
+	    }
+	    else {
+		printf("-od option needs a value\n");
+		printUsage();
+	    }
+	}
+	else if (strcmp(argv[i],"-pr") == 0) {
+	    pr = TRUE;
+	}
+	else if (strcmp(argv[i],"-h") == 0) {
+	    printUsage();
+	}
+	else if (strcmp(argv[i],"-v") == 0) {
+	    verbose = TRUE;
+	    TSS_SetProperty(NULL, TPM_TRACE_LEVEL, "2");
+	}
+	else {
+	    printf("\n%s is not a valid option\n", argv[i]);
+	    printUsage();
+	}
+    }
+    if (inFilename == NULL) {
+	printf("Missing input file parameter -if\n");
+	printUsage();
+    }
+    if (hashAlgCount == 0) {
+	hashAlg[0] = TPM_ALG_SHA256;
+	hashAlgCount = 1;
+    }
+    if (rc == 0) {
+	rc = TSS_Policy_Init(&initial, hashAlg, hashAlgCount);
+    }
+    if (rc == 0) {
+	rc = compileFile(&table, &initial, outDirectory, pr, inFilename);
+    }
+    if (rc == 0) {
+	if (verbose) printf("policycompile: %lu policies\n", (unsigned long)table.count);
+    }
+    else {
+	const char *msg;
+	const char *submsg;
+	const char *num;
+	printf("policycompile: failed, rc %08x\n", rc);
+	TSS_ResponseCode_toString(&msg, &submsg, &num, rc);
+	printf("%s%s%s\n", msg, submsg, num);
+	rc = EXIT_FAILURE;
+    }
+    free(table.entries);
+    return rc;
+}
+
+/* compileFile() compiles each policy block in the description file */
+
+static TPM_RC compileFile(POLICY_TABLE *table,
+			  const TSS_POLICY *initial,
+			  const char *outDirectory,
+			  int pr,
+			  const char *filename)
+{
+    TPM_RC		rc = 0;
+    FILE		*file = NULL;		/* closed @1 */
+    char		line[POLICY_LINE_MAX];
+    unsigned int	lineNumber = 0;
+    int			inPolicy = FALSE;
+    POLICY_ENTRY	current;
+
+    if (rc == 0) {
+	rc = TSS_File_Open(&file, filename, "r");	/* closed @1 */
+    }
+    while ((rc == 0) && (fgets(line, sizeof(line), file) != NULL)) {
+	char	*tokens[POLICY_TOKENS_MAX];
+	int	tokenCount = 0;
+	char	*comment;
+	char	*token;
+
+	lineNumber++;
+	comment = strchr(line, '#');
+	if (comment != NULL) {
+	    *comment = '\0';
+	}
+	for (token = strtok(line, " \t\r\n") ;
+	     (token != NULL) && (tokenCount < POLICY_TOKENS_MAX) ;
+	     token = strtok(NULL, " \t\r\n")) {
+	    tokens[tokenCount] = token;
+	    tokenCount++;
+	}
+	if (tokenCount == 0) {
+	    continue;
+	}
+	if (token != NULL) {
+	    printf("compileFile: Line %u has more than %u tokens\n",
+		   lineNumber, POLICY_TOKENS_MAX);
+	    rc = TSS_RC_BAD_PROPERTY_VALUE;
+	}
+	/* start a policy block */
+	else if (strcmp(tokens[0], "policy") == 0) {
+	    if (inPolicy) {
+		printf("compileFile: Line %u policy %s has no end\n", lineNumber, current.name);
+		rc = TSS_RC_BAD_PROPERTY_VALUE;
+	    }
+	    else if (((tokenCount != 2) && (tokenCount != 4)) ||
+		     ((tokenCount == 4) && (strcmp(tokens[2], "from") != 0)) ||
+		     (strlen(tokens[1]) >= POLICY_NAME_MAX)) {
+		printf("compileFile: Line %u expected policy name [from base]\n", lineNumber);
+		rc = TSS_RC_BAD_PROPERTY_VALUE;
+	    }
+	    else if (findPolicy(table, tokens[1]) != NULL) {
+		printf("compileFile: Line %u policy %s already defined\n", lineNumber, tokens[1]);
+		rc = TSS_RC_BAD_PROPERTY_VALUE;
+	    }
+	    else {
+		const POLICY_ENTRY *base = NULL;
+		if (tokenCount == 4) {
+		    base = findPolicy(table, tokens[3]);
+		    if (base == NULL) {
+			printf("compileFile: Line %u policy %s not defined\n",
+			       lineNumber, tokens[3]);
+			rc = TSS_RC_BAD_PROPERTY_VALUE;
+		    }
+		}
+		if (rc == 0) {
+		    strcpy(current.name, tokens[1]);
+		    current.policy = (base != NULL) ? base->policy : *initial;
+		    inPolicy = TRUE;
+		}
+	    }
+	}
+	/* finish a policy block */
+	else if (strcmp(tokens[0], "end") == 0) {
+	    if (!inPolicy || (tokenCount != 1)) {
+		printf("compileFile: Line %u unexpected end\n", lineNumber);
+		rc = TSS_RC_BAD_PROPERTY_VALUE;
+	    }
+	    if (rc == 0) {
+		rc = addPolicy(table, current.name, &current.policy);
+	    }
+	    if (rc == 0) {
+		rc = emitPolicy(&current, outDirectory, pr);
+	    }
+	    inPolicy = FALSE;
+	}
+	else if (!inPolicy) {
+	    printf("compileFile: Line %u %s outside a policy\n", lineNumber, tokens[0]);
+	    rc = TSS_RC_BAD_PROPERTY_VALUE;
+	}
+	else {
+	    rc = compileStatement(&current.policy, table, tokens, tokenCount);
+	    if (rc != 0) {
+		printf("compileFile: Line %u error in %s\n", lineNumber, tokens[0]);
+	    }
+	}
+    }
+    if ((rc == 0) && inPolicy) {
+	printf("compileFile: policy %s has no end\n", current.name);
+	rc = TSS_RC_BAD_PROPERTY_VALUE;
+    }
+    if (file != NULL) {
+	fclose(file);		/* @1 */
+    }
+    return rc;
+}
+
+/* compileStatement() extends one policy statement into the policy */
+
+static TPM_RC compileStatement(TSS_POLICY *policy,
+			       const POLICY_TABLE *table,
+			       char **tokens,
+			       int tokenCount)
+{
+    TPM_RC		rc = 0;
+    const char		*statement = tokens[0];
+    uint32_t		number;
+    uint32_t		offset;
+    uint32_t		operation;
+    TPM2B_NAME		name;
+    TPM2B_NONCE		policyRef;
+    TPM2B_DIGEST	digest;
+
+    if ((strcmp(statement, "authvalue") == 0) ||
+	(strcmp(statement, "password") == 0) ||
+	(strcmp(statement, "physicalpresence") == 0)) {
+	if (tokenCount != 1) {
+	    rc = TSS_RC_BAD_PROPERTY_VALUE;
+	}
+	else if (statement[0] == 'a') {
+	    rc = TSS_Policy_AuthValue(policy);
+	}
+	else if (statement[0] == 'p' && statement[1] == 'a') {
+	    rc = TSS_Policy_Password(policy);
+	}
+	else {
+	    rc = TSS_Policy_PhysicalPresence(policy);
+	}
+    }
+    else if (strcmp(statement, "commandcode") == 0) {
+	if (tokenCount != 2) {
+	    rc = TSS_RC_BAD_PROPERTY_VALUE;
+	}
+	if (rc == 0) {
+	    rc = parseNumber(&number, 0xffffffff, tokens[1]);
+	}
+	if (rc == 0) {
+	    rc = TSS_Policy_CommandCode(policy, number);
+	}
+    }
+    else if (strcmp(statement, "locality") == 0) {
+	TPMA_LOCALITY locality;
+	if (tokenCount != 2) {
+	    rc = TSS_RC_BAD_PROPERTY_VALUE;
+	}
+	if (rc == 0) {
+	    rc = parseNumber(&number, 0xff, tokens[1]);
+	}
+	if (rc == 0) {
+	    locality.val = number;
+	    rc = TSS_Policy_Locality(policy, locality);
+	}
+    }
+    else if (strcmp(statement, "nvwritten") == 0) {
+	if ((tokenCount != 2) ||
+	    ((strcmp(tokens[1], "yes") != 0) && (strcmp(tokens[1], "no") != 0))) {
+	    rc = TSS_RC_BAD_PROPERTY_VALUE;
+	}
+	if (rc == 0) {
+	    rc = TSS_Policy_NvWritten(policy, (strcmp(tokens[1], "yes") == 0) ? YES : NO);
+	}
+    }
+    else if (strcmp(statement, "pcr") == 0) {
+	rc = compilePCR(policy, tokens, tokenCount);
+    }
+    else if (strcmp(statement, "or") == 0) {
+	rc = compileOR(policy, table, tokens, tokenCount);
+    }
+    else if ((strcmp(statement, "signed") == 0) ||
+	     (strcmp(statement, "secret") == 0) ||
+	     (strcmp(statement, "authorize") == 0)) {
+	policyRef.t.size = 0;
+	if ((tokenCount != 2) && (tokenCount != 3)) {
+	    rc = TSS_RC_BAD_PROPERTY_VALUE;
+	}
+	if (rc == 0) {
+	    rc = parseBinary(name.t.name, &name.t.size, sizeof(name.t.name), tokens[1]);
+	}
+	if ((rc == 0) && (tokenCount == 3)) {
+	    rc = parseBinary(policyRef.t.buffer, &policyRef.t.size,
+			     sizeof(policyRef.t.buffer), tokens[2]);
+	}
+	if (rc == 0) {
+	    if (strcmp(statement, "signed") == 0) {
+		rc = TSS_Policy_Signed(policy, &name, &policyRef);
+	    }
+	    else if (strcmp(statement, "secret") == 0) {
+		rc = TSS_Policy_Secret(policy, &name, &policyRef);
+	    }
+	    else {
+		rc = TSS_Policy_Authorize(policy, &name, &policyRef);
+	    }
+	}
+    }
+    else if (strcmp(statement, "authorizenv") == 0) {
+	if (tokenCount != 2) {
+	    rc = TSS_RC_BAD_PROPERTY_VALUE;
+	}
+	if (rc == 0) {
+	    rc = parseBinary(name.t.name, &name.t.size, sizeof(name.t.name), tokens[1]);
+	}
+	if (rc == 0) {
+	    rc = TSS_Policy_AuthorizeNV(policy, &name);
+	}
+    }
+    else if ((strcmp(statement, "nv") == 0) ||
+	     (strcmp(statement, "countertimer") == 0)) {
+	int nv = (strcmp(statement, "nv") == 0);
+	int t = nv ? 2 : 1;		/* first operand token */
+	if (tokenCount != (t + 3)) {
+	    rc = TSS_RC_BAD_PROPERTY_VALUE;
+	}
+	if ((rc == 0) && nv) {
+	    rc = parseBinary(name.t.name, &name.t.size, sizeof(name.t.name), tokens[1]);
+	}
+	if (rc == 0) {
+	    rc = parseBinary(digest.t.buffer, &digest.t.size, sizeof(digest.t.buffer), tokens[t]);
+	}
+	if (rc == 0) {
+	    rc = parseNumber(&offset, 0xffff, tokens[t+1]);
+	}
+	if (rc == 0) {
+	    rc = parseNumber(&operation, 0xffff, tokens[t+2]);
+	}
+	if (rc == 0) {
+	    if (nv) {
+		rc = TSS_Policy_NV(policy, &name, &digest, offset, operation);
+	    }
+	    else {
+		rc = TSS_Policy_CounterTimer(policy, &digest, offset, operation);
+	    }
+	}
+    }
+    else if ((strcmp(statement, "cphash") == 0) ||
+	     (strcmp(statement, "namehash") == 0) ||
+	     (strcmp(statement, "template") == 0)) {
+	if (tokenCount != 2) {
+	    rc = TSS_RC_BAD_PROPERTY_VALUE;
+	}
+	if (rc == 0) {
+	    rc = parseBinary(digest.t.buffer, &digest.t.size, sizeof(digest.t.buffer), tokens[1]);
+	}
+	if (rc == 0) {
+	    if (strcmp(statement, "cphash") == 0) {
+		rc = TSS_Policy_CpHash(policy, &digest);
+	    }
+	    else if (strcmp(statement, "namehash") == 0) {
+		rc = TSS_Policy_NameHash(policy, &digest);
+	    }
+	    else {
+		rc = TSS_Policy_TemplateHash(policy, &digest);
+	    }
+	}
+    }
+    else {
+	printf("compileStatement: Unknown statement %s\n", statement);
+	rc = TSS_RC_BAD_PROPERTY_VALUE;
+    }
+    return rc;
+}
+
+/* compilePCR() extends 'pcr halg pcr[,pcr...] value ...'
+
+   The values are given in ascending PCR order, as the TPM digests them.
+*/
+
+static TPM_RC compilePCR(TSS_POLICY *policy,
+			 char **tokens,
+			 int tokenCount)
+{
+    TPM_RC		rc = 0;
+    TPML_PCR_SELECTION	pcrs;
+    TPM2B_DIGEST	pcrValues[IMPLEMENTATION_PCR];
+    uint32_t		selected = 0;
+    uint32_t		pcr;
+    uint32_t		v;
+    char		*token;
+
+    if (tokenCount < 4) {
+	rc = TSS_RC_BAD_PROPERTY_VALUE;
+    }
+    if (rc == 0) {
+	pcrs.count = 1;
+	pcrs.pcrSelections[0].sizeofSelect = IMPLEMENTATION_PCR / 8;
+	memset(pcrs.pcrSelections[0].pcrSelect, 0, sizeof(pcrs.pcrSelections[0].pcrSelect));
+	rc = parseHashAlg(&pcrs.pcrSelections[0].hash, tokens[1]);
+    }
+    for (token = strtok(tokens[2], ",") ; (rc == 0) && (token != NULL) ;
+	 token = strtok(NULL, ",")) {
+	rc = parseNumber(&pcr, IMPLEMENTATION_PCR - 1, token);
+	if (rc == 0) {
+	    if (pcrs.pcrSelections[0].pcrSelect[pcr / 8] & (1 << (pcr % 8))) {
+		printf("compilePCR: PCR %u selected twice\n", pcr);
+		rc = TSS_RC_BAD_PROPERTY_VALUE;
+	    }
+	    pcrs.pcrSelections[0].pcrSelect[pcr / 8] |= 1 << (pcr % 8);
+	    selected++;
+	}
+    }
+    if (rc == 0) {
+	if ((uint32_t)tokenCount != (selected + 3)) {
+	    printf("compilePCR: %u PCRs selected, %u values\n", selected, tokenCount - 3);
+	    rc = TSS_RC_BAD_PROPERTY_VALUE;
+	}
+    }
+    for (v = 0 ; (rc == 0) && (v < selected) ; v++) {
+	rc = parseBinary(pcrValues[v].t.buffer, &pcrValues[v].t.size,
+			 sizeof(pcrValues[v].t.buffer), tokens[v + 3]);
+	if ((rc == 0) &&
+	    (pcrValues[v].t.size != TSS_GetDigestSize(pcrs.pcrSelections[0].hash))) {
+	    printf("compilePCR: PCR value %u size %u invalid\n", v, pcrValues[v].t.size);
+	    rc = TSS_RC_BAD_DIGEST_SIZE;
+	}
+    }
+    if (rc == 0) {
+	rc = TSS_Policy_PCR(policy, &pcrs, pcrValues, selected);
+    }
+    return rc;
+}
+
+/* compileOR() extends 'or policy policy ...' */
+
+static TPM_RC compileOR(TSS_POLICY *policy,
+			const POLICY_TABLE *table,
+			char **tokens,
+			int tokenCount)
+{
+    TPM_RC		rc = 0;
+    TSS_POLICY		branches[8];
+    const POLICY_ENTRY	*entry;
+    int			b;
+
+    if ((tokenCount < 3) || (tokenCount > 9)) {
+	rc = TSS_RC_POLICY_OR_COUNT;
+    }
+    for (b = 1 ; (rc == 0) && (b < tokenCount) ; b++) {
+	entry = findPolicy(table, tokens[b]);
+	if (entry == NULL) {
+	    printf("compileOR: Policy %s not defined\n", tokens[b]);
+	    rc = TSS_RC_BAD_PROPERTY_VALUE;
+	}
+	else {
+	    branches[b-1] = entry->policy;
+	}
+    }
+    if (rc == 0) {
+	rc = TSS_Policy_OR(policy, branches, tokenCount - 1);
+    }
+    return rc;
+}
+
+/* emitPolicy() prints and/or writes the policy digests */
+
+static TPM_RC emitPolicy(const POLICY_ENTRY *entry,
+			 const char *outDirectory,
+			 int pr)
+{
+    TPM_RC		rc = 0;
+    uint32_t		i;
+    TPM2B_DIGEST	digest;
+
+    for (i = 0 ; (rc == 0) && (i < entry->policy.count) ; i++) {
+	TPMI_ALG_HASH hashAlg = entry->policy.digest[i].hashAlg;
+	rc = TSS_Policy_GetDigest(&digest, &entry->policy, hashAlg);
+	if ((rc == 0) && pr) {
+	    uint16_t b;
+	    printf("%s %s ", entry->name, hashAlgName(hashAlg));
+	    for (b = 0 ; b < digest.t.size ; b++) {
+		printf("%02x", digest.t.buffer[b]);
+	    }
+	    printf("\n");
+	}
+	if ((rc == 0) && (outDirectory != NULL)) {
+	    char filename[FILENAME_MAX];
+	    int len;
+	    if (entry->policy.count == 1) {
+		len = snprintf(filename, sizeof(filename), "%s/%s.bin",
+			       outDirectory, entry->name);
+	    }
+	    else {
+		len = snprintf(filename, sizeof(filename), "%s/%s-%s.bin",
+			       outDirectory, entry->name, hashAlgName(hashAlg));
+	    }
+	    if ((len < 0) || ((size_t)len >= sizeof(filename))) {
+		printf("emitPolicy: File name too long for %s\n", entry->name);
+		rc = TSS_RC_BAD_PROPERTY_VALUE;
+	    }
+	    if (rc == 0) {
+		rc = TSS_File_WriteBinaryFile(digest.t.buffer, digest.t.size, filename);
+	    }
+	}
+    }
+    return rc;
+}
+
+/* findPolicy() returns the earlier policy with name, or NULL */
+
+static const POLICY_ENTRY *findPolicy(const POLICY_TABLE *table,
+				      const char *name)
+{
+    size_t i;
+
+    for (i = 0 ; i < table->count ; i++) {
+	if (strcmp(table->entries[i].name, name) == 0) {
+	    return &table->entries[i];
+	}
+    }
+    return NULL;
+}
+
+/* addPolicy() adds a completed policy to the table, so later policies can reference it */
+
+static TPM_RC addPolicy(POLICY_TABLE *table,
+			const char *name,
+			const TSS_POLICY *policy)
+{
+    TPM_RC	rc = 0;
+
+    if (table->count == table->allocated) {
+	size_t allocated = (table->allocated == 0) ? 64 : (table->allocated * 2);
+	POLICY_ENTRY *entries = realloc(table->entries, allocated * sizeof(POLICY_ENTRY));
+	if (entries == NULL) {
+	    printf("addPolicy: Cannot allocate %lu policies\n", (unsigned long)allocated);
+	    rc = TSS_RC_OUT_OF_MEMORY;
+	}
+	else {
+	    table->entries = entries;
+	    table->allocated = allocated;
+	}
+    }
+    if (rc == 0) {
+	strcpy(table->entries[table->count].name, name);
+	table->entries[table->count].policy = *policy;
+	table->count++;
+    }
+    return rc;
+}
+
+/* parseBinary() converts a hexascii token, or the contents of the file @filename, to binary */
+
+static TPM_RC parseBinary(uint8_t *binary,
+			  uint16_t *length,
+			  size_t maxLength,
+			  const char *token)
+{
+    TPM_RC	rc = 0;
+    size_t	i;
+
+    if (token[0] == '@') {
+	unsigned char *data = NULL;	/* freed @1 */
+	size_t dataLength;
+	rc = TSS_File_ReadBinaryFile(&data, &dataLength, token + 1);
+	if ((rc == 0) && (dataLength > maxLength)) {
+	    printf("parseBinary: %s is larger than %lu bytes\n", token + 1,
+		   (unsigned long)maxLength);
+	    rc = TSS_RC_INSUFFICIENT_BUFFER;
+	}
+	if (rc == 0) {
+	    memcpy(binary, data, dataLength);
+	    *length = dataLength;
+	}
+	free(data);			/* @1 */
+	return rc;
+    }
+    if (((strlen(token) % 2) != 0) || ((strlen(token) / 2) > maxLength)) {
+	printf("parseBinary: Bad hexascii length %s\n", token);
+	rc = TSS_RC_BAD_PROPERTY_VALUE;
+    }
+    for (i = 0 ; (rc == 0) && (i < strlen(token) / 2) ; i++) {
+	unsigned int byte;
+	if ((sscanf(token + (i * 2), "%2x", &byte) != 1) ||
+	    !isxdigit((unsigned char)token[i * 2]) || !isxdigit((unsigned char)token[(i * 2) + 1])) {
+	    printf("parseBinary: Bad hexascii %s\n", token);
+	    rc = TSS_RC_BAD_PROPERTY_VALUE;
+	}
+	else {
+	    binary[i] = byte;
+	}
+    }
+    if (rc == 0) {
+	*length = strlen(token) / 2;
+    }
+    return rc;
+}
+
+/* parseNumber() converts a decimal or 0x prefixed hex token */
+
+static TPM_RC parseNumber(uint32_t *number,
+			  uint32_t maxNumber,
+			  const char *token)
+{
+    TPM_RC		rc = 0;
+    char		*end;
+    unsigned long	value;
+
+    errno = 0;
+    value = strtoul(token, &end, 0);
+    if ((errno != 0) || (*end != '\0') || (end == token) || (value > maxNumber)) {
+	printf("parseNumber: Bad number %s\n", token);
+	rc = TSS_RC_BAD_PROPERTY_VALUE;
+    }
+    else {
+	*number = value;
+    }
+    return rc;
+}
+
+static TPM_RC parseHashAlg(TPMI_ALG_HASH *hashAlg,
+			   const char *token)
+{
+    TPM_RC	rc = 0;
+
+    if (strcmp(token, "sha1") == 0) {
+	*hashAlg = TPM_ALG_SHA1;
+    }
+    else if (strcmp(token, "sha256") == 0) {
+	*hashAlg = TPM_ALG_SHA256;
+    }
+    else if (strcmp(token, "sha384") == 0) {
+	*hashAlg = TPM_ALG_SHA384;
+    }
+    else {
+	printf("parseHashAlg: Bad hash algorithm %s\n", token);
+	rc = TSS_RC_BAD_HASH_ALGORITHM;
+    }
+    return rc;
+}
+
+static const char *hashAlgName(TPMI_ALG_HASH hashAlg)
+{
+    switch (hashAlg) {
+      case TPM_ALG_SHA1:
+	return "sha1";
+      case TPM_ALG_SHA256:
+	return "sha256";
+      case TPM_ALG_SHA384:
+	return "sha384";
+      default:
+	return "unknown";
+    }
+}
+
+static void printUsage(void)
+{
+    printf("\n");
+    printf("policycompile\n");
+    printf("\n");
+    printf("Calculates policy digests from a policy description file\n");
+    printf("\n");
+    printf("\t-if policy description file name\n");
+    printf("\t[-halg hash algorithm (sha1 sha256 sha384) (default sha256)]\n");
+    printf("\t\tmay be specified more than once\n");
+    printf("\t[-od output directory for binary policy digests (default do not save)]\n");
+    printf("\t[-pr print policy digests]\n");
+    printf("\t[-v verbose trace]\n");
+    exit(1);	
+}
@@ -0,0 +1,626 @@
+/********************************************************************************/
+/*										*/
+/*			  Offline Quote Verification				*/
+/*		       IBM Thomas J. Watson Research Center			*/
+/*			     $Id: quoteverify.c $				*/
+/*										*/
+/* (c) Copyright IBM Corporation 2017.						*/
+/*										*/
+/* All rights reserved.								*/
+/* 										*/
+/* Redistribution and use in source and binary forms, with or without		*/
+/* modification, are permitted provided that the following conditions are	*/
+/* met:										*/
+/* 										*/
+/* Redistributions of source code must retain the above copyright notice,	*/
+/* this list of conditions and the following disclaimer.			*/
+/* 										*/
+/* Redistributions in binary form must reproduce the above copyright		*/
+/* notice, this list of conditions and the following disclaimer in the		*/
+/* documentation and/or other materials provided with the distribution.		*/
+/* 										*/
+/* Neither the names of the IBM Corporation nor the names of its		*/
+/* contributors may be used to endorse or promote products derived from		*/
+/* this software without specific prior written permission.			*/
+/* 										*/
+/* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS		*/
+/* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT		*/
+/* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR	*/
+/* A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT		*/
+/* HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,	*/
+/* SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT		*/
+/* LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,	*/
+/* DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY	*/
+/* THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT		*/
+/* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE	*/
+/* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.		*/
+/********************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#ifdef TPM_POSIX
+#include <pthread.h>
+#endif
+
+#include <openssl/evp.h>
+
+#include <tss2/tss.h>
+#include <tss2/tssutils.h>
+#include <tss2/tssmarshal.h>
+#include <tss2/Unmarshal_fp.h>
+#include <tss2/tsscryptoh.h>
+#include <tss2/tsscrypto.h>
+#include <tss2/tsserror.h>
+
+#include "cryptoutils.h"
+#include "quoteverify.h"
+
+#ifdef TPM_POSIX
+
+/* The worker pool threads are created once by QUOTE_Verifier_Init().  A batch is posted under the
+   mutex, and each thread, including the caller of QUOTE_Verify_Batch(), claims the next job until
+   the batch is exhausted. */
+
+typedef struct QUOTE_POOL {
+    pthread_mutex_t		mutex;
+    pthread_cond_t		start;		/* signaled when a batch is posted or at shutdown */
+    pthread_cond_t		done;		/* signaled when the last job completes */
+    pthread_t			*threads;
+    unsigned int		threadCount;	/* threads successfully created */
+    const QUOTE_VERIFIER	*verifier;
+    QUOTE_JOB			*jobs;
+    size_t			count;		/* jobs in the batch */
+    size_t			next;		/* next job to claim */
+    size_t			remaining;	/* jobs not yet complete */
+    int				shutdown;
+} QUOTE_POOL;
+
+#endif
+
+/* local prototypes */
+
+static int QUOTE_Name_Compare(const TPM2B_NAME *a,
+			      const TPM2B_NAME *b);
+static const QUOTE_KEY *QUOTE_Key_Find(const QUOTE_VERIFIER *verifier,
+				       const TPM2B_NAME *name,
+				       size_t *index);
+static TPM_RC QUOTE_Name_Calculate(TPM2B_NAME *name,
+				   const TPMT_PUBLIC *publicArea);
+static TPM_RC QUOTE_Verify_Signature(const QUOTE_KEY *quoteKey,
+				     const TPM2B_ATTEST *quoted,
+				     const TPMT_SIGNATURE *signature);
+#ifdef TPM_POSIX
+static TPM_RC QUOTE_Pool_Create(QUOTE_VERIFIER *verifier);
+static void QUOTE_Pool_Delete(QUOTE_VERIFIER *verifier);
+static void QUOTE_Pool_Run(QUOTE_POOL *pool);
+static void *QUOTE_Pool_Worker(void *arg);
+#endif
+
+/* QUOTE_Verifier_Init() initializes an empty key cache and starts 'workers' threads.
+
+   If workers is 0, or threads are not supported on the platform, QUOTE_Verify_Batch() verifies
+   inline.
+*/
+
+TPM_RC QUOTE_Verifier_Init(QUOTE_VERIFIER *verifier,
+			   unsigned int workers)
+{
+    TPM_RC	rc = 0;
+
+    verifier->keys = NULL;
+    verifier->keyCount = 0;
+    verifier->keyAllocated = 0;
+    verifier->workers = workers;
+    verifier->pool = NULL;
+#ifdef TPM_POSIX
+    if ((rc == 0) && (workers > 0)) {
+	rc = QUOTE_Pool_Create(verifier);
+    }
+#endif
+    return rc;
+}
+
+/* QUOTE_Verifier_Delete() stops the worker threads and frees the key cache */
+
+void QUOTE_Verifier_Delete(QUOTE_VERIFIER *verifier)
+{
+    size_t i;
+
+#ifdef TPM_POSIX
+    QUOTE_Pool_Delete(verifier);
+#endif
+    for (i = 0 ; i < verifier->keyCount ; i++) {
+	EVP_PKEY_free(verifier->keys[i].evpPkey);
+    }
+    free(verifier->keys);
+    verifier->keys = NULL;
+    verifier->keyCount = 0;
+    verifier->keyAllocated = 0;
+    return;
+}
+
+/* QUOTE_Verifier_AddKey() calculates the Name of the attestation key public area, converts the
+   public key to an OpenSSL key, and adds it to the cache.
+
+   If name is not NULL, the Name is returned.  Adding a key that is already cached is not an
+   error.
+
+   Only RSA keys and ECC NIST P-256 keys are supported.
+*/
+
+TPM_RC QUOTE_Verifier_AddKey(QUOTE_VERIFIER *verifier,
+			     TPM2B_NAME *name,
+			     const TPMT_PUBLIC *publicArea)
+{
+    TPM_RC	rc = 0;
+    TPM2B_NAME	akName;
+    size_t	index = 0;
+    int		found = FALSE;
+    EVP_PKEY	*evpPkey = NULL;
+
+    if (rc == 0) {
+	rc = QUOTE_Name_Calculate(&akName, publicArea);
+    }
+    if (rc == 0) {
+	found = (QUOTE_Key_Find(verifier, &akName, &index) != NULL);
+    }
+    /* parse the public key once, rather than at each verification */
+    if ((rc == 0) && !found) {
+	switch (publicArea->type) {
+	  case TPM_ALG_RSA:
+	    rc = convertRsaPublicToEvpPubKey(&evpPkey,		/* freed @1 */
+					     &publicArea->unique.rsa);
+	    break;
+	  case TPM_ALG_ECC:
+	    if (publicArea->parameters.eccDetail.curveID != TPM_ECC_NIST_P256) {
+		printf("QUOTE_Verifier_AddKey: Unsupported curve %04x\n",
+		       publicArea->parameters.eccDetail.curveID);
+		rc = TSS_RC_BAD_SIGNATURE_ALGORITHM;
+	    }
+	    else {
+		rc = convertEcPublicToEvpPubKey(&evpPkey,	/* freed @1 */
+						&publicArea->unique.ecc);
+	    }
+	    break;
+	  default:
+	    printf("QUOTE_Verifier_AddKey: Unsupported key type %04x\n", publicArea->type);
+	    rc = TSS_RC_BAD_SIGNATURE_ALGORITHM;
+	    break;
+	}
+    }
+    /* grow the cache */
+    if ((rc == 0) && !found && (verifier->keyCount == verifier->keyAllocated)) {
+	size_t allocated = (verifier->keyAllocated == 0) ? 16 : (verifier->keyAllocated * 2);
+	QUOTE_KEY *keys = realloc(verifier->keys, allocated * sizeof(QUOTE_KEY));
+	if (keys == NULL) {
+	    printf("QUOTE_Verifier_AddKey: Error allocating %lu keys\n",
+		   (unsigned long)allocated);
+	    rc = TSS_RC_OUT_OF_MEMORY;
+	}
+	else {
+	    verifier->keys = keys;
+	    verifier->keyAllocated = allocated;
+	}
+    }
+    /* insert in Name order */
+    if ((rc == 0) && !found) {
+	memmove(&verifier->keys[index + 1], &verifier->keys[index],
+		(verifier->keyCount - index) * sizeof(QUOTE_KEY));
+	verifier->keys[index].name = akName;
+	verifier->keys[index].type = publicArea->type;
+	verifier->keys[index].evpPkey = evpPkey;	/* freed by QUOTE_Verifier_Delete() */
+	verifier->keyCount++;
+	evpPkey = NULL;
+    }
+    if ((rc == 0) && (name != NULL)) {
+	*name = akName;
+    }
+    if (evpPkey != NULL) {
+	EVP_PKEY_free(evpPkey);		/* @1 */
+    }
+    return rc;
+}
+
+/* QUOTE_Verify() verifies one quote.  The result is also returned in job->rc.
+
+   It checks:
+
+   - the AK is in the cache
+   - the attestation structure unmarshals, was generated by a TPM, and is a quote
+   - extraData is the qualifyingData, if supplied
+   - the signature over the attestation structure
+   - pcrDigest is the digest of the selected PCR values in banks, if supplied
+
+   It does not modify the verifier, so any number of threads can call it concurrently.
+*/
+
+TPM_RC QUOTE_Verify(const QUOTE_VERIFIER *verifier,
+		    QUOTE_JOB *job)
+{
+    TPM_RC		rc = 0;
+    const QUOTE_KEY	*quoteKey = NULL;
+
+    if (rc == 0) {
+	quoteKey = QUOTE_Key_Find(verifier, job->akName, NULL);
+	if (quoteKey == NULL) {
+	    rc = TSS_RC_NO_KEY;
+	}
+    }
+    /* unmarshal the attestation structure */
+    if (rc == 0) {
+	uint8_t *buffer = (uint8_t *)job->quoted->t.attestationData;
+	INT32 size = job->quoted->t.size;
+	rc = TPMS_ATTEST_Unmarshal(&job->attest, &buffer, &size);
+	if ((rc == 0) && (size != 0)) {
+	    rc = TSS_RC_BAD_ATTEST;
+	}
+    }
+    if (rc == 0) {
+	if ((job->attest.magic != TPM_GENERATED_VALUE) ||
+	    (job->attest.type != TPM_ST_ATTEST_QUOTE)) {
+	    rc = TSS_RC_BAD_ATTEST;
+	}
+    }
+    /* the nonce proves freshness */
+    if ((rc == 0) && (job->qualifyingData != NULL)) {
+	if ((job->attest.extraData.t.size != job->qualifyingData->t.size) ||
+	    (memcmp(job->attest.extraData.t.buffer, job->qualifyingData->t.buffer,
+		    job->qualifyingData->t.size) != 0)) {
+	    rc = TSS_RC_BAD_NONCE;
+	}
+    }
+    if (rc == 0) {
+	rc = QUOTE_Verify_Signature(quoteKey, job->quoted, job->signature);
+    }
+    /* the TPM digests the selected PCRs with the signing scheme hash algorithm */
+    if ((rc == 0) && (job->banks != NULL)) {
+	TPMT_HA pcrDigest;
+	const TPM2B_DIGEST *quoteDigest = &job->attest.attested.quote.pcrDigest;
+	pcrDigest.hashAlg = job->signature->signature.any.hashAlg;
+	rc = QUOTE_PcrDigest(&pcrDigest, &job->attest.attested.quote.pcrSelect, job->banks);
+	if (rc == 0) {
+	    if ((quoteDigest->t.size != TSS_GetDigestSize(pcrDigest.hashAlg)) ||
+		(memcmp(quoteDigest->t.buffer, (uint8_t *)&pcrDigest.digest,
+			quoteDigest->t.size) != 0)) {
+		rc = TSS_RC_PCR_DIGEST;
+	    }
+	}
+    }
+    job->rc = rc;
+    return rc;
+}
+
+/* QUOTE_Verify_Batch() verifies 'count' quotes across the worker pool.
+
+   The per quote results are in each job's rc.  The function returns non-zero only if the batch
+   could not be run.
+*/
+
+TPM_RC QUOTE_Verify_Batch(QUOTE_VERIFIER *verifier,
+			  QUOTE_JOB *jobs,
+			  size_t count)
+{
+    TPM_RC	rc = 0;
+    size_t	i;
+
+#ifdef TPM_POSIX
+    if (verifier->pool != NULL) {
+	QUOTE_POOL *pool = verifier->pool;
+	pthread_mutex_lock(&pool->mutex);
+	pool->verifier = verifier;
+	pool->jobs = jobs;
+	pool->count = count;
+	pool->next = 0;
+	pool->remaining = count;
+	pthread_cond_broadcast(&pool->start);
+	/* the caller works too, then waits for jobs claimed by other threads */
+	QUOTE_Pool_Run(pool);
+	while (pool->remaining > 0) {
+	    pthread_cond_wait(&pool->done, &pool->mutex);
+	}
+	pool->jobs = NULL;
+	pool->count = 0;
+	pool->next = 0;
+	pthread_mutex_unlock(&pool->mutex);
+	return rc;
+    }
+#endif
+    for (i = 0 ; i < count ; i++) {
+	QUOTE_Verify(verifier, &jobs[i]);
+    }
+    return rc;
+}
+
+/* QUOTE_PcrDigest() calculates the digest of the PCR values selected by pcrSelect, as the TPM does
+   for a quote.
+
+   On call, digest->hashAlg is the digest algorithm.  PCRs are digested in selection order, and in
+   ascending PCR order within a selection.
+*/
+
+TPM_RC QUOTE_PcrDigest(TPMT_HA *digest,
+		       const TPML_PCR_SELECTION *pcrSelect,
+		       const TSS_EVENT2_PCR_BANKS *banks)
+{
+    TPM_RC	rc = 0;
+    void	*hashContext = NULL;	/* freed @1 */
+    uint32_t	s;			/* iterator through selections */
+    uint32_t	b;			/* iterator through PCR banks */
+    uint32_t	pcr;
+
+    if (rc == 0) {
+	rc = TSS_Hash_Start(&hashContext, digest->hashAlg);	/* freed @1 */
+    }
+    for (s = 0 ; (rc == 0) && (s < pcrSelect->count) ; s++) {
+	const TPMS_PCR_SELECTION *selection = &pcrSelect->pcrSelections[s];
+	for (b = 0 ; b < banks->bankCount ; b++) {
+	    if (banks->pcrs[b][0].hashAlg == selection->hash) {
+		break;
+	    }
+	}
+	if (b == banks->bankCount) {
+	    printf("QUOTE_PcrDigest: No PCR bank for algorithm %04x\n", selection->hash);
+	    rc = TSS_RC_BAD_HASH_ALGORITHM;
+	}
+	for (pcr = 0 ; (rc == 0) && (pcr < (uint32_t)selection->sizeofSelect * 8) ; pcr++) {
+	    if ((selection->pcrSelect[pcr / 8] & (1 << (pcr % 8))) == 0) {
+		continue;
+	    }
+	    if (pcr >= IMPLEMENTATION_PCR) {
+		printf("QUOTE_PcrDigest: PCR %u out of range\n", pcr);
+		rc = TSS_RC_BAD_PROPERTY_VALUE;
+	    }
+	    else {
+		rc = TSS_Hash_Update(hashContext,
+				     (uint8_t *)&banks->pcrs[b][pcr].digest,
+				     banks->digestSize[b]);
+	    }
+	}
+    }
+    /* TSS_Hash_Finish() frees the context even on error */
+    if (hashContext != NULL) {
+	TPM_RC rc1 = TSS_Hash_Finish((rc == 0) ? digest : NULL, &hashContext);	/* @1 */
+	if (rc == 0) {
+	    rc = rc1;
+	}
+    }
+    return rc;
+}
+
+/* QUOTE_Name_Compare() orders Names by size, then contents */
+
+static int QUOTE_Name_Compare(const TPM2B_NAME *a,
+			      const TPM2B_NAME *b)
+{
+    if (a->t.size != b->t.size) {
+	return (a->t.size < b->t.size) ? -1 : 1;
+    }
+    return memcmp(a->t.name, b->t.name, a->t.size);
+}
+
+/* QUOTE_Key_Find() binary searches the key cache for name.
+
+   Returns the key, or NULL if not found.  If index is not NULL, it returns the position of the key
+   or the insertion point.
+*/
+
+static const QUOTE_KEY *QUOTE_Key_Find(const QUOTE_VERIFIER *verifier,
+				       const TPM2B_NAME *name,
+				       size_t *index)
+{
+    size_t low = 0;
+    size_t high = verifier->keyCount;
+
+    while (low < high) {
+	size_t mid = low + ((high - low) / 2);
+	int cmp = QUOTE_Name_Compare(&verifier->keys[mid].name, name);
+	if (cmp == 0) {
+	    if (index != NULL) {
+		*index = mid;
+	    }
+	    return &verifier->keys[mid];
+	}
+	if (cmp < 0) {
+	    low = mid + 1;
+	}
+	else {
+	    high = mid;
+	}
+    }
+    if (index != NULL) {
+	*index = low;
+    }
+    return NULL;
+}
+
+/* QUOTE_Name_Calculate() calculates the Name of the public area, the nameAlg followed by the digest
+   of the marshaled TPMT_PUBLIC. */
+
+static TPM_RC QUOTE_Name_Calculate(TPM2B_NAME *name,
+				   const TPMT_PUBLIC *publicArea)
+{
+    TPM_RC 	rc = 0;
+    uint16_t 	written = 0;
+    uint8_t 	buffer[sizeof(TPMT_PUBLIC)];
+    TPMT_HA	digest;
+    uint16_t	digestSize = 0;
+
+    if (rc == 0) {
+	INT32 size = sizeof(buffer);
+	uint8_t *buffer1 = buffer;
+	rc = TSS_TPMT_PUBLIC_Marshal(publicArea, &written, &buffer1, &size);
+    }
+    if (rc == 0) {
+	digest.hashAlg = publicArea->nameAlg;
+	digestSize = TSS_GetDigestSize(publicArea->nameAlg);
+	if (digestSize == 0) {
+	    rc = TSS_RC_BAD_HASH_ALGORITHM;
+	}
+    }
+    if (rc == 0) {
+	rc = TSS_Hash_Generate(&digest,
+			       written, buffer,
+			       0, NULL);
+    }
+    if (rc == 0) {
+	uint8_t *buffer1 = name->t.name;
+	INT32 size = sizeof(TPMI_ALG_HASH);
+	name->t.size = 0;
+	rc = TSS_TPMI_ALG_HASH_Marshal(&publicArea->nameAlg, &name->t.size, &buffer1, &size);
+    }
+    if (rc == 0) {
+	memcpy(name->t.name + name->t.size, (uint8_t *)&digest.digest, digestSize);
+	name->t.size += digestSize;
+    }
+    return rc;
+}
+
+/* QUOTE_Verify_Signature() verifies the signature over the marshaled attestation structure using
+   the cached OpenSSL key.
+
+   Only RSASSA and ECDSA signatures are supported.
+*/
+
+static TPM_RC QUOTE_Verify_Signature(const QUOTE_KEY *quoteKey,
+				     const TPM2B_ATTEST *quoted,
+				     const TPMT_SIGNATURE *signature)
+{
+    TPM_RC 	rc = 0;
+    TPMT_HA	digest;
+
+    if (rc == 0) {
+	if (((quoteKey->type == TPM_ALG_RSA) && (signature->sigAlg != TPM_ALG_RSASSA)) ||
+	    ((quoteKey->type == TPM_ALG_ECC) && (signature->sigAlg != TPM_ALG_ECDSA))) {
+	    rc = TSS_RC_BAD_SIGNATURE_ALGORITHM;
+	}
+    }
+    if (rc == 0) {
+	digest.hashAlg = signature->signature.any.hashAlg;
+	rc = TSS_Hash_Generate(&digest,
+			       quoted->t.size, quoted->t.attestationData,
+			       0, NULL);
+    }
+    if (rc == 0) {
+	if (quoteKey->type == TPM_ALG_RSA) {
+	    rc = verifyRSASignatureFromEvpPubKey((uint8_t *)&digest.digest,
+						 TSS_GetDigestSize(digest.hashAlg),
+						 (TPMT_SIGNATURE *)signature,
+						 digest.hashAlg,
+						 quoteKey->evpPkey);
+	}
+	else {
+	    rc = verifyEcSignatureFromEvpPubKey((uint8_t *)&digest.digest,
+						TSS_GetDigestSize(digest.hashAlg),
+						(TPMT_SIGNATURE *)signature,
+						quoteKey->evpPkey);
+	}
+    }
+    return rc;
+}
+
+#ifdef TPM_POSIX
+
+/* QUOTE_Pool_Create() starts verifier->workers threads.  If some threads cannot be created, the
+   pool runs with fewer. */
+
+static TPM_RC QUOTE_Pool_Create(QUOTE_VERIFIER *verifier)
+{
+    TPM_RC 	rc = 0;
+    QUOTE_POOL	*pool = NULL;
+    unsigned int i;
+
+    if (rc == 0) {
+	pool = calloc(1, sizeof(QUOTE_POOL));
+	if (pool != NULL) {
+	    pool->threads = calloc(verifier->workers, sizeof(pthread_t));
+	}
+	if ((pool == NULL) || (pool->threads == NULL)) {
+	    printf("QUOTE_Pool_Create: Error allocating %u workers\n", verifier->workers);
+	    if (pool != NULL) {
+		free(pool);
+	    }
+	    rc = TSS_RC_OUT_OF_MEMORY;
+	}
+    }
+    if (rc == 0) {
+	pthread_mutex_init(&pool->mutex, NULL);
+	pthread_cond_init(&pool->start, NULL);
+	pthread_cond_init(&pool->done, NULL);
+	verifier->pool = pool;
+	for (i = 0 ; i < verifier->workers ; i++) {
+	    if (pthread_create(&pool->threads[i], NULL, QUOTE_Pool_Worker, pool) != 0) {
+		printf("QUOTE_Pool_Create: Created %u of %u workers\n", i, verifier->workers);
+		break;
+	    }
+	    pool->threadCount++;
+	}
+    }
+    return rc;
+}
+
+/* QUOTE_Pool_Delete() signals the workers to exit and joins them */
+
+static void QUOTE_Pool_Delete(QUOTE_VERIFIER *verifier)
+{
+    QUOTE_POOL	*pool = verifier->pool;
+    unsigned int i;
+
+    if (pool == NULL) {
+	return;
+    }
+    pthread_mutex_lock(&pool->mutex);
+    pool->shutdown = TRUE;
+    pthread_cond_broadcast(&pool->start);
+    pthread_mutex_unlock(&pool->mutex);
+    for (i = 0 ; i < pool->threadCount ; i++) {
+	pthread_join(pool->threads[i], NULL);
+    }
+    pthread_cond_destroy(&pool->done);
+    pthread_cond_destroy(&pool->start);
+    pthread_mutex_destroy(&pool->mutex);
+    free(pool->threads);
+    free(pool);
+    verifier->pool = NULL;
+    return;
+}
+
+/* QUOTE_Pool_Run() claims and verifies jobs until the batch is exhausted.
+
+   It is called and returns with the mutex held.  The mutex is released while verifying.
+*/
+
+static void QUOTE_Pool_Run(QUOTE_POOL *pool)
+{
+    while (pool->next < pool->count) {
+	QUOTE_JOB *job = &pool->jobs[pool->next];
+	pool->next++;
+	pthread_mutex_unlock(&pool->mutex);
+	QUOTE_Verify(pool->verifier, job);
+	pthread_mutex_lock(&pool->mutex);
+	pool->remaining--;
+	if (pool->remaining == 0) {
+	    pthread_cond_signal(&pool->done);
+	}
+    }
+    return;
+}
+
+/* QUOTE_Pool_Worker() is the worker thread main loop */
+
+static void *QUOTE_Pool_Worker(void *arg)
+{
+    QUOTE_POOL *pool = arg;
+
+    pthread_mutex_lock(&pool->mutex);
+    while (!pool->shutdown) {
+	QUOTE_Pool_Run(pool);
+	pthread_cond_wait(&pool->start, &pool->mutex);
+    }
+    pthread_mutex_unlock(&pool->mutex);
+    return NULL;
+}
+
+#endif
@@ -0,0 +1,116 @@
+/********************************************************************************/
+/*										*/
+/*			  Offline Quote Verification				*/
+/*		       IBM Thomas J. Watson Research Center			*/
+/*			     $Id: quoteverify.h $				*/
+/*										*/
+/* (c) Copyright IBM Corporation 2017.						*/
+/*										*/
+/* All rights reserved.								*/
+/* 										*/
+/* Redistribution and use in source and binary forms, with or without		*/
+/* modification, are permitted provided that the following conditions are	*/
+/* met:										*/
+/* 										*/
+/* Redistributions of source code must retain the above copyright notice,	*/
+/* this list of conditions and the following disclaimer.			*/
+/* 										*/
+/* Redistributions in binary form must reproduce the above copyright		*/
+/* notice, this list of conditions and the following disclaimer in the		*/
+/* documentation and/or other materials provided with the distribution.		*/
+/* 										*/
+/* Neither the names of the IBM Corporation nor the names of its		*/
+/* contributors may be used to endorse or promote products derived from		*/
+/* this software without specific prior written permission.			*/
+/* 										*/
+/* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS		*/
+/* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT		*/
+/* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR	*/
+/* A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT		*/
+/* HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,	*/
+/* SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT		*/
+/* LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,	*/
+/* DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY	*/
+/* THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT		*/
+/* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE	*/
+/* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.		*/
+/********************************************************************************/
+
+/* The quote verifier checks TPM2_Quote results offline, typically at an attestation server that
+   receives many quotes from many clients.
+
+   Attestation key public areas are parsed once into OpenSSL keys and cached by Name.  A quote
+   job is the attestation blob, its signature, the AK Name, and optionally the nonce and the PCR
+   values replayed from the event log.  A batch of jobs is spread across a worker pool.
+
+   The key cache is not locked.  Add all keys before QUOTE_Verify_Batch(), and do not add keys
+   while a batch is running.
+*/
+
+#ifndef QUOTEVERIFY_H
+#define QUOTEVERIFY_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <openssl/evp.h>
+
+#include <tss2/TPM_Types.h>
+
+#include "eventlib.h"
+
+/* parsed attestation key, cached by Name */
+
+typedef struct QUOTE_KEY {
+    TPM2B_NAME		name;
+    TPMI_ALG_PUBLIC	type;		/* TPM_ALG_RSA or TPM_ALG_ECC */
+    EVP_PKEY		*evpPkey;
+} QUOTE_KEY;
+
+typedef struct QUOTE_VERIFIER {
+    QUOTE_KEY		*keys;		/* sorted by Name */
+    size_t		keyCount;
+    size_t		keyAllocated;
+    unsigned int	workers;	/* number of worker threads, 0 verifies inline */
+    void		*pool;		/* worker pool, opaque */
+} QUOTE_VERIFIER;
+
+/* one quote to verify.  The inputs are not copied, and must remain valid until the job
+   completes. */
+
+typedef struct QUOTE_JOB {
+    /* input */
+    const TPM2B_NAME		*akName;	/* Name of the signing key */
+    const TPM2B_ATTEST		*quoted;	/* marshaled TPMS_ATTEST */
+    const TPMT_SIGNATURE	*signature;	/* signature over quoted */
+    const TPM2B_DATA		*qualifyingData;/* expected extraData, NULL to skip the check */
+    const TSS_EVENT2_PCR_BANKS	*banks;		/* expected PCR values, NULL to skip the check */
+    /* output */
+    TPM_RC			rc;		/* 0 if all checks passed */
+    TPMS_ATTEST			attest;		/* unmarshaled quoted */
+} QUOTE_JOB;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+    TPM_RC QUOTE_Verifier_Init(QUOTE_VERIFIER *verifier,
+			       unsigned int workers);
+    void QUOTE_Verifier_Delete(QUOTE_VERIFIER *verifier);
+    TPM_RC QUOTE_Verifier_AddKey(QUOTE_VERIFIER *verifier,
+				 TPM2B_NAME *name,
+				 const TPMT_PUBLIC *publicArea);
+    TPM_RC QUOTE_Verify(const QUOTE_VERIFIER *verifier,
+			QUOTE_JOB *job);
+    TPM_RC QUOTE_Verify_Batch(QUOTE_VERIFIER *verifier,
+			      QUOTE_JOB *jobs,
+			      size_t count);
+    TPM_RC QUOTE_PcrDigest(TPMT_HA *digest,
+			   const TPML_PCR_SELECTION *pcrSelect,
+			   const TSS_EVENT2_PCR_BANKS *banks);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
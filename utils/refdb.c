@@ -0,0 +1,482 @@
+/********************************************************************************/
+/*										*/
+/*			Reference Digest Database Tool				*/
+/*		       IBM Thomas J. Watson Research Center			*/
+/*				$Id: refdb.c $					*/
+/*										*/
+/* (c) Copyright IBM Corporation 2017.						*/
+/*										*/
+/* All rights reserved.								*/
+/* 										*/
+/* Redistribution and use in source and binary forms, with or without		*/
+/* modification, are permitted provided that the following conditions are	*/
+/* met:										*/
+/* 										*/
+/* Redistributions of source code must retain the above copyright notice,	*/
+/* this list of conditions and the following disclaimer.			*/
+/* 										*/
+/* Redistributions in binary form must reproduce the above copyright		*/
+/* notice, this list of conditions and the following disclaimer in the		*/
+/* documentation and/or other materials provided with the distribution.		*/
+/* 										*/
+/* Neither the names of the IBM Corporation nor the names of its		*/
+/* contributors may be used to endorse or promote products derived from		*/
+/* this software without specific prior written permission.			*/
+/* 										*/
+/* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS		*/
+/* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT		*/
+/* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR	*/
+/* A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT		*/
+/* HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,	*/
+/* SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT		*/
+/* LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,	*/
+/* DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY	*/
+/* THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT		*/
+/* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE	*/
+/* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.		*/
+/********************************************************************************/
+
+
+/* refdb is test/demo code.  It builds a reference digest database from a list of known good
+   digests, appraises an IMA event log against the database, and benchmarks lookups.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <time.h>
+
+#include <tss2/tss.h>
+#include <tss2/tssutils.h>
+#include <tss2/tsscryptoh.h>
+#include <tss2/tsscrypto.h>
+#include <tss2/tssresponsecode.h>
+
+#include "imalib.h"
+#include "refdblib.h"
+
+/* local prototypes */
+
+static void printUsage(void);
+static TPM_RC readDigestList(uint8_t **digests,
+			     uint32_t *count,
+			     uint32_t *allocated,
+			     uint16_t digestSize,
+			     const char *filename);
+static TPM_RC addRandomDigests(uint8_t **digests,
+			       uint32_t *count,
+			       uint32_t *allocated,
+			       uint16_t digestSize,
+			       uint32_t number);
+static TPM_RC growDigests(uint8_t **digests,
+			  uint32_t *allocated,
+			  uint16_t digestSize,
+			  uint32_t needed);
+static TPM_RC appraiseIma(const REFDB *refdb,
+			  const char *filename,
+			  int littleEndian);
+static TPM_RC benchmark(const REFDB *refdb,
+			uint32_t lookups);
+
+int verbose = FALSE;
+int vverbose = FALSE;
+
+int main(int argc, char * argv[])
+{
+    TPM_RC 			rc = 0;
+    int 			i = 0;
+    const char 			*listFilename = NULL;
+    const char 			*dbFilename = NULL;
+    const char 			*imaFilename = NULL;
+    int 			littleEndian = FALSE;
+    TPMI_ALG_HASH		halg = TPM_ALG_SHA256;
+    unsigned int		generate = 0;
+    unsigned int		lookups = 0;
+    int				build;
+    uint16_t			digestSize;
+    uint8_t			*digests = NULL;	/* freed @1 */
+    uint32_t			count = 0;
+    uint32_t			allocated = 0;
+    REFDB			refdb;
+	
+    setvbuf(stdout, 0, _IONBF, 0);      /* output may be going through pipe to log file */
+    TSS_SetProperty(NULL, TPM_TRACE_LEVEL, "1");
+    refdb.base = NULL;
+
+    for (i=1 ; i<argc ; i++) {
+	if (strcmp(argv[i],"-if") == 0) {
+	    i++;
+	    if (i < argc) {
+		listFilename = argv[i];
+	    }
+	    else {
+		printf("-if option needs a value\n");
+		printUsage();
+	    }
+	}
+	else if (strcmp(argv[i],"-db") == 0) {
+	    i++;
+	    if (i < argc) {
+		dbFilename = argv[i];
+	    }
+	    else {
+		printf("-db option needs a value\n");
+		printUsage();
+	    }
+	}
+	else if (strcmp(argv[i],"-ima") == 0) {
+	    i++;
+	    if (i < argc) {
+		imaFilename = argv[i];
+	    }
+	    else {
+		printf("-ima option needs a value\n");
+		printUsage();
+	    }
+	}
+	else if (strcmp(argv[i],"-le") == 0) {
+	    littleEndian = TRUE; 
+	}
+	else if (strcmp(argv[i],"-halg") == 0) {
+	    i++;
+	    if (i < argc) {
+		if (strcmp(argv[i],"sha1") == 0) {
+		    halg = TPM_ALG_SHA1;
+		}
+		else if (strcmp(argv[i],"sha256") == 0) {
+		    halg = TPM_ALG_SHA256;
+		}
+		else if (strcmp(argv[i],"sha384") == 0) {
+		    halg = TPM_ALG_SHA384;
+		}
+		else {
+		    printf("Bad parameter %s for -halg\n", argv[i]);
+		    printUsage();
+		}
+	    }
+	    else {
+		printf("-halg option needs a value\n");
+		printUsage();
+	    }
+	}
+	else if (strcmp(argv[i],"-gen") == 0) {
+	    i++;
+	    if (i < argc) {
+		sscanf(argv[i],"%u", &generate);
+	    }
+	    else {
+		printf("Missing parameter for -gen\n");
+		printUsage();
+	    }
+	}
+	else if (strcmp(argv[i],"-bench") == 0) {
+	    i++;
+	    if (i < argc) {
+		sscanf(argv[i],"%u", &lookups);
+	    }
+	    else {
+		printf("Missing parameter for -bench\n");
+		printUsage();
+	    }
+	}
+	else if (!strcmp(argv[i], "-h")) {
+	    printUsage();
+	}
+	else if (!strcmp(argv[i], "-v")) {
+	    verbose = TRUE;
+	    TSS_SetProperty(NULL, TPM_TRACE_LEVEL, "2");
+	}
+	else {
+	    printf("\n%s is not a valid option\n", argv[i]);
+	    printUsage();
+	}
+    }
+    if (dbFilename == NULL) {
+	printf("Missing -db argument\n");
+	printUsage();
+    }
+    build = (listFilename != NULL) || (generate != 0);
+    if (!build && (imaFilename == NULL) && (lookups == 0)) {
+	printf("Nothing to do, specify -if, -gen, -ima, or -bench\n");
+	printUsage();
+    }
+    digestSize = TSS_GetDigestSize(halg);
+    /* build the database from the digest list and random digests */
+    if ((rc == 0) && (listFilename != NULL)) {
+	rc = readDigestList(&digests, &count, &allocated, digestSize,	/* freed @1 */
+			    listFilename);
+    }
+    if ((rc == 0) && (generate != 0)) {
+	rc = addRandomDigests(&digests, &count, &allocated, digestSize,
+			      generate);
+    }
+    if ((rc == 0) && build) {
+	clock_t startTime = clock();
+	rc = REFDB_Build(dbFilename, halg, digests, &count);
+	if ((rc == 0) && verbose) {
+	    printf("refdb: built %u unique digests in %f seconds\n",
+		   count, (double)(clock() - startTime) / CLOCKS_PER_SEC);
+	}
+    }
+    free(digests);	/* @1 */
+    digests = NULL;
+    if ((rc == 0) && ((imaFilename != NULL) || (lookups != 0))) {
+	rc = REFDB_Open(&refdb, dbFilename);
+    }
+    if ((rc == 0) && (imaFilename != NULL)) {
+	rc = appraiseIma(&refdb, imaFilename, littleEndian);
+    }
+    if ((rc == 0) && (lookups != 0)) {
+	rc = benchmark(&refdb, lookups);
+    }
+    REFDB_Close(&refdb);
+    if (rc == 0) {
+	if (verbose) printf("refdb: success\n");
+    }
+    else {
+	const char *msg;
+	const char *submsg;
+	const char *num;
+	printf("refdb: failed, rc %08x\n", rc);
+	TSS_ResponseCode_toString(&msg, &submsg, &num, rc);
+	printf("%s%s%s\n", msg, submsg, num);
+	rc = EXIT_FAILURE;
+    }
+    return rc;
+}
+
+/* readDigestList() appends the digests in a text file.  Each line starts with the hexascii digest,
+   optionally followed by white space and a file name, as output by sha256sum.  Blank lines and
+   lines starting with # are skipped.
+*/
+
+static TPM_RC readDigestList(uint8_t **digests,
+			     uint32_t *count,
+			     uint32_t *allocated,
+			     uint16_t digestSize,
+			     const char *filename)
+{
+    TPM_RC 	rc = 0;
+    FILE	*file = NULL;		/* closed @1 */
+    char	line[4096];
+    unsigned int lineNum;
+    uint16_t	i;
+    
+    if (rc == 0) {
+	rc = TSS_File_Open(&file, filename, "r");	/* closed @1 */
+    }
+    for (lineNum = 1 ; (rc == 0) && (fgets(line, sizeof(line), file) != NULL) ; lineNum++) {
+	uint8_t *digest;
+	char *p = line;
+	if ((*p == '#') || (*p == '\n') || (*p == '\r') || (*p == '\0')) {
+	    continue;
+	}
+	if (rc == 0) {
+	    rc = growDigests(digests, allocated, digestSize, *count + 1);
+	}
+	if (rc == 0) {
+	    digest = *digests + ((size_t)*count * digestSize);
+	    for (i = 0 ; (rc == 0) && (i < digestSize) ; i++) {
+		int high = p[2 * i];
+		int low = (high != '\0') ? p[(2 * i) + 1] : '\0';
+		if (!isxdigit(high) || !isxdigit(low)) {
+		    printf("readDigestList: Error, %s line %u is not a digest\n", filename, lineNum);
+		    rc = TSS_RC_BAD_PROPERTY_VALUE;
+		}
+		else {
+		    high = isdigit(high) ? (high - '0') : (tolower(high) - 'a' + 10);
+		    low = isdigit(low) ? (low - '0') : (tolower(low) - 'a' + 10);
+		    digest[i] = (uint8_t)((high << 4) | low);
+		}
+	    }
+	}
+	/* the digest must be followed by white space or end of line */
+	if (rc == 0) {
+	    if (!isspace((int)p[2 * digestSize]) && (p[2 * digestSize] != '\0')) {
+		printf("readDigestList: Error, %s line %u digest length is not %u bytes\n",
+		       filename, lineNum, digestSize);
+		rc = TSS_RC_BAD_PROPERTY_VALUE;
+	    }
+	}
+	if (rc == 0) {
+	    (*count)++;
+	}
+    }
+    if (file != NULL) {
+	fclose(file);	/* @1 */
+    }
+    return rc;
+}
+
+/* addRandomDigests() appends random digests, for a benchmark */
+
+static TPM_RC addRandomDigests(uint8_t **digests,
+			       uint32_t *count,
+			       uint32_t *allocated,
+			       uint16_t digestSize,
+			       uint32_t number)
+{
+    TPM_RC 	rc = 0;
+
+    if (rc == 0) {
+	rc = growDigests(digests, allocated, digestSize, *count + number);
+    }
+    if (rc == 0) {
+	rc = TSS_RandBytes(*digests + ((size_t)*count * digestSize),
+			   number * (uint32_t)digestSize);
+    }
+    if (rc == 0) {
+	*count += number;
+    }
+    return rc;
+}
+
+/* growDigests() grows the digest array to hold at least 'needed' digests */
+
+static TPM_RC growDigests(uint8_t **digests,
+			  uint32_t *allocated,
+			  uint16_t digestSize,
+			  uint32_t needed)
+{
+    TPM_RC 	rc = 0;
+    uint8_t	*tmp;
+    uint32_t	newAllocated;
+    
+    if (needed > *allocated) {
+	newAllocated = (*allocated == 0) ? 0x10000 : *allocated;
+	while (newAllocated < needed) {
+	    newAllocated *= 2;
+	}
+	tmp = realloc(*digests, (size_t)newAllocated * digestSize);
+	if (tmp == NULL) {
+	    printf("growDigests: Error, could not allocate %u digests\n", newAllocated);
+	    rc = TSS_RC_OUT_OF_MEMORY;
+	}
+	else {
+	    *digests = tmp;
+	    *allocated = newAllocated;
+	}
+    }
+    return rc;
+}
+
+/* appraiseIma() looks up each IMA file data hash in the database and prints the files that are
+   not found.  Returns ERR_REFDB_NOT_FOUND if any file is not found.
+*/
+
+static TPM_RC appraiseIma(const REFDB *refdb,
+			  const char *filename,
+			  int littleEndian)
+{
+    TPM_RC 		rc = 0;
+    FILE		*file = NULL;		/* closed @1 */
+    ImaEvent 		imaEvent;
+    ImaTemplateData	imaTemplateData;
+    int 		endOfFile = FALSE;
+    int			found;
+    unsigned int 	lineNum;
+    unsigned int 	notFound = 0;
+
+    if (rc == 0) {
+	rc = TSS_File_Open(&file, filename, "rb");	/* closed @1 */
+    }
+    for (lineNum = 0 ; (rc == 0) && !endOfFile ; lineNum++) {
+	IMA_Event_Init(&imaEvent);
+	rc = IMA_Event_ReadFile(&imaEvent, &endOfFile, file, littleEndian);
+	if ((rc == 0) && !endOfFile) {
+	    rc = IMA_TemplateData_ReadBuffer(&imaTemplateData, &imaEvent, littleEndian);
+	}
+	if ((rc == 0) && !endOfFile) {
+	    rc = REFDB_AppraiseImaTemplateData(&found, refdb, &imaTemplateData);
+	}
+	if ((rc == 0) && !endOfFile && !found) {
+	    printf("refdb: line %u not found: %s\n", lineNum, imaTemplateData.fileName);
+	    notFound++;
+	}
+	IMA_Event_Free(&imaEvent);
+    }
+    if (rc == 0) {
+	printf("refdb: %u events, %u not found\n", lineNum - 1, notFound);
+	if (notFound > 0) {
+	    rc = ERR_REFDB_NOT_FOUND;
+	}
+    }
+    if (file != NULL) {
+	fclose(file);	/* @1 */
+    }
+    return rc;
+}
+
+/* benchmark() times lookups, half of digests that are in the database and half of random digests
+   that are almost certainly not.  Returns ERR_REFDB_NOT_FOUND if a database digest is not found.
+*/
+
+static TPM_RC benchmark(const REFDB *refdb,
+			uint32_t lookups)
+{
+    TPM_RC 		rc = 0;
+    uint8_t		*missDigests = NULL;		/* freed @1 */
+    uint32_t		missCount = 1024;
+    uint32_t 		i;
+    uint32_t 		hits = 0;
+    clock_t		startTime;
+    double		seconds;
+
+    if (rc == 0) {
+	if (refdb->count == 0) {
+	    printf("benchmark: Error, database is empty\n");
+	    rc = TSS_RC_BAD_PROPERTY_VALUE;
+	}
+    }
+    if (rc == 0) {
+	rc = TSS_Malloc(&missDigests, missCount * refdb->digestSize);
+    }
+    if (rc == 0) {
+	rc = TSS_RandBytes(missDigests, missCount * refdb->digestSize);
+    }
+    if (rc == 0) {
+	startTime = clock();
+	for (i = 0 ; i < lookups ; i++) {
+	    const uint8_t *digest;
+	    if ((i % 2) == 0) {
+		/* stride through the database so that lookups are not cache friendly */
+		digest = refdb->digests +
+			 ((size_t)(((uint64_t)i * 2654435761U) % refdb->count) * refdb->digestSize);
+	    }
+	    else {
+		digest = missDigests + ((size_t)(i % missCount) * refdb->digestSize);
+	    }
+	    hits += REFDB_Lookup(refdb, digest);
+	}
+	seconds = (double)(clock() - startTime) / CLOCKS_PER_SEC;
+	printf("Entries %u lookups %u hits %u time %f lookups per second %.0f\n",
+	       refdb->count, lookups, hits, seconds,
+	       (seconds > 0) ? lookups / seconds : 0);
+	if (hits < ((lookups + 1) / 2)) {
+	    printf("benchmark: Error, database digests not found\n");
+	    rc = ERR_REFDB_NOT_FOUND;
+	}
+    }
+    free(missDigests);	/* @1 */
+    return rc;
+}
+
+static void printUsage(void)
+{
+    printf("\n");
+    printf("refdb\n");
+    printf("\n");
+    printf("Builds a reference digest database, appraises an IMA log, and benchmarks lookups\n");
+    printf("\n");
+    printf("\t-db\treference digest database file\n");
+    printf("\t[-if\tdigest list to build the database, one hexascii digest per line,\n"
+	   "\t\toptionally followed by a file name]\n");
+    printf("\t[-halg\t(sha1, sha256, sha384) (default sha256)]\n");
+    printf("\t[-gen\tnumber of random digests to add to the database]\n");
+    printf("\t[-ima\tIMA event log file name to appraise, fails if a file is not found]\n");
+    printf("\t[-le\tIMA input file is little endian (default big endian)]\n");
+    printf("\t[-bench\tnumber of lookups to time]\n");
+    printf("\n");
+    exit(1);
+}
@@ -0,0 +1,507 @@
+/********************************************************************************/
+/*										*/
+/*			  Reference Digest Database				*/
+/*		       IBM Thomas J. Watson Research Center			*/
+/*			      $Id: refdblib.c $					*/
+/*										*/
+/* (c) Copyright IBM Corporation 2017.						*/
+/*										*/
+/* All rights reserved.								*/
+/* 										*/
+/* Redistribution and use in source and binary forms, with or without		*/
+/* modification, are permitted provided that the following conditions are	*/
+/* met:										*/
+/* 										*/
+/* Redistributions of source code must retain the above copyright notice,	*/
+/* this list of conditions and the following disclaimer.			*/
+/* 										*/
+/* Redistributions in binary form must reproduce the above copyright		*/
+/* notice, this list of conditions and the following disclaimer in the		*/
+/* documentation and/or other materials provided with the distribution.		*/
+/* 										*/
+/* Neither the names of the IBM Corporation nor the names of its		*/
+/* contributors may be used to endorse or promote products derived from		*/
+/* this software without specific prior written permission.			*/
+/* 										*/
+/* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS		*/
+/* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT		*/
+/* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR	*/
+/* A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT		*/
+/* HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,	*/
+/* SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT		*/
+/* LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,	*/
+/* DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY	*/
+/* THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT		*/
+/* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE	*/
+/* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.		*/
+/********************************************************************************/
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#ifdef TPM_POSIX
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include <openssl/objects.h>
+
+#include <tss2/tss.h>
+#include <tss2/tsscryptoh.h>
+
+#include "refdblib.h"
+
+/* local prototypes */
+
+static int REFDB_Compare_SHA1(const void *a, const void *b);
+static int REFDB_Compare_SHA256(const void *a, const void *b);
+static int REFDB_Compare_SHA384(const void *a, const void *b);
+static uint32_t REFDB_Uint32_Get(const uint8_t *stream);
+static void REFDB_Uint32_Put(uint8_t *stream, uint32_t value);
+static uint32_t REFDB_Validate(REFDB *refdb);
+
+/* REFDB_Build() sorts and de-duplicates the digests and writes the database to filename.
+
+   digests is count digests of the hashAlg size.  The array is sorted in place.  On return, count
+   is the number of unique digests written.
+*/
+
+uint32_t REFDB_Build(const char *filename,
+		     TPMI_ALG_HASH hashAlg,
+		     uint8_t *digests,
+		     uint32_t *count)
+{
+    uint32_t 	rc = 0;
+    uint16_t	digestSize;
+    uint8_t	*header = NULL;		/* freed @1 */
+    FILE	*file = NULL;		/* closed @2 */
+    uint32_t	unique = 0;
+    uint32_t	i;
+    uint32_t	prefix;
+    int		(*compare)(const void *, const void *) = NULL;
+    
+    /* the qsort() callback gets no context, so the digest size is fixed by the callback */
+    if (rc == 0) {
+	digestSize = TSS_GetDigestSize(hashAlg);
+	switch (digestSize) {
+	  case SHA1_DIGEST_SIZE:
+	    compare = REFDB_Compare_SHA1;
+	    break;
+	  case SHA256_DIGEST_SIZE:
+	    compare = REFDB_Compare_SHA256;
+	    break;
+	  case SHA384_DIGEST_SIZE:
+	    compare = REFDB_Compare_SHA384;
+	    break;
+	  default:
+	    printf("REFDB_Build: Error, unsupported hash algorithm %04x\n", hashAlg);
+	    rc = ERR_REFDB_ALGORITHM;
+	}
+    }
+    /* sort and remove duplicates */
+    if ((rc == 0) && (*count > 0)) {
+	qsort(digests, *count, digestSize, compare);
+	unique = 1;
+	for (i = 1 ; i < *count ; i++) {
+	    if (memcmp(digests + ((size_t)(unique - 1) * digestSize),
+		       digests + ((size_t)i * digestSize), digestSize) != 0) {
+		if (unique != i) {
+		    memcpy(digests + ((size_t)unique * digestSize),
+			   digests + ((size_t)i * digestSize), digestSize);
+		}
+		unique++;
+	    }
+	}
+	*count = unique;
+    }
+    if (rc == 0) {
+	header = malloc(REFDB_HEADER_SIZE);
+	if (header == NULL) {
+	    printf("REFDB_Build: Error, could not allocate header\n");
+	    rc = TSS_RC_OUT_OF_MEMORY;
+	}
+    }
+    /* build the header and prefix index */
+    if (rc == 0) {
+	memcpy(header, REFDB_MAGIC, 8);
+	header[8] = (uint8_t)(hashAlg >> 8);
+	header[9] = (uint8_t)(hashAlg >> 0);
+	header[10] = (uint8_t)(digestSize >> 8);
+	header[11] = (uint8_t)(digestSize >> 0);
+	REFDB_Uint32_Put(header + 12, *count);
+	for (prefix = 0, i = 0 ; prefix <= REFDB_PREFIX_COUNT ; prefix++) {
+	    while ((i < *count) &&
+		   ((((uint32_t)digests[(size_t)i * digestSize] << 8) |
+		     digests[((size_t)i * digestSize) + 1]) < prefix)) {
+		i++;
+	    }
+	    REFDB_Uint32_Put(header + 16 + (4 * prefix), i);
+	}
+    }
+    if (rc == 0) {
+	file = fopen(filename, "wb");			/* closed @2 */
+	if (file == NULL) {
+	    printf("REFDB_Build: Error opening %s\n", filename);
+	    rc = TSS_RC_FILE_OPEN;
+	}
+    }
+    if (rc == 0) {
+	if (fwrite(header, REFDB_HEADER_SIZE, 1, file) != 1) {
+	    printf("REFDB_Build: Error writing %s\n", filename);
+	    rc = TSS_RC_FILE_WRITE;
+	}
+    }
+    if ((rc == 0) && (*count > 0)) {
+	if (fwrite(digests, (size_t)*count * digestSize, 1, file) != 1) {
+	    printf("REFDB_Build: Error writing %s\n", filename);
+	    rc = TSS_RC_FILE_WRITE;
+	}
+    }
+    if (file != NULL) {
+	if (fclose(file) != 0) {	/* @2 */
+	    if (rc == 0) {
+		printf("REFDB_Build: Error closing %s\n", filename);
+		rc = TSS_RC_FILE_CLOSE;
+	    }
+	}
+    }
+    free(header);	/* @1 */
+    return rc;
+}
+
+/* REFDB_Open() opens a reference digest database.
+
+   On POSIX platforms, the file is memory mapped, so opening even a large database is fast and the
+   pages are shared between processes.  Otherwise, the file is read into memory.  In both cases,
+   the complete format is validated, so that lookups need no bounds checks.
+
+   The database must be closed with REFDB_Close().
+*/
+
+uint32_t REFDB_Open(REFDB *refdb,
+		    const char *filename)
+{
+    uint32_t 	rc = 0;
+
+    refdb->base = NULL;
+    refdb->length = 0;
+    refdb->mapped = FALSE;
+#ifdef TPM_POSIX
+    {
+	int 		fd = -1;		/* closed @1 */
+	struct stat 	statBuf;
+	if (rc == 0) {
+	    fd = open(filename, O_RDONLY);
+	    if (fd < 0) {
+		printf("REFDB_Open: Error opening %s\n", filename);
+		rc = TSS_RC_FILE_OPEN;
+	    }
+	}
+	if (rc == 0) {
+	    if (fstat(fd, &statBuf) != 0) {
+		printf("REFDB_Open: Error reading the size of %s\n", filename);
+		rc = TSS_RC_FILE_FTELL;
+	    }
+	}
+	if (rc == 0) {
+	    if (statBuf.st_size < REFDB_HEADER_SIZE) {
+		printf("REFDB_Open: Error, %s is too small\n", filename);
+		rc = ERR_REFDB_FORMAT;
+	    }
+	}
+	if (rc == 0) {
+	    void *map = mmap(NULL, (size_t)statBuf.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	    if (map == MAP_FAILED) {
+		printf("REFDB_Open: Error mapping %s\n", filename);
+		rc = TSS_RC_FILE_READ;
+	    }
+	    else {
+		refdb->base = map;
+		refdb->length = (size_t)statBuf.st_size;
+		refdb->mapped = TRUE;
+	    }
+	}
+	if (fd >= 0) {
+	    close(fd);		/* @1 */
+	}
+    }
+#else
+    {
+	FILE 		*file = NULL;		/* closed @1 */
+	long		lrc;
+	if (rc == 0) {
+	    file = fopen(filename, "rb");
+	    if (file == NULL) {
+		printf("REFDB_Open: Error opening %s\n", filename);
+		rc = TSS_RC_FILE_OPEN;
+	    }
+	}
+	if (rc == 0) {
+	    if ((fseek(file, 0L, SEEK_END) != 0) ||
+		((lrc = ftell(file)) < 0) ||
+		(fseek(file, 0L, SEEK_SET) != 0)) {
+		printf("REFDB_Open: Error reading the size of %s\n", filename);
+		rc = TSS_RC_FILE_FTELL;
+	    }
+	}
+	if (rc == 0) {
+	    if (lrc < REFDB_HEADER_SIZE) {
+		printf("REFDB_Open: Error, %s is too small\n", filename);
+		rc = ERR_REFDB_FORMAT;
+	    }
+	}
+	if (rc == 0) {
+	    refdb->length = (size_t)lrc;
+	    refdb->base = malloc(refdb->length);
+	    if (refdb->base == NULL) {
+		printf("REFDB_Open: Error, could not allocate %lu bytes\n",
+		       (unsigned long)refdb->length);
+		rc = TSS_RC_OUT_OF_MEMORY;
+	    }
+	}
+	if (rc == 0) {
+	    if (fread(refdb->base, refdb->length, 1, file) != 1) {
+		printf("REFDB_Open: Error reading %s\n", filename);
+		rc = TSS_RC_FILE_READ;
+	    }
+	}
+	if (file != NULL) {
+	    fclose(file);	/* @1 */
+	}
+    }
+#endif
+    if (rc == 0) {
+	rc = REFDB_Validate(refdb);
+    }
+    if (rc != 0) {
+	REFDB_Close(refdb);
+    }
+    return rc;
+}
+
+/* REFDB_Validate() checks the header, the file length, and that the prefix index is monotonic and
+   within the digest list */
+
+static uint32_t REFDB_Validate(REFDB *refdb)
+{
+    uint32_t 	rc = 0;
+    uint32_t	prefix;
+    uint32_t	previous = 0;
+    uint32_t	current;
+
+    if (rc == 0) {
+	if (memcmp(refdb->base, REFDB_MAGIC, 8) != 0) {
+	    printf("REFDB_Validate: Error, not a reference digest database\n");
+	    rc = ERR_REFDB_FORMAT;
+	}
+    }
+    if (rc == 0) {
+	refdb->hashAlg = (TPMI_ALG_HASH)((refdb->base[8] << 8) | refdb->base[9]);
+	refdb->digestSize = (uint16_t)((refdb->base[10] << 8) | refdb->base[11]);
+	refdb->count = REFDB_Uint32_Get(refdb->base + 12);
+	refdb->index = refdb->base + 16;
+	refdb->digests = refdb->base + REFDB_HEADER_SIZE;
+	if ((refdb->digestSize < 2) || (refdb->digestSize != TSS_GetDigestSize(refdb->hashAlg))) {
+	    printf("REFDB_Validate: Error, hash algorithm %04x digest size %u\n",
+		   refdb->hashAlg, refdb->digestSize);
+	    rc = ERR_REFDB_FORMAT;
+	}
+    }
+    if (rc == 0) {
+	if ((refdb->length - REFDB_HEADER_SIZE) / refdb->digestSize != refdb->count) {
+	    printf("REFDB_Validate: Error, length %lu inconsistent with count %u\n",
+		   (unsigned long)refdb->length, refdb->count);
+	    rc = ERR_REFDB_FORMAT;
+	}
+    }
+    for (prefix = 0 ; (rc == 0) && (prefix <= REFDB_PREFIX_COUNT) ; prefix++) {
+	current = REFDB_Uint32_Get(refdb->index + (4 * prefix));
+	if ((current < previous) || (current > refdb->count) ||
+	    ((prefix == REFDB_PREFIX_COUNT) && (current != refdb->count))) {
+	    printf("REFDB_Validate: Error, bad prefix index at %04x\n", prefix);
+	    rc = ERR_REFDB_FORMAT;
+	}
+	previous = current;
+    }
+    return rc;
+}
+
+/* REFDB_Close() unmaps or frees the database.  It is safe to call on a closed database. */
+
+void REFDB_Close(REFDB *refdb)
+{
+    if (refdb->base != NULL) {
+#ifdef TPM_POSIX
+	if (refdb->mapped) {
+	    munmap(refdb->base, refdb->length);
+	}
+	else
+#endif
+	{
+	    free(refdb->base);
+	}
+    }
+    refdb->base = NULL;
+    refdb->length = 0;
+    refdb->mapped = FALSE;
+    return;
+}
+
+/* REFDB_Lookup() returns TRUE if the digest is in the database.  The digest must be the database
+   digest size.
+
+   Since digests are uniformly distributed, the first probe is interpolated from the next four
+   digest bytes.  The search then gallops away from the probe and finishes with a binary search.
+   For a large database, this is typically two or three probes in nearby cache lines rather than
+   a dozen scattered ones.
+
+   The database is read only, so concurrent lookups are safe.
+*/
+
+int REFDB_Lookup(const REFDB *refdb,
+		 const uint8_t *digest)
+{
+    uint32_t	prefix = ((uint32_t)digest[0] << 8) | digest[1];
+    uint32_t	low = REFDB_Uint32_Get(refdb->index + (4 * prefix));
+    uint32_t	high = REFDB_Uint32_Get(refdb->index + (4 * (prefix + 1)));
+    uint32_t	probe;
+    uint32_t	step;
+    int		irc;
+
+    /* the first two bytes are already known to match, compare the rest */
+#define REFDB_COMPARE(i) memcmp(refdb->digests + ((size_t)(i) * refdb->digestSize) + 2, \
+				digest + 2, refdb->digestSize - 2)
+
+    if (low == high) {
+	return FALSE;
+    }
+    /* interpolated first probe */
+    probe = low + (uint32_t)(((uint64_t)REFDB_Uint32_Get(digest + 2) * (high - low)) >> 32);
+    irc = REFDB_COMPARE(probe);
+    if (irc == 0) {
+	return TRUE;
+    }
+    /* gallop toward the digest to bound the binary search */
+    if (irc < 0) {
+	low = probe + 1;
+	for (step = 1 ; (probe + step) < high ; step *= 2) {
+	    irc = REFDB_COMPARE(probe + step);
+	    if (irc == 0) {
+		return TRUE;
+	    }
+	    if (irc > 0) {
+		high = probe + step;
+		break;
+	    }
+	    low = probe + step + 1;
+	}
+    }
+    else {
+	high = probe;
+	for (step = 1 ; step <= (probe - low) ; step *= 2) {
+	    irc = REFDB_COMPARE(probe - step);
+	    if (irc == 0) {
+		return TRUE;
+	    }
+	    if (irc < 0) {
+		low = probe - step + 1;
+		break;
+	    }
+	    high = probe - step;
+	}
+    }
+    /* binary search [low, high) */
+    while (low < high) {
+	probe = low + ((high - low) / 2);
+	irc = REFDB_COMPARE(probe);
+	if (irc == 0) {
+	    return TRUE;
+	}
+	if (irc < 0) {
+	    low = probe + 1;
+	}
+	else {
+	    high = probe;
+	}
+    }
+#undef REFDB_COMPARE
+    return FALSE;
+}
+
+/* REFDB_AppraiseImaTemplateData() looks up the file data hash of an IMA ima-ng template.
+
+   found is TRUE if the file hash is in the database.  An error is returned if the template hash
+   algorithm is not the database algorithm.
+*/
+
+uint32_t REFDB_AppraiseImaTemplateData(int *found,
+				       const REFDB *refdb,
+				       const ImaTemplateData *imaTemplateData)
+{
+    uint32_t 		rc = 0;
+    TPMI_ALG_HASH	hashAlg;
+
+    *found = FALSE;
+    if (rc == 0) {
+	switch (imaTemplateData->hashNid) {
+	  case NID_sha1:
+	    hashAlg = TPM_ALG_SHA1;
+	    break;
+	  case NID_sha256:
+	    hashAlg = TPM_ALG_SHA256;
+	    break;
+	  default:
+	    hashAlg = TPM_ALG_NULL;
+	}
+	if ((hashAlg != refdb->hashAlg) ||
+	    (imaTemplateData->fileDataHashLength != refdb->digestSize)) {
+	    printf("REFDB_AppraiseImaTemplateData: Error, template hash algorithm %s, "
+		   "database algorithm %04x\n", imaTemplateData->hashAlg, refdb->hashAlg);
+	    rc = ERR_REFDB_ALGORITHM;
+	}
+    }
+    if (rc == 0) {
+	*found = REFDB_Lookup(refdb, imaTemplateData->fileDataHash);
+    }
+    return rc;
+}
+
+/* REFDB_Compare_SHA1(), REFDB_Compare_SHA256(), and REFDB_Compare_SHA384() are the qsort()
+   callbacks for REFDB_Build(), one per digest size so that the sort is reentrant */
+
+static int REFDB_Compare_SHA1(const void *a, const void *b)
+{
+    return memcmp(a, b, SHA1_DIGEST_SIZE);
+}
+
+static int REFDB_Compare_SHA256(const void *a, const void *b)
+{
+    return memcmp(a, b, SHA256_DIGEST_SIZE);
+}
+
+static int REFDB_Compare_SHA384(const void *a, const void *b)
+{
+    return memcmp(a, b, SHA384_DIGEST_SIZE);
+}
+
+static uint32_t REFDB_Uint32_Get(const uint8_t *stream)
+{
+    return ((uint32_t)stream[0] << 24) |
+	((uint32_t)stream[1] << 16) |
+	((uint32_t)stream[2] <<  8) |
+	((uint32_t)stream[3] <<  0);
+}
+
+static void REFDB_Uint32_Put(uint8_t *stream, uint32_t value)
+{
+    stream[0] = (uint8_t)(value >> 24);
+    stream[1] = (uint8_t)(value >> 16);
+    stream[2] = (uint8_t)(value >>  8);
+    stream[3] = (uint8_t)(value >>  0);
+    return;
+}
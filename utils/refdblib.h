@@ -0,0 +1,111 @@
+/********************************************************************************/
+/*										*/
+/*			  Reference Digest Database				*/
+/*		       IBM Thomas J. Watson Research Center			*/
+/*			      $Id: refdblib.h $					*/
+/*										*/
+/* (c) Copyright IBM Corporation 2017.						*/
+/*										*/
+/* All rights reserved.								*/
+/* 										*/
+/* Redistribution and use in source and binary forms, with or without		*/
+/* modification, are permitted provided that the following conditions are	*/
+/* met:										*/
+/* 										*/
+/* Redistributions of source code must retain the above copyright notice,	*/
+/* this list of conditions and the following disclaimer.			*/
+/* 										*/
+/* Redistributions in binary form must reproduce the above copyright		*/
+/* notice, this list of conditions and the following disclaimer in the		*/
+/* documentation and/or other materials provided with the distribution.		*/
+/* 										*/
+/* Neither the names of the IBM Corporation nor the names of its		*/
+/* contributors may be used to endorse or promote products derived from		*/
+/* this software without specific prior written permission.			*/
+/* 										*/
+/* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS		*/
+/* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT		*/
+/* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR	*/
+/* A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT		*/
+/* HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,	*/
+/* SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT		*/
+/* LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,	*/
+/* DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY	*/
+/* THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT		*/
+/* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE	*/
+/* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.		*/
+/********************************************************************************/
+
+
+/* A reference digest database is a sorted, de-duplicated list of known good digests, typically
+   file hashes from a software distribution.  It is built offline by refdb, and is used to
+   appraise IMA (ImaTemplateData) and boot event log measurements.
+
+   The file can be memory mapped.  All integers are big endian.
+
+	offset	size			contents
+	0	8			magic "TSSRDB01"
+	8	2			TPM_ALG_ID hash algorithm
+	10	2			digest size
+	12	4			digest count
+	16	4 * 65537		prefix index
+	262164	count * digest size	sorted digests
+
+   prefix index[p] is the number of digests whose first two bytes are less than p.  The digests
+   starting with p are therefore at [index[p], index[p+1]), and a lookup is a binary search of
+   typically count / 65536 digests.
+*/
+
+#ifndef REFDBLIB_H
+#define REFDBLIB_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include <tss2/TPM_Types.h>
+
+#include "imalib.h"
+
+#define REFDB_MAGIC		"TSSRDB01"
+#define REFDB_PREFIX_COUNT	0x10000
+#define REFDB_HEADER_SIZE	(16 + (4 * (REFDB_PREFIX_COUNT + 1)))
+
+#define ERR_REFDB_FORMAT	3	/* not a valid reference digest database */
+#define ERR_REFDB_ALGORITHM	4	/* digest algorithm does not match the database */
+#define ERR_REFDB_NOT_FOUND	5	/* an appraised digest is not in the database */
+
+typedef struct REFDB {
+    TPMI_ALG_HASH	hashAlg;
+    uint16_t		digestSize;
+    uint32_t		count;
+    const uint8_t	*index;		/* prefix index, big endian */
+    const uint8_t	*digests;	/* sorted digests */
+    uint8_t		*base;		/* start of the mapped or read file */
+    size_t		length;		/* file length */
+    int			mapped;		/* TRUE if base is memory mapped */
+} REFDB;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+    uint32_t REFDB_Build(const char *filename,
+			 TPMI_ALG_HASH hashAlg,
+			 uint8_t *digests,
+			 uint32_t *count);
+    uint32_t REFDB_Open(REFDB *refdb,
+			const char *filename);
+    void REFDB_Close(REFDB *refdb);
+    int REFDB_Lookup(const REFDB *refdb,
+		     const uint8_t *digest);
+    uint32_t REFDB_AppraiseImaTemplateData(int *found,
+					   const REFDB *refdb,
+					   const ImaTemplateData *imaTemplateData);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -282,6 +282,69 @@ IF !ERRORLEVEL! NEQ 0 (
   exit /B 1
 )
 
+call regtests\testlocality.bat
+IF !ERRORLEVEL! NEQ 0 (
+      echo ""
+      echo "Failed testlocality.bat"
+  exit /B 1
+)
+
+call regtests\testcapability.bat
+IF !ERRORLEVEL! NEQ 0 (
+      echo ""
+      echo "Failed testcapability.bat"
+  exit /B 1
+)
+
+call regtests\testnamecache.bat
+IF !ERRORLEVEL! NEQ 0 (
+      echo ""
+      echo "Failed testnamecache.bat"
+  exit /B 1
+)
+
+call regtests\testpolicyemulate.bat
+IF !ERRORLEVEL! NEQ 0 (
+      echo ""
+      echo "Failed testpolicyemulate.bat"
+  exit /B 1
+)
+
+call regtests\testcphash.bat
+IF !ERRORLEVEL! NEQ 0 (
+      echo ""
+      echo "Failed testcphash.bat"
+  exit /B 1
+)
+
+call regtests\testreplay.bat
+IF !ERRORLEVEL! NEQ 0 (
+      echo ""
+      echo "Failed testreplay.bat"
+  exit /B 1
+)
+
+call regtests\testpolicycompile.bat
+IF !ERRORLEVEL! NEQ 0 (
+      echo ""
+      echo "Failed testpolicycompile.bat"
+  exit /B 1
+)
+
+call regtests\testeventreplay.bat
+IF !ERRORLEVEL! NEQ 0 (
+      echo ""
+      echo "Failed testeventreplay.bat"
+  exit /B 1
+)
+
+call regtests\testrefdb.bat
+IF !ERRORLEVEL! NEQ 0 (
+      echo ""
+      echo "Failed testrefdb.bat"
+  exit /B 1
+)
+
 call regtests\testshutdown.bat
 IF !ERRORLEVEL! NEQ 0 (
       echo ""
@@ -102,8 +102,18 @@ printUsage ()
     echo "-27 Duplication"
     echo "-28 ECC"
     echo "-29 Credential"
+    echo "-30 Locality (only run for simulator)"
+    echo "-31 Capability cache"
+    echo "-32 Name cache"
+    echo "-33 Policy emulation"
+    echo "-34 cpHash"
     echo "-35 Shutdown (only run for simulator)"
+    echo "-36 Scheduler"
+    echo "-37 Record and replay"
+    echo "-38 Policy compile"
+    echo "-39 Event log replay"
     echo "-40 Tests under development (not part of all)"
+    echo "-41 Reference digest database"
     echo ""
     echo "-50 Change seed"
 }
@@ -470,6 +480,51 @@ main ()
 	fi
 	((I++))
     fi
+    if [ "$1" == "-a" ] || [ "$1" == "-30" ]; then
+	# the MS simulator packet carries the locality
+	if [ -z ${TPM_INTERFACE_TYPE} ] || [ ${TPM_INTERFACE_TYPE} == "socsim" ];  then
+	    if [ -z ${TPM_SERVER_TYPE} ] || [ ${TPM_SERVER_TYPE} == "mssim" ]; then
+		./regtests/testlocality.sh
+	    fi
+	fi
+   	RC=$?
+	if [ $RC -ne 0 ]; then
+	    exit 255
+	fi
+	((I++))
+    fi
+    if [ "$1" == "-a" ] || [ "$1" == "-31" ]; then
+    	./regtests/testcapability.sh
+    	RC=$?
+    	if [ $RC -ne 0 ]; then
+    	    exit 255
+    	fi
+	((I++))
+    fi
+    if [ "$1" == "-a" ] || [ "$1" == "-32" ]; then
+    	./regtests/testnamecache.sh
+    	RC=$?
+    	if [ $RC -ne 0 ]; then
+    	    exit 255
+    	fi
+	((I++))
+    fi
+    if [ "$1" == "-a" ] || [ "$1" == "-33" ]; then
+    	./regtests/testpolicyemulate.sh
+    	RC=$?
+    	if [ $RC -ne 0 ]; then
+    	    exit 255
+    	fi
+	((I++))
+    fi
+    if [ "$1" == "-a" ] || [ "$1" == "-34" ]; then
+    	./regtests/testcphash.sh
+    	RC=$?
+    	if [ $RC -ne 0 ]; then
+    	    exit 255
+    	fi
+	((I++))
+    fi
     if [ "$1" == "-a" ] || [ "$1" == "-35" ]; then
 	# the MS simulator supports power cycling
 	if [ -z ${TPM_INTERFACE_TYPE} ] || [ ${TPM_INTERFACE_TYPE} == "socsim" ];  then
@@ -483,6 +538,38 @@ main ()
 	fi
 	((I++))
     fi
+    if [ "$1" == "-a" ] || [ "$1" == "-36" ]; then
+    	./regtests/testscheduler.sh
+    	RC=$?
+    	if [ $RC -ne 0 ]; then
+    	    exit 255
+    	fi
+	((I++))
+    fi
+    if [ "$1" == "-a" ] || [ "$1" == "-37" ]; then
+    	./regtests/testreplay.sh
+    	RC=$?
+    	if [ $RC -ne 0 ]; then
+    	    exit 255
+    	fi
+	((I++))
+    fi
+    if [ "$1" == "-a" ] || [ "$1" == "-38" ]; then
+    	./regtests/testpolicycompile.sh
+    	RC=$?
+    	if [ $RC -ne 0 ]; then
+    	    exit 255
+    	fi
+	((I++))
+    fi
+    if [ "$1" == "-a" ] || [ "$1" == "-39" ]; then
+    	./regtests/testeventreplay.sh
+    	RC=$?
+    	if [ $RC -ne 0 ]; then
+    	    exit 255
+    	fi
+	((I++))
+    fi
     if [ "$1" == "-40" ]; then
      	./regtests/testdevel.sh
      	RC=$?
@@ -492,6 +579,14 @@ main ()
      	((I++))
      	((WARN=$RC))
     fi
+    if [ "$1" == "-a" ] || [ "$1" == "-41" ]; then
+    	./regtests/testrefdb.sh
+    	RC=$?
+    	if [ $RC -ne 0 ]; then
+    	    exit 255
+    	fi
+	((I++))
+    fi
 # this must be the last test
     if [ "$1" == "-a" ] || [ "$1" == "-50" ]; then
     	./regtests/testchangeseed.sh
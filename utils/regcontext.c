@@ -0,0 +1,945 @@
+/********************************************************************************/
+/*										*/
+/*			 TSS Context Regression Tests				*/
+/*		       IBM Thomas J. Watson Research Center			*/
+/*			     $Id: regcontext.c $				*/
+/*										*/
+/* (c) Copyright IBM Corporation 2017.						*/
+/*										*/
+/* All rights reserved.								*/
+/* 										*/
+/* Redistribution and use in source and binary forms, with or without		*/
+/* modification, are permitted provided that the following conditions are	*/
+/* met:										*/
+/* 										*/
+/* Redistributions of source code must retain the above copyright notice,	*/
+/* this list of conditions and the following disclaimer.			*/
+/* 										*/
+/* Redistributions in binary form must reproduce the above copyright		*/
+/* notice, this list of conditions and the following disclaimer in the		*/
+/* documentation and/or other materials provided with the distribution.		*/
+/* 										*/
+/* Neither the names of the IBM Corporation nor the names of its		*/
+/* contributors may be used to endorse or promote products derived from		*/
+/* this software without specific prior written permission.			*/
+/* 										*/
+/* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS		*/
+/* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT		*/
+/* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR	*/
+/* A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT		*/
+/* HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,	*/
+/* SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT		*/
+/* LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,	*/
+/* DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY	*/
+/* THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT		*/
+/* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE	*/
+/* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.		*/
+/********************************************************************************/
+
+
+/* regcontext is test code.  It runs the regression tests that need several commands in one TSS
+   context, such as the TSS caches, which a utility that exits after one command cannot exercise.
+   See regtests/testcapability.sh, testnamecache.sh, testcphash.sh, and testscheduler.sh.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#ifdef TPM_POSIX
+#include <pthread.h>
+#include <time.h>
+#endif
+
+#include <tss2/tss.h>
+#include <tss2/tssutils.h>
+#include <tss2/tssresponsecode.h>
+#include <tss2/tsstransmit.h>
+#include <tss2/tsscapability.h>
+#include <tss2/tssfile.h>
+#include <tss2/tsscryptoh.h>
+#include <tss2/tssscheduler.h>
+
+#ifdef TPM_POSIX
+
+/* a thread of the scheduler test, with its own TSS context */
+
+typedef struct SCHEDULER_THREAD {
+    TSS_CONTEXT		*tssContext;
+    uint8_t		extend;		/* byte of the PCR extend digest */
+    TPM_RC		rc;
+    pthread_t		thread;
+} SCHEDULER_THREAD;
+
+#endif
+
+static void printUsage(void);
+static TPM_RC testCapability(TSS_CONTEXT *tssContext,
+			     int clear,
+			     int startup);
+static TPM_RC testCapabilityPaging(TSS_CONTEXT *tssContext,
+				   TPM_CAP capability,
+				   uint32_t property);
+static TPM_RC testCapabilityCached(TSS_CONTEXT *tssContext,
+				   int cached,
+				   const char *message);
+static TPM_RC testNameCache(TSS_CONTEXT *tssContext,
+			    TPMI_DH_OBJECT objectHandle);
+static TPM_RC testCpHash(TSS_CONTEXT *tssContext,
+			 const char *cpHashFilename);
+static TPM_RC testScheduler(TSS_CONTEXT *tssContext);
+#ifdef TPM_POSIX
+static TPM_RC schedulerThreadStart(SCHEDULER_THREAD *schedulerThread,
+				   TSS_SCHEDULER *scheduler,
+				   const char *priority,
+				   const char *deadline,
+				   void *(*startRoutine)(void *));
+static void *schedulerBlocker(void *arg);
+static void *schedulerWaiter(void *arg);
+static TPM_RC schedulerWait(TSS_SCHEDULER *scheduler,
+			    uint32_t commands,
+			    uint32_t queueDepth);
+#endif
+static uint32_t getCapabilityCount(const TPMS_CAPABILITY_DATA *capabilityData);
+static void getCapabilityEntry(uint32_t *key,
+			       uint32_t *value,
+			       const TPMS_CAPABILITY_DATA *capabilityData,
+			       uint32_t i);
+static uint32_t getCommandCount(TSS_CONTEXT *tssContext);
+
+int verbose = FALSE;
+
+int main(int argc, char *argv[])
+{
+    TPM_RC			rc = 0;
+    int				i;    /* argc iterator */
+    TSS_CONTEXT			*tssContext = NULL;
+    int				capability = FALSE;
+    int				clear = FALSE;
+    int				startup = FALSE;
+    int				nameCache = FALSE;
+    TPMI_DH_OBJECT		objectHandle = 0;
+    int				cpHash = FALSE;
+    const char			*cpHashFilename = NULL;
+    int				scheduler = FALSE;
+
+    setvbuf(stdout, 0, _IONBF, 0);      /* output may be going through pipe to log file */
+    TSS_SetProperty(NULL, TPM_TRACE_LEVEL, "1");
+
+    /* command line argument defaults */
+    for (i=1 ; (i<argc) && (rc == 0) ; i++) {
+	if (strcmp(argv[i],"-cap") == 0) {
+	    capability = TRUE;
+	}
+	else if (strcmp(argv[i],"-clear") == 0) {
+	    clear = TRUE;
+	}
+	else if (strcmp(argv[i],"-startup") == 0) {
+	    startup = TRUE;
+	}
+	else if (strcmp(argv[i],"-name") == 0) {
+	    nameCache = TRUE;
+	}
+	else if (strcmp(argv[i],"-cphash") == 0) {
+	    cpHash = TRUE;
+	}
+	else if (strcmp(argv[i],"-sched") == 0) {
+	    scheduler = TRUE;
+	}
+	else if (strcmp(argv[i],"-icp") == 0) {
+	    i++;
+	    if (i < argc) {
+		cpHashFilename = argv[i];
+	    }
+	    else {
+		printf("-icp option needs a value\n");
+		printUsage();
+	    }
+	}
+	else if (strcmp(argv[i],"-ho") == 0) {
+	    i++;
+	    if (i < argc) {
+		sscanf(argv[i],"%x", &objectHandle);
+	    }
+	    else {
+		printf("Missing parameter for -ho\n");
+		printUsage();
+	    }
+	}
+ 	else if (strcmp(argv[i],"-h") == 0) {
+	    printUsage();
+	}
+	else if (strcmp(argv[i],"-v") == 0) {
+	    verbose = TRUE;
+	    TSS_SetProperty(NULL, TPM_TRACE_LEVEL, "2");
+	}
+	else {
+	    printf("\n%s is not a valid option\n", argv[i]);
+	    printUsage();
+	}
+    }
+    if (!capability && !nameCache && !cpHash && !scheduler) {
+	printf("Missing test option\n");
+	printUsage();
+    }
+    if (nameCache && (objectHandle == 0)) {
+	printf("Missing handle parameter -ho\n");
+	printUsage();
+    }
+    if (cpHash && (cpHashFilename == NULL)) {
+	printf("Missing cpHash file parameter -icp\n");
+	printUsage();
+    }
+    /* Start a TSS context */
+    if (rc == 0) {
+	rc = TSS_Create(&tssContext);
+    }
+    if ((rc == 0) && capability) {
+	rc = testCapability(tssContext, clear, startup);
+    }
+    if ((rc == 0) && nameCache) {
+	rc = testNameCache(tssContext, objectHandle);
+    }
+    if ((rc == 0) && cpHash) {
+	rc = testCpHash(tssContext, cpHashFilename);
+    }
+    if ((rc == 0) && scheduler) {
+	rc = testScheduler(tssContext);
+    }
+    {
+	TPM_RC rc1 = TSS_Delete(tssContext);
+	if (rc == 0) {
+	    rc = rc1;
+	}
+    }
+    if (rc == 0) {
+	if (verbose) printf("regcontext: success\n");
+    }
+    else {
+	const char *msg;
+	const char *submsg;
+	const char *num;
+	printf("regcontext: failed, rc %08x\n", rc);
+	/* EXIT_FAILURE is a test mismatch, already reported */
+	if (rc != EXIT_FAILURE) {
+	    TSS_ResponseCode_toString(&msg, &submsg, &num, rc);
+	    printf("%s%s%s\n", msg, submsg, num);
+	}
+	rc = EXIT_FAILURE;
+    }
+    return rc;
+}
+
+/* testCapability() checks that TSS_Capability_Get() pages through the TPM lists, and that the fixed
+   properties are cached until TPM2_Clear() or TPM2_Startup().
+
+   Clear uses the platform hierarchy with an empty password.  Startup power cycles the simulator
+   first, so it only runs against the simulator.
+*/
+
+static TPM_RC testCapability(TSS_CONTEXT *tssContext,
+			     int clear,
+			     int startup)
+{
+    TPM_RC			rc = 0;
+
+    if (rc == 0) {
+	rc = testCapabilityPaging(tssContext, TPM_CAP_ALGS, TPM_ALG_FIRST);
+    }
+    if (rc == 0) {
+	rc = testCapabilityPaging(tssContext, TPM_CAP_COMMANDS, 0);
+    }
+    if (rc == 0) {
+	rc = testCapabilityPaging(tssContext, TPM_CAP_TPM_PROPERTIES, PT_FIXED);
+    }
+    /* the paging test filled the cache */
+    if (rc == 0) {
+	rc = testCapabilityCached(tssContext, TRUE, "after paging");
+    }
+    if ((rc == 0) && clear) {
+	Clear_In 		in;
+	in.authHandle = TPM_RH_PLATFORM;
+	rc = TSS_Execute(tssContext,
+			 NULL,
+			 (COMMAND_PARAMETERS *)&in,
+			 NULL,
+			 TPM_CC_Clear,
+			 TPM_RS_PW, NULL, 0,
+			 TPM_RH_NULL, NULL, 0);
+	if (rc == 0) {
+	    rc = testCapabilityCached(tssContext, FALSE, "after Clear");
+	}
+    }
+    if ((rc == 0) && startup) {
+	Startup_In 		in;
+	TSS_CONTEXT		*platformContext = NULL;
+	/* the platform signals use their own context and connection, as in powerup */
+	if (rc == 0) {
+	    rc = TSS_Create(&platformContext);
+	}
+	if (rc == 0) {
+	    rc = TSS_TransmitPlatform(platformContext, TPM_SIGNAL_POWER_OFF,
+				      "TPM2_PowerOffPlatform");
+	}
+	if (rc == 0) {
+	    rc = TSS_TransmitPlatform(platformContext, TPM_SIGNAL_POWER_ON,
+				      "TPM2_PowerOnPlatform");
+	}
+	if (rc == 0) {
+	    rc = TSS_TransmitPlatform(platformContext, TPM_SIGNAL_NV_ON, "TPM2_NvOnPlatform");
+	}
+	if (platformContext != NULL) {
+	    TPM_RC rc1 = TSS_Delete(platformContext);
+	    if (rc == 0) {
+		rc = rc1;
+	    }
+	}
+	if (rc == 0) {
+	    in.startupType = TPM_SU_CLEAR;
+	    rc = TSS_Execute(tssContext,
+			     NULL,
+			     (COMMAND_PARAMETERS *)&in,
+			     NULL,
+			     TPM_CC_Startup,
+			     TPM_RH_NULL, NULL, 0);
+	}
+	if (rc == 0) {
+	    rc = testCapabilityCached(tssContext, FALSE, "after Startup");
+	}
+    }
+    return rc;
+}
+
+/* testCapabilityPaging() reads the capability list starting at property with
+   TSS_Capability_Get(), and again with TPM2_GetCapability() three entries at a time.  The lists
+   must match.
+*/
+
+static TPM_RC testCapabilityPaging(TSS_CONTEXT *tssContext,
+				   TPM_CAP capability,
+				   uint32_t property)
+{
+    TPM_RC			rc = 0;
+    TPMS_CAPABILITY_DATA	capabilityData;
+    TPMI_YES_NO			moreData;
+    GetCapability_In 		in;
+    GetCapability_Out		out;
+    uint32_t			count;		/* entries in the TSS list */
+    uint32_t			paged = 0;	/* entries read a page at a time */
+    uint32_t			pages = 0;
+    uint32_t			page;
+    uint32_t			key;
+    uint32_t			value;
+    uint32_t			pagedKey;
+    uint32_t			pagedValue;
+    int				done = FALSE;
+
+    if (rc == 0) {
+	rc = TSS_Capability_Get(tssContext,
+				&capabilityData,
+				&moreData,
+				capability,
+				property,
+				0xffffffff);
+    }
+    if (rc == 0) {
+	count = getCapabilityCount(&capabilityData);
+	in.capability = capability;
+	in.property = property;
+	in.propertyCount = 3;
+    }
+    while ((rc == 0) && !done) {
+	if (rc == 0) {
+	    rc = TSS_Execute(tssContext,
+			     (RESPONSE_PARAMETERS *)&out,
+			     (COMMAND_PARAMETERS *)&in,
+			     NULL,
+			     TPM_CC_GetCapability,
+			     TPM_RH_NULL, NULL, 0);
+	}
+	for (page = 0 ; (rc == 0) && (page < getCapabilityCount(&out.capabilityData)) ; page++) {
+	    getCapabilityEntry(&pagedKey, &pagedValue, &out.capabilityData, page);
+	    if (paged < count) {
+		getCapabilityEntry(&key, &value, &capabilityData, paged);
+	    }
+	    /* the TSS list ends at the fixed properties, the TPM list continues */
+	    else if ((capability == TPM_CAP_TPM_PROPERTIES) && (pagedKey >= PT_VAR)) {
+		done = TRUE;
+		break;
+	    }
+	    if ((paged >= count) || (key != pagedKey) || (value != pagedValue)) {
+		printf("regcontext: capability %08x entry %u mismatch\n", capability, paged);
+		rc = EXIT_FAILURE;
+	    }
+	    paged++;
+	}
+	if ((rc == 0) && !done) {
+	    pages++;
+	    if (out.moreData == NO) {
+		done = TRUE;
+	    }
+	    else {
+		rc = TSS_Capability_NextProperty(&in.property, &out.capabilityData);
+	    }
+	}
+    }
+    if (rc == 0) {
+	if (paged != count) {
+	    printf("regcontext: capability %08x TSS count %u paged count %u\n",
+		   capability, count, paged);
+	    rc = EXIT_FAILURE;
+	}
+    }
+    if (rc == 0) {
+	if (verbose) printf("regcontext: capability %08x %u entries in %u pages\n",
+			    capability, count, pages);
+    }
+    return rc;
+}
+
+/* testCapabilityCached() reads TPM_PT_NV_BUFFER_MAX twice.  The first read must be served from the
+   cache if cached is TRUE, and must go to the TPM otherwise.  The second read is always served from
+   the cache.
+*/
+
+static TPM_RC testCapabilityCached(TSS_CONTEXT *tssContext,
+				   int cached,
+				   const char *message)
+{
+    TPM_RC			rc = 0;
+    uint32_t			value;
+    uint32_t			commands;
+    int				pass;
+
+    for (pass = 0 ; (rc == 0) && (pass < 2) ; pass++) {
+	if (rc == 0) {
+	    commands = getCommandCount(tssContext);
+	    rc = TSS_Capability_GetProperty(tssContext, &value, TPM_PT_NV_BUFFER_MAX);
+	}
+	if (rc == 0) {
+	    commands = getCommandCount(tssContext) - commands;
+	    if ((cached || (pass > 0)) && (commands != 0)) {
+		printf("regcontext: %s, cached property read sent %u commands\n", message, commands);
+		rc = EXIT_FAILURE;
+	    }
+	    else if (!cached && (pass == 0) && (commands == 0)) {
+		printf("regcontext: %s, property read was served from the cache\n", message);
+		rc = EXIT_FAILURE;
+	    }
+	}
+    }
+    if (rc == 0) {
+	if (verbose) printf("regcontext: %s, cache %s\n", message, cached ? "hit" : "miss");
+    }
+    return rc;
+}
+
+/* testNameCache() reads the public area of objectHandle three times.  The TSS calculates the Name
+   to validate each response.  The first read must miss the Name cache, and the later reads must
+   hit it and return the same Name.
+*/
+
+static TPM_RC testNameCache(TSS_CONTEXT *tssContext,
+			    TPMI_DH_OBJECT objectHandle)
+{
+    TPM_RC			rc = 0;
+    ReadPublic_In 		in;
+    ReadPublic_Out 		out;
+    TPM2B_NAME			name;
+    uint32_t			hits;
+    uint32_t			misses;
+    uint32_t			hitsBefore;
+    uint32_t			missesBefore;
+    int				pass;
+
+    in.objectHandle = objectHandle;
+    for (pass = 0 ; (rc == 0) && (pass < 3) ; pass++) {
+	if (rc == 0) {
+	    rc = TSS_GetNameCacheStatistics(tssContext, &hitsBefore, &missesBefore);
+	}
+	if (rc == 0) {
+	    rc = TSS_Execute(tssContext,
+			     (RESPONSE_PARAMETERS *)&out,
+			     (COMMAND_PARAMETERS *)&in,
+			     NULL,
+			     TPM_CC_ReadPublic,
+			     TPM_RH_NULL, NULL, 0);
+	}
+	if (rc == 0) {
+	    rc = TSS_GetNameCacheStatistics(tssContext, &hits, &misses);
+	}
+	if (rc == 0) {
+	    if (verbose) printf("regcontext: read public %u, name cache hits %u misses %u\n",
+				pass, hits - hitsBefore, misses - missesBefore);
+	    if ((pass == 0) && ((misses == missesBefore) || (hits != hitsBefore))) {
+		printf("regcontext: first read public did not miss the name cache\n");
+		rc = EXIT_FAILURE;
+	    }
+	    else if ((pass > 0) && ((misses != missesBefore) || (hits == hitsBefore))) {
+		printf("regcontext: read public %u did not hit the name cache\n", pass);
+		rc = EXIT_FAILURE;
+	    }
+	}
+	if (rc == 0) {
+	    if (pass == 0) {
+		name = out.name;
+	    }
+	    else if ((out.name.t.size != name.t.size) ||
+		     (memcmp(out.name.t.name, name.t.name, name.t.size) != 0)) {
+		printf("regcontext: read public %u name mismatch\n", pass);
+		rc = EXIT_FAILURE;
+	    }
+	}
+    }
+    return rc;
+}
+
+/* testCpHash() calculates the cpHash of TPM2_ClockRateAdjust(TPM_RH_PLATFORM, 0) for SHA-1, SHA-256,
+   and SHA-384 in one TSS_GetCpHash() call.  The SHA-1 cpHash must match cpHashFilename, which is
+   policies/policycphashhash.bin.  Each cpHash must match the hash of the command code, the
+   platform hierarchy Name, and the rateAdjust parameter.  No command is sent to the TPM.
+*/
+
+static TPM_RC testCpHash(TSS_CONTEXT *tssContext,
+			 const char *cpHashFilename)
+{
+    TPM_RC			rc = 0;
+    ClockRateAdjust_In 		in;
+    TPMT_HA			cpHash[3];
+    TPMT_HA			digest;
+    uint8_t			*expected = NULL;	/* freed @1 */
+    size_t			length;
+    uint16_t			sizeInBytes;
+    size_t			i;
+    /* TPM_CC_ClockRateAdjust, TPM_RH_PLATFORM Name, rateAdjust 0 */
+    static const uint8_t	commandCode[] = {0x00, 0x00, 0x01, 0x30};
+    static const uint8_t	authName[] = {0x40, 0x00, 0x00, 0x0c};
+    static const uint8_t	rateAdjust[] = {0x00};
+
+    if (rc == 0) {
+	rc = TSS_File_ReadBinaryFile(&expected,     /* freed @1 */
+				     &length,
+				     cpHashFilename);
+    }
+    if (rc == 0) {
+	in.auth = TPM_RH_PLATFORM;
+	in.rateAdjust = 0;
+	cpHash[0].hashAlg = TPM_ALG_SHA1;
+	cpHash[1].hashAlg = TPM_ALG_SHA256;
+	cpHash[2].hashAlg = TPM_ALG_SHA384;
+	rc = TSS_GetCpHash(tssContext, cpHash, sizeof(cpHash) / sizeof(TPMT_HA),
+			   (COMMAND_PARAMETERS *)&in, TPM_CC_ClockRateAdjust);
+    }
+    if (rc == 0) {
+	if ((length != SHA1_DIGEST_SIZE) ||
+	    (memcmp(cpHash[0].digest.sha1, expected, SHA1_DIGEST_SIZE) != 0)) {
+	    printf("regcontext: SHA-1 cpHash does not match %s\n", cpHashFilename);
+	    rc = EXIT_FAILURE;
+	}
+    }
+    for (i = 0 ; (rc == 0) && (i < sizeof(cpHash) / sizeof(TPMT_HA)) ; i++) {
+	if (rc == 0) {
+	    digest.hashAlg = cpHash[i].hashAlg;
+	    rc = TSS_Hash_Generate(&digest,
+				   sizeof(commandCode), commandCode,
+				   sizeof(authName), authName,
+				   sizeof(rateAdjust), rateAdjust,
+				   0, NULL);
+	}
+	if (rc == 0) {
+	    sizeInBytes = TSS_GetDigestSize(digest.hashAlg);
+	    if (memcmp(&cpHash[i].digest, &digest.digest, sizeInBytes) != 0) {
+		printf("regcontext: cpHash algorithm %04x mismatch\n", cpHash[i].hashAlg);
+		rc = EXIT_FAILURE;
+	    }
+	}
+	if (rc == 0) {
+	    if (verbose) TSS_PrintAll("regcontext: cpHash",
+				      (uint8_t *)&cpHash[i].digest, sizeInBytes);
+	}
+    }
+    free(expected);		/* @1 */
+    return rc;
+}
+
+/* testScheduler() checks the order in which the scheduler sends waiting commands.
+
+   A blocker thread holds the connection with a slow TPM2_CreatePrimary() of an RSA key.  While it
+   runs, four waiter threads queue a PCR 16 extend each:
+
+	waiter 0	priority 3
+	waiter 1	priority 1
+	waiter 2	priority 2
+	waiter 3	priority 2 with a deadline
+
+   Each waiter starts after the previous one is queued.  The extends must be sent in the order 1,
+   3, 2, 0, which the final PCR value shows.  The test fails if the blocker completes before all
+   the waiters are queued.
+*/
+
+static TPM_RC testScheduler(TSS_CONTEXT *tssContext)
+{
+    TPM_RC			rc = 0;
+#ifdef TPM_POSIX
+    TSS_SCHEDULER		*scheduler = NULL;
+    SCHEDULER_THREAD		blocker;
+    SCHEDULER_THREAD		waiters[4];
+    int				started = 0;	/* waiter threads started */
+    int				blockerStarted = FALSE;
+    uint32_t			commands;
+    uint32_t			queueDepth;
+    uint32_t			queueDepthMax;
+    uint64_t			waitTime;
+    uint64_t			waitTimeMax;
+    uint32_t			deadlineMisses;
+    TPMT_HA			expected;
+    uint8_t			extend[SHA256_DIGEST_SIZE];
+    int				i;
+    static const char		*priority[] = {"3", "1", "2", "2"};
+    static const char		*deadline[] = {"0", "0", "0", "60000"};
+    static const int		order[] = {1, 3, 2, 0};
+
+    /* reset PCR 16 before the transport context belongs to the scheduler */
+    if (rc == 0) {
+	PCR_Reset_In 		in;
+	in.pcrHandle = 16;
+	rc = TSS_Execute(tssContext,
+			 NULL,
+			 (COMMAND_PARAMETERS *)&in,
+			 NULL,
+			 TPM_CC_PCR_Reset,
+			 TPM_RS_PW, NULL, 0,
+			 TPM_RH_NULL, NULL, 0);
+    }
+    if (rc == 0) {
+	rc = TSS_Scheduler_Create(&scheduler, tssContext);
+    }
+    /* the blocker holds the connection */
+    if (rc == 0) {
+	rc = schedulerThreadStart(&blocker, scheduler, "8", "0", schedulerBlocker);
+    }
+    if (rc == 0) {
+	blockerStarted = TRUE;
+	rc = schedulerWait(scheduler, 1, 0);
+    }
+    /* queue the waiters one at a time, so that their arrival order is known */
+    for (i = 0 ; (rc == 0) && (i < 4) ; i++) {
+	waiters[i].extend = i + 1;
+	rc = schedulerThreadStart(&waiters[i], scheduler, priority[i], deadline[i],
+				  schedulerWaiter);
+	if (rc == 0) {
+	    started++;
+	    rc = schedulerWait(scheduler, 1, i + 1);
+	}
+    }
+    /* always join the started threads before deleting the scheduler */
+    if (blockerStarted) {
+	pthread_join(blocker.thread, NULL);
+	TSS_Delete(blocker.tssContext);
+    }
+    for (i = 0 ; i < started ; i++) {
+	pthread_join(waiters[i].thread, NULL);
+	if (rc == 0) {
+	    rc = waiters[i].rc;
+	}
+	TSS_Delete(waiters[i].tssContext);
+    }
+    if (scheduler != NULL) {
+	TSS_Scheduler_GetStatistics(scheduler, &commands, &queueDepth, &queueDepthMax,
+				    &waitTime, &waitTimeMax, &deadlineMisses);
+	if (verbose) printf("regcontext: scheduler commands %u queue depth max %u "
+			    "wait max %llu usec deadline misses %u\n",
+			    commands, queueDepthMax,
+			    (unsigned long long)waitTimeMax, deadlineMisses);
+	if ((rc == 0) && (queueDepthMax < 4)) {
+	    printf("regcontext: scheduler queue depth max %u, expected 4\n", queueDepthMax);
+	    rc = EXIT_FAILURE;
+	}
+	TSS_Scheduler_Delete(scheduler);
+    }
+    /* the expected PCR value, extended in the scheduled order */
+    if (rc == 0) {
+	expected.hashAlg = TPM_ALG_SHA256;
+	memset((uint8_t *)&expected.digest, 0, SHA256_DIGEST_SIZE);
+	for (i = 0 ; (rc == 0) && (i < 4) ; i++) {
+	    memset(extend, waiters[order[i]].extend, SHA256_DIGEST_SIZE);
+	    rc = TSS_Hash_Generate(&expected,
+				   SHA256_DIGEST_SIZE, (uint8_t *)&expected.digest,
+				   SHA256_DIGEST_SIZE, extend,
+				   0, NULL);
+	}
+    }
+    if (rc == 0) {
+	PCR_Read_In 		in;
+	PCR_Read_Out 		out;
+	in.pcrSelectionIn.count = 1;
+	in.pcrSelectionIn.pcrSelections[0].hash = TPM_ALG_SHA256;
+	in.pcrSelectionIn.pcrSelections[0].sizeofSelect = 3;
+	in.pcrSelectionIn.pcrSelections[0].pcrSelect[0] = 0;
+	in.pcrSelectionIn.pcrSelections[0].pcrSelect[1] = 0;
+	in.pcrSelectionIn.pcrSelections[0].pcrSelect[2] = 0x01;	/* PCR 16 */
+	rc = TSS_Execute(tssContext,
+			 (RESPONSE_PARAMETERS *)&out,
+			 (COMMAND_PARAMETERS *)&in,
+			 NULL,
+			 TPM_CC_PCR_Read,
+			 TPM_RH_NULL, NULL, 0);
+	if ((rc == 0) &&
+	    ((out.pcrValues.count != 1) ||
+	     (out.pcrValues.digests[0].t.size != SHA256_DIGEST_SIZE) ||
+	     (memcmp(out.pcrValues.digests[0].t.buffer, (uint8_t *)&expected.digest,
+		     SHA256_DIGEST_SIZE) != 0))) {
+	    printf("regcontext: PCR 16 does not match the scheduled order\n");
+	    rc = EXIT_FAILURE;
+	}
+    }
+#else
+    tssContext = tssContext;
+    printf("regcontext: the scheduler requires POSIX threads\n");
+    rc = EXIT_FAILURE;
+#endif	/* TPM_POSIX */
+    return rc;
+}
+
+#ifdef TPM_POSIX
+
+/* schedulerThreadStart() creates a TSS context that sends through the scheduler with priority and
+   deadline, and starts a thread that uses it */
+
+static TPM_RC schedulerThreadStart(SCHEDULER_THREAD *schedulerThread,
+				   TSS_SCHEDULER *scheduler,
+				   const char *priority,
+				   const char *deadline,
+				   void *(*startRoutine)(void *))
+{
+    TPM_RC	rc = 0;
+    int		irc;
+
+    schedulerThread->tssContext = NULL;
+    schedulerThread->rc = 0;
+    if (rc == 0) {
+	rc = TSS_Create(&schedulerThread->tssContext);
+    }
+    if (rc == 0) {
+	rc = TSS_SetProperty(schedulerThread->tssContext, TPM_SCHEDULER_PRIORITY, priority);
+    }
+    if (rc == 0) {
+	rc = TSS_SetProperty(schedulerThread->tssContext, TPM_SCHEDULER_DEADLINE, deadline);
+    }
+    if (rc == 0) {
+	rc = TSS_SetScheduler(schedulerThread->tssContext, scheduler);
+    }
+    if (rc == 0) {
+	irc = pthread_create(&schedulerThread->thread, NULL, startRoutine, schedulerThread);
+	if (irc != 0) {
+	    printf("regcontext: thread create failed %d\n", irc);
+	    rc = EXIT_FAILURE;
+	}
+    }
+    if ((rc != 0) && (schedulerThread->tssContext != NULL)) {
+	TSS_Delete(schedulerThread->tssContext);
+	schedulerThread->tssContext = NULL;
+    }
+    return rc;
+}
+
+/* schedulerBlocker() creates an RSA primary key in the NULL hierarchy, a slow command, and flushes
+   it.  Its result does not matter, only that it holds the connection. */
+
+static void *schedulerBlocker(void *arg)
+{
+    SCHEDULER_THREAD 		*blocker = arg;
+    TPM_RC			rc = 0;
+    CreatePrimary_In 		in;
+    CreatePrimary_Out 		out;
+
+    in.primaryHandle = TPM_RH_NULL;
+    in.inSensitive.sensitive.userAuth.t.size = 0;
+    in.inSensitive.sensitive.data.t.size = 0;
+    in.inPublic.publicArea.type = TPM_ALG_RSA;
+    in.inPublic.publicArea.nameAlg = TPM_ALG_SHA256;
+    in.inPublic.publicArea.objectAttributes.val = TPMA_OBJECT_FIXEDTPM |
+						  TPMA_OBJECT_FIXEDPARENT |
+						  TPMA_OBJECT_SENSITIVEDATAORIGIN |
+						  TPMA_OBJECT_USERWITHAUTH |
+						  TPMA_OBJECT_SIGN;
+    in.inPublic.publicArea.authPolicy.t.size = 0;
+    in.inPublic.publicArea.parameters.rsaDetail.symmetric.algorithm = TPM_ALG_NULL;
+    in.inPublic.publicArea.parameters.rsaDetail.scheme.scheme = TPM_ALG_NULL;
+    in.inPublic.publicArea.parameters.rsaDetail.keyBits = 2048;
+    in.inPublic.publicArea.parameters.rsaDetail.exponent = 0;
+    in.inPublic.publicArea.unique.rsa.t.size = 0;
+    in.outsideInfo.t.size = 0;
+    in.creationPCR.count = 0;
+    rc = TSS_Execute(blocker->tssContext,
+		     (RESPONSE_PARAMETERS *)&out,
+		     (COMMAND_PARAMETERS *)&in,
+		     NULL,
+		     TPM_CC_CreatePrimary,
+		     TPM_RS_PW, NULL, 0,
+		     TPM_RH_NULL, NULL, 0);
+    if (rc == 0) {
+	FlushContext_In 	flushIn;
+	flushIn.flushHandle = out.objectHandle;
+	TSS_Execute(blocker->tssContext,
+		    NULL,
+		    (COMMAND_PARAMETERS *)&flushIn,
+		    NULL,
+		    TPM_CC_FlushContext,
+		    TPM_RH_NULL, NULL, 0);
+    }
+    if (verbose) printf("regcontext: blocker create primary rc %08x\n", rc);
+    return NULL;
+}
+
+/* schedulerWaiter() extends PCR 16 with a digest of the waiter's extend byte */
+
+static void *schedulerWaiter(void *arg)
+{
+    SCHEDULER_THREAD 		*waiter = arg;
+    PCR_Extend_In 		in;
+
+    in.pcrHandle = 16;
+    in.digests.count = 1;
+    in.digests.digests[0].hashAlg = TPM_ALG_SHA256;
+    memset((uint8_t *)&in.digests.digests[0].digest, waiter->extend, SHA256_DIGEST_SIZE);
+    waiter->rc = TSS_Execute(waiter->tssContext,
+			     NULL,
+			     (COMMAND_PARAMETERS *)&in,
+			     NULL,
+			     TPM_CC_PCR_Extend,
+			     TPM_RS_PW, NULL, 0,
+			     TPM_RH_NULL, NULL, 0);
+    if (verbose) printf("regcontext: waiter %u extend rc %08x\n", waiter->extend, waiter->rc);
+    return NULL;
+}
+
+/* schedulerWait() polls the scheduler statistics until at least 'commands' commands were sent and
+   at least 'queueDepth' commands are waiting.  It gives up after 10 seconds.
+*/
+
+static TPM_RC schedulerWait(TSS_SCHEDULER *scheduler,
+			    uint32_t commands,
+			    uint32_t queueDepth)
+{
+    TPM_RC			rc = 0;
+    uint32_t			schedulerCommands;
+    uint32_t			schedulerQueueDepth;
+    uint32_t			queueDepthMax;
+    uint64_t			waitTime;
+    uint64_t			waitTimeMax;
+    uint32_t			deadlineMisses;
+    struct timespec 		delay;
+    int				polls;
+    int				done = FALSE;
+
+    delay.tv_sec = 0;
+    delay.tv_nsec = 1000000;	/* 1 msec */
+    for (polls = 0 ; (rc == 0) && !done ; polls++) {
+	rc = TSS_Scheduler_GetStatistics(scheduler, &schedulerCommands, &schedulerQueueDepth,
+					 &queueDepthMax, &waitTime, &waitTimeMax,
+					 &deadlineMisses);
+	if (rc == 0) {
+	    if ((schedulerCommands >= commands) && (schedulerQueueDepth >= queueDepth)) {
+		done = TRUE;
+	    }
+	    else if (polls >= 10000) {
+		printf("regcontext: scheduler commands %u queue depth %u, "
+		       "the blocking command completed too soon\n",
+		       schedulerCommands, schedulerQueueDepth);
+		rc = EXIT_FAILURE;
+	    }
+	    else {
+		nanosleep(&delay, NULL);
+	    }
+	}
+    }
+    return rc;
+}
+
+#endif	/* TPM_POSIX */
+
+/* getCapabilityCount() returns the number of entries in the capability list */
+
+static uint32_t getCapabilityCount(const TPMS_CAPABILITY_DATA *capabilityData)
+{
+    uint32_t count;
+
+    switch (capabilityData->capability) {
+      case TPM_CAP_ALGS:
+	count = capabilityData->data.algorithms.count;
+	break;
+      case TPM_CAP_COMMANDS:
+	count = capabilityData->data.command.count;
+	break;
+      case TPM_CAP_TPM_PROPERTIES:
+	count = capabilityData->data.tpmProperties.count;
+	break;
+      default:
+	count = 0;
+    }
+    return count;
+}
+
+/* getCapabilityEntry() returns the property and value of entry i of the capability list */
+
+static void getCapabilityEntry(uint32_t *key,
+			       uint32_t *value,
+			       const TPMS_CAPABILITY_DATA *capabilityData,
+			       uint32_t i)
+{
+    switch (capabilityData->capability) {
+      case TPM_CAP_ALGS:
+	*key = capabilityData->data.algorithms.algProperties[i].alg;
+	*value = capabilityData->data.algorithms.algProperties[i].algProperties.val;
+	break;
+      case TPM_CAP_COMMANDS:
+	*key = capabilityData->data.command.commandAttributes[i].val & TPMA_CC_COMMANDINDEX;
+	*value = capabilityData->data.command.commandAttributes[i].val;
+	break;
+      case TPM_CAP_TPM_PROPERTIES:
+	*key = capabilityData->data.tpmProperties.tpmProperty[i].property;
+	*value = capabilityData->data.tpmProperties.tpmProperty[i].value;
+	break;
+      default:
+	*key = 0;
+	*value = 0;
+    }
+    return;
+}
+
+/* getCommandCount() returns the number of commands the context has sent to the TPM */
+
+static uint32_t getCommandCount(TSS_CONTEXT *tssContext)
+{
+    uint32_t	socketCommands;
+    uint32_t	writes;
+    uint32_t	reads;
+    uint32_t	devCommands;
+    uint32_t	timeouts;
+    uint64_t	waitTime;
+    uint64_t	processTime;
+
+    TSS_GetSocketStatistics(tssContext, &socketCommands, &writes, &reads);
+    TSS_GetDeviceStatistics(tssContext, &devCommands, &timeouts, &waitTime, &processTime);
+    return socketCommands + devCommands;
+}
+
+static void printUsage(void)
+{
+    printf("\n");
+    printf("regcontext\n");
+    printf("\n");
+    printf("Runs regression tests that need several commands in one TSS context\n");
+    printf("\n");
+    printf("\t-cap capability paging and cache\n");
+    printf("\t\t[-clear TPM2_Clear invalidates the cache (platform auth empty)]\n");
+    printf("\t\t[-startup power cycle, TPM2_Startup invalidates the cache (simulator)]\n");
+    printf("\t-name Name cache hit path\n");
+    printf("\t\t-ho loaded object handle\n");
+    printf("\t-cphash TSS_GetCpHash() for several hash algorithms\n");
+    printf("\t\t-icp SHA-1 cpHash of TPM2_ClockRateAdjust(platform, 0) file\n");
+    printf("\t-sched scheduler order, extends PCR 16\n");
+    exit(1);	
+}
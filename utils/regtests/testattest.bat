@@ -88,9 +88,11 @@ for %%S in ("" "-se0 02000000 1") do (
 
 		IF "%%A" == "rsa" (
 		   set K=80000001
+		   set P=signpub.bin
 		)
 		IF "%%A" == "ecc" (
 		   set K=80000002
+		   set P=signeccpub.bin
 		)		
 
 		echo "Signing Key Self Certify %%H %%A %%~S"
@@ -117,6 +119,24 @@ for %%S in ("" "-se0 02000000 1") do (
 		exit /B 1
 		)
 	
+		echo "Check the %%A quote %%H offline"
+		%TPM_EXE_PATH%checkquote -ipu !P! -is sig.bin -ia tmp.bin -qd policies/aaa > run.out
+		IF !ERRORLEVEL! NEQ 0 (
+		exit /B 1
+		)
+	
+		echo "Check the %%A quote %%H offline, worker threads"
+		%TPM_EXE_PATH%checkquote -ipu !P! -is sig.bin -ia tmp.bin -qd policies/aaa -it 4 -th 2 > run.out
+		IF !ERRORLEVEL! NEQ 0 (
+		exit /B 1
+		)
+	
+		echo "Check the %%A quote %%H offline, wrong nonce - should fail"
+		%TPM_EXE_PATH%checkquote -ipu !P! -is sig.bin -ia tmp.bin -qd policies/zero8.bin > run.out
+		IF !ERRORLEVEL! EQU 0 (
+		exit /B 1
+		)
+	
 		echo "Get Time %%H %%A %%~S"
 		%TPM_EXE_PATH%gettime -hk !K! -halg %%H -pwdk sig %%~S -os sig.bin -oa tmp.bin -qd policies/aaa -salg %%A > run.out
 		IF !ERRORLEVEL! NEQ 0 (
@@ -284,7 +304,7 @@ for %%S in ("" "-se0 02000000 1") do (
        )
     
        echo "Get Session Audit Digest %%~S"
-       %TPM_EXE_PATH%getsessionauditdigest -hs 02000001 -hk 80000001 -pwdk sig -os sig.bin -oa tmp.bin %%~S -qd policies/aaa > run.out
+       %TPM_EXE_PATH%getsessionauditdigest -hs 02000001 -hk 80000001 -pwdk sig -os sig.bin -oa tmp.bin %%~S -qd policies/aaa -cd > run.out
        IF !ERRORLEVEL! NEQ 0 (
            exit /B 1
        )
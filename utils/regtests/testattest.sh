@@ -83,8 +83,10 @@ do
 
 	    if [ ${SALG} == rsa ]; then
 		HANDLE=80000001
+		PUB=signpub.bin
 	    else
 		HANDLE=80000002
+		PUB=signeccpub.bin
 	    fi
 
 	    echo "Signing Key Self Certify ${HALG} ${SALG} ${SESS}"
@@ -103,6 +105,18 @@ do
 	    ${PREFIX}verifysignature -hk ${HANDLE} -halg ${HALG} -if tmp.bin -is sig.bin > run.out
 	    checkSuccess $?
 
+	    echo "Check the ${SALG} quote ${HALG} offline"
+	    ${PREFIX}checkquote -ipu ${PUB} -is sig.bin -ia tmp.bin -qd policies/aaa > run.out
+	    checkSuccess $?
+
+	    echo "Check the ${SALG} quote ${HALG} offline, worker threads"
+	    ${PREFIX}checkquote -ipu ${PUB} -is sig.bin -ia tmp.bin -qd policies/aaa -it 4 -th 2 > run.out
+	    checkSuccess $?
+
+	    echo "Check the ${SALG} quote ${HALG} offline, wrong nonce - should fail"
+	    ${PREFIX}checkquote -ipu ${PUB} -is sig.bin -ia tmp.bin -qd policies/zero8.bin > run.out
+	    checkFailure $?
+
 	    echo "Get Time ${HALG} ${SALG} ${SESS}"
 	    ${PREFIX}gettime -hk ${HANDLE} -halg ${HALG} -pwdk sig ${SESS} -os sig.bin -oa tmp.bin -qd policies/aaa -salg ${SALG} > run.out
 	    checkSuccess $?
@@ -229,7 +243,7 @@ do
 	checkSuccess $?
 
 	echo "Get Session Audit Digest ${SESS}"
-	${PREFIX}getsessionauditdigest -hs 02000001 -hk 80000001 -pwdk sig -os sig.bin -oa tmp.bin ${SESS} -qd policies/aaa > run.out
+	${PREFIX}getsessionauditdigest -hs 02000001 -hk 80000001 -pwdk sig -os sig.bin -oa tmp.bin ${SESS} -qd policies/aaa -cd > run.out
 	checkSuccess $?
 
 	echo "Verify the signature"
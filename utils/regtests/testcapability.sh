@@ -0,0 +1,75 @@
+#!/bin/bash
+#
+
+#################################################################################
+#										#
+#			TPM2 regression test					#
+#		       IBM Thomas J. Watson Research Center			#
+#	$Id: testcapability.sh $						#
+#										#
+# (c) Copyright IBM Corporation 2017						#
+# 										#
+# All rights reserved.								#
+# 										#
+# Redistribution and use in source and binary forms, with or without		#
+# modification, are permitted provided that the following conditions are	#
+# met:										#
+# 										#
+# Redistributions of source code must retain the above copyright notice,	#
+# this list of conditions and the following disclaimer.				#
+# 										#
+# Redistributions in binary form must reproduce the above copyright		#
+# notice, this list of conditions and the following disclaimer in the		#
+# documentation and/or other materials provided with the distribution.		#
+# 										#
+# Neither the names of the IBM Corporation nor the names of its			#
+# contributors may be used to endorse or promote products derived from		#
+# this software without specific prior written permission.			#
+# 										#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS		#
+# "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT		#
+# LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR		#
+# A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT		#
+# HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,	#
+# SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT		#
+# LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,		#
+# DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY		#
+# THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT		#
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE		#
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.		#
+#										#
+#################################################################################
+
+# regcontext runs the tests that need several commands in one TSS context.  The capability cache
+# test clears the TPM with the platform hierarchy, so it runs after the hierarchy tests restore
+# the platform auth.
+
+echo ""
+echo "Capability Cache"
+echo ""
+
+echo "Get capability commands, one per command"
+${PREFIX}getcapability -cap 2 -pc 1 > run.out
+checkSuccess $?
+
+echo "Capability paging and cache, Clear invalidates the cache"
+${PREFIX}regcontext -cap -clear > run.out
+checkSuccess $?
+
+# the power cycle only works with the simulator
+
+if [ -z ${TPM_INTERFACE_TYPE} ] || [ ${TPM_INTERFACE_TYPE} == "socsim" ];  then
+    if [ -z ${TPM_SERVER_TYPE} ] || [ ${TPM_SERVER_TYPE} == "mssim" ]; then
+
+	echo "Power cycle, Startup invalidates the cache"
+	${PREFIX}regcontext -cap -startup > run.out
+	checkSuccess $?
+
+	echo "Recreate a platform primary storage key"
+	${PREFIX}createprimary -hi p -pwdk pps > run.out
+	checkSuccess $?
+
+    fi
+fi
+
+# ${PREFIX}getcapability -cap 1 -pr 80000000
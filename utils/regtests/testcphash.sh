@@ -0,0 +1,59 @@
+#!/bin/bash
+#
+
+#################################################################################
+#										#
+#			TPM2 regression test					#
+#		       IBM Thomas J. Watson Research Center			#
+#	$Id: testcphash.sh $							#
+#										#
+# (c) Copyright IBM Corporation 2017						#
+# 										#
+# All rights reserved.								#
+# 										#
+# Redistribution and use in source and binary forms, with or without		#
+# modification, are permitted provided that the following conditions are	#
+# met:										#
+# 										#
+# Redistributions of source code must retain the above copyright notice,	#
+# this list of conditions and the following disclaimer.				#
+# 										#
+# Redistributions in binary form must reproduce the above copyright		#
+# notice, this list of conditions and the following disclaimer in the		#
+# documentation and/or other materials provided with the distribution.		#
+# 										#
+# Neither the names of the IBM Corporation nor the names of its			#
+# contributors may be used to endorse or promote products derived from		#
+# this software without specific prior written permission.			#
+# 										#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS		#
+# "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT		#
+# LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR		#
+# A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT		#
+# HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,	#
+# SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT		#
+# LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,		#
+# DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY		#
+# THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT		#
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE		#
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.		#
+#										#
+#################################################################################
+
+# policies/policycphashhash.bin is the SHA-1 cpHash of TPM2_ClockRateAdjust(TPM_RH_PLATFORM, 0),
+# used by the policycphash regression test.  regcontext calculates the cpHash for several hash
+# algorithms with TSS_GetCpHash() and checks it against the file and an independent hash.
+
+echo ""
+echo "cpHash"
+echo ""
+
+echo "TSS_GetCpHash of ClockRateAdjust, SHA-1, SHA-256, SHA-384"
+${PREFIX}regcontext -cphash -icp policies/policycphashhash.bin > run.out
+checkSuccess $?
+
+echo "TSS_GetCpHash against a bad cpHash file"
+${PREFIX}regcontext -cphash -icp policies/policyccsign.bin > run.out
+checkFailure $?
+
+# ${PREFIX}getcapability -cap 1 -pr 80000000
@@ -0,0 +1,67 @@
+#!/bin/bash
+#
+
+#################################################################################
+#										#
+#			TPM2 regression test					#
+#		       IBM Thomas J. Watson Research Center			#
+#	$Id: testeventreplay.sh $						#
+#										#
+# (c) Copyright IBM Corporation 2017						#
+# 										#
+# All rights reserved.								#
+# 										#
+# Redistribution and use in source and binary forms, with or without		#
+# modification, are permitted provided that the following conditions are	#
+# met:										#
+# 										#
+# Redistributions of source code must retain the above copyright notice,	#
+# this list of conditions and the following disclaimer.				#
+# 										#
+# Redistributions in binary form must reproduce the above copyright		#
+# notice, this list of conditions and the following disclaimer in the		#
+# documentation and/or other materials provided with the distribution.		#
+# 										#
+# Neither the names of the IBM Corporation nor the names of its			#
+# contributors may be used to endorse or promote products derived from		#
+# this software without specific prior written permission.			#
+# 										#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS		#
+# "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT		#
+# LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR		#
+# A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT		#
+# HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,	#
+# SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT		#
+# LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,		#
+# DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY		#
+# THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT		#
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE		#
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.		#
+#										#
+#################################################################################
+
+# policies/eventreplay.bin is a small little endian TPM 2.0 event log with SHA-1, SHA-256, and SM3
+# banks.  SM3 is unknown to the TSS, so its digests are skipped.  It holds a StartupLocality 3
+# event, a PCR 7 event larger than TCG_EVENT_LEN_MAX with its digests in a different order than
+# the banks, and a PCR 17 event.  policies/eventreplay.txt holds the PCR values calculated
+# independently of the TSS.
+
+echo ""
+echo "Event log replay"
+echo ""
+
+echo "Replay the event log"
+${PREFIX}eventreplay -if policies/eventreplay.bin > tmpeventreplay.txt
+checkSuccess $?
+
+echo "Verify the replayed PCRs"
+diff tmpeventreplay.txt policies/eventreplay.txt
+checkSuccess $?
+
+echo "Replay a truncated event log"
+head -c 1000 policies/eventreplay.bin > tmpeventreplay.bin
+${PREFIX}eventreplay -if tmpeventreplay.bin > run.out
+checkFailure $?
+
+rm -f tmpeventreplay.txt
+rm -f tmpeventreplay.bin
@@ -95,6 +95,18 @@ for %%H in (sha1 sha256 sha384) do (
 	   exit /B 1
 	)
 
+	echo "HMAC %%H stream using the keyed hash key, message from file %%~S"
+	%TPM_EXE_PATH%hmac -hk 80000001 -if msg.bin -stream -os tmp.bin -pwdk khk -halg %%H %%~S > run.out
+	IF !ERRORLEVEL! NEQ 0 (
+	   exit /B 1
+	)
+
+	echo "Verify the streamed HMAC %%H"
+	diff sig.bin tmp.bin > run.out
+	IF !ERRORLEVEL! NEQ 0 (
+	   exit /B 1
+	)
+
 	echo "HMAC %%H using the keyed hash key, message from command line %%~S"
 	%TPM_EXE_PATH%hmac -hk 80000001 -ic 1234567890123456 -os sig.bin -pwdk khk -halg %%H %%~S > run.out
 	IF !ERRORLEVEL! NEQ 0 (
@@ -177,6 +189,30 @@ for %%H in (sha1 sha256 sha384) do (
 	   exit /B 1
 	)
 
+	echo "Hash %%H stream in software, data from file"
+	%TPM_EXE_PATH%hash -hi p -halg %%H -if policies/aaa -stream -oh tmp.bin > run.out
+	IF !ERRORLEVEL! NEQ 0 (
+	   exit /B 1
+	)
+
+	echo "Verify the streamed hash %%H"
+	diff tmp.bin policies/%%Haaa.bin > run.out
+	IF !ERRORLEVEL! NEQ 0 (
+	   exit /B 1
+	)
+
+	echo "Hash %%H stream through a TPM sequence, data from file"
+	%TPM_EXE_PATH%hash -hi p -halg %%H -if policies/aaa -stream -tpm -oh tmp.bin > run.out
+	IF !ERRORLEVEL! NEQ 0 (
+	   exit /B 1
+	)
+
+	echo "Verify the streamed hash %%H"
+	diff tmp.bin policies/%%Haaa.bin > run.out
+	IF !ERRORLEVEL! NEQ 0 (
+	   exit /B 1
+	)
+
 	echo "Hash %%H in one cal, data on command linel"
 	%TPM_EXE_PATH%hash -hi p -halg %%H -ic aaa -oh tmp.bin > run.out
 	IF !ERRORLEVEL! NEQ 0 (
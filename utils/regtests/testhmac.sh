@@ -84,6 +84,14 @@ do
 	diff sig.bin tmp.bin
 	checkSuccess $?
 
+	echo "HMAC ${HALG} stream using the keyed hash key, message from file ${SESS}"
+	${PREFIX}hmac -hk 80000001 -if msg.bin -stream -os tmp.bin -pwdk khk -halg ${HALG} ${SESS} > run.out
+	checkSuccess $?
+
+	echo "Verify the streamed HMAC ${HALG}"
+	diff sig.bin tmp.bin
+	checkSuccess $?
+
 	echo "HMAC ${HALG} using the keyed hash key, message from command line ${SESS}"
 	${PREFIX}hmac -hk 80000001 -ic 1234567890123456 -os sig.bin -pwdk khk -halg ${HALG} ${SESS} > run.out
 	checkSuccess $?
@@ -145,6 +153,22 @@ do
 	diff tmp.bin policies/${HALG}aaa.bin > run.out
 	checkSuccess $?
 
+	echo "Hash ${HALG} stream in software, data from file"
+	${PREFIX}hash -hi p -halg ${HALG} -if policies/aaa -stream -oh tmp.bin > run.out
+	checkSuccess $?
+
+	echo "Verify the streamed hash ${HALG}"
+	diff tmp.bin policies/${HALG}aaa.bin > run.out
+	checkSuccess $?
+
+	echo "Hash ${HALG} stream through a TPM sequence, data from file"
+	${PREFIX}hash -hi p -halg ${HALG} -if policies/aaa -stream -tpm -oh tmp.bin > run.out
+	checkSuccess $?
+
+	echo "Verify the streamed hash ${HALG}"
+	diff tmp.bin policies/${HALG}aaa.bin > run.out
+	checkSuccess $?
+
 	echo "Hash ${HALG} in one call, data on command line"
 	${PREFIX}hash -hi p -halg ${HALG} -ic aaa -oh tmp.bin > run.out
 	checkSuccess $?
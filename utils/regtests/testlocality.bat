@@ -0,0 +1,107 @@
+REM #############################################################################
+REM #										#
+REM #			TPM2 regression test					#
+REM #		       IBM Thomas J. Watson Research Center			#
+REM #		$Id: testlocality.bat $					#
+REM #										#
+REM # (c) Copyright IBM Corporation 2017					#
+REM # 										#
+REM # All rights reserved.							#
+REM # 										#
+REM # Redistribution and use in source and binary forms, with or without	#
+REM # modification, are permitted provided that the following conditions are	#
+REM # met:									#
+REM # 										#
+REM # Redistributions of source code must retain the above copyright notice,	#
+REM # this list of conditions and the following disclaimer.			#
+REM # 										#
+REM # Redistributions in binary form must reproduce the above copyright		#
+REM # notice, this list of conditions and the following disclaimer in the	#
+REM # documentation and/or other materials provided with the distribution.	#
+REM # 										#
+REM # Neither the names of the IBM Corporation nor the names of its		#
+REM # contributors may be used to endorse or promote products derived from	#
+REM # this software without specific prior written permission.			#
+REM # 										#
+REM # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS	#
+REM # "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT		#
+REM # LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR	#
+REM # A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT	#
+REM # HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,	#
+REM # SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT		#
+REM # LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,	#
+REM # DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY	#
+REM # THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT	#
+REM # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE	#
+REM # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.	#
+REM #										#
+REM #############################################################################
+
+setlocal enableDelayedExpansion
+
+REM # Locality is carried in the MS simulator packet, so these tests only
+REM # run against the simulator.  The concurrent workers are in testlocality.sh.
+
+echo ""
+echo "Locality"
+echo ""
+
+echo "Define an NV index with policy locality 3"
+%TPM_EXE_PATH%nvdefinespace -hi o -ha 01000000 -sz 16 -pol policies/policylocality3.bin > run.out
+IF !ERRORLEVEL! NEQ 0 (
+   exit /B 1
+)
+
+echo "Set locality 5 - should fail"
+set TPM_LOCALITY=5
+%TPM_EXE_PATH%getrandom -by 8 > run.out
+IF !ERRORLEVEL! EQU 0 (
+   exit /B 1
+)
+
+for %%L in (3 0) do (
+
+    set TPM_LOCALITY=%%L
+
+    echo "Start a policy session at locality %%L"
+    %TPM_EXE_PATH%startauthsession -se p > run.out
+    IF !ERRORLEVEL! NEQ 0 (
+       exit /B 1
+    )
+
+    echo "Policy locality 3"
+    %TPM_EXE_PATH%policylocality -ha 03000000 -loc 08 > run.out
+    IF !ERRORLEVEL! NEQ 0 (
+       exit /B 1
+    )
+
+    echo "Write the NV index at locality %%L"
+    %TPM_EXE_PATH%nvwrite -ha 01000000 -ic locality -se0 03000000 0 > run.out
+    IF %%L EQU 3 (
+       IF !ERRORLEVEL! NEQ 0 (
+          exit /B 1
+       )
+    ) ELSE (
+       IF !ERRORLEVEL! EQU 0 (
+          exit /B 1
+       )
+       %TPM_EXE_PATH%flushcontext -ha 03000000 > run.out
+       IF !ERRORLEVEL! NEQ 0 (
+          exit /B 1
+       )
+    )
+)
+
+set TPM_LOCALITY=0
+
+echo "Undefine the NV index"
+%TPM_EXE_PATH%nvundefinespace -hi o -ha 01000000 > run.out
+IF !ERRORLEVEL! NEQ 0 (
+   exit /B 1
+)
+
+exit /B 0
+
+REM getcapability -cap 1 -pr 80000000
+REM getcapability -cap 1 -pr 02000000
+REM getcapability -cap 1 -pr 03000000
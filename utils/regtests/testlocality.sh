@@ -0,0 +1,144 @@
+#!/bin/bash
+#
+
+#################################################################################
+#										#
+#			TPM2 regression test					#
+#		       IBM Thomas J. Watson Research Center			#
+#	$Id: testlocality.sh $						#
+#										#
+# (c) Copyright IBM Corporation 2017						#
+# 										#
+# All rights reserved.								#
+# 										#
+# Redistribution and use in source and binary forms, with or without		#
+# modification, are permitted provided that the following conditions are	#
+# met:										#
+# 										#
+# Redistributions of source code must retain the above copyright notice,	#
+# this list of conditions and the following disclaimer.				#
+# 										#
+# Redistributions in binary form must reproduce the above copyright		#
+# notice, this list of conditions and the following disclaimer in the		#
+# documentation and/or other materials provided with the distribution.		#
+# 										#
+# Neither the names of the IBM Corporation nor the names of its			#
+# contributors may be used to endorse or promote products derived from		#
+# this software without specific prior written permission.			#
+# 										#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS		#
+# "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT		#
+# LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR		#
+# A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT		#
+# HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,	#
+# SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT		#
+# LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,		#
+# DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY		#
+# THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT		#
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE		#
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.		#
+#										#
+#################################################################################
+
+# Locality is carried in the MS simulator packet, so these tests only run against the simulator
+# with the mssim server type.  See reg.sh.
+
+# The NV index policy is PolicyLocality 3, see policies/policylocality3.txt.
+#
+# The simulator serves one connection at a time, so each utility (one TSS context, one
+# connection) runs to completion before the next, but the commands of concurrent workers at
+# different localities interleave.
+
+# localityWorker() runs one policy session at locality $1 and writes the NV index.  $2 is 0 if
+# the write should succeed, 1 if it should fail.  Each worker uses its own output file and session
+# handle, since they run concurrently.
+
+localityWorker ()
+{
+    export TPM_LOCALITY=$1
+    for ((ITER = 0 ; ITER < 4 ; ITER++))
+    do
+	${PREFIX}startauthsession -se p > run$1.out || return 1
+	SESSION=`awk '/^Handle/ {print $2}' run$1.out`
+	${PREFIX}policylocality -ha ${SESSION} -loc 08 > run$1.out || return 1
+	${PREFIX}nvwrite -ha 01000000 -ic loc$1 -se0 ${SESSION} 0 > run$1.out
+	RC=$?
+	if [ $RC -ne 0 ]; then
+	    # a failed command does not consume the session
+	    ${PREFIX}flushcontext -ha ${SESSION} > run$1.out || return 1
+	fi
+	if [ $2 -eq 0 ] && [ $RC -ne 0 ]; then
+	    return 1
+	fi
+	if [ $2 -ne 0 ] && [ $RC -eq 0 ]; then
+	    return 1
+	fi
+    done
+    return 0
+}
+
+echo ""
+echo "Locality"
+echo ""
+
+echo "Define an NV index with policy locality 3"
+${PREFIX}nvdefinespace -hi o -ha 01000000 -sz 16 -pol policies/policylocality3.bin > run.out
+checkSuccess $?
+
+echo "Set locality 5 - should fail"
+TPM_LOCALITY=5 ${PREFIX}getrandom -by 8 > run.out
+checkFailure $?
+
+echo "Write the NV index at locality 3, policy locality 3"
+localityWorker 3 0 > run.out
+checkSuccess $?
+
+echo "Write the NV index at locality 0, policy locality 3 - should fail"
+localityWorker 0 0 > run.out
+checkFailure $?
+
+echo "Read the NV index at locality 3, policy locality 3"
+TPM_LOCALITY=3 ${PREFIX}startauthsession -se p > run.out
+checkSuccess $?
+SESSION=`awk '/^Handle/ {print $2}' run.out`
+TPM_LOCALITY=3 ${PREFIX}policylocality -ha ${SESSION} -loc 08 > run.out
+checkSuccess $?
+TPM_LOCALITY=3 ${PREFIX}nvread -ha 01000000 -sz 4 -se0 ${SESSION} 0 > run.out
+checkSuccess $?
+
+echo "Concurrent workers at localities 0, 3, 3, 0"
+localityWorker 0 1 > /dev/null &
+PID0=$!
+localityWorker 3 0 > /dev/null &
+PID1=$!
+localityWorker 3 0 > /dev/null &
+PID2=$!
+localityWorker 0 1 > /dev/null &
+PID3=$!
+
+echo "Locality 0 worker, writes should fail"
+wait ${PID0}
+checkSuccess $?
+
+echo "Locality 3 worker, writes should succeed"
+wait ${PID1}
+checkSuccess $?
+
+echo "Locality 3 worker, writes should succeed"
+wait ${PID2}
+checkSuccess $?
+
+echo "Locality 0 worker, writes should fail"
+wait ${PID3}
+checkSuccess $?
+
+echo "Undefine the NV index"
+${PREFIX}nvundefinespace -hi o -ha 01000000 > run.out
+checkSuccess $?
+
+rm -f run0.out
+rm -f run3.out
+
+# ${PREFIX}getcapability -cap 1 -pr 80000000
+# ${PREFIX}getcapability -cap 1 -pr 02000000
+# ${PREFIX}getcapability -cap 1 -pr 03000000
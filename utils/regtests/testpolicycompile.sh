@@ -0,0 +1,77 @@
+#!/bin/bash
+#
+
+#################################################################################
+#										#
+#			TPM2 regression test					#
+#		       IBM Thomas J. Watson Research Center			#
+#	$Id: testpolicycompile.sh $						#
+#										#
+# (c) Copyright IBM Corporation 2017						#
+# 										#
+# All rights reserved.								#
+# 										#
+# Redistribution and use in source and binary forms, with or without		#
+# modification, are permitted provided that the following conditions are	#
+# met:										#
+# 										#
+# Redistributions of source code must retain the above copyright notice,	#
+# this list of conditions and the following disclaimer.				#
+# 										#
+# Redistributions in binary form must reproduce the above copyright		#
+# notice, this list of conditions and the following disclaimer in the		#
+# documentation and/or other materials provided with the distribution.		#
+# 										#
+# Neither the names of the IBM Corporation nor the names of its			#
+# contributors may be used to endorse or promote products derived from		#
+# this software without specific prior written permission.			#
+# 										#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS		#
+# "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT		#
+# LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR		#
+# A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT		#
+# HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,	#
+# SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT		#
+# LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,		#
+# DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY		#
+# THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT		#
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE		#
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.		#
+#										#
+#################################################################################
+
+# policies/policycompile.txt describes policies that the policy regression tests calculate with
+# policymaker.  policycompile must produce the same digests.
+
+echo ""
+echo "Policy compile"
+echo ""
+
+echo "Compile the policy descriptions"
+${PREFIX}policycompile -if policies/policycompile.txt -od . > run.out
+checkSuccess $?
+
+echo "Verify the command code sign policy"
+diff tmpccsign.bin policies/policyccsign.bin
+checkSuccess $?
+
+echo "Verify the command code quote policy"
+diff tmpccquote.bin policies/policyccquote.bin
+checkSuccess $?
+
+echo "Verify the policy OR of sign and quote"
+diff tmpor.bin policies/policyor.bin
+checkSuccess $?
+
+echo "Verify the PCR 16 aaa SHA-256 policy"
+diff tmppcr16aaasha256.bin policies/policypcr16aaasha256.bin
+checkSuccess $?
+
+echo "Verify a different policy, mismatch"
+diff tmpccsign.bin policies/policyccquote.bin > run.out
+checkFailure $?
+
+rm -f tmpccsign.bin
+rm -f tmpccquote.bin
+rm -f tmpor.bin
+rm -f tmppcr16aaasha256.bin
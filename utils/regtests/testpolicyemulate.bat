@@ -0,0 +1,323 @@
+REM #############################################################################
+REM #										#
+REM #			TPM2 regression test					#
+REM #		       IBM Thomas J. Watson Research Center			#
+REM #		$Id: testpolicyemulate.bat $					#
+REM #										#
+REM # (c) Copyright IBM Corporation 2017					#
+REM # 										#
+REM # All rights reserved.							#
+REM # 										#
+REM # Redistribution and use in source and binary forms, with or without	#
+REM # modification, are permitted provided that the following conditions are	#
+REM # met:									#
+REM # 										#
+REM # Redistributions of source code must retain the above copyright notice,	#
+REM # this list of conditions and the following disclaimer.			#
+REM # 										#
+REM # Redistributions in binary form must reproduce the above copyright		#
+REM # notice, this list of conditions and the following disclaimer in the	#
+REM # documentation and/or other materials provided with the distribution.	#
+REM # 										#
+REM # Neither the names of the IBM Corporation nor the names of its		#
+REM # contributors may be used to endorse or promote products derived from	#
+REM # this software without specific prior written permission.			#
+REM # 										#
+REM # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS	#
+REM # "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT		#
+REM # LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR	#
+REM # A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT	#
+REM # HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,	#
+REM # SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT		#
+REM # LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,	#
+REM # DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY	#
+REM # THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT	#
+REM # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE	#
+REM # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.	#
+REM #										#
+REM #############################################################################
+
+setlocal enableDelayedExpansion
+
+REM # With TPM_POLICY_EMULATE set, the TSS runs trial sessions itself.
+REM # Each policy is calculated in a TPM trial session and in an emulated
+REM # trial session.  Both digests must match the policymaker digest.
+REM # The emulated session handles are read from the startauthsession
+REM # output.
+
+echo ""
+echo "Policy Emulation"
+echo ""
+
+for %%E in (0 1) do (
+
+    set TPM_POLICY_EMULATE=%%E
+
+    for %%P in ("15d policyccsign" "158 policyccquote" "148 policycccertify" "147 policyccactivate" "14b policyccduplicate") do (
+
+	for /f "tokens=1,2" %%C in (%%P) do (
+
+	    echo "Start a trial policy session, emulate %%E"
+	    %TPM_EXE_PATH%startauthsession -se t > run.out
+	    IF !ERRORLEVEL! NEQ 0 (
+	       exit /B 1
+	    )
+	    for /f "tokens=2" %%H in ('findstr /b Handle run.out') do set SH=%%H
+
+	    echo "Policy command code %%C"
+	    %TPM_EXE_PATH%policycommandcode -ha !SH! -cc %%C > run.out
+	    IF !ERRORLEVEL! NEQ 0 (
+	       exit /B 1
+	    )
+
+	    echo "Policy get digest"
+	    %TPM_EXE_PATH%policygetdigest -ha !SH! -of tmppol.bin > run.out
+	    IF !ERRORLEVEL! NEQ 0 (
+	       exit /B 1
+	    )
+
+	    echo "Verify the %%D digest"
+	    fc /b policies\%%D.bin tmppol.bin > run.out
+	    IF !ERRORLEVEL! NEQ 0 (
+	       exit /B 1
+	    )
+
+	    echo "Flush the policy session"
+	    %TPM_EXE_PATH%flushcontext -ha !SH! > run.out
+	    IF !ERRORLEVEL! NEQ 0 (
+	       exit /B 1
+	    )
+	)
+    )
+
+    for %%P in ("15d policyccsign-auth" "153 policycccreate-auth" "13b policyccnvchangeauth-auth" "11f policyccundefinespacespecial-auth") do (
+
+	for /f "tokens=1,2" %%C in (%%P) do (
+
+	    echo "Start a trial policy session, emulate %%E"
+	    %TPM_EXE_PATH%startauthsession -se t > run.out
+	    IF !ERRORLEVEL! NEQ 0 (
+	       exit /B 1
+	    )
+	    for /f "tokens=2" %%H in ('findstr /b Handle run.out') do set SH=%%H
+
+	    echo "Policy command code %%C"
+	    %TPM_EXE_PATH%policycommandcode -ha !SH! -cc %%C > run.out
+	    IF !ERRORLEVEL! NEQ 0 (
+	       exit /B 1
+	    )
+
+	    echo "Policy authvalue"
+	    %TPM_EXE_PATH%policyauthvalue -ha !SH! > run.out
+	    IF !ERRORLEVEL! NEQ 0 (
+	       exit /B 1
+	    )
+
+	    echo "Policy get digest"
+	    %TPM_EXE_PATH%policygetdigest -ha !SH! -of tmppol.bin > run.out
+	    IF !ERRORLEVEL! NEQ 0 (
+	       exit /B 1
+	    )
+
+	    echo "Verify the %%D digest"
+	    fc /b policies\%%D.bin tmppol.bin > run.out
+	    IF !ERRORLEVEL! NEQ 0 (
+	       exit /B 1
+	    )
+
+	    echo "Flush the policy session"
+	    %TPM_EXE_PATH%flushcontext -ha !SH! > run.out
+	    IF !ERRORLEVEL! NEQ 0 (
+	       exit /B 1
+	    )
+	)
+    )
+
+    echo "Start a trial policy session, emulate %%E"
+    %TPM_EXE_PATH%startauthsession -se t > run.out
+    IF !ERRORLEVEL! NEQ 0 (
+       exit /B 1
+    )
+    for /f "tokens=2" %%H in ('findstr /b Handle run.out') do set SH=%%H
+
+    echo "Policy locality 3"
+    %TPM_EXE_PATH%policylocality -ha !SH! -loc 08 > run.out
+    IF !ERRORLEVEL! NEQ 0 (
+       exit /B 1
+    )
+
+    echo "Policy get digest"
+    %TPM_EXE_PATH%policygetdigest -ha !SH! -of tmppol.bin > run.out
+    IF !ERRORLEVEL! NEQ 0 (
+       exit /B 1
+    )
+
+    echo "Verify the policylocality3 digest"
+    fc /b policies\policylocality3.bin tmppol.bin > run.out
+    IF !ERRORLEVEL! NEQ 0 (
+       exit /B 1
+    )
+
+    echo "Policy restart"
+    %TPM_EXE_PATH%policyrestart -ha !SH! > run.out
+    IF !ERRORLEVEL! NEQ 0 (
+       exit /B 1
+    )
+
+    echo "Policy secret with platform auth"
+    %TPM_EXE_PATH%policysecret -ha 4000000c -hs !SH! > run.out
+    IF !ERRORLEVEL! NEQ 0 (
+       exit /B 1
+    )
+
+    echo "Policy get digest"
+    %TPM_EXE_PATH%policygetdigest -ha !SH! -of tmppol.bin > run.out
+    IF !ERRORLEVEL! NEQ 0 (
+       exit /B 1
+    )
+
+    echo "Verify the policysecretp digest"
+    fc /b policies\policysecretp.bin tmppol.bin > run.out
+    IF !ERRORLEVEL! NEQ 0 (
+       exit /B 1
+    )
+
+    echo "Policy restart"
+    %TPM_EXE_PATH%policyrestart -ha !SH! > run.out
+    IF !ERRORLEVEL! NEQ 0 (
+       exit /B 1
+    )
+
+    echo "Policy template"
+    %TPM_EXE_PATH%policytemplate -ha !SH! -te policies/policytemplate.bin > run.out
+    IF !ERRORLEVEL! NEQ 0 (
+       exit /B 1
+    )
+
+    echo "Policy get digest"
+    %TPM_EXE_PATH%policygetdigest -ha !SH! -of tmppol.bin > run.out
+    IF !ERRORLEVEL! NEQ 0 (
+       exit /B 1
+    )
+
+    echo "Verify the policytemplatehash digest"
+    fc /b policies\policytemplatehash.bin tmppol.bin > run.out
+    IF !ERRORLEVEL! NEQ 0 (
+       exit /B 1
+    )
+
+    echo "Policy restart"
+    %TPM_EXE_PATH%policyrestart -ha !SH! > run.out
+    IF !ERRORLEVEL! NEQ 0 (
+       exit /B 1
+    )
+
+    echo "Policy OR of policyccsign and policyccquote"
+    %TPM_EXE_PATH%policyor -ha !SH! -if policies/policyccsign.bin -if policies/policyccquote.bin > run.out
+    IF !ERRORLEVEL! NEQ 0 (
+       exit /B 1
+    )
+
+    echo "Policy get digest"
+    %TPM_EXE_PATH%policygetdigest -ha !SH! -of tmppol.bin > run.out
+    IF !ERRORLEVEL! NEQ 0 (
+       exit /B 1
+    )
+
+    echo "Verify the policyor digest"
+    fc /b policies\policyor.bin tmppol.bin > run.out
+    IF !ERRORLEVEL! NEQ 0 (
+       exit /B 1
+    )
+
+    echo "Flush the policy session"
+    %TPM_EXE_PATH%flushcontext -ha !SH! > run.out
+    IF !ERRORLEVEL! NEQ 0 (
+       exit /B 1
+    )
+
+    echo "Start a SHA-1 trial policy session, emulate %%E"
+    %TPM_EXE_PATH%startauthsession -se t -halg sha1 > run.out
+    IF !ERRORLEVEL! NEQ 0 (
+       exit /B 1
+    )
+    for /f "tokens=2" %%H in ('findstr /b Handle run.out') do set SH=%%H
+
+    echo "Policy cpHash"
+    %TPM_EXE_PATH%policycphash -ha !SH! -cp policies/policycphashhash.bin > run.out
+    IF !ERRORLEVEL! NEQ 0 (
+       exit /B 1
+    )
+
+    echo "Policy get digest"
+    %TPM_EXE_PATH%policygetdigest -ha !SH! -of tmppol.bin > run.out
+    IF !ERRORLEVEL! NEQ 0 (
+       exit /B 1
+    )
+
+    echo "Verify the policycphash digest"
+    fc /b policies\policycphash.bin tmppol.bin > run.out
+    IF !ERRORLEVEL! NEQ 0 (
+       exit /B 1
+    )
+
+    echo "Policy restart"
+    %TPM_EXE_PATH%policyrestart -ha !SH! > run.out
+    IF !ERRORLEVEL! NEQ 0 (
+       exit /B 1
+    )
+
+    echo "Policy NV written set"
+    %TPM_EXE_PATH%policynvwritten -hs !SH! -ws y > run.out
+    IF !ERRORLEVEL! NEQ 0 (
+       exit /B 1
+    )
+
+    echo "Policy get digest"
+    %TPM_EXE_PATH%policygetdigest -ha !SH! -of tmppol.bin > run.out
+    IF !ERRORLEVEL! NEQ 0 (
+       exit /B 1
+    )
+
+    echo "Verify the policywrittenset digest"
+    fc /b policies\policywrittenset.bin tmppol.bin > run.out
+    IF !ERRORLEVEL! NEQ 0 (
+       exit /B 1
+    )
+
+    echo "Policy restart"
+    %TPM_EXE_PATH%policyrestart -ha !SH! > run.out
+    IF !ERRORLEVEL! NEQ 0 (
+       exit /B 1
+    )
+
+    echo "Policy counter timer"
+    %TPM_EXE_PATH%policycountertimer -ha !SH! -if policies/zero8.bin -op 2 > run.out
+    IF !ERRORLEVEL! NEQ 0 (
+       exit /B 1
+    )
+
+    echo "Policy get digest"
+    %TPM_EXE_PATH%policygetdigest -ha !SH! -of tmppol.bin > run.out
+    IF !ERRORLEVEL! NEQ 0 (
+       exit /B 1
+    )
+
+    echo "Verify the policycountertimer digest"
+    fc /b policies\policycountertimer.bin tmppol.bin > run.out
+    IF !ERRORLEVEL! NEQ 0 (
+       exit /B 1
+    )
+
+    echo "Flush the policy session"
+    %TPM_EXE_PATH%flushcontext -ha !SH! > run.out
+    IF !ERRORLEVEL! NEQ 0 (
+       exit /B 1
+    )
+)
+
+set TPM_POLICY_EMULATE=
+
+rm -f tmppol.bin
+
+exit /B 0
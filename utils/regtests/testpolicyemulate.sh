@@ -0,0 +1,239 @@
+#!/bin/bash
+#
+
+#################################################################################
+#										#
+#			TPM2 regression test					#
+#		       IBM Thomas J. Watson Research Center			#
+#	$Id: testpolicyemulate.sh $						#
+#										#
+# (c) Copyright IBM Corporation 2017						#
+# 										#
+# All rights reserved.								#
+# 										#
+# Redistribution and use in source and binary forms, with or without		#
+# modification, are permitted provided that the following conditions are	#
+# met:										#
+# 										#
+# Redistributions of source code must retain the above copyright notice,	#
+# this list of conditions and the following disclaimer.				#
+# 										#
+# Redistributions in binary form must reproduce the above copyright		#
+# notice, this list of conditions and the following disclaimer in the		#
+# documentation and/or other materials provided with the distribution.		#
+# 										#
+# Neither the names of the IBM Corporation nor the names of its			#
+# contributors may be used to endorse or promote products derived from		#
+# this software without specific prior written permission.			#
+# 										#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS		#
+# "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT		#
+# LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR		#
+# A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT		#
+# HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,	#
+# SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT		#
+# LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,		#
+# DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY		#
+# THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT		#
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE		#
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.		#
+#										#
+#################################################################################
+
+# With TPM_POLICY_EMULATE set, the TSS runs trial sessions itself and never sends them to the TPM.
+# Each policy in the policies directory is calculated twice, once in a TPM trial session and once
+# in an emulated trial session.  Both digests must match each other and the policymaker digest.
+# The emulated trial session handles are not TPM handles, so they are read from the
+# startauthsession output.
+
+echo ""
+echo "Policy Emulation"
+echo ""
+
+for EMU in 0 1
+do
+
+    export TPM_POLICY_EMULATE=${EMU}
+
+    for POL in "15d policyccsign" "158 policyccquote" "148 policycccertify" "147 policyccactivate" "14b policyccduplicate"
+    do
+
+	CC=${POL% *}
+	NAME=${POL#* }
+
+	echo "Start a trial policy session, emulate ${EMU}"
+	${PREFIX}startauthsession -se t > run.out
+	checkSuccess $?
+	SH=`awk '/^Handle/ {print $2}' run.out`
+
+	echo "Policy command code ${CC}"
+	${PREFIX}policycommandcode -ha ${SH} -cc ${CC} > run.out
+	checkSuccess $?
+
+	echo "Policy get digest"
+	${PREFIX}policygetdigest -ha ${SH} -of tmppol${EMU}${NAME}.bin > run.out
+	checkSuccess $?
+
+	echo "Verify the ${NAME} digest"
+	diff policies/${NAME}.bin tmppol${EMU}${NAME}.bin
+	checkSuccess $?
+
+	echo "Flush the policy session"
+	${PREFIX}flushcontext -ha ${SH} > run.out
+	checkSuccess $?
+
+    done
+
+    for POL in "15d policyccsign-auth" "153 policycccreate-auth" "13b policyccnvchangeauth-auth" "11f policyccundefinespacespecial-auth"
+    do
+
+	CC=${POL% *}
+	NAME=${POL#* }
+
+	echo "Start a trial policy session, emulate ${EMU}"
+	${PREFIX}startauthsession -se t > run.out
+	checkSuccess $?
+	SH=`awk '/^Handle/ {print $2}' run.out`
+
+	echo "Policy command code ${CC}"
+	${PREFIX}policycommandcode -ha ${SH} -cc ${CC} > run.out
+	checkSuccess $?
+
+	echo "Policy authvalue"
+	${PREFIX}policyauthvalue -ha ${SH} > run.out
+	checkSuccess $?
+
+	echo "Policy get digest"
+	${PREFIX}policygetdigest -ha ${SH} -of tmppol${EMU}${NAME}.bin > run.out
+	checkSuccess $?
+
+	echo "Verify the ${NAME} digest"
+	diff policies/${NAME}.bin tmppol${EMU}${NAME}.bin
+	checkSuccess $?
+
+	echo "Flush the policy session"
+	${PREFIX}flushcontext -ha ${SH} > run.out
+	checkSuccess $?
+
+    done
+
+    echo "Start a trial policy session, emulate ${EMU}"
+    ${PREFIX}startauthsession -se t > run.out
+    checkSuccess $?
+    SH=`awk '/^Handle/ {print $2}' run.out`
+
+    echo "Policy locality 3"
+    ${PREFIX}policylocality -ha ${SH} -loc 08 > run.out
+    checkSuccess $?
+
+    echo "Policy get digest"
+    ${PREFIX}policygetdigest -ha ${SH} -of tmppol${EMU}policylocality3.bin > run.out
+    checkSuccess $?
+
+    echo "Policy restart"
+    ${PREFIX}policyrestart -ha ${SH} > run.out
+    checkSuccess $?
+
+    echo "Policy secret with platform auth"
+    ${PREFIX}policysecret -ha 4000000c -hs ${SH} > run.out
+    checkSuccess $?
+
+    echo "Policy get digest"
+    ${PREFIX}policygetdigest -ha ${SH} -of tmppol${EMU}policysecretp.bin > run.out
+    checkSuccess $?
+
+    echo "Policy restart"
+    ${PREFIX}policyrestart -ha ${SH} > run.out
+    checkSuccess $?
+
+    echo "Policy template"
+    ${PREFIX}policytemplate -ha ${SH} -te policies/policytemplate.bin > run.out
+    checkSuccess $?
+
+    echo "Policy get digest"
+    ${PREFIX}policygetdigest -ha ${SH} -of tmppol${EMU}policytemplatehash.bin > run.out
+    checkSuccess $?
+
+    echo "Policy restart"
+    ${PREFIX}policyrestart -ha ${SH} > run.out
+    checkSuccess $?
+
+    echo "Policy OR of policyccsign and policyccquote"
+    ${PREFIX}policyor -ha ${SH} -if policies/policyccsign.bin -if policies/policyccquote.bin > run.out
+    checkSuccess $?
+
+    echo "Policy get digest"
+    ${PREFIX}policygetdigest -ha ${SH} -of tmppol${EMU}policyor.bin > run.out
+    checkSuccess $?
+
+    echo "Flush the policy session"
+    ${PREFIX}flushcontext -ha ${SH} > run.out
+    checkSuccess $?
+
+    echo "Start a SHA-1 trial policy session, emulate ${EMU}"
+    ${PREFIX}startauthsession -se t -halg sha1 > run.out
+    checkSuccess $?
+    SH=`awk '/^Handle/ {print $2}' run.out`
+
+    echo "Policy cpHash"
+    ${PREFIX}policycphash -ha ${SH} -cp policies/policycphashhash.bin > run.out
+    checkSuccess $?
+
+    echo "Policy get digest"
+    ${PREFIX}policygetdigest -ha ${SH} -of tmppol${EMU}policycphash.bin > run.out
+    checkSuccess $?
+
+    echo "Policy restart"
+    ${PREFIX}policyrestart -ha ${SH} > run.out
+    checkSuccess $?
+
+    echo "Policy NV written set"
+    ${PREFIX}policynvwritten -hs ${SH} -ws y > run.out
+    checkSuccess $?
+
+    echo "Policy get digest"
+    ${PREFIX}policygetdigest -ha ${SH} -of tmppol${EMU}policywrittenset.bin > run.out
+    checkSuccess $?
+
+    echo "Policy restart"
+    ${PREFIX}policyrestart -ha ${SH} > run.out
+    checkSuccess $?
+
+    echo "Policy counter timer"
+    ${PREFIX}policycountertimer -ha ${SH} -if policies/zero8.bin -op 2 > run.out
+    checkSuccess $?
+
+    echo "Policy get digest"
+    ${PREFIX}policygetdigest -ha ${SH} -of tmppol${EMU}policycountertimer.bin > run.out
+    checkSuccess $?
+
+    echo "Flush the policy session"
+    ${PREFIX}flushcontext -ha ${SH} > run.out
+    checkSuccess $?
+
+done
+
+unset TPM_POLICY_EMULATE
+
+for NAME in policylocality3 policysecretp policytemplatehash policyor policycphash policywrittenset policycountertimer
+do
+
+    echo "Verify the ${NAME} digest"
+    diff policies/${NAME}.bin tmppol0${NAME}.bin
+    checkSuccess $?
+
+done
+
+for NAME in policyccsign policyccquote policycccertify policyccactivate policyccduplicate policyccsign-auth policycccreate-auth policyccnvchangeauth-auth policyccundefinespacespecial-auth policylocality3 policysecretp policytemplatehash policyor policycphash policywrittenset policycountertimer
+do
+
+    echo "Verify the emulated ${NAME} digest against the TPM"
+    diff tmppol0${NAME}.bin tmppol1${NAME}.bin
+    checkSuccess $?
+
+done
+
+rm -f tmppol0*.bin
+rm -f tmppol1*.bin
+
+# ${PREFIX}getcapability -cap 1 -pr 03000000
@@ -0,0 +1,79 @@
+#!/bin/bash
+#
+
+#################################################################################
+#										#
+#			TPM2 regression test					#
+#		       IBM Thomas J. Watson Research Center			#
+#	$Id: testrefdb.sh $							#
+#										#
+# (c) Copyright IBM Corporation 2017						#
+# 										#
+# All rights reserved.								#
+# 										#
+# Redistribution and use in source and binary forms, with or without		#
+# modification, are permitted provided that the following conditions are	#
+# met:										#
+# 										#
+# Redistributions of source code must retain the above copyright notice,	#
+# this list of conditions and the following disclaimer.				#
+# 										#
+# Redistributions in binary form must reproduce the above copyright		#
+# notice, this list of conditions and the following disclaimer in the		#
+# documentation and/or other materials provided with the distribution.		#
+# 										#
+# Neither the names of the IBM Corporation nor the names of its			#
+# contributors may be used to endorse or promote products derived from		#
+# this software without specific prior written permission.			#
+# 										#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS		#
+# "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT		#
+# LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR		#
+# A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT		#
+# HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,	#
+# SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT		#
+# LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,		#
+# DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY		#
+# THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT		#
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE		#
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.		#
+#										#
+#################################################################################
+
+# policies/refdbima.bin is a big endian ima-ng IMA log of three files.  policies/refdb.txt lists
+# their SHA-256 digests unsorted and with a duplicate.  policies/refdbmiss.txt lacks one of them.
+
+echo ""
+echo "Reference digest database"
+echo ""
+
+echo "Build the database from the digest list"
+${PREFIX}refdb -db tmprefdb.bin -if policies/refdb.txt > run.out
+checkSuccess $?
+
+echo "Appraise the IMA log"
+${PREFIX}refdb -db tmprefdb.bin -ima policies/refdbima.bin > run.out
+checkSuccess $?
+
+echo "Build the database from the digest list, missing one file"
+${PREFIX}refdb -db tmprefdb.bin -if policies/refdbmiss.txt > run.out
+checkSuccess $?
+
+echo "Appraise the IMA log - should fail"
+${PREFIX}refdb -db tmprefdb.bin -ima policies/refdbima.bin > run.out
+checkFailure $?
+
+for HALG in sha1 sha256 sha384
+do
+
+    echo "Build a ${HALG} database of random digests and time lookups"
+    ${PREFIX}refdb -db tmprefdb.bin -halg ${HALG} -gen 1000 -bench 10000 > run.out
+    checkSuccess $?
+
+done
+
+echo "Appraise the SHA-256 IMA log with a SHA-384 database - should fail"
+${PREFIX}refdb -db tmprefdb.bin -ima policies/refdbima.bin > run.out
+checkFailure $?
+
+rm -f tmprefdb.bin
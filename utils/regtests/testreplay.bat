@@ -0,0 +1,194 @@
+REM #############################################################################
+REM #										#
+REM #			TPM2 regression test					#
+REM #		       IBM Thomas J. Watson Research Center			#
+REM #		$Id: testreplay.bat $						#
+REM #										#
+REM # (c) Copyright IBM Corporation 2017					#
+REM # 										#
+REM # All rights reserved.							#
+REM # 										#
+REM # Redistribution and use in source and binary forms, with or without	#
+REM # modification, are permitted provided that the following conditions are	#
+REM # met:									#
+REM # 										#
+REM # Redistributions of source code must retain the above copyright notice,	#
+REM # this list of conditions and the following disclaimer.			#
+REM # 										#
+REM # Redistributions in binary form must reproduce the above copyright		#
+REM # notice, this list of conditions and the following disclaimer in the	#
+REM # documentation and/or other materials provided with the distribution.	#
+REM # 										#
+REM # Neither the names of the IBM Corporation nor the names of its		#
+REM # contributors may be used to endorse or promote products derived from	#
+REM # this software without specific prior written permission.			#
+REM # 										#
+REM # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS	#
+REM # "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT		#
+REM # LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR	#
+REM # A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT	#
+REM # HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,	#
+REM # SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT		#
+REM # LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,	#
+REM # DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY	#
+REM # THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT	#
+REM # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE	#
+REM # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.	#
+REM #										#
+REM #############################################################################
+
+setlocal enableDelayedExpansion
+
+REM # With TPM_REPLAY_FILE set, each utility records its commands and
+REM # responses to a trace.  With TPM_INTERFACE_TYPE replay, the utility is
+REM # served from the trace and must produce the same output.  Each utility
+REM # run has its own trace, replayed in the recorded order.  Salts are not
+REM # recorded, so a salted session does not replay.
+
+echo ""
+echo "Record and Replay"
+echo ""
+
+echo "Record get capability, TPM properties"
+set TPM_REPLAY_FILE=tmptrace1.bin
+%TPM_EXE_PATH%getcapability -cap 6 -pr 100 > tmprecord1.txt
+IF !ERRORLEVEL! NEQ 0 (
+   exit /B 1
+)
+
+echo "Record read public of the primary key"
+set TPM_REPLAY_FILE=tmptrace2.bin
+%TPM_EXE_PATH%readpublic -ho 80000000 -opu tmprecord2.bin > run.out
+IF !ERRORLEVEL! NEQ 0 (
+   exit /B 1
+)
+
+echo "Record get random"
+set TPM_REPLAY_FILE=tmptrace3.bin
+%TPM_EXE_PATH%getrandom -by 16 -of tmprecord3.bin > run.out
+IF !ERRORLEVEL! NEQ 0 (
+   exit /B 1
+)
+
+echo "Record start an HMAC session bound to the primary key"
+set TPM_REPLAY_FILE=tmptrace4.bin
+%TPM_EXE_PATH%startauthsession -se h -bi 80000000 -pwdb pps > run.out
+IF !ERRORLEVEL! NEQ 0 (
+   exit /B 1
+)
+
+echo "Record get random, response encryption"
+set TPM_REPLAY_FILE=tmptrace5.bin
+%TPM_EXE_PATH%getrandom -by 16 -of tmprecord5.bin -se0 02000000 41 > run.out
+IF !ERRORLEVEL! NEQ 0 (
+   exit /B 1
+)
+
+echo "Record flush the session"
+set TPM_REPLAY_FILE=tmptrace6.bin
+%TPM_EXE_PATH%flushcontext -ha 02000000 > run.out
+IF !ERRORLEVEL! NEQ 0 (
+   exit /B 1
+)
+
+echo "Record start an RSA salted HMAC session"
+set TPM_REPLAY_FILE=tmptrace7.bin
+%TPM_EXE_PATH%startauthsession -se h -hs 80000000 > run.out
+IF !ERRORLEVEL! NEQ 0 (
+   exit /B 1
+)
+
+echo "Flush the salted session"
+set TPM_REPLAY_FILE=
+%TPM_EXE_PATH%flushcontext -ha 02000000 > run.out
+IF !ERRORLEVEL! NEQ 0 (
+   exit /B 1
+)
+
+set TPM_INTERFACE_TYPE=replay
+
+echo "Replay get capability, TPM properties"
+set TPM_REPLAY_FILE=tmptrace1.bin
+%TPM_EXE_PATH%getcapability -cap 6 -pr 100 > tmpreplay1.txt
+IF !ERRORLEVEL! NEQ 0 (
+   exit /B 1
+)
+
+echo "Verify the replayed properties"
+fc /b tmprecord1.txt tmpreplay1.txt > run.out
+IF !ERRORLEVEL! NEQ 0 (
+   exit /B 1
+)
+
+echo "Replay read public of the primary key"
+set TPM_REPLAY_FILE=tmptrace2.bin
+%TPM_EXE_PATH%readpublic -ho 80000000 -opu tmpreplay2.bin > run.out
+IF !ERRORLEVEL! NEQ 0 (
+   exit /B 1
+)
+
+echo "Verify the replayed public area"
+fc /b tmprecord2.bin tmpreplay2.bin > run.out
+IF !ERRORLEVEL! NEQ 0 (
+   exit /B 1
+)
+
+echo "Replay get random"
+set TPM_REPLAY_FILE=tmptrace3.bin
+%TPM_EXE_PATH%getrandom -by 16 -of tmpreplay3.bin > run.out
+IF !ERRORLEVEL! NEQ 0 (
+   exit /B 1
+)
+
+echo "Verify the replayed random bytes"
+fc /b tmprecord3.bin tmpreplay3.bin > run.out
+IF !ERRORLEVEL! NEQ 0 (
+   exit /B 1
+)
+
+echo "Replay start an HMAC session bound to the primary key"
+set TPM_REPLAY_FILE=tmptrace4.bin
+%TPM_EXE_PATH%startauthsession -se h -bi 80000000 -pwdb pps > run.out
+IF !ERRORLEVEL! NEQ 0 (
+   exit /B 1
+)
+
+echo "Replay get random, response encryption"
+set TPM_REPLAY_FILE=tmptrace5.bin
+%TPM_EXE_PATH%getrandom -by 16 -of tmpreplay5.bin -se0 02000000 41 > run.out
+IF !ERRORLEVEL! NEQ 0 (
+   exit /B 1
+)
+
+echo "Verify the replayed decrypted random bytes"
+fc /b tmprecord5.bin tmpreplay5.bin > run.out
+IF !ERRORLEVEL! NEQ 0 (
+   exit /B 1
+)
+
+echo "Replay flush the session"
+set TPM_REPLAY_FILE=tmptrace6.bin
+%TPM_EXE_PATH%flushcontext -ha 02000000 > run.out
+IF !ERRORLEVEL! NEQ 0 (
+   exit /B 1
+)
+
+echo "Replay start an RSA salted HMAC session, salt not recorded"
+set TPM_REPLAY_FILE=tmptrace7.bin
+%TPM_EXE_PATH%startauthsession -se h -hs 80000000 > run.out
+IF !ERRORLEVEL! EQU 0 (
+   exit /B 1
+)
+
+echo "Replay a different command, mismatch"
+set TPM_REPLAY_FILE=tmptrace1.bin
+%TPM_EXE_PATH%getcapability -cap 6 -pr 200 > run.out
+IF !ERRORLEVEL! EQU 0 (
+   exit /B 1
+)
+
+rm -f tmptrace*.bin
+rm -f tmprecord*
+rm -f tmpreplay*
+
+exit /B 0
@@ -0,0 +1,137 @@
+#!/bin/bash
+#
+
+#################################################################################
+#										#
+#			TPM2 regression test					#
+#		       IBM Thomas J. Watson Research Center			#
+#	$Id: testreplay.sh $							#
+#										#
+# (c) Copyright IBM Corporation 2017						#
+# 										#
+# All rights reserved.								#
+# 										#
+# Redistribution and use in source and binary forms, with or without		#
+# modification, are permitted provided that the following conditions are	#
+# met:										#
+# 										#
+# Redistributions of source code must retain the above copyright notice,	#
+# this list of conditions and the following disclaimer.				#
+# 										#
+# Redistributions in binary form must reproduce the above copyright		#
+# notice, this list of conditions and the following disclaimer in the		#
+# documentation and/or other materials provided with the distribution.		#
+# 										#
+# Neither the names of the IBM Corporation nor the names of its			#
+# contributors may be used to endorse or promote products derived from		#
+# this software without specific prior written permission.			#
+# 										#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS		#
+# "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT		#
+# LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR		#
+# A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT		#
+# HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,	#
+# SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT		#
+# LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,		#
+# DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY		#
+# THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT		#
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE		#
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.		#
+#										#
+#################################################################################
+
+# With TPM_REPLAY_FILE set, each utility records its commands and responses, and the TSS generated
+# nonces, to a trace.  With TPM_INTERFACE_TYPE replay, the utility is served from the
+# trace instead of the TPM, and must produce the same output.  A trace holds one TSS context, so
+# each utility run has its own trace.  The steps are replayed in the recorded order, so that the
+# session files match.  Salts are not recorded, so a salted session does not replay.
+
+echo ""
+echo "Record and Replay"
+echo ""
+
+echo "Record get capability, TPM properties"
+TPM_REPLAY_FILE=tmptrace1.bin ${PREFIX}getcapability -cap 6 -pr 100 > tmprecord1.txt
+checkSuccess $?
+
+echo "Record read public of the primary key"
+TPM_REPLAY_FILE=tmptrace2.bin ${PREFIX}readpublic -ho 80000000 -opu tmprecord2.bin > run.out
+checkSuccess $?
+
+echo "Record get random"
+TPM_REPLAY_FILE=tmptrace3.bin ${PREFIX}getrandom -by 16 -of tmprecord3.bin > run.out
+checkSuccess $?
+
+echo "Record start an HMAC session bound to the primary key"
+TPM_REPLAY_FILE=tmptrace4.bin ${PREFIX}startauthsession -se h -bi 80000000 -pwdb pps > run.out
+checkSuccess $?
+
+echo "Record get random, response encryption"
+TPM_REPLAY_FILE=tmptrace5.bin ${PREFIX}getrandom -by 16 -of tmprecord5.bin -se0 02000000 41 > run.out
+checkSuccess $?
+
+echo "Record flush the session"
+TPM_REPLAY_FILE=tmptrace6.bin ${PREFIX}flushcontext -ha 02000000 > run.out
+checkSuccess $?
+
+echo "Record start an RSA salted HMAC session"
+TPM_REPLAY_FILE=tmptrace7.bin ${PREFIX}startauthsession -se h -hs 80000000 > run.out
+checkSuccess $?
+
+echo "Flush the salted session"
+${PREFIX}flushcontext -ha 02000000 > run.out
+checkSuccess $?
+
+echo "Replay get capability, TPM properties"
+TPM_INTERFACE_TYPE=replay TPM_REPLAY_FILE=tmptrace1.bin ${PREFIX}getcapability -cap 6 -pr 100 > tmpreplay1.txt
+checkSuccess $?
+
+echo "Verify the replayed properties"
+diff tmprecord1.txt tmpreplay1.txt
+checkSuccess $?
+
+echo "Replay read public of the primary key"
+TPM_INTERFACE_TYPE=replay TPM_REPLAY_FILE=tmptrace2.bin ${PREFIX}readpublic -ho 80000000 -opu tmpreplay2.bin > run.out
+checkSuccess $?
+
+echo "Verify the replayed public area"
+diff tmprecord2.bin tmpreplay2.bin
+checkSuccess $?
+
+echo "Replay get random"
+TPM_INTERFACE_TYPE=replay TPM_REPLAY_FILE=tmptrace3.bin ${PREFIX}getrandom -by 16 -of tmpreplay3.bin > run.out
+checkSuccess $?
+
+echo "Verify the replayed random bytes"
+diff tmprecord3.bin tmpreplay3.bin
+checkSuccess $?
+
+echo "Replay start an HMAC session bound to the primary key"
+TPM_INTERFACE_TYPE=replay TPM_REPLAY_FILE=tmptrace4.bin ${PREFIX}startauthsession -se h -bi 80000000 -pwdb pps > run.out
+checkSuccess $?
+
+echo "Replay get random, response encryption"
+TPM_INTERFACE_TYPE=replay TPM_REPLAY_FILE=tmptrace5.bin ${PREFIX}getrandom -by 16 -of tmpreplay5.bin -se0 02000000 41 > run.out
+checkSuccess $?
+
+echo "Verify the replayed decrypted random bytes"
+diff tmprecord5.bin tmpreplay5.bin
+checkSuccess $?
+
+echo "Replay flush the session"
+TPM_INTERFACE_TYPE=replay TPM_REPLAY_FILE=tmptrace6.bin ${PREFIX}flushcontext -ha 02000000 > run.out
+checkSuccess $?
+
+echo "Replay start an RSA salted HMAC session, salt not recorded"
+TPM_INTERFACE_TYPE=replay TPM_REPLAY_FILE=tmptrace7.bin ${PREFIX}startauthsession -se h -hs 80000000 > run.out
+checkFailure $?
+
+echo "Replay a different command, mismatch"
+TPM_INTERFACE_TYPE=replay TPM_REPLAY_FILE=tmptrace1.bin ${PREFIX}getcapability -cap 6 -pr 200 > run.out
+checkFailure $?
+
+rm -f tmptrace*.bin
+rm -f tmprecord*
+rm -f tmpreplay*
+
+# ${PREFIX}getcapability -cap 1 -pr 02000000
@@ -153,7 +153,27 @@ int main(int argc, char *argv[])
 	printf("End Pass %u\n", count +1);
  	timeDiff += difftime(endTime, startTime);
    }
+    /* the socket interface counts its system calls, normally one send and one receive per pass */
     if (rc == 0) {
+	uint32_t commands;
+	uint32_t writes;
+	uint32_t reads;
+	TSS_GetSocketStatistics(tssContext, &commands, &writes, &reads);
+	if (commands != 0) {
+	    printf("Socket commands %u writes %u reads %u\n", commands, writes, reads);
+	}
+    }
+    /* the device interface times the wait for each response */
+    if (rc == 0) {
+	uint32_t commands;
+	uint32_t timeouts;
+	uint64_t waitTime;
+	uint64_t processTime;
+	TSS_GetDeviceStatistics(tssContext, &commands, &timeouts, &waitTime, &processTime);
+	if (commands != 0) {
+	    printf("Device commands %u timeouts %u wait usec %llu\n", commands, timeouts,
+		   (unsigned long long)waitTime);
+	}
     }
     {
 	TPM_RC rc1 = TSS_Delete(tssContext);
@@ -58,10 +58,17 @@
 #include <tss2/tssmarshal.h>
 #include <tss2/Unmarshal_fp.h>
 #include "tssccattributes.h"
+#include <tss2/tsscapability.h>
+#include <tss2/tssprimary.h>
 #ifndef TPM_TSS_NOCRYPTO
 #include <tss2/tsscrypto.h>
 #include <tss2/tsscryptoh.h>
+#include <tss2/tsspolicy.h>
 #endif
+#ifdef TPM_POSIX
+#include "tssdev.h"
+#endif
+#include "tssreplay.h"
 
 /* Files:
 
@@ -73,6 +80,12 @@
    cxxxx...xxxx.bin - context blob name
 */
 
+/* Trial sessions emulated by the TSS, see TSS_Execute_Emulate(), have handles in a range that a TPM
+   does not assign */
+
+#define TSS_EMULATED_SESSION_FIRST	(HR_POLICY_SESSION + 0x00ff0000)
+#define TSS_EMULATED_SESSION_MASK	0xffff0000
+
 /* NOTE Synchronize with
 
    TSS_HmacSession_InitContext
@@ -101,10 +114,16 @@ struct TSS_HMAC_CONTEXT {
     TPM_SE			sessionType;		/* HMAC (0), policy (1), or trial policy */
     uint8_t			isPasswordNeeded;	/* flag set by policy password */
     uint8_t			isAuthValueNeeded;	/* flag set by policy authvalue */
+    uint8_t			isPolicyDigestValid;	/* policyDigest tracks the TPM */
+    TPM2B_DIGEST		policyDigest;		/* expected policy session digest */
+    uint8_t			isAuditDigestValid;	/* auditDigest tracks the TPM */
+    TPM2B_DIGEST		auditDigest;		/* expected session audit digest */
     /* Items below this line are for the lifetime of one command.  They are not saved and loaded. */
     TPM2B_KEY			hmacKey;		/* HMAC key calculated for each command */
 #ifndef TPM_TSS_NOCRYPTO
     TPM2B_KEY			sessionValue;		/* KDFa secret for parameter encryption */
+    TPMT_HA			cpHash;			/* command cpHash, for audit */
+    TPMT_HA			rpHash;			/* response rpHash, for audit */
 #endif	/* TPM_TSS_NOCRYPTO */
 } TSS_HMAC_CONTEXT;
 
@@ -143,6 +162,10 @@ static TPM_RC TSS_CA_NV_ChangeAuth(TSS_CONTEXT *tssContext,
 				   NV_ChangeAuth_In *in);
 
 
+static TPM_RC TSS_PO_Startup(TSS_CONTEXT *tssContext,
+			     Startup_In *in,
+			     void *out,
+			     void *extra);
 static TPM_RC TSS_PO_StartAuthSession(TSS_CONTEXT *tssContext,
 				      StartAuthSession_In *in,
 				      StartAuthSession_Out *out,
@@ -195,6 +218,14 @@ static TPM_RC TSS_PO_EventSequenceComplete(TSS_CONTEXT *tssContext,
 					   EventSequenceComplete_In *in,
 					   EventSequenceComplete_Out *out,
 					   void *extra);
+static TPM_RC TSS_PO_PCR_Read(TSS_CONTEXT *tssContext,
+			      PCR_Read_In *in,
+			      PCR_Read_Out *out,
+			      void *extra);
+static TPM_RC TSS_PO_PCR_Extend(TSS_CONTEXT *tssContext,
+				PCR_Extend_In *in,
+				void *out,
+				void *extra);
 static TPM_RC TSS_PO_PolicyAuthValue(TSS_CONTEXT *tssContext,
 				     PolicyAuthValue_In *in,
 				     void *out,
@@ -203,6 +234,10 @@ static TPM_RC TSS_PO_PolicyPassword(TSS_CONTEXT *tssContext,
 				    PolicyPassword_In *in,
 				    void *out,
 				    void *extra);
+static TPM_RC TSS_PO_PolicyDigest(TSS_CONTEXT *tssContext,
+				  COMMAND_PARAMETERS *in,
+				  void *out,
+				  void *extra);
 static TPM_RC TSS_PO_CreatePrimary(TSS_CONTEXT *tssContext,
 				   CreatePrimary_In *in,
 				   CreatePrimary_Out *out,
@@ -235,6 +270,18 @@ static TPM_RC TSS_PO_NV_ReadLock(TSS_CONTEXT *tssContext,
 				 NV_ReadLock_In *in,
 				 void *out,
 				 void *extra);
+static TPM_RC TSS_PO_ChangePPS(TSS_CONTEXT *tssContext,
+			       ChangePPS_In *in,
+			       void *out,
+			       void *extra);
+static TPM_RC TSS_PO_ChangeEPS(TSS_CONTEXT *tssContext,
+			       ChangeEPS_In *in,
+			       void *out,
+			       void *extra);
+static TPM_RC TSS_PO_Clear(TSS_CONTEXT *tssContext,
+			   Clear_In *in,
+			   void *out,
+			   void *extra);
 
 typedef struct TSS_TABLE {
     TPM_CC 			commandCode;
@@ -245,13 +292,13 @@ typedef struct TSS_TABLE {
 
 static const TSS_TABLE tssTable [] = {
 				 
-    {TPM_CC_Startup, NULL, NULL, NULL},
+    {TPM_CC_Startup, NULL, NULL, (TSS_PostProcessFunction_t)TSS_PO_Startup},
     {TPM_CC_Shutdown, NULL, NULL, NULL},
     {TPM_CC_SelfTest, NULL, NULL, NULL},
     {TPM_CC_IncrementalSelfTest, NULL, NULL, NULL},
     {TPM_CC_GetTestResult, NULL, NULL, NULL},
     {TPM_CC_StartAuthSession, (TSS_PreProcessFunction_t)TSS_PR_StartAuthSession, NULL, (TSS_PostProcessFunction_t)TSS_PO_StartAuthSession},
-    {TPM_CC_PolicyRestart, NULL, NULL, NULL},
+    {TPM_CC_PolicyRestart, NULL, NULL, (TSS_PostProcessFunction_t)TSS_PO_PolicyDigest},
     {TPM_CC_Create, NULL, NULL, NULL},
     {TPM_CC_Load, NULL, NULL, (TSS_PostProcessFunction_t)TSS_PO_Load},
     {TPM_CC_LoadExternal, NULL, NULL, (TSS_PostProcessFunction_t)TSS_PO_LoadExternal},
@@ -292,39 +339,39 @@ static const TSS_TABLE tssTable [] = {
     {TPM_CC_VerifySignature, NULL, NULL, NULL},
     {TPM_CC_Sign, NULL, NULL, NULL},
     {TPM_CC_SetCommandCodeAuditStatus, NULL, NULL, NULL},
-    {TPM_CC_PCR_Extend, NULL, NULL, NULL},
-    {TPM_CC_PCR_Event, NULL, NULL, NULL},
-    {TPM_CC_PCR_Read, NULL, NULL, NULL},
+    {TPM_CC_PCR_Extend, NULL, NULL, (TSS_PostProcessFunction_t)TSS_PO_PCR_Extend},
+    {TPM_CC_PCR_Event, NULL, NULL, (TSS_PostProcessFunction_t)TSS_PO_PCR_Extend},
+    {TPM_CC_PCR_Read, NULL, NULL, (TSS_PostProcessFunction_t)TSS_PO_PCR_Read},
     {TPM_CC_PCR_Allocate, NULL, NULL, NULL},
     {TPM_CC_PCR_SetAuthPolicy, NULL, NULL, NULL},
     {TPM_CC_PCR_SetAuthValue, NULL, NULL, NULL},
-    {TPM_CC_PCR_Reset, NULL, NULL, NULL},
-    {TPM_CC_PolicySigned, NULL, NULL, NULL},
-    {TPM_CC_PolicySecret, NULL, NULL, NULL},
-    {TPM_CC_PolicyTicket, NULL, NULL, NULL},
-    {TPM_CC_PolicyOR, NULL, NULL, NULL},
-    {TPM_CC_PolicyPCR, NULL, NULL, NULL},
-    {TPM_CC_PolicyLocality, NULL, NULL, NULL},
-    {TPM_CC_PolicyNV, NULL, NULL, NULL},
-    {TPM_CC_PolicyAuthorizeNV, NULL, NULL, NULL},
-    {TPM_CC_PolicyCounterTimer, NULL, NULL, NULL},
-    {TPM_CC_PolicyCommandCode, NULL, NULL, NULL},
-    {TPM_CC_PolicyPhysicalPresence, NULL, NULL, NULL},
-    {TPM_CC_PolicyCpHash, NULL, NULL, NULL},
-    {TPM_CC_PolicyNameHash, NULL, NULL, NULL},
-    {TPM_CC_PolicyDuplicationSelect, NULL, NULL, NULL},
-    {TPM_CC_PolicyAuthorize, NULL, NULL, NULL},
+    {TPM_CC_PCR_Reset, NULL, NULL, (TSS_PostProcessFunction_t)TSS_PO_PCR_Extend},
+    {TPM_CC_PolicySigned, NULL, NULL, (TSS_PostProcessFunction_t)TSS_PO_PolicyDigest},
+    {TPM_CC_PolicySecret, NULL, NULL, (TSS_PostProcessFunction_t)TSS_PO_PolicyDigest},
+    {TPM_CC_PolicyTicket, NULL, NULL, (TSS_PostProcessFunction_t)TSS_PO_PolicyDigest},
+    {TPM_CC_PolicyOR, NULL, NULL, (TSS_PostProcessFunction_t)TSS_PO_PolicyDigest},
+    {TPM_CC_PolicyPCR, NULL, NULL, (TSS_PostProcessFunction_t)TSS_PO_PolicyDigest},
+    {TPM_CC_PolicyLocality, NULL, NULL, (TSS_PostProcessFunction_t)TSS_PO_PolicyDigest},
+    {TPM_CC_PolicyNV, NULL, NULL, (TSS_PostProcessFunction_t)TSS_PO_PolicyDigest},
+    {TPM_CC_PolicyAuthorizeNV, NULL, NULL, (TSS_PostProcessFunction_t)TSS_PO_PolicyDigest},
+    {TPM_CC_PolicyCounterTimer, NULL, NULL, (TSS_PostProcessFunction_t)TSS_PO_PolicyDigest},
+    {TPM_CC_PolicyCommandCode, NULL, NULL, (TSS_PostProcessFunction_t)TSS_PO_PolicyDigest},
+    {TPM_CC_PolicyPhysicalPresence, NULL, NULL, (TSS_PostProcessFunction_t)TSS_PO_PolicyDigest},
+    {TPM_CC_PolicyCpHash, NULL, NULL, (TSS_PostProcessFunction_t)TSS_PO_PolicyDigest},
+    {TPM_CC_PolicyNameHash, NULL, NULL, (TSS_PostProcessFunction_t)TSS_PO_PolicyDigest},
+    {TPM_CC_PolicyDuplicationSelect, NULL, NULL, (TSS_PostProcessFunction_t)TSS_PO_PolicyDigest},
+    {TPM_CC_PolicyAuthorize, NULL, NULL, (TSS_PostProcessFunction_t)TSS_PO_PolicyDigest},
     {TPM_CC_PolicyAuthValue, NULL, NULL, (TSS_PostProcessFunction_t)TSS_PO_PolicyAuthValue},
     {TPM_CC_PolicyPassword, NULL, NULL, (TSS_PostProcessFunction_t)TSS_PO_PolicyPassword},
     {TPM_CC_PolicyGetDigest, NULL, NULL, NULL},
-    {TPM_CC_PolicyNvWritten, NULL, NULL, NULL},
-    {TPM_CC_PolicyTemplate, NULL, NULL, NULL},
+    {TPM_CC_PolicyNvWritten, NULL, NULL, (TSS_PostProcessFunction_t)TSS_PO_PolicyDigest},
+    {TPM_CC_PolicyTemplate, NULL, NULL, (TSS_PostProcessFunction_t)TSS_PO_PolicyDigest},
     {TPM_CC_CreatePrimary, NULL, NULL, (TSS_PostProcessFunction_t)TSS_PO_CreatePrimary},
     {TPM_CC_HierarchyControl, NULL, NULL, NULL},
     {TPM_CC_SetPrimaryPolicy, NULL, NULL, NULL},
-    {TPM_CC_ChangePPS, NULL, NULL, NULL},
-    {TPM_CC_ChangeEPS, NULL, NULL, NULL},
-    {TPM_CC_Clear, NULL, NULL, NULL},
+    {TPM_CC_ChangePPS, NULL, NULL, (TSS_PostProcessFunction_t)TSS_PO_ChangePPS},
+    {TPM_CC_ChangeEPS, NULL, NULL, (TSS_PostProcessFunction_t)TSS_PO_ChangeEPS},
+    {TPM_CC_Clear, NULL, NULL, (TSS_PostProcessFunction_t)TSS_PO_Clear},
     {TPM_CC_ClearControl, NULL, NULL, NULL},
     {TPM_CC_HierarchyChangeAuth, NULL, (TSS_ChangeAuthFunction_t)TSS_CA_HierarchyChangeAuth, NULL},
     {TPM_CC_DictionaryAttackLockReset, NULL, NULL, NULL},
@@ -362,6 +409,11 @@ static TPM_RC TSS_Context_Init(TSS_CONTEXT *tssContext);
 static TPM_RC TSS_Execute_valist(TSS_CONTEXT *tssContext,
 				 COMMAND_PARAMETERS *in,
 				 va_list ap);
+static TPM_RC TSS_Execute_Emulate(TSS_CONTEXT *tssContext,
+				  int *emulated,
+				  RESPONSE_PARAMETERS *out,
+				  COMMAND_PARAMETERS *in,
+				  TPM_CC commandCode);
 
 
 static TPM_RC TSS_PwapSession_Set(TPMS_AUTH_COMMAND *authCommand,
@@ -378,7 +430,8 @@ static TPM_RC TSS_HmacSession_SetSessionKey(TSS_CONTEXT *tssContext,
 					    TPM2B_DIGEST *salt,
 					    TPMI_DH_ENTITY bind,
 					    TPM2B_AUTH *bindAuthValue);
-static TPM_RC TSS_HmacSession_SetNonceCaller(struct TSS_HMAC_CONTEXT *session,
+static TPM_RC TSS_HmacSession_SetNonceCaller(TSS_CONTEXT *tssContext,
+					     struct TSS_HMAC_CONTEXT *session,
 					     TPMS_AUTH_COMMAND 	*authC);
 static TPM_RC TSS_HmacSession_SetHmacKey(TSS_CONTEXT *tssContext,
 					 struct TSS_HMAC_CONTEXT *session,
@@ -395,10 +448,29 @@ static TPM_RC TSS_HmacSession_SetHMAC(TSS_AUTH_CONTEXT *tssAuthContext,
 				      TPM2B_NAME *name1,		  
 				      TPM2B_NAME *name2);
 #ifndef TPM_TSS_NOCRYPTO
-static TPM_RC TSS_HmacSession_Verify(TSS_AUTH_CONTEXT *tssAuthContext,
-				     struct TSS_HMAC_CONTEXT *session,
+static TPM_RC TSS_HmacSession_Verify(struct TSS_HMAC_CONTEXT *session,
+				     const TPMT_HA *rpHash,
 				     TPMS_AUTH_RESPONSE *authResponse);
+static TPM_RC TSS_CpHash_Calculate(TSS_AUTH_CONTEXT *tssAuthContext,
+				   TPMT_HA cpHash[],
+				   size_t count,
+				   TPM2B_NAME *name0,
+				   TPM2B_NAME *name1,
+				   TPM2B_NAME *name2);
+static TPM_RC TSS_RpHash_Calculate(TSS_AUTH_CONTEXT *tssAuthContext,
+				   TPMT_HA rpHash[],
+				   size_t count);
+static void TSS_HashList_Add(TPMT_HA digests[],
+			     size_t *count,
+			     TPMI_ALG_HASH hashAlg);
+static TPMT_HA *TSS_HashList_Find(TPMT_HA digests[],
+				  size_t count,
+				  TPMI_ALG_HASH hashAlg);
 #endif	/* TPM_TSS_NOCRYPTO */
+static int TSS_HmacSession_IsHmacNeeded(struct TSS_HMAC_CONTEXT *session);
+static int TSS_HmacSession_IsVerifyNeeded(struct TSS_HMAC_CONTEXT *session);
+static void TSS_HmacSession_Audit(struct TSS_HMAC_CONTEXT *session,
+				  unsigned int sessionAttributes);
 static TPM_RC TSS_HmacSession_Continue(TSS_CONTEXT *tssContext,
 				       struct TSS_HMAC_CONTEXT *session,
 				       TPMS_AUTH_RESPONSE *authR);
@@ -409,7 +481,12 @@ static TPM_RC TSS_HmacSession_SaveSession(TSS_CONTEXT *tssContext,
 static TPM_RC TSS_HmacSession_LoadSession(TSS_CONTEXT *tssContext,
 					  struct TSS_HMAC_CONTEXT *session,
 					  TPMI_SH_AUTH_SESSION	sessionHandle);
-#ifdef TPM_TSS_NOFILE
+#ifndef TPM_TSS_NOFILE
+static TPM_RC TSS_HmacSession_SaveFile(TSS_CONTEXT *tssContext,
+				       TPMI_SH_AUTH_SESSION sessionHandle,
+				       uint32_t written,
+				       uint8_t *buffer);
+#endif
 static TPM_RC TSS_HmacSession_SaveData(TSS_CONTEXT *tssContext,
 				       TPMI_SH_AUTH_SESSION sessionHandle,
 				       uint32_t outLength,
@@ -422,12 +499,29 @@ static TPM_RC TSS_HmacSession_DeleteData(TSS_CONTEXT *tssContext,
 static TPM_RC TSS_HmacSession_GetSlotForHandle(TSS_CONTEXT *tssContext,
 					       size_t *slotIndex,
 					       TPMI_SH_AUTH_SESSION sessionHandle);
-#endif
 static uint16_t TSS_HmacSession_Marshal(struct TSS_HMAC_CONTEXT *source,
 					uint16_t *written, uint8_t **buffer, int32_t *size);
 static TPM_RC TSS_HmacSession_Unmarshal(struct TSS_HMAC_CONTEXT *target,
 					uint8_t **buffer, int32_t *size);
 
+static int    TSS_PolicySession_GetHandle(TPMI_SH_POLICY *policySession,
+					  TPM_CC commandCode,
+					  COMMAND_PARAMETERS *in);
+static int    TSS_PolicySession_IsEmulated(TPMI_SH_AUTH_SESSION sessionHandle);
+#ifndef TPM_TSS_NOCRYPTO
+static TPM_RC TSS_PolicySession_NewHandle(TSS_CONTEXT *tssContext,
+					  TPMI_SH_AUTH_SESSION *sessionHandle);
+static TPM_RC TSS_PolicySession_Extend(TSS_CONTEXT *tssContext,
+				       TSS_POLICY *policy,
+				       int emulated,
+				       TPM_CC commandCode,
+				       COMMAND_PARAMETERS *in);
+#endif	/* TPM_TSS_NOCRYPTO */
+static TPM_RC TSS_PolicySession_Update(TSS_CONTEXT *tssContext,
+				       struct TSS_HMAC_CONTEXT *session,
+				       TPM_CC commandCode,
+				       COMMAND_PARAMETERS *in);
+
 static TPM_RC TSS_Name_GetAllNames(TSS_CONTEXT *tssContext,
 				   TPM2B_NAME **names);
 static TPM_RC TSS_Name_GetName(TSS_CONTEXT *tssContext,
@@ -467,8 +561,16 @@ static TPM_RC TSS_ObjectPublic_DeleteData(TSS_CONTEXT *tssContext, TPM_HANDLE ha
 #endif
 static TPM_RC TSS_DeleteHandle(TSS_CONTEXT *tssContext,
 			       TPM_HANDLE handle);
-static TPM_RC TSS_ObjectPublic_GetName(TPM2B_NAME *name,
+static TPM_RC TSS_ObjectPublic_GetName(TSS_CONTEXT *tssContext,
+				       TPM2B_NAME *name,
 				       TPMT_PUBLIC *tpmtPublic);
+#ifndef TPM_TSS_NOCRYPTO
+static TPM_RC TSS_Name_Calculate(TSS_CONTEXT *tssContext,
+				 TPM2B_NAME *name,
+				 TPMI_ALG_HASH nameAlg,
+				 const uint8_t *buffer,
+				 uint16_t written);
+#endif
 
 #ifndef TPM_TSS_NOCRYPTO
 static TPM_RC TSS_NVPublic_Store(TSS_CONTEXT *tssContext,
@@ -521,6 +623,7 @@ static TPM_RC TSS_Response_PostProcessor(TSS_CONTEXT *tssContext,
 					 COMMAND_PARAMETERS *in,
 					 RESPONSE_PARAMETERS *out,
 					 EXTRA_PARAMETERS *extra);
+static TSS_PostProcessFunction_t TSS_GetPostProcessFunction(TPM_CC commandCode);
 
 static TPM_RC TSS_Sessions_GetDecryptSession(unsigned int *isDecrypt,
 					     unsigned int *decryptSession,
@@ -535,7 +638,8 @@ static TPM_RC TSS_Sessions_GetEncryptSession(unsigned int *isEncrypt,
 static TPM_RC TSS_HashToString(char *str, uint8_t *digest);
 #endif
 #ifndef TPM_TSS_NOCRYPTO
-static TPM_RC TSS_RSA_Salt(TPM2B_DIGEST 		*salt,
+static TPM_RC TSS_RSA_Salt(TSS_CONTEXT *tssContext,
+			   TPM2B_DIGEST 		*salt,
 			   TPM2B_ENCRYPTED_SECRET	*encryptedSalt,
 			   TPMT_PUBLIC			*publicArea);
 #endif
@@ -640,7 +744,8 @@ TPM_RC TSS_Delete(TSS_CONTEXT *tssContext)
 
     if (tssContext != NULL) {
 	TSS_AuthDelete(tssContext->tssAuthContext);
-#ifdef TPM_TSS_NOFILE
+	/* write back any held session state before it is freed */
+	rc = TSS_HoldSessions(tssContext, FALSE);
 	{
 	    size_t i;
 	    for (i = 0 ; i < (sizeof(tssContext->sessions) / sizeof(TSS_SESSIONS)) ; i++) {
@@ -652,17 +757,249 @@ TPM_RC TSS_Delete(TSS_CONTEXT *tssContext)
 		tssContext->sessions[i].sessionDataLength = 0;
 	    }
 	}
-#endif
+	TSS_MarshalBuffer_Free(&tssContext->sessionMarshalBuffer);
 #ifndef TPM_TSS_NOCRYPTO
 	free(tssContext->tssSessionEncKey);
 	free(tssContext->tssSessionDecKey);
 #endif
-	rc = TSS_Close(tssContext);
+	{
+	    TPM_RC rc1 = TSS_Close(tssContext);
+	    if (rc == 0) {
+		rc = rc1;
+	    }
+	}
+	{
+	    TPM_RC rc1 = TSS_Replay_Close(tssContext);
+	    if (rc == 0) {
+		rc = rc1;
+	    }
+	}
 	free(tssContext);
     }
     return rc;
 }
 
+/* TSS_HoldSessions() controls where updated HMAC and policy session state is kept.
+
+   When hold is TRUE, the session state is kept in the TSS context after each command, rather than
+   being written to (and for the next command, read and decrypted from) the session file.  This
+   saves the file I/O when a series of commands uses the same session, e.g., a large NV read or
+   write in chunks.
+
+   When hold is FALSE, any held session state is written to the session file.  TSS_Delete() does
+   this automatically.
+
+   The TSS without file support always keeps sessions in the context, so this is a no-op.
+*/
+
+TPM_RC TSS_HoldSessions(TSS_CONTEXT *tssContext, int hold)
+{
+    TPM_RC	rc = 0;
+#ifndef TPM_TSS_NOFILE
+    size_t 	i;
+
+    if (!hold) {
+	for (i = 0 ; i < (sizeof(tssContext->sessions) / sizeof(TSS_SESSIONS)) ; i++) {
+	    if (tssContext->sessions[i].sessionHandle != TPM_RH_NULL) {
+		TPM_RC rc1;
+		if (tssVverbose) printf("TSS_HoldSessions: release handle %08x\n",
+					tssContext->sessions[i].sessionHandle);
+		rc1 = TSS_HmacSession_SaveFile(tssContext,
+					       tssContext->sessions[i].sessionHandle,
+					       tssContext->sessions[i].sessionDataLength,
+					       tssContext->sessions[i].sessionData);
+		if (rc == 0) {
+		    rc = rc1;
+		}
+		TSS_HmacSession_DeleteData(tssContext, tssContext->sessions[i].sessionHandle);
+	    }
+	}
+    }
+#endif
+    tssContext->tssHoldSessions = hold;
+    return rc;
+}
+
+/* TSS_GetNameCacheStatistics() returns the number of Name calculations that were found in the
+   context Name cache, and the number that had to be hashed.
+
+   The TSS without crypto support does not calculate Names, and returns zero counts.
+*/
+
+TPM_RC TSS_GetNameCacheStatistics(TSS_CONTEXT *tssContext,
+				  uint32_t *hits,
+				  uint32_t *misses)
+{
+    TPM_RC	rc = 0;
+#ifndef TPM_TSS_NOCRYPTO
+    *hits = tssContext->nameCacheHits;
+    *misses = tssContext->nameCacheMisses;
+#else
+    tssContext = tssContext;
+    *hits = 0;
+    *misses = 0;
+#endif
+    return rc;
+}
+
+/* TSS_GetRetryStatistics() returns the number of times a command was resent because the TPM
+   returned TPM_RC_RETRY, TPM_RC_YIELDED, or TPM_RC_TESTING, and the number of commands that still
+   returned one of those codes after the last resend.  See the TPM_RETRY_COUNT and TPM_RETRY_DELAY
+   properties.
+*/
+
+TPM_RC TSS_GetRetryStatistics(TSS_CONTEXT *tssContext,
+			      uint32_t *resends,
+			      uint32_t *exhausted)
+{
+    TPM_RC	rc = 0;
+    *resends = tssContext->tssRetryResends;
+    *exhausted = tssContext->tssRetryExhausted;
+    return rc;
+}
+
+/* TSS_GetSocketStatistics() returns the number of commands transmitted over the socket interface,
+   and the number of send and receive system calls used for them.  A command normally takes one of
+   each.
+*/
+
+TPM_RC TSS_GetSocketStatistics(TSS_CONTEXT *tssContext,
+			       uint32_t *commands,
+			       uint32_t *writes,
+			       uint32_t *reads)
+{
+    TPM_RC	rc = 0;
+    *commands = tssContext->tssSocketCommands;
+    *writes = tssContext->tssSocketWrites;
+    *reads = tssContext->tssSocketReads;
+    return rc;
+}
+
+/* TSS_GetDeviceStatistics() returns the number of commands transmitted over the device interface,
+   the number that did not respond within the TPM_DEVICE_TIMEOUT or TPM_DEVICE_TIMEOUT_LONG, the
+   usec blocked on the device waiting for responses, and the usec spent processing in
+   TSS_Execute() otherwise.  The wait includes the TPM execution and, with the resource manager,
+   commands from other contexts queued ahead.
+*/
+
+TPM_RC TSS_GetDeviceStatistics(TSS_CONTEXT *tssContext,
+			       uint32_t *commands,
+			       uint32_t *timeouts,
+			       uint64_t *waitTime,
+			       uint64_t *processTime)
+{
+    TPM_RC	rc = 0;
+    *commands = tssContext->tssDevCommands;
+    *timeouts = tssContext->tssDevTimeouts;
+    *waitTime = tssContext->tssDevWaitTime;
+    *processTime = tssContext->tssDevProcessTime;
+    return rc;
+}
+
+/* TSS_GetPolicyDigest() returns the policy digest that the TSS tracks for a policy or trial
+   session, without a TPM round trip.  It returns TSS_RC_POLICY_NOT_EMULATED if the TSS could not
+   calculate the digest, in which case TPM2_PolicyGetDigest must be used.
+*/
+
+TPM_RC TSS_GetPolicyDigest(TSS_CONTEXT *tssContext,
+			   TPM2B_DIGEST *policyDigest,
+			   TPMI_SH_POLICY policySession)
+{
+    TPM_RC			rc = 0;
+    struct TSS_HMAC_CONTEXT 	session;
+
+    if (rc == 0) {
+	rc = TSS_HmacSession_LoadSession(tssContext, &session, policySession);
+    }
+    if (rc == 0) {
+	if (session.isPolicyDigestValid) {
+	    *policyDigest = session.policyDigest;
+	}
+	else {
+	    rc = TSS_RC_POLICY_NOT_EMULATED;
+	}
+    }
+    return rc;
+}
+
+/* TSS_GetSessionAuditDigest() returns the session audit digest that the TSS tracks for an HMAC
+   session, the expected TPMS_SESSION_AUDIT_INFO sessionDigest of TPM2_GetSessionAuditDigest.  It
+   returns TSS_RC_AUDIT_NOT_EMULATED if the TSS could not calculate the digest.
+*/
+
+TPM_RC TSS_GetSessionAuditDigest(TSS_CONTEXT *tssContext,
+				 TPM2B_DIGEST *auditDigest,
+				 TPMI_SH_HMAC sessionHandle)
+{
+    TPM_RC			rc = 0;
+    struct TSS_HMAC_CONTEXT 	session;
+
+    if (rc == 0) {
+	rc = TSS_HmacSession_LoadSession(tssContext, &session, sessionHandle);
+    }
+    if (rc == 0) {
+	if (session.isAuditDigestValid) {
+	    *auditDigest = session.auditDigest;
+	}
+	else {
+	    rc = TSS_RC_AUDIT_NOT_EMULATED;
+	}
+    }
+    return rc;
+}
+
+/* TSS_GetCpHash() returns the cpHash of the command 'in' for each hash algorithm in the cpHash
+   array, e.g. for the TPM2_PolicyCpHash of a policy that authorizes that command.  The caller sets
+   each cpHash[].hashAlg.  count is at most HASH_COUNT.
+
+   The command is marshaled into the TSS context but not sent.  The command pre-processor is not
+   run.  The Names of the command handles must be known to the TSS, as for an HMAC session.
+*/
+
+TPM_RC TSS_GetCpHash(TSS_CONTEXT *tssContext,
+		     TPMT_HA cpHash[],
+		     size_t count,
+		     COMMAND_PARAMETERS *in,
+		     TPM_CC commandCode)
+{
+    TPM_RC		rc = 0;
+#ifndef TPM_TSS_NOCRYPTO
+    uint32_t		i;
+    TPM2B_NAME 		name[MAX_SESSION_NUM];
+    TPM2B_NAME 		*names[MAX_SESSION_NUM];
+
+    for (i = 0 ; i < MAX_SESSION_NUM ; i++) {
+	names[i] = &name[i];
+	name[i].b.size = 0;		/* to ignore unused names in cpHash calculation */
+    }
+    if (rc == 0) {
+	TSS_InitAuthContext(tssContext->tssAuthContext);
+    }
+    if (rc == 0) {
+	if (tssVverbose) printf("TSS_GetCpHash: Command %08x marshal\n", commandCode);
+	rc = TSS_Marshal(tssContext->tssAuthContext,
+			 in,
+			 commandCode);
+    }
+    if (rc == 0) {
+	rc = TSS_Name_GetAllNames(tssContext, names);
+    }
+    if (rc == 0) {
+	rc = TSS_CpHash_Calculate(tssContext->tssAuthContext, cpHash, count,
+				  names[0], names[1], names[2]);
+    }
+#else
+    tssContext = tssContext;
+    cpHash = cpHash;
+    count = count;
+    in = in;
+    commandCode = commandCode;
+    if (tssVerbose) printf("TSS_GetCpHash: not implemented for NOCRYPTO\n");
+    rc = TSS_RC_NOT_IMPLEMENTED;
+#endif	/* TPM_TSS_NOCRYPTO */
+    return rc;
+}
+
 /* TSS_Execute() performs the complete command / response process.
 
    It sends the command specified by commandCode and the parameters 'in', returning the response
@@ -688,6 +1025,11 @@ TPM_RC TSS_Execute(TSS_CONTEXT *tssContext,
 {
     TPM_RC		rc = 0;
     va_list		ap;
+    int			emulated = FALSE;	/* command was answered by the TSS */
+#ifdef TPM_POSIX
+    uint64_t		startTime = TSS_Dev_GetTime();
+    uint64_t		startWaitTime = tssContext->tssDevWaitTime;
+#endif
 
     /* create a TSS context */
     if (rc == 0) {
@@ -707,14 +1049,18 @@ TPM_RC TSS_Execute(TSS_CONTEXT *tssContext,
 			 in,
 			 commandCode);
     }
+    /* trial policy sessions and policy digests can be handled without the TPM */
+    if ((rc == 0) && tssContext->tssPolicyEmulate) {
+	rc = TSS_Execute_Emulate(tssContext, &emulated, out, in, commandCode);
+    }
     /* execute the command */
-    if (rc == 0) {
+    if ((rc == 0) && !emulated) {
 	va_start(ap, commandCode);
 	rc = TSS_Execute_valist(tssContext, in, ap);
 	va_end(ap);
     }
     /* unmarshal the response parameters */
-    if (rc == 0) {
+    if ((rc == 0) && !emulated) {
 	if (tssVverbose) printf("TSS_Execute: Command %08x unmarshal\n", commandCode);
 	rc = TSS_Unmarshal(tssContext->tssAuthContext, out);
     }
@@ -726,6 +1072,214 @@ TPM_RC TSS_Execute(TSS_CONTEXT *tssContext,
 					out,
 					extra);
     }
+#ifdef TPM_POSIX
+    TSS_Dev_AddProcessTime(tssContext, startTime, startWaitTime);
+#endif
+    return rc;
+}
+
+/* TSS_ExecuteView() is TSS_Execute() without the response parameter unmarshal.  Rather than
+   copying into a RESPONSE_PARAMETERS structure, it returns 'view', the response parameter area in
+   the TSS response buffer.  The caller parses it with TSS_ResponseView_TPM2B() for large TPM2B
+   fields and the *_Unmarshal functions for the others.
+
+   The view is valid until the next command on the TSS_CONTEXT.  Response handles are not in the
+   view.
+
+   This avoids the RESPONSE_PARAMETERS union (several KB) and the copy of each TPM2B to a maximum
+   size field, e.g. for high rate TPM2_NV_Read, TPM2_Quote, or TPM2_GetRandom.
+
+   Only commands without a TSS response post processor are supported, since those use the
+   unmarshaled response.  Others return TSS_RC_OUT_PARAMETER.  Trial policy session emulation is
+   not done.
+*/
+
+TPM_RC TSS_ExecuteView(TSS_CONTEXT *tssContext,
+		       TSS_RESPONSE_VIEW *view,
+		       COMMAND_PARAMETERS *in,
+		       EXTRA_PARAMETERS *extra,
+		       TPM_CC commandCode,
+		       ...)
+{
+    TPM_RC		rc = 0;
+    va_list		ap;
+    uint32_t 		rpBufferSize;
+    uint8_t 		*rpBuffer;
+#ifdef TPM_POSIX
+    uint64_t		startTime = TSS_Dev_GetTime();
+    uint64_t		startWaitTime = tssContext->tssDevWaitTime;
+#endif
+
+    if (rc == 0) {
+	if (TSS_GetPostProcessFunction(commandCode) != NULL) {
+	    if (tssVerbose) printf("TSS_ExecuteView: Command %08x requires response parameters\n",
+				   commandCode);
+	    rc = TSS_RC_OUT_PARAMETER;
+	}
+    }
+    if (rc == 0) {
+	TSS_InitAuthContext(tssContext->tssAuthContext);
+    }
+    /* handle any command specific command pre-processing */
+    if (rc == 0) {
+	rc = TSS_Command_PreProcessor(tssContext,
+				      commandCode,
+				      in,
+				      extra);
+    }
+    /* marshal input parameters */
+    if (rc == 0) {
+	if (tssVverbose) printf("TSS_ExecuteView: Command %08x marshal\n", commandCode);
+	rc = TSS_Marshal(tssContext->tssAuthContext,
+			 in,
+			 commandCode);
+    }
+    /* execute the command, including response HMAC verification and parameter decryption */
+    if (rc == 0) {
+	va_start(ap, commandCode);
+	rc = TSS_Execute_valist(tssContext, in, ap);
+	va_end(ap);
+    }
+    /* the response parameter area, range checked against the response size */
+    if (rc == 0) {
+	rc = TSS_GetRpBuffer(tssContext->tssAuthContext, &rpBufferSize, &rpBuffer);
+    }
+    if (rc == 0) {
+	view->buffer = rpBuffer;
+	view->size = rpBufferSize;
+    }
+#ifdef TPM_POSIX
+    TSS_Dev_AddProcessTime(tssContext, startTime, startWaitTime);
+#endif
+    return rc;
+}
+
+/* TSS_ResponseView_TPM2B() consumes a TPM2B from the front of 'view' and returns it in 'target'
+   without copying.  targetSize is the maximum size of the TPM2B buffer, the same check as the
+   TPM2B unmarshal, e.g. sizeof(TPMU_MAX_NV_BUFFER) for TPM2B_MAX_NV_BUFFER.
+*/
+
+TPM_RC TSS_ResponseView_TPM2B(TSS_TPM2B_VIEW *target,
+			      uint16_t targetSize,
+			      TSS_RESPONSE_VIEW *view)
+{
+    TPM_RC	rc = 0;
+    uint16_t	size;
+
+    if (rc == 0) {
+	rc = UINT16_Unmarshal(&size, &view->buffer, &view->size);
+    }
+    if (rc == 0) {
+	if (size > targetSize) {
+	    rc = TPM_RC_SIZE;
+	}
+    }
+    if (rc == 0) {
+	if ((int32_t)size > view->size) {
+	    rc = TPM_RC_INSUFFICIENT;
+	}
+    }
+    if (rc == 0) {
+	target->buffer = view->buffer;
+	target->size = size;
+	view->buffer += size;
+	view->size -= size;
+    }
+    return rc;
+}
+
+/* TSS_Execute_Emulate() answers a command in the TSS, without a TPM round trip.  It is called when
+   the TPM_POLICY_EMULATE property is set.  emulated is set TRUE if the command was answered, in
+   which case the command is not sent and the response parameters are filled in.
+
+   StartAuthSession for an unbound, unsalted trial session creates a session that exists only in
+   the TSS, with a handle starting at TSS_EMULATED_SESSION_FIRST.  Policy commands, PolicyRestart,
+   and FlushContext for such a session are not sent.  The post processors update the policy digest
+   and delete the session state.
+
+   PolicyGetDigest for an emulated trial session is answered from the tracked policy digest.  A TPM
+   session is always sent to the TPM, which is the authority on its policy digest.
+*/
+
+static TPM_RC TSS_Execute_Emulate(TSS_CONTEXT *tssContext,
+				  int *emulated,
+				  RESPONSE_PARAMETERS *out,
+				  COMMAND_PARAMETERS *in,
+				  TPM_CC commandCode)
+{
+    TPM_RC			rc = 0;
+#ifndef TPM_TSS_NOCRYPTO
+    TPMI_SH_POLICY		policySession;
+    struct TSS_HMAC_CONTEXT 	session;
+
+    *emulated = FALSE;
+    switch (commandCode) {
+      case TPM_CC_StartAuthSession:
+	/* a trial session with no bind or salt has no secret, so the TSS can run it */
+	if ((in->StartAuthSession.sessionType == TPM_SE_TRIAL) &&
+	    (in->StartAuthSession.tpmKey == TPM_RH_NULL) &&
+	    (in->StartAuthSession.bind == TPM_RH_NULL)) {
+	    if (rc == 0) {
+		rc = TSS_PolicySession_NewHandle(tssContext,
+						 &out->StartAuthSession.sessionHandle);
+	    }
+	    if (rc == 0) {
+		out->StartAuthSession.nonceTPM.t.size =
+		    TSS_GetDigestSize(in->StartAuthSession.authHash);
+		rc = TSS_RandBytes(out->StartAuthSession.nonceTPM.t.buffer,
+				   out->StartAuthSession.nonceTPM.t.size);
+	    }
+	    if (rc == 0) {
+		if (tssVverbose) printf("TSS_Execute_Emulate: trial session %08x\n",
+					out->StartAuthSession.sessionHandle);
+		*emulated = TRUE;
+	    }
+	}
+	break;
+      case TPM_CC_FlushContext:
+	*emulated = TSS_PolicySession_IsEmulated(in->FlushContext.flushHandle);
+	break;
+      case TPM_CC_PolicyGetDigest:
+	/* a TPM session is always sent to the TPM */
+	if (TSS_PolicySession_IsEmulated(in->PolicyGetDigest.policySession)) {
+	    rc = TSS_HmacSession_LoadSession(tssContext, &session,
+					     in->PolicyGetDigest.policySession);
+	    *emulated = TRUE;
+	}
+	if ((rc == 0) && *emulated) {
+	    if (tssVverbose) printf("TSS_Execute_Emulate: policy digest for session %08x\n",
+				    in->PolicyGetDigest.policySession);
+	    out->PolicyGetDigest.policyDigest = session.policyDigest;
+	}
+	break;
+      default:
+	if (TSS_PolicySession_GetHandle(&policySession, commandCode, in)) {
+	    *emulated = TSS_PolicySession_IsEmulated(policySession);
+	}
+	/* a trial session returns an empty timeout and a NULL ticket */
+	if (*emulated && (out != NULL)) {
+	    if (commandCode == TPM_CC_PolicySigned) {
+		out->PolicySigned.timeout.t.size = 0;
+		out->PolicySigned.policyTicket.tag = TPM_ST_AUTH_SIGNED;
+		out->PolicySigned.policyTicket.hierarchy = TPM_RH_NULL;
+		out->PolicySigned.policyTicket.digest.t.size = 0;
+	    }
+	    else if (commandCode == TPM_CC_PolicySecret) {
+		out->PolicySecret.timeout.t.size = 0;
+		out->PolicySecret.policyTicket.tag = TPM_ST_AUTH_SECRET;
+		out->PolicySecret.policyTicket.hierarchy = TPM_RH_NULL;
+		out->PolicySecret.policyTicket.digest.t.size = 0;
+	    }
+	}
+	break;
+    }
+#else
+    tssContext = tssContext;
+    out = out;
+    in = in;
+    commandCode = commandCode;
+    *emulated = FALSE;
+#endif	/* TPM_TSS_NOCRYPTO */
     return rc;
 }
 
@@ -767,6 +1321,11 @@ static TPM_RC TSS_Execute_valist(TSS_CONTEXT *tssContext,
     struct TSS_HMAC_CONTEXT *session[MAX_SESSION_NUM];
     TPM2B_NAME authName[MAX_SESSION_NUM];
     TPM2B_NAME *names[MAX_SESSION_NUM];
+#ifndef TPM_TSS_NOCRYPTO
+    /* rpHash, one per distinct session hash algorithm */
+    TPMT_HA		rpHash[MAX_SESSION_NUM];
+    size_t		rpHashCount = 0;
+#endif	/* TPM_TSS_NOCRYPTO */
 	
     /* Step 1: initialization */
     if (tssVverbose) printf("TSS_Execute_valist: Step 1: initialization\n");
@@ -838,7 +1397,7 @@ static TPM_RC TSS_Execute_valist(TSS_CONTEXT *tssContext,
 	    if (tssVverbose)
 		printf("TSS_Execute_valist: Step 3: nonceCaller %08x\n", sessionHandle[i]);
 #ifndef TPM_TSS_NOCRYPTO
-	    rc = TSS_HmacSession_SetNonceCaller(session[i], authC[i]);
+	    rc = TSS_HmacSession_SetNonceCaller(tssContext, session[i], authC[i]);
 #else
 	    authC[i]->nonce.b.size = 16;
 	    memset(&authC[i]->nonce.b.buffer, 0, 16);
@@ -901,6 +1460,17 @@ static TPM_RC TSS_Execute_valist(TSS_CONTEXT *tssContext,
 			     authR[2],
 			     NULL);
     }
+#ifndef TPM_TSS_NOCRYPTO
+    /* Step 10: calculate rpHash once for each distinct session hash algorithm */
+    for (i = 0 ; (rc == 0) && (i < MAX_SESSION_NUM) && (sessionHandle[i] != TPM_RH_NULL) ; i++) {
+	if ((sessionHandle[i] != TPM_RS_PW) && TSS_HmacSession_IsVerifyNeeded(session[i])) {
+	    TSS_HashList_Add(rpHash, &rpHashCount, session[i]->authHashAlg);
+	}
+    }
+    if ((rc == 0) && (rpHashCount > 0)) {
+	rc = TSS_RpHash_Calculate(tssContext->tssAuthContext, rpHash, rpHashCount);
+    }
+#endif	/* TPM_TSS_NOCRYPTO */
     /* Step 10: process the response authorizations, validate the HMAC */
     for (i = 0 ; (rc == 0) && (i < MAX_SESSION_NUM) && (sessionHandle[i] != TPM_RH_NULL) ; i++) {
 	if (tssVverbose)
@@ -919,16 +1489,16 @@ static TPM_RC TSS_Execute_valist(TSS_CONTEXT *tssContext,
 #endif	/* TPM_TSS_NOCRYPTO */
 	    /* the HMAC key is already part of the TSS session context.  For policy sessions with
 	       policy password, the response hmac is empty. */
-	    if ((session[i]->sessionType == TPM_SE_HMAC) ||
-		((session[i]->sessionType == TPM_SE_POLICY) && (session[i]->isAuthValueNeeded))) {
+	    if (TSS_HmacSession_IsVerifyNeeded(session[i])) {
 #ifndef TPM_TSS_NOCRYPTO
 		if (rc == 0) {
 		    rc = TSS_Command_ChangeAuthProcessor(tssContext, session[i], i, in);
 		}
 		if (rc == 0) {
-		    rc = TSS_HmacSession_Verify(tssContext->tssAuthContext, /* authorization
-									       context */
-						session[i],	/* TSS session context */
+		    rc = TSS_HmacSession_Verify(session[i],	/* TSS session context */
+						/* rpHash for the session algorithm */
+						TSS_HashList_Find(rpHash, rpHashCount,
+								  session[i]->authHashAlg),
 						authR[i]);	/* input: response authorization */
 		}
 #else
@@ -944,12 +1514,16 @@ static TPM_RC TSS_Execute_valist(TSS_CONTEXT *tssContext,
     /* Step 11: process the audit flag */
     for (i = 0 ; (rc == 0) && (i < MAX_SESSION_NUM) && (sessionHandle[i] != TPM_RH_NULL) ; i++) {
 	if ((sessionHandle[i] != TPM_RS_PW) &&
-	    (session[i]->bind != TPM_RH_NULL) &&
 	    (authR[i]->sessionAttributes.val & TPMA_SESSION_AUDIT)) {
-	    if (tssVverbose) printf("TSS_Execute_valist: Step 11: process bind audit flag %08x\n",
-				    sessionHandle[i]);
-	    /* if bind audit session, bind value is lost and further use requires authValue */
-	    session[i]->bind = TPM_RH_NULL;
+	    if (session[i]->bind != TPM_RH_NULL) {
+		if (tssVverbose)
+		    printf("TSS_Execute_valist: Step 11: process bind audit flag %08x\n",
+			   sessionHandle[i]);
+		/* if bind audit session, bind value is lost and further use requires authValue */
+		session[i]->bind = TPM_RH_NULL;
+	    }
+	    /* extend the expected session audit digest */
+	    TSS_HmacSession_Audit(session[i], sessionAttributes[i]);
 	}
     }
     /* Step 12: process the response continue flag */
@@ -1070,11 +1644,17 @@ static void TSS_HmacSession_InitContext(struct TSS_HMAC_CONTEXT *session)
     session->sessionType = 0;
     session->isPasswordNeeded = FALSE;
     session->isAuthValueNeeded = FALSE;
+    session->isPolicyDigestValid = FALSE;
+    session->policyDigest.b.size = 0;
+    session->isAuditDigestValid = FALSE;
+    session->auditDigest.b.size = 0;
     memset(session->hmacKey.t.buffer, 0, sizeof(TPMU_HA) + sizeof(TPMU_HA));
     session->hmacKey.b.size = 0;
 #ifndef TPM_TSS_NOCRYPTO
     memset(session->sessionValue.t.buffer, 0, sizeof(TPMU_HA) + sizeof(TPMU_HA));
     session->sessionValue.b.size = 0;
+    session->cpHash.hashAlg = TPM_ALG_NULL;
+    session->rpHash.hashAlg = TPM_ALG_NULL;
 #endif
 }
 
@@ -1171,20 +1751,62 @@ static TPM_RC TSS_HmacSession_SaveSession(TSS_CONTEXT *tssContext,
     TPM_RC	rc = 0;
     uint8_t 	*buffer = NULL;		/* marshaled TSS_HMAC_CONTEXT */
     uint16_t	written = 0;
-#ifndef TPM_TSS_NOFILE
-    char	sessionFilename[128];
-    uint8_t *outBuffer = NULL;
-    uint32_t outLength;
-#endif
     
     if (tssVverbose) printf("TSS_HmacSession_SaveSession: handle %08x\n", session->sessionHandle);
+    /* marshal once into the context buffer, no allocation after the first save */
     if (rc == 0) {
-	rc = TSS_Structure_Marshal(&buffer,	/* freed @1 */
-				   &written,
-				   session,
-				   (MarshalFunction_t)TSS_HmacSession_Marshal);
+	rc = TSS_Structure_MarshalBuffer(&tssContext->sessionMarshalBuffer,
+					 &written,
+					 session,
+					 (MarshalFunction_t)TSS_HmacSession_Marshal);
+    }
+    if (rc == 0) {
+	buffer = tssContext->sessionMarshalBuffer.buffer;
+    }
+#ifndef TPM_TSS_NOFILE
+    if (rc == 0) {
+	/* while sessions are held, the session state stays in the context */
+	if (!tssContext->tssHoldSessions) {
+	    rc = TSS_HmacSession_SaveFile(tssContext,
+					  session->sessionHandle,
+					  written, buffer);
+	}
+	else {
+	    rc = TSS_HmacSession_SaveData(tssContext,
+					  session->sessionHandle,
+					  written, buffer);
+	}
+    }
+#else		/* no file support, save to context */
+    if (rc == 0) {
+	rc = TSS_HmacSession_SaveData(tssContext,
+				      session->sessionHandle,
+				      written, buffer);
+    }
+#endif
+    /* erase the session secrets */
+    if (buffer != NULL) {
+	memset(buffer, 0, written);
     }
+    return rc;
+}
+
 #ifndef TPM_TSS_NOFILE
+
+/* TSS_HmacSession_SaveFile() saves the marshaled session state in the session file, encrypting it
+   if the TSS is configured to encrypt sessions.
+*/
+
+static TPM_RC TSS_HmacSession_SaveFile(TSS_CONTEXT *tssContext,
+				       TPMI_SH_AUTH_SESSION sessionHandle,
+				       uint32_t written,
+				       uint8_t *buffer)
+{
+    TPM_RC	rc = 0;
+    char	sessionFilename[128];
+    uint8_t *outBuffer = NULL;
+    uint32_t outLength;
+
     if (rc == 0) {
 	/* if the flag is set, encrypt the session state before store */
 	if (tssContext->tssEncryptSessions) {
@@ -1204,7 +1826,7 @@ static TPM_RC TSS_HmacSession_SaveSession(TSS_CONTEXT *tssContext,
        handle */
     if (rc == 0) {
 	sprintf(sessionFilename, "%s/h%08x.bin",
-		tssContext->tssDataDirectory, session->sessionHandle);
+		tssContext->tssDataDirectory, sessionHandle);
     }
     if (rc == 0) {
 	rc = TSS_File_WriteBinaryFile(outBuffer,
@@ -1214,17 +1836,11 @@ static TPM_RC TSS_HmacSession_SaveSession(TSS_CONTEXT *tssContext,
     if (tssContext->tssEncryptSessions) {
 	free(outBuffer);	/* @2 */
     }
-#else		/* no file support, save to context */
-    if (rc == 0) {
-	rc = TSS_HmacSession_SaveData(tssContext,
-				      session->sessionHandle,
-				      written, buffer);
-    }
-#endif
-    free(buffer);	/* @1 */
     return rc;
 }
 
+#endif	/* TPM_TSS_NOFILE */
+
 /* TSS_HmacSession_LoadSession() loads an HMAC existing session saved by:
 
    startauthsession
@@ -1241,21 +1857,33 @@ static TPM_RC TSS_HmacSession_LoadSession(TSS_CONTEXT *tssContext,
 #ifndef TPM_TSS_NOFILE
     size_t 		length = 0;
     char		sessionFilename[128];
+    size_t		slotIndex;
+    int			held = FALSE;		/* session state is held in the context */
 #endif    
     unsigned char *inData = NULL;		/* output */
     uint32_t inLength;				/* output */
 
     if (tssVverbose) printf("TSS_HmacSession_LoadSession: handle %08x\n", sessionHandle);
 #ifndef TPM_TSS_NOFILE
+    if (rc == 0) {
+	if (tssContext->tssHoldSessions) {
+	    held = (TSS_HmacSession_GetSlotForHandle(tssContext, &slotIndex, sessionHandle) == 0);
+	}
+    }
+    if ((rc == 0) && held) {
+	rc = TSS_HmacSession_LoadData(tssContext,
+				      &inLength, &inData,
+				      sessionHandle);
+    }
     /* load the session from a hard coded file name hxxxxxxxx.bin where xxxxxxxx is the session
        handle */
-    if (rc == 0) {
+    if ((rc == 0) && !held) {
 	sprintf(sessionFilename, "%s/h%08x.bin", tssContext->tssDataDirectory, sessionHandle);
 	rc = TSS_File_ReadBinaryFile(&buffer,     /* freed @1 */
 				     &length,
 				     sessionFilename);
     }
-    if (rc == 0) {
+    if ((rc == 0) && !held) {
 	/* if the flag is set, decrypt the session state before unmarshal */
 	if (tssContext->tssEncryptSessions) {
 	    rc = TSS_AES_Decrypt(tssContext->tssSessionDecKey,
@@ -1283,7 +1911,7 @@ static TPM_RC TSS_HmacSession_LoadSession(TSS_CONTEXT *tssContext,
 	rc = TSS_HmacSession_Unmarshal(session, &buffer1, &ilength);
     }
 #ifndef TPM_TSS_NOFILE
-    if (tssContext->tssEncryptSessions) {
+    if (tssContext->tssEncryptSessions && !held) {
 	free(inData);	/* @2 */
     }
 #endif
@@ -1291,7 +1919,10 @@ static TPM_RC TSS_HmacSession_LoadSession(TSS_CONTEXT *tssContext,
     return rc;
 }
 
-#ifdef TPM_TSS_NOFILE
+/* TSS_HmacSession_SaveData(), TSS_HmacSession_LoadData(), and TSS_HmacSession_DeleteData() keep the
+   marshaled session state in the TSS context.  They are used by the TSS without file support, and
+   by the file TSS while sessions are held.
+*/
 
 static TPM_RC TSS_HmacSession_SaveData(TSS_CONTEXT *tssContext,
 				       TPMI_SH_AUTH_SESSION sessionHandle,
@@ -1396,8 +2027,6 @@ static TPM_RC TSS_HmacSession_GetSlotForHandle(TSS_CONTEXT *tssContext,
     return TSS_RC_NO_SESSION_SLOT;
 }
 
-#endif
-
 static uint16_t TSS_HmacSession_Marshal(struct TSS_HMAC_CONTEXT *source,
 					uint16_t *written,
 					uint8_t **buffer,
@@ -1452,6 +2081,18 @@ static uint16_t TSS_HmacSession_Marshal(struct TSS_HMAC_CONTEXT *source,
     if (rc == 0) {
 	rc = TSS_UINT8_Marshal(&source->isAuthValueNeeded, written, buffer, size);
     }  
+    if (rc == 0) {
+	rc = TSS_UINT8_Marshal(&source->isPolicyDigestValid, written, buffer, size);
+    }
+    if (rc == 0) {
+	rc = TSS_TPM2B_DIGEST_Marshal(&source->policyDigest, written, buffer, size);
+    }
+    if (rc == 0) {
+	rc = TSS_UINT8_Marshal(&source->isAuditDigestValid, written, buffer, size);
+    }
+    if (rc == 0) {
+	rc = TSS_TPM2B_DIGEST_Marshal(&source->auditDigest, written, buffer, size);
+    }
     return rc;
 }
 
@@ -1503,6 +2144,24 @@ static TPM_RC TSS_HmacSession_Unmarshal(struct TSS_HMAC_CONTEXT *target,
     if (rc == 0) {
 	rc = UINT8_Unmarshal(&target->isAuthValueNeeded, buffer, size);
     }
+    /* a session file saved by an older TSS ends here or after the policy digest.  The digests that
+       it did not track are marked as not tracked. */
+    target->isPolicyDigestValid = FALSE;
+    target->policyDigest.t.size = 0;
+    target->isAuditDigestValid = FALSE;
+    target->auditDigest.t.size = 0;
+    if ((rc == 0) && (*size > 0)) {
+	rc = UINT8_Unmarshal(&target->isPolicyDigestValid, buffer, size);
+	if (rc == 0) {
+	    rc = TPM2B_DIGEST_Unmarshal(&target->policyDigest, buffer, size);
+	}
+    }
+    if ((rc == 0) && (*size > 0)) {
+	rc = UINT8_Unmarshal(&target->isAuditDigestValid, buffer, size);
+	if (rc == 0) {
+	    rc = TPM2B_DIGEST_Unmarshal(&target->auditDigest, buffer, size);
+	}
+    }
     return rc;
 }
 
@@ -2115,15 +2774,31 @@ static TPM_RC TSS_DeleteHandle(TSS_CONTEXT *tssContext,
     TPM_HT 		handleType;
 #ifndef TPM_TSS_NOFILE
     char		filename[128];
+    int			held = FALSE;
 #endif
 
     handleType = (TPM_HT) ((handle & HR_RANGE_MASK) >> HR_SHIFT);
 #ifndef TPM_TSS_NOFILE
+    /* delete any held session state.  A session started while sessions are held may not have a
+       file yet. */
+    if (rc == 0) {
+	if ((handleType == TPM_HT_HMAC_SESSION) ||
+	    (handleType == TPM_HT_POLICY_SESSION)) {
+	    size_t slotIndex;
+	    if (TSS_HmacSession_GetSlotForHandle(tssContext, &slotIndex, handle) == 0) {
+		rc = TSS_HmacSession_DeleteData(tssContext, handle);
+		held = TRUE;
+	    }
+	}
+    }
     /* delete the Name */
     if (rc == 0) {
 	sprintf(filename, "%s/h%08x.bin", tssContext->tssDataDirectory, handle);
 	if (tssVverbose) printf("TSS_DeleteHandle: delete Name file %s\n", filename);
 	rc = TSS_File_DeleteFile(filename);
+	if (held) {
+	    rc = 0;
+	}
     }
     /* delete the public if it exists */
     if (rc == 0) {
@@ -2160,15 +2835,14 @@ static TPM_RC TSS_DeleteHandle(TSS_CONTEXT *tssContext,
    because the Name returned from the TPM2_ReadPublic cannot be trusted.
 */
 
-static TPM_RC TSS_ObjectPublic_GetName(TPM2B_NAME *name,
+static TPM_RC TSS_ObjectPublic_GetName(TSS_CONTEXT *tssContext,
+				       TPM2B_NAME *name,
 				       TPMT_PUBLIC *tpmtPublic)
 {
     TPM_RC 	rc = 0;
     
 #ifndef TPM_TSS_NOCRYPTO
     uint16_t 	written = 0;
-    TPMT_HA	digest;
-    uint32_t 	sizeInBytes;
     uint8_t 	buffer[MAX_RESPONSE_SIZE];
 
     /* marshal the TPMT_PUBLIC */
@@ -2179,23 +2853,10 @@ static TPM_RC TSS_ObjectPublic_GetName(TPM2B_NAME *name,
     }
     /* hash the public area */
     if (rc == 0) {
-	sizeInBytes = TSS_GetDigestSize(tpmtPublic->nameAlg);
-	digest.hashAlg = tpmtPublic->nameAlg;	/* Name digest algorithm */
-	/* generate the TPMT_HA */
-	rc = TSS_Hash_Generate(&digest,	
-			       written, buffer,
-			       0, NULL);
-    }
-    if (rc == 0) {
-	/* copy the digest */
-	memcpy(name->t.name + sizeof(TPMI_ALG_HASH), (uint8_t *)&digest.digest, sizeInBytes);
-	/* copy the hash algorithm */
-	TPMI_ALG_HASH nameAlgNbo = htons(tpmtPublic->nameAlg);
-	memcpy(name->t.name, (uint8_t *)&nameAlgNbo, sizeof(TPMI_ALG_HASH));
-	/* set the size */
-	name->t.size = sizeInBytes + sizeof(TPMI_ALG_HASH);
+	rc = TSS_Name_Calculate(tssContext, name, tpmtPublic->nameAlg, buffer, written);
     }
 #else
+    tssContext = tssContext;
     tpmtPublic = tpmtPublic;
     name->t.size = 0;
 #endif
@@ -2395,14 +3056,13 @@ static TPM_RC TSS_NvPublic_GetSlotForHandle(TSS_CONTEXT *tssContext,
 
 #ifndef TPM_TSS_NOCRYPTO
 
-static TPM_RC TSS_NVPublic_GetName(TPM2B_NAME *name,
+static TPM_RC TSS_NVPublic_GetName(TSS_CONTEXT *tssContext,
+				   TPM2B_NAME *name,
 				   TPMS_NV_PUBLIC *nvPublic)
 {
     TPM_RC 	rc = 0;
     
     uint16_t 	written = 0;
-    TPMT_HA	digest;
-    uint32_t 	sizeInBytes;
     uint8_t 	buffer[MAX_RESPONSE_SIZE];
 
     /* marshal the TPMS_NV_PUBLIC */
@@ -2413,30 +3073,93 @@ static TPM_RC TSS_NVPublic_GetName(TPM2B_NAME *name,
     }
     /* hash the public area */
     if (rc == 0) {
-	sizeInBytes = TSS_GetDigestSize(nvPublic->nameAlg);
-	digest.hashAlg = nvPublic->nameAlg;	/* Name digest algorithm */
-	/* generate the TPMT_HA */
-	rc = TSS_Hash_Generate(&digest,	
-			       written, buffer,
-			       0, NULL);
-    }
-    if (rc == 0) {
-	/* copy the digest */
-	memcpy(name->t.name + sizeof(TPMI_ALG_HASH), (uint8_t *)&digest.digest, sizeInBytes);
-	/* copy the hash algorithm */
-	TPMI_ALG_HASH nameAlgNbo = htons(nvPublic->nameAlg);
-	memcpy(name->t.name, (uint8_t *)&nameAlgNbo, sizeof(TPMI_ALG_HASH));
-	/* set the size */
-	name->t.size = sizeInBytes + sizeof(TPMI_ALG_HASH);
+	rc = TSS_Name_Calculate(tssContext, name, nvPublic->nameAlg, buffer, written);
     }
    return rc;
 }
 
+/* TSS_Name_Calculate() calculates the Name from the marshaled public area buffer.
+
+   Name = nameAlg || HnameAlg (public area)
+
+   The Name is a function of only the marshaled bytes, so the result is cached in the TSS context,
+   addressed by the marshaled bytes.  An application that repeatedly loads the same keys skips the
+   hash.  The hash is still calculated for a public area that is not in the cache, so the Name
+   still provides security.
+*/
+
+static TPM_RC TSS_Name_Calculate(TSS_CONTEXT *tssContext,
+				 TPM2B_NAME *name,
+				 TPMI_ALG_HASH nameAlg,
+				 const uint8_t *buffer,
+				 uint16_t written)
+{
+    TPM_RC 	rc = 0;
+    TPMT_HA	digest;
+    uint32_t 	sizeInBytes;
+    uint32_t	key = 2166136261U;		/* FNV-1a offset basis */
+    uint16_t	i;
+    int		found = FALSE;
+    TSS_NAME_CACHE *entry;
+
+    /* FNV-1a of the marshaled public area, a fast filter before the byte compare */
+    for (i = 0 ; i < written ; i++) {
+	key = (key ^ buffer[i]) * 16777619U;
+    }
+    for (i = 0 ; (i < TSS_NAME_CACHE_SIZE) && !found ; i++) {
+	entry = &tssContext->nameCache[i];
+	if ((entry->publicSize == written) &&
+	    (entry->key == key) &&
+	    (entry->nameAlg == nameAlg) &&
+	    (memcmp(entry->publicArea, buffer, written) == 0)) {
+	    found = TRUE;
+	    *name = entry->name;
+	}
+    }
+    if (found) {
+	tssContext->nameCacheHits++;
+	if (tssVverbose) printf("TSS_Name_Calculate: cache hit\n");
+    }
+    /* not in the cache, hash the public area */
+    else {
+	tssContext->nameCacheMisses++;
+	if (rc == 0) {
+	    sizeInBytes = TSS_GetDigestSize(nameAlg);
+	    digest.hashAlg = nameAlg;	/* Name digest algorithm */
+	    /* generate the TPMT_HA */
+	    rc = TSS_Hash_Generate(&digest,	
+				   written, buffer,
+				   0, NULL);
+	}
+	if (rc == 0) {
+	    /* copy the digest */
+	    memcpy(name->t.name + sizeof(TPMI_ALG_HASH), (uint8_t *)&digest.digest, sizeInBytes);
+	    /* copy the hash algorithm */
+	    TPMI_ALG_HASH nameAlgNbo = htons(nameAlg);
+	    memcpy(name->t.name, (uint8_t *)&nameAlgNbo, sizeof(TPMI_ALG_HASH));
+	    /* set the size */
+	    name->t.size = sizeInBytes + sizeof(TPMI_ALG_HASH);
+	}
+	/* replace the oldest entry */
+	if ((rc == 0) && (written <= sizeof(entry->publicArea))) {
+	    entry = &tssContext->nameCache[tssContext->nameCacheNext];
+	    tssContext->nameCacheNext = (tssContext->nameCacheNext + 1) % TSS_NAME_CACHE_SIZE;
+	    entry->key = key;
+	    entry->nameAlg = nameAlg;
+	    entry->publicSize = written;
+	    memcpy(entry->publicArea, buffer, written);
+	    entry->name = *name;
+	}
+    }
+    return rc;
+}
+
 #endif
 
 #ifndef TPM_TSS_NOCRYPTO
 
-static TPM_RC TSS_HmacSession_SetNonceCaller(struct TSS_HMAC_CONTEXT *session,
+static TPM_RC TSS_HmacSession_SetNonceCaller(TSS_CONTEXT *tssContext,
+					     struct TSS_HMAC_CONTEXT *session,
 					     TPMS_AUTH_COMMAND 	*authC)
 {
     TPM_RC		rc = 0;
@@ -2444,7 +3167,7 @@ static TPM_RC TSS_HmacSession_SetNonceCaller(struct TSS_HMAC_CONTEXT *session,
     /* generate a new nonceCaller */
     if (rc == 0) {
 	session->nonceCaller.b.size = session->sizeInBytes;
-	rc = TSS_RandBytes(session->nonceCaller.t.buffer,session->sizeInBytes);
+	rc = TSS_Replay_Nonce(tssContext, session->nonceCaller.t.buffer, session->sizeInBytes);
     }
     /* nonceCaller for the command */
     if (rc == 0) {
@@ -2650,14 +3373,26 @@ static TPM_RC TSS_HmacSession_SetHMAC(TSS_AUTH_CONTEXT *tssAuthContext,	/* autho
 {
     TPM_RC		rc = 0;
     unsigned int	i = 0;
-    TPMT_HA 		cpHash;
 #ifndef TPM_TSS_NOCRYPTO
+    TPMT_HA 		cpHash[MAX_SESSION_NUM];	/* one per distinct session hash algorithm */
+    size_t		cpHashCount = 0;
+    TPMT_HA 		*sessionCpHash;
     TPMT_HA 		hmac;
     TPM2B_NONCE	nonceTPMDecrypt;
     TPM2B_NONCE	nonceTPMEncrypt;
-#endif	/* TPM_TSS_NOCRYPTO */
 
-    cpHash.hashAlg = TPM_ALG_NULL;	/* for cpHash calculation optimization */
+    /* calculate cpHash once for each distinct session hash algorithm, in one pass over the
+       command parameters.  Mixed algorithms, e.g., a SHA-1 policy session with a SHA-256 HMAC
+       session, do not hash the command again. */
+    for (i = 0 ; (i < MAX_SESSION_NUM) && (sessionHandle[i] != TPM_RH_NULL) ; i++) {
+	if ((sessionHandle[i] != TPM_RS_PW) && TSS_HmacSession_IsHmacNeeded(session[i])) {
+	    TSS_HashList_Add(cpHash, &cpHashCount, session[i]->authHashAlg);
+	}
+    }
+    if (cpHashCount > 0) {
+	rc = TSS_CpHash_Calculate(tssAuthContext, cpHash, cpHashCount, name0, name1, name2);
+    }
+#endif	/* TPM_TSS_NOCRYPTO */
 
     for (i = 0 ; (rc == 0) && (i < MAX_SESSION_NUM) && (sessionHandle[i] != TPM_RH_NULL) ; i++) {
 	uint8_t sessionAttr8;
@@ -2681,48 +3416,12 @@ static TPM_RC TSS_HmacSession_SetHMAC(TSS_AUTH_CONTEXT *tssAuthContext,	/* autho
 	/* policy session with policy password handled below, no hmac.  isPasswordNeeded is never
 	   true for an HMAC session, so don't need to test session type here. */
 	if (!(session[i]->isPasswordNeeded)) {
-	    /* HMAC session */ 
-	    if ((session[i]->sessionType == TPM_SE_HMAC) ||
-		/* policy session with TPM2_PolicyAuthValue */
-		((session[i]->sessionType == TPM_SE_POLICY) && (session[i]->isAuthValueNeeded)) ||
-		/* salted session */
-		(session[i]->hmacKey.t.size != 0)
-		) {
+	    if (TSS_HmacSession_IsHmacNeeded(session[i])) {
 		/* needs HMAC */
 #ifndef TPM_TSS_NOCRYPTO
 		if (tssVverbose) printf("TSS_HmacSession_SetHMAC: calculate HMAC\n");
-		/* calculate cpHash.  Performance optimization: If there is more than one session,
-		   and the hash algorithm is the same, use the previously calculated version. */
-		if ((rc == 0) && (cpHash.hashAlg != session[i]->authHashAlg)) {
-		    uint32_t cpBufferSize;
-		    uint8_t *cpBuffer;
-		    TPM_CC commandCode;
-		    TPM_CC commandCodeNbo;
-	
-		    rc = TSS_GetCpBuffer(tssAuthContext,
-					 &cpBufferSize,
-					 &cpBuffer);
-		    if (tssVverbose) TSS_PrintAll("TSS_HmacSession_SetHMAC: cpBuffer",
-						  cpBuffer, cpBufferSize);
-		    cpHash.hashAlg = session[i]->authHashAlg;
-    
-		    /* cpHash = hash(commandCode [ || authName1		*/
-		    /*                           [ || authName2		*/
-		    /*                           [ || authName3 ]]]	*/
-		    /*                           [ || parameters])	*/
-		    /* A cpHash can contain just a commandCode only if the lone session is */
-		    /* an audit session. */
-
-		    commandCode = TSS_GetCommandCode(tssAuthContext);
-		    commandCodeNbo = htonl(commandCode);
-		    rc = TSS_Hash_Generate(&cpHash,		/* largest size of a digest */
-					   sizeof(TPM_CC), &commandCodeNbo,
-					   name0->b.size, &name0->b.buffer,
-					   name1->b.size, &name1->b.buffer,
-					   name2->b.size, &name2->b.buffer,
-					   cpBufferSize, cpBuffer,
-					   0, NULL);
-		}
+		/* cpHash for the session hash algorithm, calculated above */
+		sessionCpHash = TSS_HashList_Find(cpHash, cpHashCount, session[i]->authHashAlg);
 		if (i == 0) {
 		    unsigned int 	isDecrypt = 0;	/* count number of sessions with decrypt
 							   set */
@@ -2773,7 +3472,8 @@ static TPM_RC TSS_HmacSession_SetHMAC(TSS_AUTH_CONTEXT *tssAuthContext,	/* autho
 		    hmac.hashAlg = session[i]->authHashAlg;
 		    rc = TSS_HMAC_Generate(&hmac,				/* output hmac */
 					   &session[i]->hmacKey,		/* input key */
-					   session[i]->sizeInBytes, (uint8_t *)&cpHash.digest,
+					   session[i]->sizeInBytes,
+					   (uint8_t *)&sessionCpHash->digest,
 					   /* new is nonceCaller */
 					   session[i]->nonceCaller.b.size,
 					   &session[i]->nonceCaller.b.buffer,
@@ -2791,7 +3491,7 @@ static TPM_RC TSS_HmacSession_SetHMAC(TSS_AUTH_CONTEXT *tssAuthContext,	/* autho
 			TSS_PrintAll("TSS_HmacSession_SetHMAC: HMAC key",
 				     session[i]->hmacKey.t.buffer, session[i]->hmacKey.t.size);
 			TSS_PrintAll("TSS_HmacSession_SetHMAC: cpHash",
-				     (uint8_t *)&cpHash.digest, session[i]->sizeInBytes);
+				     (uint8_t *)&sessionCpHash->digest, session[i]->sizeInBytes);
 			TSS_PrintAll("TSS_HmacSession_Set: nonceCaller",
 				     session[i]->nonceCaller.b.buffer,
 				     session[i]->nonceCaller.b.size);
@@ -2813,6 +3513,10 @@ static TPM_RC TSS_HmacSession_SetHMAC(TSS_AUTH_CONTEXT *tssAuthContext,	/* autho
 					  (uint8_t *)&hmac.digest,
 					  session[i]->sizeInBytes, sizeof(TPMU_HA));
 		}
+		/* save cpHash for the session audit digest */
+		if (rc == 0) {
+		    session[i]->cpHash = *sessionCpHash;
+		}
 #else
 		tssAuthContext = tssAuthContext;
 		name0 = name0;
@@ -2843,41 +3547,22 @@ static TPM_RC TSS_HmacSession_SetHMAC(TSS_AUTH_CONTEXT *tssAuthContext,	/* autho
 #ifndef TPM_TSS_NOCRYPTO
 
 /* TSS_HmacSession_Verify() is used for a response.  It uses the values in TPMS_AUTH_RESPONSE to
-   validate the response HMAC
+   validate the response HMAC.
+
+   rpHash is calculated once per hash algorithm by TSS_RpHash_Calculate().
 */
 
-static TPM_RC TSS_HmacSession_Verify(TSS_AUTH_CONTEXT *tssAuthContext,	/* authorization context */
-				     struct TSS_HMAC_CONTEXT *session,	/* TSS session context */
+static TPM_RC TSS_HmacSession_Verify(struct TSS_HMAC_CONTEXT *session,	/* TSS session context */
+				     const TPMT_HA *rpHash,		/* rpHash for the session
+									   algorithm */
 				     TPMS_AUTH_RESPONSE *authResponse)	/* input: response authorization */
 {
     TPM_RC		rc = 0;
-    uint32_t		rpBufferSize;
-    uint8_t 		*rpBuffer;
-    TPMT_HA 		rpHash;
     TPMT_HA 		actualHmac;
 
-    /* get the rpBuffer */
+    /* save rpHash for the session audit digest */
     if (rc == 0) {
-	rc = TSS_GetRpBuffer(tssAuthContext, &rpBufferSize, &rpBuffer);
-	if (tssVverbose) TSS_PrintAll("TSS_HmacSession_Verify: rpBuffer",
-				      rpBuffer, rpBufferSize);
-    }
-    /* calculate rpHash */
-    if (rc == 0) {
-	TPM_CC commandCode;
-	TPM_CC commandCodeNbo;
-	rpHash.hashAlg = session->authHashAlg;
-	
-	commandCode = TSS_GetCommandCode(tssAuthContext);
-	commandCodeNbo = htonl(commandCode);
-	
-	/* rpHash = HsessionAlg (responseCode || commandCode {|| parameters })	 */
-	rc = TSS_Hash_Generate(&rpHash,			/* largest size of a digest */
-			       sizeof(TPM_RC), &rc,	/* RC is always 0, no need to endian
-							   convert */
-			       sizeof(TPM_CC), &commandCodeNbo,
-			       rpBufferSize, rpBuffer,
-			       0, NULL);
+	session->rpHash = *rpHash;
     }
     /* construct the actual HMAC as TPMT_HA */
     if (rc == 0) {
@@ -2899,7 +3584,7 @@ static TPM_RC TSS_HmacSession_Verify(TSS_AUTH_CONTEXT *tssAuthContext,	/* author
 	    TSS_PrintAll("TSS_HmacSession_Verify: HMAC key",
 			 session->hmacKey.t.buffer, session->hmacKey.t.size);
 	    TSS_PrintAll("TSS_HmacSession_Verify: rpHash",
-			 (uint8_t *)&rpHash.digest, session->sizeInBytes);
+			 (uint8_t *)&rpHash->digest, session->sizeInBytes);
 	    TSS_PrintAll("TSS_HmacSession_Verify: nonceTPM",
 			 session->nonceTPM.b.buffer, session->nonceTPM.b.size);
 	    TSS_PrintAll("TSS_HmacSession_Verify: nonceCaller",
@@ -2913,7 +3598,7 @@ static TPM_RC TSS_HmacSession_Verify(TSS_AUTH_CONTEXT *tssAuthContext,	/* author
 			     &session->hmacKey,		/* input HMAC key */
 			     session->sizeInBytes,
 			     /* rpHash */
-			     session->sizeInBytes, (uint8_t *)&rpHash.digest,
+			     session->sizeInBytes, (uint8_t *)&rpHash->digest,
 			     /* new is nonceTPM */
 			     session->nonceTPM.b.size, &session->nonceTPM.b.buffer,
 			     /* old is nonceCaller */
@@ -2925,8 +3610,193 @@ static TPM_RC TSS_HmacSession_Verify(TSS_AUTH_CONTEXT *tssAuthContext,	/* author
     return rc;
 }
 
+/* TSS_CpHash_Calculate() calculates the command cpHash for each cpHash[].hashAlg, in one pass over
+   the command parameters.
+
+   cpHash = hash(commandCode [ || authName1
+                             [ || authName2
+                             [ || authName3 ]]]
+                             [ || parameters])
+
+   A cpHash can contain just a commandCode only if the lone session is an audit session.
+
+   Unused names must have size 0.
+*/
+
+static TPM_RC TSS_CpHash_Calculate(TSS_AUTH_CONTEXT *tssAuthContext,
+				   TPMT_HA cpHash[],
+				   size_t count,
+				   TPM2B_NAME *name0,
+				   TPM2B_NAME *name1,
+				   TPM2B_NAME *name2)
+{
+    TPM_RC	rc = 0;
+    uint32_t 	cpBufferSize;
+    uint8_t 	*cpBuffer;
+    TPM_CC 	commandCodeNbo;
+
+    if (rc == 0) {
+	rc = TSS_GetCpBuffer(tssAuthContext,
+			     &cpBufferSize,
+			     &cpBuffer);
+	if (tssVverbose) TSS_PrintAll("TSS_CpHash_Calculate: cpBuffer",
+				      cpBuffer, cpBufferSize);
+    }
+    if (rc == 0) {
+	commandCodeNbo = htonl(TSS_GetCommandCode(tssAuthContext));
+	rc = TSS_Hash_GenerateMulti(cpHash, count,
+				    sizeof(TPM_CC), &commandCodeNbo,
+				    name0->b.size, &name0->b.buffer,
+				    name1->b.size, &name1->b.buffer,
+				    name2->b.size, &name2->b.buffer,
+				    cpBufferSize, cpBuffer,
+				    0, NULL);
+    }
+    return rc;
+}
+
+/* TSS_RpHash_Calculate() calculates the response rpHash for each rpHash[].hashAlg, in one pass over
+   the response parameters.
+
+   rpHash = hash(responseCode || commandCode {|| parameters })
+*/
+
+static TPM_RC TSS_RpHash_Calculate(TSS_AUTH_CONTEXT *tssAuthContext,
+				   TPMT_HA rpHash[],
+				   size_t count)
+{
+    TPM_RC	rc = 0;
+    TPM_RC	responseCode = 0;	/* RC is always 0, no need to endian convert */
+    uint32_t	rpBufferSize;
+    uint8_t 	*rpBuffer;
+    TPM_CC 	commandCodeNbo;
+
+    if (rc == 0) {
+	rc = TSS_GetRpBuffer(tssAuthContext, &rpBufferSize, &rpBuffer);
+	if (tssVverbose) TSS_PrintAll("TSS_RpHash_Calculate: rpBuffer",
+				      rpBuffer, rpBufferSize);
+    }
+    if (rc == 0) {
+	commandCodeNbo = htonl(TSS_GetCommandCode(tssAuthContext));
+	rc = TSS_Hash_GenerateMulti(rpHash, count,
+				    sizeof(TPM_RC), &responseCode,
+				    sizeof(TPM_CC), &commandCodeNbo,
+				    rpBufferSize, rpBuffer,
+				    0, NULL);
+    }
+    return rc;
+}
+
+/* TSS_HashList_Add() adds hashAlg to the list of digests to calculate, if it is not already
+   there.  The list has room for one entry per session. */
+
+static void TSS_HashList_Add(TPMT_HA digests[],
+			     size_t *count,
+			     TPMI_ALG_HASH hashAlg)
+{
+    if (TSS_HashList_Find(digests, *count, hashAlg) == NULL) {
+	digests[*count].hashAlg = hashAlg;
+	(*count)++;
+    }
+    return;
+}
+
+/* TSS_HashList_Find() returns the digest for hashAlg, or NULL if it is not in the list */
+
+static TPMT_HA *TSS_HashList_Find(TPMT_HA digests[],
+				  size_t count,
+				  TPMI_ALG_HASH hashAlg)
+{
+    TPMT_HA	*digest = NULL;
+    size_t	i;
+
+    for (i = 0 ; (digest == NULL) && (i < count) ; i++) {
+	if (digests[i].hashAlg == hashAlg) {
+	    digest = &digests[i];
+	}
+    }
+    return digest;
+}
+
 #endif 	/* TPM_TSS_NOCRYPTO */
 
+/* TSS_HmacSession_IsHmacNeeded() returns TRUE if the command authorization for the session is an
+   HMAC: an HMAC session, a policy session with TPM2_PolicyAuthValue, or a salted session.  A
+   policy session with TPM2_PolicyPassword uses the password instead. */
+
+static int TSS_HmacSession_IsHmacNeeded(struct TSS_HMAC_CONTEXT *session)
+{
+    return !session->isPasswordNeeded &&
+	((session->sessionType == TPM_SE_HMAC) ||
+	 ((session->sessionType == TPM_SE_POLICY) && session->isAuthValueNeeded) ||
+	 (session->hmacKey.t.size != 0));
+}
+
+/* TSS_HmacSession_IsVerifyNeeded() returns TRUE if the response authorization for the session
+   has an HMAC to verify.  For policy sessions with policy password, the response hmac is
+   empty. */
+
+static int TSS_HmacSession_IsVerifyNeeded(struct TSS_HMAC_CONTEXT *session)
+{
+    return (session->sessionType == TPM_SE_HMAC) ||
+	((session->sessionType == TPM_SE_POLICY) && session->isAuthValueNeeded);
+}
+
+/* TSS_HmacSession_Audit() extends the expected session audit digest for a command that used
+   'session' as an audit session.
+
+	auditDigest = H(auditDigest || cpHash || rpHash)
+
+   The digest is all zeros when the session starts and when the command sets auditReset.  If the
+   TSS did not calculate cpHash and rpHash for the command, the TSS no longer tracks the digest.
+*/
+
+static void TSS_HmacSession_Audit(struct TSS_HMAC_CONTEXT *session,
+				  unsigned int sessionAttributes)
+{
+#ifndef TPM_TSS_NOCRYPTO
+    TPM_RC	rc = 0;
+    TPMT_HA	auditDigest;
+
+    if (session->isAuditDigestValid) {
+	if ((session->sessionType != TPM_SE_HMAC) ||
+	    (session->cpHash.hashAlg != session->authHashAlg) ||
+	    (session->rpHash.hashAlg != session->authHashAlg)) {
+	    if (tssVverbose) printf("TSS_HmacSession_Audit: session %08x digest not tracked\n",
+				    session->sessionHandle);
+	    rc = TSS_RC_AUDIT_NOT_EMULATED;
+	}
+	if (rc == 0) {
+	    if (sessionAttributes & TPMA_SESSION_AUDITRESET) {
+		session->auditDigest.t.size = session->sizeInBytes;
+		memset(session->auditDigest.t.buffer, 0, session->sizeInBytes);
+	    }
+	    auditDigest.hashAlg = session->authHashAlg;
+	    rc = TSS_Hash_Generate(&auditDigest,
+				   session->auditDigest.b.size, session->auditDigest.b.buffer,
+				   session->sizeInBytes, (uint8_t *)&session->cpHash.digest,
+				   session->sizeInBytes, (uint8_t *)&session->rpHash.digest,
+				   0, NULL);
+	}
+	if (rc == 0) {
+	    memcpy(session->auditDigest.t.buffer, (uint8_t *)&auditDigest.digest,
+		   session->sizeInBytes);
+	    session->auditDigest.t.size = session->sizeInBytes;
+	    if (tssVverbose) TSS_PrintAll("TSS_HmacSession_Audit: auditDigest",
+					  session->auditDigest.t.buffer,
+					  session->auditDigest.t.size);
+	}
+	else {
+	    session->isAuditDigestValid = FALSE;
+	}
+    }
+#else
+    session = session;
+    sessionAttributes = sessionAttributes;
+#endif	/* TPM_TSS_NOCRYPTO */
+    return;
+}
+
 	/* TSS_HmacSession_Continue() handles the response continueSession flag.  It either saves the
 	   updated session or deletes the session state. */
 
@@ -3606,92 +4476,397 @@ static TPM_RC TSS_CA_HierarchyChangeAuth(TSS_CONTEXT *tssContext,
     }
     else {
 	if (rc == 0) {
-	    rc = TSS_Malloc((uint8_t **)&password , in->newAuth.t.size + 1);
+	    rc = TSS_Malloc((uint8_t **)&password , in->newAuth.t.size + 1);
+	}
+	if (rc == 0) {
+	    /* copy the password */
+	    memcpy(password, in->newAuth.t.buffer, in->newAuth.t.size);
+	    password[in->newAuth.t.size] = '\0';	/* nul terminate string */
+	}
+    }
+#ifndef TPM_TSS_NOCRYPTO
+    if (rc == 0) {
+	rc = TSS_HmacSession_SetHmacKey(tssContext,
+					session,
+					handleNumber,
+					password);
+    }
+#else
+    tssContext = tssContext;
+    session = session;
+    handleNumber = handleNumber;
+#endif	/* TPM_TSS_NOCRYPTO */
+    free(password);
+    return rc;
+}
+
+static TPM_RC TSS_CA_NV_ChangeAuth(TSS_CONTEXT *tssContext,
+				   struct TSS_HMAC_CONTEXT *session,
+				   size_t handleNumber,
+				   NV_ChangeAuth_In *in)
+{
+    TPM_RC 		rc = 0;
+    char		*password = NULL;
+
+    if (tssVverbose) printf("TSS_CA_NV_ChangeAuth\n");
+    if (in->newAuth.t.size == 0) {
+	password = NULL;
+    }
+    else {
+	if (rc == 0) {
+	    rc = TSS_Malloc((uint8_t **)&password , in->newAuth.t.size + 1);
+	}
+	if (rc == 0) {
+	    /* copy the password */
+	    memcpy(password, in->newAuth.t.buffer, in->newAuth.t.size);
+	    password[in->newAuth.t.size] = '\0';	/* nul terminate string */
+	}
+    }
+#ifndef TPM_TSS_NOCRYPTO
+    if (rc == 0) {
+	rc = TSS_HmacSession_SetHmacKey(tssContext,
+					session,
+					handleNumber,
+					password);
+    }
+#else
+    tssContext = tssContext;
+    session = session;
+    handleNumber = handleNumber;
+#endif	/* TPM_TSS_NOCRYPTO */
+    free(password);
+    return rc;
+}
+
+static TPM_RC TSS_CA_NV_UndefineSpaceSpecial(TSS_CONTEXT *tssContext,
+					     struct TSS_HMAC_CONTEXT *session,
+					     size_t handleNumber,
+					     NV_UndefineSpaceSpecial_In *in)
+{
+    TPM_RC 		rc = 0;
+    
+    in = in;
+    if (tssVverbose) printf("TSS_CA_NV_UndefineSpaceSpecial\n");
+#ifndef TPM_TSS_NOCRYPTO
+    if (rc == 0) {
+	/* the nvIndex authorization, the zeroth authorization, has special handling */
+	if (handleNumber == 0) {
+	    /* the Empty Buffer is used as the authValue when generating the response HMAC */
+	    rc = TSS_HmacSession_SetHmacKey(tssContext,
+					    session,
+					    handleNumber,
+					    NULL);		/* password */
+	}
+    }
+#else
+    tssContext = tssContext;
+    session = session;
+    handleNumber = handleNumber;
+#endif	/* TPM_TSS_NOCRYPTO */
+    return rc;
+}
+
+/*
+  Policy session digest
+*/
+
+/* TSS_PolicySession_GetHandle() returns TRUE and the policy session handle if commandCode is a
+   command that changes or reads the policy session digest.
+*/
+
+static int TSS_PolicySession_GetHandle(TPMI_SH_POLICY *policySession,
+				       TPM_CC commandCode,
+				       COMMAND_PARAMETERS *in)
+{
+    int found = TRUE;
+
+    switch (commandCode) {
+      case TPM_CC_PolicySigned:
+	*policySession = in->PolicySigned.policySession;
+	break;
+      case TPM_CC_PolicySecret:
+	*policySession = in->PolicySecret.policySession;
+	break;
+      case TPM_CC_PolicyTicket:
+	*policySession = in->PolicyTicket.policySession;
+	break;
+      case TPM_CC_PolicyOR:
+	*policySession = in->PolicyOR.policySession;
+	break;
+      case TPM_CC_PolicyPCR:
+	*policySession = in->PolicyPCR.policySession;
+	break;
+      case TPM_CC_PolicyLocality:
+	*policySession = in->PolicyLocality.policySession;
+	break;
+      case TPM_CC_PolicyNV:
+	*policySession = in->PolicyNV.policySession;
+	break;
+      case TPM_CC_PolicyAuthorizeNV:
+	*policySession = in->PolicyAuthorizeNV.policySession;
+	break;
+      case TPM_CC_PolicyCounterTimer:
+	*policySession = in->PolicyCounterTimer.policySession;
+	break;
+      case TPM_CC_PolicyCommandCode:
+	*policySession = in->PolicyCommandCode.policySession;
+	break;
+      case TPM_CC_PolicyPhysicalPresence:
+	*policySession = in->PolicyPhysicalPresence.policySession;
+	break;
+      case TPM_CC_PolicyCpHash:
+	*policySession = in->PolicyCpHash.policySession;
+	break;
+      case TPM_CC_PolicyNameHash:
+	*policySession = in->PolicyNameHash.policySession;
+	break;
+      case TPM_CC_PolicyDuplicationSelect:
+	*policySession = in->PolicyDuplicationSelect.policySession;
+	break;
+      case TPM_CC_PolicyAuthorize:
+	*policySession = in->PolicyAuthorize.policySession;
+	break;
+      case TPM_CC_PolicyAuthValue:
+	*policySession = in->PolicyAuthValue.policySession;
+	break;
+      case TPM_CC_PolicyPassword:
+	*policySession = in->PolicyPassword.policySession;
+	break;
+      case TPM_CC_PolicyGetDigest:
+	*policySession = in->PolicyGetDigest.policySession;
+	break;
+      case TPM_CC_PolicyNvWritten:
+	*policySession = in->PolicyNvWritten.policySession;
+	break;
+      case TPM_CC_PolicyTemplate:
+	*policySession = in->PolicyTemplate.policySession;
+	break;
+      case TPM_CC_PolicyRestart:
+	*policySession = in->PolicyRestart.sessionHandle;
+	break;
+      default:
+	found = FALSE;
+    }
+    return found;
+}
+
+/* TSS_PolicySession_IsEmulated() returns TRUE if the session handle is a trial session created by
+   the TSS rather than the TPM */
+
+static int TSS_PolicySession_IsEmulated(TPMI_SH_AUTH_SESSION sessionHandle)
+{
+    return ((sessionHandle & TSS_EMULATED_SESSION_MASK) == TSS_EMULATED_SESSION_FIRST);
+}
+
+#ifndef TPM_TSS_NOCRYPTO
+
+/* TSS_PolicySession_NewHandle() assigns a handle for an emulated trial session that is not already
+   in use by the TSS */
+
+static TPM_RC TSS_PolicySession_NewHandle(TSS_CONTEXT *tssContext,
+					  TPMI_SH_AUTH_SESSION *sessionHandle)
+{
+    TPM_RC	rc = 0;
+    uint16_t	random;
+    size_t	slotIndex;
+    int		inUse = TRUE;
+    unsigned int i;
+
+    for (i = 0 ; (rc == 0) && inUse && (i < 16) ; i++) {
+	rc = TSS_RandBytes((unsigned char *)&random, sizeof(random));
+	if (rc == 0) {
+	    *sessionHandle = TSS_EMULATED_SESSION_FIRST + random;
+	    inUse = (TSS_HmacSession_GetSlotForHandle(tssContext, &slotIndex,
+						      *sessionHandle) == 0);
 	}
-	if (rc == 0) {
-	    /* copy the password */
-	    memcpy(password, in->newAuth.t.buffer, in->newAuth.t.size);
-	    password[in->newAuth.t.size] = '\0';	/* nul terminate string */
+#ifndef TPM_TSS_NOFILE
+	if ((rc == 0) && !inUse) {
+	    char	sessionFilename[128];
+	    FILE	*file;
+	    sprintf(sessionFilename, "%s/h%08x.bin",
+		    tssContext->tssDataDirectory, *sessionHandle);
+	    file = fopen(sessionFilename, "rb");
+	    if (file != NULL) {
+		inUse = TRUE;
+		fclose(file);
+	    }
 	}
+#endif
     }
-#ifndef TPM_TSS_NOCRYPTO
-    if (rc == 0) {
-	rc = TSS_HmacSession_SetHmacKey(tssContext,
-					session,
-					handleNumber,
-					password);
+    if ((rc == 0) && inUse) {
+	if (tssVerbose) printf("TSS_PolicySession_NewHandle: No free emulated session handle\n");
+	rc = TSS_RC_NO_SESSION_SLOT;
     }
-#else
-    tssContext = tssContext;
-    session = session;
-    handleNumber = handleNumber;
-#endif	/* TPM_TSS_NOCRYPTO */
-    free(password);
     return rc;
 }
 
-static TPM_RC TSS_CA_NV_ChangeAuth(TSS_CONTEXT *tssContext,
-				   struct TSS_HMAC_CONTEXT *session,
-				   size_t handleNumber,
-				   NV_ChangeAuth_In *in)
+/* TSS_PolicySession_Extend() extends the policy digest for a policy command.
+
+   Some policy digests cannot be calculated by the TSS.  PolicyPCR with an empty pcrDigest uses the
+   current PCR values.  For an emulated trial session, the TSS uses the values it has read.  For a
+   TPM session, the PCRs may have been extended by another context since, so the digest is not
+   tracked.  PolicySigned, PolicySecret, PolicyNV, and PolicyAuthorizeNV require a Name that the TSS
+   has not seen.
+*/
+
+static TPM_RC TSS_PolicySession_Extend(TSS_CONTEXT *tssContext,
+				       TSS_POLICY *policy,
+				       int emulated,
+				       TPM_CC commandCode,
+				       COMMAND_PARAMETERS *in)
 {
-    TPM_RC 		rc = 0;
-    char		*password = NULL;
+    TPM_RC		rc = 0;
+    TPM2B_NAME		name;
 
-    if (tssVverbose) printf("TSS_CA_NV_ChangeAuth\n");
-    if (in->newAuth.t.size == 0) {
-	password = NULL;
-    }
-    else {
+    switch (commandCode) {
+      case TPM_CC_PolicySigned:
+	rc = TSS_Name_GetName(tssContext, &name, in->PolicySigned.authObject);
 	if (rc == 0) {
-	    rc = TSS_Malloc((uint8_t **)&password , in->newAuth.t.size + 1);
+	    rc = TSS_Policy_Signed(policy, &name, &in->PolicySigned.policyRef);
 	}
+	break;
+      case TPM_CC_PolicySecret:
+	rc = TSS_Name_GetName(tssContext, &name, in->PolicySecret.authHandle);
 	if (rc == 0) {
-	    /* copy the password */
-	    memcpy(password, in->newAuth.t.buffer, in->newAuth.t.size);
-	    password[in->newAuth.t.size] = '\0';	/* nul terminate string */
+	    rc = TSS_Policy_Secret(policy, &name, &in->PolicySecret.policyRef);
 	}
+	break;
+      case TPM_CC_PolicyTicket:
+	if (in->PolicyTicket.ticket.tag == TPM_ST_AUTH_SIGNED) {
+	    rc = TSS_Policy_Signed(policy, &in->PolicyTicket.authName,
+				   &in->PolicyTicket.policyRef);
+	}
+	else {
+	    rc = TSS_Policy_Secret(policy, &in->PolicyTicket.authName,
+				   &in->PolicyTicket.policyRef);
+	}
+	break;
+      case TPM_CC_PolicyOR:
+	rc = TSS_Policy_ORDigests(policy, &in->PolicyOR.pHashList);
+	break;
+      case TPM_CC_PolicyPCR:
+	if (in->PolicyPCR.pcrDigest.t.size != 0) {
+	    rc = TSS_Policy_PCRDigest(policy, &in->PolicyPCR.pcrs, &in->PolicyPCR.pcrDigest);
+	}
+	/* the TPM uses the current PCR values, only emulated if they were read */
+	else if (emulated) {
+	    rc = TSS_Policy_PCRCached(tssContext, policy, &in->PolicyPCR.pcrs);
+	}
+	else {
+	    rc = TSS_RC_POLICY_NOT_EMULATED;
+	}
+	break;
+      case TPM_CC_PolicyLocality:
+	rc = TSS_Policy_Locality(policy, in->PolicyLocality.locality);
+	break;
+      case TPM_CC_PolicyNV:
+	rc = TSS_Name_GetName(tssContext, &name, in->PolicyNV.nvIndex);
+	if (rc == 0) {
+	    rc = TSS_Policy_NV(policy, &name, &in->PolicyNV.operandB,
+			       in->PolicyNV.offset, in->PolicyNV.operation);
+	}
+	break;
+      case TPM_CC_PolicyAuthorizeNV:
+	rc = TSS_Name_GetName(tssContext, &name, in->PolicyAuthorizeNV.nvIndex);
+	if (rc == 0) {
+	    rc = TSS_Policy_AuthorizeNV(policy, &name);
+	}
+	break;
+      case TPM_CC_PolicyCounterTimer:
+	rc = TSS_Policy_CounterTimer(policy, &in->PolicyCounterTimer.operandB,
+				     in->PolicyCounterTimer.offset,
+				     in->PolicyCounterTimer.operation);
+	break;
+      case TPM_CC_PolicyCommandCode:
+	rc = TSS_Policy_CommandCode(policy, in->PolicyCommandCode.code);
+	break;
+      case TPM_CC_PolicyPhysicalPresence:
+	rc = TSS_Policy_PhysicalPresence(policy);
+	break;
+      case TPM_CC_PolicyCpHash:
+	rc = TSS_Policy_CpHash(policy, &in->PolicyCpHash.cpHashA);
+	break;
+      case TPM_CC_PolicyNameHash:
+	rc = TSS_Policy_NameHash(policy, &in->PolicyNameHash.nameHash);
+	break;
+      case TPM_CC_PolicyDuplicationSelect:
+	rc = TSS_Policy_DuplicationSelect(policy,
+					  &in->PolicyDuplicationSelect.objectName,
+					  &in->PolicyDuplicationSelect.newParentName,
+					  in->PolicyDuplicationSelect.includeObject);
+	break;
+      case TPM_CC_PolicyAuthorize:
+	rc = TSS_Policy_Authorize(policy, &in->PolicyAuthorize.keySign,
+				  &in->PolicyAuthorize.policyRef);
+	break;
+      case TPM_CC_PolicyAuthValue:
+	rc = TSS_Policy_AuthValue(policy);
+	break;
+      case TPM_CC_PolicyPassword:
+	rc = TSS_Policy_Password(policy);
+	break;
+      case TPM_CC_PolicyNvWritten:
+	rc = TSS_Policy_NvWritten(policy, in->PolicyNvWritten.writtenSet);
+	break;
+      case TPM_CC_PolicyTemplate:
+	rc = TSS_Policy_TemplateHash(policy, &in->PolicyTemplate.templateHash);
+	break;
+      case TPM_CC_PolicyRestart:
+	TSS_Policy_Reset(policy);
+	break;
     }
-#ifndef TPM_TSS_NOCRYPTO
-    if (rc == 0) {
-	rc = TSS_HmacSession_SetHmacKey(tssContext,
-					session,
-					handleNumber,
-					password);
-    }
-#else
-    tssContext = tssContext;
-    session = session;
-    handleNumber = handleNumber;
-#endif	/* TPM_TSS_NOCRYPTO */
-    free(password);
     return rc;
 }
 
-static TPM_RC TSS_CA_NV_UndefineSpaceSpecial(TSS_CONTEXT *tssContext,
-					     struct TSS_HMAC_CONTEXT *session,
-					     size_t handleNumber,
-					     NV_UndefineSpaceSpecial_In *in)
+#endif	/* TPM_TSS_NOCRYPTO */
+
+/* TSS_PolicySession_Update() updates the expected policy digest of the session for a policy command
+   that the TPM has executed, or that the TSS emulates.
+
+   If the digest cannot be calculated for a TPM session, it is marked as not tracked, and
+   TSS_GetPolicyDigest() returns an error.  For an emulated trial session, this is an error.
+*/
+
+static TPM_RC TSS_PolicySession_Update(TSS_CONTEXT *tssContext,
+				       struct TSS_HMAC_CONTEXT *session,
+				       TPM_CC commandCode,
+				       COMMAND_PARAMETERS *in)
 {
-    TPM_RC 		rc = 0;
-    
-    in = in;
-    if (tssVverbose) printf("TSS_CA_NV_UndefineSpaceSpecial\n");
+    TPM_RC		rc = 0;
 #ifndef TPM_TSS_NOCRYPTO
-    if (rc == 0) {
-	/* the nvIndex authorization, the zeroth authorization, has special handling */
-	if (handleNumber == 0) {
-	    /* the Empty Buffer is used as the authValue when generating the response HMAC */
-	    rc = TSS_HmacSession_SetHmacKey(tssContext,
-					    session,
-					    handleNumber,
-					    NULL);		/* password */
+    TSS_POLICY		policy;
+
+    /* nothing to do for an HMAC session, or a digest that is already not tracked */
+    if (session->isPolicyDigestValid) {
+	policy.count = 1;
+	policy.digest[0].hashAlg = session->authHashAlg;
+	memcpy((uint8_t *)&policy.digest[0].digest,
+	       session->policyDigest.t.buffer, session->policyDigest.t.size);
+	rc = TSS_PolicySession_Extend(tssContext, &policy,
+				      TSS_PolicySession_IsEmulated(session->sessionHandle),
+				      commandCode, in);
+	if (rc == 0) {
+	    memcpy(session->policyDigest.t.buffer,
+		   (uint8_t *)&policy.digest[0].digest, session->policyDigest.t.size);
+	}
+	/* a TPM session still works, the TSS just can't return its digest in TSS_GetPolicyDigest() */
+	else if (!TSS_PolicySession_IsEmulated(session->sessionHandle)) {
+	    if (tssVverbose) printf("TSS_PolicySession_Update: session %08x digest not tracked\n",
+				    session->sessionHandle);
+	    session->isPolicyDigestValid = FALSE;
+	    rc = 0;
+	}
+	else {
+	    if (tssVerbose) printf("TSS_PolicySession_Update: "
+				   "Cannot emulate command %08x for session %08x\n",
+				   commandCode, session->sessionHandle);
 	}
     }
 #else
     tssContext = tssContext;
     session = session;
-    handleNumber = handleNumber;
+    commandCode = commandCode;
+    in = in;
 #endif	/* TPM_TSS_NOCRYPTO */
     return rc;
 }
@@ -3769,7 +4944,8 @@ static TPM_RC TSS_PR_StartAuthSession(TSS_CONTEXT *tssContext,
 	}
     }
     if (rc == 0) {
-	rc = TSS_RandBytes((unsigned char *)&in->nonceCaller.t.buffer, in->nonceCaller.t.size);
+	rc = TSS_Replay_Nonce(tssContext, (unsigned char *)&in->nonceCaller.t.buffer,
+			      in->nonceCaller.t.size);
     }
 #else
     in->nonceCaller.t.size = 16;
@@ -3803,7 +4979,8 @@ static TPM_RC TSS_PR_StartAuthSession(TSS_CONTEXT *tssContext,
 			      &bPublic.publicArea);
 	} 
 	else if (bPublic.publicArea.type == TPM_ALG_RSA) {
-	    rc = TSS_RSA_Salt(&extra->salt,
+	    rc = TSS_RSA_Salt(tssContext,
+			      &extra->salt,
 			      &in->encryptedSalt,
 			      &bPublic.publicArea);
 	} 
@@ -3825,7 +5002,8 @@ static TPM_RC TSS_PR_StartAuthSession(TSS_CONTEXT *tssContext,
 
 /* TSS_RSA_Salt() returns both the plaintext and excrypted salt, based on the salt key bPublic. */
 
-static TPM_RC TSS_RSA_Salt(TPM2B_DIGEST 		*salt,
+static TPM_RC TSS_RSA_Salt(TSS_CONTEXT *tssContext,
+			   TPM2B_DIGEST 		*salt,
 			   TPM2B_ENCRYPTED_SECRET	*encryptedSalt,
 			   TPMT_PUBLIC			*publicArea)
 {
@@ -3862,7 +5040,7 @@ static TPM_RC TSS_RSA_Salt(TPM2B_DIGEST 		*salt,
 				"Hash algorithm %04x Salt size %u\n",
 				publicArea->nameAlg, salt->t.size);
 	/* place the salt in extra so that it can be retrieved by post processor */
-	rc = TSS_RandBytes((uint8_t *)&salt->t.buffer, salt->t.size);
+	rc = TSS_Replay_Salt(tssContext, (uint8_t *)&salt->t.buffer, salt->t.size);
     }
     /* In TPM2_StartAuthSession(), when tpmKey is an RSA key, the secret value (salt) is
        encrypted using OAEP as described in B.4. The string "SECRET" (see 4.5) is used as
@@ -3937,41 +5115,69 @@ static TPM_RC TSS_Response_PostProcessor(TSS_CONTEXT *tssContext,
 					 EXTRA_PARAMETERS *extra)
 {
     TPM_RC 			rc = 0;
-    size_t 			index;
-    int 			found;
     TSS_PostProcessFunction_t 	postProcessFunction = NULL;
 
     /* search the table for a post processing function */
     if (rc == 0) {
 	TPM_CC commandCode = TSS_GetCommandCode(tssContext->tssAuthContext);
-	found = FALSE;
-	for (index = 0 ; (index < (sizeof(tssTable) / sizeof(TSS_TABLE))) && !found ; index++) {
-	    if (tssTable[index].commandCode == commandCode) {
-		found = TRUE;
-		break;	/* don't increment index if found */
-	    }
-	}
-    }
-    /* found false means there is no post processing function.  This permits the table to be smaller
-       if desired. */
-    if ((rc == 0) && found) {
-	postProcessFunction = tssTable[index].postProcessFunction;
-	/* there could also be an entry that it currently NULL, nothing to do */
-	if (postProcessFunction == NULL) {
-	    found = FALSE;
-	}
+	postProcessFunction = TSS_GetPostProcessFunction(commandCode);
     }
     /* call the function */
-    if ((rc == 0) && found) {
+    if ((rc == 0) && (postProcessFunction != NULL)) {
 	rc = postProcessFunction(tssContext, in, out, extra);
     }
     return rc;
 }
 
+/* TSS_GetPostProcessFunction() returns the command's post processing function, or NULL if there
+   is none */
+
+static TSS_PostProcessFunction_t TSS_GetPostProcessFunction(TPM_CC commandCode)
+{
+    size_t 			index;
+    int 			found;
+    TSS_PostProcessFunction_t 	postProcessFunction = NULL;
+
+    found = FALSE;
+    for (index = 0 ; (index < (sizeof(tssTable) / sizeof(TSS_TABLE))) && !found ; index++) {
+	if (tssTable[index].commandCode == commandCode) {
+	    found = TRUE;
+	    break;	/* don't increment index if found */
+	}
+    }
+    /* found false means there is no post processing function.  This permits the table to be smaller
+       if desired.  There could also be an entry that is NULL. */
+    if (found) {
+	postProcessFunction = tssTable[index].postProcessFunction;
+    }
+    return postProcessFunction;
+}
+
 /*
   Command specific post processing functions
 */
 
+/* TSS_PO_Startup() discards the cached TPM capabilities, since the PCR allocation and algorithm set
+   can change at TPM reset */
+
+static TPM_RC TSS_PO_Startup(TSS_CONTEXT *tssContext,
+			     Startup_In *in,
+			     void *out,
+			     void *extra)
+{
+    TPM_RC 			rc = 0;
+
+    in = in;
+    out = out;
+    extra = extra;
+    if (tssVverbose) printf("TSS_PO_Startup\n");
+    TSS_Capability_Invalidate(tssContext);
+#ifndef TPM_TSS_NOCRYPTO
+    TSS_PcrCache_Invalidate(tssContext, 0xffffffff);
+#endif
+    return rc;
+}
+
 /* TSS_PO_StartAuthSession handles StartAuthSession post processing.  It:
 
    creates a TSS HMAC session
@@ -4006,6 +5212,22 @@ static TPM_RC TSS_PO_StartAuthSession(TSS_CONTEXT *tssContext,
 	session->symmetric = in->symmetric;
 	session->sessionType = in->sessionType;
     }
+#ifndef TPM_TSS_NOCRYPTO
+    /* a new policy session digest is all zeros */
+    if (rc == 0) {
+	if (session->sessionType != TPM_SE_HMAC) {
+	    session->policyDigest.t.size = session->sizeInBytes;
+	    memset(session->policyDigest.t.buffer, 0, session->sizeInBytes);
+	    session->isPolicyDigestValid = TRUE;
+	}
+	/* a new HMAC session audit digest is all zeros */
+	else {
+	    session->auditDigest.t.size = session->sizeInBytes;
+	    memset(session->auditDigest.t.buffer, 0, session->sizeInBytes);
+	    session->isAuditDigestValid = TRUE;
+	}
+    }
+#endif	/* TPM_TSS_NOCRYPTO */
     /* if not a bind session or if no bind password was supplied */
     if (rc == 0) {
 	if ((extra == NULL) || (in->bind == TPM_RH_NULL) || (extra->bindPassword == NULL)) {
@@ -4313,7 +5535,7 @@ static TPM_RC TSS_PO_ReadPublic(TSS_CONTEXT *tssContext,
     {
 	TPM2B_NAME name;
 	if (rc == 0) {
-	    rc = TSS_ObjectPublic_GetName(&name, &out->outPublic.publicArea);
+	    rc = TSS_ObjectPublic_GetName(tssContext, &name, &out->outPublic.publicArea);
 	}
 	if (rc == 0) {
 	    if (name.t.size != out->name.t.size) {
@@ -4460,6 +5682,10 @@ static TPM_RC TSS_PO_PolicyAuthValue(TSS_CONTEXT *tssContext,
     if (rc == 0) {
 	session.isPasswordNeeded = FALSE;
 	session.isAuthValueNeeded = TRUE;
+	rc = TSS_PolicySession_Update(tssContext, &session, TPM_CC_PolicyAuthValue,
+				      (COMMAND_PARAMETERS *)in);
+    }
+    if (rc == 0) {
 	rc = TSS_HmacSession_SaveSession(tssContext, &session);
     }
     return rc;
@@ -4482,6 +5708,92 @@ static TPM_RC TSS_PO_PolicyPassword(TSS_CONTEXT *tssContext,
     if (rc == 0) {
 	session.isPasswordNeeded = TRUE;
 	session.isAuthValueNeeded = FALSE;
+	rc = TSS_PolicySession_Update(tssContext, &session, TPM_CC_PolicyPassword,
+				      (COMMAND_PARAMETERS *)in);
+    }
+    if (rc == 0) {
+	rc = TSS_HmacSession_SaveSession(tssContext, &session);
+    }
+    return rc;
+}
+
+/* TSS_PO_PCR_Read() saves the PCR values in the TSS context PCR cache, see
+   TSS_PcrCache_GetDigest() */
+
+static TPM_RC TSS_PO_PCR_Read(TSS_CONTEXT *tssContext,
+			      PCR_Read_In *in,
+			      PCR_Read_Out *out,
+			      void *extra)
+{
+    TPM_RC 	rc = 0;
+
+    in = in;
+    extra = extra;
+    if (tssVverbose) printf("TSS_PO_PCR_Read\n");
+#ifndef TPM_TSS_NOCRYPTO
+    if (rc == 0) {
+	rc = TSS_PcrCache_Read(tssContext, &out->pcrSelectionOut, &out->pcrValues);
+    }
+#else
+    tssContext = tssContext;
+    out = out;
+#endif
+    return rc;
+}
+
+/* TSS_PO_PCR_Extend() discards the cached values of the PCR.  It is used for PCR_Extend,
+   PCR_Event, and PCR_Reset, which all start with pcrHandle. */
+
+static TPM_RC TSS_PO_PCR_Extend(TSS_CONTEXT *tssContext,
+				PCR_Extend_In *in,
+				void *out,
+				void *extra)
+{
+    TPM_RC 	rc = 0;
+
+    out = out;
+    extra = extra;
+    if (tssVverbose) printf("TSS_PO_PCR_Extend: pcrHandle %08x\n", in->pcrHandle);
+#ifndef TPM_TSS_NOCRYPTO
+    /* TPM_RH_NULL does not change a PCR */
+    if (in->pcrHandle < IMPLEMENTATION_PCR) {
+	TSS_PcrCache_Invalidate(tssContext, 1U << in->pcrHandle);
+    }
+#else
+    tssContext = tssContext;
+#endif
+    return rc;
+}
+
+/* TSS_PO_PolicyDigest() updates the policy digest that the TSS tracks for the policy session */
+
+static TPM_RC TSS_PO_PolicyDigest(TSS_CONTEXT *tssContext,
+				  COMMAND_PARAMETERS *in,
+				  void *out,
+				  void *extra)
+{
+    TPM_RC 			rc = 0;
+    struct TSS_HMAC_CONTEXT 	session;
+    TPM_CC			commandCode = TSS_GetCommandCode(tssContext->tssAuthContext);
+    TPMI_SH_POLICY		policySession;
+    int				loaded = FALSE;
+
+    out = out;
+    extra = extra;
+    if (tssVverbose) printf("TSS_PO_PolicyDigest: command %08x\n", commandCode);
+    if (rc == 0) {
+	TSS_PolicySession_GetHandle(&policySession, commandCode, in);
+	rc = TSS_HmacSession_LoadSession(tssContext, &session, policySession);
+	loaded = (rc == 0);
+	/* the TPM executed the command, the TSS just cannot track the digest */
+	if (!loaded && !TSS_PolicySession_IsEmulated(policySession)) {
+	    rc = 0;
+	}
+    }
+    if ((rc == 0) && loaded) {
+	rc = TSS_PolicySession_Update(tssContext, &session, commandCode, in);
+    }
+    if ((rc == 0) && loaded) {
 	rc = TSS_HmacSession_SaveSession(tssContext, &session);
     }
     return rc;
@@ -4527,7 +5839,7 @@ static TPM_RC TSS_PO_NV_DefineSpace(TSS_CONTEXT *tssContext,
 	*/
 	/* calculate the Name from the input TPMS_NV_PUBLIC */
 	if (rc == 0) {
-	    rc = TSS_NVPublic_GetName(&name, &in->publicInfo.nvPublic);
+	    rc = TSS_NVPublic_GetName(tssContext, &name, &in->publicInfo.nvPublic);
 	}
 	/* use handle as file name */
 	if (rc == 0) {
@@ -4569,7 +5881,7 @@ static TPM_RC TSS_PO_NV_ReadPublic(TSS_CONTEXT *tssContext,
 	TPM2B_NAME name;
 	/* calculate the Name from the TPMS_NV_PUBLIC */
 	if (rc == 0) {
-	    rc = TSS_NVPublic_GetName(&name, &out->nvPublic.nvPublic);
+	    rc = TSS_NVPublic_GetName(tssContext, &name, &out->nvPublic.nvPublic);
 	}
 	if (rc == 0) {
 	    if (name.t.size != out->nvName.t.size) {
@@ -4671,7 +5983,7 @@ static TPM_RC TSS_PO_NV_Write(TSS_CONTEXT *tssContext,
 	    }
 	    /* calculate the name */
 	    if (rc == 0) {
-		rc = TSS_NVPublic_GetName(&name, &nvPublic);
+		rc = TSS_NVPublic_GetName(tssContext, &name, &nvPublic);
 	    }
 	    /* save the name */
 	    if (rc == 0) {
@@ -4723,7 +6035,7 @@ static TPM_RC TSS_PO_NV_WriteLock(TSS_CONTEXT *tssContext,
 	    }
 	    /* calculate the name */
 	    if (rc == 0) {
-		rc = TSS_NVPublic_GetName(&name, &nvPublic);
+		rc = TSS_NVPublic_GetName(tssContext, &name, &nvPublic);
 	    }
 	    /* save the name */
 	    if (rc == 0) {
@@ -4775,7 +6087,7 @@ static TPM_RC TSS_PO_NV_ReadLock(TSS_CONTEXT *tssContext,
 	    }
 	    /* calculate the name */
 	    if (rc == 0) {
-		rc = TSS_NVPublic_GetName(&name, &nvPublic);
+		rc = TSS_NVPublic_GetName(tssContext, &name, &nvPublic);
 	    }
 	    /* save the name */
 	    if (rc == 0) {
@@ -4797,3 +6109,66 @@ static TPM_RC TSS_PO_NV_ReadLock(TSS_CONTEXT *tssContext,
     extra = extra;
     return rc;
 }
+
+/* TSS_PO_ChangePPS() discards the cached platform hierarchy primary keys */
+
+static TPM_RC TSS_PO_ChangePPS(TSS_CONTEXT *tssContext,
+			       ChangePPS_In *in,
+			       void *out,
+			       void *extra)
+{
+    TPM_RC 			rc = 0;
+
+    in = in;
+    out = out;
+    extra = extra;
+    if (tssVverbose) printf("TSS_PO_ChangePPS\n");
+    if (rc == 0) {
+	rc = TSS_PrimaryCache_Invalidate(tssContext, TPM_RH_PLATFORM);
+    }
+    return rc;
+}
+
+/* TSS_PO_ChangeEPS() discards the cached endorsement hierarchy primary keys */
+
+static TPM_RC TSS_PO_ChangeEPS(TSS_CONTEXT *tssContext,
+			       ChangeEPS_In *in,
+			       void *out,
+			       void *extra)
+{
+    TPM_RC 			rc = 0;
+
+    in = in;
+    out = out;
+    extra = extra;
+    if (tssVverbose) printf("TSS_PO_ChangeEPS\n");
+    if (rc == 0) {
+	rc = TSS_PrimaryCache_Invalidate(tssContext, TPM_RH_ENDORSEMENT);
+    }
+    return rc;
+}
+
+/* TSS_PO_Clear() discards the cached TPM capabilities.  It discards the cached storage and
+   endorsement hierarchy primary keys, since the clear changes the storage primary seed and the
+   proofs that protect their saved contexts. */
+
+static TPM_RC TSS_PO_Clear(TSS_CONTEXT *tssContext,
+			   Clear_In *in,
+			   void *out,
+			   void *extra)
+{
+    TPM_RC 			rc = 0;
+
+    in = in;
+    out = out;
+    extra = extra;
+    if (tssVverbose) printf("TSS_PO_Clear\n");
+    TSS_Capability_Invalidate(tssContext);
+    if (rc == 0) {
+	rc = TSS_PrimaryCache_Invalidate(tssContext, TPM_RH_OWNER);
+    }
+    if (rc == 0) {
+	rc = TSS_PrimaryCache_Invalidate(tssContext, TPM_RH_ENDORSEMENT);
+    }
+    return rc;
+}
@@ -254,6 +254,7 @@ typedef union {
     PolicyNV_In                   PolicyNV;
     PolicyAuthorizeNV_In          PolicyAuthorizeNV;
     PolicyNameHash_In             PolicyNameHash;
+    PolicyNvWritten_In            PolicyNvWritten;
     PolicyOR_In                   PolicyOR;
     PolicyPCR_In                  PolicyPCR;
     PolicyPassword_In             PolicyPassword;
@@ -261,6 +262,7 @@ typedef union {
     PolicyRestart_In              PolicyRestart;
     PolicySecret_In               PolicySecret;
     PolicySigned_In               PolicySigned;
+    PolicyTemplate_In             PolicyTemplate;
     PolicyTicket_In               PolicyTicket;
     Quote_In                      Quote;
     RSA_Decrypt_In                RSA_Decrypt;
@@ -51,7 +51,20 @@
 #include <tss2/tsserror.h>
 #include <tss2/tssprint.h>
 
+/* Thread safety: A TSS_CONTEXT must be used by one thread at a time.  Threads using separate
+   contexts can marshal, execute, and unmarshal concurrently.  The command and response parameters
+   are the caller's 'in' and 'out' structures, and all other command state is in the context.
+
+   The library globals are the trace level and the first call flag.  The first TSS_Create() or
+   TSS_SetProperty() call sets them, so it should complete before other threads start.  Commands
+   that use the TPM_DATA_DIR files (sessions, names) need a separate directory per thread.
+
+   Contexts that should share one TPM connection, rather than each opening its own, can use a
+   TSS_SCHEDULER, see tssscheduler.h.
+*/
+
 typedef struct TSS_CONTEXT TSS_CONTEXT; 
+typedef struct TSS_SCHEDULER TSS_SCHEDULER;
    
 #define TPM_TRACE_LEVEL		1
 #define TPM_DATA_DIR		2
@@ -62,6 +75,18 @@ typedef struct TSS_CONTEXT TSS_CONTEXT;
 #define TPM_DEVICE		7
 #define TPM_ENCRYPT_SESSIONS	8
 #define TPM_SERVER_TYPE		9
+#define TPM_RETRY_COUNT		10
+#define TPM_RETRY_DELAY		11
+#define TPM_POLICY_EMULATE	12
+#define TPM_LOCALITY		13
+#define TPM_CORPUS_DIR		14
+#define TPM_DEVICE_TIMEOUT	15
+#define TPM_DEVICE_TIMEOUT_LONG	16
+#define TPM_SCHEDULER_PRIORITY	17
+#define TPM_SCHEDULER_DEADLINE	18
+#define TPM_REPLAY_FILE		19
+#define TPM_CONNECT_RETRY_COUNT	20
+#define TPM_CONNECT_RETRY_DELAY	21
 
 #ifdef __cplusplus
 extern "C" {
@@ -78,6 +103,22 @@ extern "C" {
 	StartAuthSession_Extra 	StartAuthSession;
     } EXTRA_PARAMETERS;
 
+    /* TSS_RESPONSE_VIEW is the unparsed remainder of the response parameter area, see
+       TSS_ExecuteView().  buffer and size can be passed directly to the *_Unmarshal functions,
+       which advance the view. */
+
+    typedef struct {
+	uint8_t		*buffer;	/* into the TSS response buffer */
+	int32_t		size;		/* bytes remaining */
+    } TSS_RESPONSE_VIEW;
+
+    /* TSS_TPM2B_VIEW is a TPM2B in the response buffer, not copied */
+
+    typedef struct {
+	const uint8_t	*buffer;
+	uint16_t	size;
+    } TSS_TPM2B_VIEW;
+
     LIB_EXPORT
     TPM_RC TSS_Create(TSS_CONTEXT **tssContext);
 
@@ -91,12 +132,60 @@ extern "C" {
 		       EXTRA_PARAMETERS *extra,
 		       TPM_CC commandCode,
 		       ...);
+    LIB_EXPORT
+    TPM_RC TSS_ExecuteView(TSS_CONTEXT *tssContext,
+			   TSS_RESPONSE_VIEW *view,
+			   COMMAND_PARAMETERS *in,
+			   EXTRA_PARAMETERS *extra,
+			   TPM_CC commandCode,
+			   ...);
+    LIB_EXPORT
+    TPM_RC TSS_ResponseView_TPM2B(TSS_TPM2B_VIEW *target,
+				  uint16_t targetSize,
+				  TSS_RESPONSE_VIEW *view);
 
     LIB_EXPORT
     TPM_RC TSS_SetProperty(TSS_CONTEXT *tssContext,
 			   int property,
 			   const char *value);
 
+    LIB_EXPORT
+    TPM_RC TSS_HoldSessions(TSS_CONTEXT *tssContext,
+			    int hold);
+    LIB_EXPORT
+    TPM_RC TSS_GetNameCacheStatistics(TSS_CONTEXT *tssContext,
+				      uint32_t *hits,
+				      uint32_t *misses);
+    LIB_EXPORT
+    TPM_RC TSS_GetRetryStatistics(TSS_CONTEXT *tssContext,
+				  uint32_t *resends,
+				  uint32_t *exhausted);
+    LIB_EXPORT
+    TPM_RC TSS_GetSocketStatistics(TSS_CONTEXT *tssContext,
+				   uint32_t *commands,
+				   uint32_t *writes,
+				   uint32_t *reads);
+    LIB_EXPORT
+    TPM_RC TSS_GetDeviceStatistics(TSS_CONTEXT *tssContext,
+				   uint32_t *commands,
+				   uint32_t *timeouts,
+				   uint64_t *waitTime,
+				   uint64_t *processTime);
+    LIB_EXPORT
+    TPM_RC TSS_GetPolicyDigest(TSS_CONTEXT *tssContext,
+			       TPM2B_DIGEST *policyDigest,
+			       TPMI_SH_POLICY policySession);
+    LIB_EXPORT
+    TPM_RC TSS_GetSessionAuditDigest(TSS_CONTEXT *tssContext,
+				     TPM2B_DIGEST *auditDigest,
+				     TPMI_SH_HMAC sessionHandle);
+    LIB_EXPORT
+    TPM_RC TSS_GetCpHash(TSS_CONTEXT *tssContext,
+			 TPMT_HA cpHash[],
+			 size_t count,
+			 COMMAND_PARAMETERS *in,
+			 TPM_CC commandCode);
+
 #ifdef __cplusplus
 }
 #endif
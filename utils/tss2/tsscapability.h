@@ -0,0 +1,89 @@
+/********************************************************************************/
+/*										*/
+/*			     TSS Capability Cache				*/
+/*		       IBM Thomas J. Watson Research Center			*/
+/*			    $Id: tsscapability.h $				*/
+/*										*/
+/* (c) Copyright IBM Corporation 2017.						*/
+/*										*/
+/* All rights reserved.								*/
+/* 										*/
+/* Redistribution and use in source and binary forms, with or without		*/
+/* modification, are permitted provided that the following conditions are	*/
+/* met:										*/
+/* 										*/
+/* Redistributions of source code must retain the above copyright notice,	*/
+/* this list of conditions and the following disclaimer.			*/
+/* 										*/
+/* Redistributions in binary form must reproduce the above copyright		*/
+/* notice, this list of conditions and the following disclaimer in the		*/
+/* documentation and/or other materials provided with the distribution.		*/
+/* 										*/
+/* Neither the names of the IBM Corporation nor the names of its		*/
+/* contributors may be used to endorse or promote products derived from		*/
+/* this software without specific prior written permission.			*/
+/* 										*/
+/* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS		*/
+/* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT		*/
+/* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR	*/
+/* A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT		*/
+/* HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,	*/
+/* SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT		*/
+/* LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,	*/
+/* DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY	*/
+/* THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT		*/
+/* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE	*/
+/* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.		*/
+/********************************************************************************/
+
+
+/* This is a semi-public header. The API is subject to change.
+
+   It is useful for applications that query TPM capabilities, especially the fixed properties that
+   do not change while the TPM is running.
+*/
+
+#ifndef TSSCAPABILITY_H
+#define TSSCAPABILITY_H
+
+#include <stdint.h>
+
+#ifndef TPM_TSS
+#define TPM_TSS
+#endif
+#include <tss2/tss.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+    LIB_EXPORT
+    TPM_RC TSS_Capability_Get(TSS_CONTEXT *tssContext,
+			      TPMS_CAPABILITY_DATA *capabilityData,
+			      TPMI_YES_NO *moreData,
+			      TPM_CAP capability,
+			      uint32_t property,
+			      uint32_t propertyCount);
+    LIB_EXPORT
+    TPM_RC TSS_Capability_GetProperty(TSS_CONTEXT *tssContext,
+				      uint32_t *value,
+				      TPM_PT property);
+    LIB_EXPORT
+    TPM_RC TSS_Capability_GetPcrs(TSS_CONTEXT *tssContext,
+				  TPML_PCR_SELECTION *pcrSelection);
+    LIB_EXPORT
+    TPM_RC TSS_Capability_GetAlgorithm(TSS_CONTEXT *tssContext,
+				       int *implemented,
+				       TPMA_ALGORITHM *algProperties,
+				       TPM_ALG_ID alg);
+    LIB_EXPORT
+    TPM_RC TSS_Capability_NextProperty(uint32_t *nextProperty,
+				       const TPMS_CAPABILITY_DATA *capabilityData);
+    LIB_EXPORT
+    void TSS_Capability_Invalidate(TSS_CONTEXT *tssContext);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
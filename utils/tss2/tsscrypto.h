@@ -80,6 +80,16 @@ extern "C" {
     TPM_RC TSS_HMAC_Generate_valist(TPMT_HA *digest,
 				    const TPM2B_KEY *hmacKey,
 				    va_list ap);
+    LIB_EXPORT
+    TPM_RC TSS_Hash_Start(void **hashContext,
+			  TPMI_ALG_HASH hashAlg);
+    LIB_EXPORT
+    TPM_RC TSS_Hash_Update(void *hashContext,
+			   const uint8_t *buffer,
+			   uint32_t length);
+    LIB_EXPORT
+    TPM_RC TSS_Hash_Finish(TPMT_HA *digest,
+			   void **hashContext);
     LIB_EXPORT void TSS_XOR(unsigned char *out,
 			    const unsigned char *in1,
 			    const unsigned char *in2,
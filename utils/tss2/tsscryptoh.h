@@ -59,6 +59,10 @@ extern "C" {
     LIB_EXPORT
     TPM_RC TSS_Hash_Generate(TPMT_HA *digest,
 			     ...);
+    LIB_EXPORT
+    TPM_RC TSS_Hash_GenerateMulti(TPMT_HA digests[],
+				  size_t count,
+				  ...);
 
     LIB_EXPORT
     TPM_RC TSS_HMAC_Generate(TPMT_HA *digest,
@@ -109,4 +109,17 @@
 #define TSS_RC_NO_SESSION_SLOT		0x000b0090	/* TSS context has no session slot for handle */
 #define TSS_RC_NO_OBJECTPUBLIC_SLOT	0x000b0091	/* TSS context has no object public slot for handle */
 #define TSS_RC_NO_NVPUBLIC_SLOT		0x000b0092	/* TSS context has no NV public slot for handle */
+#define TSS_RC_BAD_ATTEST		0x000b00a0	/* Attestation structure is malformed or not a quote */
+#define TSS_RC_BAD_NONCE		0x000b00a1	/* Attestation extraData does not match the nonce */
+#define TSS_RC_PCR_DIGEST		0x000b00a2	/* Quote PCR digest does not match the PCR values */
+#define TSS_RC_NO_KEY			0x000b00a3	/* No verification key for the Name */
+#define TSS_RC_BAD_DIGEST_SIZE		0x000b00a4	/* Digest size does not match the hash algorithm */
+#define TSS_RC_POLICY_OR_COUNT		0x000b00a5	/* PolicyOR requires 2 to 8 branches */
+#define TSS_RC_POLICY_NOT_EMULATED	0x000b00a6	/* policy digest cannot be calculated by the TSS */
+#define TSS_RC_PCR_NOT_CACHED		0x000b00a7	/* PCR values have not been read */
+#define TSS_RC_AUDIT_NOT_EMULATED	0x000b00a8	/* audit digest cannot be calculated by the TSS */
+#define TSS_RC_AUDIT_DIGEST		0x000b00a9	/* audit digest does not match the TSS */
+#define TSS_RC_DEVICE_TIMEOUT		0x000b00aa	/* TPM device did not respond within the timeout */
+#define TSS_RC_REPLAY_MISMATCH		0x000b00ab	/* command does not match the replay trace */
+#define TSS_RC_REPLAY_END		0x000b00ac	/* replay trace has no more commands */
 #endif
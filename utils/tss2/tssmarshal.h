@@ -52,6 +52,7 @@
 
 #include "BaseTypes.h"
 #include <tss2/TPM_Types.h>
+#include <tss2/Parameters.h>
 
 #include "ActivateCredential_fp.h"
 #include "CertifyCreation_fp.h"
@@ -872,6 +873,21 @@ extern "C" {
     LIB_EXPORT TPM_RC
     TSS_TPM2B_CREATION_DATA_Marshal(const TPM2B_CREATION_DATA *source, UINT16 *written, BYTE **buffer, INT32 *size);
 
+    /* all commands, by command code, see TSS_MarshalTable_Entry() */
+
+    LIB_EXPORT TPM_RC
+    TSS_MarshalTable_Entry(size_t index, TPM_CC *commandCode, const char **commandText,
+			   uint32_t *commandHandleCount);
+    LIB_EXPORT TPM_RC
+    TSS_MarshalTable_InMarshal(TPM_CC commandCode, COMMAND_PARAMETERS *in,
+			       UINT16 *written, BYTE **buffer, INT32 *size);
+    LIB_EXPORT TPM_RC
+    TSS_MarshalTable_InUnmarshal(TPM_CC commandCode, COMMAND_PARAMETERS *in,
+				 BYTE **buffer, INT32 *size, TPM_HANDLE handles[]);
+    LIB_EXPORT TPM_RC
+    TSS_MarshalTable_OutUnmarshal(TPM_CC commandCode, RESPONSE_PARAMETERS *out, TPM_ST tag,
+				  BYTE **buffer, INT32 *size);
+
 #ifdef __cplusplus
 }
 #endif
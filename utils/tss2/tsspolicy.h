@@ -0,0 +1,167 @@
+/********************************************************************************/
+/*										*/
+/*			TSS Policy Digest Calculation				*/
+/*		       IBM Thomas J. Watson Research Center			*/
+/*			      $Id: tsspolicy.h $				*/
+/*										*/
+/* (c) Copyright IBM Corporation 2017.						*/
+/*										*/
+/* All rights reserved.								*/
+/* 										*/
+/* Redistribution and use in source and binary forms, with or without		*/
+/* modification, are permitted provided that the following conditions are	*/
+/* met:										*/
+/* 										*/
+/* Redistributions of source code must retain the above copyright notice,	*/
+/* this list of conditions and the following disclaimer.			*/
+/* 										*/
+/* Redistributions in binary form must reproduce the above copyright		*/
+/* notice, this list of conditions and the following disclaimer in the		*/
+/* documentation and/or other materials provided with the distribution.		*/
+/* 										*/
+/* Neither the names of the IBM Corporation nor the names of its		*/
+/* contributors may be used to endorse or promote products derived from		*/
+/* this software without specific prior written permission.			*/
+/* 										*/
+/* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS		*/
+/* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT		*/
+/* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR	*/
+/* A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT		*/
+/* HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,	*/
+/* SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT		*/
+/* LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,	*/
+/* DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY	*/
+/* THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT		*/
+/* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE	*/
+/* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.		*/
+/********************************************************************************/
+
+/* This is a semi-public header. The API should be stable, but is less guaranteed.
+
+   It is useful for applications that calculate policy digests without a TPM trial session.
+
+   A TSS_POLICY holds the running policy digest for one or more hash algorithms.  Each
+   TSS_Policy_ function extends all of them, exactly as the TPM extends the policyDigest of a
+   policy session for the corresponding policy command.  Since a TSS_POLICY is a plain value, a
+   common policy prefix can be calculated once and copied before adding the terms that differ.
+
+   Arguments that are themselves digests (a pcrDigest, a PolicyOR digest list, cpHashA, nameHash,
+   templateHash) are extended unchanged into every algorithm, so their size must match each
+   algorithm's digest size.
+
+   TSS_Policy_PCRCached() takes the PCR values from those that the TSS context read with
+   TPM2_PCR_Read(), and reuses the pcrDigest while those PCRs are unchanged.
+*/
+
+#ifndef TSSPOLICY_H
+#define TSSPOLICY_H
+
+#include <stdint.h>
+
+#ifndef TPM_TSS
+#define TPM_TSS
+#endif
+#include <tss2/tss.h>
+
+typedef struct TSS_POLICY {
+    uint32_t	count;			/* number of hash algorithms */
+    TPMT_HA	digest[HASH_COUNT];	/* policy digest for each algorithm */
+} TSS_POLICY;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+    LIB_EXPORT
+    TPM_RC TSS_Policy_Init(TSS_POLICY *policy,
+			   const TPMI_ALG_HASH *hashAlg,
+			   uint32_t count);
+    LIB_EXPORT
+    void TSS_Policy_Reset(TSS_POLICY *policy);
+    LIB_EXPORT
+    TPM_RC TSS_Policy_GetDigest(TPM2B_DIGEST *digest,
+				const TSS_POLICY *policy,
+				TPMI_ALG_HASH hashAlg);
+    LIB_EXPORT
+    TPM_RC TSS_Policy_CommandCode(TSS_POLICY *policy,
+				  TPM_CC code);
+    LIB_EXPORT
+    TPM_RC TSS_Policy_AuthValue(TSS_POLICY *policy);
+    LIB_EXPORT
+    TPM_RC TSS_Policy_Password(TSS_POLICY *policy);
+    LIB_EXPORT
+    TPM_RC TSS_Policy_PhysicalPresence(TSS_POLICY *policy);
+    LIB_EXPORT
+    TPM_RC TSS_Policy_Locality(TSS_POLICY *policy,
+			       TPMA_LOCALITY locality);
+    LIB_EXPORT
+    TPM_RC TSS_Policy_NvWritten(TSS_POLICY *policy,
+				TPMI_YES_NO writtenSet);
+    LIB_EXPORT
+    TPM_RC TSS_Policy_PCR(TSS_POLICY *policy,
+			  const TPML_PCR_SELECTION *pcrs,
+			  const TPM2B_DIGEST *pcrValues,
+			  uint32_t count);
+    LIB_EXPORT
+    TPM_RC TSS_Policy_PCRDigest(TSS_POLICY *policy,
+				const TPML_PCR_SELECTION *pcrs,
+				const TPM2B_DIGEST *pcrDigest);
+    LIB_EXPORT
+    TPM_RC TSS_Policy_PCRCached(TSS_CONTEXT *tssContext,
+				TSS_POLICY *policy,
+				const TPML_PCR_SELECTION *pcrs);
+    LIB_EXPORT
+    void TSS_Policy_PCRInvalidate(TSS_CONTEXT *tssContext);
+    LIB_EXPORT
+    TPM_RC TSS_Policy_OR(TSS_POLICY *policy,
+			 const TSS_POLICY *branches,
+			 uint32_t count);
+    LIB_EXPORT
+    TPM_RC TSS_Policy_ORDigests(TSS_POLICY *policy,
+				const TPML_DIGEST *pHashList);
+    LIB_EXPORT
+    TPM_RC TSS_Policy_Signed(TSS_POLICY *policy,
+			     const TPM2B_NAME *authName,
+			     const TPM2B_NONCE *policyRef);
+    LIB_EXPORT
+    TPM_RC TSS_Policy_Secret(TSS_POLICY *policy,
+			     const TPM2B_NAME *authName,
+			     const TPM2B_NONCE *policyRef);
+    LIB_EXPORT
+    TPM_RC TSS_Policy_Authorize(TSS_POLICY *policy,
+				const TPM2B_NAME *keySignName,
+				const TPM2B_NONCE *policyRef);
+    LIB_EXPORT
+    TPM_RC TSS_Policy_AuthorizeNV(TSS_POLICY *policy,
+				  const TPM2B_NAME *nvIndexName);
+    LIB_EXPORT
+    TPM_RC TSS_Policy_NV(TSS_POLICY *policy,
+			 const TPM2B_NAME *nvIndexName,
+			 const TPM2B_OPERAND *operandB,
+			 UINT16 offset,
+			 TPM_EO operation);
+    LIB_EXPORT
+    TPM_RC TSS_Policy_CounterTimer(TSS_POLICY *policy,
+				   const TPM2B_OPERAND *operandB,
+				   UINT16 offset,
+				   TPM_EO operation);
+    LIB_EXPORT
+    TPM_RC TSS_Policy_CpHash(TSS_POLICY *policy,
+			     const TPM2B_DIGEST *cpHashA);
+    LIB_EXPORT
+    TPM_RC TSS_Policy_NameHash(TSS_POLICY *policy,
+			       const TPM2B_DIGEST *nameHash);
+    LIB_EXPORT
+    TPM_RC TSS_Policy_TemplateHash(TSS_POLICY *policy,
+				   const TPM2B_DIGEST *templateHash);
+    LIB_EXPORT
+    TPM_RC TSS_Policy_DuplicationSelect(TSS_POLICY *policy,
+					const TPM2B_NAME *objectName,
+					const TPM2B_NAME *newParentName,
+					TPMI_YES_NO includeObject);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
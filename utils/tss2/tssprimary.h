@@ -0,0 +1,80 @@
+/********************************************************************************/
+/*										*/
+/*			    TSS Primary Key Cache				*/
+/*		       IBM Thomas J. Watson Research Center			*/
+/*			     $Id: tssprimary.h $				*/
+/*										*/
+/* (c) Copyright IBM Corporation 2017.						*/
+/*										*/
+/* All rights reserved.								*/
+/* 										*/
+/* Redistribution and use in source and binary forms, with or without		*/
+/* modification, are permitted provided that the following conditions are	*/
+/* met:										*/
+/* 										*/
+/* Redistributions of source code must retain the above copyright notice,	*/
+/* this list of conditions and the following disclaimer.			*/
+/* 										*/
+/* Redistributions in binary form must reproduce the above copyright		*/
+/* notice, this list of conditions and the following disclaimer in the		*/
+/* documentation and/or other materials provided with the distribution.		*/
+/* 										*/
+/* Neither the names of the IBM Corporation nor the names of its		*/
+/* contributors may be used to endorse or promote products derived from		*/
+/* this software without specific prior written permission.			*/
+/* 										*/
+/* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS		*/
+/* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT		*/
+/* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR	*/
+/* A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT		*/
+/* HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,	*/
+/* SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT		*/
+/* LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,	*/
+/* DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY	*/
+/* THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT		*/
+/* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE	*/
+/* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.		*/
+/********************************************************************************/
+
+
+/* This is a semi-public header. The API is subject to change.
+
+   It is useful for applications that repeatedly create the same primary key, e.g., a storage root
+   key for each provisioning step.
+*/
+
+#ifndef TSSPRIMARY_H
+#define TSSPRIMARY_H
+
+#include <stdint.h>
+
+#ifndef TPM_TSS
+#define TPM_TSS
+#endif
+#include <tss2/tss.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+    LIB_EXPORT
+    TPM_RC TSS_PrimaryCache_CreatePrimary(TSS_CONTEXT *tssContext,
+					  CreatePrimary_Out *out,
+					  int *cached,
+					  CreatePrimary_In *in,
+					  TPMI_SH_AUTH_SESSION sessionHandle0,
+					  const char *password0,
+					  unsigned int sessionAttributes0,
+					  TPMI_SH_AUTH_SESSION sessionHandle1,
+					  unsigned int sessionAttributes1,
+					  TPMI_SH_AUTH_SESSION sessionHandle2,
+					  unsigned int sessionAttributes2);
+    LIB_EXPORT
+    TPM_RC TSS_PrimaryCache_Invalidate(TSS_CONTEXT *tssContext,
+				       TPMI_RH_HIERARCHY hierarchy);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,82 @@
+/********************************************************************************/
+/*										*/
+/*			    TSS Command Scheduler				*/
+/*		       IBM Thomas J. Watson Research Center			*/
+/*			    $Id: tssscheduler.h $				*/
+/*										*/
+/* (c) Copyright IBM Corporation 2017.						*/
+/*										*/
+/* All rights reserved.								*/
+/* 										*/
+/* Redistribution and use in source and binary forms, with or without		*/
+/* modification, are permitted provided that the following conditions are	*/
+/* met:										*/
+/* 										*/
+/* Redistributions of source code must retain the above copyright notice,	*/
+/* this list of conditions and the following disclaimer.			*/
+/* 										*/
+/* Redistributions in binary form must reproduce the above copyright		*/
+/* notice, this list of conditions and the following disclaimer in the		*/
+/* documentation and/or other materials provided with the distribution.		*/
+/* 										*/
+/* Neither the names of the IBM Corporation nor the names of its		*/
+/* contributors may be used to endorse or promote products derived from		*/
+/* this software without specific prior written permission.			*/
+/* 										*/
+/* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS		*/
+/* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT		*/
+/* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR	*/
+/* A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT		*/
+/* HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,	*/
+/* SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT		*/
+/* LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,	*/
+/* DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY	*/
+/* THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT		*/
+/* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE	*/
+/* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.		*/
+/********************************************************************************/
+
+
+
+/* The scheduler lets several TSS_CONTEXTs, typically one per thread, share the TPM connection of
+   a transport context.  Commands wait in a queue and are sent one at a time, highest priority
+   (lowest value) first, then earliest deadline, then first come.
+
+   A TPM command cannot be preempted, so a waiting command is delayed by at most the command in
+   progress.  Long work that is already a series of commands (hash and event sequences, NV writes
+   in chunks, IMA and event log replays) yields to higher priority commands between each one.
+*/
+
+#ifndef TSSSCHEDULER_H
+#define TSSSCHEDULER_H
+
+#include <stdint.h>
+
+#include <tss2/tss.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+    LIB_EXPORT
+    TPM_RC TSS_Scheduler_Create(TSS_SCHEDULER **scheduler,
+				TSS_CONTEXT *transportContext);
+    LIB_EXPORT
+    TPM_RC TSS_Scheduler_Delete(TSS_SCHEDULER *scheduler);
+    LIB_EXPORT
+    TPM_RC TSS_SetScheduler(TSS_CONTEXT *tssContext,
+			    TSS_SCHEDULER *scheduler);
+    LIB_EXPORT
+    TPM_RC TSS_Scheduler_GetStatistics(TSS_SCHEDULER *scheduler,
+				       uint32_t *commands,
+				       uint32_t *queueDepth,
+				       uint32_t *queueDepthMax,
+				       uint64_t *waitTime,
+				       uint64_t *waitTimeMax,
+				       uint32_t *deadlineMisses);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,162 @@
+/********************************************************************************/
+/*										*/
+/*		       TSS Streaming Large Data Helpers				*/
+/*		       IBM Thomas J. Watson Research Center			*/
+/*			      $Id: tssstream.h $				*/
+/*										*/
+/* (c) Copyright IBM Corporation 2017.						*/
+/*										*/
+/* All rights reserved.								*/
+/* 										*/
+/* Redistribution and use in source and binary forms, with or without		*/
+/* modification, are permitted provided that the following conditions are	*/
+/* met:										*/
+/* 										*/
+/* Redistributions of source code must retain the above copyright notice,	*/
+/* this list of conditions and the following disclaimer.			*/
+/* 										*/
+/* Redistributions in binary form must reproduce the above copyright		*/
+/* notice, this list of conditions and the following disclaimer in the		*/
+/* documentation and/or other materials provided with the distribution.		*/
+/* 										*/
+/* Neither the names of the IBM Corporation nor the names of its		*/
+/* contributors may be used to endorse or promote products derived from		*/
+/* this software without specific prior written permission.			*/
+/* 										*/
+/* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS		*/
+/* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT		*/
+/* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR	*/
+/* A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT		*/
+/* HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,	*/
+/* SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT		*/
+/* LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,	*/
+/* DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY	*/
+/* THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT		*/
+/* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE	*/
+/* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.		*/
+/********************************************************************************/
+
+
+/* This is a semi-public header. The API is subject to change.
+
+   It is useful for applications that must pass data larger than one TPM command buffer through the
+   TPM, e.g., hashing a large file or reading and writing a large NV index.
+*/
+
+#ifndef TSSSTREAM_H
+#define TSSSTREAM_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+#ifndef TPM_TSS
+#define TPM_TSS
+#endif
+#include <tss2/tss.h>
+
+/* TSS_StreamRead_t is the application data source for the streaming functions.
+
+   It should return up to bufferSize bytes in buffer and the count in bytesRead.  bytesRead of zero
+   indicates the end of the stream.  A non-zero return code aborts the stream.
+*/
+
+typedef TPM_RC (*TSS_StreamRead_t)(void *readContext,
+				   uint8_t *buffer,
+				   uint32_t bufferSize,
+				   uint32_t *bytesRead);
+
+/* TSS_StreamWrite_t is the application data sink for the streaming functions.
+
+   It is called with each chunk of data, in order.  A non-zero return code aborts the stream.
+*/
+
+typedef TPM_RC (*TSS_StreamWrite_t)(void *writeContext,
+				    const uint8_t *buffer,
+				    uint32_t length);
+
+/* TSS_STREAM_BUFFER is the writeContext for TSS_Stream_WriteBuffer().  The caller supplies buffer
+   and size, and initializes length to zero. */
+
+typedef struct {
+    uint8_t 	*buffer;
+    uint32_t	size;		/* size of buffer */
+    uint32_t	length;		/* bytes written so far */
+} TSS_STREAM_BUFFER;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+    LIB_EXPORT
+    TPM_RC TSS_Stream_ReadFile(void *readContext,
+			       uint8_t *buffer,
+			       uint32_t bufferSize,
+			       uint32_t *bytesRead);
+    LIB_EXPORT
+    TPM_RC TSS_Stream_WriteFile(void *writeContext,
+				const uint8_t *buffer,
+				uint32_t length);
+    LIB_EXPORT
+    TPM_RC TSS_Stream_WriteBuffer(void *writeContext,
+				  const uint8_t *buffer,
+				  uint32_t length);
+    LIB_EXPORT
+    TPM_RC TSS_Stream_GetInputBufferMax(TSS_CONTEXT *tssContext,
+					uint32_t *inputBufferMax);
+    LIB_EXPORT
+    TPM_RC TSS_Hash_Stream(TSS_CONTEXT *tssContext,
+			   TPMT_HA *digest,
+			   TPMT_TK_HASHCHECK *validation,
+			   TPMI_RH_HIERARCHY hierarchy,
+			   TSS_StreamRead_t readFunction,
+			   void *readContext,
+			   uint64_t *streamed);
+    LIB_EXPORT
+    TPM_RC TSS_HMAC_Stream(TSS_CONTEXT *tssContext,
+			   TPMT_HA *digest,
+			   TPMI_DH_OBJECT keyHandle,
+			   const char *keyPassword,
+			   TPMI_SH_AUTH_SESSION sessionHandle,
+			   unsigned int sessionAttributes,
+			   TSS_StreamRead_t readFunction,
+			   void *readContext,
+			   uint64_t *streamed);
+    LIB_EXPORT
+    TPM_RC TSS_NV_GetBufferMax(TSS_CONTEXT *tssContext,
+			       uint32_t *nvBufferMax);
+    LIB_EXPORT
+    TPM_RC TSS_NV_ReadStream(TSS_CONTEXT *tssContext,
+			     TPMI_RH_NV_AUTH authHandle,
+			     TPMI_RH_NV_INDEX nvIndex,
+			     uint16_t offset,
+			     uint16_t size,
+			     TSS_StreamWrite_t writeFunction,
+			     void *writeContext,
+			     TPMI_SH_AUTH_SESSION sessionHandle0,
+			     const char *password0,
+			     unsigned int sessionAttributes0,
+			     TPMI_SH_AUTH_SESSION sessionHandle1,
+			     unsigned int sessionAttributes1,
+			     TPMI_SH_AUTH_SESSION sessionHandle2,
+			     unsigned int sessionAttributes2);
+    LIB_EXPORT
+    TPM_RC TSS_NV_WriteStream(TSS_CONTEXT *tssContext,
+			      TPMI_RH_NV_AUTH authHandle,
+			      TPMI_RH_NV_INDEX nvIndex,
+			      uint16_t offset,
+			      TSS_StreamRead_t readFunction,
+			      void *readContext,
+			      uint32_t *written,
+			      TPMI_SH_AUTH_SESSION sessionHandle0,
+			      const char *password0,
+			      unsigned int sessionAttributes0,
+			      TPMI_SH_AUTH_SESSION sessionHandle1,
+			      unsigned int sessionAttributes1,
+			      TPMI_SH_AUTH_SESSION sessionHandle2,
+			      unsigned int sessionAttributes2);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
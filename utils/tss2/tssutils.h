@@ -61,6 +61,14 @@ extern "C" {
     typedef TPM_RC (*UnmarshalFunction_t)(void *target, uint8_t **buffer, int32_t *size);
     typedef TPM_RC (*MarshalFunction_t)(void *source, uint16_t *written, uint8_t **buffer, int32_t *size);
 
+    /* TSS_MARSHAL_BUFFER is a reusable, growable marshal output buffer.  Initialize with
+       TSS_MarshalBuffer_Init(), free with TSS_MarshalBuffer_Free(). */
+
+    typedef struct {
+	uint8_t		*buffer;	/* grows as needed */
+	uint32_t	size;		/* allocated bytes */
+    } TSS_MARSHAL_BUFFER;
+
     LIB_EXPORT
     TPM_RC TSS_Malloc(unsigned char **buffer, uint32_t size);
     LIB_EXPORT
@@ -71,6 +79,15 @@ extern "C" {
 				 uint16_t		*written,
 				 void 		*structure,
 				 MarshalFunction_t 	marshalFunction);
+    LIB_EXPORT
+    void TSS_MarshalBuffer_Init(TSS_MARSHAL_BUFFER *marshalBuffer);
+    LIB_EXPORT
+    void TSS_MarshalBuffer_Free(TSS_MARSHAL_BUFFER *marshalBuffer);
+    LIB_EXPORT
+    TPM_RC TSS_Structure_MarshalBuffer(TSS_MARSHAL_BUFFER	*marshalBuffer,
+				       uint16_t			*written,
+				       void 			*structure,
+				       MarshalFunction_t 	marshalFunction);
 
     LIB_EXPORT 
     TPM_RC TSS_TPM2B_Copy(TPM2B *target, TPM2B *source, uint16_t targetSize);
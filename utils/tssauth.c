@@ -47,6 +47,8 @@
 
 #ifdef TPM_POSIX
 #include <netinet/in.h>
+#include <unistd.h>
+#include <time.h>
 #endif
 #ifdef TPM_WINDOWS
 #include <winsock2.h>
@@ -73,11 +75,19 @@ extern int tssVverbose;
 
 /* Generic functions to marshal and unmarshal Part 3 ordinal command and response parameters */
 
+/* Command parameter checking unmarshals into a scratch _In structure on the stack if it fits.  The
+   default covers all but the list commands (e.g., TPM2_SetCommandCodeAuditStatus), which are
+   allocated. */
+
+#ifndef TSS_VALIDATE_STACK
+#define TSS_VALIDATE_STACK	2304
+#endif
+
 typedef TPM_RC (*MarshalInFunction_t)(COMMAND_PARAMETERS *source,
 				      UINT16 *written, BYTE **buffer, INT32 *size);
 typedef TPM_RC (*UnmarshalOutFunction_t)(RESPONSE_PARAMETERS *target,
 					 TPM_ST tag, BYTE **buffer, INT32 *size);
-typedef TPM_RC (*UnmarshalInFunction_t)(COMMAND_PARAMETERS *target,
+typedef TPM_RC (*UnmarshalInFunction_t)(void *target,
 					BYTE **buffer, INT32 *size, TPM_HANDLE handles[]);
 
 typedef struct MARSHAL_TABLE {
@@ -87,6 +97,8 @@ typedef struct MARSHAL_TABLE {
     UnmarshalOutFunction_t 	unmarshalOutFunction;	/* unmarshal output response */
     UnmarshalInFunction_t	unmarshalInFunction;	/* unmarshal input command for parameter
 							   checking */
+    size_t			inSize;			/* size of the command _In structure, the
+							   parameter checking scratch */
 } MARSHAL_TABLE;
 
 static const MARSHAL_TABLE marshalTable [] = {
@@ -94,547 +106,656 @@ static const MARSHAL_TABLE marshalTable [] = {
     {TPM_CC_Startup, "TPM2_Startup",
      (MarshalInFunction_t)TSS_Startup_In_Marshal,
      NULL,
-     (UnmarshalInFunction_t)Startup_In_Unmarshal},
+     (UnmarshalInFunction_t)Startup_In_Unmarshal,
+     sizeof(Startup_In)},
 
     {TPM_CC_Shutdown, "TPM2_Shutdown",
      (MarshalInFunction_t)TSS_Shutdown_In_Marshal,
      NULL,
-     (UnmarshalInFunction_t)Shutdown_In_Unmarshal},
+     (UnmarshalInFunction_t)Shutdown_In_Unmarshal,
+     sizeof(Shutdown_In)},
 
     {TPM_CC_SelfTest, "TPM2_SelfTest",
      (MarshalInFunction_t)TSS_SelfTest_In_Marshal,
      NULL,
-     (UnmarshalInFunction_t)SelfTest_In_Unmarshal},
+     (UnmarshalInFunction_t)SelfTest_In_Unmarshal,
+     sizeof(SelfTest_In)},
 
     {TPM_CC_IncrementalSelfTest, "TPM2_IncrementalSelfTest",
      (MarshalInFunction_t)TSS_IncrementalSelfTest_In_Marshal,
      (UnmarshalOutFunction_t)TSS_IncrementalSelfTest_Out_Unmarshal,
-     (UnmarshalInFunction_t)IncrementalSelfTest_In_Unmarshal},
+     (UnmarshalInFunction_t)IncrementalSelfTest_In_Unmarshal,
+     sizeof(IncrementalSelfTest_In)},
 
     {TPM_CC_GetTestResult, "TPM2_GetTestResult",
      NULL,
      (UnmarshalOutFunction_t)TSS_GetTestResult_Out_Unmarshal,
-     NULL},
+     NULL,
+     0},
 
     {TPM_CC_StartAuthSession, "TPM2_StartAuthSession",
      (MarshalInFunction_t)TSS_StartAuthSession_In_Marshal,
      (UnmarshalOutFunction_t)TSS_StartAuthSession_Out_Unmarshal,
-     (UnmarshalInFunction_t)StartAuthSession_In_Unmarshal},
+     (UnmarshalInFunction_t)StartAuthSession_In_Unmarshal,
+     sizeof(StartAuthSession_In)},
     
     {TPM_CC_PolicyRestart, "TPM2_PolicyRestart",
      (MarshalInFunction_t)TSS_PolicyRestart_In_Marshal,
      NULL,
-     (UnmarshalInFunction_t)PolicyRestart_In_Unmarshal},
+     (UnmarshalInFunction_t)PolicyRestart_In_Unmarshal,
+     sizeof(PolicyRestart_In)},
 
     {TPM_CC_Create, "TPM2_Create",
      (MarshalInFunction_t)TSS_Create_In_Marshal,
      (UnmarshalOutFunction_t)TSS_Create_Out_Unmarshal,
-     (UnmarshalInFunction_t)Create_In_Unmarshal},
+     (UnmarshalInFunction_t)Create_In_Unmarshal,
+     sizeof(Create_In)},
 
     {TPM_CC_Load, "TPM2_Load",
      (MarshalInFunction_t)TSS_Load_In_Marshal,
      (UnmarshalOutFunction_t)TSS_Load_Out_Unmarshal,
-     (UnmarshalInFunction_t)Load_In_Unmarshal},
+     (UnmarshalInFunction_t)Load_In_Unmarshal,
+     sizeof(Load_In)},
 
     {TPM_CC_LoadExternal, "TPM2_LoadExternal",
      (MarshalInFunction_t)TSS_LoadExternal_In_Marshal,
      (UnmarshalOutFunction_t)TSS_LoadExternal_Out_Unmarshal,
-     (UnmarshalInFunction_t)LoadExternal_In_Unmarshal},
+     (UnmarshalInFunction_t)LoadExternal_In_Unmarshal,
+     sizeof(LoadExternal_In)},
 
     {TPM_CC_ReadPublic, "TPM2_ReadPublic",
      (MarshalInFunction_t)TSS_ReadPublic_In_Marshal,
      (UnmarshalOutFunction_t)TSS_ReadPublic_Out_Unmarshal,
-     (UnmarshalInFunction_t)ReadPublic_In_Unmarshal},
+     (UnmarshalInFunction_t)ReadPublic_In_Unmarshal,
+     sizeof(ReadPublic_In)},
 
     {TPM_CC_ActivateCredential, "TPM2_ActivateCredential",
      (MarshalInFunction_t)TSS_ActivateCredential_In_Marshal,
      (UnmarshalOutFunction_t)TSS_ActivateCredential_Out_Unmarshal,
-     (UnmarshalInFunction_t)ActivateCredential_In_Unmarshal},
+     (UnmarshalInFunction_t)ActivateCredential_In_Unmarshal,
+     sizeof(ActivateCredential_In)},
 
     {TPM_CC_MakeCredential, "TPM2_MakeCredential",
      (MarshalInFunction_t)TSS_MakeCredential_In_Marshal,
      (UnmarshalOutFunction_t)TSS_MakeCredential_Out_Unmarshal,
-     (UnmarshalInFunction_t)MakeCredential_In_Unmarshal},
+     (UnmarshalInFunction_t)MakeCredential_In_Unmarshal,
+     sizeof(MakeCredential_In)},
 
     {TPM_CC_Unseal, "TPM2_Unseal",
      (MarshalInFunction_t)TSS_Unseal_In_Marshal,
      (UnmarshalOutFunction_t)TSS_Unseal_Out_Unmarshal,
-     (UnmarshalInFunction_t)Unseal_In_Unmarshal},
+     (UnmarshalInFunction_t)Unseal_In_Unmarshal,
+     sizeof(Unseal_In)},
 
     {TPM_CC_ObjectChangeAuth, "TPM2_ObjectChangeAuth",
      (MarshalInFunction_t)TSS_ObjectChangeAuth_In_Marshal,
      (UnmarshalOutFunction_t)TSS_ObjectChangeAuth_Out_Unmarshal,
-     (UnmarshalInFunction_t)ObjectChangeAuth_In_Unmarshal},
+     (UnmarshalInFunction_t)ObjectChangeAuth_In_Unmarshal,
+     sizeof(ObjectChangeAuth_In)},
 
     {TPM_CC_CreateLoaded, "TPM2_CreateLoaded",
      (MarshalInFunction_t)TSS_CreateLoaded_In_Marshal,
      (UnmarshalOutFunction_t)TSS_CreateLoaded_Out_Unmarshal,
-     (UnmarshalInFunction_t)CreateLoaded_In_Unmarshal},
+     (UnmarshalInFunction_t)CreateLoaded_In_Unmarshal,
+     sizeof(CreateLoaded_In)},
 
     {TPM_CC_Duplicate, "TPM2_Duplicate",
      (MarshalInFunction_t)TSS_Duplicate_In_Marshal,
      (UnmarshalOutFunction_t)TSS_Duplicate_Out_Unmarshal,
-     (UnmarshalInFunction_t)Duplicate_In_Unmarshal},
+     (UnmarshalInFunction_t)Duplicate_In_Unmarshal,
+     sizeof(Duplicate_In)},
 
     {TPM_CC_Rewrap, "TPM2_Rewrap",
      (MarshalInFunction_t)TSS_Rewrap_In_Marshal,
      (UnmarshalOutFunction_t)TSS_Rewrap_Out_Unmarshal,
-     (UnmarshalInFunction_t)Rewrap_In_Unmarshal},
+     (UnmarshalInFunction_t)Rewrap_In_Unmarshal,
+     sizeof(Rewrap_In)},
 
     {TPM_CC_Import, "TPM2_Import",
      (MarshalInFunction_t)TSS_Import_In_Marshal,
      (UnmarshalOutFunction_t)TSS_Import_Out_Unmarshal,
-     (UnmarshalInFunction_t)Import_In_Unmarshal},
+     (UnmarshalInFunction_t)Import_In_Unmarshal,
+     sizeof(Import_In)},
 
     {TPM_CC_RSA_Encrypt, "TPM2_RSA_Encrypt",
      (MarshalInFunction_t)TSS_RSA_Encrypt_In_Marshal,
      (UnmarshalOutFunction_t)TSS_RSA_Encrypt_Out_Unmarshal,
-     (UnmarshalInFunction_t)RSA_Encrypt_In_Unmarshal},
+     (UnmarshalInFunction_t)RSA_Encrypt_In_Unmarshal,
+     sizeof(RSA_Encrypt_In)},
 
     {TPM_CC_RSA_Decrypt, "TPM2_RSA_Decrypt",
      (MarshalInFunction_t)TSS_RSA_Decrypt_In_Marshal,
      (UnmarshalOutFunction_t)TSS_RSA_Decrypt_Out_Unmarshal,
-     (UnmarshalInFunction_t)RSA_Decrypt_In_Unmarshal},
+     (UnmarshalInFunction_t)RSA_Decrypt_In_Unmarshal,
+     sizeof(RSA_Decrypt_In)},
 
     {TPM_CC_ECDH_KeyGen, "TPM2_ECDH_KeyGen",
      (MarshalInFunction_t)TSS_ECDH_KeyGen_In_Marshal,
      (UnmarshalOutFunction_t)TSS_ECDH_KeyGen_Out_Unmarshal,
-     (UnmarshalInFunction_t)ECDH_KeyGen_In_Unmarshal},
+     (UnmarshalInFunction_t)ECDH_KeyGen_In_Unmarshal,
+     sizeof(ECDH_KeyGen_In)},
 
     {TPM_CC_ECDH_ZGen, "TPM2_ECDH_ZGen",
      (MarshalInFunction_t)TSS_ECDH_ZGen_In_Marshal,
      (UnmarshalOutFunction_t)TSS_ECDH_ZGen_Out_Unmarshal,
-     (UnmarshalInFunction_t)ECDH_ZGen_In_Unmarshal},
+     (UnmarshalInFunction_t)ECDH_ZGen_In_Unmarshal,
+     sizeof(ECDH_ZGen_In)},
 
     {TPM_CC_ECC_Parameters, "TPM2_ECC_Parameters",
      (MarshalInFunction_t)TSS_ECC_Parameters_In_Marshal,
      (UnmarshalOutFunction_t)TSS_ECC_Parameters_Out_Unmarshal,
-     (UnmarshalInFunction_t)ECC_Parameters_In_Unmarshal},
+     (UnmarshalInFunction_t)ECC_Parameters_In_Unmarshal,
+     sizeof(ECC_Parameters_In)},
 
     {TPM_CC_ZGen_2Phase, "TPM2_ZGen_2Phase",
      (MarshalInFunction_t)TSS_ZGen_2Phase_In_Marshal,
      (UnmarshalOutFunction_t)TSS_ZGen_2Phase_Out_Unmarshal,
-     (UnmarshalInFunction_t)ZGen_2Phase_In_Unmarshal},
+     (UnmarshalInFunction_t)ZGen_2Phase_In_Unmarshal,
+     sizeof(ZGen_2Phase_In)},
 
     {TPM_CC_EncryptDecrypt, "TPM2_EncryptDecrypt",
      (MarshalInFunction_t)TSS_EncryptDecrypt_In_Marshal,
      (UnmarshalOutFunction_t)TSS_EncryptDecrypt_Out_Unmarshal,
-     (UnmarshalInFunction_t)EncryptDecrypt_In_Unmarshal},
+     (UnmarshalInFunction_t)EncryptDecrypt_In_Unmarshal,
+     sizeof(EncryptDecrypt_In)},
 
     {TPM_CC_EncryptDecrypt2, "TPM2_EncryptDecrypt2",
      (MarshalInFunction_t)TSS_EncryptDecrypt2_In_Marshal,
      (UnmarshalOutFunction_t)TSS_EncryptDecrypt2_Out_Unmarshal,
-     (UnmarshalInFunction_t)EncryptDecrypt2_In_Unmarshal},
+     (UnmarshalInFunction_t)EncryptDecrypt2_In_Unmarshal,
+     sizeof(EncryptDecrypt2_In)},
 
     {TPM_CC_Hash, "TPM2_Hash",
      (MarshalInFunction_t)TSS_Hash_In_Marshal,
      (UnmarshalOutFunction_t)TSS_Hash_Out_Unmarshal,
-     (UnmarshalInFunction_t)Hash_In_Unmarshal},
+     (UnmarshalInFunction_t)Hash_In_Unmarshal,
+     sizeof(Hash_In)},
 
     {TPM_CC_HMAC, "TPM2_HMAC",
      (MarshalInFunction_t)TSS_HMAC_In_Marshal,
      (UnmarshalOutFunction_t)TSS_HMAC_Out_Unmarshal,
-     (UnmarshalInFunction_t)HMAC_In_Unmarshal},
+     (UnmarshalInFunction_t)HMAC_In_Unmarshal,
+     sizeof(HMAC_In)},
 
     {TPM_CC_GetRandom, "TPM2_GetRandom",
      (MarshalInFunction_t)TSS_GetRandom_In_Marshal,
      (UnmarshalOutFunction_t)TSS_GetRandom_Out_Unmarshal,
-     (UnmarshalInFunction_t)GetRandom_In_Unmarshal},
+     (UnmarshalInFunction_t)GetRandom_In_Unmarshal,
+     sizeof(GetRandom_In)},
 
     {TPM_CC_StirRandom, "TPM2_StirRandom",
      (MarshalInFunction_t)TSS_StirRandom_In_Marshal,
      NULL,
-     (UnmarshalInFunction_t)StirRandom_In_Unmarshal},
+     (UnmarshalInFunction_t)StirRandom_In_Unmarshal,
+     sizeof(StirRandom_In)},
 
     {TPM_CC_HMAC_Start, "TPM2_HMAC_Start",
      (MarshalInFunction_t)TSS_HMAC_Start_In_Marshal,
      (UnmarshalOutFunction_t)TSS_HMAC_Start_Out_Unmarshal,
-     (UnmarshalInFunction_t)HMAC_Start_In_Unmarshal},
+     (UnmarshalInFunction_t)HMAC_Start_In_Unmarshal,
+     sizeof(HMAC_Start_In)},
 
     {TPM_CC_HashSequenceStart, "TPM2_HashSequenceStart",
      (MarshalInFunction_t)TSS_HashSequenceStart_In_Marshal,
      (UnmarshalOutFunction_t)TSS_HashSequenceStart_Out_Unmarshal,
-     (UnmarshalInFunction_t)HashSequenceStart_In_Unmarshal},
+     (UnmarshalInFunction_t)HashSequenceStart_In_Unmarshal,
+     sizeof(HashSequenceStart_In)},
 
     {TPM_CC_SequenceUpdate, "TPM2_SequenceUpdate",
      (MarshalInFunction_t)TSS_SequenceUpdate_In_Marshal,
      NULL,
-     (UnmarshalInFunction_t)SequenceUpdate_In_Unmarshal},
+     (UnmarshalInFunction_t)SequenceUpdate_In_Unmarshal,
+     sizeof(SequenceUpdate_In)},
 
     {TPM_CC_SequenceComplete, "TPM2_SequenceComplete",
      (MarshalInFunction_t)TSS_SequenceComplete_In_Marshal,
      (UnmarshalOutFunction_t)TSS_SequenceComplete_Out_Unmarshal,
-     (UnmarshalInFunction_t)SequenceComplete_In_Unmarshal},
+     (UnmarshalInFunction_t)SequenceComplete_In_Unmarshal,
+     sizeof(SequenceComplete_In)},
 
     {TPM_CC_EventSequenceComplete, "TPM2_EventSequenceComplete",
      (MarshalInFunction_t)TSS_EventSequenceComplete_In_Marshal,
      (UnmarshalOutFunction_t)TSS_EventSequenceComplete_Out_Unmarshal,
-     (UnmarshalInFunction_t)EventSequenceComplete_In_Unmarshal},
+     (UnmarshalInFunction_t)EventSequenceComplete_In_Unmarshal,
+     sizeof(EventSequenceComplete_In)},
 
     {TPM_CC_Certify, "TPM2_Certify",
      (MarshalInFunction_t)TSS_Certify_In_Marshal,
      (UnmarshalOutFunction_t)TSS_Certify_Out_Unmarshal,
-     (UnmarshalInFunction_t)Certify_In_Unmarshal},
+     (UnmarshalInFunction_t)Certify_In_Unmarshal,
+     sizeof(Certify_In)},
 
     {TPM_CC_CertifyCreation, "TPM2_CertifyCreation",
      (MarshalInFunction_t)TSS_CertifyCreation_In_Marshal,
      (UnmarshalOutFunction_t)TSS_CertifyCreation_Out_Unmarshal,
-     (UnmarshalInFunction_t)CertifyCreation_In_Unmarshal},
+     (UnmarshalInFunction_t)CertifyCreation_In_Unmarshal,
+     sizeof(CertifyCreation_In)},
 
     {TPM_CC_Quote, "TPM2_Quote",
      (MarshalInFunction_t)TSS_Quote_In_Marshal,
      (UnmarshalOutFunction_t)TSS_Quote_Out_Unmarshal,
-     (UnmarshalInFunction_t)Quote_In_Unmarshal},
+     (UnmarshalInFunction_t)Quote_In_Unmarshal,
+     sizeof(Quote_In)},
 
     {TPM_CC_GetSessionAuditDigest, "TPM2_GetSessionAuditDigest",
      (MarshalInFunction_t)TSS_GetSessionAuditDigest_In_Marshal,
      (UnmarshalOutFunction_t)TSS_GetSessionAuditDigest_Out_Unmarshal,
-     (UnmarshalInFunction_t)GetSessionAuditDigest_In_Unmarshal},
+     (UnmarshalInFunction_t)GetSessionAuditDigest_In_Unmarshal,
+     sizeof(GetSessionAuditDigest_In)},
 
     {TPM_CC_GetCommandAuditDigest, "TPM2_GetCommandAuditDigest",
      (MarshalInFunction_t)TSS_GetCommandAuditDigest_In_Marshal,
      (UnmarshalOutFunction_t)TSS_GetCommandAuditDigest_Out_Unmarshal,
-     (UnmarshalInFunction_t)GetCommandAuditDigest_In_Unmarshal},
+     (UnmarshalInFunction_t)GetCommandAuditDigest_In_Unmarshal,
+     sizeof(GetCommandAuditDigest_In)},
 
     {TPM_CC_GetTime, "TPM2_GetTime",
      (MarshalInFunction_t)TSS_GetTime_In_Marshal,
      (UnmarshalOutFunction_t)TSS_GetTime_Out_Unmarshal,
-     (UnmarshalInFunction_t)GetTime_In_Unmarshal},
+     (UnmarshalInFunction_t)GetTime_In_Unmarshal,
+     sizeof(GetTime_In)},
 
     {TPM_CC_Commit, "TPM2_Commit",
      (MarshalInFunction_t)TSS_Commit_In_Marshal,
      (UnmarshalOutFunction_t)TSS_Commit_Out_Unmarshal,
-     (UnmarshalInFunction_t)Commit_In_Unmarshal},
+     (UnmarshalInFunction_t)Commit_In_Unmarshal,
+     sizeof(Commit_In)},
 
     {TPM_CC_EC_Ephemeral, "TPM2_EC_Ephemeral",
      (MarshalInFunction_t)TSS_EC_Ephemeral_In_Marshal,
      (UnmarshalOutFunction_t)TSS_EC_Ephemeral_Out_Unmarshal,
-     (UnmarshalInFunction_t)EC_Ephemeral_In_Unmarshal},
+     (UnmarshalInFunction_t)EC_Ephemeral_In_Unmarshal,
+     sizeof(EC_Ephemeral_In)},
 
     {TPM_CC_VerifySignature, "TPM2_VerifySignature",
      (MarshalInFunction_t)TSS_VerifySignature_In_Marshal,
      (UnmarshalOutFunction_t)TSS_VerifySignature_Out_Unmarshal,
-     (UnmarshalInFunction_t)VerifySignature_In_Unmarshal},
+     (UnmarshalInFunction_t)VerifySignature_In_Unmarshal,
+     sizeof(VerifySignature_In)},
 
     {TPM_CC_Sign, "TPM2_Sign",
      (MarshalInFunction_t)TSS_Sign_In_Marshal,
      (UnmarshalOutFunction_t)TSS_Sign_Out_Unmarshal,
-     (UnmarshalInFunction_t)Sign_In_Unmarshal},
+     (UnmarshalInFunction_t)Sign_In_Unmarshal,
+     sizeof(Sign_In)},
 
     {TPM_CC_SetCommandCodeAuditStatus, "TPM2_SetCommandCodeAuditStatus",
      (MarshalInFunction_t)TSS_SetCommandCodeAuditStatus_In_Marshal,
      NULL,
-     (UnmarshalInFunction_t)SetCommandCodeAuditStatus_In_Unmarshal},
+     (UnmarshalInFunction_t)SetCommandCodeAuditStatus_In_Unmarshal,
+     sizeof(SetCommandCodeAuditStatus_In)},
 
     {TPM_CC_PCR_Extend, "TPM2_PCR_Extend",
      (MarshalInFunction_t)TSS_PCR_Extend_In_Marshal,
      NULL,
-     (UnmarshalInFunction_t)PCR_Extend_In_Unmarshal},
+     (UnmarshalInFunction_t)PCR_Extend_In_Unmarshal,
+     sizeof(PCR_Extend_In)},
 
     {TPM_CC_PCR_Event, "TPM2_PCR_Event",
      (MarshalInFunction_t)TSS_PCR_Event_In_Marshal,
      (UnmarshalOutFunction_t)TSS_PCR_Event_Out_Unmarshal,
-     (UnmarshalInFunction_t)PCR_Event_In_Unmarshal},
+     (UnmarshalInFunction_t)PCR_Event_In_Unmarshal,
+     sizeof(PCR_Event_In)},
 
     {TPM_CC_PCR_Read, "TPM2_PCR_Read",
      (MarshalInFunction_t)TSS_PCR_Read_In_Marshal,
      (UnmarshalOutFunction_t)TSS_PCR_Read_Out_Unmarshal,
-     (UnmarshalInFunction_t)PCR_Read_In_Unmarshal},
+     (UnmarshalInFunction_t)PCR_Read_In_Unmarshal,
+     sizeof(PCR_Read_In)},
 
     {TPM_CC_PCR_Allocate, "TPM2_PCR_Allocate",
      (MarshalInFunction_t)TSS_PCR_Allocate_In_Marshal,
      (UnmarshalOutFunction_t)TSS_PCR_Allocate_Out_Unmarshal,
-     (UnmarshalInFunction_t)PCR_Allocate_In_Unmarshal},
+     (UnmarshalInFunction_t)PCR_Allocate_In_Unmarshal,
+     sizeof(PCR_Allocate_In)},
 
     {TPM_CC_PCR_SetAuthPolicy, "TPM2_PCR_SetAuthPolicy",
      (MarshalInFunction_t)TSS_PCR_SetAuthPolicy_In_Marshal,
      NULL,
-     (UnmarshalInFunction_t)PCR_SetAuthPolicy_In_Unmarshal},
+     (UnmarshalInFunction_t)PCR_SetAuthPolicy_In_Unmarshal,
+     sizeof(PCR_SetAuthPolicy_In)},
 
     {TPM_CC_PCR_SetAuthValue, "TPM2_PCR_SetAuthValue",
      (MarshalInFunction_t)TSS_PCR_SetAuthValue_In_Marshal,
      NULL,
-     (UnmarshalInFunction_t)PCR_SetAuthValue_In_Unmarshal},
+     (UnmarshalInFunction_t)PCR_SetAuthValue_In_Unmarshal,
+     sizeof(PCR_SetAuthValue_In)},
 
     {TPM_CC_PCR_Reset, "TPM2_PCR_Reset",
      (MarshalInFunction_t)TSS_PCR_Reset_In_Marshal,
      NULL,
-     (UnmarshalInFunction_t)PCR_Reset_In_Unmarshal},
+     (UnmarshalInFunction_t)PCR_Reset_In_Unmarshal,
+     sizeof(PCR_Reset_In)},
 
     {TPM_CC_PolicySigned, "TPM2_PolicySigned",
      (MarshalInFunction_t)TSS_PolicySigned_In_Marshal,
      (UnmarshalOutFunction_t)TSS_PolicySigned_Out_Unmarshal,
-     (UnmarshalInFunction_t)PolicySigned_In_Unmarshal},
+     (UnmarshalInFunction_t)PolicySigned_In_Unmarshal,
+     sizeof(PolicySigned_In)},
 
     {TPM_CC_PolicySecret, "TPM2_PolicySecret",
      (MarshalInFunction_t)TSS_PolicySecret_In_Marshal,
      (UnmarshalOutFunction_t)TSS_PolicySecret_Out_Unmarshal,
-     (UnmarshalInFunction_t)PolicySecret_In_Unmarshal},
+     (UnmarshalInFunction_t)PolicySecret_In_Unmarshal,
+     sizeof(PolicySecret_In)},
 
     {TPM_CC_PolicyTicket, "TPM2_PolicyTicket",
      (MarshalInFunction_t)TSS_PolicyTicket_In_Marshal,
      NULL,
-     (UnmarshalInFunction_t)PolicyTicket_In_Unmarshal},
+     (UnmarshalInFunction_t)PolicyTicket_In_Unmarshal,
+     sizeof(PolicyTicket_In)},
 
     {TPM_CC_PolicyOR, "TPM2_PolicyOR",
      (MarshalInFunction_t)TSS_PolicyOR_In_Marshal,
      NULL,
-     (UnmarshalInFunction_t)PolicyOR_In_Unmarshal},
+     (UnmarshalInFunction_t)PolicyOR_In_Unmarshal,
+     sizeof(PolicyOR_In)},
 
     {TPM_CC_PolicyPCR, "TPM2_PolicyPCR",
      (MarshalInFunction_t)TSS_PolicyPCR_In_Marshal,
      NULL,
-     (UnmarshalInFunction_t)PolicyPCR_In_Unmarshal},
+     (UnmarshalInFunction_t)PolicyPCR_In_Unmarshal,
+     sizeof(PolicyPCR_In)},
 
     {TPM_CC_PolicyLocality, "TPM2_PolicyLocality",
      (MarshalInFunction_t)TSS_PolicyLocality_In_Marshal,
      NULL,
-     (UnmarshalInFunction_t)PolicyLocality_In_Unmarshal},
+     (UnmarshalInFunction_t)PolicyLocality_In_Unmarshal,
+     sizeof(PolicyLocality_In)},
 
     {TPM_CC_PolicyNV, "TPM2_PolicyNV",
      (MarshalInFunction_t)TSS_PolicyNV_In_Marshal,
      NULL,
-     (UnmarshalInFunction_t)PolicyNV_In_Unmarshal},
+     (UnmarshalInFunction_t)PolicyNV_In_Unmarshal,
+     sizeof(PolicyNV_In)},
 
     {TPM_CC_PolicyAuthorizeNV, "TPM2_PolicyAuthorizeNV",
      (MarshalInFunction_t)TSS_PolicyAuthorizeNV_In_Marshal,
      NULL,
-     (UnmarshalInFunction_t)PolicyAuthorizeNV_In_Unmarshal},
+     (UnmarshalInFunction_t)PolicyAuthorizeNV_In_Unmarshal,
+     sizeof(PolicyAuthorizeNV_In)},
 
     {TPM_CC_PolicyCounterTimer, "TPM2_PolicyCounterTimer",
      (MarshalInFunction_t)TSS_PolicyCounterTimer_In_Marshal,
      NULL,
-     (UnmarshalInFunction_t)PolicyCounterTimer_In_Unmarshal},
+     (UnmarshalInFunction_t)PolicyCounterTimer_In_Unmarshal,
+     sizeof(PolicyCounterTimer_In)},
 
     {TPM_CC_PolicyCommandCode, "TPM2_PolicyCommandCode",
      (MarshalInFunction_t)TSS_PolicyCommandCode_In_Marshal,
      NULL,
-     (UnmarshalInFunction_t)PolicyCommandCode_In_Unmarshal},
+     (UnmarshalInFunction_t)PolicyCommandCode_In_Unmarshal,
+     sizeof(PolicyCommandCode_In)},
 
     {TPM_CC_PolicyPhysicalPresence, "TPM2_PolicyPhysicalPresence",
      (MarshalInFunction_t)TSS_PolicyPhysicalPresence_In_Marshal,
      NULL,
-     (UnmarshalInFunction_t)PolicyPhysicalPresence_In_Unmarshal},
+     (UnmarshalInFunction_t)PolicyPhysicalPresence_In_Unmarshal,
+     sizeof(PolicyPhysicalPresence_In)},
 
     {TPM_CC_PolicyCpHash, "TPM2_PolicyCpHash",
      (MarshalInFunction_t)TSS_PolicyCpHash_In_Marshal,
      NULL,
-     (UnmarshalInFunction_t)PolicyCpHash_In_Unmarshal},
+     (UnmarshalInFunction_t)PolicyCpHash_In_Unmarshal,
+     sizeof(PolicyCpHash_In)},
 
     {TPM_CC_PolicyNameHash, "TPM2_PolicyNameHash",
      (MarshalInFunction_t)TSS_PolicyNameHash_In_Marshal,
      NULL,
-     (UnmarshalInFunction_t)PolicyNameHash_In_Unmarshal},
+     (UnmarshalInFunction_t)PolicyNameHash_In_Unmarshal,
+     sizeof(PolicyNameHash_In)},
 
     {TPM_CC_PolicyDuplicationSelect, "TPM2_PolicyDuplicationSelect",
      (MarshalInFunction_t)TSS_PolicyDuplicationSelect_In_Marshal,
      NULL,
-     (UnmarshalInFunction_t)PolicyDuplicationSelect_In_Unmarshal},
+     (UnmarshalInFunction_t)PolicyDuplicationSelect_In_Unmarshal,
+     sizeof(PolicyDuplicationSelect_In)},
 
     {TPM_CC_PolicyAuthorize, "TPM2_PolicyAuthorize",
      (MarshalInFunction_t)TSS_PolicyAuthorize_In_Marshal,
      NULL,
-     (UnmarshalInFunction_t)PolicyAuthorize_In_Unmarshal},
+     (UnmarshalInFunction_t)PolicyAuthorize_In_Unmarshal,
+     sizeof(PolicyAuthorize_In)},
 
     {TPM_CC_PolicyAuthValue, "TPM2_PolicyAuthValue",
      (MarshalInFunction_t)TSS_PolicyAuthValue_In_Marshal,
      NULL,
-     (UnmarshalInFunction_t)PolicyAuthValue_In_Unmarshal},
+     (UnmarshalInFunction_t)PolicyAuthValue_In_Unmarshal,
+     sizeof(PolicyAuthValue_In)},
 
     {TPM_CC_PolicyPassword, "TPM2_PolicyPassword",
      (MarshalInFunction_t)TSS_PolicyPassword_In_Marshal,
      NULL,
-     (UnmarshalInFunction_t)PolicyPassword_In_Unmarshal},
+     (UnmarshalInFunction_t)PolicyPassword_In_Unmarshal,
+     sizeof(PolicyPassword_In)},
 
     {TPM_CC_PolicyGetDigest, "TPM2_PolicyGetDigest",
      (MarshalInFunction_t)TSS_PolicyGetDigest_In_Marshal,
      (UnmarshalOutFunction_t)TSS_PolicyGetDigest_Out_Unmarshal,
-     (UnmarshalInFunction_t)PolicyGetDigest_In_Unmarshal},
+     (UnmarshalInFunction_t)PolicyGetDigest_In_Unmarshal,
+     sizeof(PolicyGetDigest_In)},
 
     {TPM_CC_PolicyNvWritten, "TPM2_PolicyNvWritten",
      (MarshalInFunction_t)TSS_PolicyNvWritten_In_Marshal,
      NULL,
-     (UnmarshalInFunction_t)PolicyNvWritten_In_Unmarshal},
+     (UnmarshalInFunction_t)PolicyNvWritten_In_Unmarshal,
+     sizeof(PolicyNvWritten_In)},
 
     {TPM_CC_PolicyTemplate, "TPM2_PolicyTemplate",
      (MarshalInFunction_t)TSS_PolicyTemplate_In_Marshal,
      NULL,
-     (UnmarshalInFunction_t)PolicyTemplate_In_Unmarshal},
+     (UnmarshalInFunction_t)PolicyTemplate_In_Unmarshal,
+     sizeof(PolicyTemplate_In)},
 
     {TPM_CC_CreatePrimary, "TPM2_CreatePrimary",
      (MarshalInFunction_t)TSS_CreatePrimary_In_Marshal,
      (UnmarshalOutFunction_t)TSS_CreatePrimary_Out_Unmarshal,
-     (UnmarshalInFunction_t)CreatePrimary_In_Unmarshal},
+     (UnmarshalInFunction_t)CreatePrimary_In_Unmarshal,
+     sizeof(CreatePrimary_In)},
 
     {TPM_CC_HierarchyControl, "TPM2_HierarchyControl",
      (MarshalInFunction_t)TSS_HierarchyControl_In_Marshal,
      NULL,
-     (UnmarshalInFunction_t)HierarchyControl_In_Unmarshal},
+     (UnmarshalInFunction_t)HierarchyControl_In_Unmarshal,
+     sizeof(HierarchyControl_In)},
 
     {TPM_CC_SetPrimaryPolicy, "TPM2_SetPrimaryPolicy",
      (MarshalInFunction_t)TSS_SetPrimaryPolicy_In_Marshal,
      NULL,
-     (UnmarshalInFunction_t)SetPrimaryPolicy_In_Unmarshal},
+     (UnmarshalInFunction_t)SetPrimaryPolicy_In_Unmarshal,
+     sizeof(SetPrimaryPolicy_In)},
 
     {TPM_CC_ChangePPS, "TPM2_ChangePPS",
      (MarshalInFunction_t)TSS_ChangePPS_In_Marshal,
      NULL,
-     (UnmarshalInFunction_t)ChangePPS_In_Unmarshal},
+     (UnmarshalInFunction_t)ChangePPS_In_Unmarshal,
+     sizeof(ChangePPS_In)},
 
     {TPM_CC_ChangeEPS, "TPM2_ChangeEPS",
      (MarshalInFunction_t)TSS_ChangeEPS_In_Marshal,
      NULL,
-     (UnmarshalInFunction_t)ChangeEPS_In_Unmarshal},
+     (UnmarshalInFunction_t)ChangeEPS_In_Unmarshal,
+     sizeof(ChangeEPS_In)},
 
     {TPM_CC_Clear, "TPM2_Clear",
      (MarshalInFunction_t)TSS_Clear_In_Marshal,
      NULL,
-     (UnmarshalInFunction_t)Clear_In_Unmarshal},
+     (UnmarshalInFunction_t)Clear_In_Unmarshal,
+     sizeof(Clear_In)},
 
     {TPM_CC_ClearControl, "TPM2_ClearControl",
      (MarshalInFunction_t)TSS_ClearControl_In_Marshal,
      NULL,
-     (UnmarshalInFunction_t)ClearControl_In_Unmarshal},
+     (UnmarshalInFunction_t)ClearControl_In_Unmarshal,
+     sizeof(ClearControl_In)},
 
     {TPM_CC_HierarchyChangeAuth, "TPM2_HierarchyChangeAuth",
      (MarshalInFunction_t)TSS_HierarchyChangeAuth_In_Marshal,
      NULL,
-     (UnmarshalInFunction_t)HierarchyChangeAuth_In_Unmarshal},
+     (UnmarshalInFunction_t)HierarchyChangeAuth_In_Unmarshal,
+     sizeof(HierarchyChangeAuth_In)},
 
     {TPM_CC_DictionaryAttackLockReset, "TPM2_DictionaryAttackLockReset",
      (MarshalInFunction_t)TSS_DictionaryAttackLockReset_In_Marshal,
      NULL,
-     (UnmarshalInFunction_t)DictionaryAttackLockReset_In_Unmarshal},
+     (UnmarshalInFunction_t)DictionaryAttackLockReset_In_Unmarshal,
+     sizeof(DictionaryAttackLockReset_In)},
 
     {TPM_CC_DictionaryAttackParameters, "TPM2_DictionaryAttackParameters",
      (MarshalInFunction_t)TSS_DictionaryAttackParameters_In_Marshal,
      NULL,
-     (UnmarshalInFunction_t)DictionaryAttackParameters_In_Unmarshal},
+     (UnmarshalInFunction_t)DictionaryAttackParameters_In_Unmarshal,
+     sizeof(DictionaryAttackParameters_In)},
 
     {TPM_CC_PP_Commands, "TPM2_PP_Commands",
      (MarshalInFunction_t)TSS_PP_Commands_In_Marshal,
      NULL,
-     (UnmarshalInFunction_t)PP_Commands_In_Unmarshal},
+     (UnmarshalInFunction_t)PP_Commands_In_Unmarshal,
+     sizeof(PP_Commands_In)},
 
     {TPM_CC_SetAlgorithmSet, "TPM2_SetAlgorithmSet",
      (MarshalInFunction_t)TSS_SetAlgorithmSet_In_Marshal,
      NULL,
-     (UnmarshalInFunction_t)SetAlgorithmSet_In_Unmarshal},
+     (UnmarshalInFunction_t)SetAlgorithmSet_In_Unmarshal,
+     sizeof(SetAlgorithmSet_In)},
 
     {TPM_CC_ContextSave, "TPM2_ContextSave",
      (MarshalInFunction_t)TSS_ContextSave_In_Marshal,
      (UnmarshalOutFunction_t)TSS_ContextSave_Out_Unmarshal,
-     (UnmarshalInFunction_t)ContextSave_In_Unmarshal},
+     (UnmarshalInFunction_t)ContextSave_In_Unmarshal,
+     sizeof(ContextSave_In)},
 
     {TPM_CC_ContextLoad, "TPM2_ContextLoad",
      (MarshalInFunction_t)TSS_ContextLoad_In_Marshal,
      (UnmarshalOutFunction_t)TSS_ContextLoad_Out_Unmarshal,
-     (UnmarshalInFunction_t)ContextLoad_In_Unmarshal},
+     (UnmarshalInFunction_t)ContextLoad_In_Unmarshal,
+     sizeof(ContextLoad_In)},
 
     {TPM_CC_FlushContext, "TPM2_FlushContext",
      (MarshalInFunction_t)TSS_FlushContext_In_Marshal,
      NULL,
-     (UnmarshalInFunction_t)FlushContext_In_Unmarshal},
+     (UnmarshalInFunction_t)FlushContext_In_Unmarshal,
+     sizeof(FlushContext_In)},
 
     {TPM_CC_EvictControl, "TPM2_EvictControl",
      (MarshalInFunction_t)TSS_EvictControl_In_Marshal,
      NULL,
-     (UnmarshalInFunction_t)EvictControl_In_Unmarshal},
+     (UnmarshalInFunction_t)EvictControl_In_Unmarshal,
+     sizeof(EvictControl_In)},
 
     {TPM_CC_ReadClock, "TPM2_ReadClock",
      NULL,
      (UnmarshalOutFunction_t)TSS_ReadClock_Out_Unmarshal,
-     NULL},
+     NULL,
+     0},
 
     {TPM_CC_ClockSet, "TPM2_ClockSet",
      (MarshalInFunction_t)TSS_ClockSet_In_Marshal,
      NULL,
-     (UnmarshalInFunction_t)ClockSet_In_Unmarshal},
+     (UnmarshalInFunction_t)ClockSet_In_Unmarshal,
+     sizeof(ClockSet_In)},
 
     {TPM_CC_ClockRateAdjust, "TPM2_ClockRateAdjust",
      (MarshalInFunction_t)TSS_ClockRateAdjust_In_Marshal,
      NULL,
-     (UnmarshalInFunction_t)ClockRateAdjust_In_Unmarshal},
+     (UnmarshalInFunction_t)ClockRateAdjust_In_Unmarshal,
+     sizeof(ClockRateAdjust_In)},
     
     {TPM_CC_GetCapability, "TPM2_GetCapability",
      (MarshalInFunction_t)TSS_GetCapability_In_Marshal,
      (UnmarshalOutFunction_t)TSS_GetCapability_Out_Unmarshal,
-     (UnmarshalInFunction_t)GetCapability_In_Unmarshal},
+     (UnmarshalInFunction_t)GetCapability_In_Unmarshal,
+     sizeof(GetCapability_In)},
     
     {TPM_CC_TestParms, "TPM2_TestParms",
      (MarshalInFunction_t)TSS_TestParms_In_Marshal,
      NULL,
-     (UnmarshalInFunction_t)TestParms_In_Unmarshal},
+     (UnmarshalInFunction_t)TestParms_In_Unmarshal,
+     sizeof(TestParms_In)},
 
     {TPM_CC_NV_DefineSpace, "TPM2_NV_DefineSpace",
      (MarshalInFunction_t)TSS_NV_DefineSpace_In_Marshal,
      NULL,
-     (UnmarshalInFunction_t)NV_DefineSpace_In_Unmarshal},
+     (UnmarshalInFunction_t)NV_DefineSpace_In_Unmarshal,
+     sizeof(NV_DefineSpace_In)},
 
     {TPM_CC_NV_UndefineSpace, "TPM2_NV_UndefineSpace",
      (MarshalInFunction_t)TSS_NV_UndefineSpace_In_Marshal,
      NULL,
-     (UnmarshalInFunction_t)NV_UndefineSpace_In_Unmarshal},
+     (UnmarshalInFunction_t)NV_UndefineSpace_In_Unmarshal,
+     sizeof(NV_UndefineSpace_In)},
 
     {TPM_CC_NV_UndefineSpaceSpecial, "TPM2_NV_UndefineSpaceSpecial",
      (MarshalInFunction_t)TSS_NV_UndefineSpaceSpecial_In_Marshal,
      NULL,
-     (UnmarshalInFunction_t)NV_UndefineSpaceSpecial_In_Unmarshal},
+     (UnmarshalInFunction_t)NV_UndefineSpaceSpecial_In_Unmarshal,
+     sizeof(NV_UndefineSpaceSpecial_In)},
 
     {TPM_CC_NV_ReadPublic, "TPM2_NV_ReadPublic",
      (MarshalInFunction_t)TSS_NV_ReadPublic_In_Marshal,
      (UnmarshalOutFunction_t)TSS_NV_ReadPublic_Out_Unmarshal,
-     (UnmarshalInFunction_t)NV_ReadPublic_In_Unmarshal},
+     (UnmarshalInFunction_t)NV_ReadPublic_In_Unmarshal,
+     sizeof(NV_ReadPublic_In)},
 
     {TPM_CC_NV_Write, "TPM2_NV_Write",
      (MarshalInFunction_t)TSS_NV_Write_In_Marshal,
      NULL,
-     (UnmarshalInFunction_t)NV_Write_In_Unmarshal},
+     (UnmarshalInFunction_t)NV_Write_In_Unmarshal,
+     sizeof(NV_Write_In)},
 
     {TPM_CC_NV_Increment, "TPM2_NV_Increment",
      (MarshalInFunction_t)TSS_NV_Increment_In_Marshal,
      NULL,
-     (UnmarshalInFunction_t)NV_Increment_In_Unmarshal},
+     (UnmarshalInFunction_t)NV_Increment_In_Unmarshal,
+     sizeof(NV_Increment_In)},
 
     {TPM_CC_NV_Extend, "TPM2_NV_Extend",
      (MarshalInFunction_t)TSS_NV_Extend_In_Marshal,
      NULL,
-     (UnmarshalInFunction_t)NV_Extend_In_Unmarshal},
+     (UnmarshalInFunction_t)NV_Extend_In_Unmarshal,
+     sizeof(NV_Extend_In)},
 
     {TPM_CC_NV_SetBits, "TPM2_NV_SetBits",
      (MarshalInFunction_t)TSS_NV_SetBits_In_Marshal,
      NULL,
-     (UnmarshalInFunction_t)NV_SetBits_In_Unmarshal},
+     (UnmarshalInFunction_t)NV_SetBits_In_Unmarshal,
+     sizeof(NV_SetBits_In)},
 
     {TPM_CC_NV_WriteLock, "TPM2_NV_WriteLock",
      (MarshalInFunction_t)TSS_NV_WriteLock_In_Marshal,
      NULL,
-     (UnmarshalInFunction_t)NV_WriteLock_In_Unmarshal},
+     (UnmarshalInFunction_t)NV_WriteLock_In_Unmarshal,
+     sizeof(NV_WriteLock_In)},
 
     {TPM_CC_NV_GlobalWriteLock, "TPM2_NV_GlobalWriteLock",
      (MarshalInFunction_t)TSS_NV_GlobalWriteLock_In_Marshal,
      NULL,
-     (UnmarshalInFunction_t)NV_GlobalWriteLock_In_Unmarshal},
+     (UnmarshalInFunction_t)NV_GlobalWriteLock_In_Unmarshal,
+     sizeof(NV_GlobalWriteLock_In)},
 
     {TPM_CC_NV_Read, "TPM2_NV_Read",
      (MarshalInFunction_t)TSS_NV_Read_In_Marshal,
      (UnmarshalOutFunction_t)TSS_NV_Read_Out_Unmarshal,
-     (UnmarshalInFunction_t)NV_Read_In_Unmarshal},
+     (UnmarshalInFunction_t)NV_Read_In_Unmarshal,
+     sizeof(NV_Read_In)},
 
     {TPM_CC_NV_ReadLock, "TPM2_NV_ReadLock",
      (MarshalInFunction_t)TSS_NV_ReadLock_In_Marshal,
      NULL,
-     (UnmarshalInFunction_t)NV_ReadLock_In_Unmarshal},
+     (UnmarshalInFunction_t)NV_ReadLock_In_Unmarshal,
+     sizeof(NV_ReadLock_In)},
 
     {TPM_CC_NV_ChangeAuth, "TPM2_NV_ChangeAuth",
      (MarshalInFunction_t)TSS_NV_ChangeAuth_In_Marshal,
      NULL,
-     (UnmarshalInFunction_t)NV_ChangeAuth_In_Unmarshal},
+     (UnmarshalInFunction_t)NV_ChangeAuth_In_Unmarshal,
+     sizeof(NV_ChangeAuth_In)},
 
     {TPM_CC_NV_Certify, "TPM2_NV_Certify",
      (MarshalInFunction_t)TSS_NV_Certify_In_Marshal,
      (UnmarshalOutFunction_t)TSS_NV_Certify_Out_Unmarshal,
-     (UnmarshalInFunction_t)NV_Certify_In_Unmarshal}
+     (UnmarshalInFunction_t)NV_Certify_In_Unmarshal,
+     sizeof(NV_Certify_In)}
 
 #ifdef TPM_NUVOTON
     ,
@@ -642,17 +763,20 @@ static const MARSHAL_TABLE marshalTable [] = {
     {NTC2_CC_PreConfig,"NTC2_CC_PreConfig",
      (MarshalInFunction_t)TSS_NTC2_PreConfig_In_Marshal,
      NULL,
-     (UnmarshalInFunction_t)NTC2_PreConfig_In_Unmarshal},
+     (UnmarshalInFunction_t)NTC2_PreConfig_In_Unmarshal,
+     sizeof(NTC2_PreConfig_In)},
      
     {NTC2_CC_LockPreConfig,"NTC2_CC_LockPreConfig",
      NULL,
      NULL,
-     NULL},
+     NULL,
+     0},
 
     {NTC2_CC_GetConfig,"NTC2_CC_GetConfig",
      NULL,
      (UnmarshalOutFunction_t)TSS_NTC2_GetConfig_Out_Unmarshal,
-     NULL}
+     NULL,
+     0}
 
 #endif
 };
@@ -677,8 +801,14 @@ struct TSS_AUTH_CONTEXT {
     MarshalInFunction_t    marshalInFunction;
     UnmarshalOutFunction_t unmarshalOutFunction;
     UnmarshalInFunction_t  unmarshalInFunction;
+    size_t		inSize;
 } ;
 
+/* local prototypes */
+
+static void TSS_RetrySleep(unsigned int msec);
+static TPM_RC TSS_Marshal_Validate(TSS_AUTH_CONTEXT *tssAuthContext,
+				   uint8_t *bufferu);
 
 static TPM_RC TSS_MarshalTable_Process(TSS_AUTH_CONTEXT *tssAuthContext,
 				       TPM_CC commandCode)
@@ -700,6 +830,7 @@ static TPM_RC TSS_MarshalTable_Process(TSS_AUTH_CONTEXT *tssAuthContext,
 	tssAuthContext->marshalInFunction = marshalTable[index].marshalInFunction;
 	tssAuthContext->unmarshalOutFunction = marshalTable[index].unmarshalOutFunction;
 	tssAuthContext->unmarshalInFunction = marshalTable[index].unmarshalInFunction;
+	tssAuthContext->inSize = marshalTable[index].inSize;
     }
     else {
 	if (tssVerbose) printf("TSS_MarshalTable_Process: commandCode %08x not found\n", commandCode);
@@ -708,6 +839,143 @@ static TPM_RC TSS_MarshalTable_Process(TSS_AUTH_CONTEXT *tssAuthContext,
     return rc;
 }
 
+/* TSS_MarshalTable_Entry() returns the command code, text, and number of command handles for
+   entry 'index' of the marshal table.  It returns TSS_RC_COMMAND_UNIMPLEMENTED past the end, so
+   callers iterate from 0 until an error.
+
+   The TSS_MarshalTable_*() functions let benchmarks and fuzzers reach every command's marshal and
+   unmarshal functions without a TPM.
+*/
+
+TPM_RC TSS_MarshalTable_Entry(size_t index,
+			      TPM_CC *commandCode,
+			      const char **commandText,
+			      uint32_t *commandHandleCount)
+{
+    TPM_RC 		rc = 0;
+    COMMAND_INDEX	tpmCommandIndex;
+
+    if (index >= (sizeof(marshalTable) / sizeof(MARSHAL_TABLE))) {
+	rc = TSS_RC_COMMAND_UNIMPLEMENTED;
+    }
+    if (rc == 0) {
+	*commandCode = marshalTable[index].commandCode;
+	*commandText = marshalTable[index].commandText;
+	tpmCommandIndex = CommandCodeToCommandIndex(*commandCode);
+	if (tpmCommandIndex == UNIMPLEMENTED_COMMAND_INDEX) {
+	    rc = TSS_RC_COMMAND_UNIMPLEMENTED;
+	}
+    }
+    if (rc == 0) {
+	*commandHandleCount = getCommandHandleCount(tpmCommandIndex);
+    }
+    return rc;
+}
+
+/* TSS_MarshalTable_Lookup() returns the marshal table entry for the command code */
+
+static TPM_RC TSS_MarshalTable_Lookup(const MARSHAL_TABLE **entry,
+				      TPM_CC commandCode)
+{
+    TPM_RC rc = TSS_RC_COMMAND_UNIMPLEMENTED;
+    size_t index;
+
+    for (index = 0 ; index < (sizeof(marshalTable) / sizeof(MARSHAL_TABLE)) ; index++) {
+	if (marshalTable[index].commandCode == commandCode) {
+	    *entry = &marshalTable[index];
+	    rc = 0;
+	    break;
+	}
+    }
+    return rc;
+}
+
+/* TSS_MarshalTable_InMarshal() marshals the command parameters, including the handles.
+
+   Returns TSS_RC_NOT_IMPLEMENTED if the command has no parameters.
+*/
+
+TPM_RC TSS_MarshalTable_InMarshal(TPM_CC commandCode,
+				  COMMAND_PARAMETERS *in,
+				  UINT16 *written,
+				  BYTE **buffer,
+				  INT32 *size)
+{
+    TPM_RC 		rc = 0;
+    const MARSHAL_TABLE	*entry = NULL;
+
+    if (rc == 0) {
+	rc = TSS_MarshalTable_Lookup(&entry, commandCode);
+    }
+    if (rc == 0) {
+	if (entry->marshalInFunction != NULL) {
+	    rc = entry->marshalInFunction(in, written, buffer, size);
+	}
+	else {
+	    rc = TSS_RC_NOT_IMPLEMENTED;
+	}
+    }
+    return rc;
+}
+
+/* TSS_MarshalTable_InUnmarshal() unmarshals the command parameters after the handles and
+   authorization area, the TSS command parameter check.
+
+   Returns TSS_RC_NOT_IMPLEMENTED if the command has no parameters.
+*/
+
+TPM_RC TSS_MarshalTable_InUnmarshal(TPM_CC commandCode,
+				    COMMAND_PARAMETERS *in,
+				    BYTE **buffer,
+				    INT32 *size,
+				    TPM_HANDLE handles[])
+{
+    TPM_RC 		rc = 0;
+    const MARSHAL_TABLE	*entry = NULL;
+
+    if (rc == 0) {
+	rc = TSS_MarshalTable_Lookup(&entry, commandCode);
+    }
+    if (rc == 0) {
+	if (entry->unmarshalInFunction != NULL) {
+	    rc = entry->unmarshalInFunction(in, buffer, size, handles);
+	}
+	else {
+	    rc = TSS_RC_NOT_IMPLEMENTED;
+	}
+    }
+    return rc;
+}
+
+/* TSS_MarshalTable_OutUnmarshal() unmarshals the response after the header, starting at the
+   response handles, the same as TSS_Unmarshal().  'tag' is the response tag.
+
+   Returns TSS_RC_NOT_IMPLEMENTED if the command has no response handles or parameters.
+*/
+
+TPM_RC TSS_MarshalTable_OutUnmarshal(TPM_CC commandCode,
+				     RESPONSE_PARAMETERS *out,
+				     TPM_ST tag,
+				     BYTE **buffer,
+				     INT32 *size)
+{
+    TPM_RC 		rc = 0;
+    const MARSHAL_TABLE	*entry = NULL;
+
+    if (rc == 0) {
+	rc = TSS_MarshalTable_Lookup(&entry, commandCode);
+    }
+    if (rc == 0) {
+	if (entry->unmarshalOutFunction != NULL) {
+	    rc = entry->unmarshalOutFunction(out, tag, buffer, size);
+	}
+	else {
+	    rc = TSS_RC_NOT_IMPLEMENTED;
+	}
+    }
+    return rc;
+}
+
 TPM_RC TSS_AuthCreate(TSS_AUTH_CONTEXT **tssAuthContext)
 {
     TPM_RC rc = 0;
@@ -737,6 +1005,7 @@ void TSS_InitAuthContext(TSS_AUTH_CONTEXT *tssAuthContext)
     tssAuthContext->marshalInFunction = NULL;
     tssAuthContext->unmarshalOutFunction = NULL;
     tssAuthContext->unmarshalInFunction = NULL;
+    tssAuthContext->inSize = 0;
 }
 
 TPM_RC TSS_AuthDelete(TSS_AUTH_CONTEXT *tssAuthContext)
@@ -748,6 +1017,42 @@ TPM_RC TSS_AuthDelete(TSS_AUTH_CONTEXT *tssAuthContext)
     return 0;
 }
 
+/* TSS_Marshal_Validate() unmarshals the command parameters at 'bufferu' to check them before
+   sending the command.
+
+   The scratch target is sized for this command's _In structure, not the COMMAND_PARAMETERS union.
+   Most fit in the aligned stack buffer, the rest are allocated.  There is no shared state, so
+   threads with their own TSS_CONTEXT can marshal concurrently.
+*/
+
+static TPM_RC TSS_Marshal_Validate(TSS_AUTH_CONTEXT *tssAuthContext,
+				   uint8_t *bufferu)
+{
+    TPM_RC 		rc = 0;
+    union {
+	uint64_t	align;
+	uint8_t		buffer[TSS_VALIDATE_STACK];
+    } scratch;
+    uint8_t		*target = scratch.buffer;
+    uint8_t		*targetAlloc = NULL;	/* freed @1 */
+    TPM_HANDLE 		handles[MAX_HANDLE_NUM];
+    INT32		size;
+
+    if (tssAuthContext->inSize > sizeof(scratch)) {
+	rc = TSS_Malloc(&targetAlloc, (uint32_t)tssAuthContext->inSize);
+	target = targetAlloc;
+    }
+    if (rc == 0) {
+	size = MAX_COMMAND_SIZE;
+	rc = tssAuthContext->unmarshalInFunction(target, &bufferu, &size, handles);
+	if ((rc != 0) && tssVerbose) {
+	    printf("TSS_Marshal: Invalid command parameter\n");
+	}
+    }
+    free(targetAlloc);		/* @1 */
+    return rc;
+}
+
 /* TSS_Marshal() marshals the in parameters into the TSS context.
 
    It also sets other member of the context in preparation for the rest of the sequence.  
@@ -833,13 +1138,7 @@ TPM_RC TSS_Marshal(TSS_AUTH_CONTEXT *tssAuthContext,
     }
     /* unmarshal to validate the input parameters */
     if ((rc == 0) && (tssAuthContext->unmarshalInFunction != NULL)) {
-	COMMAND_PARAMETERS target;
-	TPM_HANDLE 	handles[MAX_HANDLE_NUM];
-	size = MAX_COMMAND_SIZE;
-	rc = tssAuthContext->unmarshalInFunction(&target, &bufferu, &size, handles);
-	if ((rc != 0) && tssVerbose) {
-	    printf("TSS_Marshal: Invalid command parameter\n");
-	}
+	rc = TSS_Marshal_Validate(tssAuthContext, bufferu);
     }
     /* back fill the correct commandSize */
     if (rc == 0) {
@@ -1217,7 +1516,7 @@ TPM_RC TSS_GetCommandHandle(TSS_AUTH_CONTEXT *tssAuthContext,
     
 /* TSS_GetRpBuffer() returns a pointer to the response parameter area.
 
-   FIXME missing range checks all over
+   The handle area and the parameterSize are range checked against the response size.
 
    FIXME move to execute so it only has to be done once.
 */
@@ -1243,7 +1542,13 @@ TPM_RC TSS_GetRpBuffer(TSS_AUTH_CONTEXT *tssAuthContext,
 	/* offset to parameterSize or parameters */
 	offsetSize = sizeof(TPM_ST) +  + sizeof (uint32_t) + sizeof(TPM_RC) +
 		     (sizeof(TPM_HANDLE) * tssAuthContext->responseHandleCount);
-	
+	if (offsetSize > tssAuthContext->responseSize) {
+	    if (tssVerbose) printf("TSS_GetRpBuffer: response size %u too small for handles\n",
+				   tssAuthContext->responseSize);
+	    rc = TSS_RC_MALFORMED_RESPONSE;
+	}
+    }
+    if (rc == 0) {
 	/* no sessions -> no parameterSize */
 	if (tag == TPM_ST_NO_SESSIONS) {
 	    *rpBufferSize = tssAuthContext->responseSize - offsetSize;
@@ -1256,9 +1561,15 @@ TPM_RC TSS_GetRpBuffer(TSS_AUTH_CONTEXT *tssAuthContext,
 		buffer = tssAuthContext->responseBuffer + offsetSize;
 		rc = UINT32_Unmarshal(&parameterSize, &buffer, &size);
 	    }
-	    /* FIXME need consistency check */
 	    if (rc == 0) {
 		offsetSize += sizeof(uint32_t);
+		if (parameterSize > (tssAuthContext->responseSize - offsetSize)) {
+		    if (tssVerbose) printf("TSS_GetRpBuffer: parameterSize %u too large\n",
+					   parameterSize);
+		    rc = TSS_RC_MALFORMED_RESPONSE;
+		}
+	    }
+	    if (rc == 0) {
 		*rpBufferSize = parameterSize;
 		*rpBuffer = tssAuthContext->responseBuffer + offsetSize;
 	    }
@@ -1328,18 +1639,79 @@ TPM_RC TSS_SetResponseDecryptParam(TSS_AUTH_CONTEXT *tssAuthContext,
     return rc;
 }
 
+/* TSS_AuthExecute() transmits the marshaled command and receives the response.
+
+   TPM_RC_RETRY, TPM_RC_YIELDED, and TPM_RC_TESTING indicate that the TPM did not start (or did not
+   complete) the command and did not change any session state.  The unchanged command buffer,
+   including any HMAC, is therefore resent, up to tssRetryCount times, with an exponential backoff
+   starting at tssRetryDelay msec.
+*/
+
 TPM_RC TSS_AuthExecute(TSS_CONTEXT *tssContext)
 {
     TPM_RC rc = 0;
+    unsigned int attempt;
+    unsigned int delay = tssContext->tssRetryDelay;
+
     if (tssVverbose) printf("TSS_AuthExecute: Executing %s\n", tssContext->tssAuthContext->commandText);
     /* transmit the command and receive the response.  Normally returns the TPM response code. */
-    if (rc == 0) {
-	rc = TSS_Transmit(tssContext,
-			  tssContext->tssAuthContext->responseBuffer,
-			  &tssContext->tssAuthContext->responseSize,
-			  tssContext->tssAuthContext->commandBuffer,
-			  tssContext->tssAuthContext->commandSize,
-			  tssContext->tssAuthContext->commandText);
+    for (attempt = 0 ; ; attempt++) {
+	/* a context with a scheduler shares the scheduler's connection, see TSS_SetScheduler() */
+	if (tssContext->tssScheduler == NULL) {
+	    rc = TSS_Transmit(tssContext,
+			      tssContext->tssAuthContext->responseBuffer,
+			      &tssContext->tssAuthContext->responseSize,
+			      tssContext->tssAuthContext->commandBuffer,
+			      tssContext->tssAuthContext->commandSize,
+			      tssContext->tssAuthContext->commandText);
+	}
+	else {
+	    rc = TSS_Scheduler_Transmit(tssContext,
+					tssContext->tssAuthContext->responseBuffer,
+					&tssContext->tssAuthContext->responseSize,
+					tssContext->tssAuthContext->commandBuffer,
+					tssContext->tssAuthContext->commandSize,
+					tssContext->tssAuthContext->commandText);
+	}
+	if ((rc != TPM_RC_RETRY) && (rc != TPM_RC_YIELDED) && (rc != TPM_RC_TESTING)) {
+	    break;
+	}
+	if (attempt >= tssContext->tssRetryCount) {
+	    if (tssContext->tssRetryCount != 0) {
+		if (tssVerbose) printf("TSS_AuthExecute: %s failed after %u resends\n",
+				       tssContext->tssAuthContext->commandText, attempt);
+		tssContext->tssRetryExhausted++;
+	    }
+	    break;
+	}
+	if (tssVverbose) printf("TSS_AuthExecute: %s rc %08x, resend after %u msec\n",
+				tssContext->tssAuthContext->commandText, rc, delay);
+	TSS_RetrySleep(delay);
+	tssContext->tssRetryResends++;
+	delay *= 2;
+	if (delay > TSS_RETRY_DELAY_MAX) {
+	    delay = TSS_RETRY_DELAY_MAX;
+	}
     }
     return rc;
 }
+
+/* TSS_RetrySleep() sleeps before a command resend.
+
+   nanosleep() is used rather than usleep(), which may reject a delay of a second or more.
+*/
+
+static void TSS_RetrySleep(unsigned int msec)
+{
+#ifdef TPM_POSIX
+    struct timespec	delay;
+
+    delay.tv_sec = msec / 1000;
+    delay.tv_nsec = (long)(msec % 1000) * 1000000;
+    nanosleep(&delay, NULL);
+#endif
+#ifdef TPM_WINDOWS
+    Sleep(msec);
+#endif
+    return;
+}
@@ -103,4 +103,11 @@ TPM_RC TSS_SetResponseDecryptParam(TSS_AUTH_CONTEXT *tssAuthContext,
 
 TPM_RC TSS_AuthExecute(TSS_CONTEXT *tssContext);
 
+/* tssscheduler.c */
+
+TPM_RC TSS_Scheduler_Transmit(TSS_CONTEXT *tssContext,
+			      uint8_t *responseBuffer, uint32_t *read,
+			      const uint8_t *commandBuffer, uint32_t written,
+			      const char *message);
+
 #endif
@@ -0,0 +1,612 @@
+/********************************************************************************/
+/*										*/
+/*			     TSS Capability Cache				*/
+/*		       IBM Thomas J. Watson Research Center			*/
+/*			    $Id: tsscapability.c $				*/
+/*										*/
+/* (c) Copyright IBM Corporation 2017.						*/
+/*										*/
+/* All rights reserved.								*/
+/* 										*/
+/* Redistribution and use in source and binary forms, with or without		*/
+/* modification, are permitted provided that the following conditions are	*/
+/* met:										*/
+/* 										*/
+/* Redistributions of source code must retain the above copyright notice,	*/
+/* this list of conditions and the following disclaimer.			*/
+/* 										*/
+/* Redistributions in binary form must reproduce the above copyright		*/
+/* notice, this list of conditions and the following disclaimer in the		*/
+/* documentation and/or other materials provided with the distribution.		*/
+/* 										*/
+/* Neither the names of the IBM Corporation nor the names of its		*/
+/* contributors may be used to endorse or promote products derived from		*/
+/* this software without specific prior written permission.			*/
+/* 										*/
+/* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS		*/
+/* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT		*/
+/* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR	*/
+/* A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT		*/
+/* HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,	*/
+/* SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT		*/
+/* LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,	*/
+/* DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY	*/
+/* THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT		*/
+/* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE	*/
+/* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.		*/
+/********************************************************************************/
+
+
+/* These functions wrap TPM2_GetCapability().
+
+   They page through the response automatically while the TPM reports moreData.
+
+   Capabilities that do not change while the TPM is running (algorithms, commands, PCR banks, ECC
+   curves, and the fixed TPM properties) are read once and cached in the TSS context.  The cache is
+   invalidated by TPM2_Startup() and TPM2_Clear(), or by the application through
+   TSS_Capability_Invalidate().
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <tss2/tss.h>
+#include <tss2/tsserror.h>
+#include <tss2/tsscapability.h>
+#include "tssproperties.h"
+
+extern int tssVerbose;
+extern int tssVverbose;
+
+/* The cached capabilities.  The index into this table is the index into the context cache.
+
+   Each capability is read from property first.  Properties after last are not cached, because they
+   are variable.
+*/
+
+typedef struct {
+    TPM_CAP	capability;
+    uint32_t	first;
+    uint32_t	last;
+} TSS_CAPABILITY_RANGE;
+
+static const TSS_CAPABILITY_RANGE tssCapabilityRangeTable[TSS_CAPABILITY_CACHE_SIZE] = {
+    {TPM_CAP_ALGS, 0, 0xffffffff},
+    {TPM_CAP_COMMANDS, 0, 0xffffffff},
+    {TPM_CAP_PCRS, 0, 0xffffffff},
+    {TPM_CAP_TPM_PROPERTIES, PT_FIXED, PT_VAR - 1},
+    {TPM_CAP_ECC_CURVES, 0, 0xffffffff}
+};
+
+/* local prototypes */
+
+static uint32_t TSS_Capability_MaxCount(TPM_CAP capability);
+static uint32_t *TSS_Capability_Count(TPMS_CAPABILITY_DATA *capabilityData);
+static uint32_t TSS_Capability_Key(const TPMS_CAPABILITY_DATA *capabilityData,
+				   uint32_t i);
+static void TSS_Capability_CopyEntry(TPMS_CAPABILITY_DATA *dest,
+				     uint32_t d,
+				     const TPMS_CAPABILITY_DATA *src,
+				     uint32_t s);
+static void TSS_Capability_Append(TPMS_CAPABILITY_DATA *dest,
+				  int *remaining,
+				  const TPMS_CAPABILITY_DATA *src,
+				  uint32_t first,
+				  uint32_t last,
+				  uint32_t propertyCount);
+static TPM_RC TSS_Capability_Page(TSS_CONTEXT *tssContext,
+				  TPMS_CAPABILITY_DATA *capabilityData,
+				  TPMI_YES_NO *moreData,
+				  TPM_CAP capability,
+				  uint32_t property,
+				  uint32_t last,
+				  uint32_t propertyCount);
+static int TSS_Capability_CacheIndex(TPM_CAP capability,
+				     uint32_t property);
+
+/* TSS_Capability_Get() returns up to propertyCount entries of capability, starting at property.
+
+   The TPM response is paged while the TPM reports moreData, so the result can hold more entries
+   than one TPM response.  propertyCount is limited by the size of the TPMU_CAPABILITIES list.
+
+   moreData is YES if the TPM has more entries after the returned list.  The caller can continue
+   at the property returned by TSS_Capability_NextProperty().
+*/
+
+TPM_RC TSS_Capability_Get(TSS_CONTEXT *tssContext,
+			  TPMS_CAPABILITY_DATA *capabilityData,
+			  TPMI_YES_NO *moreData,
+			  TPM_CAP capability,
+			  uint32_t property,
+			  uint32_t propertyCount)
+{
+    TPM_RC		rc = 0;
+    int			index = -1;
+    int			remaining;
+    uint32_t		maxCount;
+
+    if (rc == 0) {
+	maxCount = TSS_Capability_MaxCount(capability);
+	if (maxCount == 0) {
+	    if (tssVerbose) printf("TSS_Capability_Get: Unsupported capability %08x\n",
+				   capability);
+	    rc = TSS_RC_BAD_PROPERTY;
+	}
+	else if (propertyCount > maxCount) {
+	    propertyCount = maxCount;
+	}
+    }
+    /* read a cacheable capability into the context once */
+    if (rc == 0) {
+	index = TSS_Capability_CacheIndex(capability, property);
+	if ((index >= 0) && !tssContext->capabilityCache[index].valid) {
+	    if (tssVverbose) printf("TSS_Capability_Get: Caching capability %08x\n", capability);
+	    rc = TSS_Capability_Page(tssContext,
+				     &tssContext->capabilityCache[index].capabilityData,
+				     &tssContext->capabilityCache[index].moreData,
+				     capability,
+				     tssCapabilityRangeTable[index].first,
+				     tssCapabilityRangeTable[index].last,
+				     maxCount);
+	    if (rc == 0) {
+		tssContext->capabilityCache[index].valid = TRUE;
+	    }
+	}
+    }
+    /* serve the request from the cache */
+    if ((rc == 0) && (index >= 0)) {
+	capabilityData->capability = capability;
+	*TSS_Capability_Count(capabilityData) = 0;
+	TSS_Capability_Append(capabilityData,
+			      &remaining,
+			      &tssContext->capabilityCache[index].capabilityData,
+			      property, 0xffffffff,
+			      propertyCount);
+	if (remaining || tssContext->capabilityCache[index].moreData) {
+	    *moreData = YES;
+	}
+	else {
+	    *moreData = NO;
+	}
+	/* the request is past a cache that could not hold the entire TPM list */
+	if ((*TSS_Capability_Count(capabilityData) == 0) &&
+	    tssContext->capabilityCache[index].moreData) {
+	    index = -1;
+	}
+    }
+    /* not cacheable, go to the TPM */
+    if ((rc == 0) && (index < 0)) {
+	rc = TSS_Capability_Page(tssContext,
+				 capabilityData,
+				 moreData,
+				 capability,
+				 property, 0xffffffff,
+				 propertyCount);
+    }
+    return rc;
+}
+
+/* TSS_Capability_GetProperty() returns the value of one TPM property.
+
+   Fixed properties come from the context cache.  Returns TSS_RC_BAD_PROPERTY if the TPM does not
+   report the property, e.g., a back level TPM.
+*/
+
+TPM_RC TSS_Capability_GetProperty(TSS_CONTEXT *tssContext,
+				  uint32_t *value,
+				  TPM_PT property)
+{
+    TPM_RC			rc = 0;
+    TPMS_CAPABILITY_DATA	capabilityData;
+    TPMI_YES_NO			moreData;
+
+    if (rc == 0) {
+	rc = TSS_Capability_Get(tssContext,
+				&capabilityData,
+				&moreData,
+				TPM_CAP_TPM_PROPERTIES,
+				property,
+				1);
+    }
+    if (rc == 0) {
+	if ((capabilityData.data.tpmProperties.count > 0) &&
+	    (capabilityData.data.tpmProperties.tpmProperty[0].property == property)) {
+	    *value = capabilityData.data.tpmProperties.tpmProperty[0].value;
+	}
+	else {
+	    if (tssVverbose) printf("TSS_Capability_GetProperty: Property %08x not reported\n",
+				    property);
+	    rc = TSS_RC_BAD_PROPERTY;
+	}
+    }
+    return rc;
+}
+
+/* TSS_Capability_GetPcrs() returns the allocated PCR banks */
+
+TPM_RC TSS_Capability_GetPcrs(TSS_CONTEXT *tssContext,
+			      TPML_PCR_SELECTION *pcrSelection)
+{
+    TPM_RC			rc = 0;
+    TPMS_CAPABILITY_DATA	capabilityData;
+    TPMI_YES_NO			moreData;
+
+    if (rc == 0) {
+	rc = TSS_Capability_Get(tssContext,
+				&capabilityData,
+				&moreData,
+				TPM_CAP_PCRS,
+				0,
+				HASH_COUNT);
+    }
+    if (rc == 0) {
+	*pcrSelection = capabilityData.data.assignedPCR;
+    }
+    return rc;
+}
+
+/* TSS_Capability_GetAlgorithm() sets implemented to TRUE if the TPM implements alg.
+
+   If algProperties is not NULL, it is set to the algorithm attributes.
+*/
+
+TPM_RC TSS_Capability_GetAlgorithm(TSS_CONTEXT *tssContext,
+				   int *implemented,
+				   TPMA_ALGORITHM *algProperties,
+				   TPM_ALG_ID alg)
+{
+    TPM_RC			rc = 0;
+    TPMS_CAPABILITY_DATA	capabilityData;
+    TPMI_YES_NO			moreData;
+
+    if (rc == 0) {
+	rc = TSS_Capability_Get(tssContext,
+				&capabilityData,
+				&moreData,
+				TPM_CAP_ALGS,
+				alg,
+				1);
+    }
+    if (rc == 0) {
+	if ((capabilityData.data.algorithms.count > 0) &&
+	    (capabilityData.data.algorithms.algProperties[0].alg == alg)) {
+	    *implemented = TRUE;
+	    if (algProperties != NULL) {
+		*algProperties = capabilityData.data.algorithms.algProperties[0].algProperties;
+	    }
+	}
+	else {
+	    *implemented = FALSE;
+	}
+    }
+    return rc;
+}
+
+/* TSS_Capability_NextProperty() returns the property that continues a TPM2_GetCapability() list
+   after the last entry in capabilityData.
+
+   Returns TSS_RC_BAD_PROPERTY if the list is empty or the capability cannot be paged.
+*/
+
+TPM_RC TSS_Capability_NextProperty(uint32_t *nextProperty,
+				   const TPMS_CAPABILITY_DATA *capabilityData)
+{
+    TPM_RC		rc = 0;
+    uint32_t		count = 0;
+
+    if (rc == 0) {
+	if ((TSS_Capability_MaxCount(capabilityData->capability) == 0) ||
+	    (capabilityData->capability == TPM_CAP_PCRS)) {
+	    rc = TSS_RC_BAD_PROPERTY;
+	}
+    }
+    if (rc == 0) {
+	count = *TSS_Capability_Count((TPMS_CAPABILITY_DATA *)capabilityData);
+	if (count == 0) {
+	    rc = TSS_RC_BAD_PROPERTY;
+	}
+    }
+    if (rc == 0) {
+	*nextProperty = TSS_Capability_Key(capabilityData, count - 1) + 1;
+    }
+    return rc;
+}
+
+/* TSS_Capability_Invalidate() discards the cached capabilities.  They are read again on next use.
+
+   The TSS calls this after TPM2_Startup() and TPM2_Clear().  An application should call it if the
+   TPM was reset through another TSS context.
+*/
+
+void TSS_Capability_Invalidate(TSS_CONTEXT *tssContext)
+{
+    size_t i;
+    for (i = 0 ; i < (sizeof(tssContext->capabilityCache) / sizeof(TSS_CAPABILITY_CACHE)) ; i++) {
+	tssContext->capabilityCache[i].valid = FALSE;
+    }
+    return;
+}
+
+/* TSS_Capability_CacheIndex() returns the context cache index for capability, or -1 if property is
+   not cached */
+
+static int TSS_Capability_CacheIndex(TPM_CAP capability,
+				     uint32_t property)
+{
+    int 	i;
+
+    for (i = 0 ; i < TSS_CAPABILITY_CACHE_SIZE ; i++) {
+	if ((tssCapabilityRangeTable[i].capability == capability) &&
+	    (property >= tssCapabilityRangeTable[i].first) &&
+	    (property <= tssCapabilityRangeTable[i].last)) {
+	    return i;
+	}
+    }
+    return -1;
+}
+
+/* TSS_Capability_Page() reads up to propertyCount entries of capability from the TPM, starting at
+   property, and stopping after property last.  It issues TPM2_GetCapability() until the TPM reports
+   no moreData.
+*/
+
+static TPM_RC TSS_Capability_Page(TSS_CONTEXT *tssContext,
+				  TPMS_CAPABILITY_DATA *capabilityData,
+				  TPMI_YES_NO *moreData,
+				  TPM_CAP capability,
+				  uint32_t property,
+				  uint32_t last,
+				  uint32_t propertyCount)
+{
+    TPM_RC			rc = 0;
+    GetCapability_In 		in;
+    GetCapability_Out		out;
+    int				done = FALSE;
+    int				remaining = FALSE;
+    uint32_t			*count;
+
+    capabilityData->capability = capability;
+    count = TSS_Capability_Count(capabilityData);
+    *count = 0;
+    *moreData = NO;
+    in.capability = capability;
+    in.property = property;
+    while ((rc == 0) && !done) {
+	if (rc == 0) {
+	    in.propertyCount = propertyCount - *count;
+	    rc = TSS_Execute(tssContext,
+			     (RESPONSE_PARAMETERS *)&out, 
+			     (COMMAND_PARAMETERS *)&in,
+			     NULL,
+			     TPM_CC_GetCapability,
+			     TPM_RH_NULL, NULL, 0);
+	}
+	if (rc == 0) {
+	    if (out.capabilityData.capability != capability) {
+		if (tssVerbose) printf("TSS_Capability_Page: Capability %08x response %08x\n",
+				       capability, out.capabilityData.capability);
+		rc = TSS_RC_MALFORMED_RESPONSE;
+	    }
+	}
+	if (rc == 0) {
+	    TSS_Capability_Append(capabilityData,
+				  &remaining,
+				  &out.capabilityData,
+				  property, last,
+				  propertyCount);
+	    if (remaining) {			/* full, or past the last requested property */
+		*moreData = YES;
+		done = TRUE;
+	    }
+	    else if (out.moreData == NO) {	/* TPM list is done */
+		done = TRUE;
+	    }
+	    else if ((*count >= propertyCount) ||
+		     (*TSS_Capability_Count(&out.capabilityData) == 0)) {
+		*moreData = YES;
+		done = TRUE;
+	    }
+	    else {
+		rc = TSS_Capability_NextProperty(&in.property, &out.capabilityData);
+		if (tssVverbose) printf("TSS_Capability_Page: Next property %08x\n", in.property);
+	    }
+	}
+    }
+    return rc;
+}
+
+/* TSS_Capability_Append() appends the src entries from property first through last to the dest
+   list, up to propertyCount total entries.
+
+   remaining is set TRUE if src has entries that were not appended.  Entries before first are
+   skipped.  TPM_CAP_PCRS is not ordered by property, so all entries are appended.
+*/
+
+static void TSS_Capability_Append(TPMS_CAPABILITY_DATA *dest,
+				  int *remaining,
+				  const TPMS_CAPABILITY_DATA *src,
+				  uint32_t first,
+				  uint32_t last,
+				  uint32_t propertyCount)
+{
+    uint32_t	*destCount = TSS_Capability_Count(dest);
+    uint32_t	srcCount = *TSS_Capability_Count((TPMS_CAPABILITY_DATA *)src);
+    uint32_t	i;
+    uint32_t	key;
+
+    *remaining = FALSE;
+    for (i = 0 ; (i < srcCount) && !(*remaining) ; i++) {
+	if (src->capability != TPM_CAP_PCRS) {
+	    key = TSS_Capability_Key(src, i);
+	    if (key < first) {
+		continue;
+	    }
+	    if (key > last) {
+		*remaining = TRUE;
+		continue;
+	    }
+	}
+	if (*destCount >= propertyCount) {
+	    *remaining = TRUE;
+	    continue;
+	}
+	TSS_Capability_CopyEntry(dest, *destCount, src, i);
+	(*destCount)++;
+    }
+    return;
+}
+
+/* TSS_Capability_MaxCount() returns the size of the TPMU_CAPABILITIES list for the capability, or 0
+   if the capability is not supported */
+
+static uint32_t TSS_Capability_MaxCount(TPM_CAP capability)
+{
+    uint32_t maxCount;
+    switch (capability) {
+      case TPM_CAP_ALGS:
+	maxCount = MAX_CAP_ALGS;
+	break;
+      case TPM_CAP_HANDLES:
+	maxCount = MAX_CAP_HANDLES;
+	break;
+      case TPM_CAP_COMMANDS:
+      case TPM_CAP_PP_COMMANDS:
+      case TPM_CAP_AUDIT_COMMANDS:
+	maxCount = MAX_CAP_CC;
+	break;
+      case TPM_CAP_PCRS:
+	maxCount = HASH_COUNT;
+	break;
+      case TPM_CAP_TPM_PROPERTIES:
+	maxCount = MAX_TPM_PROPERTIES;
+	break;
+      case TPM_CAP_PCR_PROPERTIES:
+	maxCount = MAX_PCR_PROPERTIES;
+	break;
+      case TPM_CAP_ECC_CURVES:
+	maxCount = MAX_ECC_CURVES;
+	break;
+      default:
+	maxCount = 0;
+    }
+    return maxCount;
+}
+
+/* TSS_Capability_Count() returns a pointer to the count of the TPMU_CAPABILITIES list.  Each list
+   starts with a UINT32 count. */
+
+static uint32_t *TSS_Capability_Count(TPMS_CAPABILITY_DATA *capabilityData)
+{
+    uint32_t *count;
+    switch (capabilityData->capability) {
+      case TPM_CAP_ALGS:
+	count = &capabilityData->data.algorithms.count;
+	break;
+      case TPM_CAP_COMMANDS:
+	count = &capabilityData->data.command.count;
+	break;
+      case TPM_CAP_PP_COMMANDS:
+	count = &capabilityData->data.ppCommands.count;
+	break;
+      case TPM_CAP_AUDIT_COMMANDS:
+	count = &capabilityData->data.auditCommands.count;
+	break;
+      case TPM_CAP_PCRS:
+	count = &capabilityData->data.assignedPCR.count;
+	break;
+      case TPM_CAP_TPM_PROPERTIES:
+	count = &capabilityData->data.tpmProperties.count;
+	break;
+      case TPM_CAP_PCR_PROPERTIES:
+	count = &capabilityData->data.pcrProperties.count;
+	break;
+      case TPM_CAP_ECC_CURVES:
+	count = &capabilityData->data.eccCurves.count;
+	break;
+      case TPM_CAP_HANDLES:
+      default:
+	count = &capabilityData->data.handles.count;
+    }
+    return count;
+}
+
+/* TSS_Capability_Key() returns the property value of list entry i, the value that
+   TPM2_GetCapability() property selects on */
+
+static uint32_t TSS_Capability_Key(const TPMS_CAPABILITY_DATA *capabilityData,
+				   uint32_t i)
+{
+    uint32_t key;
+    switch (capabilityData->capability) {
+      case TPM_CAP_ALGS:
+	key = capabilityData->data.algorithms.algProperties[i].alg;
+	break;
+      case TPM_CAP_COMMANDS:
+	/* the command code is the command index plus the vendor bit */
+	key = capabilityData->data.command.commandAttributes[i].val &
+	      (TPMA_CC_COMMANDINDEX | TPMA_CC_V);
+	break;
+      case TPM_CAP_PP_COMMANDS:
+	key = capabilityData->data.ppCommands.commandCodes[i];
+	break;
+      case TPM_CAP_AUDIT_COMMANDS:
+	key = capabilityData->data.auditCommands.commandCodes[i];
+	break;
+      case TPM_CAP_PCRS:
+	key = capabilityData->data.assignedPCR.pcrSelections[i].hash;
+	break;
+      case TPM_CAP_TPM_PROPERTIES:
+	key = capabilityData->data.tpmProperties.tpmProperty[i].property;
+	break;
+      case TPM_CAP_PCR_PROPERTIES:
+	key = capabilityData->data.pcrProperties.pcrProperty[i].tag;
+	break;
+      case TPM_CAP_ECC_CURVES:
+	key = capabilityData->data.eccCurves.eccCurves[i];
+	break;
+      case TPM_CAP_HANDLES:
+      default:
+	key = capabilityData->data.handles.handle[i];
+    }
+    return key;
+}
+
+/* TSS_Capability_CopyEntry() copies src list entry s to dest list entry d */
+
+static void TSS_Capability_CopyEntry(TPMS_CAPABILITY_DATA *dest,
+				     uint32_t d,
+				     const TPMS_CAPABILITY_DATA *src,
+				     uint32_t s)
+{
+    switch (src->capability) {
+      case TPM_CAP_ALGS:
+	dest->data.algorithms.algProperties[d] = src->data.algorithms.algProperties[s];
+	break;
+      case TPM_CAP_COMMANDS:
+	dest->data.command.commandAttributes[d] = src->data.command.commandAttributes[s];
+	break;
+      case TPM_CAP_PP_COMMANDS:
+	dest->data.ppCommands.commandCodes[d] = src->data.ppCommands.commandCodes[s];
+	break;
+      case TPM_CAP_AUDIT_COMMANDS:
+	dest->data.auditCommands.commandCodes[d] = src->data.auditCommands.commandCodes[s];
+	break;
+      case TPM_CAP_PCRS:
+	dest->data.assignedPCR.pcrSelections[d] = src->data.assignedPCR.pcrSelections[s];
+	break;
+      case TPM_CAP_TPM_PROPERTIES:
+	dest->data.tpmProperties.tpmProperty[d] = src->data.tpmProperties.tpmProperty[s];
+	break;
+      case TPM_CAP_PCR_PROPERTIES:
+	dest->data.pcrProperties.pcrProperty[d] = src->data.pcrProperties.pcrProperty[s];
+	break;
+      case TPM_CAP_ECC_CURVES:
+	dest->data.eccCurves.eccCurves[d] = src->data.eccCurves.eccCurves[s];
+	break;
+      case TPM_CAP_HANDLES:
+      default:
+	dest->data.handles.handle[d] = src->data.handles.handle[s];
+    }
+    return;
+}
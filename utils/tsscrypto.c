@@ -276,6 +276,91 @@ TPM_RC TSS_Hash_Generate_valist(TPMT_HA *digest,		/* largest size of a digest */
     return rc;
 }
 
+/* TSS_Hash_Start() begins an incremental digest of hashAlg.  It is used when the data is too large
+   or arrives in pieces, so that the valist interface cannot be used.
+
+   The hashContext is opaque to the caller.  It must be freed by TSS_Hash_Finish().
+*/
+
+TPM_RC TSS_Hash_Start(void **hashContext,	/* freed by TSS_Hash_Finish() */
+		      TPMI_ALG_HASH hashAlg)
+{
+    TPM_RC		rc = 0;
+    int			irc = 0;
+    EVP_MD_CTX 		*mdctx = NULL;
+    const EVP_MD 	*md;
+
+    if (rc == 0) {
+	mdctx = EVP_MD_CTX_create();
+        if (mdctx == NULL) {
+	    if (tssVerbose) printf("TSS_Hash_Start: malloc EVP_MD_CTX failed\n");
+	    rc = TSS_RC_OUT_OF_MEMORY;
+	}
+    }
+    if (rc == 0) {
+	rc = TSS_Hash_GetMd(&md, hashAlg);
+    }
+    if (rc == 0) {
+	irc = EVP_DigestInit_ex(mdctx, md, NULL);
+	if (irc != 1) {
+	    rc = TSS_RC_HASH;
+	}
+    }
+    if (rc == 0) {
+	*hashContext = mdctx;
+    }
+    else {
+	EVP_MD_CTX_destroy(mdctx);
+	*hashContext = NULL;
+    }
+    return rc;
+}
+
+/* TSS_Hash_Update() adds length bytes of buffer to the digest */
+
+TPM_RC TSS_Hash_Update(void *hashContext,
+		       const uint8_t *buffer,
+		       uint32_t length)
+{
+    TPM_RC		rc = 0;
+    int			irc = 0;
+
+    if (length != 0) {
+	irc = EVP_DigestUpdate((EVP_MD_CTX *)hashContext, buffer, length);
+	if (irc != 1) {
+	    if (tssVerbose) printf("TSS_Hash_Update: EVP_DigestUpdate failed\n");
+	    rc = TSS_RC_HASH;
+	}
+    }
+    return rc;
+}
+
+/* TSS_Hash_Finish() returns the digest and frees the hashContext.
+
+   On call, digest->hashAlg is the algorithm passed to TSS_Hash_Start().  digest may be NULL to
+   abandon the digest, e.g., on an error path.
+*/
+
+TPM_RC TSS_Hash_Finish(TPMT_HA *digest,
+		       void **hashContext)
+{
+    TPM_RC		rc = 0;
+    int			irc = 0;
+
+    if (*hashContext != NULL) {
+	if (digest != NULL) {
+	    irc = EVP_DigestFinal_ex((EVP_MD_CTX *)*hashContext,
+				     (uint8_t *)&digest->digest, NULL);
+	    if (irc != 1) {
+		rc = TSS_RC_HASH;
+	    }
+	}
+	EVP_MD_CTX_destroy((EVP_MD_CTX *)*hashContext);
+	*hashContext = NULL;
+    }
+    return rc;
+}
+
 /* Random Numbers */
 
 TPM_RC TSS_RandBytes(unsigned char *buffer, uint32_t size)
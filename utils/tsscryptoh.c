@@ -277,6 +277,69 @@ TPM_RC TSS_Hash_Generate(TPMT_HA *digest,		/* largest size of a digest */
     return rc;
 }
 
+/* TSS_Hash_GenerateMulti() is TSS_Hash_Generate() for 'count' digests of the same data, one for
+   each digests[i].hashAlg.  The varargs are the same length / buffer pairs.
+
+   The data is read once.  Each block of TSS_HASH_MULTI_BLOCK bytes is added to every digest
+   before moving on, so that a large parameter area stays in cache.
+*/
+
+#define TSS_HASH_MULTI_BLOCK	2048
+
+TPM_RC TSS_Hash_GenerateMulti(TPMT_HA digests[],
+			      size_t count,
+			      ...)
+{
+    TPM_RC	rc = 0;
+    TPM_RC	rc1;
+    va_list	ap;
+    void	*hashContext[HASH_COUNT];
+    size_t	i;
+    int		length;
+    uint8_t	*buffer;
+    int		block;
+
+    if (count > HASH_COUNT) {
+	if (tssVerbose) printf("TSS_Hash_GenerateMulti: %lu digests, maximum %u\n",
+			       (unsigned long)count, HASH_COUNT);
+	rc = TSS_RC_BAD_HASH_ALGORITHM;
+	count = 0;
+    }
+    for (i = 0 ; i < count ; i++) {
+	hashContext[i] = NULL;
+    }
+    for (i = 0 ; (rc == 0) && (i < count) ; i++) {
+	rc = TSS_Hash_Start(&hashContext[i], digests[i].hashAlg);	/* freed @1 */
+    }
+    va_start(ap, count);
+    while (rc == 0) {
+	length = va_arg(ap, int);		/* first vararg is the length */
+	buffer = va_arg(ap, unsigned char *);	/* second vararg is the array */
+	if (buffer == NULL) {			/* loop until a NULL buffer terminates */
+	    break;
+	}
+	if (length < 0) {
+	    if (tssVerbose) printf("TSS_Hash_GenerateMulti: Length is negative\n");
+	    rc = TSS_RC_HASH;
+	}
+	for ( ; (rc == 0) && (length > 0) ; length -= block, buffer += block) {
+	    block = (length > TSS_HASH_MULTI_BLOCK) ? TSS_HASH_MULTI_BLOCK : length;
+	    for (i = 0 ; (rc == 0) && (i < count) ; i++) {
+		rc = TSS_Hash_Update(hashContext[i], buffer, block);
+	    }
+	}
+    }
+    va_end(ap);
+    /* TSS_Hash_Finish() frees the context even on error */
+    for (i = 0 ; i < count ; i++) {
+	rc1 = TSS_Hash_Finish((rc == 0) ? &digests[i] : NULL, &hashContext[i]);	/* @1 */
+	if (rc == 0) {
+	    rc = rc1;
+	}
+    }
+    return rc;
+}
+
 /* TSS_GetDigestSize() returns the digest size in bytes based on the hash algorithm.
 
    Returns 0 for an unknown algorithm.
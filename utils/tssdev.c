@@ -47,9 +47,10 @@
 
 #include <fcntl.h>
 #include <unistd.h>
+#include <poll.h>
+#include <time.h>
 #include <arpa/inet.h>
 #include <sys/types.h>
-#include <fcntl.h>
 
 #include <tss2/tssresponsecode.h>
 #include <tss2/tsserror.h>
@@ -58,12 +59,23 @@
 
 #include "tssdev.h"
 
+/* The kernel resource manager, opted into with TPM_DEVICE /dev/tpmrm0, virtualizes objects and
+   sessions per open file, so each TSS_CONTEXT (typically one per thread) can hold its own open
+   concurrently with other contexts and processes.  The default /dev/tpm0 allows only one open at a
+   time. */
+
+#define TPM_DEVICE_RM		"/dev/tpmrm0"
+
 /* local prototypes */
 
 static uint32_t TSS_Dev_Open(TSS_CONTEXT *tssContext);
 static uint32_t TSS_Dev_SendCommand(int dev_fd, const uint8_t *buffer, uint16_t length,
 				    const char *message);
 static uint32_t TSS_Dev_ReceiveCommand(int dev_fd, uint8_t *buffer, uint32_t *length);
+static uint32_t TSS_Dev_Poll(TSS_CONTEXT *tssContext,
+			     const uint8_t *commandBuffer, uint32_t written);
+static unsigned int TSS_Dev_GetTimeout(TSS_CONTEXT *tssContext,
+				       const uint8_t *commandBuffer, uint32_t written);
 
 /* global configuration */
 
@@ -81,9 +93,16 @@ TPM_RC TSS_Dev_Transmit(TSS_CONTEXT *tssContext,
 			const char *message)
 {
     TPM_RC rc = 0;
+    uint64_t startTime;
     
+    /* the device driver always sends at the locality the kernel chose */
+    if (tssContext->tssLocality != 0) {
+	if (tssVerbose) printf("TSS_Dev_Transmit: Error, locality %u not supported\n",
+			       tssContext->tssLocality);
+	rc = TSS_RC_INSUPPORTED_INTERFACE;
+    }
     /* open on first transmit */
-    if (tssContext->tssFirstTransmit) {	
+    if ((rc == 0) && tssContext->tssFirstTransmit) {	
 	if (rc == 0) {
 	    rc = TSS_Dev_Open(tssContext);
 	}
@@ -91,10 +110,17 @@ TPM_RC TSS_Dev_Transmit(TSS_CONTEXT *tssContext,
 	    tssContext->tssFirstTransmit = FALSE;
 	}
     }
+    startTime = TSS_Dev_GetTime();
     /* send the command to the device.  Error if the device send fails. */
     if (rc == 0) {
 	rc = TSS_Dev_SendCommand(tssContext->dev_fd, commandBuffer, written, message);
     }
+    /* wait for the response, up to the timeout for the command */
+    if (rc == 0) {
+	tssContext->tssDevCommands++;
+	rc = TSS_Dev_Poll(tssContext, commandBuffer, written);
+	tssContext->tssDevWaitTime += TSS_Dev_GetTime() - startTime;
+    }
     /* receive the response from the dev_fd.  Returns dev_fd errors, malformed response errors.
        Else returns the TPM response code. */
     if (rc == 0) {
@@ -108,21 +134,131 @@ TPM_RC TSS_Dev_Transmit(TSS_CONTEXT *tssContext,
 static uint32_t TSS_Dev_Open(TSS_CONTEXT *tssContext)
 {
     uint32_t rc = 0;
+    int flags;
     
     if (rc == 0) {
 	if (tssVverbose) printf("TSS_Dev_Open: Opening %s\n", tssContext->tssDevice);
-	tssContext->dev_fd = open(tssContext->tssDevice, O_RDWR);
-	if (tssContext->dev_fd <= 0) {
-	    if (tssVerbose) printf("TSS_Dev_Open: Error opening %s\n", tssContext->tssDevice);
+	tssContext->dev_fd = open(tssContext->tssDevice, O_RDWR | O_CLOEXEC);
+	if (tssContext->dev_fd < 0) {
+	    if (tssVerbose) printf("TSS_Dev_Open: Error opening %s, %d %s\n",
+				   tssContext->tssDevice, errno, strerror(errno));
+	    if ((errno == EBUSY) && tssVerbose) {
+		printf("TSS_Dev_Open: %s is in use, %s allows concurrent opens\n",
+		       tssContext->tssDevice, TPM_DEVICE_RM);
+	    }
 	    rc = TSS_RC_NO_CONNECTION;
 	}
     }
+    /* Kernels with asynchronous device support return from the write once the command is queued,
+       and the response is polled.  Others ignore O_NONBLOCK, the write returns after the TPM
+       completes, and the poll returns immediately. */
     if (rc == 0) {
-	fcntl(tssContext->dev_fd, O_RDONLY | O_NONBLOCK);
+	flags = fcntl(tssContext->dev_fd, F_GETFL);
+	if (flags >= 0) {
+	    fcntl(tssContext->dev_fd, F_SETFL, flags | O_NONBLOCK);
+	}
     }
     return rc;
 }
 
+/* TSS_Dev_GetTimeout() returns the response timeout in msec for the command, longer for commands
+   that generate a key.  0 waits forever.
+*/
+
+static unsigned int TSS_Dev_GetTimeout(TSS_CONTEXT *tssContext,
+				       const uint8_t *commandBuffer, uint32_t written)
+{
+    unsigned int timeout = tssContext->tssDeviceTimeout;
+    TPM_CC commandCode = 0;
+
+    if (written >= (sizeof(TPM_ST) + sizeof(uint32_t) + sizeof(TPM_CC))) {
+	commandCode = ntohl(*(uint32_t *)(commandBuffer + sizeof(TPM_ST) + sizeof(uint32_t)));
+    }
+    switch (commandCode) {
+      case TPM_CC_CreatePrimary:
+      case TPM_CC_Create:
+      case TPM_CC_CreateLoaded:
+	timeout = tssContext->tssDeviceTimeoutLong;
+	break;
+      default:
+	break;
+    }
+    return timeout;
+}
+
+/* TSS_Dev_Poll() waits until the response is ready to read.
+
+   After a timeout, the device still holds the command, so it is closed and reopened at the next
+   transmit.
+*/
+
+static uint32_t TSS_Dev_Poll(TSS_CONTEXT *tssContext,
+			     const uint8_t *commandBuffer, uint32_t written)
+{
+    uint32_t 		rc = 0;
+    int 		irc;
+    unsigned int 	timeout;
+    struct pollfd 	pollFd;
+
+    timeout = TSS_Dev_GetTimeout(tssContext, commandBuffer, written);
+    pollFd.fd = tssContext->dev_fd;
+    pollFd.events = POLLIN;
+    do {
+	pollFd.revents = 0;
+	irc = poll(&pollFd, 1, (timeout == 0) ? -1 : (int)timeout);
+    } while ((irc < 0) && (errno == EINTR));
+    if (irc < 0) {
+	if (tssVerbose) printf("TSS_Dev_Poll: poll error %d %s\n", errno, strerror(errno));
+	rc = TSS_RC_BAD_CONNECTION;
+    }
+    else if (irc == 0) {
+	if (tssVerbose) printf("TSS_Dev_Poll: no response after %u msec\n", timeout);
+	tssContext->tssDevTimeouts++;
+	TSS_Dev_Close(tssContext);
+	tssContext->tssFirstTransmit = TRUE;
+	rc = TSS_RC_DEVICE_TIMEOUT;
+    }
+    else if ((pollFd.revents & POLLIN) == 0) {
+	if (tssVerbose) printf("TSS_Dev_Poll: poll revents %04x\n", pollFd.revents);
+	rc = TSS_RC_BAD_CONNECTION;
+    }
+    return rc;
+}
+
+/* TSS_Dev_GetTime() returns a monotonic time in usec, for the device statistics */
+
+uint64_t TSS_Dev_GetTime(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((uint64_t)now.tv_sec * 1000000) + ((uint64_t)now.tv_nsec / 1000);
+}
+
+/* TSS_Dev_AddProcessTime() adds the time in TSS_Execute() since startTime, less the time blocked on
+   the device since that time, to the device interface statistics.  startWaitTime is tssDevWaitTime
+   at startTime.
+*/
+
+void TSS_Dev_AddProcessTime(TSS_CONTEXT *tssContext,
+			    uint64_t startTime,
+			    uint64_t startWaitTime)
+{
+    uint64_t elapsed;
+    uint64_t waitTime;
+    
+    /* a context with a scheduler transmits on the scheduler's transport context */
+    if ((tssContext->tssScheduler == NULL) &&
+	(strcmp(tssContext->tssInterfaceType, "dev") == 0)) {
+	elapsed = TSS_Dev_GetTime() - startTime;
+	waitTime = tssContext->tssDevWaitTime - startWaitTime;
+	if (elapsed > waitTime) {
+	    tssContext->tssDevProcessTime += elapsed - waitTime;
+	}
+    }
+    return;
+}
+
 /* TSS_Dev_SendCommand() sends the TPM command buffer to the device.
 
    Returns an error if the device write fails.
@@ -216,7 +352,10 @@ static uint32_t TSS_Dev_ReceiveCommand(int dev_fd, uint8_t *buffer, uint32_t *le
 TPM_RC TSS_Dev_Close(TSS_CONTEXT *tssContext)
 {
     if (tssVverbose) printf("TSS_Dev_Close: Closing %s\n", tssContext->tssDevice);
-    close(tssContext->dev_fd);
+    if (tssContext->dev_fd >= 0) {
+	close(tssContext->dev_fd);
+	tssContext->dev_fd = -1;
+    }
     return 0;
 }
 
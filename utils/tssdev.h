@@ -53,6 +53,10 @@ extern "C" {
 			    const uint8_t *commandBuffer, uint32_t written,
 			    const char *message);
     TPM_RC TSS_Dev_Close(TSS_CONTEXT *tssContext);
+    uint64_t TSS_Dev_GetTime(void);
+    void TSS_Dev_AddProcessTime(TSS_CONTEXT *tssContext,
+				uint64_t startTime,
+				uint64_t startWaitTime);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,1021 @@
+/********************************************************************************/
+/*										*/
+/*			TSS Policy Digest Calculation				*/
+/*		       IBM Thomas J. Watson Research Center			*/
+/*			      $Id: tsspolicy.c $				*/
+/*										*/
+/* (c) Copyright IBM Corporation 2017.						*/
+/*										*/
+/* All rights reserved.								*/
+/* 										*/
+/* Redistribution and use in source and binary forms, with or without		*/
+/* modification, are permitted provided that the following conditions are	*/
+/* met:										*/
+/* 										*/
+/* Redistributions of source code must retain the above copyright notice,	*/
+/* this list of conditions and the following disclaimer.			*/
+/* 										*/
+/* Redistributions in binary form must reproduce the above copyright		*/
+/* notice, this list of conditions and the following disclaimer in the		*/
+/* documentation and/or other materials provided with the distribution.		*/
+/* 										*/
+/* Neither the names of the IBM Corporation nor the names of its		*/
+/* contributors may be used to endorse or promote products derived from		*/
+/* this software without specific prior written permission.			*/
+/* 										*/
+/* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS		*/
+/* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT		*/
+/* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR	*/
+/* A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT		*/
+/* HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,	*/
+/* SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT		*/
+/* LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,	*/
+/* DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY	*/
+/* THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT		*/
+/* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE	*/
+/* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.		*/
+/********************************************************************************/
+
+/* Policy digest calculation without a TPM trial session.
+
+   The formulas are from TPM 2.0 Part 3, each policy command's "Detailed Actions".
+*/
+
+#include <string.h>
+#include <stdio.h>
+
+#include <tss2/tss.h>
+#include <tss2/tsserror.h>
+#include <tss2/tssmarshal.h>
+#include <tss2/tsscryptoh.h>
+#include <tss2/tsscrypto.h>
+#include <tss2/tsspolicy.h>
+#include "tssproperties.h"
+
+#ifndef TPM_TSS_NOCRYPTO
+
+extern int tssVerbose;
+extern int tssVverbose;
+
+/* local prototypes */
+
+static TPM_RC TSS_Policy_Extend(TPMT_HA *digest,
+				TPM_CC commandCode,
+				const uint8_t *data1,
+				uint16_t length1,
+				const uint8_t *data2,
+				uint16_t length2);
+static TPM_RC TSS_Policy_ExtendAll(TSS_POLICY *policy,
+				   TPM_CC commandCode,
+				   const uint8_t *data1,
+				   uint16_t length1,
+				   const uint8_t *data2,
+				   uint16_t length2);
+static TPM_RC TSS_Policy_Update(TSS_POLICY *policy,
+				TPM_CC commandCode,
+				const TPM2B_NAME *name,
+				const TPM2B_NONCE *policyRef);
+static TPM_RC TSS_Policy_ExtendDigest(TSS_POLICY *policy,
+				      TPM_CC commandCode,
+				      const TPM2B_DIGEST *digest);
+static TPM_RC TSS_Policy_Args(TPMT_HA *args,
+			      const TPM2B_OPERAND *operandB,
+			      UINT16 offset,
+			      TPM_EO operation);
+static int TSS_PcrCache_GetBank(TSS_CONTEXT *tssContext,
+				TPMI_ALG_HASH hashAlg,
+				int add);
+static int TSS_PcrCache_IsSelected(const TPMS_PCR_SELECTION *pcrSelection,
+				   uint32_t pcr);
+static int TSS_PcrCache_Compare(const TPML_PCR_SELECTION *pcrs1,
+				const TPML_PCR_SELECTION *pcrs2);
+
+/* empty buffer, since TSS_Hash_Generate() terminates at a NULL buffer */
+
+static const uint8_t tssPolicyEmpty[1];
+
+/* TSS_Policy_Init() initializes the policy digests for 'count' hash algorithms to zero, as
+   TPM2_StartAuthSession does for a policy or trial session. */
+
+TPM_RC TSS_Policy_Init(TSS_POLICY *policy,
+		       const TPMI_ALG_HASH *hashAlg,
+		       uint32_t count)
+{
+    TPM_RC	rc = 0;
+    uint32_t	i;
+    uint32_t	j;
+
+    if (rc == 0) {
+	if ((count == 0) || (count > HASH_COUNT)) {
+	    if (tssVerbose) printf("TSS_Policy_Init: Bad algorithm count %u\n", count);
+	    rc = TSS_RC_BAD_HASH_ALGORITHM;
+	}
+    }
+    for (i = 0 ; (rc == 0) && (i < count) ; i++) {
+	if (TSS_GetDigestSize(hashAlg[i]) == 0) {
+	    if (tssVerbose) printf("TSS_Policy_Init: Bad hash algorithm %04x\n", hashAlg[i]);
+	    rc = TSS_RC_BAD_HASH_ALGORITHM;
+	}
+	for (j = 0 ; (rc == 0) && (j < i) ; j++) {
+	    if (hashAlg[j] == hashAlg[i]) {
+		if (tssVerbose) printf("TSS_Policy_Init: Duplicate hash algorithm %04x\n",
+				       hashAlg[i]);
+		rc = TSS_RC_BAD_HASH_ALGORITHM;
+	    }
+	}
+	policy->digest[i].hashAlg = hashAlg[i];
+    }
+    if (rc == 0) {
+	policy->count = count;
+	TSS_Policy_Reset(policy);
+    }
+    return rc;
+}
+
+/* TSS_Policy_Reset() sets the policy digests to zero, as TPM2_PolicyRestart does */
+
+void TSS_Policy_Reset(TSS_POLICY *policy)
+{
+    uint32_t	i;
+
+    for (i = 0 ; i < policy->count ; i++) {
+	memset((uint8_t *)&policy->digest[i].digest, 0, sizeof(TPMU_HA));
+    }
+    return;
+}
+
+/* TSS_Policy_GetDigest() returns the policy digest for hashAlg */
+
+TPM_RC TSS_Policy_GetDigest(TPM2B_DIGEST *digest,
+			    const TSS_POLICY *policy,
+			    TPMI_ALG_HASH hashAlg)
+{
+    TPM_RC	rc = 0;
+    uint32_t	i;
+
+    for (i = 0 ; i < policy->count ; i++) {
+	if (policy->digest[i].hashAlg == hashAlg) {
+	    break;
+	}
+    }
+    if (i == policy->count) {
+	if (tssVerbose) printf("TSS_Policy_GetDigest: No digest for hash algorithm %04x\n",
+			       hashAlg);
+	rc = TSS_RC_BAD_HASH_ALGORITHM;
+    }
+    if (rc == 0) {
+	digest->t.size = TSS_GetDigestSize(hashAlg);
+	memcpy(digest->t.buffer, (const uint8_t *)&policy->digest[i].digest, digest->t.size);
+    }
+    return rc;
+}
+
+/* TSS_Policy_CommandCode() extends TPM2_PolicyCommandCode
+
+   policyDigest = H(policyDigest || TPM_CC_PolicyCommandCode || code)
+*/
+
+TPM_RC TSS_Policy_CommandCode(TSS_POLICY *policy,
+			      TPM_CC code)
+{
+    TPM_RC	rc = 0;
+    uint16_t	written = 0;
+    uint8_t	buffer[sizeof(TPM_CC)];
+    uint8_t	*bufferPtr = buffer;
+
+    if (rc == 0) {
+	rc = TSS_TPM_CC_Marshal(&code, &written, &bufferPtr, NULL);
+    }
+    if (rc == 0) {
+	rc = TSS_Policy_ExtendAll(policy, TPM_CC_PolicyCommandCode,
+				  buffer, written, NULL, 0);
+    }
+    return rc;
+}
+
+/* TSS_Policy_AuthValue() extends TPM2_PolicyAuthValue
+
+   policyDigest = H(policyDigest || TPM_CC_PolicyAuthValue)
+*/
+
+TPM_RC TSS_Policy_AuthValue(TSS_POLICY *policy)
+{
+    return TSS_Policy_ExtendAll(policy, TPM_CC_PolicyAuthValue, NULL, 0, NULL, 0);
+}
+
+/* TSS_Policy_Password() extends TPM2_PolicyPassword.  The policy digest is the same as for
+   TPM2_PolicyAuthValue.
+
+   policyDigest = H(policyDigest || TPM_CC_PolicyAuthValue)
+*/
+
+TPM_RC TSS_Policy_Password(TSS_POLICY *policy)
+{
+    return TSS_Policy_ExtendAll(policy, TPM_CC_PolicyAuthValue, NULL, 0, NULL, 0);
+}
+
+/* TSS_Policy_PhysicalPresence() extends TPM2_PolicyPhysicalPresence
+
+   policyDigest = H(policyDigest || TPM_CC_PolicyPhysicalPresence)
+*/
+
+TPM_RC TSS_Policy_PhysicalPresence(TSS_POLICY *policy)
+{
+    return TSS_Policy_ExtendAll(policy, TPM_CC_PolicyPhysicalPresence, NULL, 0, NULL, 0);
+}
+
+/* TSS_Policy_Locality() extends TPM2_PolicyLocality
+
+   policyDigest = H(policyDigest || TPM_CC_PolicyLocality || locality)
+*/
+
+TPM_RC TSS_Policy_Locality(TSS_POLICY *policy,
+			   TPMA_LOCALITY locality)
+{
+    return TSS_Policy_ExtendAll(policy, TPM_CC_PolicyLocality,
+				&locality.val, sizeof(locality.val), NULL, 0);
+}
+
+/* TSS_Policy_NvWritten() extends TPM2_PolicyNvWritten
+
+   policyDigest = H(policyDigest || TPM_CC_PolicyNvWritten || writtenSet)
+*/
+
+TPM_RC TSS_Policy_NvWritten(TSS_POLICY *policy,
+			    TPMI_YES_NO writtenSet)
+{
+    return TSS_Policy_ExtendAll(policy, TPM_CC_PolicyNvWritten,
+				&writtenSet, sizeof(writtenSet), NULL, 0);
+}
+
+/* TSS_Policy_PCR() extends TPM2_PolicyPCR given the PCR values.
+
+   pcrValues are the 'count' selected PCR values in the order the TPM digests them, selection by
+   selection and ascending PCR number within a selection.  The pcrDigest is calculated with each
+   policy hash algorithm.
+
+   pcrDigest = H(pcrValues[0] || ... || pcrValues[count-1])
+   policyDigest = H(policyDigest || TPM_CC_PolicyPCR || pcrs || pcrDigest)
+*/
+
+TPM_RC TSS_Policy_PCR(TSS_POLICY *policy,
+		      const TPML_PCR_SELECTION *pcrs,
+		      const TPM2B_DIGEST *pcrValues,
+		      uint32_t count)
+{
+    TPM_RC	rc = 0;
+    uint16_t	written = 0;
+    uint8_t	buffer[sizeof(TPML_PCR_SELECTION)];
+    uint8_t	*bufferPtr = buffer;
+    uint32_t	i;
+    uint32_t	v;
+
+    if (rc == 0) {
+	rc = TSS_TPML_PCR_SELECTION_Marshal(pcrs, &written, &bufferPtr, NULL);
+    }
+    for (i = 0 ; (rc == 0) && (i < policy->count) ; i++) {
+	TPMT_HA pcrDigest;
+	void *hashContext = NULL;
+	pcrDigest.hashAlg = policy->digest[i].hashAlg;
+	rc = TSS_Hash_Start(&hashContext, pcrDigest.hashAlg);
+	for (v = 0 ; (rc == 0) && (v < count) ; v++) {
+	    rc = TSS_Hash_Update(hashContext, pcrValues[v].t.buffer, pcrValues[v].t.size);
+	}
+	if (hashContext != NULL) {
+	    TPM_RC rc1 = TSS_Hash_Finish((rc == 0) ? &pcrDigest : NULL, &hashContext);
+	    if (rc == 0) {
+		rc = rc1;
+	    }
+	}
+	if (rc == 0) {
+	    rc = TSS_Policy_Extend(&policy->digest[i], TPM_CC_PolicyPCR,
+				   buffer, written,
+				   (uint8_t *)&pcrDigest.digest,
+				   TSS_GetDigestSize(pcrDigest.hashAlg));
+	}
+    }
+    return rc;
+}
+
+/* TSS_Policy_PCRDigest() extends TPM2_PolicyPCR given the pcrDigest command parameter.
+
+   policyDigest = H(policyDigest || TPM_CC_PolicyPCR || pcrs || pcrDigest)
+*/
+
+TPM_RC TSS_Policy_PCRDigest(TSS_POLICY *policy,
+			    const TPML_PCR_SELECTION *pcrs,
+			    const TPM2B_DIGEST *pcrDigest)
+{
+    TPM_RC	rc = 0;
+    uint16_t	written = 0;
+    uint8_t	buffer[sizeof(TPML_PCR_SELECTION)];
+    uint8_t	*bufferPtr = buffer;
+    uint32_t	i;
+
+    for (i = 0 ; (rc == 0) && (i < policy->count) ; i++) {
+	if (pcrDigest->t.size != TSS_GetDigestSize(policy->digest[i].hashAlg)) {
+	    if (tssVerbose) printf("TSS_Policy_PCRDigest: pcrDigest size %u invalid\n",
+				   pcrDigest->t.size);
+	    rc = TSS_RC_BAD_DIGEST_SIZE;
+	}
+    }
+    if (rc == 0) {
+	rc = TSS_TPML_PCR_SELECTION_Marshal(pcrs, &written, &bufferPtr, NULL);
+    }
+    if (rc == 0) {
+	rc = TSS_Policy_ExtendAll(policy, TPM_CC_PolicyPCR,
+				  buffer, written,
+				  pcrDigest->t.buffer, pcrDigest->t.size);
+    }
+    return rc;
+}
+
+/* TSS_Policy_OR() extends TPM2_PolicyOR, where the branches are themselves TSS_POLICY values with
+   the same hash algorithms as policy.  It is typically used to combine branches built with this
+   API, since the branch digest for each algorithm is used.
+
+   policyDigest = H(0...0 || TPM_CC_PolicyOR || branch[0] || ... || branch[count-1])
+*/
+
+TPM_RC TSS_Policy_OR(TSS_POLICY *policy,
+		     const TSS_POLICY *branches,
+		     uint32_t count)
+{
+    TPM_RC	rc = 0;
+    uint32_t	i;
+    uint32_t	b;
+
+    if (rc == 0) {
+	if ((count < 2) || (count > 8)) {
+	    if (tssVerbose) printf("TSS_Policy_OR: Branch count %u not 2 to 8\n", count);
+	    rc = TSS_RC_POLICY_OR_COUNT;
+	}
+    }
+    for (b = 0 ; (rc == 0) && (b < count) ; b++) {
+	if (branches[b].count != policy->count) {
+	    rc = TSS_RC_BAD_HASH_ALGORITHM;
+	}
+	for (i = 0 ; (rc == 0) && (i < policy->count) ; i++) {
+	    if (branches[b].digest[i].hashAlg != policy->digest[i].hashAlg) {
+		rc = TSS_RC_BAD_HASH_ALGORITHM;
+	    }
+	}
+	if (rc != 0) {
+	    if (tssVerbose) printf("TSS_Policy_OR: Branch %u hash algorithms do not match\n", b);
+	}
+    }
+    if (rc == 0) {
+	TSS_Policy_Reset(policy);
+    }
+    for (i = 0 ; (rc == 0) && (i < policy->count) ; i++) {
+	uint16_t digestSize = TSS_GetDigestSize(policy->digest[i].hashAlg);
+	uint8_t	buffer[8 * sizeof(TPMU_HA)];
+	for (b = 0 ; b < count ; b++) {
+	    memcpy(buffer + (b * digestSize), (const uint8_t *)&branches[b].digest[i].digest,
+		   digestSize);
+	}
+	rc = TSS_Policy_Extend(&policy->digest[i], TPM_CC_PolicyOR,
+			       buffer, count * digestSize, NULL, 0);
+    }
+    return rc;
+}
+
+/* TSS_Policy_ORDigests() extends TPM2_PolicyOR given the pHashList command parameter.
+
+   policyDigest = H(0...0 || TPM_CC_PolicyOR || digests)
+*/
+
+TPM_RC TSS_Policy_ORDigests(TSS_POLICY *policy,
+			    const TPML_DIGEST *pHashList)
+{
+    TPM_RC	rc = 0;
+    uint16_t	length = 0;
+    uint8_t	buffer[8 * sizeof(TPMU_HA)];
+    uint32_t	i;
+    uint32_t	d;
+
+    if (rc == 0) {
+	if ((pHashList->count < 2) || (pHashList->count > 8)) {
+	    if (tssVerbose) printf("TSS_Policy_ORDigests: Digest count %u not 2 to 8\n",
+				   pHashList->count);
+	    rc = TSS_RC_POLICY_OR_COUNT;
+	}
+    }
+    for (i = 0 ; (rc == 0) && (i < policy->count) ; i++) {
+	for (d = 0 ; (rc == 0) && (d < pHashList->count) ; d++) {
+	    if (pHashList->digests[d].t.size != TSS_GetDigestSize(policy->digest[i].hashAlg)) {
+		if (tssVerbose) printf("TSS_Policy_ORDigests: Digest %u size %u invalid\n",
+				       d, pHashList->digests[d].t.size);
+		rc = TSS_RC_BAD_DIGEST_SIZE;
+	    }
+	}
+    }
+    for (d = 0 ; (rc == 0) && (d < pHashList->count) ; d++) {
+	memcpy(buffer + length, pHashList->digests[d].t.buffer, pHashList->digests[d].t.size);
+	length += pHashList->digests[d].t.size;
+    }
+    if (rc == 0) {
+	TSS_Policy_Reset(policy);
+	rc = TSS_Policy_ExtendAll(policy, TPM_CC_PolicyOR, buffer, length, NULL, 0);
+    }
+    return rc;
+}
+
+/* TSS_Policy_Signed() extends TPM2_PolicySigned.  policyRef may be NULL for an empty policyRef.
+
+   policyDigest = H(policyDigest || TPM_CC_PolicySigned || authName)
+   policyDigest = H(policyDigest || policyRef)
+*/
+
+TPM_RC TSS_Policy_Signed(TSS_POLICY *policy,
+			 const TPM2B_NAME *authName,
+			 const TPM2B_NONCE *policyRef)
+{
+    return TSS_Policy_Update(policy, TPM_CC_PolicySigned, authName, policyRef);
+}
+
+/* TSS_Policy_Secret() extends TPM2_PolicySecret.  policyRef may be NULL for an empty policyRef.
+
+   policyDigest = H(policyDigest || TPM_CC_PolicySecret || authName)
+   policyDigest = H(policyDigest || policyRef)
+*/
+
+TPM_RC TSS_Policy_Secret(TSS_POLICY *policy,
+			 const TPM2B_NAME *authName,
+			 const TPM2B_NONCE *policyRef)
+{
+    return TSS_Policy_Update(policy, TPM_CC_PolicySecret, authName, policyRef);
+}
+
+/* TSS_Policy_Authorize() extends TPM2_PolicyAuthorize.  policyRef may be NULL for an empty
+   policyRef.
+
+   policyDigest = H(0...0 || TPM_CC_PolicyAuthorize || keySignName)
+   policyDigest = H(policyDigest || policyRef)
+*/
+
+TPM_RC TSS_Policy_Authorize(TSS_POLICY *policy,
+			    const TPM2B_NAME *keySignName,
+			    const TPM2B_NONCE *policyRef)
+{
+    TSS_Policy_Reset(policy);
+    return TSS_Policy_Update(policy, TPM_CC_PolicyAuthorize, keySignName, policyRef);
+}
+
+/* TSS_Policy_AuthorizeNV() extends TPM2_PolicyAuthorizeNV
+
+   policyDigest = H(0...0 || TPM_CC_PolicyAuthorizeNV || nvIndexName)
+*/
+
+TPM_RC TSS_Policy_AuthorizeNV(TSS_POLICY *policy,
+			      const TPM2B_NAME *nvIndexName)
+{
+    TSS_Policy_Reset(policy);
+    return TSS_Policy_ExtendAll(policy, TPM_CC_PolicyAuthorizeNV,
+				nvIndexName->t.name, nvIndexName->t.size, NULL, 0);
+}
+
+/* TSS_Policy_NV() extends TPM2_PolicyNV
+
+   args = H(operandB || offset || operation)
+   policyDigest = H(policyDigest || TPM_CC_PolicyNV || args || nvIndexName)
+*/
+
+TPM_RC TSS_Policy_NV(TSS_POLICY *policy,
+		     const TPM2B_NAME *nvIndexName,
+		     const TPM2B_OPERAND *operandB,
+		     UINT16 offset,
+		     TPM_EO operation)
+{
+    TPM_RC	rc = 0;
+    uint32_t	i;
+
+    for (i = 0 ; (rc == 0) && (i < policy->count) ; i++) {
+	TPMT_HA args;
+	args.hashAlg = policy->digest[i].hashAlg;
+	rc = TSS_Policy_Args(&args, operandB, offset, operation);
+	if (rc == 0) {
+	    rc = TSS_Policy_Extend(&policy->digest[i], TPM_CC_PolicyNV,
+				   (uint8_t *)&args.digest, TSS_GetDigestSize(args.hashAlg),
+				   nvIndexName->t.name, nvIndexName->t.size);
+	}
+    }
+    return rc;
+}
+
+/* TSS_Policy_CounterTimer() extends TPM2_PolicyCounterTimer
+
+   args = H(operandB || offset || operation)
+   policyDigest = H(policyDigest || TPM_CC_PolicyCounterTimer || args)
+*/
+
+TPM_RC TSS_Policy_CounterTimer(TSS_POLICY *policy,
+			       const TPM2B_OPERAND *operandB,
+			       UINT16 offset,
+			       TPM_EO operation)
+{
+    TPM_RC	rc = 0;
+    uint32_t	i;
+
+    for (i = 0 ; (rc == 0) && (i < policy->count) ; i++) {
+	TPMT_HA args;
+	args.hashAlg = policy->digest[i].hashAlg;
+	rc = TSS_Policy_Args(&args, operandB, offset, operation);
+	if (rc == 0) {
+	    rc = TSS_Policy_Extend(&policy->digest[i], TPM_CC_PolicyCounterTimer,
+				   (uint8_t *)&args.digest, TSS_GetDigestSize(args.hashAlg),
+				   NULL, 0);
+	}
+    }
+    return rc;
+}
+
+/* TSS_Policy_CpHash() extends TPM2_PolicyCpHash
+
+   policyDigest = H(policyDigest || TPM_CC_PolicyCpHash || cpHashA)
+*/
+
+TPM_RC TSS_Policy_CpHash(TSS_POLICY *policy,
+			 const TPM2B_DIGEST *cpHashA)
+{
+    return TSS_Policy_ExtendDigest(policy, TPM_CC_PolicyCpHash, cpHashA);
+}
+
+/* TSS_Policy_NameHash() extends TPM2_PolicyNameHash
+
+   policyDigest = H(policyDigest || TPM_CC_PolicyNameHash || nameHash)
+*/
+
+TPM_RC TSS_Policy_NameHash(TSS_POLICY *policy,
+			   const TPM2B_DIGEST *nameHash)
+{
+    return TSS_Policy_ExtendDigest(policy, TPM_CC_PolicyNameHash, nameHash);
+}
+
+/* TSS_Policy_TemplateHash() extends TPM2_PolicyTemplate
+
+   policyDigest = H(policyDigest || TPM_CC_PolicyTemplate || templateHash)
+*/
+
+TPM_RC TSS_Policy_TemplateHash(TSS_POLICY *policy,
+			       const TPM2B_DIGEST *templateHash)
+{
+    return TSS_Policy_ExtendDigest(policy, TPM_CC_PolicyTemplate, templateHash);
+}
+
+/* TSS_Policy_DuplicationSelect() extends TPM2_PolicyDuplicationSelect.  objectName is ignored
+   when includeObject is NO.
+
+   policyDigest = H(policyDigest || TPM_CC_PolicyDuplicationSelect || [objectName] ||
+		    newParentName || includeObject)
+*/
+
+TPM_RC TSS_Policy_DuplicationSelect(TSS_POLICY *policy,
+				    const TPM2B_NAME *objectName,
+				    const TPM2B_NAME *newParentName,
+				    TPMI_YES_NO includeObject)
+{
+    TPM_RC	rc = 0;
+    uint16_t	length = 0;
+    uint8_t	buffer[sizeof(TPMU_NAME) + sizeof(TPMI_YES_NO)];
+
+    memcpy(buffer, newParentName->t.name, newParentName->t.size);
+    length = newParentName->t.size;
+    buffer[length] = includeObject;
+    length++;
+    if (includeObject) {
+	rc = TSS_Policy_ExtendAll(policy, TPM_CC_PolicyDuplicationSelect,
+				  objectName->t.name, objectName->t.size,
+				  buffer, length);
+    }
+    else {
+	rc = TSS_Policy_ExtendAll(policy, TPM_CC_PolicyDuplicationSelect,
+				  buffer, length, NULL, 0);
+    }
+    return rc;
+}
+
+/* TSS_Policy_Extend() extends one policy digest
+
+   digest = H(digest || commandCode || data1 || data2)
+*/
+
+static TPM_RC TSS_Policy_Extend(TPMT_HA *digest,
+				TPM_CC commandCode,
+				const uint8_t *data1,
+				uint16_t length1,
+				const uint8_t *data2,
+				uint16_t length2)
+{
+    TPM_RC	rc = 0;
+    uint16_t	digestSize = TSS_GetDigestSize(digest->hashAlg);
+    uint16_t	written = 0;
+    uint8_t	commandCodeBuffer[sizeof(TPM_CC)];
+    uint8_t	*bufferPtr = commandCodeBuffer;
+    TPMU_HA	policyDigest;
+
+    if (rc == 0) {
+	rc = TSS_TPM_CC_Marshal(&commandCode, &written, &bufferPtr, NULL);
+    }
+    if (rc == 0) {
+	memcpy((uint8_t *)&policyDigest, (uint8_t *)&digest->digest, digestSize);
+	rc = TSS_Hash_Generate(digest,
+			       digestSize, (uint8_t *)&policyDigest,
+			       written, commandCodeBuffer,
+			       length1, (data1 != NULL) ? data1 : tssPolicyEmpty,
+			       length2, (data2 != NULL) ? data2 : tssPolicyEmpty,
+			       0, NULL);
+    }
+    return rc;
+}
+
+/* TSS_Policy_ExtendAll() extends the policy digest for each hash algorithm */
+
+static TPM_RC TSS_Policy_ExtendAll(TSS_POLICY *policy,
+				   TPM_CC commandCode,
+				   const uint8_t *data1,
+				   uint16_t length1,
+				   const uint8_t *data2,
+				   uint16_t length2)
+{
+    TPM_RC	rc = 0;
+    uint32_t	i;
+
+    for (i = 0 ; (rc == 0) && (i < policy->count) ; i++) {
+	rc = TSS_Policy_Extend(&policy->digest[i], commandCode, data1, length1, data2, length2);
+    }
+    return rc;
+}
+
+/* TSS_Policy_Update() is the PolicyUpdate() common to PolicySigned, PolicySecret, and
+   PolicyAuthorize.
+
+   policyDigest = H(policyDigest || commandCode || name)
+   policyDigest = H(policyDigest || policyRef)
+*/
+
+static TPM_RC TSS_Policy_Update(TSS_POLICY *policy,
+				TPM_CC commandCode,
+				const TPM2B_NAME *name,
+				const TPM2B_NONCE *policyRef)
+{
+    TPM_RC	rc = 0;
+    uint32_t	i;
+
+    if (rc == 0) {
+	rc = TSS_Policy_ExtendAll(policy, commandCode, name->t.name, name->t.size, NULL, 0);
+    }
+    for (i = 0 ; (rc == 0) && (i < policy->count) ; i++) {
+	uint16_t digestSize = TSS_GetDigestSize(policy->digest[i].hashAlg);
+	TPMU_HA	policyDigest;
+	memcpy((uint8_t *)&policyDigest, (uint8_t *)&policy->digest[i].digest, digestSize);
+	rc = TSS_Hash_Generate(&policy->digest[i],
+			       digestSize, (uint8_t *)&policyDigest,
+			       (policyRef != NULL) ? policyRef->t.size : 0,
+			       (policyRef != NULL) ? policyRef->t.buffer : tssPolicyEmpty,
+			       0, NULL);
+    }
+    return rc;
+}
+
+/* TSS_Policy_ExtendDigest() extends a digest command parameter, which must be the size of each
+   policy hash algorithm */
+
+static TPM_RC TSS_Policy_ExtendDigest(TSS_POLICY *policy,
+				      TPM_CC commandCode,
+				      const TPM2B_DIGEST *digest)
+{
+    TPM_RC	rc = 0;
+    uint32_t	i;
+
+    for (i = 0 ; (rc == 0) && (i < policy->count) ; i++) {
+	if (digest->t.size != TSS_GetDigestSize(policy->digest[i].hashAlg)) {
+	    if (tssVerbose) printf("TSS_Policy_ExtendDigest: Digest size %u invalid for %04x\n",
+				   digest->t.size, policy->digest[i].hashAlg);
+	    rc = TSS_RC_BAD_DIGEST_SIZE;
+	}
+    }
+    if (rc == 0) {
+	rc = TSS_Policy_ExtendAll(policy, commandCode,
+				  digest->t.buffer, digest->t.size, NULL, 0);
+    }
+    return rc;
+}
+
+/* TSS_Policy_Args() calculates the args digest of PolicyNV and PolicyCounterTimer.  On call,
+   args->hashAlg is the policy hash algorithm.
+
+   args = H(operandB || offset || operation)
+*/
+
+static TPM_RC TSS_Policy_Args(TPMT_HA *args,
+			      const TPM2B_OPERAND *operandB,
+			      UINT16 offset,
+			      TPM_EO operation)
+{
+    TPM_RC	rc = 0;
+    uint16_t	written = 0;
+    uint8_t	buffer[sizeof(UINT16) + sizeof(TPM_EO)];
+    uint8_t	*bufferPtr = buffer;
+
+    if (rc == 0) {
+	rc = TSS_UINT16_Marshal(&offset, &written, &bufferPtr, NULL);
+    }
+    if (rc == 0) {
+	rc = TSS_TPM_EO_Marshal(&operation, &written, &bufferPtr, NULL);
+    }
+    if (rc == 0) {
+	rc = TSS_Hash_Generate(args,
+			       operandB->t.size, operandB->t.buffer,
+			       written, buffer,
+			       0, NULL);
+    }
+    return rc;
+}
+
+/*
+  PCR cache
+
+  PolicyPCR extends pcrDigest, a hash of the selected PCR values.  A service that repeatedly
+  satisfies the same PCR policy, e.g. to unseal, would otherwise hash the same PCR values for each
+  policy session.
+
+  The TSS context holds the PCR values returned by TPM2_PCR_Read(), and the pcrDigest values
+  calculated from them, keyed by the PCR selection and the hash algorithm.  TPM2_PCR_Extend(),
+  TPM2_PCR_Event(), and TPM2_PCR_Reset() discard the values and digests that include the PCR.
+  TPM2_Startup() discards everything.  A PCR changed through another TSS context is not seen, so
+  an application that shares the TPM should call TSS_Policy_PCRInvalidate().
+*/
+
+/* TSS_PcrCache_Init() empties the PCR cache */
+
+void TSS_PcrCache_Init(TSS_CONTEXT *tssContext)
+{
+    TSS_PCR_CACHE	*pcrCache = &tssContext->pcrCache;
+    size_t		i;
+
+    for (i = 0 ; i < HASH_COUNT ; i++) {
+	pcrCache->bank[i] = TPM_ALG_NULL;
+	pcrCache->valid[i] = 0;
+    }
+    for (i = 0 ; i < TSS_PCR_CACHE_DIGESTS ; i++) {
+	pcrCache->digest[i].pcrs.count = 0;
+    }
+    pcrCache->digestNext = 0;
+    return;
+}
+
+/* TSS_PcrCache_Read() saves the PCR values returned by TPM2_PCR_Read().  The TPM returns the values
+   in the order of pcrSelectionOut, lowest PCR first within each bank.
+*/
+
+TPM_RC TSS_PcrCache_Read(TSS_CONTEXT *tssContext,
+			 const TPML_PCR_SELECTION *pcrSelectionOut,
+			 const TPML_DIGEST *pcrValues)
+{
+    TPM_RC		rc = 0;
+    TSS_PCR_CACHE	*pcrCache = &tssContext->pcrCache;
+    uint32_t		s;		/* pcrSelectionOut iterator */
+    uint32_t		pcr;
+    uint32_t		v = 0;		/* pcrValues iterator */
+    uint32_t		pcrMask;
+    int			bank;
+
+    for (s = 0 ; (rc == 0) && (s < pcrSelectionOut->count) ; s++) {
+	const TPMS_PCR_SELECTION *pcrSelection = &pcrSelectionOut->pcrSelections[s];
+	/* the values are about to change, discard digests that use them */
+	pcrMask = 0;
+	for (pcr = 0 ; pcr < IMPLEMENTATION_PCR ; pcr++) {
+	    if (TSS_PcrCache_IsSelected(pcrSelection, pcr)) {
+		pcrMask |= 1U << pcr;
+	    }
+	}
+	TSS_PcrCache_Invalidate(tssContext, pcrMask);
+	bank = TSS_PcrCache_GetBank(tssContext, pcrSelection->hash, TRUE);
+	for (pcr = 0 ; (rc == 0) && (pcr < IMPLEMENTATION_PCR) ; pcr++) {
+	    if (pcrMask & (1U << pcr)) {
+		if (v >= pcrValues->count) {
+		    if (tssVerbose) printf("TSS_PcrCache_Read: PCR value count %u too small\n",
+					   pcrValues->count);
+		    rc = TSS_RC_MALFORMED_RESPONSE;
+		}
+		else if (bank >= 0) {
+		    pcrCache->value[bank][pcr] = pcrValues->digests[v];
+		    pcrCache->valid[bank] |= 1U << pcr;
+		}
+		v++;
+	    }
+	}
+    }
+    return rc;
+}
+
+/* TSS_PcrCache_Invalidate() discards the PCR values and digests for the PCRs in pcrMask, in all
+   banks */
+
+void TSS_PcrCache_Invalidate(TSS_CONTEXT *tssContext,
+			     uint32_t pcrMask)
+{
+    TSS_PCR_CACHE	*pcrCache = &tssContext->pcrCache;
+    size_t		i;
+    uint32_t		s;
+    uint32_t		pcr;
+
+    for (i = 0 ; i < HASH_COUNT ; i++) {
+	pcrCache->valid[i] &= ~pcrMask;
+    }
+    for (i = 0 ; i < TSS_PCR_CACHE_DIGESTS ; i++) {
+	TPML_PCR_SELECTION *pcrs = &pcrCache->digest[i].pcrs;
+	for (s = 0 ; s < pcrs->count ; s++) {
+	    for (pcr = 0 ; pcr < IMPLEMENTATION_PCR ; pcr++) {
+		if ((pcrMask & (1U << pcr)) &&
+		    TSS_PcrCache_IsSelected(&pcrs->pcrSelections[s], pcr)) {
+		    pcrs->count = 0;	/* empty entry also terminates the loops */
+		}
+	    }
+	}
+    }
+    return;
+}
+
+/* TSS_PcrCache_GetDigest() returns pcrDigest, the hashAlg hash of the PCR values selected by pcrs,
+   as used by PolicyPCR.
+
+   The digest is returned from the cache if it was already calculated.  Otherwise, it is calculated
+   from the cached PCR values and added to the cache.  Returns TSS_RC_PCR_NOT_CACHED if a selected
+   PCR value has not been read.
+*/
+
+TPM_RC TSS_PcrCache_GetDigest(TSS_CONTEXT *tssContext,
+			      TPM2B_DIGEST *pcrDigest,
+			      const TPML_PCR_SELECTION *pcrs,
+			      TPMI_ALG_HASH hashAlg)
+{
+    TPM_RC		rc = 0;
+    TSS_PCR_CACHE	*pcrCache = &tssContext->pcrCache;
+    TSS_PCR_CACHE_DIGEST *entry;
+    size_t		i;
+    uint32_t		s;
+    uint32_t		pcr;
+    int			bank;
+    int			found = FALSE;
+    TPMT_HA		digest;
+    void		*hashContext = NULL;
+
+    /* search for a digest already calculated */
+    for (i = 0 ; (i < TSS_PCR_CACHE_DIGESTS) && !found ; i++) {
+	entry = &pcrCache->digest[i];
+	if ((entry->pcrs.count != 0) &&
+	    (entry->hashAlg == hashAlg) &&
+	    TSS_PcrCache_Compare(&entry->pcrs, pcrs)) {
+	    *pcrDigest = entry->pcrDigest;
+	    found = TRUE;
+	}
+    }
+    /* hash the cached PCR values */
+    if ((rc == 0) && !found) {
+	if (pcrs->count > HASH_COUNT) {
+	    rc = TSS_RC_PCR_NOT_CACHED;
+	}
+    }
+    if ((rc == 0) && !found) {
+	digest.hashAlg = hashAlg;
+	rc = TSS_Hash_Start(&hashContext, hashAlg);
+    }
+    for (s = 0 ; (rc == 0) && !found && (s < pcrs->count) ; s++) {
+	bank = TSS_PcrCache_GetBank(tssContext, pcrs->pcrSelections[s].hash, FALSE);
+	for (pcr = 0 ; (rc == 0) && (pcr < (PCR_SELECT_MAX * 8)) ; pcr++) {
+	    if (TSS_PcrCache_IsSelected(&pcrs->pcrSelections[s], pcr)) {
+		if ((bank < 0) || (pcr >= IMPLEMENTATION_PCR) ||
+		    !(pcrCache->valid[bank] & (1U << pcr))) {
+		    if (tssVverbose) printf("TSS_PcrCache_GetDigest: PCR %u bank %04x not cached\n",
+					    pcr, pcrs->pcrSelections[s].hash);
+		    rc = TSS_RC_PCR_NOT_CACHED;
+		}
+		else {
+		    rc = TSS_Hash_Update(hashContext,
+					 pcrCache->value[bank][pcr].t.buffer,
+					 pcrCache->value[bank][pcr].t.size);
+		}
+	    }
+	}
+    }
+    if (hashContext != NULL) {
+	TPM_RC rc1 = TSS_Hash_Finish((rc == 0) ? &digest : NULL, &hashContext);
+	if (rc == 0) {
+	    rc = rc1;
+	}
+    }
+    /* add the digest to the cache, replacing the oldest entry */
+    if ((rc == 0) && !found) {
+	pcrDigest->t.size = TSS_GetDigestSize(hashAlg);
+	memcpy(pcrDigest->t.buffer, (uint8_t *)&digest.digest, pcrDigest->t.size);
+	entry = &pcrCache->digest[pcrCache->digestNext];
+	entry->pcrs = *pcrs;
+	entry->hashAlg = hashAlg;
+	entry->pcrDigest = *pcrDigest;
+	pcrCache->digestNext = (pcrCache->digestNext + 1) % TSS_PCR_CACHE_DIGESTS;
+    }
+    return rc;
+}
+
+/* TSS_Policy_PCRCached() extends TPM2_PolicyPCR using the PCR values that the TSS context has read
+   through TPM2_PCR_Read().  It is equivalent to TSS_Policy_PCR() with those values, but the
+   pcrDigest for each algorithm is only calculated once while the PCRs are unchanged.
+
+   Returns TSS_RC_PCR_NOT_CACHED if a selected PCR has not been read, or was changed since.
+*/
+
+TPM_RC TSS_Policy_PCRCached(TSS_CONTEXT *tssContext,
+			    TSS_POLICY *policy,
+			    const TPML_PCR_SELECTION *pcrs)
+{
+    TPM_RC		rc = 0;
+    uint16_t		written = 0;
+    uint8_t		buffer[sizeof(TPML_PCR_SELECTION)];
+    uint8_t		*bufferPtr = buffer;
+    TPM2B_DIGEST	pcrDigest;
+    uint32_t		i;
+
+    if (rc == 0) {
+	rc = TSS_TPML_PCR_SELECTION_Marshal(pcrs, &written, &bufferPtr, NULL);
+    }
+    for (i = 0 ; (rc == 0) && (i < policy->count) ; i++) {
+	rc = TSS_PcrCache_GetDigest(tssContext, &pcrDigest, pcrs, policy->digest[i].hashAlg);
+	if (rc == 0) {
+	    rc = TSS_Policy_Extend(&policy->digest[i], TPM_CC_PolicyPCR,
+				   buffer, written,
+				   pcrDigest.t.buffer, pcrDigest.t.size);
+	}
+    }
+    return rc;
+}
+
+/* TSS_Policy_PCRInvalidate() discards the PCR values and digests cached in the TSS context.  An
+   application should call it if PCRs may have been changed through another TSS context.
+*/
+
+void TSS_Policy_PCRInvalidate(TSS_CONTEXT *tssContext)
+{
+    TSS_PcrCache_Init(tssContext);
+    return;
+}
+
+/* TSS_PcrCache_GetBank() returns the cache bank index for the hash algorithm, adding it if add is
+   TRUE.  Returns -1 if not found or there is no free bank.
+*/
+
+static int TSS_PcrCache_GetBank(TSS_CONTEXT *tssContext,
+				TPMI_ALG_HASH hashAlg,
+				int add)
+{
+    TSS_PCR_CACHE	*pcrCache = &tssContext->pcrCache;
+    int			bank = -1;
+    int			i;
+
+    for (i = 0 ; (bank < 0) && (i < HASH_COUNT) ; i++) {
+	if (pcrCache->bank[i] == hashAlg) {
+	    bank = i;
+	}
+    }
+    for (i = 0 ; add && (bank < 0) && (i < HASH_COUNT) ; i++) {
+	if (pcrCache->bank[i] == TPM_ALG_NULL) {
+	    pcrCache->bank[i] = hashAlg;
+	    pcrCache->valid[i] = 0;
+	    bank = i;
+	}
+    }
+    return bank;
+}
+
+/* TSS_PcrCache_IsSelected() returns TRUE if pcr is selected */
+
+static int TSS_PcrCache_IsSelected(const TPMS_PCR_SELECTION *pcrSelection,
+				   uint32_t pcr)
+{
+    return (((pcr / 8) < pcrSelection->sizeofSelect) &&
+	    (pcrSelection->pcrSelect[pcr / 8] & (1 << (pcr % 8))));
+}
+
+/* TSS_PcrCache_Compare() returns TRUE if the two PCR selections select the same PCRs in the same
+   order */
+
+static int TSS_PcrCache_Compare(const TPML_PCR_SELECTION *pcrs1,
+				const TPML_PCR_SELECTION *pcrs2)
+{
+    int		match = (pcrs1->count == pcrs2->count);
+    uint32_t	s;
+    uint32_t	pcr;
+
+    for (s = 0 ; match && (s < pcrs1->count) ; s++) {
+	match = (pcrs1->pcrSelections[s].hash == pcrs2->pcrSelections[s].hash);
+	/* sizeofSelect can differ, compare the selected PCRs */
+	for (pcr = 0 ; match && (pcr < (PCR_SELECT_MAX * 8)) ; pcr++) {
+	    match = (TSS_PcrCache_IsSelected(&pcrs1->pcrSelections[s], pcr) ==
+		     TSS_PcrCache_IsSelected(&pcrs2->pcrSelections[s], pcr));
+	}
+    }
+    return match;
+}
+
+#endif	/* TPM_TSS_NOCRYPTO */
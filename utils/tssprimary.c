@@ -0,0 +1,552 @@
+/********************************************************************************/
+/*										*/
+/*			    TSS Primary Key Cache				*/
+/*		       IBM Thomas J. Watson Research Center			*/
+/*			     $Id: tssprimary.c $				*/
+/*										*/
+/* (c) Copyright IBM Corporation 2017.						*/
+/*										*/
+/* All rights reserved.								*/
+/* 										*/
+/* Redistribution and use in source and binary forms, with or without		*/
+/* modification, are permitted provided that the following conditions are	*/
+/* met:										*/
+/* 										*/
+/* Redistributions of source code must retain the above copyright notice,	*/
+/* this list of conditions and the following disclaimer.			*/
+/* 										*/
+/* Redistributions in binary form must reproduce the above copyright		*/
+/* notice, this list of conditions and the following disclaimer in the		*/
+/* documentation and/or other materials provided with the distribution.		*/
+/* 										*/
+/* Neither the names of the IBM Corporation nor the names of its		*/
+/* contributors may be used to endorse or promote products derived from		*/
+/* this software without specific prior written permission.			*/
+/* 										*/
+/* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS		*/
+/* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT		*/
+/* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR	*/
+/* A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT		*/
+/* HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,	*/
+/* SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT		*/
+/* LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,	*/
+/* DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY	*/
+/* THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT		*/
+/* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE	*/
+/* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.		*/
+/********************************************************************************/
+
+
+/* TPM2_CreatePrimary() can take seconds for an RSA key on a hardware TPM.  These functions remember
+   a primary key created from a template, so that the next request for the same primary loads a
+   saved context rather than creating the key again.
+
+   The cache is addressed by a SHA-256 digest of the hierarchy, the template, and the sensitive
+   data.  The userAuth is not part of the digest, since the cache file would then be an offline
+   dictionary attack oracle for it.  Instead, a primary key with a userAuth is never cached, so
+   that a cached key cannot be returned with a different authorization.  Each hierarchy has one cache file,
+   pxxxxxxxx.bin, in the TSS data directory, where xxxxxxxx is the hierarchy handle.  The file holds
+   up to TSS_PRIMARY_CACHE_ENTRIES entries, most recent first.  Each entry holds the saved context,
+   public area, and Name of the primary key.
+
+   TPM2_Clear(), TPM2_ChangePPS(), and TPM2_ChangeEPS() invalidate the saved contexts of the
+   affected hierarchies, so the TSS deletes those cache files.  If a context load fails for any
+   other reason, the entry is removed and the primary key is created again.
+
+   Primary keys in the null hierarchy are not cached, since the null seed changes at each TPM
+   reset.
+
+   Loading a saved context does not require the hierarchy authorization.  The authorization is
+   checked when the primary key is first created.
+
+   The cache requires file and crypto support.  Without them, the functions always create the
+   primary key.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <tss2/tss.h>
+#include <tss2/tssutils.h>
+#include <tss2/tsserror.h>
+#include <tss2/tssfile.h>
+#include <tss2/tssmarshal.h>
+#include <tss2/Unmarshal_fp.h>
+#include <tss2/tssprimary.h>
+#include "tssproperties.h"
+#ifndef TPM_TSS_NOCRYPTO
+#include <tss2/tsscryptoh.h>
+#endif
+
+#define TSS_PRIMARY_CACHE_ENTRIES	8
+
+extern int tssVerbose;
+extern int tssVverbose;
+
+#if !defined TPM_TSS_NOFILE && !defined TPM_TSS_NOCRYPTO
+
+typedef struct {
+    TPM2B_DIGEST	key;		/* digest of the CreatePrimary parameters */
+    TPMS_CONTEXT	context;	/* saved context of the primary key */
+    TPM2B_PUBLIC	outPublic;
+    TPM2B_NAME		name;
+} TSS_PRIMARY_CACHE_ENTRY;
+
+/* local prototypes */
+
+static TPM_RC TSS_PrimaryCache_Key(TPM2B_DIGEST *key,
+				   CreatePrimary_In *in);
+static TPM_RC TSS_PrimaryCache_Lookup(TSS_CONTEXT *tssContext,
+				      TSS_PRIMARY_CACHE_ENTRY *entry,
+				      int *found,
+				      TPMI_RH_HIERARCHY hierarchy,
+				      const TPM2B_DIGEST *key);
+static TPM_RC TSS_PrimaryCache_Update(TSS_CONTEXT *tssContext,
+				      TPMI_RH_HIERARCHY hierarchy,
+				      const TPM2B_DIGEST *key,
+				      const TSS_PRIMARY_CACHE_ENTRY *newEntry);
+static TPM_RC TSS_PrimaryCache_Load(TSS_CONTEXT *tssContext,
+				    CreatePrimary_Out *out,
+				    const TSS_PRIMARY_CACHE_ENTRY *entry);
+static TPM_RC TSS_PrimaryCache_Save(TSS_CONTEXT *tssContext,
+				    TPMI_RH_HIERARCHY hierarchy,
+				    const TPM2B_DIGEST *key,
+				    const CreatePrimary_Out *out);
+static TPM_RC TSS_PrimaryCache_EntryMarshal(const TSS_PRIMARY_CACHE_ENTRY *entry,
+					    uint16_t *written,
+					    uint8_t **buffer,
+					    INT32 *size);
+static TPM_RC TSS_PrimaryCache_EntryUnmarshal(TSS_PRIMARY_CACHE_ENTRY *entry,
+					      uint8_t **buffer,
+					      INT32 *size);
+static void TSS_PrimaryCache_Filename(TSS_CONTEXT *tssContext,
+				      char *filename,
+				      TPMI_RH_HIERARCHY hierarchy);
+
+#endif
+
+/* TSS_PrimaryCache_CreatePrimary() returns a loaded primary key for the CreatePrimary parameters
+   in.
+
+   If the primary key is in the cache, its saved context is loaded and cached is set TRUE.  The
+   creationData, creationHash, and creationTicket are not available, and are returned empty.
+
+   Otherwise, TPM2_CreatePrimary() is run with the sessions, cached is set FALSE, and the new
+   primary key is saved in the cache.  A primary key in the null hierarchy or with a userAuth is
+   never cached.
+
+   In both cases, the caller owns the loaded handle in out->objectHandle and should flush it when
+   done.
+*/
+
+TPM_RC TSS_PrimaryCache_CreatePrimary(TSS_CONTEXT *tssContext,
+				      CreatePrimary_Out *out,
+				      int *cached,
+				      CreatePrimary_In *in,
+				      TPMI_SH_AUTH_SESSION sessionHandle0,
+				      const char *password0,
+				      unsigned int sessionAttributes0,
+				      TPMI_SH_AUTH_SESSION sessionHandle1,
+				      unsigned int sessionAttributes1,
+				      TPMI_SH_AUTH_SESSION sessionHandle2,
+				      unsigned int sessionAttributes2)
+{
+    TPM_RC			rc = 0;
+#if !defined TPM_TSS_NOFILE && !defined TPM_TSS_NOCRYPTO
+    int				cacheable = ((in->primaryHandle != TPM_RH_NULL) &&
+					     (in->inSensitive.sensitive.userAuth.t.size == 0));
+    TPM2B_DIGEST		key;
+    TSS_PRIMARY_CACHE_ENTRY	*entry = NULL;
+    int				found = FALSE;
+#endif
+
+    *cached = FALSE;
+#if !defined TPM_TSS_NOFILE && !defined TPM_TSS_NOCRYPTO
+    if ((rc == 0) && cacheable) {
+	rc = TSS_PrimaryCache_Key(&key, in);
+    }
+    if ((rc == 0) && cacheable) {
+	rc = TSS_Malloc((unsigned char **)&entry, sizeof(TSS_PRIMARY_CACHE_ENTRY));	/* freed @1 */
+    }
+    /* a missing or bad cache file is a cache miss */
+    if ((rc == 0) && cacheable) {
+	if (TSS_PrimaryCache_Lookup(tssContext, entry, &found, in->primaryHandle, &key) != 0) {
+	    found = FALSE;
+	}
+    }
+    if ((rc == 0) && found) {
+	if (TSS_PrimaryCache_Load(tssContext, out, entry) == 0) {
+	    if (tssVverbose) printf("TSS_PrimaryCache_CreatePrimary: Loaded handle %08x\n",
+				    out->objectHandle);
+	    *cached = TRUE;
+	}
+	/* the saved context is no longer valid, create the primary key again */
+	else {
+	    if (tssVverbose) printf("TSS_PrimaryCache_CreatePrimary: Stale entry removed\n");
+	    TSS_PrimaryCache_Update(tssContext, in->primaryHandle, &key, NULL);
+	}
+    }
+#endif
+    if ((rc == 0) && !(*cached)) {
+	rc = TSS_Execute(tssContext,
+			 (RESPONSE_PARAMETERS *)out,
+			 (COMMAND_PARAMETERS *)in,
+			 NULL,
+			 TPM_CC_CreatePrimary,
+			 sessionHandle0, password0, sessionAttributes0,
+			 sessionHandle1, NULL, sessionAttributes1,
+			 sessionHandle2, NULL, sessionAttributes2,
+			 TPM_RH_NULL, NULL, 0);
+    }
+#if !defined TPM_TSS_NOFILE && !defined TPM_TSS_NOCRYPTO
+    /* failure to cache the primary key is not an error, it will be created next time */
+    if ((rc == 0) && !(*cached) && cacheable) {
+	TPM_RC rc1 = TSS_PrimaryCache_Save(tssContext, in->primaryHandle, &key, out);
+	if (rc1 != 0) {
+	    if (tssVerbose) printf("TSS_PrimaryCache_CreatePrimary: Cache save failed, rc %08x\n",
+				   rc1);
+	}
+    }
+    free(entry);	/* @1 */
+#endif
+    return rc;
+}
+
+/* TSS_PrimaryCache_Invalidate() removes all cached primary keys for the hierarchy.
+
+   The TSS calls this after TPM2_Clear(), TPM2_ChangePPS(), and TPM2_ChangeEPS().  An application
+   should call it if it changes a primary seed through another path.
+*/
+
+TPM_RC TSS_PrimaryCache_Invalidate(TSS_CONTEXT *tssContext,
+				   TPMI_RH_HIERARCHY hierarchy)
+{
+    TPM_RC		rc = 0;
+#if !defined TPM_TSS_NOFILE && !defined TPM_TSS_NOCRYPTO
+    char		filename[128];
+
+    if (tssVverbose) printf("TSS_PrimaryCache_Invalidate: hierarchy %08x\n", hierarchy);
+    TSS_PrimaryCache_Filename(tssContext, filename, hierarchy);
+    /* the file may not exist */
+    TSS_File_DeleteFile(filename);
+#else
+    tssContext = tssContext;
+    hierarchy = hierarchy;
+#endif
+    return rc;
+}
+
+#if !defined TPM_TSS_NOFILE && !defined TPM_TSS_NOCRYPTO
+
+/* TSS_PrimaryCache_Key() calculates the cache key, a SHA-256 digest of the marshaled hierarchy,
+   template, and sensitive data.
+
+   The userAuth is deliberately omitted, so that the cache file reveals nothing about it.
+*/
+
+static TPM_RC TSS_PrimaryCache_Key(TPM2B_DIGEST *key,
+				   CreatePrimary_In *in)
+{
+    TPM_RC		rc = 0;
+    uint16_t		written = 0;
+    uint8_t		*buffer = NULL;
+    uint16_t		hierarchyWritten = 0;
+    uint8_t		hierarchyBuffer[sizeof(TPMI_RH_HIERARCHY)];
+    uint16_t		dataWritten = 0;
+    uint8_t		*dataBuffer = NULL;
+    TPMT_HA		digest;
+
+    if (rc == 0) {
+	uint8_t *buffer1 = hierarchyBuffer;
+	INT32 size1 = sizeof(hierarchyBuffer);
+	rc = TSS_TPMI_RH_HIERARCHY_Marshal(&in->primaryHandle, &hierarchyWritten,
+					   &buffer1, &size1);
+    }
+    if (rc == 0) {
+	rc = TSS_Structure_Marshal(&buffer,	/* freed @1 */
+				   &written,
+				   &in->inPublic,
+				   (MarshalFunction_t)TSS_TPM2B_PUBLIC_Marshal);
+    }
+    if (rc == 0) {
+	rc = TSS_Structure_Marshal(&dataBuffer,	/* freed @2 */
+				   &dataWritten,
+				   &in->inSensitive.sensitive.data,
+				   (MarshalFunction_t)TSS_TPM2B_SENSITIVE_DATA_Marshal);
+    }
+    if (rc == 0) {
+	digest.hashAlg = TPM_ALG_SHA256;
+	rc = TSS_Hash_Generate(&digest,
+			       hierarchyWritten, hierarchyBuffer,
+			       written, buffer,
+			       dataWritten, dataBuffer,
+			       0, NULL);
+    }
+    if (rc == 0) {
+	rc = TSS_TPM2B_Create(&key->b, (uint8_t *)&digest.digest, SHA256_DIGEST_SIZE,
+			      sizeof(key->t.buffer));
+    }
+    free(buffer);	/* @1 */
+    free(dataBuffer);	/* @2 */
+    return rc;
+}
+
+/* TSS_PrimaryCache_Lookup() searches the hierarchy cache file for key */
+
+static TPM_RC TSS_PrimaryCache_Lookup(TSS_CONTEXT *tssContext,
+				      TSS_PRIMARY_CACHE_ENTRY *entry,
+				      int *found,
+				      TPMI_RH_HIERARCHY hierarchy,
+				      const TPM2B_DIGEST *key)
+{
+    TPM_RC		rc = 0;
+    char		filename[128];
+    uint8_t		*buffer = NULL;
+    size_t		length;
+    uint8_t		*buffer1;
+    INT32		size1;
+    uint32_t		count;
+    uint32_t		i;
+
+    *found = FALSE;
+    if (rc == 0) {
+	TSS_PrimaryCache_Filename(tssContext, filename, hierarchy);
+	rc = TSS_File_ReadBinaryFile(&buffer,     /* freed @1 */
+				     &length,
+				     filename);
+    }
+    if (rc == 0) {
+	buffer1 = buffer;
+	size1 = length;
+	rc = UINT32_Unmarshal(&count, &buffer1, &size1);
+    }
+    for (i = 0 ; (rc == 0) && (i < count) && !(*found) ; i++) {
+	rc = TSS_PrimaryCache_EntryUnmarshal(entry, &buffer1, &size1);
+	if (rc == 0) {
+	    *found = ((entry->key.t.size == key->t.size) &&
+		      (memcmp(entry->key.t.buffer, key->t.buffer, key->t.size) == 0));
+	}
+    }
+    free(buffer);	/* @1 */
+    return rc;
+}
+
+/* TSS_PrimaryCache_Update() rewrites the hierarchy cache file with newEntry first, followed by the
+   existing entries other than key.  If newEntry is NULL, the entry for key is removed.
+
+   The oldest entries are dropped when the file is full.
+*/
+
+static TPM_RC TSS_PrimaryCache_Update(TSS_CONTEXT *tssContext,
+				      TPMI_RH_HIERARCHY hierarchy,
+				      const TPM2B_DIGEST *key,
+				      const TSS_PRIMARY_CACHE_ENTRY *newEntry)
+{
+    TPM_RC			rc = 0;
+    char			filename[128];
+    uint8_t			*oldBuffer = NULL;
+    size_t			oldLength;
+    uint8_t			*newBuffer = NULL;
+    uint32_t			newSize = sizeof(uint32_t) +
+				  (TSS_PRIMARY_CACHE_ENTRIES * sizeof(TSS_PRIMARY_CACHE_ENTRY));
+    TSS_PRIMARY_CACHE_ENTRY	*entry = NULL;
+    uint16_t			written = 0;
+    uint8_t			*buffer1;
+    INT32			size1;
+    uint32_t			count = 0;
+
+    if (rc == 0) {
+	TSS_PrimaryCache_Filename(tssContext, filename, hierarchy);
+	rc = TSS_Malloc(&newBuffer, newSize);		/* freed @1 */
+    }
+    if (rc == 0) {
+	rc = TSS_Malloc((unsigned char **)&entry, sizeof(TSS_PRIMARY_CACHE_ENTRY));	/* freed @2 */
+    }
+    /* leave room for the count, marshaled last */
+    if (rc == 0) {
+	buffer1 = newBuffer + sizeof(uint32_t);
+	size1 = newSize - sizeof(uint32_t);
+    }
+    if ((rc == 0) && (newEntry != NULL)) {
+	rc = TSS_PrimaryCache_EntryMarshal(newEntry, &written, &buffer1, &size1);
+	count++;
+    }
+    /* copy the existing entries.  A missing file has no entries, and a bad entry ends the list. */
+    if (rc == 0) {
+	uint8_t		*oldBuffer1;
+	INT32		oldSize1;
+	uint32_t	oldCount = 0;
+	uint32_t	i;
+	TPM_RC		rc1 = TSS_File_ReadBinaryFile(&oldBuffer,     /* freed @3 */
+						      &oldLength,
+						      filename);
+	if (rc1 == 0) {
+	    oldBuffer1 = oldBuffer;
+	    oldSize1 = oldLength;
+	    rc1 = UINT32_Unmarshal(&oldCount, &oldBuffer1, &oldSize1);
+	}
+	for (i = 0 ; (rc == 0) && (rc1 == 0) && (i < oldCount) &&
+		 (count < TSS_PRIMARY_CACHE_ENTRIES) ; i++) {
+	    rc1 = TSS_PrimaryCache_EntryUnmarshal(entry, &oldBuffer1, &oldSize1);
+	    if ((rc1 == 0) &&
+		((entry->key.t.size != key->t.size) ||
+		 (memcmp(entry->key.t.buffer, key->t.buffer, key->t.size) != 0))) {
+		rc = TSS_PrimaryCache_EntryMarshal(entry, &written, &buffer1, &size1);
+		count++;
+	    }
+	}
+    }
+    if (rc == 0) {
+	uint16_t countWritten = 0;
+	buffer1 = newBuffer;
+	size1 = sizeof(uint32_t);
+	rc = TSS_UINT32_Marshal(&count, &countWritten, &buffer1, &size1);
+    }
+    if (rc == 0) {
+	if (count > 0) {
+	    rc = TSS_File_WriteBinaryFile(newBuffer, written + sizeof(uint32_t), filename);
+	}
+	else {
+	    TSS_File_DeleteFile(filename);
+	}
+    }
+    free(newBuffer);	/* @1 */
+    free(entry);	/* @2 */
+    free(oldBuffer);	/* @3 */
+    return rc;
+}
+
+/* TSS_PrimaryCache_Load() loads the saved context of the cached primary key */
+
+static TPM_RC TSS_PrimaryCache_Load(TSS_CONTEXT *tssContext,
+				    CreatePrimary_Out *out,
+				    const TSS_PRIMARY_CACHE_ENTRY *entry)
+{
+    TPM_RC			rc = 0;
+    ContextLoad_In 		in;
+    ContextLoad_Out 		outLoad;
+
+    if (rc == 0) {
+	in.context = entry->context;
+	outLoad.loadedHandle = 0;
+	rc = TSS_Execute(tssContext,
+			 (RESPONSE_PARAMETERS *)&outLoad,
+			 (COMMAND_PARAMETERS *)&in,
+			 NULL,
+			 TPM_CC_ContextLoad,
+			 TPM_RH_NULL, NULL, 0);
+	/* if the TSS post processing failed, the object is loaded and must be flushed */
+	if ((rc != 0) && (outLoad.loadedHandle != 0)) {
+	    FlushContext_In inFlush;
+	    inFlush.flushHandle = outLoad.loadedHandle;
+	    TSS_Execute(tssContext,
+			NULL,
+			(COMMAND_PARAMETERS *)&inFlush,
+			NULL,
+			TPM_CC_FlushContext,
+			TPM_RH_NULL, NULL, 0);
+	}
+    }
+    if (rc == 0) {
+	out->objectHandle = outLoad.loadedHandle;
+	out->outPublic = entry->outPublic;
+	out->name = entry->name;
+	out->creationData.size = 0;
+	out->creationHash.t.size = 0;
+	out->creationTicket.tag = TPM_ST_CREATION;
+	out->creationTicket.hierarchy = TPM_RH_NULL;
+	out->creationTicket.digest.t.size = 0;
+    }
+    return rc;
+}
+
+/* TSS_PrimaryCache_Save() saves the context of a newly created primary key and adds it to the
+   hierarchy cache file */
+
+static TPM_RC TSS_PrimaryCache_Save(TSS_CONTEXT *tssContext,
+				    TPMI_RH_HIERARCHY hierarchy,
+				    const TPM2B_DIGEST *key,
+				    const CreatePrimary_Out *out)
+{
+    TPM_RC			rc = 0;
+    ContextSave_In 		in;
+    ContextSave_Out 		outSave;
+    TSS_PRIMARY_CACHE_ENTRY	*entry = NULL;
+
+    if (rc == 0) {
+	rc = TSS_Malloc((unsigned char **)&entry, sizeof(TSS_PRIMARY_CACHE_ENTRY));	/* freed @1 */
+    }
+    if (rc == 0) {
+	in.saveHandle = out->objectHandle;
+	rc = TSS_Execute(tssContext,
+			 (RESPONSE_PARAMETERS *)&outSave,
+			 (COMMAND_PARAMETERS *)&in,
+			 NULL,
+			 TPM_CC_ContextSave,
+			 TPM_RH_NULL, NULL, 0);
+    }
+    if (rc == 0) {
+	entry->key = *key;
+	entry->context = outSave.context;
+	entry->outPublic = out->outPublic;
+	entry->name = out->name;
+	rc = TSS_PrimaryCache_Update(tssContext, hierarchy, key, entry);
+    }
+    free(entry);	/* @1 */
+    return rc;
+}
+
+static TPM_RC TSS_PrimaryCache_EntryMarshal(const TSS_PRIMARY_CACHE_ENTRY *entry,
+					    uint16_t *written,
+					    uint8_t **buffer,
+					    INT32 *size)
+{
+    TPM_RC		rc = 0;
+    if (rc == 0) {
+	rc = TSS_TPM2B_DIGEST_Marshal(&entry->key, written, buffer, size);
+    }
+    if (rc == 0) {
+	rc = TSS_TPMS_CONTEXT_Marshal(&entry->context, written, buffer, size);
+    }
+    if (rc == 0) {
+	rc = TSS_TPM2B_PUBLIC_Marshal(&entry->outPublic, written, buffer, size);
+    }
+    if (rc == 0) {
+	rc = TSS_TPM2B_NAME_Marshal(&entry->name, written, buffer, size);
+    }
+    return rc;
+}
+
+static TPM_RC TSS_PrimaryCache_EntryUnmarshal(TSS_PRIMARY_CACHE_ENTRY *entry,
+					      uint8_t **buffer,
+					      INT32 *size)
+{
+    TPM_RC		rc = 0;
+    if (rc == 0) {
+	rc = TPM2B_DIGEST_Unmarshal(&entry->key, buffer, size);
+    }
+    if (rc == 0) {
+	rc = TPMS_CONTEXT_Unmarshal(&entry->context, buffer, size);
+    }
+    if (rc == 0) {
+	rc = TPM2B_PUBLIC_Unmarshal(&entry->outPublic, buffer, size, NO);
+    }
+    if (rc == 0) {
+	rc = TPM2B_NAME_Unmarshal(&entry->name, buffer, size);
+    }
+    return rc;
+}
+
+/* TSS_PrimaryCache_Filename() returns the cache file name for the hierarchy.  filename must be
+   128 bytes, the TSS limit for data directory file names. */
+
+static void TSS_PrimaryCache_Filename(TSS_CONTEXT *tssContext,
+				      char *filename,
+				      TPMI_RH_HIERARCHY hierarchy)
+{
+    sprintf(filename, "%s/p%08x.bin", tssContext->tssDataDirectory, hierarchy);
+    return;
+}
+
+#endif
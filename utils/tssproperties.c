@@ -51,6 +51,7 @@
 #include <tss2/tssprint.h>
 
 #include "tssproperties.h"
+#include "tssreplay.h"
 
 /* local prototypes */
 
@@ -63,6 +64,18 @@ static TPM_RC TSS_SetServerType(TSS_CONTEXT *tssContext, const char *value);
 static TPM_RC TSS_SetInterfaceType(TSS_CONTEXT *tssContext, const char *value);
 static TPM_RC TSS_SetDevice(TSS_CONTEXT *tssContext, const char *value);
 static TPM_RC TSS_SetEncryptSessions(TSS_CONTEXT *tssContext, const char *value);
+static TPM_RC TSS_SetRetryCount(TSS_CONTEXT *tssContext, const char *value);
+static TPM_RC TSS_SetRetryDelay(TSS_CONTEXT *tssContext, const char *value);
+static TPM_RC TSS_SetPolicyEmulate(TSS_CONTEXT *tssContext, const char *value);
+static TPM_RC TSS_SetLocality(TSS_CONTEXT *tssContext, const char *value);
+static TPM_RC TSS_SetCorpusDirectory(TSS_CONTEXT *tssContext, const char *value);
+static TPM_RC TSS_SetDeviceTimeout(TSS_CONTEXT *tssContext, const char *value);
+static TPM_RC TSS_SetDeviceTimeoutLong(TSS_CONTEXT *tssContext, const char *value);
+static TPM_RC TSS_SetSchedulerPriority(TSS_CONTEXT *tssContext, const char *value);
+static TPM_RC TSS_SetSchedulerDeadline(TSS_CONTEXT *tssContext, const char *value);
+static TPM_RC TSS_SetReplayFile(TSS_CONTEXT *tssContext, const char *value);
+static TPM_RC TSS_SetConnectRetryCount(TSS_CONTEXT *tssContext, const char *value);
+static TPM_RC TSS_SetConnectRetryDelay(TSS_CONTEXT *tssContext, const char *value);
 
 /* globals for the library */
 
@@ -118,6 +131,54 @@ int tssFirstCall = TRUE;
 #define TPM_ENCRYPT_SESSIONS_DEFAULT	"1"
 #endif
 
+#ifndef TPM_RETRY_COUNT_DEFAULT
+#define TPM_RETRY_COUNT_DEFAULT		"5"		/* resends of TPM_RC_RETRY etc. */
+#endif
+
+#ifndef TPM_RETRY_DELAY_DEFAULT
+#define TPM_RETRY_DELAY_DEFAULT		"10"		/* first resend delay in msec */
+#endif
+
+#ifndef TPM_POLICY_EMULATE_DEFAULT
+#define TPM_POLICY_EMULATE_DEFAULT	"0"		/* trial sessions use the TPM */
+#endif
+
+#ifndef TPM_LOCALITY_DEFAULT
+#define TPM_LOCALITY_DEFAULT		"0"		/* commands at locality 0 */
+#endif
+
+#ifndef TPM_CORPUS_DIR_DEFAULT
+#define TPM_CORPUS_DIR_DEFAULT		""		/* do not save commands and responses */
+#endif
+
+#ifndef TPM_DEVICE_TIMEOUT_DEFAULT
+#define TPM_DEVICE_TIMEOUT_DEFAULT	"20000"		/* device response timeout in msec */
+#endif
+
+#ifndef TPM_DEVICE_TIMEOUT_LONG_DEFAULT
+#define TPM_DEVICE_TIMEOUT_LONG_DEFAULT	"300000"	/* the same for key generation */
+#endif
+
+#ifndef TPM_SCHEDULER_PRIORITY_DEFAULT
+#define TPM_SCHEDULER_PRIORITY_DEFAULT	"8"		/* 0 is the highest priority */
+#endif
+
+#ifndef TPM_SCHEDULER_DEADLINE_DEFAULT
+#define TPM_SCHEDULER_DEADLINE_DEFAULT	"0"		/* no deadline */
+#endif
+
+#ifndef TPM_REPLAY_FILE_DEFAULT
+#define TPM_REPLAY_FILE_DEFAULT		""		/* do not record commands and responses */
+#endif
+
+#ifndef TPM_CONNECT_RETRY_COUNT_DEFAULT
+#define TPM_CONNECT_RETRY_COUNT_DEFAULT	"0"		/* a refused socket connect fails at once */
+#endif
+
+#ifndef TPM_CONNECT_RETRY_DELAY_DEFAULT
+#define TPM_CONNECT_RETRY_DELAY_DEFAULT	"10"		/* first reconnect delay in msec */
+#endif
+
 /* TSS_GlobalProperties_Init() sets the global verbose trace flags at the first entry points to the
    TSS */
 
@@ -164,10 +225,43 @@ TPM_RC TSS_Properties_Init(TSS_CONTEXT *tssContext)
 #ifndef TPM_TSS_NOCRYPTO
 	tssContext->tssSessionEncKey = NULL;
 	tssContext->tssSessionDecKey = NULL;
+	{
+	    size_t i;
+	    for (i = 0 ; i < TSS_NAME_CACHE_SIZE ; i++) {
+		tssContext->nameCache[i].publicSize = 0;
+	    }
+	}
+	tssContext->nameCacheNext = 0;
+	tssContext->nameCacheHits = 0;
+	tssContext->nameCacheMisses = 0;
+	TSS_PcrCache_Init(tssContext);
 #endif
+	tssContext->tssHoldSessions = FALSE;
+	TSS_MarshalBuffer_Init(&tssContext->sessionMarshalBuffer);
+	tssContext->tssRetryResends = 0;
+	tssContext->tssRetryExhausted = 0;
+	tssContext->tssSocketCommands = 0;
+	tssContext->tssSocketWrites = 0;
+	tssContext->tssSocketReads = 0;
+	tssContext->tssDevCommands = 0;
+	tssContext->tssDevTimeouts = 0;
+	tssContext->tssDevWaitTime = 0;
+	tssContext->tssDevProcessTime = 0;
+	tssContext->tssScheduler = NULL;
+	tssContext->tssReplayRecordFile = NULL;
+	tssContext->tssReplayBuffer = NULL;
+	tssContext->tssReplayLength = 0;
+	tssContext->tssReplayOffset = 0;
+	tssContext->tssReplayRecordRc = 0;
+    }
+    /* capability cache */
+    {
+	size_t i;
+	for (i = 0 ; i < (sizeof(tssContext->capabilityCache) / sizeof(TSS_CAPABILITY_CACHE)) ; i++) {
+	    tssContext->capabilityCache[i].valid = FALSE;
+	}
     }
-    /* for a minimal TSS with no file support */
-#ifdef TPM_TSS_NOFILE
+    /* for a minimal TSS with no file support, or for held sessions */
     {
 	size_t i;
 	for (i = 0 ; i < (sizeof(tssContext->sessions) / sizeof(TSS_SESSIONS)) ; i++) {
@@ -175,6 +269,11 @@ TPM_RC TSS_Properties_Init(TSS_CONTEXT *tssContext)
 	    tssContext->sessions[i].sessionData = NULL;
 	    tssContext->sessions[i].sessionDataLength = 0;
 	}
+    }
+    /* for a minimal TSS with no file support */
+#ifdef TPM_TSS_NOFILE
+    {
+	size_t i;
 	for (i = 0 ; i < (sizeof(tssContext->objectPublic) / sizeof(TSS_OBJECT_PUBLIC)) ; i++) {
 	    tssContext->objectPublic[i].objectHandle = TPM_RH_NULL;
 	}
@@ -223,6 +322,63 @@ TPM_RC TSS_Properties_Init(TSS_CONTEXT *tssContext)
 	value = getenv("TPM_DEVICE");
 	rc = TSS_SetDevice(tssContext, value);
     }
+    /* TPM device response timeouts */
+    if (rc == 0) {
+	value = getenv("TPM_DEVICE_TIMEOUT");
+	rc = TSS_SetDeviceTimeout(tssContext, value);
+    }
+    if (rc == 0) {
+	value = getenv("TPM_DEVICE_TIMEOUT_LONG");
+	rc = TSS_SetDeviceTimeoutLong(tssContext, value);
+    }
+    /* command order when the connection is shared, see TSS_SetScheduler() */
+    if (rc == 0) {
+	value = getenv("TPM_SCHEDULER_PRIORITY");
+	rc = TSS_SetSchedulerPriority(tssContext, value);
+    }
+    if (rc == 0) {
+	value = getenv("TPM_SCHEDULER_DEADLINE");
+	rc = TSS_SetSchedulerDeadline(tssContext, value);
+    }
+    /* resends of commands that the TPM did not start */
+    if (rc == 0) {
+	value = getenv("TPM_RETRY_COUNT");
+	rc = TSS_SetRetryCount(tssContext, value);
+    }
+    if (rc == 0) {
+	value = getenv("TPM_RETRY_DELAY");
+	rc = TSS_SetRetryDelay(tssContext, value);
+    }
+    /* socket reconnects while the server is not accepting connections */
+    if (rc == 0) {
+	value = getenv("TPM_CONNECT_RETRY_COUNT");
+	rc = TSS_SetConnectRetryCount(tssContext, value);
+    }
+    if (rc == 0) {
+	value = getenv("TPM_CONNECT_RETRY_DELAY");
+	rc = TSS_SetConnectRetryDelay(tssContext, value);
+    }
+    /* trial sessions and policy digests in the TSS */
+    if (rc == 0) {
+	value = getenv("TPM_POLICY_EMULATE");
+	rc = TSS_SetPolicyEmulate(tssContext, value);
+    }
+    /* command locality */
+    if (rc == 0) {
+	value = getenv("TPM_LOCALITY");
+	rc = TSS_SetLocality(tssContext, value);
+    }
+    /* command and response capture */
+    if (rc == 0) {
+	tssContext->tssCorpusCount = 0;
+	value = getenv("TPM_CORPUS_DIR");
+	rc = TSS_SetCorpusDirectory(tssContext, value);
+    }
+    /* command and response trace record and replay */
+    if (rc == 0) {
+	value = getenv("TPM_REPLAY_FILE");
+	rc = TSS_SetReplayFile(tssContext, value);
+    }
     return rc;
 }
 
@@ -281,6 +437,42 @@ TPM_RC TSS_SetProperty(TSS_CONTEXT *tssContext,
 	  case TPM_ENCRYPT_SESSIONS:
 	    rc = TSS_SetEncryptSessions(tssContext, value);
 	    break;
+	  case TPM_RETRY_COUNT:
+	    rc = TSS_SetRetryCount(tssContext, value);
+	    break;
+	  case TPM_RETRY_DELAY:
+	    rc = TSS_SetRetryDelay(tssContext, value);
+	    break;
+	  case TPM_POLICY_EMULATE:
+	    rc = TSS_SetPolicyEmulate(tssContext, value);
+	    break;
+	  case TPM_LOCALITY:
+	    rc = TSS_SetLocality(tssContext, value);
+	    break;
+	  case TPM_CORPUS_DIR:
+	    rc = TSS_SetCorpusDirectory(tssContext, value);
+	    break;
+	  case TPM_DEVICE_TIMEOUT:
+	    rc = TSS_SetDeviceTimeout(tssContext, value);
+	    break;
+	  case TPM_DEVICE_TIMEOUT_LONG:
+	    rc = TSS_SetDeviceTimeoutLong(tssContext, value);
+	    break;
+	  case TPM_SCHEDULER_PRIORITY:
+	    rc = TSS_SetSchedulerPriority(tssContext, value);
+	    break;
+	  case TPM_SCHEDULER_DEADLINE:
+	    rc = TSS_SetSchedulerDeadline(tssContext, value);
+	    break;
+	  case TPM_REPLAY_FILE:
+	    rc = TSS_SetReplayFile(tssContext, value);
+	    break;
+	  case TPM_CONNECT_RETRY_COUNT:
+	    rc = TSS_SetConnectRetryCount(tssContext, value);
+	    break;
+	  case TPM_CONNECT_RETRY_DELAY:
+	    rc = TSS_SetConnectRetryDelay(tssContext, value);
+	    break;
 	  default:
 	    rc = TSS_RC_BAD_PROPERTY;
 	}
@@ -491,3 +683,325 @@ static TPM_RC TSS_SetEncryptSessions(TSS_CONTEXT *tssContext, const char *value)
     }
     return rc;
 }
+
+/* TSS_SetDeviceTimeout() sets the time in msec that the device interface waits for a response.
+   0 waits forever.
+*/
+
+static TPM_RC TSS_SetDeviceTimeout(TSS_CONTEXT *tssContext, const char *value)
+{
+    TPM_RC		rc = 0;
+    int			irc;
+
+    if (rc == 0) {
+	if (value == NULL) {
+	    value = TPM_DEVICE_TIMEOUT_DEFAULT;
+	}
+    }
+    if (rc == 0) {
+	irc = sscanf(value, "%u", &tssContext->tssDeviceTimeout);
+	if (irc != 1) {
+	    if (tssVerbose) printf("TSS_SetDeviceTimeout: Error, value invalid\n");
+	    rc = TSS_RC_BAD_PROPERTY_VALUE;
+	}
+    }
+    return rc;
+}
+
+/* TSS_SetDeviceTimeoutLong() sets the response timeout in msec for commands that generate a key,
+   which can take minutes for RSA.  0 waits forever.
+*/
+
+static TPM_RC TSS_SetDeviceTimeoutLong(TSS_CONTEXT *tssContext, const char *value)
+{
+    TPM_RC		rc = 0;
+    int			irc;
+
+    if (rc == 0) {
+	if (value == NULL) {
+	    value = TPM_DEVICE_TIMEOUT_LONG_DEFAULT;
+	}
+    }
+    if (rc == 0) {
+	irc = sscanf(value, "%u", &tssContext->tssDeviceTimeoutLong);
+	if (irc != 1) {
+	    if (tssVerbose) printf("TSS_SetDeviceTimeoutLong: Error, value invalid\n");
+	    rc = TSS_RC_BAD_PROPERTY_VALUE;
+	}
+    }
+    return rc;
+}
+
+/* TSS_SetSchedulerPriority() sets the priority of the following commands when the context has a
+   scheduler.  Lower values are sent first.
+*/
+
+static TPM_RC TSS_SetSchedulerPriority(TSS_CONTEXT *tssContext, const char *value)
+{
+    TPM_RC		rc = 0;
+    int			irc;
+
+    if (rc == 0) {
+	if (value == NULL) {
+	    value = TPM_SCHEDULER_PRIORITY_DEFAULT;
+	}
+    }
+    if (rc == 0) {
+	irc = sscanf(value, "%u", &tssContext->tssSchedulerPriority);
+	if (irc != 1) {
+	    if (tssVerbose) printf("TSS_SetSchedulerPriority: Error, value invalid\n");
+	    rc = TSS_RC_BAD_PROPERTY_VALUE;
+	}
+    }
+    return rc;
+}
+
+/* TSS_SetSchedulerDeadline() sets the deadline in msec of the following commands when the context
+   has a scheduler.  Among commands of the same priority, the earliest deadline is sent first.  0
+   is no deadline.
+*/
+
+static TPM_RC TSS_SetSchedulerDeadline(TSS_CONTEXT *tssContext, const char *value)
+{
+    TPM_RC		rc = 0;
+    int			irc;
+
+    if (rc == 0) {
+	if (value == NULL) {
+	    value = TPM_SCHEDULER_DEADLINE_DEFAULT;
+	}
+    }
+    if (rc == 0) {
+	irc = sscanf(value, "%u", &tssContext->tssSchedulerDeadline);
+	if (irc != 1) {
+	    if (tssVerbose) printf("TSS_SetSchedulerDeadline: Error, value invalid\n");
+	    rc = TSS_RC_BAD_PROPERTY_VALUE;
+	}
+    }
+    return rc;
+}
+
+/* TSS_SetRetryCount() sets the maximum number of times a command is resent when the TPM returns
+   TPM_RC_RETRY, TPM_RC_YIELDED, or TPM_RC_TESTING.  0 disables the resend.
+*/
+
+static TPM_RC TSS_SetRetryCount(TSS_CONTEXT *tssContext, const char *value)
+{
+    TPM_RC		rc = 0;
+    int			irc;
+
+    if (rc == 0) {
+	if (value == NULL) {
+	    value = TPM_RETRY_COUNT_DEFAULT;
+	}
+    }
+    if (rc == 0) {
+	irc = sscanf(value, "%u", &tssContext->tssRetryCount);
+	if (irc != 1) {
+	    if (tssVerbose) printf("TSS_SetRetryCount: Error, value invalid\n");
+	    rc = TSS_RC_BAD_PROPERTY_VALUE;
+	}
+    }
+    return rc;
+}
+
+/* TSS_SetRetryDelay() sets the delay in msec before the first resend.  The delay doubles for each
+   following resend, up to TSS_RETRY_DELAY_MAX.
+*/
+
+static TPM_RC TSS_SetRetryDelay(TSS_CONTEXT *tssContext, const char *value)
+{
+    TPM_RC		rc = 0;
+    int			irc;
+    unsigned int	delay;
+
+    if (rc == 0) {
+	if (value == NULL) {
+	    value = TPM_RETRY_DELAY_DEFAULT;
+	}
+    }
+    if (rc == 0) {
+	irc = sscanf(value, "%u", &delay);
+	if (irc != 1) {
+	    if (tssVerbose) printf("TSS_SetRetryDelay: Error, value invalid\n");
+	    rc = TSS_RC_BAD_PROPERTY_VALUE;
+	}
+    }
+    if (rc == 0) {
+	if (delay > TSS_RETRY_DELAY_MAX) {
+	    if (tssVerbose) printf("TSS_SetRetryDelay: Error, delay %u msec above %u\n",
+				   delay, TSS_RETRY_DELAY_MAX);
+	    rc = TSS_RC_BAD_PROPERTY_VALUE;
+	}
+    }
+    if (rc == 0) {
+	tssContext->tssRetryDelay = delay;
+    }
+    return rc;
+}
+
+/* TSS_SetPolicyEmulate() sets whether the TSS emulates trial policy sessions and answers their
+   PolicyGetDigest from the policy digest it tracks, rather than sending the commands to the TPM.
+*/
+
+static TPM_RC TSS_SetPolicyEmulate(TSS_CONTEXT *tssContext, const char *value)
+{
+    TPM_RC		rc = 0;
+    int			irc;
+
+    if (rc == 0) {
+	if (value == NULL) {
+	    value = TPM_POLICY_EMULATE_DEFAULT;
+	}
+    }
+    if (rc == 0) {
+	irc = sscanf(value, "%u", &tssContext->tssPolicyEmulate);
+	if (irc != 1) {
+	    if (tssVerbose) printf("TSS_SetPolicyEmulate: Error, value invalid\n");
+	    rc = TSS_RC_BAD_PROPERTY_VALUE;
+	}
+    }
+    return rc;
+}
+
+/* TSS_SetLocality() sets the locality sent with subsequent commands.
+
+   The value is a locality number, 0 to 4 or an extended locality 32 to 255, not a TPMA_LOCALITY
+   bit map.  The connection is not closed, so the property can be changed between commands to
+   run each command at a different locality.
+*/
+
+static TPM_RC TSS_SetLocality(TSS_CONTEXT *tssContext, const char *value)
+{
+    TPM_RC		rc = 0;
+    int			irc;
+    unsigned int	locality;
+
+    if (rc == 0) {
+	if (value == NULL) {
+	    value = TPM_LOCALITY_DEFAULT;
+	}
+    }
+    if (rc == 0) {
+	irc = sscanf(value, "%u", &locality);
+	if (irc != 1) {
+	    if (tssVerbose) printf("TSS_SetLocality: Error, value invalid\n");
+	    rc = TSS_RC_BAD_PROPERTY_VALUE;
+	}
+    }
+    if (rc == 0) {
+	if (((locality > 4) && (locality < 32)) || (locality > 255)) {
+	    if (tssVerbose) printf("TSS_SetLocality: Error, locality %u invalid\n", locality);
+	    rc = TSS_RC_BAD_PROPERTY_VALUE;
+	}
+    }
+    if (rc == 0) {
+	tssContext->tssLocality = locality;
+    }
+    return rc;
+}
+
+/* TSS_SetCorpusDirectory() sets the directory where each command and response pair is saved.  The
+   empty string, the default, disables the capture.  The TSS without file support ignores it. */
+
+static TPM_RC TSS_SetCorpusDirectory(TSS_CONTEXT *tssContext, const char *value)
+{
+    TPM_RC		rc = 0;
+
+    if (rc == 0) {
+	if (value == NULL) {
+	    value = TPM_CORPUS_DIR_DEFAULT;
+	}
+    }
+    if (rc == 0) {
+	tssContext->tssCorpusDirectory = value;
+    }
+    return rc;
+}
+
+/* TSS_SetReplayFile() sets the trace file that commands and responses are recorded to, or that the
+   "replay" interface serves them from.  A trace in progress is closed.
+
+   The trace holds session nonces and unencrypted parameters.  Never record against a production
+   TPM.
+*/
+
+static TPM_RC TSS_SetReplayFile(TSS_CONTEXT *tssContext, const char *value)
+{
+    TPM_RC		rc = 0;
+
+    if (rc == 0) {
+	rc = TSS_Replay_Close(tssContext);
+    }
+    if (rc == 0) {
+	if (value == NULL) {
+	    value = TPM_REPLAY_FILE_DEFAULT;
+	}
+    }
+    if (rc == 0) {
+	tssContext->tssReplayFile = value;
+    }
+    return rc;
+}
+
+/* TSS_SetConnectRetryCount() sets the maximum number of times a socket open is retried when the
+   server is not accepting connections, e.g. during a simulator restart.  0, the default, disables
+   the retry, so that an open with no server fails at once.
+
+   This is separate from TPM_RETRY_COUNT, which resends commands that the TPM did not start.
+*/
+
+static TPM_RC TSS_SetConnectRetryCount(TSS_CONTEXT *tssContext, const char *value)
+{
+    TPM_RC		rc = 0;
+    int			irc;
+
+    if (rc == 0) {
+	if (value == NULL) {
+	    value = TPM_CONNECT_RETRY_COUNT_DEFAULT;
+	}
+    }
+    if (rc == 0) {
+	irc = sscanf(value, "%u", &tssContext->tssConnectRetryCount);
+	if (irc != 1) {
+	    if (tssVerbose) printf("TSS_SetConnectRetryCount: Error, value invalid\n");
+	    rc = TSS_RC_BAD_PROPERTY_VALUE;
+	}
+    }
+    return rc;
+}
+
+/* TSS_SetConnectRetryDelay() sets the delay in msec before the first socket open retry.  The
+   delay doubles for each following retry, up to TSS_CONNECT_RETRY_DELAY_MAX.
+*/
+
+static TPM_RC TSS_SetConnectRetryDelay(TSS_CONTEXT *tssContext, const char *value)
+{
+    TPM_RC		rc = 0;
+    int			irc;
+    unsigned int	delay;
+
+    if (rc == 0) {
+	if (value == NULL) {
+	    value = TPM_CONNECT_RETRY_DELAY_DEFAULT;
+	}
+    }
+    if (rc == 0) {
+	irc = sscanf(value, "%u", &delay);
+	if (irc != 1) {
+	    if (tssVerbose) printf("TSS_SetConnectRetryDelay: Error, value invalid\n");
+	    rc = TSS_RC_BAD_PROPERTY_VALUE;
+	}
+    }
+    if (rc == 0) {
+	if (delay > TSS_CONNECT_RETRY_DELAY_MAX) {
+	    if (tssVerbose) printf("TSS_SetConnectRetryDelay: Error, delay %u msec above %u\n",
+				   delay, TSS_CONNECT_RETRY_DELAY_MAX);
+	    rc = TSS_RC_BAD_PROPERTY_VALUE;
+	}
+    }
+    if (rc == 0) {
+	tssContext->tssConnectRetryDelay = delay;
+    }
+    return rc;
+}
@@ -45,6 +45,8 @@
 #ifndef TPM_TSS
 #define TPM_TSS
 #endif
+#include <stdio.h>
+
 #include <tss2/TPM_Types.h>
 
 #ifdef TPM_WINDOWS
@@ -77,6 +79,7 @@ extern "C" {
 #endif
 
 #include <tss2/tss.h>
+#include <tss2/tssutils.h>
 #include "tssauth.h"
 
     /* Structure to hold session data within the context */
@@ -103,6 +106,60 @@ extern "C" {
 	TPMS_NV_PUBLIC	nvPublic;
     } TSS_NVPUBLIC;
 
+    /* the TPM_RC_RETRY resend delay doubles up to this limit, in msec, see TSS_AuthExecute() */
+
+#ifndef TSS_RETRY_DELAY_MAX
+#define TSS_RETRY_DELAY_MAX		1000
+#endif
+
+    /* the socket reconnect delay doubles up to this limit, in msec, see TSS_Socket_Reopen() */
+
+#ifndef TSS_CONNECT_RETRY_DELAY_MAX
+#define TSS_CONNECT_RETRY_DELAY_MAX	1000
+#endif
+
+    /* Structure to hold a cached Name within the context.  The entry is addressed by the marshaled
+       public area, TPMT_PUBLIC or TPMS_NV_PUBLIC. */
+
+#define TSS_NAME_CACHE_SIZE		32
+
+    typedef struct TSS_NAME_CACHE {
+	uint32_t key;				/* FNV-1a of the marshaled public area */
+	TPMI_ALG_HASH nameAlg;
+	uint16_t publicSize;			/* marshaled size, 0 for an empty entry */
+	uint8_t publicArea[sizeof(TPMT_PUBLIC)];
+	TPM2B_NAME name;
+    } TSS_NAME_CACHE;
+
+    /* Structure to hold PCR values read from the TPM, and the PolicyPCR pcrDigest values
+       calculated from them, see tsspolicy.c */
+
+#define TSS_PCR_CACHE_DIGESTS		8
+
+    typedef struct TSS_PCR_CACHE_DIGEST {
+	TPML_PCR_SELECTION pcrs;		/* count 0 for an empty entry */
+	TPMI_ALG_HASH hashAlg;			/* policy session hash algorithm */
+	TPM2B_DIGEST pcrDigest;			/* hash of the selected PCR values */
+    } TSS_PCR_CACHE_DIGEST;
+
+    typedef struct TSS_PCR_CACHE {
+	TPMI_ALG_HASH bank[HASH_COUNT];		/* TPM_ALG_NULL for an unused bank */
+	uint32_t valid[HASH_COUNT];		/* bit mask of the PCR values that are known */
+	TPM2B_DIGEST value[HASH_COUNT][IMPLEMENTATION_PCR];
+	TSS_PCR_CACHE_DIGEST digest[TSS_PCR_CACHE_DIGESTS];
+	size_t digestNext;			/* next digest entry to replace */
+    } TSS_PCR_CACHE;
+
+    /* Structure to hold a cached TPM capability within the context, see tsscapability.c */
+
+#define TSS_CAPABILITY_CACHE_SIZE	5
+
+    typedef struct TSS_CAPABILITY_CACHE {
+	int valid;				/* TRUE if read from the TPM */
+	TPMI_YES_NO moreData;			/* TPM has entries after the cached list */
+	TPMS_CAPABILITY_DATA capabilityData;
+    } TSS_CAPABILITY_CACHE;
+
     /* Context for TSS global parameters.
 
        NOTE:  Keep this in sync with TSS_Properties_Init() and TSS_Delete() */
@@ -122,12 +179,22 @@ extern "C" {
 #ifndef TPM_TSS_NOCRYPTO
 	void *tssSessionEncKey;
 	void *tssSessionDecKey;
+	/* Names calculated from public areas, see TSS_Name_Calculate() */
+	TSS_NAME_CACHE nameCache[TSS_NAME_CACHE_SIZE];
+	size_t nameCacheNext;			/* next entry to replace */
+	uint32_t nameCacheHits;
+	uint32_t nameCacheMisses;
+	/* PCR values and PolicyPCR digests, see TSS_PcrCache_GetDigest() */
+	TSS_PCR_CACHE pcrCache;
 #endif
 	/* a minimal TSS with no file support stores the sessions, objects, and NV metadata in a
 	   structure.  Scripting will not work, and persistent objects will not work, but a single
-	   application will otherwise work. */
-#ifdef TPM_TSS_NOFILE
+	   application will otherwise work.
+
+	   The file TSS also stores sessions here while they are held, see TSS_HoldSessions(). */
 	TSS_SESSIONS sessions[MAX_ACTIVE_SESSIONS];
+	int tssHoldSessions;
+#ifdef TPM_TSS_NOFILE
 	TSS_OBJECT_PUBLIC objectPublic[64];
 	TSS_NVPUBLIC nvPublic[64];
 #endif
@@ -142,10 +209,64 @@ extern "C" {
 
 	/* device driver interface */
 	const char *tssDevice;
+	unsigned int tssDeviceTimeout;		/* response timeout in msec, 0 waits forever */
+	unsigned int tssDeviceTimeoutLong;	/* the same for key generation commands */
+
+	/* device driver time, see TSS_GetDeviceStatistics() */
+	uint32_t tssDevCommands;		/* commands transmitted */
+	uint32_t tssDevTimeouts;		/* commands that did not respond within the timeout */
+	uint64_t tssDevWaitTime;		/* usec blocked on the device until the response */
+	uint64_t tssDevProcessTime;		/* usec in TSS_Execute() other than the above */
 
 	/* TRUE for the first time through, indicates that interface open must occur */
 	int tssFirstTransmit;
 
+	/* resend of commands that the TPM did not start, see TSS_AuthExecute() */
+	unsigned int tssRetryCount;		/* maximum number of resends */
+	unsigned int tssRetryDelay;		/* first delay in msec, doubled for each resend */
+	uint32_t tssRetryResends;		/* commands resent */
+	uint32_t tssRetryExhausted;		/* commands that still failed after the last resend */
+
+	/* socket reopen when the server is not accepting connections, see TSS_Socket_Reopen() */
+	unsigned int tssConnectRetryCount;	/* maximum number of retries, 0 for none */
+	unsigned int tssConnectRetryDelay;	/* first delay in msec, doubled for each retry */
+
+	/* socket system calls, see TSS_GetSocketStatistics() */
+	uint32_t tssSocketCommands;		/* commands transmitted */
+	uint32_t tssSocketWrites;		/* send calls for those commands */
+	uint32_t tssSocketReads;		/* receive calls for those responses */
+
+	/* shared connection, see TSS_SetScheduler() */
+	TSS_SCHEDULER *tssScheduler;
+	unsigned int tssSchedulerPriority;	/* lower is sent first */
+	unsigned int tssSchedulerDeadline;	/* msec after the command is queued, 0 for none */
+
+	/* answer trial sessions and PolicyGetDigest in the TSS, see TSS_Execute_Emulate() */
+	int tssPolicyEmulate;
+
+	/* locality sent with each command, MS simulator packet format only */
+	unsigned int tssLocality;
+
+	/* if not empty, each command and response pair is saved in this directory, see
+	   TSS_Transmit_Capture() */
+	const char *tssCorpusDirectory;
+	uint32_t tssCorpusCount;		/* pairs saved by this context */
+
+	/* if not empty, the trace file recorded, or replayed by the "replay" interface, see
+	   tssreplay.c */
+	const char *tssReplayFile;
+	FILE *tssReplayRecordFile;		/* trace being recorded */
+	uint8_t *tssReplayBuffer;		/* trace being replayed */
+	size_t tssReplayLength;
+	size_t tssReplayOffset;			/* next record */
+	TPM_RC tssReplayRecordRc;		/* first record failure, see TSS_Replay_Close() */
+
+	/* reused for every session state save, see TSS_HmacSession_SaveSession() */
+	TSS_MARSHAL_BUFFER sessionMarshalBuffer;
+
+	/* TPM capabilities that do not change until TPM2_Startup() */
+	TSS_CAPABILITY_CACHE capabilityCache[TSS_CAPABILITY_CACHE_SIZE];
+
 	/* socket file descriptor */
 #ifndef TPM_NOSOCKET
 	TSS_SOCKET_FD sock_fd;
@@ -165,6 +286,18 @@ extern "C" {
 
     TPM_RC TSS_GlobalProperties_Init(void);
     TPM_RC TSS_Properties_Init(TSS_CONTEXT *tssContext);
+#ifndef TPM_TSS_NOCRYPTO
+    void TSS_PcrCache_Init(TSS_CONTEXT *tssContext);
+    TPM_RC TSS_PcrCache_Read(TSS_CONTEXT *tssContext,
+			     const TPML_PCR_SELECTION *pcrSelectionOut,
+			     const TPML_DIGEST *pcrValues);
+    void TSS_PcrCache_Invalidate(TSS_CONTEXT *tssContext,
+				 uint32_t pcrMask);
+    TPM_RC TSS_PcrCache_GetDigest(TSS_CONTEXT *tssContext,
+				  TPM2B_DIGEST *pcrDigest,
+				  const TPML_PCR_SELECTION *pcrs,
+				  TPMI_ALG_HASH hashAlg);
+#endif
     
 #ifdef __cplusplus
 }
@@ -0,0 +1,562 @@
+/********************************************************************************/
+/*										*/
+/*		       TSS Record and Replay Interface				*/
+/*		       IBM Thomas J. Watson Research Center			*/
+/*			      $Id: tssreplay.c $				*/
+/*										*/
+/* (c) Copyright IBM Corporation 2017.						*/
+/*										*/
+/* All rights reserved.								*/
+/* 										*/
+/* Redistribution and use in source and binary forms, with or without		*/
+/* modification, are permitted provided that the following conditions are	*/
+/* met:										*/
+/* 										*/
+/* Redistributions of source code must retain the above copyright notice,	*/
+/* this list of conditions and the following disclaimer.			*/
+/* 										*/
+/* Redistributions in binary form must reproduce the above copyright		*/
+/* notice, this list of conditions and the following disclaimer in the		*/
+/* documentation and/or other materials provided with the distribution.		*/
+/* 										*/
+/* Neither the names of the IBM Corporation nor the names of its		*/
+/* contributors may be used to endorse or promote products derived from		*/
+/* this software without specific prior written permission.			*/
+/* 										*/
+/* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS		*/
+/* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT		*/
+/* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR	*/
+/* A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT		*/
+/* HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,	*/
+/* SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT		*/
+/* LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,	*/
+/* DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY	*/
+/* THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT		*/
+/* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE	*/
+/* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.		*/
+/********************************************************************************/
+
+
+
+/* The record and replay interface takes the TPM out of the loop, for example to benchmark the TSS
+   itself in CI without a simulator.
+
+   With TPM_REPLAY_FILE set and the socsim or dev interface, each command and response pair is
+   recorded to the trace file.  With TPM_INTERFACE_TYPE "replay", responses are served from the
+   trace.  Each command must match the recorded command, except for nonces and HMACs, else the
+   replay fails with TSS_RC_REPLAY_MISMATCH.
+
+   The TSS generated nonceCaller values are recorded too, and returned again at replay, so that
+   session keys, HMACs, and parameter encryption reproduce and the recorded response HMACs verify.
+
+   A trace holds the session nonces and every command and response in the clear, including
+   unencrypted parameters.  Never record a trace against a production TPM.  Salts are session
+   secrets and are not recorded, so salted sessions do not replay.
+
+   The trace is read into memory at the first replay command, so that file I/O is not timed.  A
+   trace is one TSS_CONTEXT.  A context with a scheduler records on the transport context, which
+   does not see the nonces, so it cannot be replayed.
+
+   Trace format, integers are big endian:
+
+   	"TSSTRC01"
+	records:
+	    'C' uint32_t command size, command, uint32_t response size, response
+	    'N' uint32_t size, nonce
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <tss2/tss.h>
+#include <tss2/tsserror.h>
+#include <tss2/tssprint.h>
+#ifndef TPM_TSS_NOFILE
+#include <tss2/tssfile.h>
+#endif
+#ifndef TPM_TSS_NOCRYPTO
+#include <tss2/tsscrypto.h>
+#endif
+#include "tssproperties.h"
+#include "tssccattributes.h"
+#include "tssreplay.h"
+
+extern int tssVverbose;
+extern int tssVerbose;
+
+#define TSS_REPLAY_MAGIC	"TSSTRC01"
+#define TSS_REPLAY_MAGIC_SIZE	8
+#define TSS_REPLAY_COMMAND	'C'
+#define TSS_REPLAY_NONCE	'N'
+
+/* command fields that differ between record and replay, nonceCaller and HMAC per session, and the
+   StartAuthSession nonceCaller and encryptedSalt */
+
+#define TSS_REPLAY_MASK_MAX	((MAX_SESSION_NUM * 2) + 2)
+
+typedef struct {
+    uint32_t	start;
+    uint32_t	end;
+} TSS_REPLAY_MASK;
+
+#ifndef TPM_TSS_NOFILE
+
+static TPM_RC TSS_Replay_Load(TSS_CONTEXT *tssContext);
+static TPM_RC TSS_Replay_GetRecord(TSS_CONTEXT *tssContext,
+				   const uint8_t **data,
+				   uint32_t *size,
+				   uint8_t type);
+static void TSS_Replay_WriteRecord(TSS_CONTEXT *tssContext,
+				   uint8_t type,
+				   const uint8_t *data1, uint32_t size1,
+				   const uint8_t *data2, uint32_t size2);
+static TPM_RC TSS_Replay_Compare(const uint8_t *recorded, uint32_t recordedSize,
+				 const uint8_t *command, uint32_t commandSize);
+static void TSS_Replay_Mask2B(TSS_REPLAY_MASK *mask,
+			      size_t *maskCount,
+			      uint32_t *offset,
+			      const uint8_t *command,
+			      uint32_t commandSize);
+static uint32_t TSS_Replay_GetUint32(const uint8_t *buffer);
+
+/* TSS_Replay_Transmit() returns the next recorded response, after checking the command against
+   the recorded command.  Like the device interfaces, it returns the TPM response code.
+*/
+
+TPM_RC TSS_Replay_Transmit(TSS_CONTEXT *tssContext,
+			   uint8_t *responseBuffer, uint32_t *read,
+			   const uint8_t *commandBuffer, uint32_t written,
+			   const char *message)
+{
+    TPM_RC		rc = 0;
+    const uint8_t	*recordedCommand;
+    uint32_t		recordedCommandSize;
+    const uint8_t	*recordedResponse;
+    uint32_t		recordedResponseSize;
+
+    if (message != NULL) {
+	if (tssVverbose) printf("TSS_Replay_Transmit: %s\n", message);
+    }
+    if (rc == 0) {
+	rc = TSS_Replay_Load(tssContext);
+    }
+    if (rc == 0) {
+	rc = TSS_Replay_GetRecord(tssContext, &recordedCommand, &recordedCommandSize,
+				  TSS_REPLAY_COMMAND);
+    }
+    /* the response follows the command in the same record */
+    if (rc == 0) {
+	if ((tssContext->tssReplayLength - tssContext->tssReplayOffset) < sizeof(uint32_t)) {
+	    rc = TSS_RC_MALFORMED_RESPONSE;
+	}
+    }
+    if (rc == 0) {
+	recordedResponseSize =
+	    TSS_Replay_GetUint32(tssContext->tssReplayBuffer + tssContext->tssReplayOffset);
+	tssContext->tssReplayOffset += sizeof(uint32_t);
+	recordedResponse = tssContext->tssReplayBuffer + tssContext->tssReplayOffset;
+	if ((recordedResponseSize > MAX_RESPONSE_SIZE) ||
+	    (recordedResponseSize < (sizeof(TPM_ST) + sizeof(uint32_t) + sizeof(TPM_RC))) ||
+	    (recordedResponseSize > (tssContext->tssReplayLength - tssContext->tssReplayOffset))) {
+	    if (tssVerbose) printf("TSS_Replay_Transmit: response size %u invalid\n",
+				   recordedResponseSize);
+	    rc = TSS_RC_MALFORMED_RESPONSE;
+	}
+    }
+    if (rc == 0) {
+	tssContext->tssReplayOffset += recordedResponseSize;
+	rc = TSS_Replay_Compare(recordedCommand, recordedCommandSize,
+				commandBuffer, written);
+    }
+    if (rc == 0) {
+	if (tssVverbose) TSS_PrintAll("TSS_Replay_Transmit: response",
+				      recordedResponse, recordedResponseSize);
+	memcpy(responseBuffer, recordedResponse, recordedResponseSize);
+	*read = recordedResponseSize;
+	/* the TPM response code */
+	rc = TSS_Replay_GetUint32(responseBuffer + sizeof(TPM_ST) + sizeof(uint32_t));
+    }
+    return rc;
+}
+
+/* TSS_Replay_Record() appends a command and response pair to the trace.
+
+   See TSS_Replay_WriteRecord() for a record failure.
+*/
+
+void TSS_Replay_Record(TSS_CONTEXT *tssContext,
+		       const uint8_t *responseBuffer, uint32_t read,
+		       const uint8_t *commandBuffer, uint32_t written)
+{
+    TSS_Replay_WriteRecord(tssContext, TSS_REPLAY_COMMAND,
+			   commandBuffer, written,
+			   responseBuffer, read);
+    return;
+}
+
+/* TSS_Replay_Load() reads the trace into memory for replay, once */
+
+static TPM_RC TSS_Replay_Load(TSS_CONTEXT *tssContext)
+{
+    TPM_RC	rc = 0;
+    size_t	length;
+
+    if (tssContext->tssReplayBuffer == NULL) {
+	if (rc == 0) {
+	    if (tssVverbose) printf("TSS_Replay_Load: Reading %s\n", tssContext->tssReplayFile);
+	    rc = TSS_File_ReadBinaryFile(&tssContext->tssReplayBuffer,	/* freed @1 */
+					 &length,
+					 tssContext->tssReplayFile);
+	}
+	if (rc == 0) {
+	    if ((length < TSS_REPLAY_MAGIC_SIZE) ||
+		(memcmp(tssContext->tssReplayBuffer, TSS_REPLAY_MAGIC, TSS_REPLAY_MAGIC_SIZE) != 0)) {
+		if (tssVerbose) printf("TSS_Replay_Load: %s is not a trace\n",
+				       tssContext->tssReplayFile);
+		rc = TSS_RC_MALFORMED_RESPONSE;
+	    }
+	}
+	if (rc == 0) {
+	    tssContext->tssReplayLength = length;
+	    tssContext->tssReplayOffset = TSS_REPLAY_MAGIC_SIZE;
+	}
+	else {
+	    free(tssContext->tssReplayBuffer);		/* @1 */
+	    tssContext->tssReplayBuffer = NULL;
+	}
+    }
+    return rc;
+}
+
+/* TSS_Replay_GetRecord() consumes the next record, which must be of 'type', returning its first
+   data field.
+*/
+
+static TPM_RC TSS_Replay_GetRecord(TSS_CONTEXT *tssContext,
+				   const uint8_t **data,
+				   uint32_t *size,
+				   uint8_t type)
+{
+    TPM_RC	rc = 0;
+    size_t	remaining = tssContext->tssReplayLength - tssContext->tssReplayOffset;
+
+    if (rc == 0) {
+	if (remaining == 0) {
+	    if (tssVerbose) printf("TSS_Replay_GetRecord: End of trace\n");
+	    rc = TSS_RC_REPLAY_END;
+	}
+	else if (remaining < (1 + sizeof(uint32_t))) {
+	    rc = TSS_RC_MALFORMED_RESPONSE;
+	}
+    }
+    if (rc == 0) {
+	if (tssContext->tssReplayBuffer[tssContext->tssReplayOffset] != type) {
+	    if (tssVerbose) printf("TSS_Replay_GetRecord: Expected record %c, trace has %c\n",
+				   type, tssContext->tssReplayBuffer[tssContext->tssReplayOffset]);
+	    rc = TSS_RC_REPLAY_MISMATCH;
+	}
+    }
+    if (rc == 0) {
+	*size = TSS_Replay_GetUint32(tssContext->tssReplayBuffer + tssContext->tssReplayOffset + 1);
+	remaining -= 1 + sizeof(uint32_t);
+	if (*size > remaining) {
+	    if (tssVerbose) printf("TSS_Replay_GetRecord: size %u invalid\n", *size);
+	    rc = TSS_RC_MALFORMED_RESPONSE;
+	}
+    }
+    if (rc == 0) {
+	*data = tssContext->tssReplayBuffer + tssContext->tssReplayOffset + 1 + sizeof(uint32_t);
+	tssContext->tssReplayOffset += 1 + sizeof(uint32_t) + *size;
+    }
+    return rc;
+}
+
+/* TSS_Replay_WriteRecord() appends a record with one or two data fields to the trace, opening the
+   trace at the first record.
+
+   At the first write failure, recording stops: the trace is closed and the TPM_REPLAY_FILE property
+   is cleared, and later commands are not recorded.  A partial trace would fail at replay, so it is
+   better to stop than to keep appending.  The failure does not fail the command, which the TPM may
+   already have executed.  It is saved and returned by TSS_Replay_Close(), i.e. by TSS_Delete() or
+   by setting TPM_REPLAY_FILE.
+*/
+
+static void TSS_Replay_WriteRecord(TSS_CONTEXT *tssContext,
+				   uint8_t type,
+				   const uint8_t *data1, uint32_t size1,
+				   const uint8_t *data2, uint32_t size2)
+{
+    TPM_RC	rc = 0;
+    uint8_t	sizeNbo[sizeof(uint32_t)];
+    FILE	*file;
+
+    if (tssContext->tssReplayRecordFile == NULL) {
+	if (rc == 0) {
+	    rc = TSS_File_Open(&file, tssContext->tssReplayFile, "wb");	/* closed @2 */
+	}
+	if (rc == 0) {
+	    tssContext->tssReplayRecordFile = file;
+	    if (fwrite(TSS_REPLAY_MAGIC, 1, TSS_REPLAY_MAGIC_SIZE, file) != TSS_REPLAY_MAGIC_SIZE) {
+		rc = TSS_RC_FILE_WRITE;
+	    }
+	}
+    }
+    if (rc == 0) {
+	file = tssContext->tssReplayRecordFile;
+	sizeNbo[0] = (uint8_t)(size1 >> 24);
+	sizeNbo[1] = (uint8_t)(size1 >> 16);
+	sizeNbo[2] = (uint8_t)(size1 >>  8);
+	sizeNbo[3] = (uint8_t)(size1 >>  0);
+	if ((fwrite(&type, 1, 1, file) != 1) ||
+	    (fwrite(sizeNbo, 1, sizeof(sizeNbo), file) != sizeof(sizeNbo)) ||
+	    (fwrite(data1, 1, size1, file) != size1)) {
+	    rc = TSS_RC_FILE_WRITE;
+	}
+    }
+    if ((rc == 0) && (data2 != NULL)) {
+	sizeNbo[0] = (uint8_t)(size2 >> 24);
+	sizeNbo[1] = (uint8_t)(size2 >> 16);
+	sizeNbo[2] = (uint8_t)(size2 >>  8);
+	sizeNbo[3] = (uint8_t)(size2 >>  0);
+	if ((fwrite(sizeNbo, 1, sizeof(sizeNbo), file) != sizeof(sizeNbo)) ||
+	    (fwrite(data2, 1, size2, file) != size2)) {
+	    rc = TSS_RC_FILE_WRITE;
+	}
+    }
+    if (rc != 0) {
+	if (tssVerbose) printf("TSS_Replay_WriteRecord: Error %08x writing %s, recording stopped\n",
+			       rc, tssContext->tssReplayFile);
+	TSS_Replay_Close(tssContext);
+	tssContext->tssReplayFile = "";
+	tssContext->tssReplayRecordRc = rc;
+    }
+    return;
+}
+
+/* TSS_Replay_Compare() checks that the command matches the recorded command, except for the masked
+   nonce and HMAC fields.  The fields are located using the recorded command.
+*/
+
+static TPM_RC TSS_Replay_Compare(const uint8_t *recorded, uint32_t recordedSize,
+				 const uint8_t *command, uint32_t commandSize)
+{
+    TPM_RC		rc = 0;
+    TSS_REPLAY_MASK	mask[TSS_REPLAY_MASK_MAX];
+    size_t		maskCount = 0;
+    size_t		i;
+    uint32_t		offset;
+    uint32_t		start;
+    uint16_t		tag;
+    TPM_CC		commandCode = 0;
+    COMMAND_INDEX	commandIndex;
+    uint32_t		authSize;
+    uint32_t		authEnd;
+
+    if (rc == 0) {
+	if ((recordedSize != commandSize) ||
+	    (commandSize < (sizeof(TPM_ST) + sizeof(uint32_t) + sizeof(TPM_CC)))) {
+	    if (tssVerbose) printf("TSS_Replay_Compare: command size %u, recorded %u\n",
+				   commandSize, recordedSize);
+	    rc = TSS_RC_REPLAY_MISMATCH;
+	}
+    }
+    /* the authorization area, after the handles */
+    if (rc == 0) {
+	tag = (uint16_t)((recorded[0] << 8) | recorded[1]);
+	commandCode = TSS_Replay_GetUint32(recorded + sizeof(TPM_ST) + sizeof(uint32_t));
+	commandIndex = CommandCodeToCommandIndex(commandCode);
+	offset = sizeof(TPM_ST) + sizeof(uint32_t) + sizeof(TPM_CC);
+	if (commandIndex != UNIMPLEMENTED_COMMAND_INDEX) {
+	    offset += getCommandHandleCount(commandIndex) * sizeof(TPM_HANDLE);
+	    if ((tag == TPM_ST_SESSIONS) && ((offset + sizeof(uint32_t)) <= recordedSize)) {
+		authSize = TSS_Replay_GetUint32(recorded + offset);
+		offset += sizeof(uint32_t);
+		if (authSize > (recordedSize - offset)) {
+		    authSize = recordedSize - offset;
+		}
+		authEnd = offset + authSize;
+		/* each session is handle, nonce, attributes, hmac */
+		while ((offset + sizeof(TPM_HANDLE)) < authEnd) {
+		    offset += sizeof(TPM_HANDLE);
+		    TSS_Replay_Mask2B(mask, &maskCount, &offset, recorded, authEnd);
+		    offset += sizeof(uint8_t);
+		    TSS_Replay_Mask2B(mask, &maskCount, &offset, recorded, authEnd);
+		}
+		offset = authEnd;
+	    }
+	    /* the StartAuthSession parameters start with nonceCaller and encryptedSalt */
+	    if (commandCode == TPM_CC_StartAuthSession) {
+		TSS_Replay_Mask2B(mask, &maskCount, &offset, recorded, recordedSize);
+		TSS_Replay_Mask2B(mask, &maskCount, &offset, recorded, recordedSize);
+	    }
+	}
+    }
+    /* compare the bytes between the masks */
+    for (i = 0 , start = 0 ; (rc == 0) && (i <= maskCount) ; i++) {
+	uint32_t end = (i < maskCount) ? mask[i].start : commandSize;
+	if ((end > start) && (memcmp(recorded + start, command + start, end - start) != 0)) {
+	    if (tssVerbose) printf("TSS_Replay_Compare: command %08x does not match the trace "
+				   "at bytes %u to %u\n", commandCode, start, end);
+	    rc = TSS_RC_REPLAY_MISMATCH;
+	}
+	if (i < maskCount) {
+	    start = mask[i].end;
+	}
+    }
+    return rc;
+}
+
+/* TSS_Replay_Mask2B() adds the buffer of the TPM2B at offset to the mask, leaving the size
+   compared.  offset is advanced past the TPM2B, and both stop at commandSize.
+*/
+
+static void TSS_Replay_Mask2B(TSS_REPLAY_MASK *mask,
+			      size_t *maskCount,
+			      uint32_t *offset,
+			      const uint8_t *command,
+			      uint32_t commandSize)
+{
+    uint32_t size;
+
+    if ((*offset + sizeof(uint16_t)) <= commandSize) {
+	size = (uint32_t)((command[*offset] << 8) | command[*offset + 1]);
+	*offset += sizeof(uint16_t);
+	if (size > (commandSize - *offset)) {
+	    size = commandSize - *offset;
+	}
+	if (*maskCount < TSS_REPLAY_MASK_MAX) {
+	    mask[*maskCount].start = *offset;
+	    mask[*maskCount].end = *offset + size;
+	    (*maskCount)++;
+	}
+	*offset += size;
+    }
+    else {
+	*offset = commandSize;
+    }
+    return;
+}
+
+static uint32_t TSS_Replay_GetUint32(const uint8_t *buffer)
+{
+    return ((uint32_t)buffer[0] << 24) |
+	((uint32_t)buffer[1] << 16) |
+	((uint32_t)buffer[2] <<  8) |
+	((uint32_t)buffer[3] <<  0);
+}
+
+#endif	/* TPM_TSS_NOFILE */
+
+/* TSS_Replay_Close() closes a trace being recorded, and frees a trace being replayed.
+
+   It returns the first record failure since the last close, see TSS_Replay_WriteRecord(), else
+   any close error.
+*/
+
+TPM_RC TSS_Replay_Close(TSS_CONTEXT *tssContext)
+{
+    TPM_RC rc = 0;
+
+#ifndef TPM_TSS_NOFILE
+    if (tssContext->tssReplayRecordFile != NULL) {
+	if (fclose(tssContext->tssReplayRecordFile) != 0) {	/* @2 */
+	    rc = TSS_RC_FILE_CLOSE;
+	}
+	tssContext->tssReplayRecordFile = NULL;
+    }
+    if (tssContext->tssReplayRecordRc != 0) {
+	rc = tssContext->tssReplayRecordRc;
+	tssContext->tssReplayRecordRc = 0;
+    }
+    free(tssContext->tssReplayBuffer);				/* @1 */
+    tssContext->tssReplayBuffer = NULL;
+#else
+    tssContext = tssContext;
+#endif
+    return rc;
+}
+
+#ifndef TPM_TSS_NOCRYPTO
+
+/* TSS_Replay_Nonce() returns a random nonce that determines session keys or HMACs.
+
+   When recording, the nonce is saved in the trace.  When replaying, the recorded nonce is
+   returned.
+
+   The nonce is saved in the clear.  Do not use this function for a secret such as a salt.
+*/
+
+TPM_RC TSS_Replay_Nonce(TSS_CONTEXT *tssContext,
+			uint8_t *buffer,
+			uint32_t size)
+{
+    TPM_RC		rc = 0;
+#ifndef TPM_TSS_NOFILE
+    const uint8_t	*nonce;
+    uint32_t		nonceSize;
+
+    if (strcmp(tssContext->tssInterfaceType, "replay") == 0) {
+	if (rc == 0) {
+	    rc = TSS_Replay_Load(tssContext);
+	}
+	if (rc == 0) {
+	    rc = TSS_Replay_GetRecord(tssContext, &nonce, &nonceSize, TSS_REPLAY_NONCE);
+	}
+	if (rc == 0) {
+	    if (nonceSize != size) {
+		if (tssVerbose) printf("TSS_Replay_Nonce: size %u, recorded %u\n",
+				       size, nonceSize);
+		rc = TSS_RC_REPLAY_MISMATCH;
+	    }
+	}
+	if (rc == 0) {
+	    memcpy(buffer, nonce, size);
+	}
+    }
+    else {
+	if (rc == 0) {
+	    rc = TSS_RandBytes(buffer, size);
+	}
+	/* a record failure is reported by TSS_Replay_Close() */
+	if ((rc == 0) && (tssContext->tssReplayFile[0] != '\0')) {
+	    TSS_Replay_WriteRecord(tssContext, TSS_REPLAY_NONCE,
+				   buffer, size,
+				   NULL, 0);
+	}
+    }
+#else
+    tssContext = tssContext;
+    rc = TSS_RandBytes(buffer, size);
+#endif
+    return rc;
+}
+
+/* TSS_Replay_Salt() returns a random RSA salt.
+
+   The salt is a session secret, so it is never recorded.  When replaying, a salted session cannot
+   reproduce the recorded session key, so the function returns TSS_RC_REPLAY_MISMATCH rather than
+   fail later at the response HMAC check.
+*/
+
+TPM_RC TSS_Replay_Salt(TSS_CONTEXT *tssContext,
+		       uint8_t *buffer,
+		       uint32_t size)
+{
+    TPM_RC		rc = 0;
+
+#ifndef TPM_TSS_NOFILE
+    if (strcmp(tssContext->tssInterfaceType, "replay") == 0) {
+	if (tssVerbose) printf("TSS_Replay_Salt: salted sessions cannot be replayed\n");
+	rc = TSS_RC_REPLAY_MISMATCH;
+    }
+#else
+    tssContext = tssContext;
+#endif
+    if (rc == 0) {
+	rc = TSS_RandBytes(buffer, size);
+    }
+    return rc;
+}
+
+#endif	/* TPM_TSS_NOCRYPTO */
@@ -0,0 +1,75 @@
+/********************************************************************************/
+/*										*/
+/*		       TSS Record and Replay Interface				*/
+/*		       IBM Thomas J. Watson Research Center			*/
+/*			      $Id: tssreplay.h $				*/
+/*										*/
+/* (c) Copyright IBM Corporation 2017.						*/
+/*										*/
+/* All rights reserved.								*/
+/* 										*/
+/* Redistribution and use in source and binary forms, with or without		*/
+/* modification, are permitted provided that the following conditions are	*/
+/* met:										*/
+/* 										*/
+/* Redistributions of source code must retain the above copyright notice,	*/
+/* this list of conditions and the following disclaimer.			*/
+/* 										*/
+/* Redistributions in binary form must reproduce the above copyright		*/
+/* notice, this list of conditions and the following disclaimer in the		*/
+/* documentation and/or other materials provided with the distribution.		*/
+/* 										*/
+/* Neither the names of the IBM Corporation nor the names of its		*/
+/* contributors may be used to endorse or promote products derived from		*/
+/* this software without specific prior written permission.			*/
+/* 										*/
+/* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS		*/
+/* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT		*/
+/* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR	*/
+/* A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT		*/
+/* HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,	*/
+/* SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT		*/
+/* LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,	*/
+/* DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY	*/
+/* THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT		*/
+/* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE	*/
+/* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.		*/
+/********************************************************************************/
+
+
+
+/* This is not a public header.  It should not be used by applications. */
+
+#ifndef TSSREPLAY_H
+#define TSSREPLAY_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef TPM_TSS_NOFILE
+    TPM_RC TSS_Replay_Transmit(TSS_CONTEXT *tssContext,
+			       uint8_t *responseBuffer, uint32_t *read,
+			       const uint8_t *commandBuffer, uint32_t written,
+			       const char *message);
+    void TSS_Replay_Record(TSS_CONTEXT *tssContext,
+			   const uint8_t *responseBuffer, uint32_t read,
+			   const uint8_t *commandBuffer, uint32_t written);
+#endif
+    TPM_RC TSS_Replay_Close(TSS_CONTEXT *tssContext);
+#ifndef TPM_TSS_NOCRYPTO
+    TPM_RC TSS_Replay_Nonce(TSS_CONTEXT *tssContext,
+			    uint8_t *buffer,
+			    uint32_t size);
+    TPM_RC TSS_Replay_Salt(TSS_CONTEXT *tssContext,
+			   uint8_t *buffer,
+			   uint32_t size);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
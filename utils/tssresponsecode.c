@@ -260,7 +260,20 @@ const RC_TABLE tssTable [] = {
     {TSS_RC_EC_EPHEMERAL_FAILURE, "TSS_RC_EC_EPHEMERAL_FAILURE - Failed while making or using EC ephemeral key"},
     {TSS_RC_NO_SESSION_SLOT, "TSS_RC_NO_SESSION_SLOT - TSS context has no session slot for handle"},
     {TSS_RC_NO_OBJECTPUBLIC_SLOT, "TSS_RC_NO_OBJECTPUBLIC_SLOT - TSS context has no object public slot for handle"},
-    {TSS_RC_NO_NVPUBLIC_SLOT, "TSS_RC_NO_NVPUBLIC_SLOT -TSS context has no NV public slot for handle"}
+    {TSS_RC_NO_NVPUBLIC_SLOT, "TSS_RC_NO_NVPUBLIC_SLOT -TSS context has no NV public slot for handle"},
+    {TSS_RC_BAD_ATTEST, "TSS_RC_BAD_ATTEST - Attestation structure is malformed or not a quote"},
+    {TSS_RC_BAD_NONCE, "TSS_RC_BAD_NONCE - Attestation extraData does not match the nonce"},
+    {TSS_RC_PCR_DIGEST, "TSS_RC_PCR_DIGEST - Quote PCR digest does not match the PCR values"},
+    {TSS_RC_NO_KEY, "TSS_RC_NO_KEY - No verification key for the Name"},
+    {TSS_RC_BAD_DIGEST_SIZE, "TSS_RC_BAD_DIGEST_SIZE - Digest size does not match the hash algorithm"},
+    {TSS_RC_POLICY_OR_COUNT, "TSS_RC_POLICY_OR_COUNT - PolicyOR requires 2 to 8 branches"},
+    {TSS_RC_POLICY_NOT_EMULATED, "TSS_RC_POLICY_NOT_EMULATED - policy digest cannot be calculated by the TSS"},
+    {TSS_RC_PCR_NOT_CACHED, "TSS_RC_PCR_NOT_CACHED - PCR values have not been read"},
+    {TSS_RC_AUDIT_NOT_EMULATED, "TSS_RC_AUDIT_NOT_EMULATED - audit digest cannot be calculated by the TSS"},
+    {TSS_RC_AUDIT_DIGEST, "TSS_RC_AUDIT_DIGEST - audit digest does not match the TSS"},
+    {TSS_RC_DEVICE_TIMEOUT, "TSS_RC_DEVICE_TIMEOUT - TPM device did not respond within the timeout"},
+    {TSS_RC_REPLAY_MISMATCH, "TSS_RC_REPLAY_MISMATCH - command does not match the replay trace"},
+    {TSS_RC_REPLAY_END, "TSS_RC_REPLAY_END - replay trace has no more commands"}
 };
 
 #define BITS1108	0xf00
@@ -0,0 +1,427 @@
+/********************************************************************************/
+/*										*/
+/*			    TSS Command Scheduler				*/
+/*		       IBM Thomas J. Watson Research Center			*/
+/*			    $Id: tssscheduler.c $				*/
+/*										*/
+/* (c) Copyright IBM Corporation 2017.						*/
+/*										*/
+/* All rights reserved.								*/
+/* 										*/
+/* Redistribution and use in source and binary forms, with or without		*/
+/* modification, are permitted provided that the following conditions are	*/
+/* met:										*/
+/* 										*/
+/* Redistributions of source code must retain the above copyright notice,	*/
+/* this list of conditions and the following disclaimer.			*/
+/* 										*/
+/* Redistributions in binary form must reproduce the above copyright		*/
+/* notice, this list of conditions and the following disclaimer in the		*/
+/* documentation and/or other materials provided with the distribution.		*/
+/* 										*/
+/* Neither the names of the IBM Corporation nor the names of its		*/
+/* contributors may be used to endorse or promote products derived from		*/
+/* this software without specific prior written permission.			*/
+/* 										*/
+/* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS		*/
+/* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT		*/
+/* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR	*/
+/* A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT		*/
+/* HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,	*/
+/* SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT		*/
+/* LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,	*/
+/* DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY	*/
+/* THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT		*/
+/* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE	*/
+/* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.		*/
+/********************************************************************************/
+
+
+
+/* The scheduler serializes commands from several TSS_CONTEXTs on one transport context, see
+   tssscheduler.h.  There is no scheduler thread.  The thread whose command is granted transmits it
+   on the transport context, and at completion grants the best waiting command.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef TPM_POSIX
+#include <pthread.h>
+#include <time.h>
+#endif
+
+#include <tss2/tss.h>
+#include <tss2/tsserror.h>
+#include <tss2/tssutils.h>
+#include <tss2/tsstransmit.h>
+#include <tss2/tssscheduler.h>
+#include "tssproperties.h"
+#include "tssauth.h"
+
+extern int tssVverbose;
+extern int tssVerbose;
+
+#ifdef TPM_POSIX
+
+/* a command waiting in the queue, on the waiting thread's stack */
+
+typedef struct TSS_SCHEDULER_REQUEST {
+    unsigned int	priority;	/* lower value is sent first */
+    uint64_t		deadline;	/* absolute usec, 0 for none */
+    uint64_t		sequence;	/* arrival order */
+    int			granted;	/* TRUE when this command may transmit */
+    struct TSS_SCHEDULER_REQUEST *next;
+} TSS_SCHEDULER_REQUEST;
+
+struct TSS_SCHEDULER {
+    pthread_mutex_t	mutex;
+    pthread_cond_t	cond;		/* signaled when a waiting command is granted */
+    TSS_CONTEXT		*transportContext;
+    int			busy;		/* a command is being transmitted */
+    TSS_SCHEDULER_REQUEST *queue;	/* unsorted, the best is found at each grant */
+    uint64_t		sequence;
+    /* statistics, see TSS_Scheduler_GetStatistics() */
+    uint32_t		commands;
+    uint32_t		queueDepth;
+    uint32_t		queueDepthMax;
+    uint64_t		waitTime;
+    uint64_t		waitTimeMax;
+    uint32_t		deadlineMisses;
+};
+
+static uint64_t TSS_Scheduler_GetTime(void);
+static int TSS_Scheduler_IsBefore(const TSS_SCHEDULER_REQUEST *a,
+				  const TSS_SCHEDULER_REQUEST *b);
+static void TSS_Scheduler_Acquire(TSS_SCHEDULER *scheduler,
+				  TSS_SCHEDULER_REQUEST *request);
+static void TSS_Scheduler_Release(TSS_SCHEDULER *scheduler);
+
+/* TSS_Scheduler_Create() creates a scheduler for commands sent on the connection of
+   transportContext.  The transport context must not be used directly while the scheduler exists,
+   and must be deleted after the scheduler.
+
+   The transport context's TPM_INTERFACE_TYPE and related properties select the connection.  Its
+   corpus capture and transport statistics include all scheduled commands.
+*/
+
+TPM_RC TSS_Scheduler_Create(TSS_SCHEDULER **scheduler,
+			    TSS_CONTEXT *transportContext)
+{
+    TPM_RC	rc = 0;
+    int		irc;
+
+    if (rc == 0) {
+	rc = TSS_Malloc((unsigned char **)scheduler, sizeof(TSS_SCHEDULER));	/* freed @1 */
+    }
+    if (rc == 0) {
+	irc = pthread_mutex_init(&(*scheduler)->mutex, NULL);
+	if (irc != 0) {
+	    if (tssVerbose) printf("TSS_Scheduler_Create: Error, mutex init %d\n", irc);
+	    rc = TSS_RC_OUT_OF_MEMORY;
+	    free(*scheduler);
+	    *scheduler = NULL;
+	}
+    }
+    if (rc == 0) {
+	irc = pthread_cond_init(&(*scheduler)->cond, NULL);
+	if (irc != 0) {
+	    if (tssVerbose) printf("TSS_Scheduler_Create: Error, condition init %d\n", irc);
+	    rc = TSS_RC_OUT_OF_MEMORY;
+	    pthread_mutex_destroy(&(*scheduler)->mutex);
+	    free(*scheduler);
+	    *scheduler = NULL;
+	}
+    }
+    if (rc == 0) {
+	(*scheduler)->transportContext = transportContext;
+	(*scheduler)->busy = FALSE;
+	(*scheduler)->queue = NULL;
+	(*scheduler)->sequence = 0;
+	(*scheduler)->commands = 0;
+	(*scheduler)->queueDepth = 0;
+	(*scheduler)->queueDepthMax = 0;
+	(*scheduler)->waitTime = 0;
+	(*scheduler)->waitTimeMax = 0;
+	(*scheduler)->deadlineMisses = 0;
+    }
+    return rc;
+}
+
+/* TSS_Scheduler_Delete() frees the scheduler.  No context may be transmitting through it.  It does
+   not close or delete the transport context.
+*/
+
+TPM_RC TSS_Scheduler_Delete(TSS_SCHEDULER *scheduler)
+{
+    TPM_RC	rc = 0;
+
+    if (scheduler != NULL) {
+	if (scheduler->busy || (scheduler->queue != NULL)) {
+	    if (tssVerbose) printf("TSS_Scheduler_Delete: Error, commands in progress\n");
+	    rc = TSS_RC_BAD_CONNECTION;
+	}
+	if (rc == 0) {
+	    pthread_cond_destroy(&scheduler->cond);
+	    pthread_mutex_destroy(&scheduler->mutex);
+	    free(scheduler);		/* @1 */
+	}
+    }
+    return rc;
+}
+
+/* TSS_SetScheduler() sends the commands of tssContext through the scheduler, or directly over its
+   own connection if scheduler is NULL.  The TPM_SCHEDULER_PRIORITY and TPM_SCHEDULER_DEADLINE
+   properties of tssContext apply to each command.
+
+   Objects and sessions are then in the scheduler's connection, shared by all of its contexts.
+*/
+
+TPM_RC TSS_SetScheduler(TSS_CONTEXT *tssContext,
+			TSS_SCHEDULER *scheduler)
+{
+    TPM_RC	rc = 0;
+
+    /* close any connection of this context, it will not be used */
+    if ((rc == 0) && (scheduler != NULL)) {
+	rc = TSS_Close(tssContext);
+    }
+    if (rc == 0) {
+	tssContext->tssScheduler = scheduler;
+    }
+    return rc;
+}
+
+/* TSS_Scheduler_GetStatistics() returns the number of commands transmitted, the current and
+   maximum number of commands waiting, the total and maximum usec that a command waited before it
+   was transmitted, and the number of commands transmitted after their deadline.
+*/
+
+TPM_RC TSS_Scheduler_GetStatistics(TSS_SCHEDULER *scheduler,
+				   uint32_t *commands,
+				   uint32_t *queueDepth,
+				   uint32_t *queueDepthMax,
+				   uint64_t *waitTime,
+				   uint64_t *waitTimeMax,
+				   uint32_t *deadlineMisses)
+{
+    TPM_RC	rc = 0;
+
+    pthread_mutex_lock(&scheduler->mutex);
+    *commands = scheduler->commands;
+    *queueDepth = scheduler->queueDepth;
+    *queueDepthMax = scheduler->queueDepthMax;
+    *waitTime = scheduler->waitTime;
+    *waitTimeMax = scheduler->waitTimeMax;
+    *deadlineMisses = scheduler->deadlineMisses;
+    pthread_mutex_unlock(&scheduler->mutex);
+    return rc;
+}
+
+/* TSS_Scheduler_Transmit() waits for the turn of the tssContext command, transmits it on the
+   transport context, and grants the next command.
+*/
+
+TPM_RC TSS_Scheduler_Transmit(TSS_CONTEXT *tssContext,
+			      uint8_t *responseBuffer, uint32_t *read,
+			      const uint8_t *commandBuffer, uint32_t written,
+			      const char *message)
+{
+    TPM_RC			rc = 0;
+    TSS_SCHEDULER		*scheduler = tssContext->tssScheduler;
+    TSS_SCHEDULER_REQUEST 	request;
+    uint64_t			startTime;
+    uint64_t			waitTime;
+
+    startTime = TSS_Scheduler_GetTime();
+    request.priority = tssContext->tssSchedulerPriority;
+    if (tssContext->tssSchedulerDeadline != 0) {
+	request.deadline = startTime + ((uint64_t)tssContext->tssSchedulerDeadline * 1000);
+    }
+    else {
+	request.deadline = 0;
+    }
+    TSS_Scheduler_Acquire(scheduler, &request);
+    waitTime = TSS_Scheduler_GetTime() - startTime;
+    if (tssVverbose) printf("TSS_Scheduler_Transmit: %s priority %u waited %llu usec\n",
+			    message, request.priority, (unsigned long long)waitTime);
+    pthread_mutex_lock(&scheduler->mutex);
+    scheduler->commands++;
+    scheduler->waitTime += waitTime;
+    if (waitTime > scheduler->waitTimeMax) {
+	scheduler->waitTimeMax = waitTime;
+    }
+    if ((request.deadline != 0) && ((startTime + waitTime) > request.deadline)) {
+	scheduler->deadlineMisses++;
+    }
+    pthread_mutex_unlock(&scheduler->mutex);
+    rc = TSS_Transmit(scheduler->transportContext,
+		      responseBuffer, read,
+		      commandBuffer, written,
+		      message);
+    TSS_Scheduler_Release(scheduler);
+    return rc;
+}
+
+/* TSS_Scheduler_Acquire() returns when the request may transmit.  If the connection is idle and no
+   command is waiting, it returns immediately.  Otherwise the request is queued until
+   TSS_Scheduler_Release() grants it.
+*/
+
+static void TSS_Scheduler_Acquire(TSS_SCHEDULER *scheduler,
+				  TSS_SCHEDULER_REQUEST *request)
+{
+    pthread_mutex_lock(&scheduler->mutex);
+    request->sequence = scheduler->sequence++;
+    if (!scheduler->busy && (scheduler->queue == NULL)) {
+	scheduler->busy = TRUE;
+    }
+    else {
+	request->granted = FALSE;
+	request->next = scheduler->queue;
+	scheduler->queue = request;
+	scheduler->queueDepth++;
+	if (scheduler->queueDepth > scheduler->queueDepthMax) {
+	    scheduler->queueDepthMax = scheduler->queueDepth;
+	}
+	while (!request->granted) {
+	    pthread_cond_wait(&scheduler->cond, &scheduler->mutex);
+	}
+    }
+    pthread_mutex_unlock(&scheduler->mutex);
+    return;
+}
+
+/* TSS_Scheduler_Release() grants the best waiting request, which is removed from the queue, or
+   marks the connection idle.
+*/
+
+static void TSS_Scheduler_Release(TSS_SCHEDULER *scheduler)
+{
+    TSS_SCHEDULER_REQUEST **best;
+    TSS_SCHEDULER_REQUEST **current;
+    
+    pthread_mutex_lock(&scheduler->mutex);
+    if (scheduler->queue != NULL) {
+	best = &scheduler->queue;
+	for (current = &(*best)->next ; *current != NULL ; current = &(*current)->next) {
+	    if (TSS_Scheduler_IsBefore(*current, *best)) {
+		best = current;
+	    }
+	}
+	(*best)->granted = TRUE;
+	*best = (*best)->next;		/* remove from the queue, busy stays TRUE */
+	scheduler->queueDepth--;
+	pthread_cond_broadcast(&scheduler->cond);
+    }
+    else {
+	scheduler->busy = FALSE;
+    }
+    pthread_mutex_unlock(&scheduler->mutex);
+    return;
+}
+
+/* TSS_Scheduler_IsBefore() returns TRUE if request a should be sent before request b.  A command
+   with a deadline goes before one of the same priority without.
+*/
+
+static int TSS_Scheduler_IsBefore(const TSS_SCHEDULER_REQUEST *a,
+				  const TSS_SCHEDULER_REQUEST *b)
+{
+    int before;
+    
+    if (a->priority != b->priority) {
+	before = (a->priority < b->priority);
+    }
+    else if (a->deadline != b->deadline) {
+	if (a->deadline == 0) {
+	    before = FALSE;
+	}
+	else if (b->deadline == 0) {
+	    before = TRUE;
+	}
+	else {
+	    before = (a->deadline < b->deadline);
+	}
+    }
+    else {
+	before = (a->sequence < b->sequence);
+    }
+    return before;
+}
+
+/* TSS_Scheduler_GetTime() returns a monotonic time in usec */
+
+static uint64_t TSS_Scheduler_GetTime(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((uint64_t)now.tv_sec * 1000000) + ((uint64_t)now.tv_nsec / 1000);
+}
+
+#else	/* TPM_POSIX */
+
+/* The scheduler requires POSIX threads.  Other platforms cannot create one, so no context can
+   have a scheduler. */
+
+TPM_RC TSS_Scheduler_Create(TSS_SCHEDULER **scheduler,
+			    TSS_CONTEXT *transportContext)
+{
+    transportContext = transportContext;
+    *scheduler = NULL;
+    if (tssVerbose) printf("TSS_Scheduler_Create: Error, not supported on this platform\n");
+    return TSS_RC_INSUPPORTED_INTERFACE;
+}
+
+TPM_RC TSS_Scheduler_Delete(TSS_SCHEDULER *scheduler)
+{
+    scheduler = scheduler;
+    return 0;
+}
+
+TPM_RC TSS_SetScheduler(TSS_CONTEXT *tssContext,
+			TSS_SCHEDULER *scheduler)
+{
+    TPM_RC	rc = 0;
+
+    if (scheduler != NULL) {
+	rc = TSS_RC_INSUPPORTED_INTERFACE;
+    }
+    if (rc == 0) {
+	tssContext->tssScheduler = NULL;
+    }
+    return rc;
+}
+
+TPM_RC TSS_Scheduler_GetStatistics(TSS_SCHEDULER *scheduler,
+				   uint32_t *commands,
+				   uint32_t *queueDepth,
+				   uint32_t *queueDepthMax,
+				   uint64_t *waitTime,
+				   uint64_t *waitTimeMax,
+				   uint32_t *deadlineMisses)
+{
+    scheduler = scheduler;
+    *commands = 0;
+    *queueDepth = 0;
+    *queueDepthMax = 0;
+    *waitTime = 0;
+    *waitTimeMax = 0;
+    *deadlineMisses = 0;
+    return 0;
+}
+
+TPM_RC TSS_Scheduler_Transmit(TSS_CONTEXT *tssContext,
+			      uint8_t *responseBuffer, uint32_t *read,
+			      const uint8_t *commandBuffer, uint32_t written,
+			      const char *message)
+{
+    return TSS_Transmit(tssContext,
+			responseBuffer, read,
+			commandBuffer, written,
+			message);
+}
+
+#endif	/* TPM_POSIX */
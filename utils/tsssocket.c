@@ -47,14 +47,19 @@
 
 #ifdef TPM_POSIX
 #include <unistd.h>
+#include <time.h>
 #include <arpa/inet.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/un.h>
 #include <netdb.h>
 #endif
 
 #ifdef TPM_WINDOWS
 #include <winsock2.h>
+#include <ws2tcpip.h>
 #endif
 
 #include <sys/types.h>
@@ -69,17 +74,47 @@
 
 #include "tsssocket.h"
 
+/* TSS_SOCKET_VECTOR is one buffer of a scatter gather send */
+
+typedef struct {
+    const uint8_t	*buffer;
+    size_t		length;
+} TSS_SOCKET_VECTOR;
+
+#define TSS_SOCKET_VECTOR_MAX	2	/* MS simulator header, TPM command packet */
+
 /* local prototypes */
 
 static uint32_t TSS_Socket_Open(TSS_CONTEXT *tssContext, short port);
+static uint32_t TSS_Socket_OpenInet(TSS_CONTEXT *tssContext, short port);
+#ifdef TPM_POSIX
+static uint32_t TSS_Socket_OpenUnix(TSS_CONTEXT *tssContext, short port);
+#endif
+static uint32_t TSS_Socket_Connect(TSS_CONTEXT *tssContext,
+				   int family,
+				   const struct sockaddr *addr,
+				   socklen_t addrlen);
+static void TSS_Socket_CloseFd(TSS_SOCKET_FD sock_fd);
+static uint32_t TSS_Socket_Reopen(TSS_CONTEXT *tssContext, short port);
+static void TSS_Socket_Drop(TSS_CONTEXT *tssContext);
+static void TSS_Socket_Sleep(unsigned int msec);
 static uint32_t TSS_Socket_SendCommand(TSS_CONTEXT *tssContext,
 				       const uint8_t *buffer, uint16_t length,
 				       const char *message);
 static uint32_t TSS_Socket_SendPlatform(TSS_SOCKET_FD sock_fd, uint32_t command, const char *message);
-static uint32_t TSS_Socket_ReceiveCommand(TSS_CONTEXT *tssContext, uint8_t *buffer, uint32_t *length);
+static uint32_t TSS_Socket_ReceiveCommand(TSS_CONTEXT *tssContext,
+					  uint8_t *buffer, uint32_t *length);
+static uint32_t TSS_Socket_ReceiveFrame(TSS_CONTEXT *tssContext,
+					uint8_t *frame,
+					uint32_t *received,
+					uint32_t needed,
+					uint32_t capacity);
 static uint32_t TSS_Socket_ReceivePlatform(TSS_SOCKET_FD sock_fd);
 static uint32_t TSS_Socket_ReceiveBytes(TSS_SOCKET_FD sock_fd, uint8_t *buffer, uint32_t nbytes);
 static uint32_t TSS_Socket_SendBytes(TSS_SOCKET_FD sock_fd, const uint8_t *buffer, size_t length);
+static uint32_t TSS_Socket_SendVector(TSS_CONTEXT *tssContext,
+				      TSS_SOCKET_VECTOR *vector,
+				      unsigned int count);
 
 static uint32_t TSS_Socket_GetServerType(TSS_CONTEXT *tssContext,
 					 int *mssim);
@@ -111,10 +146,7 @@ TPM_RC TSS_Socket_TransmitPlatform(TSS_CONTEXT *tssContext,
 	    }
 	}
 	if (rc == 0) {
-	    rc = TSS_Socket_Open(tssContext, tssContext->tssPlatformPort);
-	}
-	if (rc == 0) {
-	    tssContext->tssFirstTransmit = FALSE;
+	    rc = TSS_Socket_Reopen(tssContext, tssContext->tssPlatformPort);
 	}
     }
     if (rc == 0) {
@@ -123,6 +155,9 @@ TPM_RC TSS_Socket_TransmitPlatform(TSS_CONTEXT *tssContext,
     if (rc == 0) {
 	rc = TSS_Socket_ReceivePlatform(tssContext->sock_fd);
     }
+    if (rc == TSS_RC_BAD_CONNECTION) {
+	TSS_Socket_Drop(tssContext);
+    }
     return rc;
 }
 
@@ -131,6 +166,15 @@ TPM_RC TSS_Socket_TransmitPlatform(TSS_CONTEXT *tssContext,
    It can return socket transmit and receive packet errors, but normally returns the TPM response
    code.
 
+   The connection stays open for the life of the TSS_CONTEXT.  After a connection error, it is
+   dropped and the next command reconnects.
+
+   A reused connection may have been closed by the server between commands, e.g. by a simulator
+   restart.  This is detected from the send or receive error, with no extra system call per
+   command.  The command is resent once on a new connection only if the send failed, since the
+   TPM cannot have executed a command it did not receive.  A receive error is returned, because
+   once the command was sent the TPM may have executed it, and a resend could run a command that
+   changes state twice.  The next command reconnects.
 */
 
 TPM_RC TSS_Socket_Transmit(TSS_CONTEXT *tssContext,
@@ -141,6 +185,7 @@ TPM_RC TSS_Socket_Transmit(TSS_CONTEXT *tssContext,
     TPM_RC 	rc = 0;
     int 	mssim;	/* boolean, true for MS simulator packet format, false for raw packet
 			   format */
+    int		reused = FALSE;	/* boolean, the connection was open before this command */
 
     /* open on first transmit */
     if (tssContext->tssFirstTransmit) {	
@@ -149,21 +194,33 @@ TPM_RC TSS_Socket_Transmit(TSS_CONTEXT *tssContext,
 	    rc = TSS_Socket_GetServerType(tssContext, &mssim);
 	}
 	if (rc == 0) {
-	    rc = TSS_Socket_Open(tssContext, tssContext->tssCommandPort);
-	}
-	if (rc == 0) {
-	    tssContext->tssFirstTransmit = FALSE;
+	    rc = TSS_Socket_Reopen(tssContext, tssContext->tssCommandPort);
 	}
     }
+    else {
+	reused = TRUE;
+    }
     /* send the command over the socket.  Error if the socket send fails. */
     if (rc == 0) {
+	tssContext->tssSocketCommands++;
 	rc = TSS_Socket_SendCommand(tssContext, commandBuffer, written, message);
     }
+    /* the server may have closed a reused connection, reconnect and resend */
+    if ((rc == TSS_RC_BAD_CONNECTION) && reused) {
+	TSS_Socket_Drop(tssContext);
+	rc = TSS_Socket_Reopen(tssContext, tssContext->tssCommandPort);
+	if (rc == 0) {
+	    rc = TSS_Socket_SendCommand(tssContext, commandBuffer, written, message);
+	}
+    }
     /* receive the response over the socket.  Returns socket errors, malformed response errors.
        Else returns the TPM response code. */
     if (rc == 0) {
 	rc = TSS_Socket_ReceiveCommand(tssContext, responseBuffer, read);
     }
+    if (rc == TSS_RC_BAD_CONNECTION) {
+	TSS_Socket_Drop(tssContext);
+    }
     return rc;
 }
 
@@ -198,78 +255,258 @@ static uint32_t TSS_Socket_GetServerType(TSS_CONTEXT *tssContext, int *mssim)
 
 /* TSS_Socket_Open() opens the socket to the TPM Host emulation to tssServerName:port
 
+   The server name is resolved with getaddrinfo(), so it can be an IPv4 or IPv6 address or a host
+   name, and each address is tried in turn.  For example, localhost may resolve to ::1 before
+   127.0.0.1.
+
+   On Posix, a server name starting with '/' is a Unix domain socket path.  Since the simulator
+   has a command and a platform socket, the port is appended, e.g. /var/run/tpm is opened as
+   /var/run/tpm.2321 and /var/run/tpm.2322.
 */
 
 static uint32_t TSS_Socket_Open(TSS_CONTEXT *tssContext, short port)
 {
+    uint32_t		rc = 0;
 #ifdef TPM_WINDOWS 
     WSADATA 		wsaData;
     int			irc;
 #endif
-    struct sockaddr_in 	serv_addr;
-    struct hostent 	*host = NULL;
 
     if (tssVverbose) printf("TSS_Socket_Open: Opening %s:%hu-%s\n",
 			    tssContext->tssServerName, port, tssContext->tssServerType);
-    /* create a socket */
 #ifdef TPM_WINDOWS
-    if ((irc = WSAStartup(0x202, &wsaData)) != 0) {		/* if not successful */
-	if (tssVerbose) printf("TSS_Socket_Open: Error, WSAStartup failed\n");
-	WSACleanup();
-	return TSS_RC_NO_CONNECTION;
+    if (rc == 0) {
+	if ((irc = WSAStartup(0x202, &wsaData)) != 0) {		/* if not successful */
+	    if (tssVerbose) printf("TSS_Socket_Open: Error, WSAStartup failed\n");
+	    WSACleanup();
+	    rc = TSS_RC_NO_CONNECTION;
+	}
+    }
+#endif 
+    if (rc == 0) {
+#ifdef TPM_POSIX
+	if (tssContext->tssServerName[0] == '/') {
+	    rc = TSS_Socket_OpenUnix(tssContext, port);
+	}
+	else
+#endif
+	{
+	    rc = TSS_Socket_OpenInet(tssContext, port);
+	}
     }
-    if ((tssContext->sock_fd = socket(AF_INET,SOCK_STREAM, 0)) == INVALID_SOCKET) {
-	if (tssVerbose) printf("TSS_Socket_Open: client socket() error: %u\n", tssContext->sock_fd);
-	return TSS_RC_NO_CONNECTION;
+#ifdef TPM_WINDOWS
+    if (rc != 0) {
+	WSACleanup();
     }
 #endif 
+    return rc;
+}
+
+/* TSS_Socket_OpenInet() resolves tssServerName:port and connects to the first address that
+   accepts the connection.
+*/
+
+static uint32_t TSS_Socket_OpenInet(TSS_CONTEXT *tssContext, short port)
+{
+    uint32_t		rc = 0;
+    int			irc;
+    char		service[8];
+    struct addrinfo	hints;
+    struct addrinfo	*result = NULL;		/* freed @1 */
+    struct addrinfo	*ai;
+
+    if (rc == 0) {
+	memset(&hints, 0, sizeof(hints));
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+	hints.ai_protocol = IPPROTO_TCP;
+	sprintf(service, "%hu", (unsigned short)port);
+	irc = getaddrinfo(tssContext->tssServerName, service, &hints, &result);
+	if (irc != 0) {
+	    if (tssVerbose) printf("TSS_Socket_Open: server name error, name %s, %s\n",
+				   tssContext->tssServerName, gai_strerror(irc));
+	    rc = TSS_RC_NO_CONNECTION;
+	}
+    }
+    if (rc == 0) {
+	rc = TSS_RC_NO_CONNECTION;	/* until an address connects */
+	for (ai = result ; (ai != NULL) && (rc != 0) ; ai = ai->ai_next) {
+	    rc = TSS_Socket_Connect(tssContext, ai->ai_family,
+				    ai->ai_addr, (socklen_t)ai->ai_addrlen);
+	}
+	if (rc != 0) {
+	    if (tssVerbose) printf("TSS_Socket_Open: Error on connect to %s:%u\n",
+				   tssContext->tssServerName, (unsigned short)port);
+	}
+    }
+    if (result != NULL) {
+	freeaddrinfo(result);		/* @1 */
+    }
+    return rc;
+}
+
 #ifdef TPM_POSIX
-    if ((tssContext->sock_fd = socket(AF_INET,SOCK_STREAM, 0)) < 0) {
-	if (tssVerbose) printf("TSS_Socket_Open: client socket error: %d %s\n",
-			       errno,strerror(errno));
-	return TSS_RC_NO_CONNECTION;
+
+/* TSS_Socket_OpenUnix() connects to the Unix domain socket tssServerName.port */
+
+static uint32_t TSS_Socket_OpenUnix(TSS_CONTEXT *tssContext, short port)
+{
+    uint32_t		rc = 0;
+    int			irc;
+    struct sockaddr_un	serv_addr;
+
+    if (rc == 0) {
+	memset(&serv_addr, 0, sizeof(serv_addr));
+	serv_addr.sun_family = AF_UNIX;
+	irc = snprintf(serv_addr.sun_path, sizeof(serv_addr.sun_path), "%s.%hu",
+		       tssContext->tssServerName, (unsigned short)port);
+	if ((irc < 0) || ((size_t)irc >= sizeof(serv_addr.sun_path))) {
+	    if (tssVerbose) printf("TSS_Socket_Open: server path %s too long\n",
+				   tssContext->tssServerName);
+	    rc = TSS_RC_NO_CONNECTION;
+	}
+    }
+    if (rc == 0) {
+	rc = TSS_Socket_Connect(tssContext, AF_UNIX,
+				(struct sockaddr *)&serv_addr, sizeof(serv_addr));
+	if (rc != 0) {
+	    if (tssVerbose) printf("TSS_Socket_Open: Error on connect to %s\n",
+				   serv_addr.sun_path);
+	}
     }
+    return rc;
+}
+
 #endif
-    memset((char *)&serv_addr,0x0,sizeof(serv_addr));
-    serv_addr.sin_family = AF_INET;
-    serv_addr.sin_port = htons(port);
-
-    /* the server host name tssServerName came from the default or an environment variable */
-    /* first assume server is dotted decimal number and call inet_addr */
-    if ((int)(serv_addr.sin_addr.s_addr = inet_addr(tssContext->tssServerName)) == -1) {
-	/* if inet_addr fails, assume server is a name and call gethostbyname to look it up */
-	/* if gethostbyname also fails */
-	if ((host = gethostbyname(tssContext->tssServerName)) == NULL) {
-	    if (tssVerbose) printf("TSS_Socket_Open: server name error, name %s\n",
-				   tssContext->tssServerName);
-	    return TSS_RC_NO_CONNECTION;
+
+/* TSS_Socket_Connect() creates a socket and connects it to the address.
+
+   TCP sockets disable the Nagle algorithm.  A command is sent as several small writes followed by
+   a read, which otherwise waits for the delayed acknowledgement on every command.
+*/
+
+static uint32_t TSS_Socket_Connect(TSS_CONTEXT *tssContext,
+				   int family,
+				   const struct sockaddr *addr,
+				   socklen_t addrlen)
+{
+    uint32_t		rc = 0;
+    int			irc;
+
+    /* create a socket */
+    if (rc == 0) {
+	tssContext->sock_fd = socket(family, SOCK_STREAM, 0);
+#ifdef TPM_POSIX
+	if (tssContext->sock_fd < 0) {
+#endif
+#ifdef TPM_WINDOWS
+	if (tssContext->sock_fd == INVALID_SOCKET) {
+#endif
+	    if (tssVerbose) printf("TSS_Socket_Open: client socket error: %d %s\n",
+				   errno, strerror(errno));
+	    rc = TSS_RC_NO_CONNECTION;
 	}
-	serv_addr.sin_family = host->h_addrtype;
-	memcpy(&serv_addr.sin_addr, host->h_addr, host->h_length);
     }
     /* establish the connection to the TPM server */
-#ifdef TPM_POSIX
-    if (connect(tssContext->sock_fd, (struct sockaddr *)&serv_addr, sizeof(serv_addr)) < 0) {
-	if (tssVerbose) printf("TSS_Socket_Open: Error on connect to %s:%u\n",
-			       tssContext->tssServerName, port);
-	if (tssVerbose) printf("TSS_Socket_Open: client connect: error %d %s\n",
-			       errno,strerror(errno));
-	return TSS_RC_NO_CONNECTION;
+    if (rc == 0) {
+	irc = connect(tssContext->sock_fd, addr, addrlen);
+	if (irc != 0) {
+	    if (tssVverbose) printf("TSS_Socket_Open: client connect: error %d %s\n",
+				    errno, strerror(errno));
+	    TSS_Socket_CloseFd(tssContext->sock_fd);
+	    rc = TSS_RC_NO_CONNECTION;
+	}
+    }
+    if ((rc == 0) && (family != AF_UNIX)) {
+	int nodelay = 1;
+	irc = setsockopt(tssContext->sock_fd, IPPROTO_TCP, TCP_NODELAY,
+			 (const char *)&nodelay, sizeof(nodelay));
+	if (irc != 0) {		/* not fatal, only slower */
+	    if (tssVerbose) printf("TSS_Socket_Open: TCP_NODELAY error %d %s\n",
+				   errno, strerror(errno));
+	}
     }
+    return rc;
+}
+
+/* TSS_Socket_CloseFd() closes a socket without any protocol shutdown */
+
+static void TSS_Socket_CloseFd(TSS_SOCKET_FD sock_fd)
+{
+#ifdef TPM_POSIX
+    close(sock_fd);
 #endif
 #ifdef TPM_WINDOWS
-    if (connect(tssContext->sock_fd, (struct sockaddr *)&serv_addr, sizeof(serv_addr)) != 0) {
-	if (tssVerbose) printf("TSS_Socket_Open: Error on connect to %s:%u\n",
-			       tssContext->tssServerName, port);
-	if (tssVerbose) printf("TSS_Socket_Open: client connect: error %d %s\n",
-			       errno,strerror(errno));
-	return TSS_RC_NO_CONNECTION;
-    }
+    closesocket(sock_fd);
 #endif
-    else {
-	/*  	printf("TSS_Socket_Open: client connect: success\n"); */
+    return;
+}
+
+/* TSS_Socket_Reopen() opens the connection on the first transmit or after a connection failure.
+
+   If the server is not (yet) accepting connections, the open is retried up to tssConnectRetryCount
+   times, with an exponential backoff starting at tssConnectRetryDelay msec.  This lets a client
+   ride out a simulator restart.  The retry is off by default, so that an open with no server fails
+   at once.
+*/
+
+static uint32_t TSS_Socket_Reopen(TSS_CONTEXT *tssContext, short port)
+{
+    uint32_t		rc = 0;
+    unsigned int	attempt;
+    unsigned int	delay = tssContext->tssConnectRetryDelay;
+
+    for (attempt = 0 ; ; attempt++) {
+	rc = TSS_Socket_Open(tssContext, port);
+	if ((rc != TSS_RC_NO_CONNECTION) || (attempt >= tssContext->tssConnectRetryCount)) {
+	    break;
+	}
+	if (tssVverbose) printf("TSS_Socket_Reopen: reconnect after %u msec\n", delay);
+	TSS_Socket_Sleep(delay);
+	delay *= 2;
+	if (delay > TSS_CONNECT_RETRY_DELAY_MAX) {
+	    delay = TSS_CONNECT_RETRY_DELAY_MAX;
+	}
     }
-    return 0;
+    if (rc == 0) {
+	tssContext->tssFirstTransmit = FALSE;
+    }
+    return rc;
+}
+
+/* TSS_Socket_Drop() abandons a connection after a send or receive error.  The stream is no
+   longer synchronized with the server, so no TPM_SESSION_END is sent.  The next transmit reopens
+   the connection, so the TSS_CONTEXT remains usable.
+*/
+
+static void TSS_Socket_Drop(TSS_CONTEXT *tssContext)
+{
+    if (tssVerbose) printf("TSS_Socket_Drop: Closing %s after a connection error\n",
+			   tssContext->tssServerName);
+    TSS_Socket_CloseFd(tssContext->sock_fd);
+#ifdef TPM_WINDOWS
+    WSACleanup();
+#endif
+    tssContext->tssFirstTransmit = TRUE;
+    return;
+}
+
+/* TSS_Socket_Sleep() sleeps before a reconnect.  nanosleep() is used rather than usleep(), which
+   may reject a delay of a second or more. */
+
+static void TSS_Socket_Sleep(unsigned int msec)
+{
+#ifdef TPM_POSIX
+    struct timespec	delay;
+
+    delay.tv_sec = msec / 1000;
+    delay.tv_nsec = (long)(msec % 1000) * 1000000;
+    nanosleep(&delay, NULL);
+#endif
+#ifdef TPM_WINDOWS
+    Sleep(msec);
+#endif
+    return;
 }
 
 /* TSS_Socket_SendCommand() sends the TPM command packet over the socket.
@@ -277,10 +514,12 @@ static uint32_t TSS_Socket_Open(TSS_CONTEXT *tssContext, short port)
    The MS simulator packet is of the form:
 
    TPM_SEND_COMMAND
-   locality 0
+   locality		(from the TPM_LOCALITY property)
    length
    TPM command packet	(this is the raw packet format)
 
+   The raw packet format has no way to convey locality, so a non-zero locality is an error.
+
    Returns an error if the socket send fails.
 */
 
@@ -304,22 +543,103 @@ static uint32_t TSS_Socket_SendCommand(TSS_CONTEXT *tssContext,
     if (rc == 0) {
 	rc = TSS_Socket_GetServerType(tssContext, &mssim);
     }
-    /* MS simulator wants a command type, locality, length */
-    if ((rc == 0) && mssim) {
-	uint32_t commandType = htonl(TPM_SEND_COMMAND);	/* command type is network byte order */
-	rc = TSS_Socket_SendBytes(tssContext->sock_fd, (uint8_t *)&commandType, sizeof(uint32_t));
+    if ((rc == 0) && !mssim && (tssContext->tssLocality != 0)) {
+	if (tssVerbose) printf("TSS_Socket_SendCommand: Error, locality %u requires mssim\n",
+			       tssContext->tssLocality);
+	rc = TSS_RC_INSUPPORTED_INTERFACE;
     }
-    if ((rc == 0) && mssim) {
-	uint8_t locality = 0;
-	rc = TSS_Socket_SendBytes(tssContext->sock_fd, &locality, sizeof(uint8_t));
-    }
-    if ((rc == 0) && mssim) {
-	uint32_t lengthNbo = htonl(length);	/* length is network byte order */
-	rc = TSS_Socket_SendBytes(tssContext->sock_fd, (uint8_t *)&lengthNbo, sizeof(uint32_t));
-    }
-    /* all packet formats (types) send the TPM command packet */
+    /* MS simulator wants a command type, locality, length, sent with the TPM command packet in one
+       call */
     if (rc == 0) {
-	rc = TSS_Socket_SendBytes(tssContext->sock_fd, buffer, length);
+	TSS_SOCKET_VECTOR	vector[2];
+	unsigned int		count = 0;
+	uint8_t			header[sizeof(uint32_t) + sizeof(uint8_t) + sizeof(uint32_t)];
+	if (mssim) {
+	    uint32_t commandType = htonl(TPM_SEND_COMMAND);	/* network byte order */
+	    uint32_t lengthNbo = htonl(length);			/* network byte order */
+	    memcpy(header, &commandType, sizeof(uint32_t));
+	    header[sizeof(uint32_t)] = (uint8_t)tssContext->tssLocality;
+	    memcpy(header + sizeof(uint32_t) + sizeof(uint8_t), &lengthNbo, sizeof(uint32_t));
+	    vector[count].buffer = header;
+	    vector[count].length = sizeof(header);
+	    count++;
+	}
+	/* all packet formats (types) send the TPM command packet */
+	vector[count].buffer = buffer;
+	vector[count].length = length;
+	count++;
+	rc = TSS_Socket_SendVector(tssContext, vector, count);
+    }
+    return rc;
+}
+
+/* TSS_Socket_SendVector() transmits the buffers in 'vector' with as few send calls as possible,
+   normally one.  It handles partial writes by looping.
+
+   Returns an error if the socket send fails.
+*/
+
+static uint32_t TSS_Socket_SendVector(TSS_CONTEXT *tssContext,
+				      TSS_SOCKET_VECTOR *vector,
+				      unsigned int count)
+{
+    uint32_t		rc = 0;
+    unsigned int	first = 0;	/* first vector element not completely sent */
+    size_t		offset = 0;	/* bytes of vector[first] already sent */
+    size_t		nwritten;
+    
+    while ((rc == 0) && (first < count)) {
+	unsigned int	i;
+#ifdef TPM_POSIX
+	struct iovec	iov[TSS_SOCKET_VECTOR_MAX];
+	struct msghdr	msg;
+	ssize_t		irc;
+	int		flags = 0;
+	for (i = first ; i < count ; i++) {
+	    iov[i - first].iov_base = (void *)(vector[i].buffer + ((i == first) ? offset : 0));
+	    iov[i - first].iov_len = vector[i].length - ((i == first) ? offset : 0);
+	}
+	memset(&msg, 0, sizeof(msg));
+	msg.msg_iov = iov;
+	msg.msg_iovlen = count - first;
+	/* a closed connection is reported as an error, not SIGPIPE */
+#ifdef MSG_NOSIGNAL
+	flags = MSG_NOSIGNAL;
+#endif
+	irc = sendmsg(tssContext->sock_fd, &msg, flags);
+	tssContext->tssSocketWrites++;
+	if (irc < 0) {
+	    if (tssVerbose) printf("TSS_Socket_SendVector: write error %d %s\n",
+				   errno, strerror(errno));
+	    rc = TSS_RC_BAD_CONNECTION;
+	}
+	nwritten = (size_t)irc;
+#endif
+#ifdef TPM_WINDOWS
+	WSABUF		wsabuf[TSS_SOCKET_VECTOR_MAX];
+	DWORD		sent;
+	int		irc;
+	for (i = first ; i < count ; i++) {
+	    wsabuf[i - first].buf = (char *)(vector[i].buffer + ((i == first) ? offset : 0));
+	    wsabuf[i - first].len = (ULONG)(vector[i].length - ((i == first) ? offset : 0));
+	}
+	irc = WSASend(tssContext->sock_fd, wsabuf, count - first, &sent, 0, NULL, NULL);
+	tssContext->tssSocketWrites++;
+	if (irc == SOCKET_ERROR) {
+	    if (tssVerbose) printf("TSS_Socket_SendVector: write error %d\n", WSAGetLastError());
+	    rc = TSS_RC_BAD_CONNECTION;
+	}
+	nwritten = sent;
+#endif
+	/* skip the elements that were completely sent */
+	while ((rc == 0) && (first < count) && (nwritten >= (vector[first].length - offset))) {
+	    nwritten -= vector[first].length - offset;
+	    offset = 0;
+	    first++;
+	}
+	if ((rc == 0) && (first < count)) {
+	    offset += nwritten;
+	}
     }
     return rc;
 }
@@ -362,7 +682,12 @@ static uint32_t TSS_Socket_SendBytes(TSS_SOCKET_FD sock_fd, const uint8_t *buffe
     nleft = length;
     while (nleft > 0) {
 #ifdef TPM_POSIX
+	/* a closed connection is reported as an error, not SIGPIPE */
+#ifdef MSG_NOSIGNAL
+	nwritten = send(sock_fd, &buffer[offset], nleft, MSG_NOSIGNAL);
+#else
 	nwritten = write(sock_fd, &buffer[offset], nleft);
+#endif
 	if (nwritten < 0) {        /* error */
 	    if (tssVerbose) printf("TSS_Socket_SendBytes: write error %d\n", (int)nwritten);
 	    return TSS_RC_BAD_CONNECTION;
@@ -391,6 +716,10 @@ static uint32_t TSS_Socket_SendBytes(TSS_SOCKET_FD sock_fd, const uint8_t *buffe
    TPM response packet		(this is the raw packet format)
    acknowledgement uint32_t zero
 
+   The whole packet is read into a frame buffer with as few receive calls as possible, normally
+   one, rather than one or more per field.  The server sends nothing beyond the response, so the
+   first read can ask for the largest possible packet.
+
    If the receive succeeds, returns TPM packet error code.
 
    Validates that the packet length and the packet responseSize match 
@@ -400,10 +729,16 @@ static uint32_t TSS_Socket_ReceiveCommand(TSS_CONTEXT *tssContext,
 					  uint8_t *buffer, uint32_t *length)
 {
     uint32_t 	rc = 0;
+    uint8_t	frame[sizeof(uint32_t) + MAX_RESPONSE_SIZE + sizeof(uint32_t)];
+    uint32_t	received = 0;	/* bytes in frame */
+    uint32_t	needed;		/* bytes in the complete packet, once known */
+    uint32_t	prefixSize;	/* MS simulator length */
+    uint32_t	suffixSize;	/* MS simulator acknowledgement */
     uint32_t 	responseSize = 0;
     uint32_t 	responseLength = 0;
-    uint8_t 	*bufferPtr = buffer;	/* the moving buffer */
+    uint8_t 	*bufferPtr;
     TPM_RC 	responseCode;
+    uint32_t	acknowledgement = 0;
     INT32 	size;		/* dummy for unmarshal call */
     int 	mssim;		/* boolean, true for MS simulator packet format, false for raw
 				   packet format */
@@ -412,31 +747,34 @@ static uint32_t TSS_Socket_ReceiveCommand(TSS_CONTEXT *tssContext,
     if (rc == 0) {
 	rc = TSS_Socket_GetServerType(tssContext, &mssim);
     }
-    /* read the length prepended by the simulator */
-    if ((rc == 0) && mssim) {
-	rc = TSS_Socket_ReceiveBytes(tssContext->sock_fd,
-				     (uint8_t *)&responseLength, sizeof(uint32_t));
-	responseLength = ntohl(responseLength);
-    }
-    /* read the tag and responseSize */
     if (rc == 0) {
-	rc = TSS_Socket_ReceiveBytes(tssContext->sock_fd,
-				     bufferPtr, sizeof(TPM_ST) + sizeof(uint32_t));
+	prefixSize = mssim ? sizeof(uint32_t) : 0;
+	suffixSize = mssim ? sizeof(uint32_t) : 0;
+	/* the length prepended by the simulator, the tag, and the responseSize */
+	needed = prefixSize + sizeof(TPM_ST) + sizeof(uint32_t);
+	rc = TSS_Socket_ReceiveFrame(tssContext, frame, &received, needed, sizeof(frame));
     }
     /* extract the responseSize */
     if (rc == 0) {
+	if (mssim) {
+	    memcpy(&responseLength, frame, sizeof(uint32_t));
+	    responseLength = ntohl(responseLength);
+	}
 	/* skip over tag to responseSize */
-	bufferPtr += sizeof(TPM_ST);
-	
+	bufferPtr = frame + prefixSize + sizeof(TPM_ST);
 	size = sizeof(uint32_t);		/* dummy for call */
 	rc = UINT32_Unmarshal(&responseSize, &bufferPtr, &size);
 	*length = responseSize;			/* returned length */
-
+    }
+    if (rc == 0) {
 	/* check the response size, see TSS_CONTEXT structure */
-	if (responseSize > MAX_RESPONSE_SIZE) {
+	if ((responseSize > MAX_RESPONSE_SIZE) ||
+	    (responseSize < (sizeof(TPM_ST) + sizeof(uint32_t) + sizeof(TPM_RC)))) {
 	    if (tssVerbose)
-		printf("TSS_Socket_ReceiveCommand: ERROR: responseSize %u greater than %u\n",
-		       responseSize, MAX_RESPONSE_SIZE);
+		printf("TSS_Socket_ReceiveCommand: ERROR: responseSize %u not between %lu and %u\n",
+		       responseSize,
+		       (unsigned long)(sizeof(TPM_ST) + sizeof(uint32_t) + sizeof(TPM_RC)),
+		       MAX_RESPONSE_SIZE);
 	    rc = TSS_RC_BAD_CONNECTION;
 	}
 	/* check that MS sim prepended length is the same as the response TPM packet
@@ -448,22 +786,30 @@ static uint32_t TSS_Socket_ReceiveCommand(TSS_CONTEXT *tssContext,
 	    rc = TSS_RC_BAD_CONNECTION;
 	}
     }
-    /* read the rest of the packet */
+    /* read the rest of the packet, and the MS sim acknowledgement */
     if (rc == 0) {
-	rc = TSS_Socket_ReceiveBytes(tssContext->sock_fd,
-				     bufferPtr,
-				     responseSize - (sizeof(TPM_ST) + sizeof(uint32_t)));
+	needed = prefixSize + responseSize + suffixSize;
+	rc = TSS_Socket_ReceiveFrame(tssContext, frame, &received, needed, needed);
+    }
+    /* a request response protocol should never have more */
+    if (rc == 0) {
+	if (received != needed) {
+	    if (tssVerbose) printf("TSS_Socket_ReceiveCommand: "
+				   "ERROR: received %u bytes, expected %u\n",
+				   received, needed);
+	    rc = TSS_RC_BAD_CONNECTION;
+	}
+    }
+    if (rc == 0) {
+	memcpy(buffer, frame + prefixSize, responseSize);
+	if (mssim) {
+	    memcpy(&acknowledgement, frame + prefixSize + responseSize, sizeof(uint32_t));
+	}
     }
     if ((rc == 0) && tssVverbose) {
 	TSS_PrintAll("TSS_Socket_ReceiveCommand",
 		     buffer, responseSize);
     }
-    /* read the MS sim acknowledgement */
-    TPM_RC 	acknowledgement;
-    if ((rc == 0) && mssim) {
-	rc = TSS_Socket_ReceiveBytes(tssContext->sock_fd,
-				     (uint8_t *)&acknowledgement, sizeof(uint32_t));
-    }
     /* extract the TPM return code from the packet */
     if (rc == 0) {
 	/* skip to responseCode */
@@ -482,6 +828,49 @@ static uint32_t TSS_Socket_ReceiveCommand(TSS_CONTEXT *tssContext,
     return rc;
 }
 
+/* TSS_Socket_ReceiveFrame() reads into 'frame' until it holds at least 'needed' bytes.  'received'
+   is the number of bytes already in the frame, and is updated.  Each read asks for up to
+   'capacity' bytes total, so a read can return more than 'needed'.
+*/
+
+static uint32_t TSS_Socket_ReceiveFrame(TSS_CONTEXT *tssContext,
+					uint8_t *frame,
+					uint32_t *received,
+					uint32_t needed,
+					uint32_t capacity)
+{
+    uint32_t	rc = 0;
+    int		nread;
+
+    while ((rc == 0) && (*received < needed)) {
+#ifdef TPM_POSIX
+	nread = read(tssContext->sock_fd, frame + *received, capacity - *received);
+	tssContext->tssSocketReads++;
+	if (nread < 0) {       /* error */
+	    if (tssVerbose)  printf("TSS_Socket_ReceiveFrame: read error %d\n", nread);
+	    rc = TSS_RC_BAD_CONNECTION;
+	}
+#endif
+#ifdef TPM_WINDOWS
+	/* cast for winsock.  Unix uses void * */
+	nread = recv(tssContext->sock_fd, (char *)(frame + *received), capacity - *received, 0);
+	tssContext->tssSocketReads++;
+	if (nread == SOCKET_ERROR) {       /* error */
+	    if (tssVerbose) printf("TSS_Socket_ReceiveFrame: read error %d\n", nread);
+	    rc = TSS_RC_BAD_CONNECTION;
+	}
+#endif
+	else if (nread == 0) {  /* EOF */
+	    if (tssVerbose) printf("TSS_Socket_ReceiveFrame: read EOF\n");
+	    rc = TSS_RC_BAD_CONNECTION;
+	}
+	else {
+	    *received += nread;
+	}
+    }
+    return rc;
+}
+
 /* TSS_Socket_ReceivePlatform reads MS simulator platform administrative responses.  This function
    should only be called if the TPM supports administrative commands.
 
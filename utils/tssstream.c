@@ -0,0 +1,671 @@
+/********************************************************************************/
+/*										*/
+/*		       TSS Streaming Large Data Helpers				*/
+/*		       IBM Thomas J. Watson Research Center			*/
+/*			      $Id: tssstream.c $				*/
+/*										*/
+/* (c) Copyright IBM Corporation 2017.						*/
+/*										*/
+/* All rights reserved.								*/
+/* 										*/
+/* Redistribution and use in source and binary forms, with or without		*/
+/* modification, are permitted provided that the following conditions are	*/
+/* met:										*/
+/* 										*/
+/* Redistributions of source code must retain the above copyright notice,	*/
+/* this list of conditions and the following disclaimer.			*/
+/* 										*/
+/* Redistributions in binary form must reproduce the above copyright		*/
+/* notice, this list of conditions and the following disclaimer in the		*/
+/* documentation and/or other materials provided with the distribution.		*/
+/* 										*/
+/* Neither the names of the IBM Corporation nor the names of its		*/
+/* contributors may be used to endorse or promote products derived from		*/
+/* this software without specific prior written permission.			*/
+/* 										*/
+/* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS		*/
+/* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT		*/
+/* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR	*/
+/* A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT		*/
+/* HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,	*/
+/* SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT		*/
+/* LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,	*/
+/* DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY	*/
+/* THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT		*/
+/* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE	*/
+/* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.		*/
+/********************************************************************************/
+
+
+/* These functions pass application data that is larger than one TPM command buffer through the TPM.
+
+   The data is pulled from an application supplied TSS_StreamRead_t, so that it never has to be held
+   in memory all at once.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include <tss2/tss.h>
+#include <tss2/tssutils.h>
+#include <tss2/tsserror.h>
+#include <tss2/tssprint.h>
+#include <tss2/tssstream.h>
+#include <tss2/tsscapability.h>
+#include "tssproperties.h"
+#ifndef TPM_TSS_NOCRYPTO
+#include <tss2/tsscrypto.h>
+#include <tss2/tsscryptoh.h>
+#endif
+
+/* the read size when hashing in software, larger than a TPM buffer to reduce the read calls */
+
+#define TSS_STREAM_SOFTWARE_BUFFER	0x4000
+
+extern int tssVerbose;
+extern int tssVverbose;
+
+/* local prototypes */
+
+static TPM_RC TSS_Stream_SequenceUpdate(TSS_CONTEXT *tssContext,
+					TPMI_DH_OBJECT sequenceHandle,
+					TSS_StreamRead_t readFunction,
+					void *readContext,
+					uint64_t *streamed);
+static TPM_RC TSS_Stream_SequenceComplete(TSS_CONTEXT *tssContext,
+					  SequenceComplete_Out *out,
+					  TPMI_DH_OBJECT sequenceHandle,
+					  TPMI_RH_HIERARCHY hierarchy);
+static void TSS_Stream_Flush(TSS_CONTEXT *tssContext,
+			     TPMI_DH_OBJECT sequenceHandle);
+#ifndef TPM_TSS_NOCRYPTO
+static TPM_RC TSS_Hash_StreamSoftware(TPMT_HA *digest,
+				      TSS_StreamRead_t readFunction,
+				      void *readContext,
+				      uint64_t *streamed);
+#endif
+
+/* TSS_Stream_ReadFile() is a TSS_StreamRead_t for a FILE * readContext, which the caller opens and
+   closes.
+*/
+
+TPM_RC TSS_Stream_ReadFile(void *readContext,
+			   uint8_t *buffer,
+			   uint32_t bufferSize,
+			   uint32_t *bytesRead)
+{
+    TPM_RC 	rc = 0;
+    FILE 	*file = (FILE *)readContext;
+
+    if (rc == 0) {
+	*bytesRead = fread(buffer, 1, bufferSize, file);
+	if (ferror(file)) {
+	    if (tssVerbose) printf("TSS_Stream_ReadFile: Error reading file, %s\n",
+				   strerror(errno));
+	    rc = TSS_RC_FILE_READ;
+	}
+    }
+    return rc;
+}
+
+/* TSS_Stream_WriteFile() is a TSS_StreamWrite_t for a FILE * writeContext, which the caller opens
+   and closes.
+*/
+
+TPM_RC TSS_Stream_WriteFile(void *writeContext,
+			    const uint8_t *buffer,
+			    uint32_t length)
+{
+    TPM_RC 	rc = 0;
+    FILE 	*file = (FILE *)writeContext;
+    size_t	irc;
+
+    if (rc == 0) {
+	irc = fwrite(buffer, 1, length, file);
+	if (irc != length) {
+	    if (tssVerbose) printf("TSS_Stream_WriteFile: Error writing file, %s\n",
+				   strerror(errno));
+	    rc = TSS_RC_FILE_WRITE;
+	}
+    }
+    return rc;
+}
+
+/* TSS_Stream_WriteBuffer() is a TSS_StreamWrite_t for a TSS_STREAM_BUFFER writeContext.  It appends
+   to the caller's buffer, checking its size.
+*/
+
+TPM_RC TSS_Stream_WriteBuffer(void *writeContext,
+			      const uint8_t *buffer,
+			      uint32_t length)
+{
+    TPM_RC 		rc = 0;
+    TSS_STREAM_BUFFER 	*streamBuffer = (TSS_STREAM_BUFFER *)writeContext;
+
+    if (rc == 0) {
+	if (length > (streamBuffer->size - streamBuffer->length)) {
+	    if (tssVerbose) printf("TSS_Stream_WriteBuffer: size %u greater than remaining %u\n",
+				   length, streamBuffer->size - streamBuffer->length);
+	    rc = TSS_RC_INSUFFICIENT_BUFFER;
+	}
+    }
+    if ((rc == 0) && (length > 0)) {
+	memcpy(streamBuffer->buffer + streamBuffer->length, buffer, length);
+	streamBuffer->length += length;
+    }
+    return rc;
+}
+
+/* TSS_Stream_GetInputBufferMax() returns the largest data buffer that can be sent in one sequence
+   command.  The limit is the TPM property TPM_PT_INPUT_BUFFER, further limited by the TSS side
+   structure MAX_DIGEST_BUFFER.
+*/
+
+TPM_RC TSS_Stream_GetInputBufferMax(TSS_CONTEXT *tssContext,
+				    uint32_t *inputBufferMax)
+{
+    TPM_RC			rc = 0;
+
+    if (rc == 0) {
+	rc = TSS_Capability_GetProperty(tssContext, inputBufferMax, TPM_PT_INPUT_BUFFER);
+	if (rc == TSS_RC_BAD_PROPERTY) {
+	    /* the TPM minimum */
+	    *inputBufferMax = 1024;
+	    rc = 0;
+	}
+    }
+    if (rc == 0) {
+	if (*inputBufferMax > MAX_DIGEST_BUFFER) {
+	    *inputBufferMax = MAX_DIGEST_BUFFER;
+	}
+	if (tssVverbose) printf("TSS_Stream_GetInputBufferMax: %u\n", *inputBufferMax);
+    }
+    return rc;
+}
+
+/* TSS_Hash_Stream() digests all of the data returned by readFunction.
+
+   On call, digest->hashAlg is the desired hash algorithm.
+
+   If validation is NULL, a ticket is not required, and the data is hashed in software.  Otherwise,
+   the data is streamed through TPM2_HashSequenceStart, TPM2_SequenceUpdate, and
+   TPM2_SequenceComplete, and the ticket for 'hierarchy' is returned in validation.  If the TSS was
+   built without crypto, the TPM is always used.
+
+   streamed returns the number of bytes hashed.
+*/
+
+TPM_RC TSS_Hash_Stream(TSS_CONTEXT *tssContext,
+		       TPMT_HA *digest,
+		       TPMT_TK_HASHCHECK *validation,
+		       TPMI_RH_HIERARCHY hierarchy,
+		       TSS_StreamRead_t readFunction,
+		       void *readContext,
+		       uint64_t *streamed)
+{
+    TPM_RC			rc = 0;
+    HashSequenceStart_In 	in;
+    HashSequenceStart_Out 	out;
+    SequenceComplete_Out 	outComplete;
+    int				sequenceStarted = FALSE;
+    int				useTpm = TRUE;
+
+    *streamed = 0;
+#ifndef TPM_TSS_NOCRYPTO
+    if (validation == NULL) {
+	useTpm = FALSE;
+	rc = TSS_Hash_StreamSoftware(digest, readFunction, readContext, streamed);
+    }
+#endif
+    if ((rc == 0) && useTpm) {
+	in.auth.t.size = 0;
+	in.hashAlg = digest->hashAlg;
+	rc = TSS_Execute(tssContext,
+			 (RESPONSE_PARAMETERS *)&out, 
+			 (COMMAND_PARAMETERS *)&in,
+			 NULL,
+			 TPM_CC_HashSequenceStart,
+			 TPM_RH_NULL, NULL, 0);
+    }
+    if ((rc == 0) && useTpm) {
+	sequenceStarted = TRUE;
+	rc = TSS_Stream_SequenceUpdate(tssContext, out.sequenceHandle,
+				       readFunction, readContext, streamed);
+    }
+    if ((rc == 0) && useTpm) {
+	sequenceStarted = FALSE;
+	rc = TSS_Stream_SequenceComplete(tssContext, &outComplete, out.sequenceHandle, hierarchy);
+    }
+    if ((rc == 0) && useTpm) {
+	memcpy((uint8_t *)&digest->digest, outComplete.result.t.buffer, outComplete.result.t.size);
+	if (validation != NULL) {
+	    *validation = outComplete.validation;
+	}
+    }
+    if (sequenceStarted) {
+	TSS_Stream_Flush(tssContext, out.sequenceHandle);
+    }
+    return rc;
+}
+
+/* TSS_HMAC_Stream() HMACs all of the data returned by readFunction using the loaded keyHandle.
+
+   On call, digest->hashAlg is the desired hash algorithm.
+
+   The key authorization is supplied by sessionHandle, keyPassword, and sessionAttributes, as with
+   TSS_Execute().  It is only needed for TPM2_HMAC_Start.
+
+   streamed returns the number of bytes HMACed.
+*/
+
+TPM_RC TSS_HMAC_Stream(TSS_CONTEXT *tssContext,
+		       TPMT_HA *digest,
+		       TPMI_DH_OBJECT keyHandle,
+		       const char *keyPassword,
+		       TPMI_SH_AUTH_SESSION sessionHandle,
+		       unsigned int sessionAttributes,
+		       TSS_StreamRead_t readFunction,
+		       void *readContext,
+		       uint64_t *streamed)
+{
+    TPM_RC			rc = 0;
+    HMAC_Start_In 		in;
+    HMAC_Start_Out 		out;
+    SequenceComplete_Out 	outComplete;
+    int				sequenceStarted = FALSE;
+
+    *streamed = 0;
+    if (rc == 0) {
+	in.handle = keyHandle;
+	in.auth.t.size = 0;
+	in.hashAlg = digest->hashAlg;
+	rc = TSS_Execute(tssContext,
+			 (RESPONSE_PARAMETERS *)&out, 
+			 (COMMAND_PARAMETERS *)&in,
+			 NULL,
+			 TPM_CC_HMAC_Start,
+			 sessionHandle, keyPassword, sessionAttributes,
+			 TPM_RH_NULL, NULL, 0);
+    }
+    if (rc == 0) {
+	sequenceStarted = TRUE;
+	rc = TSS_Stream_SequenceUpdate(tssContext, out.sequenceHandle,
+				       readFunction, readContext, streamed);
+    }
+    if (rc == 0) {
+	sequenceStarted = FALSE;
+	rc = TSS_Stream_SequenceComplete(tssContext, &outComplete, out.sequenceHandle, TPM_RH_NULL);
+    }
+    if (rc == 0) {
+	memcpy((uint8_t *)&digest->digest, outComplete.result.t.buffer, outComplete.result.t.size);
+    }
+    if (sequenceStarted) {
+	TSS_Stream_Flush(tssContext, out.sequenceHandle);
+    }
+    return rc;
+}
+
+/* TSS_Stream_SequenceUpdate() sends all of the data returned by readFunction to the sequence object,
+   in chunks of the largest size the TPM accepts, so that the number of round trips is minimized.
+
+   The sequence object auth is always empty.
+*/
+
+static TPM_RC TSS_Stream_SequenceUpdate(TSS_CONTEXT *tssContext,
+					TPMI_DH_OBJECT sequenceHandle,
+					TSS_StreamRead_t readFunction,
+					void *readContext,
+					uint64_t *streamed)
+{
+    TPM_RC		rc = 0;
+    SequenceUpdate_In 	in;
+    uint32_t		inputBufferMax;
+    uint32_t		bytesRead;
+    int			done = FALSE;
+
+    if (rc == 0) {
+	rc = TSS_Stream_GetInputBufferMax(tssContext, &inputBufferMax);
+    }
+    while ((rc == 0) && !done) {
+	in.sequenceHandle = sequenceHandle;
+	rc = readFunction(readContext, in.buffer.t.buffer, inputBufferMax, &bytesRead);
+	if (rc == 0) {
+	    if (bytesRead > inputBufferMax) {
+		if (tssVerbose) printf("TSS_Stream_SequenceUpdate: read %u > buffer %u\n",
+				       bytesRead, inputBufferMax);
+		rc = TSS_RC_INSUFFICIENT_BUFFER;
+	    }
+	}
+	if (rc == 0) {
+	    if (bytesRead == 0) {
+		done = TRUE;
+	    }
+	}
+	if ((rc == 0) && !done) {
+	    in.buffer.t.size = bytesRead;
+	    rc = TSS_Execute(tssContext,
+			     NULL,
+			     (COMMAND_PARAMETERS *)&in,
+			     NULL,
+			     TPM_CC_SequenceUpdate,
+			     TPM_RS_PW, NULL, 0,
+			     TPM_RH_NULL, NULL, 0);
+	}
+	if ((rc == 0) && !done) {
+	    *streamed += bytesRead;
+	}
+    }
+    return rc;
+}
+
+/* TSS_Stream_SequenceComplete() completes the sequence with an empty final buffer, since all data
+   was already sent with TPM2_SequenceUpdate.
+*/
+
+static TPM_RC TSS_Stream_SequenceComplete(TSS_CONTEXT *tssContext,
+					  SequenceComplete_Out *out,
+					  TPMI_DH_OBJECT sequenceHandle,
+					  TPMI_RH_HIERARCHY hierarchy)
+{
+    TPM_RC			rc = 0;
+    SequenceComplete_In 	in;
+
+    if (rc == 0) {
+	in.sequenceHandle = sequenceHandle;
+	in.buffer.t.size = 0;
+	in.hierarchy = hierarchy;
+	rc = TSS_Execute(tssContext,
+			 (RESPONSE_PARAMETERS *)out,
+			 (COMMAND_PARAMETERS *)&in,
+			 NULL,
+			 TPM_CC_SequenceComplete,
+			 TPM_RS_PW, NULL, 0,
+			 TPM_RH_NULL, NULL, 0);
+    }
+    return rc;
+}
+
+/* TSS_Stream_Flush() flushes an abandoned sequence object.  Errors are ignored, since the caller is
+   already on an error path.
+*/
+
+static void TSS_Stream_Flush(TSS_CONTEXT *tssContext,
+			     TPMI_DH_OBJECT sequenceHandle)
+{
+    FlushContext_In 		in;
+
+    in.flushHandle = sequenceHandle;
+    TSS_Execute(tssContext,
+		NULL, 
+		(COMMAND_PARAMETERS *)&in,
+		NULL,
+		TPM_CC_FlushContext,
+		TPM_RH_NULL, NULL, 0);
+    return;
+}
+
+/* TSS_NV_GetBufferMax() returns the maximum NV read/write chunk size.  The limit is typically set by
+   the TPM property TPM_PT_NV_BUFFER_MAX.  However, it's possible that a value could be larger than
+   the TSS side structure MAX_NV_BUFFER_SIZE.
+
+   The TPM property is fixed, so it comes from the TSS context capability cache.
+
+   A value of zero is rejected, since the chunked read and write loops would never advance.
+*/
+
+TPM_RC TSS_NV_GetBufferMax(TSS_CONTEXT *tssContext,
+			   uint32_t *nvBufferMax)
+{
+    TPM_RC			rc = 0;
+
+    if (rc == 0) {
+	rc = TSS_Capability_GetProperty(tssContext, nvBufferMax, TPM_PT_NV_BUFFER_MAX);
+	if (rc == TSS_RC_BAD_PROPERTY) {
+	    /* hard code a value for a back level HW TPM that does not implement
+	       TPM_PT_NV_BUFFER_MAX yet */
+	    *nvBufferMax = 512;
+	    rc = 0;
+	}
+    }
+    if (rc == 0) {
+	if (*nvBufferMax == 0) {
+	    if (tssVerbose) printf("TSS_NV_GetBufferMax: TPM_PT_NV_BUFFER_MAX is zero\n");
+	    rc = TSS_RC_BAD_PROPERTY_VALUE;
+	}
+    }
+    if (rc == 0) {
+	if (*nvBufferMax > MAX_NV_BUFFER_SIZE) {
+	    *nvBufferMax = MAX_NV_BUFFER_SIZE;
+	}
+	if (tssVverbose) printf("TSS_NV_GetBufferMax: %u\n", *nvBufferMax);
+    }
+    return rc;
+}
+
+/* TSS_NV_ReadStream() reads size bytes from nvIndex starting at offset, passing each chunk to
+   writeFunction.  A size of zero sends one zero size TPM2_NV_Read.
+
+   The chunk size is the cached NV buffer maximum.  The authorization sessions are as for
+   TSS_Execute(), with a password only for session 0.  While the chunks are read, the session state
+   is held in the TSS context, so it is loaded once and saved once rather than for each chunk.
+*/
+
+TPM_RC TSS_NV_ReadStream(TSS_CONTEXT *tssContext,
+			 TPMI_RH_NV_AUTH authHandle,
+			 TPMI_RH_NV_INDEX nvIndex,
+			 uint16_t offset,
+			 uint16_t size,
+			 TSS_StreamWrite_t writeFunction,
+			 void *writeContext,
+			 TPMI_SH_AUTH_SESSION sessionHandle0,
+			 const char *password0,
+			 unsigned int sessionAttributes0,
+			 TPMI_SH_AUTH_SESSION sessionHandle1,
+			 unsigned int sessionAttributes1,
+			 TPMI_SH_AUTH_SESSION sessionHandle2,
+			 unsigned int sessionAttributes2)
+{
+    TPM_RC			rc = 0;
+    NV_Read_In 			in;
+    NV_Read_Out			out;
+    uint32_t 			nvBufferMax;
+    uint16_t 			bytesRead = 0;		/* bytes read so far */
+    int				done = FALSE;
+    int				hold = !tssContext->tssHoldSessions;
+
+    if (rc == 0) {
+	rc = TSS_NV_GetBufferMax(tssContext, &nvBufferMax);
+    }
+    if ((rc == 0) && hold) {
+	rc = TSS_HoldSessions(tssContext, TRUE);
+    }
+    if (rc == 0) {
+	in.authHandle = authHandle;
+	in.nvIndex = nvIndex;
+    }
+    /* a zero size read is still sent to the TPM, e.g., to test the authorization */
+    while ((rc == 0) && !done) {
+	/* read a chunk */
+	in.offset = offset + bytesRead;
+	if ((uint32_t)(size - bytesRead) < nvBufferMax) {
+	    in.size = size - bytesRead;		/* last chunk */
+	}
+	else {
+	    in.size = nvBufferMax;		/* next chunk */
+	}
+	if (tssVverbose) printf("TSS_NV_ReadStream: reading %u bytes at %u\n", in.size, in.offset);
+	rc = TSS_Execute(tssContext,
+			 (RESPONSE_PARAMETERS *)&out,
+			 (COMMAND_PARAMETERS *)&in,
+			 NULL,
+			 TPM_CC_NV_Read,
+			 sessionHandle0, password0, sessionAttributes0,
+			 sessionHandle1, NULL, sessionAttributes1,
+			 sessionHandle2, NULL, sessionAttributes2,
+			 TPM_RH_NULL, NULL, 0);
+	if (rc == 0) {
+	    if (out.data.b.size != in.size) {
+		if (tssVerbose) printf("TSS_NV_ReadStream: read %u bytes, expected %u\n",
+				       out.data.b.size, in.size);
+		rc = TSS_RC_MALFORMED_RESPONSE;
+	    }
+	}
+	if (rc == 0) {
+	    rc = writeFunction(writeContext, out.data.b.buffer, out.data.b.size);
+	}
+	if (rc == 0) {
+	    bytesRead += out.data.b.size;
+	    if (bytesRead == size) {
+		done = TRUE;
+	    }
+	}
+    }
+    /* release the sessions, even on error, since the TPM may have rolled the nonces */
+    if (hold) {
+	TPM_RC rc1 = TSS_HoldSessions(tssContext, FALSE);
+	if (rc == 0) {
+	    rc = rc1;
+	}
+    }
+    return rc;
+}
+
+/* TSS_NV_WriteStream() writes all of the data returned by readFunction to nvIndex starting at
+   offset.  written returns the number of bytes written.
+
+   readFunction is called with the cached NV buffer maximum, so each chunk is one TPM2_NV_Write.
+   Empty data sends one zero size TPM2_NV_Write.  The authorization sessions are handled as for
+   TSS_NV_ReadStream().
+*/
+
+TPM_RC TSS_NV_WriteStream(TSS_CONTEXT *tssContext,
+			  TPMI_RH_NV_AUTH authHandle,
+			  TPMI_RH_NV_INDEX nvIndex,
+			  uint16_t offset,
+			  TSS_StreamRead_t readFunction,
+			  void *readContext,
+			  uint32_t *written,
+			  TPMI_SH_AUTH_SESSION sessionHandle0,
+			  const char *password0,
+			  unsigned int sessionAttributes0,
+			  TPMI_SH_AUTH_SESSION sessionHandle1,
+			  unsigned int sessionAttributes1,
+			  TPMI_SH_AUTH_SESSION sessionHandle2,
+			  unsigned int sessionAttributes2)
+{
+    TPM_RC			rc = 0;
+    NV_Write_In 		in;
+    uint32_t 			nvBufferMax;
+    uint32_t			bytesRead;
+    int				done = FALSE;
+    int				first = TRUE;
+    int				hold = !tssContext->tssHoldSessions;
+
+    *written = 0;
+    if (rc == 0) {
+	rc = TSS_NV_GetBufferMax(tssContext, &nvBufferMax);
+    }
+    if ((rc == 0) && hold) {
+	rc = TSS_HoldSessions(tssContext, TRUE);
+    }
+    if (rc == 0) {
+	in.authHandle = authHandle;
+	in.nvIndex = nvIndex;
+    }
+    while ((rc == 0) && !done) {
+	rc = readFunction(readContext, in.data.b.buffer, nvBufferMax, &bytesRead);
+	if (rc == 0) {
+	    if (bytesRead > nvBufferMax) {
+		if (tssVerbose) printf("TSS_NV_WriteStream: read %u > buffer %u\n",
+				       bytesRead, nvBufferMax);
+		rc = TSS_RC_INSUFFICIENT_BUFFER;
+	    }
+	}
+	/* empty data is written once, as with a zero size TPM2_NV_Write */
+	if (rc == 0) {
+	    if ((bytesRead == 0) && !first) {
+		done = TRUE;
+	    }
+	    first = FALSE;
+	}
+	if ((rc == 0) && !done) {
+	    in.data.b.size = bytesRead;
+	    in.offset = offset + *written;
+	    if (tssVverbose) printf("TSS_NV_WriteStream: writing %u bytes at %u\n",
+				    in.data.b.size, in.offset);
+	    rc = TSS_Execute(tssContext,
+			     NULL,
+			     (COMMAND_PARAMETERS *)&in,
+			     NULL,
+			     TPM_CC_NV_Write,
+			     sessionHandle0, password0, sessionAttributes0,
+			     sessionHandle1, NULL, sessionAttributes1,
+			     sessionHandle2, NULL, sessionAttributes2,
+			     TPM_RH_NULL, NULL, 0);
+	}
+	if ((rc == 0) && !done) {
+	    *written += bytesRead;
+	    if (bytesRead == 0) {
+		done = TRUE;
+	    }
+	}
+    }
+    if (hold) {
+	TPM_RC rc1 = TSS_HoldSessions(tssContext, FALSE);
+	if (rc == 0) {
+	    rc = rc1;
+	}
+    }
+    return rc;
+}
+
+#ifndef TPM_TSS_NOCRYPTO
+
+/* TSS_Hash_StreamSoftware() digests all of the data returned by readFunction without using the
+   TPM */
+
+static TPM_RC TSS_Hash_StreamSoftware(TPMT_HA *digest,
+				      TSS_StreamRead_t readFunction,
+				      void *readContext,
+				      uint64_t *streamed)
+{
+    TPM_RC	rc = 0;
+    void	*hashContext = NULL;	/* freed @1 */
+    uint8_t	buffer[TSS_STREAM_SOFTWARE_BUFFER];
+    uint32_t	bytesRead;
+    int		done = FALSE;
+
+    if (rc == 0) {
+	rc = TSS_Hash_Start(&hashContext, digest->hashAlg);
+    }
+    while ((rc == 0) && !done) {
+	rc = readFunction(readContext, buffer, sizeof(buffer), &bytesRead);
+	if (rc == 0) {
+	    if (bytesRead > sizeof(buffer)) {
+		if (tssVerbose) printf("TSS_Hash_StreamSoftware: read %u > buffer %u\n",
+				       bytesRead, (unsigned int)sizeof(buffer));
+		rc = TSS_RC_INSUFFICIENT_BUFFER;
+	    }
+	}
+	if (rc == 0) {
+	    if (bytesRead == 0) {
+		done = TRUE;
+	    }
+	    else {
+		rc = TSS_Hash_Update(hashContext, buffer, bytesRead);
+		*streamed += bytesRead;
+	    }
+	}
+    }
+    if (rc == 0) {
+	rc = TSS_Hash_Finish(digest, &hashContext);	/* @1 */
+    }
+    else {
+	TSS_Hash_Finish(NULL, &hashContext);		/* @1 */
+    }
+    return rc;
+}
+
+#endif	/* TPM_TSS_NOCRYPTO */
@@ -43,6 +43,17 @@
 #include <string.h>
 #include <stdio.h>
 
+#ifndef TPM_TSS_NOFILE
+#ifdef TPM_POSIX
+#include <unistd.h>
+#endif
+#ifdef TPM_WINDOWS
+#include <process.h>
+#define getpid _getpid
+#endif
+#include <tss2/tssfile.h>
+#endif
+
 #include "tssproperties.h"
 #ifndef TPM_NOSOCKET
 #include "tsssocket.h"
@@ -53,6 +64,7 @@
 #ifdef TPM_POSIX
 #include "tssdev.h"
 #endif
+#include "tssreplay.h"
 
 #ifdef TPM_WINDOWS
 #ifdef TPM_WINDOWS_TBSI
@@ -67,6 +79,14 @@ extern int tssVerbose;
 
 /* local prototypes */
 
+#ifndef TPM_TSS_NOFILE
+static void TSS_Transmit_Capture(TSS_CONTEXT *tssContext,
+				 const uint8_t *responseBuffer, uint32_t read,
+				 const uint8_t *commandBuffer, uint32_t written);
+static int TSS_Transmit_IsResponse(TPM_RC rc,
+				   const uint8_t *responseBuffer, uint32_t read);
+#endif
+
 /* TSS_TransmitPlatform() transmits an administrative out of band command to the TPM.
 
    Supported by the simulator, not the TPM device.
@@ -140,14 +160,115 @@ TPM_RC TSS_Transmit(TSS_CONTEXT *tssContext,
 #endif
 #endif
     }
+#ifndef TPM_TSS_NOFILE
+    else if ((strcmp(tssContext->tssInterfaceType, "replay") == 0)) {
+	rc = TSS_Replay_Transmit(tssContext,
+				 responseBuffer, read,
+				 commandBuffer, written,
+				 message);
+    }
+#endif
     else {
 	if (tssVerbose) printf("TSS_Transmit: device %s unsupported\n",
 			       tssContext->tssInterfaceType);
 	rc = TSS_RC_INSUPPORTED_INTERFACE;	
     }
+#ifndef TPM_TSS_NOFILE
+    if ((rc == 0) && (tssContext->tssCorpusDirectory[0] != '\0')) {
+	TSS_Transmit_Capture(tssContext, responseBuffer, *read, commandBuffer, written);
+    }
+    /* record every response, including TPM errors, but not interface errors.  The TPM has already
+       executed the command, so a record failure does not change rc, see TSS_Replay_Close(). */
+    if ((tssContext->tssReplayFile[0] != '\0') &&
+	(strcmp(tssContext->tssInterfaceType, "replay") != 0) &&
+	(TSS_Transmit_IsResponse(rc, responseBuffer, *read))) {
+	TSS_Replay_Record(tssContext, responseBuffer, *read, commandBuffer, written);
+    }
+#endif
     return rc;
 }
 
+#ifndef TPM_TSS_NOFILE
+
+/* TSS_Transmit_IsResponse() returns TRUE if the transmit returned a TPM response, where rc is the
+   response code in the response buffer.
+*/
+
+static int TSS_Transmit_IsResponse(TPM_RC rc,
+				   const uint8_t *responseBuffer, uint32_t read)
+{
+    int		isResponse = FALSE;
+    TPM_RC	responseCode;
+
+    if (read >= (sizeof(TPM_ST) + sizeof(uint32_t) + sizeof(TPM_RC))) {
+	responseCode = ((uint32_t)responseBuffer[6] << 24) |
+		       ((uint32_t)responseBuffer[7] << 16) |
+		       ((uint32_t)responseBuffer[8] <<  8) |
+		       ((uint32_t)responseBuffer[9] <<  0);
+	isResponse = (rc == responseCode);
+    }
+    return isResponse;
+}
+
+/* TSS_Transmit_Capture() saves a successful command and response pair for the parser benchmark and
+   fuzz corpus, see parsebench.  The file is the command packet followed by the response packet.
+   The name is the command code, process ID, and count, so that concurrent regression test
+   processes do not collide.
+
+   A capture failure is traced but does not fail the command.
+*/
+
+static void TSS_Transmit_Capture(TSS_CONTEXT *tssContext,
+				 const uint8_t *responseBuffer, uint32_t read,
+				 const uint8_t *commandBuffer, uint32_t written)
+{
+    int		rc = 0;
+    char	filename[256];
+    FILE	*file = NULL;		/* closed @1 */
+    uint32_t	commandCode;
+    int		length;
+
+    if (rc == 0) {
+	if (written < (sizeof(TPM_ST) + sizeof(uint32_t) + sizeof(TPM_CC))) {
+	    rc = TSS_RC_MALFORMED_RESPONSE;
+	}
+    }
+    if (rc == 0) {
+	commandCode = ((uint32_t)commandBuffer[6] << 24) |
+		      ((uint32_t)commandBuffer[7] << 16) |
+		      ((uint32_t)commandBuffer[8] <<  8) |
+		      ((uint32_t)commandBuffer[9] <<  0);
+	length = snprintf(filename, sizeof(filename), "%s/%08x-%lu-%u.bin",
+			  tssContext->tssCorpusDirectory, commandCode,
+			  (unsigned long)getpid(), tssContext->tssCorpusCount);
+	if ((length < 0) || ((size_t)length >= sizeof(filename))) {
+	    rc = TSS_RC_FILE_OPEN;
+	}
+    }
+    if (rc == 0) {
+	rc = TSS_File_Open(&file, filename, "wb");
+    }
+    if (rc == 0) {
+	if ((fwrite(commandBuffer, 1, written, file) != written) ||
+	    (fwrite(responseBuffer, 1, read, file) != read)) {
+	    rc = TSS_RC_FILE_WRITE;
+	}
+    }
+    if (file != NULL) {
+	fclose(file);		/* @1 */
+    }
+    if (rc == 0) {
+	tssContext->tssCorpusCount++;
+    }
+    else {
+	if (tssVerbose) printf("TSS_Transmit_Capture: Error %08x saving to %s\n",
+			       rc, tssContext->tssCorpusDirectory);
+    }
+    return;
+}
+
+#endif
+
 /* TSS_Close() closes the connection to the TPM */
 
 TPM_RC TSS_Close(TSS_CONTEXT *tssContext)
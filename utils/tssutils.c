@@ -140,8 +140,14 @@ TPM_RC TSS_Realloc(unsigned char **buffer, uint32_t size)
    
    It marshals the structure using "marshalFunction", and returns the malloc'ed stream.
 
+   The structure is marshaled once into a stack buffer, then copied to an exact size allocation.
+   Only a structure larger than the stack buffer is marshaled twice, once to calculate the length.
 */
 
+#ifndef TSS_STRUCTURE_MARSHAL_STACK
+#define TSS_STRUCTURE_MARSHAL_STACK	4096
+#endif
+
 TPM_RC TSS_Structure_Marshal(uint8_t		**buffer,	/* freed by caller */
 			     uint16_t		*written,
 			     void 		*structure,
@@ -149,19 +155,112 @@ TPM_RC TSS_Structure_Marshal(uint8_t		**buffer,	/* freed by caller */
 {
     TPM_RC 	rc = 0;
     uint8_t	*buffer1 = NULL;	/* for marshaling, moves pointer */
+    uint8_t	stackBuffer[TSS_STRUCTURE_MARSHAL_STACK];
+    int32_t	size = sizeof(stackBuffer);
+    int		singlePass = FALSE;
 
-    /* marshal once to calculates the byte length */
+    /* marshal once into the stack buffer, which fails if the structure is too large */
     if (rc == 0) {
+	buffer1 = stackBuffer;
 	*written = 0;
-	rc = marshalFunction(structure, written, NULL, NULL);
+	singlePass = (marshalFunction(structure, written, &buffer1, &size) == 0);
     }
-    if (rc == 0) {
+    if ((rc == 0) && singlePass) {
 	rc = TSS_Malloc(buffer, *written);
+	if (rc == 0) {
+	    memcpy(*buffer, stackBuffer, *written);
+	}
+    }
+    /* the structure may hold secrets.  A failed marshal may have written part of it. */
+    memset(stackBuffer, 0, buffer1 - stackBuffer);
+    /* marshal once to calculates the byte length */
+    if ((rc == 0) && !singlePass) {
+	*written = 0;
+	rc = marshalFunction(structure, written, NULL, NULL);
+	if (rc == 0) {
+	    rc = TSS_Malloc(buffer, *written);
+	}
+	if (rc == 0) {
+	    buffer1 = *buffer;
+	    *written = 0;
+	    rc = marshalFunction(structure, written, &buffer1, NULL);
+	}
+    }
+    return rc;
+}
+
+/* TSS_MarshalBuffer_Init() initializes an empty marshal buffer */
+
+void TSS_MarshalBuffer_Init(TSS_MARSHAL_BUFFER *marshalBuffer)
+{
+    marshalBuffer->buffer = NULL;
+    marshalBuffer->size = 0;
+    return;
+}
+
+/* TSS_MarshalBuffer_Free() erases and frees the marshal buffer, and leaves it empty */
+
+void TSS_MarshalBuffer_Free(TSS_MARSHAL_BUFFER *marshalBuffer)
+{
+    if (marshalBuffer->buffer != NULL) {
+	memset(marshalBuffer->buffer, 0, marshalBuffer->size);
     }
+    free(marshalBuffer->buffer);
+    TSS_MarshalBuffer_Init(marshalBuffer);
+    return;
+}
+
+/* TSS_Structure_MarshalBuffer() marshals the structure using "marshalFunction" into
+   marshalBuffer->buffer, and returns the number of bytes in 'written'.
+
+   The buffer is reused across calls, so repeated marshaling does not allocate.  If the structure
+   does not fit, the buffer is doubled and the structure marshaled again.  The stream is valid until
+   the next call or TSS_MarshalBuffer_Free().
+*/
+
+#ifndef TSS_MARSHAL_BUFFER_INITIAL
+#define TSS_MARSHAL_BUFFER_INITIAL	1024
+#endif
+
+TPM_RC TSS_Structure_MarshalBuffer(TSS_MARSHAL_BUFFER	*marshalBuffer,
+				   uint16_t		*written,
+				   void 		*structure,
+				   MarshalFunction_t 	marshalFunction)
+{
+    TPM_RC 	rc = 0;
+    uint8_t	*buffer1;		/* for marshaling, moves pointer */
+    int32_t	size;
+    int		done = FALSE;
+
     if (rc == 0) {
-	buffer1 = *buffer;
+	if (marshalBuffer->size == 0) {
+	    rc = TSS_Malloc(&marshalBuffer->buffer, TSS_MARSHAL_BUFFER_INITIAL);
+	    if (rc == 0) {
+		marshalBuffer->size = TSS_MARSHAL_BUFFER_INITIAL;
+	    }
+	}
+    }
+    while ((rc == 0) && !done) {
+	buffer1 = marshalBuffer->buffer;
+	size = marshalBuffer->size;
 	*written = 0;
-	rc = marshalFunction(structure, written, &buffer1, NULL);
+	rc = marshalFunction(structure, written, &buffer1, &size);
+	/* grow and retry, up to the largest allowed allocation */
+	if ((rc == TSS_RC_INSUFFICIENT_BUFFER) && (marshalBuffer->size < TSS_ALLOC_MAX)) {
+	    uint32_t newSize = marshalBuffer->size * 2;
+	    if (newSize > TSS_ALLOC_MAX) {
+		newSize = TSS_ALLOC_MAX;
+	    }
+	    /* the partial stream is discarded, erase rather than realloc */
+	    TSS_MarshalBuffer_Free(marshalBuffer);
+	    rc = TSS_Malloc(&marshalBuffer->buffer, newSize);
+	    if (rc == 0) {
+		marshalBuffer->size = newSize;
+	    }
+	}
+	else {
+	    done = TRUE;
+	}
     }
     return rc;
 }
@@ -134,7 +134,9 @@ int main(int argc, char *argv[])
 	rc = processPrimary(tssContext,
 			    &ekKeyHandle,
 			    EK_CERT_RSA_INDEX, EK_NONCE_RSA_INDEX, EK_TEMPLATE_RSA_INDEX,
-			    TRUE, verbose);		/* do not flush */
+			    TRUE,			/* do not flush */
+			    FALSE,			/* do not use the primary key cache */
+			    verbose);
     }
     /* start a session, salt with EK, unbound */
     if (rc == 0) {